@@ -1294,11 +1294,36 @@ void AggregateType::resolveConcreteType() {
     }
   }
 
+  if (symbol->hasFlag(FLAG_SOA_LAYOUT))
+    checkSoaLayout();
+
   makeRefType(this);
 
   this->resolveStatus = RESOLVED;
 }
 
+// A "soa layout" record is split into one array per field, so it must be
+// a plain record whose fields are stored values.
+void AggregateType::checkSoaLayout() const {
+  if (isRecord() == false || symbol->hasFlag(FLAG_EXTERN)) {
+    USR_FATAL_CONT(symbol,
+                   "pragma \"soa layout\" only applies to Chapel records");
+    return;
+  }
+
+  for_fields(field, this) {
+    if (field->hasFlag(FLAG_PARAM) || field->hasFlag(FLAG_TYPE_VARIABLE))
+      continue;
+
+    if (field->type == this || field->type->symbol->hasFlag(FLAG_REF)) {
+      USR_FATAL_CONT(field,
+                     "field '%s' of \"soa layout\" record '%s' "
+                     "must be stored by value",
+                     field->name, symbol->name);
+    }
+  }
+}
+
 static void buildParentSubMap(AggregateType* at, SymbolMap& map) {
   AggregateType* root = at->getRootInstantiation();
   if (root->dispatchParents.n > 0) {
@@ -323,6 +323,9 @@ bool AstDumpToNode::enterBlockStmt(BlockStmt* node)
   if (node->blockTag & BLOCK_C_FOR_LOOP)
     write(true, "C_FOR_LOOP", true);
 
+  if (node->blockTag & BLOCK_BOUNDS_CHECK)
+    write(true, "bounds_check", true);
+
   mOffset = mOffset + 2;
 
   for_alist(next_ast, node->body)
@@ -710,8 +710,10 @@ void remove_help(BaseAST* ast, int trace_flag) {
     expr->parentSymbol = NULL;
     expr->parentExpr = NULL;
   } else if (LabelSymbol* labsym = toLabelSymbol(ast)) {
-    if (labsym->iterResumeGoto)
+    if (labsym->iterResumeGoto) {
+      SharedAstLock lock;
       removedIterResumeLabels.add(labsym);
+    }
   }
 }
 
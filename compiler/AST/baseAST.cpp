@@ -58,6 +58,11 @@ foreach_ast(decl_gvecs);
 
 static int uid = 1;
 
+bool       gAstThreadsActive = false;
+std::mutex gSharedAstMutex;
+
+static void freeAstArena();
+
 #define decl_counters(type)                                             \
   int n##type = g##type##s.n, k##type = n##type*sizeof(type)/1024
 
@@ -80,6 +85,15 @@ def_vec_hash(BaseAST);
 
 #undef def_vec_hash
 
+void astKindBytes(std::vector<std::pair<const char*, size_t> >& bytes) {
+#define add_kind_bytes(type)                                            \
+  bytes.push_back(std::make_pair(#type, (size_t) g##type##s.n * sizeof(type)))
+
+  foreach_ast(add_kind_bytes);
+
+#undef add_kind_bytes
+}
+
 //
 // Throughout printStatistics(), "n" indicates the number of nodes;
 // "k" indicates how many KiB memory they occupy: k = n * sizeof(node) / 1024.
@@ -301,6 +315,8 @@ void destroyAst() {
       delete ast;                               \
     }
   foreach_ast(destroy_gvec);
+
+  freeAstArena();
 }
 
 
@@ -369,6 +385,92 @@ const std::string BaseAST::tabText = "   ";
 BaseAST::~BaseAST() {
 }
 
+/************************************* | **************************************
+*                                                                             *
+* The AST arena.  Nodes are carved out of large slabs, grouped by their size  *
+* rounded up to kArenaAlign, which in practice means by AST kind.  A deleted  *
+* node goes on the free list for its size, so the nodes cleanAst() deletes    *
+* between passes are reused by the next pass without going back to malloc,    *
+* and the slabs are released all at once by destroyAst().                     *
+*                                                                             *
+************************************** | *************************************/
+
+namespace {
+  struct ArenaFreeNode {
+    ArenaFreeNode* next;
+  };
+}
+
+static const size_t        kArenaAlign    = 16;
+static const size_t        kArenaMaxSize  = 1024;      // larger uses malloc
+static const size_t        kArenaSlabSize = 256 * 1024;
+
+static ArenaFreeNode*      arenaFreeLists[kArenaMaxSize / kArenaAlign + 1];
+static std::vector<char*>  arenaSlabs;
+static char*               arenaNext      = NULL;
+static char*               arenaEnd       = NULL;
+
+void* BaseAST::operator new(size_t size) {
+  size_t rounded = (size + kArenaAlign - 1) & ~(kArenaAlign - 1);
+  void*  retval  = NULL;
+
+  INT_ASSERT(gAstThreadsActive == false);
+
+  if (rounded > kArenaMaxSize) {
+    retval = ::operator new(size);
+
+  } else if (ArenaFreeNode* node = arenaFreeLists[rounded / kArenaAlign]) {
+    arenaFreeLists[rounded / kArenaAlign] = node->next;
+    retval = node;
+
+  } else {
+    if (arenaNext == NULL || arenaNext + rounded > arenaEnd) {
+      arenaNext = static_cast<char*>(::operator new(kArenaSlabSize));
+      arenaEnd  = arenaNext + kArenaSlabSize;
+
+      arenaSlabs.push_back(arenaNext);
+    }
+
+    retval     = arenaNext;
+    arenaNext += rounded;
+  }
+
+  return retval;
+}
+
+void BaseAST::operator delete(void* ptr, size_t size) {
+  size_t rounded = (size + kArenaAlign - 1) & ~(kArenaAlign - 1);
+
+  INT_ASSERT(gAstThreadsActive == false);
+
+  if (ptr == NULL) {
+
+  } else if (rounded > kArenaMaxSize) {
+    ::operator delete(ptr);
+
+  } else {
+    ArenaFreeNode* node = static_cast<ArenaFreeNode*>(ptr);
+
+    node->next = arenaFreeLists[rounded / kArenaAlign];
+    arenaFreeLists[rounded / kArenaAlign] = node;
+  }
+}
+
+static void freeAstArena() {
+  for (size_t i = 0; i < arenaSlabs.size(); i++) {
+    ::operator delete(arenaSlabs[i]);
+  }
+
+  arenaSlabs.clear();
+
+  for (size_t i = 0; i < kArenaMaxSize / kArenaAlign + 1; i++) {
+    arenaFreeLists[i] = NULL;
+  }
+
+  arenaNext = NULL;
+  arenaEnd  = NULL;
+}
+
 int BaseAST::linenum() const {
   return astloc.lineno;
 }
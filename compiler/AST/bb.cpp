@@ -34,10 +34,10 @@
 #include <queue>
 
 
-int                                          BasicBlock::nextID     = 0;
-BasicBlock*                                  BasicBlock::basicBlock = NULL;
-Map<LabelSymbol*, std::vector<BasicBlock*>*> BasicBlock::gotoMaps;
-Map<LabelSymbol*, BasicBlock*>               BasicBlock::labelMaps;
+thread_local int                                          BasicBlock::nextID     = 0;
+thread_local BasicBlock*                                  BasicBlock::basicBlock = NULL;
+thread_local Map<LabelSymbol*, std::vector<BasicBlock*>*> BasicBlock::gotoMaps;
+thread_local Map<LabelSymbol*, BasicBlock*>               BasicBlock::labelMaps;
 
 BasicBlock::BasicBlock() {
   id = nextID++;
@@ -616,40 +616,64 @@ void BasicBlock::computeBackwardOrder(FnSymbol* fn,
 }
 
 //#define DEBUG_FLOW
+//
+// Both analyses are worklist based: a block is only revisited when the
+// set it reads from one of its neighbors changed.  They reach the same
+// fixed point as iterating over every block until nothing changes.
+//
 void BasicBlock::backwardFlowAnalysis(FnSymbol*             fn,
                                       std::vector<BitVec*>& GEN,
                                       std::vector<BitVec*>& KILL,
                                       std::vector<BitVec*>& IN,
                                       std::vector<BitVec*>& OUT) {
-  bool iterate = true;
+  size_t            nbbs = fn->basicBlocks->size();
+  std::vector<int>  work;
+  std::vector<bool> queued(nbbs, true);
 
-  while (iterate) {
-    int i = 0;
+  // Popped from the back, so the last blocks are visited first
+  for (size_t i = 0; i < nbbs; i++)
+    work.push_back(i);
 
-    iterate = false;
+  while (work.empty() == false) {
+    int i = work.back();
 
-    for_vector(BasicBlock, bb, *fn->basicBlocks) {
-      for (size_t j = 0; j < IN[i]->ndata; j++) {
-        unsigned int new_in  = (OUT[i]->data[j] & ~KILL[i]->data[j]) | GEN[i]->data[j];
-        unsigned int new_out = 0;
+    work.pop_back();
+    queued[i] = false;
 
-        if (new_in != IN[i]->data[j]) {
-          IN[i]->data[j] = new_in;
-          iterate = true;
-        }
+    BasicBlock*   bb     = (*fn->basicBlocks)[i];
+    BitVec::Word* in     = IN[i]->data;
+    BitVec::Word* out    = OUT[i]->data;
+    BitVec::Word* gen    = GEN[i]->data;
+    BitVec::Word* kill   = KILL[i]->data;
+    size_t        ndata  = IN[i]->ndata;
+    bool          change = false;
 
-        for_vector(BasicBlock, bbout, bb->outs) {
-          new_out = new_out | IN[bbout->id]->data[j];
-        }
+    for (size_t j = 0; j < ndata; j++)
+      out[j] = 0;
+
+    for_vector(BasicBlock, bbout, bb->outs) {
+      BitVec::Word* succIn = IN[bbout->id]->data;
+
+      for (size_t j = 0; j < ndata; j++)
+        out[j] |= succIn[j];
+    }
 
-        if (new_out != OUT[i]->data[j]) {
-          OUT[i]->data[j] = new_out;
-          iterate = true;
+    for (size_t j = 0; j < ndata; j++) {
+      BitVec::Word new_in = (out[j] & ~kill[j]) | gen[j];
+
+      change = change || new_in != in[j];
+      in[j]  = new_in;
+    }
+
+    if (change) {
+      for_vector(BasicBlock, bbin, bb->ins) {
+        if (queued[bbin->id] == false) {
+          queued[bbin->id] = true;
+          work.push_back(bbin->id);
         }
       }
-
-      i++;
     }
+
 #ifdef DEBUG_FLOW
     printf("IN\n");  printBitVectorSets(IN);
     printf("OUT\n"); printBitVectorSets(OUT);
@@ -689,32 +713,44 @@ void BasicBlock::forwardFlowAnalysis(FnSymbol*             fn,
     }
 #endif
 
-    BasicBlock* bb     = (*fn->basicBlocks)[i];
-    bool        change = false;
-
-    for (size_t j = 0; j < IN[i]->ndata; j++) {
-      if (bb->ins.size() > 0) {
-        unsigned int new_in = (intersect) ? (unsigned int) (-1) : 0;
-
-        for_vector(BasicBlock, bbin, bb->ins) {
-          if (intersect)
-            new_in &= OUT[bbin->id]->data[j];
-          else
-            new_in |= OUT[bbin->id]->data[j];
+    BasicBlock*   bb     = (*fn->basicBlocks)[i];
+    BitVec::Word* in     = IN[i]->data;
+    BitVec::Word* out    = OUT[i]->data;
+    BitVec::Word* gen    = GEN[i]->data;
+    BitVec::Word* kill   = KILL[i]->data;
+    size_t        ndata  = IN[i]->ndata;
+    bool          change = false;
+
+    if (bb->ins.size() > 0) {
+      BitVec        meet(IN[i]->size());
+      BitVec::Word* new_in = meet.data;
+
+      if (intersect)
+        meet.set();
+
+      for_vector(BasicBlock, bbin, bb->ins) {
+        BitVec::Word* predOut = OUT[bbin->id]->data;
+
+        if (intersect) {
+          for (size_t j = 0; j < ndata; j++)
+            new_in[j] &= predOut[j];
+        } else {
+          for (size_t j = 0; j < ndata; j++)
+            new_in[j] |= predOut[j];
         }
+      }
 
-        if (new_in != IN[i]->data[j]) {
-          IN[i]->data[j] = new_in;
-          change         = true;
-        }
+      for (size_t j = 0; j < ndata; j++) {
+        change = change || new_in[j] != in[j];
+        in[j]  = new_in[j];
       }
+    }
 
-      unsigned int new_out = (IN[i]->data[j] & ~KILL[i]->data[j]) | GEN[i]->data[j];
+    for (size_t j = 0; j < ndata; j++) {
+      BitVec::Word new_out = (in[j] & ~kill[j]) | gen[j];
 
-      if (new_out != OUT[i]->data[j]) {
-        OUT[i]->data[j] = new_out;
-        change          = true;
-      }
+      change = change || new_out != out[j];
+      out[j] = new_out;
     }
 
     if (change) {
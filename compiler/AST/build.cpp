@@ -1188,6 +1188,117 @@ static void removeWrappingBlock(BlockStmt*& block) {
         block = (BlockStmt*)nested->remove();
 }
 
+// If 'body' is just 'on <index>' for a coforall over 'Locales' with a
+// single index and no task intents, return the on block.
+static BlockStmt* findCoforallOnLocales(Expr* indices,
+                                        Expr* iterator,
+                                        CallExpr* byref_vars,
+                                        BlockStmt* body,
+                                        bool zippered) {
+  UnresolvedSymExpr* index = toUnresolvedSymExpr(indices);
+  UnresolvedSymExpr* iter = toUnresolvedSymExpr(iterator);
+
+  if (fNoCoforallOnTree || zippered || byref_vars != NULL ||
+      index == NULL || iter == NULL || strcmp(iter->unresolved, "Locales"))
+    return NULL;
+
+  // buildOnStmt() gives { def tmp; move tmp, deref(wide_get_locale(x)); on }
+  BlockStmt* onBlock = findStmtWithTag(PRIM_BLOCK_ON, body);
+  if (onBlock == NULL || onBlock->byrefVars != NULL)
+    return NULL;
+
+  BlockStmt* parent = toBlockStmt(onBlock->parentExpr);
+  CallExpr* move = toCallExpr(onBlock->prev);
+  if (parent == NULL || parent->length() != 3 ||
+      !isDefExpr(parent->body.head) ||
+      move == NULL || !move->isPrimitive(PRIM_MOVE))
+    return NULL;
+
+  CallExpr* deref = toCallExpr(move->get(2));
+  if (deref == NULL || !deref->isPrimitive(PRIM_DEREF))
+    return NULL;
+
+  CallExpr* getLocale = toCallExpr(deref->get(1));
+  if (getLocale == NULL || !getLocale->isPrimitive(PRIM_WIDE_GET_LOCALE))
+    return NULL;
+
+  UnresolvedSymExpr* target = toUnresolvedSymExpr(getLocale->get(1));
+  if (target == NULL || strcmp(target->unresolved, index->unresolved))
+    return NULL;
+
+  return onBlock;
+}
+
+// Build up a coforall-on over Locales that fans out through a spanning
+// tree rooted at the current locale instead of having it fork every task
+// and take every completion.  For
+//
+//     coforall loc in Locales do on loc { body(); }
+//
+// this builds
+//
+//     proc chpl_coforallOnTree(const in chpl_treeRoot: int) {
+//       cobegin {
+//         coforall chpl_treeIdx in
+//             0..<__primitive("coforall tree num children", chpl_treeRoot) do
+//           on Locales[__primitive("coforall tree child", chpl_treeRoot,
+//                                  chpl_treeIdx)] do
+//             chpl_coforallOnTree(chpl_treeRoot);
+//         { const loc = Locales[here.id]; body(); }
+//       }
+//     }
+//     chpl_coforallOnTree(here.id);
+//
+// Each locale waits for its own subtree, so the end counts nest along
+// the tree.  Errors from the body propagate up through the nested
+// cobegins and coforalls as they would from the original coforall.
+static BlockStmt* buildCoforallOnTree(UnresolvedSymExpr* index,
+                                      BlockStmt* onBlock) {
+  static int uid = 1;
+
+  FnSymbol* fn = new FnSymbol(astr("chpl_coforallOnTree", istr(uid++)));
+  fn->addFlag(FLAG_COFORALL_ON_TREE);
+  fn->retTag = RET_VALUE;
+  fn->retExprType = new BlockStmt(new SymExpr(dtVoid->symbol), BLOCK_TYPE);
+
+  ArgSymbol* root = new ArgSymbol(INTENT_CONST_IN, "chpl_treeRoot",
+                                  dtInt[INT_SIZE_DEFAULT]);
+  fn->insertFormalAtTail(root);
+
+  // the children of this locale
+  CallExpr* child = new CallExpr(PRIM_COFORALL_TREE_CHILD, root,
+                                 new UnresolvedSymExpr("chpl_treeIdx"));
+  BlockStmt* onChild = buildOnStmt(new CallExpr("Locales", child),
+                                   new BlockStmt(new CallExpr(fn->name,
+                                                              root)));
+  Expr* numChildren = new CallExpr(PRIM_COFORALL_TREE_NUM_CHILDREN, root);
+  BlockStmt* children =
+    buildCoforallLoopStmt(new UnresolvedSymExpr("chpl_treeIdx"),
+                          buildBoundedRange(new SymExpr(new_IntSymbol(0)),
+                                            numChildren, false, true),
+                          NULL, onChild);
+
+  // the original body, run here
+  BlockStmt* local = new BlockStmt();
+  VarSymbol* loc = new VarSymbol(index->unresolved);
+  loc->addFlag(FLAG_CONST);
+  CallExpr* hereId = new CallExpr(".", new UnresolvedSymExpr("here"),
+                                  new_CStringSymbol("id"));
+  local->insertAtTail(new DefExpr(loc, new CallExpr("Locales", hereId)));
+  for_alist(stmt, onBlock->body)
+    local->insertAtTail(stmt->remove());
+
+  BlockStmt* tasks = new BlockStmt();
+  tasks->insertAtTail(children);
+  tasks->insertAtTail(local);
+  fn->insertAtTail(buildCobeginStmt(NULL, tasks));
+
+  BlockStmt* block = new BlockStmt();
+  block->insertAtTail(new DefExpr(fn));
+  block->insertAtTail(new CallExpr(fn->name, hereId->copy()));
+  return block;
+}
+
 // Build up AST for coforalls. For something like:
 //
 //     coforall indices in iterator with (byref_vars) { body(); }
@@ -1248,6 +1359,11 @@ BlockStmt* buildCoforallLoopStmt(Expr* indices,
 
   SET_LINENO(body);
 
+  if (BlockStmt* onBlock = findCoforallOnLocales(indices, iterator,
+                                                 byref_vars, body,
+                                                 zippered))
+    return buildCoforallOnTree(toUnresolvedSymExpr(indices), onBlock);
+
   VarSymbol* tmpIter = newTemp("tmpIter");
   tmpIter->addFlag(FLAG_EXPR_TEMP);
   tmpIter->addFlag(FLAG_MAYBE_REF);
@@ -127,6 +127,7 @@ void checkPrimitives()
      case PRIM_IS_UNION_TYPE:
      case PRIM_IS_ATOMIC_TYPE:
      case PRIM_IS_EXTERN_TYPE:
+     case PRIM_IS_SOA_LAYOUT_TYPE:
      case PRIM_IS_TUPLE_TYPE:
      case PRIM_IS_STAR_TUPLE_TYPE:
      case PRIM_IS_SUBTYPE:
@@ -286,6 +287,8 @@ void checkPrimitives()
      case PRIM_WIDE_GET_NODE:           // Get just the node portion of a wide pointer.
      case PRIM_WIDE_GET_ADDR:           // Get just the address portion of a wide pointer.
      case PRIM_ON_LOCALE_NUM:           // specify a particular localeID for an on clause.
+     case PRIM_COFORALL_TREE_NUM_CHILDREN:
+     case PRIM_COFORALL_TREE_CHILD:
      case PRIM_REGISTER_GLOBAL_VAR:
      case PRIM_BROADCAST_GLOBAL_VARS:
      case PRIM_PRIVATE_BROADCAST:
@@ -595,7 +595,7 @@ void printPrimitiveCounts(const char* passName) {
 
 }
 
-HashMap<const char *, StringHashFns, PrimitiveOp *> primitives_map;
+OpenHashMap<const char *, StringHashFns, PrimitiveOp *> primitives_map;
 
 PrimitiveOp* primitives[NUM_KNOWN_PRIMS];
 
@@ -888,6 +888,7 @@ initPrimitive() {
   prim_def(PRIM_ARRAY_SET_FIRST, "array_set_first", returnInfoVoid, true);
 
   prim_def(PRIM_MAYBE_LOCAL_THIS, "may be local access", returnInfoUnknown);
+  prim_def(PRIM_PROVEN_IN_BOUNDS, "proven in bounds access", returnInfoUnknown);
 
   prim_def(PRIM_ERROR, "error", returnInfoVoid, true);
   prim_def(PRIM_WARNING, "warning", returnInfoVoid, true);
@@ -959,6 +960,11 @@ initPrimitive() {
   // specify a particular localeID for an on clause.
   prim_def(PRIM_ON_LOCALE_NUM, "chpl_on_locale_num", returnInfoLocaleID);
 
+  // ('coforall tree num children' root) and ('coforall tree child' root i)
+  // give the shape of the spanning tree a coforall-on fans out through.
+  prim_def(PRIM_COFORALL_TREE_NUM_CHILDREN, "coforall tree num children", returnInfoDefaultInt);
+  prim_def(PRIM_COFORALL_TREE_CHILD, "coforall tree child", returnInfoDefaultInt);
+
   prim_def(PRIM_REGISTER_GLOBAL_VAR, "_register_global_var", returnInfoVoid, true, true);
   prim_def(PRIM_BROADCAST_GLOBAL_VARS, "_broadcast_global_vars", returnInfoVoid, true, true);
   // ('_private_broadcast' sym)
@@ -1030,6 +1036,7 @@ initPrimitive() {
   prim_def(PRIM_IS_ATOMIC_TYPE, "is atomic type", returnInfoBool);
   prim_def(PRIM_IS_REF_ITER_TYPE, "is ref iter type", returnInfoBool);
   prim_def(PRIM_IS_EXTERN_TYPE, "is extern type", returnInfoBool);
+  prim_def(PRIM_IS_SOA_LAYOUT_TYPE, "is soa layout type", returnInfoBool);
   prim_def(PRIM_IS_ABS_ENUM_TYPE, "is abstract enum type", returnInfoBool);
 
   prim_def(PRIM_IS_POD, "is pod type", returnInfoBool);
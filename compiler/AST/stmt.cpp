@@ -787,7 +787,9 @@ CondStmt::CondStmt(Expr* iCondExpr,
   if (Expr* s = toExpr(iThenStmt)) {
     BlockStmt* bs = toBlockStmt(s);
 
-    if (bs && bs->blockTag == BLOCK_NORMAL && bs->isRealBlockStmt()) {
+    // A copied 'if boundsChecking' keeps its BLOCK_BOUNDS_CHECK body as is
+    if (bs && (bs->blockTag & ~BLOCK_BOUNDS_CHECK) == BLOCK_NORMAL &&
+        bs->isRealBlockStmt()) {
       thenStmt = bs;
     } else {
       thenStmt = new BlockStmt(s);
@@ -301,6 +301,8 @@ void Symbol::addSymExpr(SymExpr* se) {
   // to all the uses of 3, and that probably isn't adding
   // any value.
 
+  SharedAstLock lock;
+
   if (symExprsTail == NULL) {
     se->symbolSymExprsPrev = NULL;
     se->symbolSymExprsNext = NULL;
@@ -316,6 +318,8 @@ void Symbol::addSymExpr(SymExpr* se) {
 }
 
 void Symbol::removeSymExpr(SymExpr* se) {
+  SharedAstLock lock;
+
   SymExpr*& prev = se->symbolSymExprsPrev;
   SymExpr*& next = se->symbolSymExprsNext;
   if (next)
@@ -1463,11 +1467,11 @@ std::string unescapeString(const char* const str, BaseAST *astForError) {
 }
 
 static int literal_id = 1;
-HashMap<Immediate *, ImmHashFns, VarSymbol *> uniqueConstantsHash;
+OpenHashMap<Immediate *, ImmHashFns, VarSymbol *> uniqueConstantsHash;
 
 // stringLiteralsHash should never contain any invalid string
-HashMap<Immediate *, ImmHashFns, VarSymbol *> stringLiteralsHash;
-HashMap<Immediate *, ImmHashFns, VarSymbol *> bytesLiteralsHash;
+OpenHashMap<Immediate *, ImmHashFns, VarSymbol *> stringLiteralsHash;
+OpenHashMap<Immediate *, ImmHashFns, VarSymbol *> bytesLiteralsHash;
 
 LabelSymbol* initStringLiteralsEpilogue = NULL;
 
@@ -22,7 +22,11 @@
 
 #include <cstdlib>
 
-#define TYPE unsigned
+#define TYPE BitVec::Word
+
+#define BITS (sizeof(TYPE) << 3)
+
+#define ONE  ((TYPE) 1)
 
 BitVec::BitVec(size_t in_size) {
   if (in_size == 0) {
@@ -30,7 +34,7 @@ BitVec::BitVec(size_t in_size) {
     this->in_size = 0;
     data          = NULL;
   } else {
-    ndata         = 1 + (in_size - 1) / (sizeof(TYPE) << 3);
+    ndata         = 1 + (in_size - 1) / BITS;
     this->in_size = in_size;
     data          = (TYPE*) calloc(ndata, sizeof(TYPE));
   }
@@ -68,18 +72,18 @@ bool BitVec::get(size_t i) const {
     INT_FATAL("BitVec::get -- operand out of range.");
 #endif
 
-  size_t j = i / (sizeof(TYPE) << 3);
-  size_t k = i - j * (sizeof(TYPE) << 3);
+  size_t j = i / BITS;
+  size_t k = i - j * BITS;
 
-  return data[j] & (1 << k);
+  return data[j] & (ONE << k);
 }
 
 
 void BitVec::unset(size_t i) {
-  size_t j = i / (sizeof(TYPE) << 3);
-  size_t k = i - j * (sizeof(TYPE) << 3);
+  size_t j = i / BITS;
+  size_t k = i - j * BITS;
 
-  data[j] &= ((TYPE)-1) - (1 << k);
+  data[j] &= ~(ONE << k);
 }
 
 
@@ -105,6 +109,17 @@ void BitVec::intersection(const BitVec& other) {
 }
 
 
+void BitVec::difference(const BitVec& other) {
+#if DEBUG
+  if (other.in_size != in_size)
+    INT_FATAL("BitVec::difference -- operand lengths must be equal.");
+#endif
+
+  for (size_t i = 0; i < ndata; i++)
+    data[i] &= ~other.data[i];
+}
+
+
 /*
  * Added functionality to make this compatible with std::bitset
  * and thus boosts dynamic bitset if that gets into the STL
@@ -131,17 +146,28 @@ bool BitVec::equals(const BitVec& other) const {
 }
 
 
+// Clears the bits of the last word that are past in_size
+static void clearPadding(BitVec* bv) {
+  size_t used = bv->in_size % BITS;
+
+  if (used != 0)
+    bv->data[bv->ndata - 1] &= (ONE << used) - 1;
+}
+
+
 void BitVec::set() {
   for (size_t i = 0; i < ndata; i++)
-    data[i] = ~0;
+    data[i] = ~((TYPE) 0);
+
+  clearPadding(this);
 }
 
 
 void BitVec::set(size_t i) {
-  size_t j = i / (sizeof(TYPE) << 3);
-  size_t k = i - j * (sizeof(TYPE) << 3);
+  size_t j = i / BITS;
+  size_t k = i - j * BITS;
 
-  data[j] |= 1 << k;
+  data[j] |= ONE << k;
 }
 
 
@@ -152,10 +178,10 @@ void BitVec::reset() {
 
 
 void BitVec::reset(size_t i) {
-  size_t j = i / (sizeof(TYPE) << 3);
-  size_t k = i - j * (sizeof(TYPE) << 3);
+  size_t j = i / BITS;
+  size_t k = i - j * BITS;
 
-  data[j] &= ((size_t)-1) - (1 << k);
+  data[j] &= ~(ONE << k);
 }
 
 
@@ -166,27 +192,29 @@ void BitVec::copy(const BitVec& other) {
 
 
 void BitVec::copy(size_t i, bool value) {
-  size_t j = i / (sizeof(TYPE) << 3);
-  size_t k = i - j * (sizeof(TYPE) << 3);
+  size_t j = i / BITS;
+  size_t k = i - j * BITS;
 
-  data[j] &= ~(1 << k);
+  data[j] &= ~(ONE << k);
 
   if (value)
-    data[j] |= (1 << k);
+    data[j] |= (ONE << k);
 }
 
 
 void BitVec::flip() {
   for (size_t i = 0; i < ndata; i++)
     data[i] = ~data[i];
+
+  clearPadding(this);
 }
 
 
 void BitVec::flip(size_t i) {
-  size_t j = i / (sizeof(TYPE)<<3);
-  size_t k = i - j*(sizeof(TYPE)<<3);
+  size_t j = i / BITS;
+  size_t k = i - j * BITS;
 
-  data[j] ^= 1 << k;
+  data[j] ^= ONE << k;
 }
 
 
@@ -202,7 +230,7 @@ size_t BitVec::count() const {
 
   for (size_t i = 0; i < ndata; i++) {
     size_t localCount = 0;
-    size_t x          = data[i];
+    TYPE   x          = data[i];
 
     for (localCount = 0; x; localCount++) {
       x &= x - 1;
@@ -221,10 +249,10 @@ size_t BitVec::size() const {
 
 
 bool BitVec::test(size_t i) const {
-  size_t j = i / (sizeof(TYPE) << 3);
-  size_t k = i - j * (sizeof(TYPE) << 3);
+  size_t j = i / BITS;
+  size_t k = i - j * BITS;
 
-  return data[j] & (1 << k);
+  return data[j] & (ONE << k);
 }
 
 
@@ -40,7 +40,8 @@
 // Returns the loop metadata node to associate with the branch.
 // If thisLoopParallelAccess is set, accessGroup will be set to the
 // metadata node to use in llvm.access.group metadata for this loop.
-static llvm::MDNode* generateLoopMetadata(bool thisLoopParallelAccess,
+static llvm::MDNode* generateLoopMetadata(CForLoop* loop,
+                                          bool thisLoopParallelAccess,
                                           llvm::MDNode*& accessGroup)
 {
   GenInfo* info = gGenInfo;
@@ -55,8 +56,48 @@ static llvm::MDNode* generateLoopMetadata(bool thisLoopParallelAccess,
   // 1) Explicitly disable vectorization of particular loop
   // 2) Print warning when vectorization is enabled (using metadata) and
   //    vectorization didn't occur
-  // Here we do not emit that metadata; instead emitting parallel
+  // It also makes the vectorizer ignore its cost model, so it is only
+  // emitted with --force-vectorize; otherwise the loop is marked with
   // llvm.loop.parallel_accesses.
+  llvm::Type* int32Ty = llvm::Type::getInt32Ty(ctx);
+
+  if (fForceVectorize) {
+    llvm::Constant* one = llvm::ConstantInt::get(llvm::Type::getInt1Ty(ctx),
+                                                 true);
+    llvm::Metadata *vectorizeEnable[] = {
+        llvm::MDString::get(ctx, "llvm.loop.vectorize.enable"),
+        llvm::ConstantAsMetadata::get(one) };
+
+    args.push_back(llvm::MDNode::get(ctx, vectorizeEnable));
+  }
+
+  if (llvmInterleaveCount > 0) {
+    llvm::Constant* count = llvm::ConstantInt::get(int32Ty,
+                                                   llvmInterleaveCount);
+    llvm::Metadata *interleaveCount[] = {
+        llvm::MDString::get(ctx, "llvm.loop.interleave.count"),
+        llvm::ConstantAsMetadata::get(count) };
+
+    args.push_back(llvm::MDNode::get(ctx, interleaveCount));
+  }
+
+  // With --report-vectorizer-remarks, record where the loop came from,
+  // since without debug info the remarks don't otherwise say.
+  // The vectorizer copies it along with the rest of the loop metadata.
+  if (fReportVectorizerRemarks) {
+    ModuleSymbol* mod = loop->getModule();
+
+    if (developer || mod->modTag == MOD_USER) {
+      llvm::Constant* line = llvm::ConstantInt::get(int32Ty,
+                                                    loop->linenum());
+      llvm::Metadata *location[] = {
+          llvm::MDString::get(ctx, CHPL_LOOP_LOCATION_MD),
+          llvm::MDString::get(ctx, loop->fname()),
+          llvm::ConstantAsMetadata::get(line) };
+
+      args.push_back(llvm::MDNode::get(ctx, location));
+    }
+  }
 
   // Does the current loop, or any outer loop in the loop stack,
   // require llvm.loop.parallel_accesses metadata?
@@ -246,7 +287,8 @@ GenRet CForLoop::codegen()
     llvm::MDNode* loopMetadata = nullptr;
 
     if(fNoVectorize == false && isVectorizable()) {
-      loopMetadata = generateLoopMetadata(isParallelAccessVectorizable(),
+      loopMetadata = generateLoopMetadata(this,
+                                          isParallelAccessVectorizable(),
                                           accessGroup);
       LoopData data(accessGroup, isParallelAccessVectorizable());
       info->loopStack.push_back(data);
@@ -2306,6 +2306,15 @@ void codegen() {
     if (!fLlvmCodegen ) USR_FATAL("--llvm-wide-opt requires --llvm");
   }
 
+  if( fPackedWidePointers ) {
+    // Packed wide pointers only have room for a node id,
+    // and only the wide optimization knows how to build them.
+    if (!fLLVMWideOpt)
+      USR_FATAL("--llvm-packed-wide-pointers requires --llvm-wide-opt");
+    if (strcmp(CHPL_LOCALE_MODEL, "flat") != 0)
+      USR_FATAL("--llvm-packed-wide-pointers requires CHPL_LOCALE_MODEL=flat");
+  }
+
   // Prepare primitives for codegen
   CallExpr::registerPrimitivesForCodegen();
 
@@ -2379,7 +2388,12 @@ void codegen() {
     prepareCodegenLLVM();
 #endif
   } else {
-    openCFile(&hdrfile,  "chpl__header", "h");
+    // With --incremental the header and the user modules are only
+    // rewritten when they change, so make can reuse their objects.
+    if (fIncrementalCompilation)
+      openCFileIfChanged(&hdrfile, "chpl__header", "h");
+    else
+      openCFile(&hdrfile,  "chpl__header", "h");
     openCFile(&mainfile, "_main",        "c");
     openCFile(&defnfile, "chpl__defn",    "c");
     openCFile(&strconfig,  "chpl_str_config", "c");
@@ -2397,14 +2411,7 @@ void codegen() {
         const char* filename = NULL;
         filename = generateFileName(fileNameHashMap, filename, currentModule->name);
         if(currentModule->modTag == MOD_USER) {
-          fileinfo modulefile;
-          openCFile(&modulefile, filename, "c");
-          int modulePathLen = strlen(astr(modulefile.pathname));
-          char path[FILENAME_MAX];
-          strncpy(path, astr(modulefile.pathname), modulePathLen-2);
-          path[modulePathLen-2]='\0';
-          userFileName.push_back(astr(path));
-          closeCFile(&modulefile);
+          userFileName.push_back(genIntermediateFilename(filename));
         }
       }
     }
@@ -2454,16 +2461,25 @@ void codegen() {
       const char* filename = NULL;
       filename = generateFileName(fileNameHashMap, filename,currentModule->name);
 
+      bool separate = fIncrementalCompilation &&
+                      currentModule->modTag == MOD_USER;
+
       fileinfo modulefile;
-      openCFile(&modulefile, filename, "c");
+      if (separate)
+        openCFileIfChanged(&modulefile, filename, "c");
+      else
+        openCFile(&modulefile, filename, "c");
       info->cfile = modulefile.fptr;
-      if(fIncrementalCompilation && (currentModule->modTag == MOD_USER))
+      if (separate)
         fprintf(modulefile.fptr, "#include \"chpl__header.h\"\n");
       currentModule->codegenDef();
 
-      closeCFile(&modulefile);
+      if (separate)
+        closeCFileIfChanged(&modulefile);
+      else
+        closeCFile(&modulefile);
 
-      if(!(fIncrementalCompilation && (currentModule->modTag == MOD_USER)))
+      if (!separate)
         fprintf(mainfile.fptr, "#include \"%s%s\"\n", filename, ".c");
     }
 
@@ -2480,7 +2496,10 @@ void codegen() {
     fprintf(hdrfile.fptr, "\n#endif");
     fprintf(hdrfile.fptr, " /* END CHPL_GEN_HEADER_INCLUDE_GUARD */\n"); 
 
-    closeCFile(&hdrfile);
+    if (fIncrementalCompilation)
+      closeCFileIfChanged(&hdrfile);
+    else
+      closeCFile(&hdrfile);
     fprintf(mainfile.fptr, "/* last line not #include to avoid gcc bug */\n");
     closeCFile(&mainfile);
     closeCFile(&defnfile);
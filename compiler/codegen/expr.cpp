@@ -4608,6 +4608,15 @@ DEFINE_PRIM(PRIM_LOCAL_CHECK) {
     }
 }
 
+DEFINE_PRIM(PRIM_COFORALL_TREE_NUM_CHILDREN) {
+    ret = codegenCallExpr("chpl_comm_coforall_tree_num_children",
+                          codegenValue(call->get(1)));
+}
+DEFINE_PRIM(PRIM_COFORALL_TREE_CHILD) {
+    ret = codegenCallExpr("chpl_comm_coforall_tree_child",
+                          codegenValue(call->get(1)),
+                          codegenValue(call->get(2)));
+}
 DEFINE_PRIM(PRIM_GET_SERIAL) {
     ret = codegenCallExpr("chpl_task_getSerial");
 }
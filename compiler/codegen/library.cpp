@@ -570,6 +570,8 @@ static void makePYXFile(std::vector<FnSymbol*> functions) {
     // Necessary for using numpy types
     fprintf(pyx.fptr, "import numpy\n");
     fprintf(pyx.fptr, "cimport numpy\n");
+    // Necessary for handing returned arrays to numpy without a copy
+    fprintf(pyx.fptr, "from cython cimport view\n");
     // Necessary for supporting pointers
     fprintf(pyx.fptr, "import ctypes\n");
     fprintf(pyx.fptr, "from libc.stdint cimport intptr_t\n\n");
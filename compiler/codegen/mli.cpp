@@ -30,6 +30,7 @@
 #include "expr.h"
 #include "stlUtil.h"
 #include "stringutil.h"
+#include "wellknown.h"
 
 #include <cstring>
 #include <map>
@@ -38,15 +39,15 @@
 const char* gen_mli_marshalling = "chpl_mli_marshalling";
 const char* gen_mli_client = "chpl_mli_client";
 const char* gen_mli_server = "chpl_mli_server";
-static const char* client_main = "chpl_client.main";
-static const char* client_arg = "chpl_client.arg";
-static const char* client_res = "chpl_client.res";
-static const char* server_arg = "chpl_server.arg";
-static const char* server_res = "chpl_server.res";
+static const char* client_buf = "buf";
+static const char* server_req = "req";
+static const char* server_rep = "rep";
 static const char* marshal_push_prefix = "chpl_mli_mtpush_";
 static const char* marshal_pull_prefix = "chpl_mli_mtpull_";
-static const char* socket_push_name = "chpl_mli_push";
-static const char* socket_pull_name = "chpl_mli_pull";
+static const char* marshal_arr_push_prefix = "chpl_mli_mtpush_arr_";
+static const char* marshal_arr_pull_prefix = "chpl_mli_mtpull_arr_";
+static const char* buffer_write_name = "chpl_mli_buf_write";
+static const char* buffer_read_name = "chpl_mli_buf_read";
 static const char* scope_begin = "{\n";
 static const char* scope_end = "}\n";
 
@@ -69,6 +70,7 @@ private:
   std::vector<FnSymbol*> exps;
   std::vector<FnSymbol*> throws;
   std::map<Type*, int64_t> typeMap;
+  std::map<Type*, int64_t> arrayMap;
   fileinfo fiMarshalling;
   fileinfo fiClientBundle;
   fileinfo fiServerBundle;
@@ -79,9 +81,12 @@ private:
   void setOutputAndWrite(fileinfo* fi, const std::string& gen);
   void write(const std::string& code);
   int64_t assignUniqueTypeID(Type* t);
+  int64_t assignUniqueArrayID(Type* eltType);
   void emitClientWrapper(FnSymbol* fn);
   void emitServerWrapper(FnSymbol* fn);
   bool isSupportedType(Type* t);
+  bool isSupportedType(Symbol* sym, Type* t);
+  Type* getArrayElementType(Symbol* sym, Type* t);
   void verifyPrototype(FnSymbol* fn);
   Type* getTypeFromFormal(ArgSymbol* as);
   Type* getTypeFromFormal(FnSymbol* fn, int i);
@@ -90,6 +95,7 @@ private:
   std::string genMarshalBodyPrimitiveScalar(Type* t, bool out);
   std::string genMarshalBodyString(Type* t, bool out);
   std::string genMarshalBodyChplBytesWrapper(Type* t, bool out);
+  std::string genMarshalBodyArray(Type* eltType, bool out);
   std::string genComment(const char* msg, const char* pfx="");
   std::string genNote(const char* msg);
   std::string genTodo(const char* msg);
@@ -99,6 +105,8 @@ private:
   std::string genMarshalRoutine(Type* t, bool out);
   std::string genMarshalPushRoutine(Type* t);
   std::string genMarshalPullRoutine(Type* t);
+  std::string genArrayMarshalRoutineProto(Type* eltType, bool out);
+  std::string genArrayMarshalRoutine(Type* eltType, bool out);
   std::string genServerDispatchSwitch(const std::vector<FnSymbol*>& fns);
   std::string genDebugPrintCall(FnSymbol* fn);
   std::string genDebugPrintCall(const char* msg);
@@ -108,22 +116,15 @@ private:
   std::string genClientsideRPC(FnSymbol* fn);
   std::string genServersideRPC(FnSymbol* fn);
   std::string genMemCleanup(Type* t, const char* var);
-  std::string genMarshalCall(const char* skt, const char* var, Type* t,
+  std::string genMarshalCall(const char* buf, const char* var, Type* t,
                              bool out);
-  std::string genMarshalPushCall(const char* skt, const char* var, Type* t);
-  std::string genMarshalPullCall(const char* skt, const char* var, Type* t);
+  std::string genMarshalCall(const char* buf, const char* var, Symbol* sym,
+                             Type* t, bool out);
   std::string genTypeName(Type* t);
-  std::string genSocketCallBuffer(const char* skt, const char* var,
-                                  const char* len, bool out);
-  std::string genSocketCall(const char* skt, const char* var, const char* len,
-                            bool out);
-  std::string genSocketCall(const char* skt, const char* var, bool out);
-  std::string genSocketPushCall(const char* skt, const char* var);
-  std::string genSocketPullCall(const char* skt, const char* var);
+  std::string genBufferCall(const char* buf, const char* var,
+                            const char* len, bool out);
+  std::string genBufferCall(const char* buf, const char* var, bool out);
   std::string genAddressOf(const char* var);
-  std::string genAddressOf(std::string& var);
-  std::string genSizeof(const char* var);
-  std::string genSizeof(std::string& var);
   std::string genNewDecl(const char* t, const char* n);
   std::string genNewDecl(Type* t, const char* n);
 
@@ -301,96 +302,75 @@ void MLIContext::emitMarshalRoutines(void) {
     gen += this->genMarshalPullRoutine(i->first);
   }
 
+  for (i = this->arrayMap.begin(); i != this->arrayMap.end(); ++i) {
+    if (this->debugPrint) {
+      std::string tpn = "array of " + this->genTypeName(i->first);
+      gen += this->genComment(tpn.c_str());
+    }
+
+    gen += this->genArrayMarshalRoutine(i->first, true);
+    gen += this->genArrayMarshalRoutine(i->first, false);
+  }
+
   this->setOutputAndWrite(&this->fiMarshalling, gen);
 
   return;
 }
 
 std::string MLIContext::genMarshalBodyPrimitiveScalar(Type* t, bool out) {
-  std::string gen;
-
-  // On pack, target buffer is input parameter. On unpack, the temporary.
+  // On pack, source is input parameter. On unpack, the temporary.
   const char* target = out ? "obj" : "result";
 
-  // Move the raw bytes of the type to/from the wire.
-  gen += "skt_err=";
-  gen += this->genSocketCall("skt", target, out);
-
-  // Generate a null frame in the opposite direction for the ACK.
-  gen += this->genSocketCall("skt", NULL, !out);
-
-  return gen;
+  // Move the raw bytes of the type to/from the buffer.
+  return this->genBufferCall("buf", target, out);
 }
 
 //
-// TODO: Generalize this method to become something akin to
-// "genMarshalVariableWidthBuffer", of which a string is nothing more than a
-// specific instance of.
-// This will help us later down the line when we have to support other types
-// that push variable width buffers (arrays).
+// Strings are packed as their length followed by their bytes, without the
+// trailing NUL.  Unpacking allocates room for the NUL and adds it.
 //
 std::string MLIContext::genMarshalBodyString(Type* t, bool out) {
-  const char* target = out ? "obj" : "buffer";
   std::string gen;
 
-  // Declare temporaries for bytecount, buffer, and memory errors.
+  // Declare temporaries for bytecount and buffer.
   gen += this->genNewDecl("uint64_t", "bytes");
   gen += this->genNewDecl("void*", "buffer");
-  gen += this->genNewDecl("int64_t", "mem_err");
 
   if (out) {
-    // Compute and push length of string.
+    // Compute and pack length of string, then the string itself.
     gen += "bytes = strlen(obj);\n";
 
     if (this->debugPrint) {
       gen += this->genDebugPrintCall1Arg("Pushing length: ", "bytes");
     }
-  }
 
-  gen += this->genSocketCall("skt", "bytes", out);
+    gen += this->genBufferCall("buf", "bytes", out);
+    gen += this->genBufferCall("buf", "obj", "bytes", out);
+    return gen;
+  }
 
-  if (!out) {
-    if (this->debugPrint) {
-      gen += this->genDebugPrintCall1Arg("Received intended length: ", "bytes");
-    }
-    // Attempt to allocate buffer.
-    gen += "buffer = mli_malloc(bytes + 1);\n";
+  gen += this->genBufferCall("buf", "bytes", out);
 
-    // Set ACK value (non-zero if memory allocation failed).
-    gen += "mem_err = (buffer == NULL);\n";
+  if (this->debugPrint) {
+    gen += this->genDebugPrintCall1Arg("Received intended length: ", "bytes");
   }
 
-  // Push/pull possible allocation error on ACK.
-  gen += this->genSocketCall("skt", "mem_err", !out);
-
-  // If error, terminate client/server.
-  gen += "if (mem_err) chpl_mli_terminate(CHPL_MLI_CODE_EMEMORY);\n";
-
-  // Move the string over the wire, using length.
-  gen += this->genSocketCallBuffer("skt", target, "bytes", out);
-
-  // Generate a null frame in the opposite direction for the ACK.
-  gen += this->genSocketCall("skt", NULL, !out);
-
-  if (!out) {
-    // Null terminate the string we just received.
-    gen += "((char*) buffer)[bytes] = '\\0';\n";
-
-    if (t == dtStringC) {
-      // Cast buffer to const char.
-      gen += "result = ((const char*) buffer);\n";
-    } else if (t->symbol->hasFlag(FLAG_C_PTR_CLASS) &&
-               getDataClassType(t->symbol)->typeInfo() == dtInt[INT_SIZE_8]) {
-      // Cast buffer to int8*
-      Type* underlyingType = getDataClassType(t->symbol)->typeInfo();
-      const char* underlyingTypeName = underlyingType->symbol->cname;
-      gen += "result = ((";
-      gen += underlyingTypeName;
-      gen += "*) buffer);\n";
-    } else {
-      INT_FATAL("Unknown type passed to %s, %s", __FUNCTION__,
-                t->symbol->name);
-    }
+  gen += "buffer = chpl_mli_buf_read_alloc(buf, bytes);\n";
+
+  if (t == dtStringC) {
+    // Cast buffer to const char.
+    gen += "result = ((const char*) buffer);\n";
+  } else if (t->symbol->hasFlag(FLAG_C_PTR_CLASS) &&
+             getDataClassType(t->symbol)->typeInfo() == dtInt[INT_SIZE_8]) {
+    // Cast buffer to int8*
+    Type* underlyingType = getDataClassType(t->symbol)->typeInfo();
+    const char* underlyingTypeName = underlyingType->symbol->cname;
+    gen += "result = ((";
+    gen += underlyingTypeName;
+    gen += "*) buffer);\n";
+  } else {
+    INT_FATAL("Unknown type passed to %s, %s", __FUNCTION__,
+              t->symbol->name);
   }
 
   return gen;
@@ -405,53 +385,52 @@ std::string MLIContext::genMarshalBodyChplBytesWrapper(Type* t, bool out) {
   const char* fieldSize = astr(target, ".size");
   const char* fieldData = astr(target, ".data");
 
-  // Generate a temporary to hold memory errors.
-  gen += this->genNewDecl("int64_t", "mem_err");
-
-  // Push/pull the "isOwned" field.
-  gen += this->genSocketCall("skt", fieldIsOwned, out);
+  // Pack/unpack the "size" field.
+  gen += this->genBufferCall("buf", fieldSize, out);
 
-  // Generate a null frame for the ACK.
-  gen += this->genSocketCall("skt", NULL, !out);
-
-  // Push/pull the "size" field.
-  gen += this->genSocketCall("skt", fieldSize, out);
-
-  if (!out) {
-    // Attempt to allocate buffer.
-    gen += fieldData;
-    gen += " = mli_malloc(";
-    gen += + fieldSize;
-    gen += " + 1);\n";
-
-    // Set ACK value (non-zero if memory allocation failed).
-    gen += "mem_err = (";
+  if (out) {
+    // Pack the bytes themselves, using length.
+    gen += this->genBufferCall("buf", fieldData, fieldSize, out);
+  } else {
+    // Unpack into a NUL terminated buffer, which we then own.
     gen += fieldData;
-    gen += " == NULL);\n";
-
-    // if I have allocated something here, own it, too
+    gen += " = chpl_mli_buf_read_alloc(buf, ";
+    gen += fieldSize;
+    gen += ");\n";
     gen += fieldIsOwned;
-    gen += " = true;";
+    gen += " = true;\n";
   }
 
-  // Push/pull possible allocation error on ACK.
-  gen += this->genSocketCall("skt", "mem_err", !out);
+  return gen;
+}
 
-  // If error, terminate client/server.
-  gen += "if (mem_err) chpl_mli_terminate(CHPL_MLI_CODE_EMEMORY);\n";
+//
+// Arrays of scalars are packed as their element count followed by all of
+// their elements in one block, rather than element by element.  Unpacked
+// arrays own their elements and free them with mli_free().
+//
+std::string MLIContext::genMarshalBodyArray(Type* eltType, bool out) {
+  const char* target = out ? "obj" : "result";
+  std::string gen;
 
-  // Move the bytes over the wire, using length.
-  gen += this->genSocketCallBuffer("skt", fieldData, fieldSize, out);
+  const char* fieldNumElts = astr(target, ".num_elts");
+  const char* fieldElts = astr(target, ".elts");
+  std::string bytes = fieldNumElts;
+  bytes += " * sizeof(";
+  bytes += this->genTypeName(eltType);
+  bytes += ")";
 
-  // Generate a null frame for the ACK.
-  gen += this->genSocketCall("skt", NULL, !out);
+  gen += this->genBufferCall("buf", fieldNumElts, out);
 
-  // Null terminate the bytes buffer if we are pulling.
-  if (!out) {
-    gen += fieldData;
-    gen += "[";
-    gen += fieldSize;
-    gen += "] = '\\0';\n";
+  if (out) {
+    gen += this->genBufferCall("buf", fieldElts, bytes.c_str(), out);
+  } else {
+    gen += fieldElts;
+    gen += " = chpl_mli_buf_read_alloc(buf, ";
+    gen += bytes;
+    gen += ");\n";
+    gen += target;
+    gen += ".freer = ((void*) chpl_mli_free_elts);\n";
   }
 
   return gen;
@@ -472,7 +451,7 @@ std::string MLIContext::genMarshalRoutineProto(Type* t, bool out) {
   // Select appropriate prefix for function name based on direction.
   gen += out ? marshal_push_prefix : marshal_pull_prefix;
   gen += str(id);
-  gen += "(void* skt";
+  gen += "(struct chpl_mli_buffer* buf";
 
   // Push routines expect the type as a parameter (named "obj").
   if (out) {
@@ -499,9 +478,6 @@ std::string MLIContext::genMarshalRoutine(Type* t, bool out) {
   gen += proto;
   gen += scope_begin;
 
-  // Always declare a variable to catch socket errors.
-  gen += this->genNewDecl("int", "skt_err");
-
   // If unpacking, declare a temporary for the return value.
   if (!out) { gen += this->genNewDecl(t, "result"); }
 
@@ -544,6 +520,56 @@ std::string MLIContext::genMarshalRoutine(Type* t, bool out) {
   return gen;
 }
 
+std::string MLIContext::genArrayMarshalRoutineProto(Type* eltType, bool out) {
+  int64_t id = this->assignUniqueArrayID(eltType);
+  std::string gen;
+
+  gen += out ? "void " : "chpl_external_array ";
+  gen += out ? marshal_arr_push_prefix : marshal_arr_pull_prefix;
+  gen += str(id);
+  gen += "(struct chpl_mli_buffer* buf";
+
+  if (out) {
+    gen += ",chpl_external_array obj";
+  }
+
+  gen += ")";
+
+  return gen;
+}
+
+std::string MLIContext::genArrayMarshalRoutine(Type* eltType, bool out) {
+  std::string proto;
+  std::string gen;
+
+  // Generate a forward declaration, followed by the actual definition.
+  proto = this->genArrayMarshalRoutineProto(eltType, out);
+  gen += proto;
+  gen += ";\n";
+  gen += proto;
+  gen += scope_begin;
+
+  if (!out) { gen += this->genNewDecl("chpl_external_array", "result"); }
+
+  if (this->debugPrint) {
+    std::string msg;
+
+    msg += out ? "Pushing array of type: " : "Pulling array of type: ";
+    msg += this->genTypeName(eltType);
+
+    gen += this->genDebugPrintCall(msg.c_str());
+  }
+
+  gen += this->genMarshalBodyArray(eltType, out);
+
+  if (!out) { gen += "return result;\n"; }
+
+  gen += scope_end;
+  gen += "\n";
+
+  return gen;
+}
+
 std::string MLIContext::genMarshalPushRoutine(Type* t) {
   return this->genMarshalRoutine(t, true);
 }
@@ -596,6 +622,21 @@ int64_t MLIContext::assignUniqueTypeID(Type* t) {
   return result;
 }
 
+//
+// Arrays get their own marshalling routines, one per element type.
+//
+int64_t MLIContext::assignUniqueArrayID(Type* eltType) {
+  int64_t result = (int64_t) this->arrayMap.size();
+
+  if (this->arrayMap.find(eltType) != this->arrayMap.end()) {
+    result = this->arrayMap[eltType];
+  } else {
+    this->arrayMap[eltType] = result;
+  }
+
+  return result;
+}
+
 void MLIContext::emitClientWrapper(FnSymbol* fn) {
   std::string gen;
 
@@ -619,7 +660,7 @@ void MLIContext::emitServerWrapper(FnSymbol* fn) {
   gen += this->genComment(toString(fn));
   prototype += "int64_t chpl_mli_swrapper_";
   prototype += this->genFuncNumericID(fn);
-  prototype += "(void)";
+  prototype += "(struct chpl_mli_buffer* req, struct chpl_mli_buffer* rep)";
 
   // Generate a prototype for the function
   gen += prototype + ";\n";
@@ -679,7 +720,7 @@ std::string MLIContext::genServerWrapperCall(FnSymbol* fn) {
 
   gen += "chpl_mli_swrapper_";
   gen += this->genFuncNumericID(fn);
-  gen += "();\n";
+  gen += "(req, rep);\n";
 
   return gen;
 }
@@ -689,7 +730,8 @@ MLIContext::genServerDispatchSwitch(const std::vector<FnSymbol*>& fns) {
   std::string gen;
 
   gen += "int64_t chpl_mli_sdispatch";
-  gen += "(int64_t function)";
+  gen += "(int64_t function, struct chpl_mli_buffer* req, ";
+  gen += "struct chpl_mli_buffer* rep)";
   gen += scope_begin;
   gen += this->genNewDecl("int", "err");
   gen += "switch (function)";
@@ -733,9 +775,34 @@ bool MLIContext::isSupportedType(Type* t) {
   );
 }
 
+//
+// Arrays are supported when their elements are scalars we can send as raw
+// bytes.  The element type is only known through the formal or function.
+//
+bool MLIContext::isSupportedType(Symbol* sym, Type* t) {
+  return this->isSupportedType(t) || this->getArrayElementType(sym, t);
+}
+
+Type* MLIContext::getArrayElementType(Symbol* sym, Type* t) {
+  if (t->getValType() != dtExternalArray) { return NULL; }
+
+  std::map<Symbol*, TypeSymbol*>::iterator it;
+  it = exportedArrayElementType.find(sym);
+  if (it == exportedArrayElementType.end() || it->second == NULL) {
+    return NULL;
+  }
+
+  Type* eltType = it->second->type;
+  if (!isPrimitiveScalar(eltType) || is_complex_type(eltType)) {
+    return NULL;
+  }
+
+  return eltType;
+}
+
 void MLIContext::verifyPrototype(FnSymbol* fn) {
 
-  if (fn->retType != dtVoid && !isSupportedType(fn->retType) &&
+  if (fn->retType != dtVoid && !isSupportedType(fn, fn->retType) &&
       exportedStrRets.find(fn) == exportedStrRets.end()) {
     // We only allow c_ptr(int8) if it was originally a Chapel string return
     Type* t = fn->retType;
@@ -745,7 +812,7 @@ void MLIContext::verifyPrototype(FnSymbol* fn) {
 
   for (int i = 1; i <= fn->numFormals(); i++) {
     ArgSymbol* as = fn->getFormal(i);
-    if (!this->isSupportedType(as->type)) {
+    if (!this->isSupportedType(as, as->type)) {
       Type* t = as->type;
       USR_FATAL(fn, "Multi-locale libraries do not support formal type: %s",
                 t->name());
@@ -766,7 +833,6 @@ Type* MLIContext::getTypeFromFormal(FnSymbol* fn, int i) {
 
 std::string MLIContext::genClientsideRPC(FnSymbol* fn) {
   bool hasVoidReturnType = fn->retType == dtVoid;
-  bool hasFormals = fn->numFormals() != 0;
   std::string gen;
 
   // Declare the unique ID for this function.
@@ -774,9 +840,6 @@ std::string MLIContext::genClientsideRPC(FnSymbol* fn) {
   gen += this->genFuncNumericID(fn);
   gen += ";\n";
 
-  // Declare a int64 for the server return value.
-  gen += this->genNewDecl("int64_t", "st");
-
   // Declare a temporary for the return value, if necessary.
   if (!hasVoidReturnType) {
     gen += this->genNewDecl(fn->retType, "result");
@@ -786,30 +849,33 @@ std::string MLIContext::genClientsideRPC(FnSymbol* fn) {
     gen += this->genDebugPrintCall(fn);
   }
 
-  // Push function to call.
-  gen += this->genSocketPushCall(client_main, "id");
-
-  // Pull server confirmation.
-  gen += this->genSocketPullCall(client_main, "st");
+  // Start the request for the function to call.
+  gen += "struct chpl_mli_buffer* ";
+  gen += client_buf;
+  gen += " = chpl_mli_begin_call(id);\n";
 
-  // If we are void/void, then there's nothing left to do.
-  if (hasVoidReturnType && !hasFormals) {
-    gen += this->genComment("Routine is void/void!");
-    return gen;
-  }
-
-  // Issue pack call for each formal.
+  // Issue pack call for each formal.  Arrays are passed by reference.
   for (int i = 1; i <= fn->numFormals(); i++) {
     ArgSymbol* as = fn->getFormal(i);
     Type* t = getTypeFromFormal(as);
+    std::string var = as->name;
+
+    if (this->getArrayElementType(as, t) && as->isRef()) {
+      var = "*" + var;
+    }
 
-    gen += this->genMarshalPushCall(client_arg, as->name, t);
+    gen += this->genMarshalCall(client_buf, var.c_str(), as, t, true);
   }
 
-  // Pull and return result if applicable.
-  if (!hasVoidReturnType) {
+  // Send the request, then pull and return result if applicable.
+  if (hasVoidReturnType) {
+    gen += "chpl_mli_end_call(0);\n";
+  } else {
+    gen += client_buf;
+    gen += " = chpl_mli_end_call(1);\n";
     gen += "result = ";
-    gen += this->genMarshalPullCall(client_res, "result", fn->retType);
+    gen += this->genMarshalCall(client_buf, "result", fn, fn->retType,
+                                false);
     gen += "return result;\n";
   }
 
@@ -834,20 +900,28 @@ std::string MLIContext::genServersideRPC(FnSymbol* fn) {
 
   // Declare temporaries, issue unpack call for each formal.
   for (int i = 1; i <= fn->numFormals(); i++) {
-    Type* t = this->getTypeFromFormal(fn, i);
+    ArgSymbol* as = fn->getFormal(i);
+    Type* t = this->getTypeFromFormal(as);
+    bool isArray = this->getArrayElementType(as, t) != NULL;
     std::string tmp;
 
     // Map temp names to formal indices (shifted down one).
     tmp += "tmp_";
-    tmp += fn->getFormal(i)->name;
-    formalTempNames[i] = tmp;
+    tmp += as->name;
 
     // Declare each temporary and initialize with a pack call.
-    gen += this->genTypeName(t);
+    gen += isArray ? "chpl_external_array" : this->genTypeName(t);
     gen += " ";
     gen += tmp;
     gen += "=";
-    gen += this->genMarshalPullCall(server_arg, tmp.c_str(), t);
+    gen += this->genMarshalCall(server_req, tmp.c_str(), as, t, false);
+
+    // Arrays are passed by reference.
+    if (isArray && as->isRef()) {
+      tmp = "&" + tmp;
+    }
+
+    formalTempNames[i] = tmp;
   }
 
   // Only generate LHS target if necessary.
@@ -872,7 +946,7 @@ std::string MLIContext::genServersideRPC(FnSymbol* fn) {
 
   // If there is a result, issue a pack call for it.
   if (!hasVoidReturnType) {
-    gen += this->genMarshalPushCall(server_res, "result", fn->retType);
+    gen += this->genMarshalCall(server_rep, "result", fn, fn->retType, true);
   }
 
   //
@@ -887,13 +961,20 @@ std::string MLIContext::genServersideRPC(FnSymbol* fn) {
   // that any allocated data is freed.
   //
   for (int i = 1; i <= fn->numFormals(); i++) {
-    Type* t = this->getTypeFromFormal(fn, i);
-    if (this->isTypeRequiringAlloc(t)) {
+    ArgSymbol* as = fn->getFormal(i);
+    Type* t = this->getTypeFromFormal(as);
+    if (this->getArrayElementType(as, t)) {
+      gen += "chpl_mli_free_elts(tmp_";
+      gen += as->name;
+      gen += ".elts);\n";
+    } else if (this->isTypeRequiringAlloc(t)) {
       gen += this->genMemCleanup(t, formalTempNames[i].c_str());
     }
   }
 
-  if (!hasVoidReturnType && this->isTypeRequiringAlloc(fn->retType)) {
+  if (!hasVoidReturnType && this->getArrayElementType(fn, fn->retType)) {
+    gen += "chpl_free_external_array(result);\n";
+  } else if (!hasVoidReturnType && this->isTypeRequiringAlloc(fn->retType)) {
     gen += this->genMemCleanup(fn->retType, "result");
   }
 
@@ -919,7 +1000,7 @@ std::string MLIContext::genMemCleanup(Type* t, const char* var) {
   return gen;
 }
 
-std::string MLIContext::genMarshalCall(const char* skt, const char* var,
+std::string MLIContext::genMarshalCall(const char* buf, const char* var,
                                        Type* t, bool out) {
   std::string gen;
   int64_t id = this->assignUniqueTypeID(t);
@@ -927,7 +1008,7 @@ std::string MLIContext::genMarshalCall(const char* skt, const char* var,
   gen += out ? marshal_push_prefix : marshal_pull_prefix;
   gen += str(id);
   gen += "(";
-  gen += skt;
+  gen += buf;
   
   if (out) {
     gen += ",";
@@ -940,19 +1021,32 @@ std::string MLIContext::genMarshalCall(const char* skt, const char* var,
 }
 
 //
-// TODO: These calls pass value types (cheaper to pass pointer).
+// Marshal the formal or return value 'sym' of type 't', which might be an
+// array of scalars.
 //
 std::string
-MLIContext::genMarshalPushCall(const char* skt, const char* var, Type* t) {
-  return this->genMarshalCall(skt, var, t, true);
-}
+MLIContext::genMarshalCall(const char* buf, const char* var, Symbol* sym,
+                           Type* t, bool out) {
+  Type* eltType = this->getArrayElementType(sym, t);
+  std::string gen;
 
-//
-// TODO: These calls pass value types (cheaper to pass pointer).
-//
-std::string
-MLIContext::genMarshalPullCall(const char* skt, const char* var, Type* t) {
-  return this->genMarshalCall(skt, var, t, false);
+  if (eltType == NULL) {
+    return this->genMarshalCall(buf, var, t, out);
+  }
+
+  gen += out ? marshal_arr_push_prefix : marshal_arr_pull_prefix;
+  gen += str(this->assignUniqueArrayID(eltType));
+  gen += "(";
+  gen += buf;
+
+  if (out) {
+    gen += ",";
+    gen += var;
+  }
+
+  gen += ");\n";
+
+  return gen;
 }
 
 std::string MLIContext::genTypeName(Type* t) {
@@ -960,17 +1054,16 @@ std::string MLIContext::genTypeName(Type* t) {
 }
 
 //
-// Bit of duplication, but "genSocketCall()" sadly assumes a value type, which
-// means it doesn't work very well with buffers.
+// Pack or unpack 'len' bytes at the pointer 'var'.
 //
 std::string
-MLIContext::genSocketCallBuffer(const char* skt, const char* var,
-                                const char* len, bool out) {
+MLIContext::genBufferCall(const char* buf, const char* var, const char* len,
+                          bool out) {
   std::string gen;
 
-  gen += out ? socket_push_name : socket_pull_name;
+  gen += out ? buffer_write_name : buffer_read_name;
   gen += "(";
-  gen += skt;
+  gen += buf;
   gen += ", ";
   // To get rid of _discards qualifiers_ warnings.
   gen += "((void*) ";
@@ -978,40 +1071,27 @@ MLIContext::genSocketCallBuffer(const char* skt, const char* var,
   gen += ")";
   gen += ", ";
   gen += len;
-  gen += ", 0);\n";
+  gen += ");\n";
 
   return gen;
 }
 
+//
+// Pack or unpack the value 'var'.
+//
 std::string
-MLIContext::genSocketCall(const char* skt, const char* var, const char* len,
-                          bool out) {
+MLIContext::genBufferCall(const char* buf, const char* var, bool out) {
   std::string gen;
+  std::string len;
 
-  gen += out ? socket_push_name : socket_pull_name;
-  gen += "(";
-  gen += skt;
-  gen += ", ";
-  gen += var ? this->genAddressOf(var) : "((void*)\"\")";
-  gen += ", ";
-  gen += len ? len : (var ? this->genSizeof(var) : "0");
-  gen += ", 0);\n";
-
-  return gen;
-}
-
-std::string
-MLIContext::genSocketCall(const char* skt, const char* var, bool out) {
-  return this->genSocketCall(skt, var, NULL, out);
-}
-
-std::string MLIContext::genSocketPushCall(const char* skt, const char* var) {
-  return this->genSocketCall(skt, var, true);
-}
+  len += "sizeof(";
+  len += var;
+  len += ")";
 
+  gen += this->genBufferCall(buf, this->genAddressOf(var).c_str(),
+                             len.c_str(), out);
 
-std::string MLIContext::genSocketPullCall(const char* skt, const char* var) {
-  return this->genSocketCall(skt, var, false);
+  return gen;
 }
 
 std::string MLIContext::genAddressOf(const char* var) {
@@ -1023,24 +1103,6 @@ std::string MLIContext::genAddressOf(const char* var) {
   return gen;
 }
 
-std::string MLIContext::genAddressOf(std::string& var) {
-  return this->genAddressOf(var.c_str());
-}
-
-std::string MLIContext::genSizeof(const char* var) {
-  std::string gen;
-
-  gen += "sizeof(";
-  gen += var;
-  gen += ")";
-
-  return gen;
-}
-
-std::string MLIContext::genSizeof(std::string& var) {
-  return this->genAddressOf(var.c_str());
-}
-
 bool MLIContext::isTypeRequiringAlloc(Type* t) {
   return
       // TODO: Do we just assume that all CPTRs require allocation?
@@ -1184,6 +1184,24 @@ static std::string pythonArgToByteBuffer(ArgSymbol* as) {
   return res;
 }
 
+//
+// The numpy dtype whose elements have the same layout as the C type of
+// 'eltType', or "" if there isn't one we can share memory with.  Python's
+// float is a double, but 'bint' is a C int and so doesn't match a bool.
+//
+static std::string pythonNumpyDtype(Type* eltType) {
+  if (eltType == dtReal[FLOAT_SIZE_64]) {
+    return "numpy.float64";
+  }
+
+  std::string typeStr = getPythonTypeName(eltType, PYTHON_PYX);
+  if (strncmp(typeStr.c_str(), "numpy.", strlen("numpy.")) == 0) {
+    return typeStr;
+  }
+
+  return "";
+}
+
 static std::string pythonArgToExternalArray(ArgSymbol* as) {
   std::string strname = as->cname;
 
@@ -1192,22 +1210,54 @@ static std::string pythonArgToExternalArray(ArgSymbol* as) {
     // if this arg's type was originally a Chapel array instead of explicitly
     // an external array.  If we have the element type, that means we need to
     // do a translation in the python wrapper.
-    std::string typeStr = getPythonTypeName(eltType->type, PYTHON_PYX);
     std::string typeStrCDefs = getPythonTypeName(eltType->type, C_PYX);
+    std::string dtype = pythonNumpyDtype(eltType->type);
+    std::string indent = "\t";
+
+    std::string res = "\tcdef chpl_external_array chpl_" + strname + "\n";
+
+    // A numpy array that already has the layout Chapel expects is passed
+    // by pointer instead of being copied.  The external array doesn't own
+    // the buffer, so freeing it afterwards is a no-op.  For example:
+    //
+    //   cdef numpy.ndarray chpl_np_foo
+    //   if isinstance(foo, numpy.ndarray) and foo.ndim == 1 and
+    //      foo.dtype == numpy.int64 and foo.flags['C_CONTIGUOUS'] and
+    //      foo.flags['ALIGNED'] and foo.flags['WRITEABLE']:
+    //     chpl_np_foo = foo
+    //     chpl_foo = chpl_make_external_array_ptr(<void*>chpl_np_foo.data,
+    //                                             len(foo))
+    //   else:
+    //     (copy, as below)
+    //
+    if (dtype != "") {
+      std::string npname = "chpl_np_" + strname;
+      res += "\tcdef numpy.ndarray " + npname + "\n";
+      res += "\tif isinstance(" + strname + ", numpy.ndarray) and ";
+      res += strname + ".ndim == 1 and ";
+      res += strname + ".dtype == " + dtype + " and ";
+      res += strname + ".flags['C_CONTIGUOUS'] and ";
+      res += strname + ".flags['ALIGNED'] and ";
+      res += strname + ".flags['WRITEABLE']:\n";
+      res += "\t\t" + npname + " = " + strname + "\n";
+      res += "\t\tchpl_" + strname + " = chpl_make_external_array_ptr(";
+      res += "<void*>" + npname + ".data, len(" + strname + "))\n";
+      res += "\telse:\n";
+      indent += "\t";
+    }
 
     // Create the memory needed to store the contents of what was passed to us
-    // E.g. cdef chpl_external_array chpl_foo =
-    //          chpl_make_external_array(sizeof(element type), len(foo))
-    std::string res = "\tcdef chpl_external_array chpl_" + strname;
+    // E.g. chpl_foo = chpl_make_external_array(sizeof(element type), len(foo))
+    res += indent + "chpl_" + strname;
     res += " = chpl_make_external_array(sizeof(" + typeStrCDefs + "), len(";
     res += strname + "))\n";
 
     // Copy the contents over.
     // E.g. for i in range(len(foo)):
     //         (<element type*>chpl_foo.elts)[i] = foo[i]
-    res += "\tfor i in range(len(" + strname + ")):\n";
-    res += "\t\t(<" + typeStrCDefs + "*>chpl_" + strname + ".elts)[i] = ";
-    res += strname + "[i]\n";
+    res += indent + "for i in range(len(" + strname + ")):\n";
+    res += indent + "\t(<" + typeStrCDefs + "*>chpl_" + strname;
+    res += ".elts)[i] = " + strname + "[i]\n";
 
     return res;
   }
@@ -2937,6 +2987,41 @@ static void pythonRetExternalArray(FnSymbol* fn, std::string& funcCall,
     }
 
     res += "\t\tret[i] = slot\n";
+  } else if (pythonNumpyDtype(eltType) != "") {
+    //
+    // When the returned array owns its buffer, hand the buffer to numpy
+    // instead of copying it.  The Cython array frees it with the array's
+    // own free function once the last view of it goes away.  Arrays that
+    // don't own their buffer, and empty ones (which Cython can't view),
+    // are copied as before:
+    //
+    //  cdef view.array ret_view
+    //  if ret_arr.freer != NULL and ret_arr.num_elts > 0:
+    //    ret_view = <C element type[:ret_arr.num_elts]>
+    //                 (<C element type*>ret_arr.elts)
+    //    ret_view.callback_free_data = <void (*)(void*)>ret_arr.freer
+    //    ret = numpy.asarray(ret_view)
+    //  else:
+    //    ret = numpy.zeros(...)
+    //    (copy)
+    //    chpl_free_external_array(ret_arr)
+    //
+    res = "\tcdef numpy.ndarray [" + typeStrCDefs + ", ndim=1] ret\n";
+    res += "\tcdef view.array ret_view\n";
+    res += "\tif ret_arr.freer != NULL and ret_arr.num_elts > 0:\n";
+    res += "\t\tret_view = <" + typeStrCDefs + "[:ret_arr.num_elts]> ";
+    res += "(<" + typeStrCDefs + "*>ret_arr.elts)\n";
+    res += "\t\tret_view.callback_free_data = ";
+    res += "<void (*)(void*)>ret_arr.freer\n";
+    res += "\t\tret = numpy.asarray(ret_view)\n";
+    res += "\telse:\n";
+    res += "\t\tret = numpy.zeros(shape = ret_arr.num_elts, dtype = ";
+    res += typeStr + ")\n";
+    res += "\t\tfor i in range(ret_arr.num_elts):\n";
+    res += "\t\t\tret[i] = (<" + typeStrCDefs + "*>ret_arr.elts)[i]\n";
+    res += "\t\tchpl_free_external_array(ret_arr)\n";
+    returnStmt += res;
+    return;
   } else {
     // Populate it with the contents we return (which translated C types into
     // Python types)
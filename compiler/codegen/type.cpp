@@ -36,6 +36,7 @@
 #include "llvmVer.h"
 #include "misc.h"
 #include "passes.h"
+#include "resolution.h"
 #include "stringutil.h"
 #include "symbol.h"
 #include "vec.h"
@@ -310,7 +311,14 @@ void AggregateType::codegenDef() {
         if (this->fields.length != 0)
           fprintf(outfile, "} _u;\n");
       }
-      fprintf(outfile, "} %s;\n\n", this->classStructName(true));
+      // Each task of a forall with a reduce intent gets its own reduce op
+      // instance.  Keep them on separate cache lines so that updating one
+      // task's op doesn't slow down the others.
+      if (aggregateTag == AGGREGATE_CLASS && isReduceOp(this))
+        fprintf(outfile, "} CHPL_CACHE_LINE_ALIGNED %s;\n\n",
+                this->classStructName(true));
+      else
+        fprintf(outfile, "} %s;\n\n", this->classStructName(true));
     } else {
 #ifdef HAVE_LLVM
       int paramID = 0;
@@ -126,6 +126,7 @@ public:
                                            bool evalDefaults,
                                            Expr* insnPoint = NULL);
   void                        resolveConcreteType();
+  void                        checkSoaLayout()                           const;
 
   bool                        isInstantiatedFrom(const AggregateType* base)
                                                                          const;
@@ -34,8 +34,11 @@
 #ifndef _BASEAST_H_
 #define _BASEAST_H_
 
+#include <mutex>
 #include <ostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "astlocs.h"
 #include "map.h"
@@ -277,6 +280,10 @@ public:
 
   static  const       std::string tabText;
 
+  // nodes come from the AST arena; see baseAST.cpp
+  static void*      operator new   (size_t size);
+  static void       operator delete(void* ptr, size_t size);
+
 protected:
                     BaseAST(AstTag type);
   virtual          ~BaseAST();
@@ -294,6 +301,29 @@ GenRet baseASTCodegenString(const char* str);
 // get the current AST node id
 int    lastNodeIDUsed();
 
+//
+// While forEachFnInParallel() runs a pass on several threads, the state
+// that functions share -- the SymExpr lists of symbols referenced from
+// more than one function, such as immediates, and a few global vectors --
+// is only changed under this lock.  New AST nodes can't be created then.
+//
+extern bool       gAstThreadsActive;
+extern std::mutex gSharedAstMutex;
+
+class SharedAstLock {
+public:
+  SharedAstLock() : mLocked(gAstThreadsActive) {
+    if (mLocked) gSharedAstMutex.lock();
+  }
+
+  ~SharedAstLock() {
+    if (mLocked) gSharedAstMutex.unlock();
+  }
+
+private:
+  bool mLocked;
+};
+
 // trace various AST node removals
 void   trace_remove(BaseAST* ast, char flag);
 
@@ -722,6 +752,11 @@ void destroyAst(void);
 //
 void printStatistics(const char* pass);
 
+//
+// the bytes held by the nodes of each AST kind, by kind name
+//
+void astKindBytes(std::vector<std::pair<const char*, size_t> >& bytes);
+
 void registerModule(ModuleSymbol* mod);
 
 //
@@ -102,9 +102,11 @@ public:
   static void        printBitVectorSets(BitVecVector& sets);
 
 
-  static BasicBlock*                          basicBlock;
-  static Map<LabelSymbol*, BasicBlock*>       labelMaps;
-  static Map<LabelSymbol*, BasicBlockVector*> gotoMaps;
+  // thread_local so that passes run by forEachFnInParallel() can build
+  // the blocks of several functions at once
+  static thread_local BasicBlock*                          basicBlock;
+  static thread_local Map<LabelSymbol*, BasicBlock*>       labelMaps;
+  static thread_local Map<LabelSymbol*, BasicBlockVector*> gotoMaps;
 
 private:
   static void        buildBasicBlocks(FnSymbol* fn,
@@ -121,7 +123,7 @@ private:
   static void        removeEmptyBlocks(FnSymbol* fn);
   static bool        verifyBasicBlocks(FnSymbol* fn);
 
-  static int         nextID;
+  static thread_local int nextID;
 
   //
   // Instance methods/variables
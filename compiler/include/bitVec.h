@@ -22,10 +22,15 @@
 #define _CHPL_BIT_VEC_H_
 
 #include <cstddef>
+#include <stdint.h>
 
 class BitVec {
 public:
-  unsigned* data;
+  // 64-bit words keep the whole-vector loops short and easy for the C++
+  // compiler to vectorize.  Bits past in_size are kept clear.
+  typedef uint64_t Word;
+
+  Word*     data;
   size_t    in_size;
   size_t    ndata;
 
@@ -43,6 +48,7 @@ public:
 
   void   disjunction(const BitVec& other);
   void   intersection(const BitVec& other);
+  void   difference(const BitVec& other);
 
   void   operator =  (const BitVec& other) { this->copy(other);         }
 
@@ -79,11 +85,7 @@ public:
 
 inline void BitVec::operator-=(const BitVec& other)
 {
-  BitVec not_other(other);
-
-  not_other.flip();
-
-  this->intersection(not_other);
+  this->difference(other);
 }
 
 inline bool operator==(const BitVec& a, const BitVec& b)
@@ -122,10 +124,9 @@ inline BitVec operator+(const BitVec& a, const BitVec& b)
 
 inline BitVec operator-(const BitVec& a, const BitVec& b)
 {
-  BitVec result(b);
+  BitVec result(a);
 
-  result.flip();
-  result.intersection(a);
+  result.difference(b);
 
   return result;
 }
@@ -63,6 +63,7 @@ void check_optimizeOnClauses();
 void check_addInitCalls();
 void check_insertLineNumbers();
 void check_denormalize();
+void check_foldIdenticalFunctions();
 void check_codegen();
 void check_makeBinary();
 
@@ -58,6 +58,10 @@ class LayeredValueTable;
 #include "files.h"
 #include "genret.h"
 
+// Loop metadata operand giving the Chapel file and line of a loop,
+// for --report-vectorizer-remarks.
+#define CHPL_LOOP_LOCATION_MD "chpl.loop.location"
+
 /* This class contains information helpful in generating
  * code for nested loops. */
 struct LoopData
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _COMPILE_CACHE_H_
+#define _COMPILE_CACHE_H_
+
+// With --compile-cache <dir>, a compile whose inputs all match an
+// earlier successful compile reuses that compile's executable instead
+// of running the passes after 'parse'.
+
+// Called after 'parse'.  On a hit this writes the executable and exits.
+void compileCacheLookup();
+
+// Called after 'makeBinary' to save the executable for later compiles.
+void compileCacheStore();
+
+#endif
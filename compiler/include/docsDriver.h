@@ -34,6 +34,7 @@ extern char fDocsSphinxDir[256];
 extern bool fDocsHTML;
 extern bool fDocsProcessUsedModules;
 extern char fDocsProjectVersion[256];
+extern int  fDocsSphinxJobs;
 
 // TODO: Whether or not to support this flag is an open discussion. Currently,
 //       it is not supported, so the flag is always true.
@@ -21,15 +21,46 @@
 #ifndef _CHPL_DOMINATOR_H
 #define _CHPL_DOMINATOR_H
 
-#include "astutil.h"
 #include "bb.h"
-#include "bitVec.h"
-#include <set>
 
-void computeDominators(std::vector<BitVec*>& dominators, std::vector<BasicBlock*>& basicBlocks);
-bool dominates(unsigned a, unsigned b, std::vector<BitVec*> & dominators);
-bool strictlyDominates(unsigned a, unsigned b, std::vector<BitVec*> & dominators);
+#include <vector>
 
-void computeImmediateDominators(std::vector<unsigned>& immediateDominators, std::vector<BitVec*>& dominators);
+/*
+ * The dominator tree of a function's basic blocks, indexed by block id with
+ * block 0 as the entry.  Blocks that can't be reached from the entry
+ * neither dominate nor are dominated by any block.
+ */
+class DominatorTree {
+public:
+  DominatorTree(std::vector<BasicBlock*>& basicBlocks);
+
+  bool isReachable(unsigned b)                      const;
+
+  // a dominates b if every path from the entry to b goes through a
+  bool dominates(unsigned a, unsigned b)            const;
+  bool strictlyDominates(unsigned a, unsigned b)    const;
+
+  // The closest strict dominator of b, or -1 for the entry and
+  // unreachable blocks
+  int  immediateDominator(unsigned b)               const;
+
+private:
+  void computeReversePostorder(std::vector<BasicBlock*>& basicBlocks);
+  void computeImmediateDominators(std::vector<BasicBlock*>& basicBlocks);
+  void numberTree();
+
+  unsigned intersect(unsigned a, unsigned b)        const;
+
+  // blocks in reverse postorder and each block's position in it, or -1
+  std::vector<unsigned> order;
+  std::vector<int>      rpoNumber;
+
+  std::vector<int>      idom;
+
+  // entry and exit times of a walk of the tree, so that a dominates b
+  // exactly when b's interval nests inside a's
+  std::vector<unsigned> treeIn;
+  std::vector<unsigned> treeOut;
+};
 
 #endif
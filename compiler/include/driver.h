@@ -37,12 +37,14 @@ extern bool fFastFlag;
 extern bool fNoBoundsChecks;
 extern bool fNoCopyPropagation;
 extern bool fNoDeadCodeElimination;
+extern bool fNoDeadFieldElimination;
 extern bool fNoGlobalConstOpt;
 extern bool fNoFastFollowers;
 extern bool fNoInlineIterators;
 extern bool fNoLoopInvariantCodeMotion;
 extern bool fNoInterproceduralAliasAnalysis;
 extern bool fNoInline;
+extern int inlineSizeThreshold;
 extern bool fNoLiveAnalysis;
 extern bool fNoFormalDomainChecks;
 extern bool fNoLocalChecks;
@@ -55,16 +57,31 @@ extern bool fNoDivZeroChecks;
 extern bool fMungeUserIdents;
 extern bool fEnableTaskTracking;
 extern bool fLLVMWideOpt;
+extern bool fPackedWidePointers;
+extern bool fLtoRuntime;
+extern int llvmCodegenThreads;
+extern int llvmInterleaveCount;
+extern int optimizationThreads;
+extern bool fProfileGenerate;
+extern char profileUseFile[FILENAME_MAX+1];
+
+// Where executables built with --profile-generate write their profiles.
+// One file per host and process, so each locale writes its own.
+#define PROFILE_GENERATE_FILE "chpl-%h-%p.profraw"
 
 extern bool fAutoLocalAccess;
 extern bool fDynamicAutoLocalAccess;
 extern bool fReportAutoLocalAccess;
 
+extern bool fBoundsCheckElimination;
+extern bool fReportBoundsChecks;
+
 extern bool fNoRemoteValueForwarding;
 extern bool fNoInferConstRefs;
 extern bool fNoRemoteSerialization;
 extern bool fNoRemoveCopyCalls;
 extern bool fNoScalarReplacement;
+extern bool fNoScalarReplaceAggregates;
 extern bool fNoTupleCopyOpt;
 extern bool fNoOptimizeRangeIteration;
 extern bool fNoOptimizeLoopIterators;
@@ -74,17 +91,31 @@ extern bool fNoPrivatization;
 extern bool fNoOptimizeOnClauses;
 extern bool fNoRemoveEmptyRecords;
 extern bool fNoInferLocalFields;
+extern bool fNoInferLocalPointers;
+extern bool fNoDevirtualize;
+extern bool fNoSpeculativeDevirtualize;
+extern bool fNoSpecializeReductions;
+extern bool fNoFoldIdenticalFunctions;
 extern bool fRemoveUnreachableBlocks;
 extern bool fReplaceArrayAccessesWithRefTemps;
 extern int  optimize_on_clause_limit;
 extern int  scalar_replace_limit;
 extern int  inline_iter_yield_limit;
 extern int  tuple_copy_limit;
+extern int  rvf_record_limit;
+extern int  ret_by_ref_record_size;
 
 extern bool fNoOptimizeForallUnordered;
 extern bool fReportOptimizeForallUnordered;
+extern bool fNoPrefetchForallReads;
+extern bool fReportPrefetchForallReads;
+extern bool fNoStrengthReduction;
+extern bool fReportStrengthReduction;
+extern bool fNoCoforallOnTree;
+extern bool fReportCoforallOnTree;
 
 extern bool report_inlining;
+extern bool fReportAutoInline;
 
 // Chapel Envs
 bool useDefaultEnv(std::string key);
@@ -132,6 +163,7 @@ extern const char* CHPL_LLVM_UNIQ_CFG_PATH;
 
 extern bool  printPasses;
 extern FILE* printPassesFile;
+extern FILE* printPassesJsonFile;
 
 extern char fExplainCall[256];
 extern int  explainCallID;
@@ -216,11 +248,18 @@ extern bool fReportBlocking;
 extern bool fReportOptimizedLoopIterators;
 extern bool fReportInlinedIterators;
 extern bool fReportVectorizedLoops;
+extern bool fReportVectorizerRemarks;
 extern bool fReportOptimizedOn;
+extern bool fReportLocalPointers;
+extern bool fReportDevirtualization;
+extern bool fReportFoldIdenticalFunctions;
+extern bool fReportSharedWrites;
 extern bool fReportPromotion;
+extern int  fReportResolutionProfile;
 extern bool fReportScalarReplace;
 extern bool fReportDeadBlocks;
 extern bool fReportDeadModules;
+extern bool fReportDeadFields;
 
 extern bool fPermitUnhandledModuleErrors;
 
@@ -32,6 +32,8 @@ extern char libmodeHeadername[FILENAME_MAX+1];
 extern char fortranModulename[FILENAME_MAX+1];
 extern char pythonModulename[FILENAME_MAX+1];
 extern char saveCDir[FILENAME_MAX+1];
+extern char compileCacheDir[FILENAME_MAX+1];
+extern char clangPchCacheDir[FILENAME_MAX+1];
 extern std::string ccflags;
 extern std::string ldflags;
 extern bool ccwarnings;
@@ -60,6 +62,8 @@ const char* stripdirectories(const char* filename);
 
 void openCFile(fileinfo* fi, const char* name, const char* ext = NULL);
 void closeCFile(fileinfo* fi, bool beautifyIt=true);
+void openCFileIfChanged(fileinfo* fi, const char* name, const char* ext = NULL);
+void closeCFileIfChanged(fileinfo* fi, bool beautifyIt=true);
 
 fileinfo* openTmpFile(const char* tmpfilename, const char* mode = "w");
 
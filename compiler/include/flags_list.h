@@ -83,6 +83,7 @@ symbolFlag( FLAG_COERCE_TEMP , npr, "coerce temp" , "a temporary that was stores
 symbolFlag( FLAG_COERCE_FN,  ypr, "coerce fn" , "coerce copy/move function" )
 symbolFlag( FLAG_CODEGENNED , npr, "codegenned" , "code has been generated for this type" )
 symbolFlag( FLAG_COFORALL_INDEX_VAR , npr, "coforall index var" , ncm )
+symbolFlag( FLAG_COFORALL_ON_TREE , npr, "coforall on tree" , "recursive function that fans a coforall-on over Locales out through a spanning tree" )
 symbolFlag( FLAG_COMMAND_LINE_SETTING , ypr, "command line setting" , ncm )
 // The compiler-generated flag has these meanings:
 // 1. In various parts of the compiler, when printing filename/lineno
@@ -195,6 +196,7 @@ symbolFlag( FLAG_INSTANTIATED_PARAM , npr, "instantiated param" , "this formal i
 symbolFlag( FLAG_INSTANTIATED_GENERIC , npr, "instantiated generic" , "this is an instantiation of a generic" )
 symbolFlag( FLAG_INSTANTIATED_FROM_ANY , npr, "instantiated from any" , "this is an instantiation from any type" )
 symbolFlag( FLAG_INTENT_REF_MAYBE_CONST_FORMAL, ypr, "intent ref maybe const formal", "The intent for this formal is ref if it is modified, const ref otherwise" )
+symbolFlag( FLAG_INVARIANT_FIELD , ypr, "invariant field" , "a field that only changes when its object is initialized or reallocated, so LICM can hoist reads of it" )
 symbolFlag( FLAG_IMPLEMENTS_WRAPPER, npr, "ImplementsStmt wrapper", ncm)
 symbolFlag( FLAG_INVISIBLE_FN , npr, "invisible fn" , "invisible function (not a candidate for resolution)" )
 symbolFlag( FLAG_ITERATOR_CLASS , npr, "iterator class" , ncm )
@@ -421,6 +423,7 @@ symbolFlag( FLAG_SAFE, ypr, "safe", "safe (activate lifetime checking)")
 symbolFlag( FLAG_SCOPE, npr, "scope", "scoped (lifetime checking like a local variable)")
 symbolFlag( FLAG_SHOULD_NOT_PASS_BY_REF, npr, "should not pass by ref", "this symbol should be passed by value (not by reference) for performance, not for correctness")
 symbolFlag( FLAG_SINGLE , ypr, "single" , ncm )
+symbolFlag( FLAG_SOA_LAYOUT , ypr, "soa layout" , "arrays of this record may store each field in its own array" )
 // Based on how this is used, I suggest renaming it to return_value_has_initializer
 // or something similar <hilde>.
 symbolFlag( FLAG_STAR_TUPLE , ypr, "star tuple" , "mark tuple types as star tuple types" )
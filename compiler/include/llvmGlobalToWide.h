@@ -128,11 +128,16 @@ struct GlobalToWideInfo {
   unsigned wideSpace;
 
   unsigned globalPtrBits;
-  // this optimization currently assumes wide pointers are
-  // stored in a 128-bit struct representation that contains
+  // wide pointers are normally stored in a 128-bit struct
+  // representation that contains
   //  locale-id
   //      node
   //  addr
+  // If packedAddrBits is nonzero, they are instead 64-bit pointers
+  // with the address in the low packedAddrBits bits and the node
+  // in the bits above it. That only works for locale ids that are
+  // just a node (the flat locale model).
+  unsigned packedAddrBits;
 
   llvm::Type* localeIdType;
   llvm::Type* nodeIdType;
@@ -166,7 +171,7 @@ struct GlobalToWideInfo {
   runtime_fn_t preservingFn;
 
   GlobalToWideInfo()
-    : globalSpace(0), wideSpace(0), globalPtrBits(0),
+    : globalSpace(0), wideSpace(0), globalPtrBits(0), packedAddrBits(0),
       localeIdType(NULL), nodeIdType(NULL), gTypes(), specialFunctions(),
       getFn(NULL), getFnType(NULL),
       putFn(NULL), putFnType(NULL),
@@ -168,6 +168,45 @@ template <class K, class AHashFns, class C> class ChainHashMap :
   void get_values(Vec<C> &values);
 };
 
+// Open addressing hash map with the interface of ChainHashMap.  Entries
+// and their hashes live in one power-of-two array probed linearly, so a
+// lookup touches a cache line or two instead of following list cells, and
+// most misses are rejected on the hash.  As with Map, the key ((K)0) marks
+// an empty slot and should not be used.  Pointers returned by put() are
+// invalidated by the next put().
+template <class K, class AHashFns, class C> class OpenHashMap {
+ public:
+  OpenHashMap() : slots(0), size(0), used(0), full(0) { }
+  ~OpenHashMap() { free(slots); }
+
+  MapElem<K,C> *put(K akey, C avalue);
+  C get(K akey);
+  int del(K akey);
+  void get_keys(Vec<K> &keys);
+  void get_values(Vec<C> &values);
+  void clear();
+  int count() { return full; }
+
+ private:
+  struct Slot {
+    unsigned int  hash;
+    bool          deleted;
+    MapElem<K,C>  elem;
+  };
+
+  Slot *slots;
+  int   size;   // a power of two, or 0
+  int   used;   // full or deleted slots
+  int   full;
+
+  static unsigned int mix(unsigned int h) { return h * 0x9E3779B1u; }
+  Slot *find(K akey, unsigned int h);
+  void grow();
+
+  OpenHashMap(const OpenHashMap&);
+  OpenHashMap& operator=(const OpenHashMap&);
+};
+
 class StringChainHash : public ChainHash<char *, StringHashFns> {
  public:
   char *canonicalize(char *s, char *e);
@@ -522,6 +561,109 @@ ChainHashMap<K, AHashFns, C>::get_values(Vec<C> &values) {
   }
 }
 
+template <class K, class AHashFns, class C>
+typename OpenHashMap<K, AHashFns, C>::Slot *
+OpenHashMap<K, AHashFns, C>::find(K akey, unsigned int h) {
+  if (!size)
+    return 0;
+  unsigned int mask = size - 1;
+  for (unsigned int k = (h >> 16 ^ h) & mask;; k = (k + 1) & mask) {
+    Slot *slot = &slots[k];
+    if (!slot->elem.key && !slot->deleted)
+      return 0;
+    if (slot->elem.key && slot->hash == h &&
+        AHashFns::equal(akey, slot->elem.key))
+      return slot;
+  }
+}
+
+template <class K, class AHashFns, class C> void
+OpenHashMap<K, AHashFns, C>::grow() {
+  Slot *old = slots;
+  int oldSize = size;
+  // only grow when full entries, not tombstones, fill the table
+  if (!size)
+    size = 16;
+  else if (full * 2 >= size)
+    size = size * 2;
+  slots = (Slot*)calloc(size, sizeof(Slot));
+  used = full;
+  unsigned int mask = size - 1;
+  for (int i = 0; i < oldSize; i++) {
+    if (old[i].elem.key) {
+      unsigned int k = (old[i].hash >> 16 ^ old[i].hash) & mask;
+      while (slots[k].elem.key)
+        k = (k + 1) & mask;
+      slots[k] = old[i];
+    }
+  }
+  free(old);
+}
+
+template <class K, class AHashFns, class C> MapElem<K,C> *
+OpenHashMap<K, AHashFns, C>::put(K akey, C avalue) {
+  unsigned int h = mix(AHashFns::hash(akey));
+  if (Slot *slot = find(akey, h)) {
+    slot->elem.value = avalue;
+    return &slot->elem;
+  }
+  if ((used + 1) * 4 > size * 3)
+    grow();
+  unsigned int mask = size - 1;
+  unsigned int k = (h >> 16 ^ h) & mask;
+  while (slots[k].elem.key)
+    k = (k + 1) & mask;
+  if (!slots[k].deleted)
+    used++;
+  slots[k].hash = h;
+  slots[k].deleted = false;
+  slots[k].elem.key = akey;
+  slots[k].elem.value = avalue;
+  full++;
+  return &slots[k].elem;
+}
+
+template <class K, class AHashFns, class C> C
+OpenHashMap<K, AHashFns, C>::get(K akey) {
+  Slot *slot = find(akey, mix(AHashFns::hash(akey)));
+  if (!slot)
+    return 0;
+  return slot->elem.value;
+}
+
+template <class K, class AHashFns, class C> int
+OpenHashMap<K, AHashFns, C>::del(K akey) {
+  Slot *slot = find(akey, mix(AHashFns::hash(akey)));
+  if (!slot)
+    return 0;
+  slot->elem.key = 0;
+  slot->elem.value = 0;
+  slot->deleted = true;
+  full--;
+  return 1;
+}
+
+template <class K, class AHashFns, class C> void
+OpenHashMap<K, AHashFns, C>::get_keys(Vec<K> &keys) {
+  for (int i = 0; i < size; i++)
+    if (slots[i].elem.key)
+      keys.add(slots[i].elem.key);
+}
+
+template <class K, class AHashFns, class C> void
+OpenHashMap<K, AHashFns, C>::get_values(Vec<C> &values) {
+  for (int i = 0; i < size; i++)
+    if (slots[i].elem.key)
+      values.add(slots[i].elem.value);
+}
+
+template <class K, class AHashFns, class C> void
+OpenHashMap<K, AHashFns, C>::clear() {
+  free(slots);
+  slots = 0;
+  size = used = full = 0;
+}
+
 inline char *
 StringChainHash::canonicalize(char *s, char *e) {
   unsigned int h = 0;
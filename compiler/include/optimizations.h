@@ -60,12 +60,22 @@ size_t singleAssignmentRefPropagation(FnSymbol* fn);
 void deadVariableElimination(FnSymbol* fn);
 void deadExpressionElimination(FnSymbol* fn);
 
+void forEachFnInParallel(std::vector<FnSymbol*>& fns,
+                         void (*pass)(FnSymbol* fn));
+
 bool outlivesBlock(LifetimeInformation* info, Symbol* sym, BlockStmt* block);
 
 void checkLifetimesForForallUnorderedOps(FnSymbol* fn,
                                          LifetimeInformation* lifetimeInfo);
 void optimizeForallUnorderedOps();
 
+void prefetchForallRemoteReads();
+
+void strengthReduceLoops();
+
+void noteProvenInBoundsAccess(CallExpr* call);
+void removeProvenBoundsChecks();
+
 void liveVariableAnalysis(FnSymbol* fn,
                           Vec<Symbol*>& locals,
                           Map<Symbol*,int>& localID,
@@ -51,6 +51,7 @@ void docs();
 void expandExternArrayCalls();
 void flattenClasses();
 void flattenFunctions();
+void foldIdenticalFunctions();
 void inlineFunctions();
 void insertLineNumbers();
 void insertWideReferences();
@@ -30,5 +30,6 @@ Symbol *earlyNormalizeForallIterand(CallExpr *call, ForallStmt *forall);
 
 // interface for resolution
 Expr *preFoldMaybeLocalThis(CallExpr *call);
+Expr *preFoldProvenInBounds(CallExpr *call);
 
 #endif
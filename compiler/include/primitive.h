@@ -52,7 +52,7 @@ class PrimitiveOp { public:
               QualifiedType (*areturnInfo)(CallExpr*));
 };
 
-extern HashMap<const char *, StringHashFns, PrimitiveOp *> primitives_map;
+extern OpenHashMap<const char *, StringHashFns, PrimitiveOp *> primitives_map;
 
 extern PrimitiveOp*     primitives[NUM_KNOWN_PRIMS];
 
@@ -169,6 +169,7 @@
   PRIMITIVE_G(PRIM_ARRAY_SET_FIRST)
 
   PRIMITIVE_R(PRIM_MAYBE_LOCAL_THIS)
+  PRIMITIVE_R(PRIM_PROVEN_IN_BOUNDS)
 
   PRIMITIVE_R(PRIM_ERROR)
   PRIMITIVE_R(PRIM_WARNING)
@@ -212,6 +213,9 @@
 
   PRIMITIVE_G(PRIM_ON_LOCALE_NUM)
 
+  PRIMITIVE_G(PRIM_COFORALL_TREE_NUM_CHILDREN)
+  PRIMITIVE_G(PRIM_COFORALL_TREE_CHILD)
+
   PRIMITIVE_G(PRIM_REGISTER_GLOBAL_VAR)
   PRIMITIVE_G(PRIM_BROADCAST_GLOBAL_VARS)
   PRIMITIVE_G(PRIM_PRIVATE_BROADCAST)
@@ -263,6 +267,7 @@
   PRIMITIVE_R(PRIM_IS_ATOMIC_TYPE)
   PRIMITIVE_R(PRIM_IS_REF_ITER_TYPE)
   PRIMITIVE_R(PRIM_IS_EXTERN_TYPE)
+  PRIMITIVE_R(PRIM_IS_SOA_LAYOUT_TYPE)
   PRIMITIVE_R(PRIM_IS_ABS_ENUM_TYPE)
 
   PRIMITIVE_R(PRIM_IS_POD)
@@ -108,6 +108,7 @@ enum BlockTag {
   BLOCK_TYPE_ONLY   = 1<<1, ///< deleted after type resolution
   BLOCK_EXTERN      = 1<<2, ///< init block for an extern var
   BLOCK_C_FOR_LOOP  = 1<<3, ///< init/test/incr block for a CForLoop
+  BLOCK_BOUNDS_CHECK = 1<<4, ///< body of 'if boundsChecking' until resolved
 
   // Bit masks:
   BLOCK_TYPE        = BLOCK_SCOPELESS | BLOCK_TYPE_ONLY,
@@ -776,8 +776,8 @@ void addTaskIntent(CallExpr* ti, ShadowVarSymbol* svar);
 
 extern bool localTempNames;
 
-extern HashMap<Immediate*, ImmHashFns, VarSymbol*> uniqueConstantsHash;
-extern HashMap<Immediate*, ImmHashFns, VarSymbol*> stringLiteralsHash;
+extern OpenHashMap<Immediate*, ImmHashFns, VarSymbol*> uniqueConstantsHash;
+extern OpenHashMap<Immediate*, ImmHashFns, VarSymbol*> stringLiteralsHash;
 
 extern StringChainHash uniqueStringHash;
 
@@ -26,10 +26,15 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
 #include <cctype>
 #include <cstring>
 #include <cstdio>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #ifdef HAVE_LLVM
 #include "clang/AST/GlobalDecl.h"
@@ -57,18 +62,29 @@
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Linker/Linker.h"
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+#if HAVE_LLVM_VER >= 60
+#include "llvm/IR/DiagnosticHandler.h"
+#endif
 
 #if HAVE_LLVM_VER >= 90
 #include "llvm/Support/CodeGen.h"
@@ -122,6 +138,9 @@ using namespace llvm;
 #define GLOBAL_PTR_SPACE 100
 #define WIDE_PTR_SPACE 101
 #define GLOBAL_PTR_SIZE 128
+#define PACKED_GLOBAL_PTR_SIZE 64
+// This needs to match CHPL_WIDE_POINTER_ADDR_BITS in chpl-wide-ptr-fns.h
+#define PACKED_PTR_ADDR_BITS 48
 #define GLOBAL_PTR_ABI_ALIGN 64
 #define GLOBAL_PTR_PREF_ALIGN 64
 
@@ -1756,6 +1775,169 @@ static void setupModule()
       /*IsConstant=*/true);
 }
 
+// Add the functions with instructions using 'user' to 'fns', looking
+// through constant expressions.
+static void addUsingFunctions(llvm::User* user,
+                              std::set<llvm::Function*>& fns) {
+  if (llvm::Instruction* insn = llvm::dyn_cast<llvm::Instruction>(user)) {
+    fns.insert(insn->getFunction());
+  } else if (llvm::isa<llvm::Constant>(user)) {
+    for (llvm::User* u : user->users())
+      addUsingFunctions(u, fns);
+  }
+}
+
+//
+// With --llvm-lto-runtime, link in the definitions of the runtime
+// functions that the program calls from the runtime's bitcode, so that
+// the optimizer can inline them and specialize them for the arguments.
+//
+// The linked-in functions are made available_externally: they are there to
+// be inlined, and the runtime library the program is linked with still
+// provides the definitions.  Functions that use the runtime's file-static
+// variables are left out, since a copy of those would be separate state.
+//
+static void linkRuntimeBitcode() {
+  GenInfo*      info   = gGenInfo;
+  llvm::Module* module = info->module;
+
+  std::string path(CHPL_RUNTIME_LIB);
+  path += "/";
+  path += CHPL_RUNTIME_SUBDIR;
+  path += "/libchpl.bc";
+
+  llvm::SMDiagnostic err;
+  std::unique_ptr<llvm::Module> runtime =
+    llvm::parseIRFile(path, err, module->getContext());
+
+  if (runtime == nullptr) {
+    USR_WARN("could not read the runtime bitcode '%s', "
+             "continuing without --llvm-lto-runtime", path.c_str());
+    return;
+  }
+
+  runtime->setDataLayout(module->getDataLayout());
+  runtime->setTargetTriple(module->getTargetTriple());
+
+  std::set<std::string> definedBefore;
+  for (llvm::GlobalValue& gv : module->global_values()) {
+    if (gv.isDeclaration() == false)
+      definedBefore.insert(gv.getName().str());
+  }
+
+  if (llvm::Linker::linkModules(*module, std::move(runtime),
+                                llvm::Linker::LinkOnlyNeeded)) {
+    USR_FATAL("could not link the runtime bitcode '%s'", path.c_str());
+  }
+
+  std::vector<llvm::Function*>       importedFns;
+  std::vector<llvm::GlobalVariable*> importedVars;
+
+  for (llvm::Function& fn : module->functions()) {
+    if (fn.isDeclaration() == false &&
+        definedBefore.count(fn.getName().str()) == 0)
+      importedFns.push_back(&fn);
+  }
+
+  for (llvm::GlobalVariable& gv : module->globals()) {
+    if (gv.isDeclaration() == false &&
+        definedBefore.count(gv.getName().str()) == 0)
+      importedVars.push_back(&gv);
+  }
+
+  // Find the functions that use file-static state, directly or through
+  // the static functions they call.
+  std::set<llvm::Function*> usesState;
+
+  for (llvm::GlobalVariable* gv : importedVars) {
+    if (gv->hasLocalLinkage() && gv->isConstant() == false) {
+      for (llvm::User* user : gv->users())
+        addUsingFunctions(user, usesState);
+    }
+  }
+
+  bool changed = true;
+
+  while (changed) {
+    changed = false;
+
+    for (llvm::Function* fn : importedFns) {
+      if (fn->hasLocalLinkage() && usesState.count(fn) != 0) {
+        for (llvm::User* user : fn->users()) {
+          std::set<llvm::Function*> users;
+
+          addUsingFunctions(user, users);
+
+          for (llvm::Function* userFn : users) {
+            if (usesState.insert(userFn).second)
+              changed = true;
+          }
+        }
+      }
+    }
+  }
+
+  // Keep the rest for inlining only.
+  for (llvm::Function* fn : importedFns) {
+    if (fn->hasLocalLinkage())
+      continue;
+
+    if (usesState.count(fn) != 0) {
+      fn->deleteBody();
+    } else {
+      fn->setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+      fn->setComdat(nullptr);
+    }
+  }
+
+  for (llvm::GlobalVariable* gv : importedVars) {
+    if (gv->hasLocalLinkage())
+      continue;
+
+    if (gv->isConstant()) {
+      gv->setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+    } else {
+      gv->setInitializer(nullptr);
+      gv->setLinkage(llvm::GlobalValue::ExternalLinkage);
+    }
+    gv->setComdat(nullptr);
+  }
+
+  // Remove the static functions and variables that are no longer used.
+  changed = true;
+
+  while (changed) {
+    changed = false;
+
+    for (llvm::Function*& fn : importedFns) {
+      if (fn != nullptr && fn->hasLocalLinkage() && fn->use_empty()) {
+        fn->eraseFromParent();
+        fn      = nullptr;
+        changed = true;
+      }
+    }
+
+    for (llvm::GlobalVariable*& gv : importedVars) {
+      if (gv != nullptr && gv->hasLocalLinkage() && gv->use_empty()) {
+        gv->eraseFromParent();
+        gv      = nullptr;
+        changed = true;
+      }
+    }
+  }
+
+  if (developer) {
+    int inlinable = 0;
+
+    for (llvm::Function* fn : importedFns) {
+      if (fn != nullptr && fn->hasAvailableExternallyLinkage())
+        inlinable++;
+    }
+
+    printf("linked %d runtime functions from %s\n", inlinable, path.c_str());
+  }
+}
+
 void finishCodegenLLVM() {
   GenInfo* info = gGenInfo;
 
@@ -1784,6 +1966,9 @@ void finishCodegenLLVM() {
 
   if(debug_info)debug_info->finalize();
 
+  if (fLtoRuntime)
+    linkRuntimeBitcode();
+
   // Verify the LLVM module.
   if( developer ) {
     bool problems;
@@ -1811,6 +1996,8 @@ void configurePMBuilder(PassManagerBuilder &PMBuilder, bool forFunctionPasses, i
   ClangInfo* clangInfo = gGenInfo->clangInfo;
   INT_ASSERT(clangInfo);
   clang::CodeGenOptions &opts = clangInfo->codegenOptions;
+  // the main pipeline, as opposed to the extra one after GlobalToWide
+  bool mainModulePasses = !forFunctionPasses && optLevel < 0;
 
   if (optLevel < 0)
     optLevel = opts.OptimizationLevel;
@@ -1843,6 +2030,19 @@ void configurePMBuilder(PassManagerBuilder &PMBuilder, bool forFunctionPasses, i
   PMBuilder.PrepareForLTO = opts.PrepareForLTO;
   PMBuilder.RerollLoops = opts.RerollLoops;
 
+  // Profile guided optimization. Only the main module pipeline adds
+  // the instrumentation and profile passes so they run once.
+  if (mainModulePasses) {
+    if (fProfileGenerate) {
+#if HAVE_LLVM_VER >= 90
+      PMBuilder.EnablePGOInstrGen = true;
+#endif
+      PMBuilder.PGOInstrGen = PROFILE_GENERATE_FILE;
+    }
+    if (profileUseFile[0] != '\0')
+      PMBuilder.PGOInstrUse = profileUseFile;
+  }
+
 
   // Enable Region Vectorizer aka Outer Loop Vectorizer
 #ifdef HAVE_LLVM_RV
@@ -1945,6 +2145,131 @@ bool setAlreadyConvertedExtern(ModuleSymbol* module, const char* name)
   return module->extern_info->gen_info->lvt->markAddedToChapelAST(name);
 }
 
+//
+// With --clang-pch-cache <dir>, the runtime headers that every clang run
+// starts with are parsed once into a precompiled header and reused by
+// later compiles with the same clang and the same C flags.  Next to each
+// <key>.pch is the <key>.h it was built from and a <key>.d dependency
+// list; a PCH that is older than anything it depends on is rebuilt.
+//
+
+static void pchHashString(uint64_t& h, const std::string& str) {
+  // 64-bit FNV-1a, including the terminator
+  for (size_t i = 0; i <= str.size(); i++) {
+    h ^= (unsigned char) str.c_str()[i];
+    h *= 1099511628211ULL;
+  }
+}
+
+static std::string shellQuote(const std::string& arg) {
+  std::string retval = "'";
+
+  for (size_t i = 0; i < arg.size(); i++) {
+    if (arg[i] == '\'')
+      retval += "'\\''";
+    else
+      retval += arg[i];
+  }
+
+  return retval + "'";
+}
+
+static bool isPchCurrent(const std::string& pch, const std::string& deps) {
+  struct stat pchStat;
+  struct stat depStat;
+
+  if (stat(pch.c_str(), &pchStat) != 0)
+    return false;
+
+  FILE* fp = fopen(deps.c_str(), "r");
+  if (fp == NULL)
+    return false;
+
+  // make-style: "<target>: <dep> <dep> ...", with "\" continuations
+  std::string contents;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    contents.append(buf, n);
+  fclose(fp);
+
+  size_t colon = contents.find(": ");
+  if (colon == std::string::npos)
+    return false;
+
+  std::istringstream iss(contents.substr(colon + 2));
+  std::string dep;
+  while (iss >> dep) {
+    if (dep == "\\")
+      continue;
+
+    if (stat(dep.c_str(), &depStat) != 0 ||
+        depStat.st_mtime > pchStat.st_mtime)
+      return false;
+  }
+
+  return true;
+}
+
+// Returns the path of a PCH for the given headers, building it if need be,
+// or an empty string if it could not be built.
+static std::string getRuntimePch(const std::string& clangCC,
+                                 const std::vector<std::string>& ccArgs,
+                                 const std::vector<const char*>& headers) {
+  uint64_t h = 14695981039346656037ULL;
+  char     key[32];
+
+  pchHashString(h, CLANG_VERSION_STRING);
+  pchHashString(h, clangCC);
+  for (size_t i = 0; i < ccArgs.size(); i++)
+    pchHashString(h, ccArgs[i]);
+  for (size_t i = 0; i < headers.size(); i++)
+    pchHashString(h, headers[i]);
+
+  snprintf(key, sizeof(key), "%016llx", (unsigned long long) h);
+
+  std::string base = std::string(clangPchCacheDir) + "/runtime-" + key;
+  std::string hdr  = base + ".h";
+  std::string pch  = base + ".pch";
+  std::string deps = base + ".d";
+
+  if (isPchCurrent(pch, deps))
+    return pch;
+
+  ensureDirExists(clangPchCacheDir, "creating the clang PCH cache");
+
+  // The PCH records the header it was built from, so only write it once.
+  if (access(hdr.c_str(), R_OK) != 0) {
+    std::string tmpHdr = hdr + ".tmp" + istr(getpid());
+    FILE* fp = fopen(tmpHdr.c_str(), "w");
+    if (fp == NULL)
+      return "";
+    for (size_t i = 0; i < headers.size(); i++)
+      fprintf(fp, "#include \"%s\"\n", headers[i]);
+    if (fclose(fp) != 0 || rename(tmpHdr.c_str(), hdr.c_str()) != 0) {
+      unlink(tmpHdr.c_str());
+      return "";
+    }
+  }
+
+  std::string tmpPch = pch + ".tmp" + istr(getpid());
+  std::string command = shellQuote(clangCC);
+  for (size_t i = 0; i < ccArgs.size(); i++)
+    command += " " + shellQuote(ccArgs[i]);
+  command += " -x c-header " + shellQuote(hdr);
+  command += " -o " + shellQuote(tmpPch);
+  command += " -MD -MF " + shellQuote(deps);
+
+  if (mysystem(command.c_str(), "building the runtime precompiled header",
+               /* ignoreStatus */ true) != 0 ||
+      rename(tmpPch.c_str(), pch.c_str()) != 0) {
+    unlink(tmpPch.c_str());
+    return "";
+  }
+
+  return pch;
+}
+
 
 void runClang(const char* just_parse_filename) {
   static bool is_installed_fatal_error_handler = false;
@@ -2113,28 +2438,58 @@ void runClang(const char* just_parse_filename) {
 
   clangCCArgs.push_back("-DCHPL_GEN_CODE");
 
-  // Always include sys_basic because it might change the
-  // behaviour of macros!
-  clangOtherArgs.push_back("-include");
-  clangOtherArgs.push_back("sys_basic.h");
+  // The runtime headers' wide_ptr_t has to match what we generate.
+  if (fPackedWidePointers)
+    clangCCArgs.push_back("-DCHPL_WIDE_POINTER_PACKED");
+
+  // Header files from the command line
+  std::vector<const char*> cmdLineHeaders;
+  if (!just_parse_filename) {
+    int filenum = 0;
+    while (const char* inputFilename = nthFilename(filenum++)) {
+      if (isCHeader(inputFilename))
+        cmdLineHeaders.push_back(inputFilename);
+    }
+  }
+
+  // The runtime headers can come from a cached PCH when nothing from the
+  // command line has to be included ahead of them.  stdchpl.h then comes
+  // before the extern blocks, as it does for the C back end.
+  std::string runtimePch;
+  if (clangPchCacheDir[0] != '\0' && cmdLineHeaders.empty()) {
+    std::vector<const char*> headers;
+    headers.push_back("sys_basic.h");
+    if (!just_parse_filename)
+      headers.push_back("llvm/chapel_libc_wrapper.h");
+    headers.push_back("stdchpl.h");
+
+    runtimePch = getRuntimePch(clangCC, clangCCArgs, headers);
+  }
+
+  if (!runtimePch.empty()) {
+    clangOtherArgs.push_back("-include-pch");
+    clangOtherArgs.push_back(runtimePch);
+  } else {
+    // Always include sys_basic because it might change the
+    // behaviour of macros!
+    clangOtherArgs.push_back("-include");
+    clangOtherArgs.push_back("sys_basic.h");
+  }
 
   if (!just_parse_filename) {
     // Running clang to compile all runtime and extern blocks
 
     // Include header files from the command line.
-    {
-      int filenum = 0;
-      while (const char* inputFilename = nthFilename(filenum++)) {
-        if (isCHeader(inputFilename)) {
-          clangOtherArgs.push_back("-include");
-          clangOtherArgs.push_back(inputFilename);
-        }
-      }
+    for_vector(const char, inputFilename, cmdLineHeaders) {
+      clangOtherArgs.push_back("-include");
+      clangOtherArgs.push_back(inputFilename);
     }
 
     // Include header containing libc wrappers
-    clangOtherArgs.push_back("-include");
-    clangOtherArgs.push_back("llvm/chapel_libc_wrapper.h");
+    if (runtimePch.empty()) {
+      clangOtherArgs.push_back("-include");
+      clangOtherArgs.push_back("llvm/chapel_libc_wrapper.h");
+    }
 
     // Include extern C blocks
     if( fAllowExternC && gAllExternCode.filename ) {
@@ -3060,6 +3415,104 @@ void addDumpIrPass(const PassManagerBuilder &Builder,
   PM.add(createDumpIrPass(llvmPrintIrStageNum));
 }
 
+#if HAVE_LLVM_VER >= 60
+// Finds the Chapel location that CForLoop::codegen recorded in the loop
+// metadata of the loop with this header block.
+static bool getRemarkLoopLocation(const llvm::Value* region,
+                                  const char*& filename, int& lineno) {
+  const llvm::BasicBlock* header = llvm::dyn_cast_or_null<llvm::BasicBlock>(region);
+
+  if (header == NULL)
+    return false;
+
+  for (const llvm::BasicBlock* pred : llvm::predecessors(header)) {
+    const llvm::Instruction* term   = pred->getTerminator();
+    llvm::MDNode*            loopID = NULL;
+
+    if (term != NULL)
+      loopID = term->getMetadata("llvm.loop");
+
+    if (loopID == NULL)
+      continue;
+
+    for (unsigned i = 1; i < loopID->getNumOperands(); i++) {
+      llvm::MDNode* md = llvm::dyn_cast<llvm::MDNode>(loopID->getOperand(i));
+
+      if (md == NULL || md->getNumOperands() != 3)
+        continue;
+
+      llvm::MDString* name = llvm::dyn_cast<llvm::MDString>(md->getOperand(0));
+      llvm::MDString* file = llvm::dyn_cast<llvm::MDString>(md->getOperand(1));
+      llvm::ConstantInt* line =
+        llvm::mdconst::dyn_extract<llvm::ConstantInt>(md->getOperand(2));
+
+      if (name != NULL && name->getString() == CHPL_LOOP_LOCATION_MD &&
+          file != NULL && line != NULL) {
+        filename = astr(file->getString().str().c_str());
+        lineno   = (int) line->getSExtValue();
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+// Prints the loop vectorizer's remarks for --report-vectorizer-remarks
+// with the location of the Chapel loop, and passes everything else on
+// to the handler it replaced.
+struct VectorizerRemarkHandler : public llvm::DiagnosticHandler {
+  std::unique_ptr<llvm::DiagnosticHandler> prev;
+  std::set<std::string>                    reported;
+
+  static bool isVectorizer(llvm::StringRef passName) {
+    return passName == "loop-vectorize";
+  }
+
+  bool isAnalysisRemarkEnabled(llvm::StringRef passName) const override {
+    return isVectorizer(passName);
+  }
+  bool isMissedOptRemarkEnabled(llvm::StringRef passName) const override {
+    return isVectorizer(passName);
+  }
+  bool isPassedOptRemarkEnabled(llvm::StringRef passName) const override {
+    return isVectorizer(passName);
+  }
+  bool isAnyRemarkEnabled() const override {
+    return true;
+  }
+
+  bool handleDiagnostics(const llvm::DiagnosticInfo& DI) override {
+    const llvm::DiagnosticInfoIROptimization* remark =
+      llvm::dyn_cast<llvm::DiagnosticInfoIROptimization>(&DI);
+
+    if (remark != NULL && isVectorizer(remark->getPassName())) {
+      const char* filename = NULL;
+      int         lineno   = 0;
+
+      // Remarks about loops without a recorded location are about
+      // loops that weren't hinted, or that aren't in user code.
+      if (getRemarkLoopLocation(remark->getCodeRegion(), filename, lineno)) {
+        std::string msg = remark->getMsg();
+        std::string key = std::string(filename) + ":" + istr(lineno) +
+                          ":" + msg;
+
+        // The follower and fast follower loops share a location
+        if (reported.insert(key).second)
+          USR_PRINT(astlocT(lineno, filename), "%s", msg.c_str());
+      }
+
+      return true;
+    }
+
+    if (prev)
+      return prev->handleDiagnostics(DI);
+
+    return false;
+  }
+};
+#endif
+
 
 // If we're using the LLVM wide optimizations, we have to add
 // some functions to call put/get into the Chapel runtime layers
@@ -3166,18 +3619,23 @@ void adjustLayoutForGlobalToWide()
 
   char buf[200]; //needs to store up to 8 32-bit numbers in decimal
 
+  unsigned ptrSize = fPackedWidePointers ? PACKED_GLOBAL_PTR_SIZE
+                                         : GLOBAL_PTR_SIZE;
+
   // Add global pointer info to layout.
   snprintf(buf, sizeof(buf), "-p%u:%u:%u:%u-p%u:%u:%u:%u"
       /*"-ni:%u:%u"*/ /* non-integral pointers */,
       GLOBAL_PTR_SPACE,
-      GLOBAL_PTR_SIZE, GLOBAL_PTR_ABI_ALIGN, GLOBAL_PTR_PREF_ALIGN,
-      WIDE_PTR_SPACE, GLOBAL_PTR_SIZE, GLOBAL_PTR_ABI_ALIGN,
+      ptrSize, GLOBAL_PTR_ABI_ALIGN, GLOBAL_PTR_PREF_ALIGN,
+      WIDE_PTR_SPACE, ptrSize, GLOBAL_PTR_ABI_ALIGN,
       GLOBAL_PTR_PREF_ALIGN /*, GLOBAL_PTR_SPACE, WIDE_PTR_SPACE*/);
   layout += buf;
   // Save the global address space we are using in info.
   info->globalToWideInfo.globalSpace = GLOBAL_PTR_SPACE;
   info->globalToWideInfo.wideSpace = WIDE_PTR_SPACE;
-  info->globalToWideInfo.globalPtrBits = GLOBAL_PTR_SIZE;
+  info->globalToWideInfo.globalPtrBits = ptrSize;
+  if (fPackedWidePointers)
+    info->globalToWideInfo.packedAddrBits = PACKED_PTR_ADDR_BITS;
 
   // Always set the module layout. This works around an apparent bug in
   // clang or LLVM (trivial/deitz/test_array_low.chpl would print out the
@@ -3202,7 +3660,8 @@ void checkAdjustedDataLayout() {
   const llvm::DataLayout& dl = info->module->getDataLayout();
   llvm::Type* testTy = llvm::Type::getInt8PtrTy(info->module->getContext(),
                                                 GLOBAL_PTR_SPACE);
-  INT_ASSERT(dl.getTypeSizeInBits(testTy) == GLOBAL_PTR_SIZE);
+  INT_ASSERT(dl.getTypeSizeInBits(testTy) ==
+             (fPackedWidePointers ? PACKED_GLOBAL_PTR_SIZE : GLOBAL_PTR_SIZE));
 }
 
 static void makeLLVMStaticLibrary(std::string moduleFilename,
@@ -3231,6 +3690,63 @@ static std::string getLibraryOutputPath();
 static void moveGeneratedLibraryFile(const char* tmpbinname);
 static void moveResultFromTmp(const char* resultName, const char* tmpbinname);
 
+//
+// Splits the optimized module into nPartitions parts and generates code
+// for them on that many threads.  The first part goes to outputOfile and
+// the others to files that are added to partitionFilenames.
+//
+template <typename FileTypeT>
+static void emitPartitionedObjects(int nPartitions,
+                                   llvm::raw_fd_ostream& outputOfile,
+                                   FileTypeT FileType,
+                                   std::vector<std::string>& partitionFilenames) {
+  GenInfo* info = gGenInfo;
+  const llvm::TargetMachine* tm = info->targetMachine;
+
+  std::vector<std::unique_ptr<llvm::raw_fd_ostream>> partitionFiles;
+  std::vector<llvm::raw_pwrite_stream*> outputs;
+
+  outputs.push_back(&outputOfile);
+
+  for (int i = 1; i < nPartitions; i++) {
+    std::string filename =
+      genIntermediateFilename(astr("chpl__module-", istr(i), ".o"));
+    std::error_code error;
+
+    partitionFiles.emplace_back(
+      new llvm::raw_fd_ostream(filename, error, llvm::sys::fs::F_None));
+    if (error || partitionFiles.back()->has_error())
+      USR_FATAL("Could not open output file %s", filename.c_str());
+
+    outputs.push_back(partitionFiles.back().get());
+    partitionFilenames.push_back(filename);
+  }
+
+  // Each code generation thread needs its own TargetMachine.
+  auto tmFactory = [tm]() {
+    return std::unique_ptr<llvm::TargetMachine>(
+      tm->getTarget().createTargetMachine(tm->getTargetTriple().str(),
+                                          tm->getTargetCPU(),
+                                          tm->getTargetFeatureString(),
+                                          tm->Options,
+                                          tm->getRelocationModel(),
+                                          tm->getCodeModel(),
+                                          tm->getOptLevel()));
+  };
+
+  // The module still belongs to clang, so split a copy of it.
+  std::unique_ptr<llvm::Module> copy = llvm::CloneModule(*info->module);
+
+#if HAVE_LLVM_VER >= 120
+  llvm::splitCodeGen(*copy, outputs, {}, tmFactory, FileType);
+#else
+  llvm::splitCodeGen(std::move(copy), outputs, {}, tmFactory, FileType);
+#endif
+
+  for (auto& file : partitionFiles)
+    file->close();
+}
+
 void makeBinaryLLVM(void) {
 
   GenInfo* info = gGenInfo;
@@ -3353,6 +3869,18 @@ void makeBinaryLLVM(void) {
 
     PMBuilder.populateModulePassManager(mpm);
 
+#if HAVE_LLVM_VER >= 60
+    llvm::LLVMContext& ctx = info->module->getContext();
+    VectorizerRemarkHandler* remarkHandler = NULL;
+
+    if (fReportVectorizerRemarks) {
+      remarkHandler       = new VectorizerRemarkHandler();
+      remarkHandler->prev = ctx.getDiagnosticHandler();
+      ctx.setDiagnosticHandler(
+        std::unique_ptr<llvm::DiagnosticHandler>(remarkHandler));
+    }
+#endif
+
     // Run the optimizations now!
     mpm.run(*info->module);
 
@@ -3409,6 +3937,16 @@ void makeBinaryLLVM(void) {
         output2.os().flush();
       }
     }
+
+#if HAVE_LLVM_VER >= 60
+    // Put back the handler that was replaced
+    if (remarkHandler != NULL) {
+      std::unique_ptr<llvm::DiagnosticHandler> prev =
+        std::move(remarkHandler->prev);
+
+      ctx.setDiagnosticHandler(std::move(prev));
+    }
+#endif
   }
 
   // Handle --llvm-print-ir-stage=full
@@ -3434,12 +3972,8 @@ void makeBinaryLLVM(void) {
 
   // Emit the .o file for linking with clang
   // Setup and run LLVM passes to emit a .o file to outputOfile
+  std::vector<std::string> partitionFilenames;
   {
-    llvm::legacy::PassManager emitPM;
-
-    emitPM.add(createTargetTransformInfoWrapperPass(
-               info->targetMachine->getTargetIRAnalysis()));
-
 #if HAVE_LLVM_VER >= 100
     llvm::CodeGenFileType FileType = llvm::CGFT_ObjectFile;
 #else
@@ -3447,20 +3981,35 @@ void makeBinaryLLVM(void) {
       llvm::TargetMachine::CGFT_ObjectFile;
 #endif
 
-    bool disableVerify = ! developer;
+    int nPartitions = llvmCodegenThreads;
+    if (nPartitions <= 0)
+      nPartitions = std::max(1u, std::thread::hardware_concurrency());
+
+    if (nPartitions > 1) {
+      emitPartitionedObjects(nPartitions, outputOfile, FileType,
+                             partitionFilenames);
+    } else {
+      llvm::legacy::PassManager emitPM;
+
+      emitPM.add(createTargetTransformInfoWrapperPass(
+                 info->targetMachine->getTargetIRAnalysis()));
+
+      bool disableVerify = ! developer;
 #if HAVE_LLVM_VER > 60
-    info->targetMachine->addPassesToEmitFile(emitPM, outputOfile,
-                                             nullptr,
-                                             FileType,
-                                             disableVerify);
+      info->targetMachine->addPassesToEmitFile(emitPM, outputOfile,
+                                               nullptr,
+                                               FileType,
+                                               disableVerify);
 #else
-    info->targetMachine->addPassesToEmitFile(emitPM, outputOfile,
-                                             FileType,
-                                             disableVerify);
+      info->targetMachine->addPassesToEmitFile(emitPM, outputOfile,
+                                               FileType,
+                                               disableVerify);
 #endif
 
-    // Run the passes to emit the .o file now!
-    emitPM.run(*info->module);
+      // Run the passes to emit the .o file now!
+      emitPM.run(*info->module);
+    }
+
     outputOfile.close();
   }
 
@@ -3561,7 +4110,7 @@ void makeBinaryLLVM(void) {
     useLinkCXX = ldOverride[0];
 
 
-  std::vector<std::string> dotOFiles;
+  std::vector<std::string> dotOFiles = partitionFilenames;
 
   // Gather C flags for compiling C files.
   std::string cargs;
@@ -41,6 +41,21 @@
 // a few elements - MemCpyOptimizer might decide it's better
 // to load/store to inline the memcpy for example, or the
 // code generator might have started with loads and stores.
+//
+// Loads are also merged across a chain of blocks that always run
+// one after another, such as the blocks of a field-by-field record
+// copy split up by bounds or nil checks that halt. The merged GET
+// goes where the first load was.
+//
+// Loads from other global pointers can appear between the loads
+// being merged and don't stop the merge. Anything that may write
+// memory does, which includes the memory consistency model fences
+// (they are calls into the runtime), so merged loads never move
+// across a fence.
+//
+// Hoisting and eliminating redundant global loads is left to LICM
+// and GVN: this pass and GlobalToWide run at EP_OptimizerLast, so
+// those see the address space loads as ordinary loads.
 
 // This code was based upon the LLVM optimization MemCpyOptimizer.cpp
 
@@ -94,6 +109,9 @@ static const char* debugThisFn = "";
 // used.
 #define GET_EXTRA 64
 
+// How many blocks of a straight-line chain to look for loads in.
+#define MAX_BLOCKS 16
+
 static inline
 bool isMergeableGlobalLoadOrStore(Instruction* I,
                                   unsigned globalSpace,
@@ -199,6 +217,35 @@ Instruction* postponeDependentInstructions(
   return LastMemopUse;
 }
 
+// Loads are merged across a chain of blocks that always run one after
+// another. Returns the block that always follows BB, or NULL. A branch
+// to a block that can only halt (like a failed bounds or nil check)
+// doesn't end the chain, since if it is taken nothing else runs.
+static
+BasicBlock* getStraightLineSuccessor(BasicBlock* BB, BasicBlock* StartBB)
+{
+  BranchInst* br = dyn_cast<BranchInst>(BB->getTerminator());
+  if (br == NULL)
+    return NULL;
+
+  BasicBlock* succ = NULL;
+  if (br->isUnconditional()) {
+    succ = br->getSuccessor(0);
+  } else {
+    BasicBlock* a = br->getSuccessor(0);
+    BasicBlock* b = br->getSuccessor(1);
+    if (isa<UnreachableInst>(a->getTerminator()))
+      succ = b;
+    else if (isa<UnreachableInst>(b->getTerminator()))
+      succ = a;
+  }
+
+  if (succ == NULL || succ == StartBB || succ->getSinglePredecessor() != BB)
+    return NULL;
+
+  return succ;
+}
+
 // The next several fns are stolen almost totally unmodified from MemCpyOptimizer.
 // modified code areas say CUSTOM.
 
@@ -496,8 +543,12 @@ Instruction *AggregateGlobalOpsOpt::tryAggregating(Instruction *StartInst, Value
   bool isLoad = isa<LoadInst>(StartInst);
   bool isStore = isa<StoreInst>(StartInst);
   Instruction *lastAddedInsn = NULL;
+  BasicBlock* StartBB = StartInst->getParent();
+  Value* ScanStartPtr = StartPtr;
+  int nBlocks = 1;
 
-  DenseMap<Instruction*, int> bbPos; // pos in basic block
+  DenseMap<Instruction*, int> bbPos; // pos in the scanned blocks
+  DenseMap<Instruction*, int64_t> scanOffset; // offset from ScanStartPtr
 
   // Okay, so we now have a single global load/store. Scan to find
   // all subsequent stores of the same value to offset from the same pointer.
@@ -507,10 +558,28 @@ Instruction *AggregateGlobalOpsOpt::tryAggregating(Instruction *StartInst, Value
 
   // Put the first store in since we want to preserve the order.
   Ranges.addInst(0, StartInst);
+  scanOffset[StartInst] = 0;
 
   BasicBlock::iterator BI(StartInst);
   int pos = 0;
-  for (++BI; !BI->isTerminator(); ++BI) {
+  for (++BI; ; ++BI) {
+
+    // Loads keep going into the next block of a straight-line chain.
+    // Stores don't, since they are aggregated at the last store.
+    bool atEnd = false;
+    while (BI->isTerminator()) {
+      BasicBlock* Next = NULL;
+      if (isLoad && nBlocks < MAX_BLOCKS)
+        Next = getStraightLineSuccessor(BI->getParent(), StartBB);
+      if (Next == NULL) {
+        atEnd = true;
+        break;
+      }
+      nBlocks++;
+      BI = Next->begin();
+    }
+    if (atEnd)
+      break;
 
     pos++;
     Instruction& insnRef = *BI;
@@ -553,20 +622,24 @@ Instruction *AggregateGlobalOpsOpt::tryAggregating(Instruction *StartInst, Value
       if (!NextLoad->isSimple()) break;
 
       // Check to see if this load is to a constant offset from the start ptr.
+      // Loads from other objects can't conflict with these loads, so skip
+      // over them; that way loads of the fields of several remote objects
+      // that are interleaved still combine into one GET per object.
 #if HAVE_LLVM_VER >= 100
       Optional<int64_t> optOffset =
         isPointerOffset(StartPtr, NextLoad->getPointerOperand(), *DL);
       if (!optOffset)
-        break;
+        continue;
       int64_t Offset = *optOffset;
 #else
       int64_t Offset;
       if (!IsPointerOffset(StartPtr, NextLoad->getPointerOperand(), Offset, *DL))
-        break;
+        continue;
 #endif
 
       Ranges.addLoad(Offset, NextLoad);
       bbPos[NextLoad] = pos;
+      scanOffset[NextLoad] = Offset;
     }
   }
 
@@ -649,13 +722,22 @@ Instruction *AggregateGlobalOpsOpt::tryAggregating(Instruction *StartInst, Value
     assert(toAggregate.count(First));
     assert(toAggregate.count(Last));
 
-    // Move any instructions between First and Last that depend on
-    // the loaded values to just after Last.
-    postponeDependentInstructions(First, Last, toAggregate, DebugThis);
-
-    // Compute the insert point for the new instructions
-    // - just before the last load/store (which will be removed)
-    Instruction* insertBefore = Last;
+    // Compute the insert point for the new instructions.
+    // Stores are done just before the last store (which will be
+    // removed), once all of the stored values are available. Any
+    // instructions between First and Last that depend on a store
+    // can't stay where they are, so move them to just after Last.
+    // Loads are done just before the first load: nothing between
+    // the loads writes memory, the pointer the scan started from
+    // is available there, and each old load can be replaced in
+    // place, even when the loads are in different blocks.
+    Instruction* insertBefore = NULL;
+    if( isLoad ) {
+      insertBefore = First;
+    } else {
+      postponeDependentInstructions(First, Last, toAggregate, DebugThis);
+      insertBefore = Last;
+    }
     IRBuilder<> irBuilder(insertBefore);
 
     // Get the starting pointer of the block.
@@ -725,7 +807,17 @@ Instruction *AggregateGlobalOpsOpt::tryAggregating(Instruction *StartInst, Value
     }
 
     // cast the pointer that was load/stored to i8 if necessary.
-    Value *globalPtr = irBuilder.CreatePointerCast(StartPtr, globalInt8PtrTy);
+    Value *globalPtr = NULL;
+    if( isLoad ) {
+      // Range.StartPtr might not be computed yet at First
+      Value* scanPtr = irBuilder.CreatePointerCast(ScanStartPtr,
+                                                   globalInt8PtrTy);
+      Constant* startC = ConstantInt::get(sizeTy, Range.Start, true);
+      Value* starts[] = {startC};
+      globalPtr = irBuilder.CreateGEP(int8Ty, scanPtr, starts);
+    } else {
+      globalPtr = irBuilder.CreatePointerCast(StartPtr, globalInt8PtrTy);
+    }
 
     // Get a Constant* for the length.
     Constant* len = ConstantInt::get(sizeTy, Range.End-Range.Start, false);
@@ -781,7 +873,12 @@ Instruction *AggregateGlobalOpsOpt::tryAggregating(Instruction *StartInst, Value
     if (!Range.TheStores.empty())
       aMemCpy->setDebugLoc(Range.TheStores[0]->getDebugLoc());
 
-    lastAddedInsn = aMemCpy;
+    // The caller continues from the instruction returned, which has
+    // to be in StartBB if anything there was replaced.
+    if( isStore || lastAddedInsn == NULL ||
+        aMemCpy->getParent() == StartBB ) {
+      lastAddedInsn = aMemCpy;
+    }
 
     // If loading, load from the memcpy'd region
     if( isLoad ) {
@@ -789,20 +886,12 @@ Instruction *AggregateGlobalOpsOpt::tryAggregating(Instruction *StartInst, Value
            SI = Range.TheStores.begin(),
            SE = Range.TheStores.end(); SI != SE; ++SI) {
         LoadInst* oldLoad = cast<LoadInst>(*SI);
-        int64_t offset = 0;
-#if HAVE_LLVM_VER >= 100
-        Optional<int64_t> optOffset =
-          isPointerOffset(StartPtr, oldLoad->getPointerOperand(), *DL);
-        assert(!!optOffset);
-        offset = *optOffset;
+        int64_t offset = scanOffset[oldLoad] - Range.Start;
         assert(offset >= 0);
-#else
-        bool ok = IsPointerOffset(StartPtr, oldLoad->getPointerOperand(),
-                                  offset, *DL);
-        assert(ok && offset >= 0); // we used this before, didn't we?
-#endif
         assert(!(oldLoad->isVolatile() || oldLoad->isAtomic()));
 
+        irBuilder.SetInsertPoint(oldLoad);
+
         Constant* offsetC = ConstantInt::get(sizeTy, offset, true);
         Value* offsets[] = {offsetC};
         Value* i8Src = irBuilder.CreateInBoundsGEP(int8Ty,
@@ -820,7 +909,6 @@ Instruction *AggregateGlobalOpsOpt::tryAggregating(Instruction *StartInst, Value
 #endif
         oldLoad->replaceAllUsesWith(newLoad);
         newLoad->takeName(oldLoad);
-        lastAddedInsn = newLoad;
       }
     }
 
@@ -876,7 +964,9 @@ bool AggregateGlobalOpsOpt::runOnFunction(Function &F) {
         if( lastAdded ) {
           ChangedBB = true;
           ChangedFn = true;
-          BI = lastAdded->getIterator();
+          // Merging loads from later blocks doesn't touch this one
+          if( lastAdded->getParent() == &*BB )
+            BI = lastAdded->getIterator();
         }
       }
     }
@@ -76,6 +76,8 @@ namespace {
   //        ...  //    addr
 
   // Besides these GEPs, createWidePointerToType relies on the representation.
+  // Packed wide pointers (info->packedAddrBits != 0) only use wideNodeGEP[1],
+  // the node's index within the locale id.
   unsigned wideLocaleGEP[] = {0};
   unsigned wideNodeGEP[] = {0,0};
   unsigned wideAddrGEP[] = {1};
@@ -185,7 +187,27 @@ namespace {
     return ConstantInt::get(ty, val);
   }
 
+  // Packed wide pointers are 64-bit local address space pointers
+  // with the node in the bits above the address.
+  Value* createPackedBits(GlobalToWideInfo* info, Value* widePtr,
+                          Instruction* insertBefore) {
+    Type* i64Ty = Type::getInt64Ty(insertBefore->getContext());
+    return new PtrToIntInst(widePtr, i64Ty, "", insertBefore);
+  }
+
   Instruction* createRaddr(GlobalToWideInfo* info, Value* widePtr, Instruction* insertBefore) {
+    if( info->packedAddrBits ) {
+      // Mask off the node to get the address
+      assert(widePtr->getType()->isPointerTy());
+      Value* bits = createPackedBits(info, widePtr, insertBefore);
+      uint64_t mask = (UINT64_C(1) << info->packedAddrBits) - 1;
+      Value* addr = BinaryOperator::Create(Instruction::And, bits,
+                                           ConstantInt::get(bits->getType(),
+                                                            mask),
+                                           "", insertBefore);
+      return new IntToPtrInst(addr, widePtr->getType(), "", insertBefore);
+    }
+
     // Assuming widePtr is a struct wide-pointer, extract the address
     assert(widePtr->getType()->isStructTy());
 
@@ -193,20 +215,39 @@ namespace {
                                     wideAddrGEP,
                                     "", insertBefore);
   }
-  Instruction* createRlocale(GlobalToWideInfo* info, Value* widePtr, Instruction* insertBefore) {
+  Instruction* createRnode(GlobalToWideInfo* info, Value* widePtr, Instruction* insertBefore) {
+    if( info->packedAddrBits ) {
+      // Shift the address away to get the node
+      assert(widePtr->getType()->isPointerTy());
+      Value* bits = createPackedBits(info, widePtr, insertBefore);
+      Value* node = BinaryOperator::Create(Instruction::LShr, bits,
+                                           ConstantInt::get(bits->getType(),
+                                                       info->packedAddrBits),
+                                           "", insertBefore);
+      return new TruncInst(node, info->nodeIdType, "", insertBefore);
+    }
+
     // Assuming widePtr is a struct wide-pointer, extract the address
     assert(widePtr->getType()->isStructTy());
 
     return ExtractValueInst::Create(widePtr,
-                                    wideLocaleGEP,
+                                    wideNodeGEP,
                                     "", insertBefore);
   }
-  Instruction* createRnode(GlobalToWideInfo* info, Value* widePtr, Instruction* insertBefore) {
+  Instruction* createRlocale(GlobalToWideInfo* info, Value* widePtr, Instruction* insertBefore) {
+    if( info->packedAddrBits ) {
+      // The locale id is just the node
+      Instruction* node = createRnode(info, widePtr, insertBefore);
+      Constant* undefLoc = UndefValue::get(info->localeIdType);
+      return InsertValueInst::Create(undefLoc, node, wideNodeGEP[1],
+                                     "", insertBefore);
+    }
+
     // Assuming widePtr is a struct wide-pointer, extract the address
     assert(widePtr->getType()->isStructTy());
 
     return ExtractValueInst::Create(widePtr,
-                                    wideNodeGEP,
+                                    wideLocaleGEP,
                                     "", insertBefore);
   }
   Instruction* createWideAddr(GlobalToWideInfo* info,
@@ -214,6 +255,22 @@ namespace {
                         Type* widePtrType,
                         Instruction* insertBefore) {
 
+    if( info->packedAddrBits ) {
+      // (node << packedAddrBits) | addr
+      Type* i64Ty = Type::getInt64Ty(insertBefore->getContext());
+      Value* node = ExtractValueInst::Create(localeId, wideNodeGEP[1],
+                                             "", insertBefore);
+      Value* hi = new ZExtInst(node, i64Ty, "", insertBefore);
+      hi = BinaryOperator::Create(Instruction::Shl, hi,
+                                  ConstantInt::get(i64Ty,
+                                                   info->packedAddrBits),
+                                  "", insertBefore);
+      Value* lo = new PtrToIntInst(addr, i64Ty, "", insertBefore);
+      Value* bits = BinaryOperator::Create(Instruction::Or, hi, lo,
+                                           "", insertBefore);
+      return new IntToPtrInst(bits, widePtrType, "", insertBefore);
+    }
+
     Constant* undefWidePtr = UndefValue::get(widePtrType);
 
     Instruction* locSet = InsertValueInst::Create(undefWidePtr, localeId,
@@ -227,11 +284,18 @@ namespace {
   }
 
   Value* createWideBitCast(GlobalToWideInfo* info, Value* widePtr, Type* widePtrType, Instruction* insertBefore) {
+    if( widePtr->getType() == widePtrType ) return widePtr;
+
+    if( info->packedAddrBits ) {
+      // Packed wide pointers can just be cast
+      assert(widePtrType->isPointerTy());
+      return CastInst::CreatePointerCast(widePtr, widePtrType,
+                                         "", insertBefore);
+    }
+
     // The destination type should be a wide pointer.
     assert(widePtrType->isStructTy());
 
-    if( widePtr->getType() == widePtrType ) return widePtr;
-
     Value* loc = ExtractValueInst::Create(widePtr,
                                           wideLocaleGEP,
                                           "", insertBefore);
@@ -1385,6 +1449,11 @@ namespace {
       assert(info->localeIdType != 0);
       assert(info->nodeIdType != 0);
 
+      // Packed wide pointers only have room for a node.
+      assert(!info->packedAddrBits ||
+             (info->localeIdType->isStructTy() &&
+              info->localeIdType->getStructNumElements() == 1));
+
       // Check that a pointer in the global address space has the correct size.
       {
         const llvm::DataLayout& dl = M.getDataLayout();
@@ -2192,6 +2261,12 @@ static
 Type* createWidePointerToType(Module* module, GlobalToWideInfo* i, Type* eltTy)
 {
   LLVMContext& context = module->getContext();
+
+  // Packed wide pointers are just local pointers with the node
+  // in the otherwise unused high bits.
+  if( i->packedAddrBits )
+    return PointerType::get(eltTy, 0);
+
   // Get the wide pointer struct containing {locale, address}
   Type* fields[2];
   fields[0] = i->localeIdType;
@@ -2286,6 +2361,7 @@ Type* convertTypeGlobalToWide(Module* module, GlobalToWideInfo* info, Type* t)
     if( t->getPointerAddressSpace() == info->globalSpace ||
         t->getPointerAddressSpace() == info->wideSpace ) {
       // Replace the pointer with a struct containing {locale, address}
+      // (or a packed pointer)
       return createWidePointerToType(module, info, wideEltType);
     } else {
       return PointerType::get(wideEltType, t->getPointerAddressSpace());
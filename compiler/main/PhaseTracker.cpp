@@ -27,6 +27,14 @@
 #include <cstring>
 #include <algorithm>
 
+#include <sys/resource.h>
+#include <unistd.h>
+
+typedef std::vector<std::pair<const char*, size_t> > AstBytes;
+
+static size_t currentRss();
+static size_t peakRss();
+
 // Used to collect the times as the program runs
 class Phase
 {
@@ -49,6 +57,9 @@ public:
   int                      mPassId;
   PhaseTracker::SubPhase   mSubPhase;
   unsigned long            mStartTime;  // Elapsed time from main() usecs
+  size_t                   mStartRss;   // bytes
+  size_t                   mPeakRss;    // bytes, peak up to the start
+  AstBytes                 mAstBytes;   // bytes per AST kind at the start
 
 private:
   Phase();
@@ -66,7 +77,8 @@ public:
                         unsigned long mainTime,
                         unsigned long checkTime,
                         unsigned long cleanTime,
-                        unsigned long totalTime);
+                        unsigned long totalTime,
+                        size_t        peakRss);
 
   bool           CompareByTime(Pass const& ref)      const;
 
@@ -77,12 +89,17 @@ public:
                        unsigned long accumTime, 
                        unsigned long totalTime)      const;
 
+  void           PrintJson(FILE* fp)                 const;
+
   char*          mName;
   int            mPassId;
   int            mIndex;
   unsigned long  mPrimary;          // usecs()
   unsigned long  mVerify;           // usecs()
   unsigned long  mCleanAst;         // usecs()
+  long           mRssDelta;         // bytes
+  size_t         mPeakRss;          // bytes, peak up to the end
+  AstBytes       mAstBytes;         // bytes per AST kind at the end
 };
 
 struct SortByTime
@@ -180,9 +197,36 @@ void PhaseTracker::ReportRollup() const
   PassesReport(passes, totalTime);
 }
 
+void PhaseTracker::ReportJson(FILE* fp) const
+{
+  std::vector<Pass> passes;
+  unsigned long     totalTime = mTimer.elapsedUsecs();
+
+  PassesCollect(passes);
+
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"totalTime\": %.6f,\n", totalTime / 1e6);
+  fprintf(fp, "  \"peakRss\": %lu,\n", (unsigned long) peakRss());
+  fprintf(fp, "  \"passes\": [");
+
+  for (size_t i = 0; i < passes.size(); i++)
+  {
+    fprintf(fp, (i == 0) ? "\n" : ",\n");
+    passes[i].PrintJson(fp);
+  }
+
+  fprintf(fp, "\n  ]\n");
+  fprintf(fp, "}\n");
+}
+
 void PhaseTracker::PassesCollect(std::vector<Pass>& passes) const
 {
   unsigned long totalTime = mTimer.elapsedUsecs();
+  size_t        nowRss    = currentRss();
+  size_t        nowPeak   = peakRss();
+  AstBytes      nowAst;
+
+  astKindBytes(nowAst);
 
   if (mPhases.size() > 0)
   {
@@ -192,6 +236,8 @@ void PhaseTracker::PassesCollect(std::vector<Pass>& passes) const
     {
       unsigned long start   = mPhases[i]->mStartTime;
       unsigned long elapsed = 0;
+      bool          isLast  = (i == mPhases.size() - 1);
+      size_t        endRss  = isLast ? nowRss  : mPhases[i + 1]->mStartRss;
 
       // Check if it's time to push an completed pass
       if (i > 0 && mPhases[i]->mSubPhase == PhaseTracker::kPrimary)
@@ -222,6 +268,10 @@ void PhaseTracker::PassesCollect(std::vector<Pass>& passes) const
           pass.mCleanAst = elapsed;
           break;
       }
+
+      pass.mRssDelta += (long) endRss - (long) mPhases[i]->mStartRss;
+      pass.mPeakRss   = isLast ? nowPeak : mPhases[i + 1]->mPeakRss;
+      pass.mAstBytes  = isLast ? nowAst  : mPhases[i + 1]->mAstBytes;
     }
 
     passes.push_back(pass);
@@ -269,7 +319,47 @@ static void PassesReport(FILE*                    fp,
     cleanTime = cleanTime + passes[i].mCleanAst;
   }
 
-  Pass::Footer(fp, mainTime, checkTime, cleanTime, totalTime);
+  Pass::Footer(fp, mainTime, checkTime, cleanTime, totalTime, peakRss());
+}
+
+// Zero where the OS doesn't say
+static size_t currentRss()
+{
+  size_t retval = 0;
+
+#ifdef __linux__
+  if (FILE* fp = fopen("/proc/self/statm", "r"))
+  {
+    unsigned long size     = 0;
+    unsigned long resident = 0;
+
+    if (fscanf(fp, "%lu %lu", &size, &resident) == 2)
+      retval = resident * sysconf(_SC_PAGESIZE);
+
+    fclose(fp);
+  }
+#else
+  retval = peakRss();
+#endif
+
+  return retval;
+}
+
+static size_t peakRss()
+{
+  struct rusage usage;
+  size_t        retval = 0;
+
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+  {
+#ifdef __APPLE__
+    retval = usage.ru_maxrss;
+#else
+    retval = usage.ru_maxrss * 1024;
+#endif
+  }
+
+  return retval;
 }
 
 /************************************* | **************************************
@@ -287,6 +377,10 @@ Phase::Phase(const char*            name,
   mPassId    = passId;
   mSubPhase  = subPhase;
   mStartTime = startTime;
+  mStartRss  = currentRss();
+  mPeakRss   = peakRss();
+
+  astKindBytes(mAstBytes);
 }
 
 Phase::~Phase()
@@ -309,6 +403,16 @@ void Phase::ReportPass(unsigned long now) const
 
   ReportTime(mName, phaseTime / 1e6);
 
+  {
+    char   text[64];
+    size_t rss   = currentRss();
+    long   delta = (long) rss - (long) mStartRss;
+
+    sprintf(text, "  %8.1f MB (%+8.1f MB)", rss / 1048576.0, delta / 1048576.0);
+
+    ReportText(text);
+  }
+
   if (developer == true)
   {
     char text[32];
@@ -369,6 +473,9 @@ void Pass::Reset()
   mPrimary  = 0;
   mVerify   = 0;
   mCleanAst = 0;
+  mRssDelta = 0;
+  mPeakRss  = 0;
+  mAstBytes.clear();
 }
 
 unsigned long Pass::TotalTime() const
@@ -403,6 +510,7 @@ void Pass::Header(FILE* fp)
 
   fprintf(fp, "    Time    %%  ");
   fprintf(fp, "   Accum    %%  ");
+  fprintf(fp, "   RSS +MB   Peak MB");
   fprintf(fp, "\n");
 
 
@@ -415,6 +523,7 @@ void Pass::Header(FILE* fp)
 
   fprintf(fp, "  ------- -----");
   fprintf(fp, "  ------- -----");
+  fprintf(fp, "  --------  --------");
   fprintf(fp, "\n");
 }
 
@@ -439,14 +548,41 @@ void Pass::Print(FILE*         fp,
   fprintf(fp, "  %7.3f  %7.3f  %7.3f", primary, verify, clean);
   fprintf(fp, "  %7.3f %5.1f", passTime  / 1e6, passFrac );
   fprintf(fp, "  %7.3f %5.1f", accumTime / 1e6, accumFrac);
+  fprintf(fp, "  %+8.1f  %8.1f", mRssDelta / 1048576.0, mPeakRss / 1048576.0);
   fprintf(fp, "\n");
 }
 
+void Pass::PrintJson(FILE* fp) const
+{
+  fprintf(fp, "    {\n");
+  fprintf(fp, "      \"id\": %d,\n", mPassId);
+  fprintf(fp, "      \"name\": \"%s\",\n", mName);
+  fprintf(fp, "      \"main\": %.6f,\n", mPrimary / 1e6);
+  fprintf(fp, "      \"check\": %.6f,\n", mVerify / 1e6);
+  fprintf(fp, "      \"clean\": %.6f,\n", mCleanAst / 1e6);
+  fprintf(fp, "      \"rssDelta\": %ld,\n", mRssDelta);
+  fprintf(fp, "      \"peakRss\": %lu,\n", (unsigned long) mPeakRss);
+  fprintf(fp, "      \"astBytes\": {");
+
+  for (size_t i = 0; i < mAstBytes.size(); i++)
+  {
+    fprintf(fp,
+            "%s\"%s\": %lu",
+            (i == 0) ? "" : ", ",
+            mAstBytes[i].first,
+            (unsigned long) mAstBytes[i].second);
+  }
+
+  fprintf(fp, "}\n");
+  fprintf(fp, "    }");
+}
+
 void Pass::Footer(FILE*         fp, 
                   unsigned long mainTime,
                   unsigned long checkTime,
                   unsigned long cleanTime,
-                  unsigned long totalTime)
+                  unsigned long totalTime,
+                  size_t        peakRss)
 {
   fprintf(fp,
           "\n     %-33s  %7.3f  %7.3f  %7.3f  %7.3f\n",
@@ -455,6 +591,8 @@ void Pass::Footer(FILE*         fp,
           checkTime / 1e6,
           cleanTime / 1e6,
           totalTime / 1e6);
+
+  fprintf(fp, "     %-33s  %7.1f MB\n", "peak RSS", peakRss / 1048576.0);
 }
 
 
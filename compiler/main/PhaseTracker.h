@@ -57,6 +57,11 @@
 * of these passes.  Phases that occur before and after the Passes ignore      *
 * the check and clean phases.                                                 *
 *                                                                             *
+* Each phase also records the resident set size and its peak so far, and the *
+* bytes held by each kind of AST node, when it starts.  The reports show how  *
+* much each pass grew the RSS; ReportJson() writes all of it, for tracking    *
+* changes over time.                                                          *
+*                                                                             *
 ************************************** | *************************************/
 
 class Phase;
@@ -85,6 +90,8 @@ public:
 
   void                 ReportRollup()                                const;
 
+  void                 ReportJson  (FILE* fp)                        const;
+
 private:
   void                 PassesCollect(std::vector<Pass>& passes) const;
   
@@ -415,6 +415,11 @@ void check_denormalize() {
   //or implement new checks ?
 }
 
+void check_foldIdenticalFunctions()
+{
+  // Like denormalize, this runs on AST that need not be normalized.
+}
+
 void check_codegen()
 {
   // This pass should not change the AST, so no checks are required.
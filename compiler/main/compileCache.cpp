@@ -0,0 +1,294 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// A cache of whole compiles, for builds that compile the same programs
+// over and over.  Once 'parse' has read every module the program uses,
+// the compile is keyed on:
+//
+//   - the compiler version and command line,
+//   - the CHPL_* settings, and
+//   - the path and contents of every parsed .chpl file and of every
+//     other file named on the command line.
+//
+// The executable (and the launcher's _real binary, if there is one) of
+// a successful compile is saved under <dir>/<key>, and a later compile
+// with the same key copies it out and exits right after 'parse'.
+//
+// Files that only the back-end C compiler reads, such as headers pulled
+// in by extern blocks or the runtime libraries, are not part of the
+// key, so the cache should be cleared after rebuilding the runtime.
+//
+
+#include "compileCache.h"
+
+#include "docsDriver.h"
+#include "driver.h"
+#include "files.h"
+#include "insertLineNumbers.h"
+#include "misc.h"
+#include "stringutil.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+static const char* sExeNameFile = "exe-name";
+static const char* sRealSuffix  = "_real";
+
+static std::string sEntryDir;
+
+static bool cacheEnabled() {
+  return compileCacheDir[0] != '\0' &&
+         fLibraryCompile == false &&
+         fParseOnly      == false &&
+         no_codegen      == false &&
+         fDocs           == false &&
+         stopAfterPass[0] == '\0';
+}
+
+//
+// 64-bit FNV-1a
+//
+static void hashBytes(uint64_t& h, const void* data, size_t len) {
+  const unsigned char* p = (const unsigned char*) data;
+
+  for (size_t i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+}
+
+// Strings are hashed with their terminator so adjacent ones can't blur.
+static void hashString(uint64_t& h, const char* str) {
+  hashBytes(h, str, strlen(str) + 1);
+}
+
+static bool hashFile(uint64_t& h, const char* path) {
+  FILE* fp = fopen(path, "rb");
+  char  buf[65536];
+  size_t n;
+
+  if (fp == NULL) {
+    return false;
+  }
+
+  hashString(h, path);
+
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+    hashBytes(h, buf, n);
+  }
+
+  fclose(fp);
+
+  return true;
+}
+
+static bool computeKey(std::string& key) {
+  uint64_t h = 14695981039346656037ULL;
+  char     buf[32];
+
+  hashString(h, compileVersion);
+  hashString(h, compileCommand);
+  hashString(h, getCwd());
+
+  for (std::map<std::string, const char*>::iterator it = envMap.begin();
+       it != envMap.end();
+       ++it) {
+    if (strncmp(it->first.c_str(), "CHPL_", 5) == 0) {
+      hashString(h, it->first.c_str());
+      hashString(h, it->second);
+    }
+  }
+
+  for (size_t i = 0; i < gFilenameLookup.size(); i++) {
+    if (hashFile(h, gFilenameLookup[i].c_str()) == false) {
+      return false;
+    }
+  }
+
+  // C sources, headers and objects named on the command line
+  int         i        = 0;
+  const char* filename = NULL;
+
+  while ((filename = nthFilename(i++)) != NULL) {
+    if (isChplSource(filename) == false &&
+        hashFile(h, filename)  == false) {
+      return false;
+    }
+  }
+
+  // the profile is an input to the optimizer
+  if (profileUseFile[0] != '\0' && hashFile(h, profileUseFile) == false) {
+    return false;
+  }
+
+  snprintf(buf, sizeof(buf), "%016llx", (unsigned long long) h);
+  key = buf;
+
+  return true;
+}
+
+static bool fileExists(const std::string& path) {
+  struct stat sb;
+
+  return stat(path.c_str(), &sb) == 0 && S_ISREG(sb.st_mode);
+}
+
+// Copies src to dst through a temporary, keeping src's permissions.
+static bool copyFile(const std::string& src, const std::string& dst) {
+  std::string tmp    = dst + ".tmp" + istr(getpid());
+  FILE*       in     = fopen(src.c_str(), "rb");
+  FILE*       out    = NULL;
+  bool        retval = false;
+  struct stat sb;
+
+  if (in == NULL) {
+    return false;
+  }
+
+  if (fstat(fileno(in), &sb) == 0 &&
+      (out = fopen(tmp.c_str(), "wb")) != NULL) {
+    char   buf[65536];
+    size_t n;
+
+    retval = true;
+
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+      if (fwrite(buf, 1, n, out) != n) {
+        retval = false;
+        break;
+      }
+    }
+
+    if (fclose(out) != 0 || ferror(in)) {
+      retval = false;
+    }
+
+    if (retval == true) {
+      retval = chmod(tmp.c_str(), sb.st_mode & 07777)  == 0 &&
+               rename(tmp.c_str(), dst.c_str())         == 0;
+    }
+
+    if (retval == false) {
+      unlink(tmp.c_str());
+    }
+  }
+
+  fclose(in);
+
+  return retval;
+}
+
+static bool readExeName(const std::string& entry, std::string& name) {
+  std::string path = entry + "/" + sExeNameFile;
+  FILE*       fp   = fopen(path.c_str(), "r");
+  char        buf[FILENAME_MAX + 1];
+  bool        ok   = false;
+
+  if (fp != NULL) {
+    if (fgets(buf, sizeof(buf), fp) != NULL) {
+      name = buf;
+      ok   = name.empty() == false;
+    }
+
+    fclose(fp);
+  }
+
+  return ok;
+}
+
+void compileCacheLookup() {
+  std::string key;
+  std::string name;
+
+  if (cacheEnabled() == false || computeKey(key) == false) {
+    return;
+  }
+
+  sEntryDir = std::string(compileCacheDir) + "/" + key;
+
+  if (readExeName(sEntryDir, name) == false) {
+    return;
+  }
+
+  std::string exe = sEntryDir + "/exe";
+
+  if (fileExists(exe) == false || copyFile(exe, name) == false) {
+    return;
+  }
+
+  if (fileExists(exe + sRealSuffix) == true) {
+    if (copyFile(exe + sRealSuffix, name + sRealSuffix) == false) {
+      unlink(name.c_str());
+      return;
+    }
+  }
+
+  if (printPasses == true) {
+    fprintf(stderr, "reused %s from the compile cache\n", name.c_str());
+  }
+
+  clean_exit(0);
+}
+
+void compileCacheStore() {
+  // Only compiles that got a key after 'parse' are stored
+  if (cacheEnabled() == false || sEntryDir.empty() == true) {
+    return;
+  }
+
+  std::string name = executableFilename;
+  std::string tmp  = sEntryDir + ".tmp" + istr(getpid());
+  std::string path = tmp + "/" + sExeNameFile;
+  FILE*       fp   = NULL;
+  bool        ok   = false;
+
+  if (fileExists(name) == false) {
+    return;
+  }
+
+  ensureDirExists(compileCacheDir, "creating the compile cache");
+
+  if (mkdir(tmp.c_str(), 0777) != 0) {
+    return;
+  }
+
+  if ((fp = fopen(path.c_str(), "w")) != NULL) {
+    ok = fputs(name.c_str(), fp) >= 0;
+    ok = fclose(fp) == 0 && ok;
+  }
+
+  ok = ok && copyFile(name, tmp + "/exe");
+
+  if (ok == true && fileExists(name + sRealSuffix) == true) {
+    ok = copyFile(name + sRealSuffix, tmp + "/exe" + sRealSuffix);
+  }
+
+  // Another compile with the same key may have won the race; either
+  // entry is as good as the other, so just drop ours.
+  if (ok == false || rename(tmp.c_str(), sEntryDir.c_str()) != 0) {
+    deleteDir(tmp.c_str());
+  }
+}
@@ -130,7 +130,9 @@ bool fCacheRemote = false;
 bool fFastFlag = false;
 bool fNoCopyPropagation = false;
 bool fNoDeadCodeElimination = false;
+bool fNoDeadFieldElimination = false;
 bool fNoScalarReplacement = false;
+bool fNoScalarReplaceAggregates = false;
 bool fNoTupleCopyOpt = false;
 bool fNoRemoteValueForwarding = false;
 bool fNoInferConstRefs = false;
@@ -154,6 +156,11 @@ bool fIgnoreNilabilityErrors = false;
 bool fOverloadSetsChecks = true;
 bool fNoStackChecks = false;
 bool fNoInferLocalFields = false;
+bool fNoInferLocalPointers = false;
+bool fNoDevirtualize = false;
+bool fNoSpeculativeDevirtualize = false;
+bool fNoSpecializeReductions = false;
+bool fNoFoldIdenticalFunctions = false;
 bool fReplaceArrayAccessesWithRefTemps = false;
 bool fUserSetStackChecks = false;
 bool fNoCastChecks = false;
@@ -164,11 +171,24 @@ bool fAutoLocalAccess = true;
 bool fDynamicAutoLocalAccess = true;
 bool fReportAutoLocalAccess= false;
 
+bool fBoundsCheckElimination = false;
+bool fReportBoundsChecks = false;
+
 bool  printPasses     = false;
 FILE* printPassesFile = NULL;
+FILE* printPassesJsonFile = NULL;
 
 // flag for llvmWideOpt
 bool fLLVMWideOpt = false;
+bool fPackedWidePointers = false;
+bool fLtoRuntime = false;
+int llvmCodegenThreads = 1;
+int llvmInterleaveCount = 0;
+int optimizationThreads = 1;
+
+// flags for profile guided optimization
+bool fProfileGenerate = false;
+char profileUseFile[FILENAME_MAX+1] = "";
 
 bool fWarnConstLoops = true;
 bool fWarnUnstable = false;
@@ -182,6 +202,7 @@ bool fNoLoopInvariantCodeMotion = false;
 bool fNoInterproceduralAliasAnalysis = true;
 bool fNoChecks = false;
 bool fNoInline = false;
+int inlineSizeThreshold = 0;
 bool fNoPrivatization = false;
 bool fNoOptimizeOnClauses = false;
 bool fNoRemoveEmptyRecords = true;
@@ -189,11 +210,16 @@ bool fRemoveUnreachableBlocks = true;
 bool fMinimalModules = false;
 bool fIncrementalCompilation = false;
 bool fNoOptimizeForallUnordered = false;
+bool fNoPrefetchForallReads = false;
+bool fNoStrengthReduction = false;
+bool fNoCoforallOnTree = false;
 
 int optimize_on_clause_limit = 20;
 int scalar_replace_limit = 8;
 int inline_iter_yield_limit = 10;
 int tuple_copy_limit = scalar_replace_limit;
+int rvf_record_limit = 64;
+int ret_by_ref_record_size = 32;
 bool fGenIDS = false;
 bool fDetectColorTerminal = true;
 bool fUseColorTerminal = false;
@@ -211,6 +237,7 @@ bool fOverrideChecking = true;
 bool fieeefloat = false;
 int ffloatOpt = 0; // 0 -> backend default; -1 -> strict; 1 -> opt
 bool report_inlining = false;
+bool fReportAutoInline = false;
 char fExplainCall[256] = "";
 int explainCallID = -1;
 int breakOnResolveID = -1;
@@ -234,12 +261,22 @@ bool fReportBlocking = false;
 bool fReportOptimizedLoopIterators = false;
 bool fReportInlinedIterators = false;
 bool fReportVectorizedLoops = false;
+bool fReportVectorizerRemarks = false;
 bool fReportOptimizedOn = false;
+bool fReportLocalPointers = false;
+bool fReportDevirtualization = false;
+bool fReportFoldIdenticalFunctions = false;
+bool fReportSharedWrites = false;
 bool fReportOptimizeForallUnordered = false;
+bool fReportPrefetchForallReads = false;
+bool fReportStrengthReduction = false;
+bool fReportCoforallOnTree = false;
 bool fReportPromotion = false;
+int fReportResolutionProfile = 0;
 bool fReportScalarReplace = false;
 bool fReportDeadBlocks = false;
 bool fReportDeadModules = false;
+bool fReportDeadFields = false;
 bool fPermitUnhandledModuleErrors = false;
 #ifdef HAVE_LLVM_RV
 bool fRegionVectorizer = true;
@@ -749,6 +786,11 @@ static void setFastFlag(const ArgumentDescription* desc, const char* unused) {
   fNoPrivatization = false;
   fNoChecks = true;
   fNoInferLocalFields = false;
+  fNoInferLocalPointers = false;
+  fNoDevirtualize = false;
+  fNoSpeculativeDevirtualize = false;
+  fNoSpecializeReductions = false;
+  fNoFoldIdenticalFunctions = false;
   fIgnoreLocalClasses = false;
   fNoOptimizeOnClauses = false;
   //fReplaceArrayAccessesWithRefTemps = true; // don't tie this to --fast yet
@@ -801,9 +843,18 @@ static void setBaselineFlag(const ArgumentDescription* desc, const char* unused)
   fNoOptimizeOnClauses = true;        // --no-optimize-on-clauses
   fIgnoreLocalClasses = true;         // --ignore-local-classes
   fNoInferLocalFields = true;         // --no-infer-local-fields
+  fNoInferLocalPointers = true;       // --no-infer-local-pointers
+  fNoDevirtualize = true;             // --no-devirtualize
+  fNoSpeculativeDevirtualize = true;  // --no-speculative-devirtualize
+  fNoSpecializeReductions = true;     // --no-specialize-reductions
+  fNoFoldIdenticalFunctions = true;   // --no-fold-identical-functions
+  fBoundsCheckElimination = false;    // --no-bounds-check-elimination
   //fReplaceArrayAccessesWithRefTemps = false; // don't tie this to --baseline yet
   fDenormalize = false;               // --no-denormalize
   fNoOptimizeForallUnordered = true;  // --no-optimize-forall-unordered-ops
+  fNoPrefetchForallReads = true;      // --no-prefetch-forall-reads
+  fNoStrengthReduction = true;        // --no-strength-reduction
+  fNoCoforallOnTree = true;           // --no-coforall-on-tree
 }
 
 static void setCacheEnable(const ArgumentDescription* desc, const char* unused) {
@@ -863,6 +914,14 @@ static void setPrintPassesFile(const ArgumentDescription* desc, const char* file
   }
 }
 
+static void setPrintPassesJsonFile(const ArgumentDescription* desc, const char* fileName) {
+  printPassesJsonFile = fopen(fileName, "w");
+
+  if (printPassesJsonFile == NULL) {
+    USR_WARN("Error opening printPassesJsonFile: %s.", fileName);
+  }
+}
+
 static void setLocal (const ArgumentDescription* desc, const char* unused) {
   // Used in postLocal() to set fLocal if user threw flag
   fUserSetLocal = true;
@@ -932,8 +991,10 @@ static ArgumentDescription arg_desc[] = {
  {"", ' ', NULL, "Optimization Control Options", NULL, NULL, NULL, NULL},
  {"baseline", ' ', NULL, "Disable all Chapel optimizations", "F", &fBaseline, "CHPL_BASELINE", setBaselineFlag},
  {"cache-remote", ' ', NULL, "[Don't] enable cache for remote data", "N", &fCacheRemote, "CHPL_CACHE_REMOTE", setCacheEnable},
+ {"coforall-on-tree", ' ', NULL, "Enable [disable] spanning-tree fan-out of coforall-on over Locales", "n", &fNoCoforallOnTree, "CHPL_DISABLE_COFORALL_ON_TREE", NULL},
  {"copy-propagation", ' ', NULL, "Enable [disable] copy propagation", "n", &fNoCopyPropagation, "CHPL_DISABLE_COPY_PROPAGATION", NULL},
  {"dead-code-elimination", ' ', NULL, "Enable [disable] dead code elimination", "n", &fNoDeadCodeElimination, "CHPL_DISABLE_DEAD_CODE_ELIMINATION", NULL},
+ {"dead-field-elimination", ' ', NULL, "Enable [disable] removal of record and class fields that are never read", "n", &fNoDeadFieldElimination, "CHPL_DISABLE_DEAD_FIELD_ELIMINATION", NULL},
  {"fast", ' ', NULL, "Disable checks; optimize/specialize code", "F", &fFastFlag, "CHPL_FAST", setFastFlag},
  {"fast-followers", ' ', NULL, "Enable [disable] fast followers", "n", &fNoFastFollowers, "CHPL_DISABLE_FAST_FOLLOWERS", NULL},
  {"ieee-float", ' ', NULL, "Generate code that is strict [lax] with respect to IEEE compliance", "N", &fieeefloat, "CHPL_IEEE_FLOAT", setFloatOptFlag},
@@ -941,26 +1002,39 @@ static ArgumentDescription arg_desc[] = {
  {"inline", ' ', NULL, "Enable [disable] function inlining", "n", &fNoInline, NULL, NULL},
  {"inline-iterators", ' ', NULL, "Enable [disable] iterator inlining", "n", &fNoInlineIterators, "CHPL_DISABLE_INLINE_ITERATORS", NULL},
  {"inline-iterators-yield-limit", ' ', "<limit>", "Limit number of yields permitted in inlined iterators", "I", &inline_iter_yield_limit, "CHPL_INLINE_ITER_YIELD_LIMIT", NULL},
+ {"inline-size-threshold", ' ', "<size>", "Also inline functions with at most <size> calls and primitives (0 to disable)", "I", &inlineSizeThreshold, "CHPL_INLINE_SIZE_THRESHOLD", NULL},
  {"live-analysis", ' ', NULL, "Enable [disable] live variable analysis", "n", &fNoLiveAnalysis, "CHPL_DISABLE_LIVE_ANALYSIS", NULL},
  {"loop-invariant-code-motion", ' ', NULL, "Enable [disable] loop invariant code motion", "n", &fNoLoopInvariantCodeMotion, NULL, NULL},
  {"optimize-forall-unordered-ops", ' ', NULL, "Enable [disable] optimization of foralls to unordered operations", "n", &fNoOptimizeForallUnordered, "CHPL_DISABLE_OPTIMIZE_FORALL_UNORDERED_OPS", NULL},
+ {"prefetch-forall-reads", ' ', NULL, "Enable [disable] prefetching of remote reads in foralls with --cache-remote", "n", &fNoPrefetchForallReads, "CHPL_DISABLE_PREFETCH_FORALL_READS", NULL},
+ {"strength-reduction", ' ', NULL, "Enable [disable] strength reduction of loop index arithmetic", "n", &fNoStrengthReduction, "CHPL_DISABLE_STRENGTH_REDUCTION", NULL},
  {"optimize-range-iteration", ' ', NULL, "Enable [disable] optimization of iteration over anonymous ranges", "n", &fNoOptimizeRangeIteration, "CHPL_DISABLE_OPTIMIZE_RANGE_ITERATION", NULL},
  {"optimize-loop-iterators", ' ', NULL, "Enable [disable] optimization of iterators composed of a single loop", "n", &fNoOptimizeLoopIterators, "CHPL_DISABLE_OPTIMIZE_LOOP_ITERATORS", NULL},
  {"optimize-on-clauses", ' ', NULL, "Enable [disable] optimization of on clauses", "n", &fNoOptimizeOnClauses, "CHPL_DISABLE_OPTIMIZE_ON_CLAUSES", NULL},
  {"optimize-on-clause-limit", ' ', "<limit>", "Limit recursion depth of on clause optimization search", "I", &optimize_on_clause_limit, "CHPL_OPTIMIZE_ON_CLAUSE_LIMIT", NULL},
+ {"optimization-threads", ' ', "<n>", "Number of threads for per-function optimizations (0 for one per core)", "I", &optimizationThreads, "CHPL_OPTIMIZATION_THREADS", NULL},
  {"privatization", ' ', NULL, "Enable [disable] privatization of distributed arrays and domains", "n", &fNoPrivatization, "CHPL_DISABLE_PRIVATIZATION", NULL},
  {"remote-value-forwarding", ' ', NULL, "Enable [disable] remote value forwarding", "n", &fNoRemoteValueForwarding, "CHPL_DISABLE_REMOTE_VALUE_FORWARDING", NULL},
+ {"remote-value-forwarding-record-limit", ' ', "<bytes>", "Limit on the size of const records forwarded by value to on statements", "I", &rvf_record_limit, "CHPL_REMOTE_VALUE_FORWARDING_RECORD_LIMIT", NULL},
  {"remote-serialization", ' ', NULL, "Enable [disable] serialization for remote consts", "n", &fNoRemoteSerialization, "CHPL_DISABLE_REMOTE_SERIALIZATION", NULL},
  {"remove-copy-calls", ' ', NULL, "Enable [disable] remove copy calls", "n", &fNoRemoveCopyCalls, "CHPL_DISABLE_REMOVE_COPY_CALLS", NULL},
+ {"return-by-ref-record-size", ' ', "<bytes>", "Return plain records of at least <bytes> bytes through a reference argument (0 to disable)", "I", &ret_by_ref_record_size, "CHPL_RETURN_BY_REF_RECORD_SIZE", NULL},
  {"scalar-replacement", ' ', NULL, "Enable [disable] scalar replacement", "n", &fNoScalarReplacement, "CHPL_DISABLE_SCALAR_REPLACEMENT", NULL},
+ {"scalar-replace-aggregates", ' ', NULL, "Enable [disable] scalar replacement of records and classes other than tuples", "n", &fNoScalarReplaceAggregates, "CHPL_DISABLE_SCALAR_REPLACE_AGGREGATES", NULL},
  {"scalar-replace-limit", ' ', "<limit>", "Limit on the size of tuples being replaced during scalar replacement", "I", &scalar_replace_limit, "CHPL_SCALAR_REPLACE_TUPLE_LIMIT", NULL},
  {"tuple-copy-opt", ' ', NULL, "Enable [disable] tuple (memcpy) optimization", "n", &fNoTupleCopyOpt, "CHPL_DISABLE_TUPLE_COPY_OPT", NULL},
  {"tuple-copy-limit", ' ', "<limit>", "Limit on the size of tuples considered for optimization", "I", &tuple_copy_limit, "CHPL_TUPLE_COPY_LIMIT", NULL},
  {"infer-local-fields", ' ', NULL, "Enable [disable] analysis to infer local fields in classes and records", "n", &fNoInferLocalFields, "CHPL_DISABLE_INFER_LOCAL_FIELDS", NULL},
+ {"infer-local-pointers", ' ', NULL, "Enable [disable] analysis to keep provably local class variables narrow", "n", &fNoInferLocalPointers, "CHPL_DISABLE_INFER_LOCAL_POINTERS", NULL},
+ {"devirtualize", ' ', NULL, "Enable [disable] making method calls direct when no override can be reached from the receiver's type", "n", &fNoDevirtualize, "CHPL_DISABLE_DEVIRTUALIZE", NULL},
+ {"speculative-devirtualize", ' ', NULL, "Enable [disable] guarded direct calls to the method of the only class allocated below the receiver's type", "n", &fNoSpeculativeDevirtualize, "CHPL_DISABLE_SPECULATIVE_DEVIRTUALIZE", NULL},
+ {"specialize-reductions", ' ', NULL, "Enable [disable] accumulating reductions of numbers with builtin operators directly in the loop body", "n", &fNoSpecializeReductions, "CHPL_DISABLE_SPECIALIZE_REDUCTIONS", NULL},
+ {"fold-identical-functions", ' ', NULL, "Enable [disable] merging functions whose generated code would be identical", "n", &fNoFoldIdenticalFunctions, "CHPL_DISABLE_FOLD_IDENTICAL_FUNCTIONS", NULL},
  {"vectorize", ' ', NULL, "Enable [disable] generation of vectorization hints", "n", &fNoVectorize, "CHPL_DISABLE_VECTORIZATION", setVectorize},
 
  {"auto-local-access", ' ', NULL, "Enable [disable] using local access automatically", "N", &fAutoLocalAccess, "CHPL_DISABLE_AUTO_LOCAL_ACCESS", NULL},
  {"dynamic-auto-local-access", ' ', NULL, "Enable [disable] using local access automatically (dynamic only)", "N", &fDynamicAutoLocalAccess, "CHPL_DISABLE_DYNAMIC_AUTO_LOCAL_ACCESS", NULL},
+ {"bounds-check-elimination", ' ', NULL, "Enable [disable] removing bounds checks from array accesses proven to be in bounds", "N", &fBoundsCheckElimination, "CHPL_BOUNDS_CHECK_ELIMINATION", NULL},
 
  {"", ' ', NULL, "Run-time Semantic Check Options", NULL, NULL, NULL, NULL},
  {"checks", ' ', NULL, "Enable [disable] all following run-time checks", "n", &fNoChecks, "CHPL_NO_CHECKS", setChecks},
@@ -973,7 +1047,9 @@ static ArgumentDescription arg_desc[] = {
  {"stack-checks", ' ', NULL, "Enable [disable] stack overflow checking", "n", &fNoStackChecks, "CHPL_STACK_CHECKS", setStackChecks},
 
  {"", ' ', NULL, "C Code Generation Options", NULL, NULL, NULL, NULL},
+ {"clang-pch-cache", ' ', "<directory>", "Cache precompiled runtime headers for clang in directory", "P", clangPchCacheDir, "CHPL_CLANG_PCH_CACHE_DIR", NULL},
  {"codegen", ' ', NULL, "[Don't] Do code generation", "n", &no_codegen, "CHPL_NO_CODEGEN", NULL},
+ {"compile-cache", ' ', "<directory>", "Reuse executables of identical compiles cached in directory", "P", compileCacheDir, "CHPL_COMPILE_CACHE_DIR", NULL},
  {"cpp-lines", ' ', NULL, "[Don't] Generate #line annotations", "N", &printCppLineno, "CHPL_CG_CPP_LINES", noteCppLinesSet},
  {"max-c-ident-len", ' ', NULL, "Maximum length of identifiers in generated code, 0 for unlimited", "I", &fMaxCIdentLen, "CHPL_MAX_C_IDENT_LEN", NULL},
  {"munge-user-idents", ' ', NULL, "[Don't] Munge user identifiers to avoid naming conflicts with external code", "N", &fMungeUserIdents, "CHPL_MUNGE_USER_IDENTS"},
@@ -988,12 +1064,18 @@ static ArgumentDescription arg_desc[] = {
  {"lib-linkage", 'l', "<library>", "C library linkage", "P", libraryFilename, "CHPL_LIB_NAME", handleLibrary},
  {"lib-search-path", 'L', "<directory>", "C library search path", "P", libraryFilename, "CHPL_LIB_PATH", handleLibPath},
  {"optimize", 'O', NULL, "[Don't] Optimize generated C code", "N", &optimizeCCode, "CHPL_OPTIMIZE", NULL},
+ {"profile-generate", ' ', NULL, "Instrument the executable to write a profile for --profile-use", "F", &fProfileGenerate, "CHPL_PROFILE_GENERATE", NULL},
+ {"profile-use", ' ', "<file>", "Optimize using a profile merged with llvm-profdata", "P", profileUseFile, "CHPL_PROFILE_USE", NULL},
  {"specialize", ' ', NULL, "[Don't] Specialize generated C code for CHPL_TARGET_CPU", "N", &specializeCCode, "CHPL_SPECIALIZE", NULL},
  {"output", 'o', "<filename>", "Name output executable", "P", executableFilename, "CHPL_EXE_NAME", NULL},
  {"static", ' ', NULL, "Generate a statically linked binary", "F", &fLinkStyle, NULL, NULL},
 
  {"", ' ', NULL, "LLVM Code Generation Options", NULL, NULL, NULL, NULL},
  {"llvm", ' ', NULL, "[Don't] use the LLVM code generator", "N", &fYesLlvmCodegen, "CHPL_LLVM_CODEGEN", setLlvmCodegen},
+ {"llvm-codegen-threads", ' ', "<n>", "Number of threads for LLVM code generation (0 for one per core)", "I", &llvmCodegenThreads, "CHPL_LLVM_CODEGEN_THREADS", NULL},
+ {"llvm-interleave-count", ' ', "<n>", "Interleave count to hint for vectorizable loops (0 to leave it to LLVM)", "I", &llvmInterleaveCount, "CHPL_LLVM_INTERLEAVE_COUNT", NULL},
+ {"llvm-lto-runtime", ' ', NULL, "[Don't] link in the runtime's LLVM bitcode so calls into the runtime can be inlined", "N", &fLtoRuntime, "CHPL_LLVM_LTO_RUNTIME", NULL},
+ {"llvm-packed-wide-pointers", ' ', NULL, "[Don't] pack the node id into the high bits of 64-bit wide pointers (requires --llvm-wide-opt)", "N", &fPackedWidePointers, "CHPL_LLVM_PACKED_WIDE_POINTERS", NULL},
  {"llvm-wide-opt", ' ', NULL, "Enable [disable] LLVM wide pointer optimizations", "N", &fLLVMWideOpt, "CHPL_LLVM_WIDE_OPTS", NULL},
  {"mllvm", ' ', "<flags>", "LLVM flags (can be specified multiple times)", "S", NULL, "CHPL_MLLVM", setLLVMFlags},
 
@@ -1001,6 +1083,7 @@ static ArgumentDescription arg_desc[] = {
  {"print-commands", ' ', NULL, "[Don't] print system commands", "N", &printSystemCommands, "CHPL_PRINT_COMMANDS", NULL},
  {"print-passes", ' ', NULL, "[Don't] print compiler passes", "N", &printPasses, "CHPL_PRINT_PASSES", NULL},
  {"print-passes-file", ' ', "<filename>", "Print compiler passes to <filename>", "S", NULL, "CHPL_PRINT_PASSES_FILE", setPrintPassesFile},
+ {"print-passes-json", ' ', "<filename>", "Print compiler pass times and memory use to <filename> as JSON", "S", NULL, "CHPL_PRINT_PASSES_JSON", setPrintPassesJsonFile},
 
  {"", ' ', NULL, "Miscellaneous Options", NULL, NULL, NULL, NULL},
  DRIVER_ARG_DEVELOPER,
@@ -1076,15 +1159,27 @@ static ArgumentDescription arg_desc[] = {
  {"report-aliases", ' ', NULL, "Report aliases in user code", "N", &fReportAliases, NULL, NULL},
  {"report-blocking", ' ', NULL, "Report blocking functions in user code", "N", &fReportBlocking, NULL, NULL},
  {"report-inlining", ' ', NULL, "Print inlined functions", "F", &report_inlining, NULL, NULL},
+ {"report-inline-size-threshold", ' ', NULL, "Show which functions --inline-size-threshold inlines", "F", &fReportAutoInline, NULL, NULL},
+ {"report-coforall-on-tree", ' ', NULL, "Show which coforall-on loops fan out through a spanning tree", "F", &fReportCoforallOnTree, NULL, NULL},
  {"report-dead-blocks", ' ', NULL, "Print dead block removal stats", "F", &fReportDeadBlocks, NULL, NULL},
  {"report-dead-modules", ' ', NULL, "Print dead module removal stats", "F", &fReportDeadModules, NULL, NULL},
+ {"report-dead-fields", ' ', NULL, "Print dead field and field store removal stats", "F", &fReportDeadFields, NULL, NULL},
  {"report-optimized-loop-iterators", ' ', NULL, "Print stats on optimized single loop iterators", "F", &fReportOptimizedLoopIterators, NULL, NULL},
  {"report-inlined-iterators", ' ', NULL, "Print stats on inlined iterators", "F", &fReportInlinedIterators, NULL, NULL},
  {"report-vectorized-loops", ' ', NULL, "Show which loops have vectorization hints", "F", &fReportVectorizedLoops, NULL, NULL},
- {"report-optimized-on", ' ', NULL, "Print information about on clauses that have been optimized for potential fast remote fork operation", "F", &fReportOptimizedOn, NULL, NULL},
+ {"report-vectorizer-remarks", ' ', NULL, "Show what the LLVM vectorizer did with loops that have vectorization hints", "F", &fReportVectorizerRemarks, NULL, NULL},
+ {"report-local-pointers", ' ', NULL, "Print the class variables kept narrow by local pointer inference", "F", &fReportLocalPointers, NULL, NULL},
+ {"report-devirtualization", ' ', NULL, "Show which method calls have been [speculatively] devirtualized", "F", &fReportDevirtualization, NULL, NULL},
+ {"report-fold-identical-functions", ' ', NULL, "Show which instantiations have been folded into identical ones", "F", &fReportFoldIdenticalFunctions, NULL, NULL},
+ {"report-shared-writes", ' ', NULL, "Print forall loops whose tasks all write the same outer variable", "F", &fReportSharedWrites, NULL, NULL},
+ {"report-optimized-on", ' ', NULL, "Print information about on clauses that have [not] been optimized for potential fast remote fork operation", "F", &fReportOptimizedOn, NULL, NULL},
  {"report-auto-local-access", ' ', NULL, "Enable compiler logs for auto local access optimization", "N", &fReportAutoLocalAccess, "CHPL_REPORT_AUTO_LOCAL_ACCESS", NULL},
+ {"report-bounds-checks", ' ', NULL, "Show which array accesses still have bounds checks", "F", &fReportBoundsChecks, NULL, NULL},
  {"report-optimized-forall-unordered-ops", ' ', NULL, "Show which statements in foralls have been converted to unordered operations", "F", &fReportOptimizeForallUnordered, NULL, NULL},
+ {"report-prefetch-forall-reads", ' ', NULL, "Show which loops in foralls have had remote reads prefetched", "F", &fReportPrefetchForallReads, NULL, NULL},
+ {"report-strength-reduction", ' ', NULL, "Show which loops have had index arithmetic strength reduced", "F", &fReportStrengthReduction, NULL, NULL},
  {"report-promotion", ' ', NULL, "Print information about scalar promotion", "F", &fReportPromotion, NULL, NULL},
+ {"report-resolution-profile", ' ', "<n>", "Print the <n> functions that took the longest to resolve", "I", &fReportResolutionProfile, NULL, NULL},
  {"report-scalar-replace", ' ', NULL, "Print scalar replacement stats", "F", &fReportScalarReplace, NULL, NULL},
 
  {"", ' ', NULL, "Developer Flags -- Miscellaneous", NULL, NULL, NULL, NULL},
@@ -1518,6 +1613,47 @@ static void checkIncrementalAndOptimized() {
               " using -O optimizations directly.");
 }
 
+// Profile guided optimization goes through LLVM, either in the LLVM
+// backend's pass pipeline or by clang compiling the generated C.
+static void checkProfileFlags() {
+  bool profileUse = profileUseFile[0] != '\0';
+
+  if (fProfileGenerate == false && profileUse == false)
+    return;
+
+  if (fProfileGenerate && profileUse)
+    USR_FATAL("--profile-generate and --profile-use can't be used together");
+
+  if (fLlvmCodegen == false &&
+      strcmp(CHPL_TARGET_COMPILER, "clang") != 0 &&
+      strcmp(CHPL_TARGET_COMPILER, "llvm") != 0)
+    USR_FATAL("--profile-%s requires --llvm or CHPL_TARGET_COMPILER=clang",
+              fProfileGenerate ? "generate" : "use");
+
+  if (profileUse) {
+    FILE* fp = fopen(profileUseFile, "r");
+
+    if (fp == NULL)
+      USR_FATAL("can't open profile '%s' for --profile-use", profileUseFile);
+
+    fclose(fp);
+  }
+
+  // The LLVM backend sets up its own instrumentation in
+  // configurePMBuilder, but linking needs the profile runtime either way.
+  if (fLlvmCodegen == false) {
+    std::string flag = fProfileGenerate ?
+                       std::string("-fprofile-instr-generate=") +
+                                   PROFILE_GENERATE_FILE :
+                       std::string("-fprofile-instr-use=") + profileUseFile;
+
+    setCCFlags(NULL, flag.c_str());
+  }
+
+  if (fProfileGenerate)
+    setLDFlags(NULL, "-fprofile-instr-generate");
+}
+
 static void checkUnsupportedConfigs(void) {
   // Check for cce classic
   if (!strcmp(CHPL_TARGET_COMPILER, "cray-prgenv-cray")) {
@@ -1580,6 +1716,8 @@ static void postprocess_args() {
 
   checkIncrementalAndOptimized();
 
+  checkProfileFlags();
+
   checkUnsupportedConfigs();
 }
 
@@ -1658,6 +1796,11 @@ int main(int argc, char* argv[]) {
     fclose(printPassesFile);
   }
 
+  if (printPassesJsonFile != NULL) {
+    tracker.ReportJson(printPassesJsonFile);
+    fclose(printPassesJsonFile);
+  }
+
   clean_exit(0);
 
   return 0;
@@ -21,6 +21,7 @@
 #include "runpasses.h"
 
 #include "checks.h"
+#include "compileCache.h"
 #include "driver.h"
 #include "log.h"
 #include "parser.h"
@@ -80,6 +81,7 @@ struct PassInfo {
 #define LOG_addInitCalls                       LOG_NO_SHORT
 #define LOG_insertLineNumbers                  LOG_NO_SHORT
 #define LOG_denormalize                        LOG_NO_SHORT
+#define LOG_foldIdenticalFunctions             LOG_NO_SHORT
 #define LOG_codegen                            'c'
 #define LOG_makeBinary                         LOG_NEVER
 
@@ -151,6 +153,7 @@ static PassInfo sPassList[] = {
   // AST to C or LLVM
   RUN(insertLineNumbers),       // insert line numbers for error messages
   RUN(denormalize),             // denormalize -- remove local temps
+  RUN(foldIdenticalFunctions),  // merge functions with identical bodies
   RUN(codegen),                 // generate C code
   RUN(makeBinary)               // invoke underlying C compiler
 };
@@ -173,6 +176,15 @@ void runPasses(PhaseTracker& tracker, bool isChpldoc) {
 
     currentPassNo++;
 
+    // Reuse an earlier identical compile now that every module is known
+    if (isChpldoc == false && strcmp(sPassList[i].name, "parse") == 0) {
+      compileCacheLookup();
+    }
+
+    if (strcmp(sPassList[i].name, "makeBinary") == 0) {
+      compileCacheStore();
+    }
+
     // Break early if this is a parse-only run
     if (fParseOnly ==  true && strcmp(sPassList[i].name, "checkParsed") == 0) {
       break;
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "astutil.h"
+#include "driver.h"
+#include "expr.h"
+#include "ModuleSymbol.h"
+#include "optimizations.h"
+#include "stlUtil.h"
+#include "stmt.h"
+#include "stringutil.h"
+#include "symbol.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+/*
+   Remove the bounds checks from array accesses that are known to be in
+   bounds, instead of leaving them all in or taking them all out with
+   --no-bounds-checks.
+
+   Before normalization, doPreNormalizeArrayOptimizations tags the body of
+   every 'if boundsChecking then ...' in the modules with BLOCK_BOUNDS_CHECK
+   and finds the accesses in for and forall loops that can't be out of
+   bounds, like 'A[i]' in 'for i in A.domain' (see findProvenAccesses).
+   Resolution hands the resolved calls for those to noteProvenInBoundsAccess.
+
+   Once everything is resolved, each of those calls is redirected to a copy
+   of the function it calls with the tagged blocks taken out.  Calls in the
+   copy to other module functions that check bounds, like dsiAccess, go to
+   unchecked copies of those in turn.  Every other call still checks.
+ */
+
+static std::vector<CallExpr*> provenAccesses;
+
+// Whether a function, or something it calls, checks bounds
+static std::map<FnSymbol*, bool> mayCheckMap;
+
+// The unchecked copy of each function, and the set of copies
+static std::map<FnSymbol*, FnSymbol*> uncheckedCopies;
+static std::set<FnSymbol*> uncheckedFns;
+
+void noteProvenInBoundsAccess(CallExpr* call) {
+  provenAccesses.push_back(call);
+}
+
+static bool isBoundsCheckBlock(BaseAST* ast) {
+  BlockStmt* block = toBlockStmt(ast);
+
+  return block != NULL && (block->blockTag & BLOCK_BOUNDS_CHECK) != 0;
+}
+
+static bool isArrayAccess(CallExpr* call) {
+  return call->numActuals() >= 2 &&
+         call->get(1)->typeInfo() == dtMethodToken &&
+         call->get(2)->getValType()->symbol->hasFlag(FLAG_ARRAY);
+}
+
+static bool mayCheckBounds(FnSymbol* fn) {
+  std::map<FnSymbol*, bool>::iterator it = mayCheckMap.find(fn);
+
+  if (it != mayCheckMap.end())
+    return it->second;
+
+  // Assume it doesn't while looking into it, for recursion.  Getting this
+  // wrong only leaves a check in.
+  mayCheckMap[fn] = false;
+
+  bool          retval = false;
+  ModuleSymbol* mod    = fn->getModule();
+
+  if (mod != NULL &&
+      (mod->modTag == MOD_INTERNAL || mod->modTag == MOD_STANDARD) &&
+      fn->hasFlag(FLAG_EXTERN) == false) {
+    std::vector<BaseAST*> asts;
+
+    collect_asts(fn->body, asts);
+
+    for_vector(BaseAST, ast, asts) {
+      if (isBoundsCheckBlock(ast)) {
+        retval = true;
+        break;
+      }
+    }
+
+    if (retval == false) {
+      for_vector(BaseAST, ast, asts) {
+        if (CallExpr* call = toCallExpr(ast)) {
+          if (FnSymbol* callee = call->resolvedFunction()) {
+            if (mayCheckBounds(callee)) {
+              retval = true;
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  mayCheckMap[fn] = retval;
+
+  return retval;
+}
+
+static FnSymbol* getUncheckedCopy(FnSymbol* fn) {
+  std::map<FnSymbol*, FnSymbol*>::iterator it = uncheckedCopies.find(fn);
+
+  if (it != uncheckedCopies.end())
+    return it->second;
+
+  SET_LINENO(fn);
+
+  FnSymbol* copy = fn->copy();
+
+  copy->name  = astr("_unchecked_", fn->name);
+  copy->cname = astr("_unchecked_", fn->cname);
+
+  fn->defPoint->insertBefore(new DefExpr(copy));
+
+  uncheckedCopies[fn]   = copy;
+  uncheckedCopies[copy] = copy; // to handle recursion
+  uncheckedFns.insert(copy);
+
+  std::vector<BaseAST*> asts;
+
+  collect_asts(copy->body, asts);
+
+  for_vector(BaseAST, ast, asts) {
+    if (isBoundsCheckBlock(ast) && ast->inTree()) {
+      toBlockStmt(ast)->remove();
+    }
+  }
+
+  for_vector(BaseAST, ast, asts) {
+    if (CallExpr* call = toCallExpr(ast)) {
+      if (call->inTree()) {
+        if (FnSymbol* callee = call->resolvedFunction()) {
+          if (mayCheckBounds(callee)) {
+            call->setResolvedFunction(getUncheckedCopy(callee));
+          }
+        }
+      }
+    }
+  }
+
+  return copy;
+}
+
+static void removeChecks(CallExpr* call) {
+  if (FnSymbol* fn = call->resolvedFunction()) {
+    if (isArrayAccess(call) && mayCheckBounds(fn)) {
+      call->setResolvedFunction(getUncheckedCopy(fn));
+    }
+  }
+}
+
+// --report-bounds-checks: list the array accesses in user code that are
+// still checked, once per line
+static void reportBoundsChecks() {
+  std::set<std::pair<const char*, int> > checkedLines;
+  std::set<std::pair<const char*, int> > uncheckedLines;
+
+  forv_Vec(CallExpr, call, gCallExprs) {
+    if (call->inTree() == false ||
+        call->getModule()->modTag != MOD_USER ||
+        isArrayAccess(call) == false) {
+      continue;
+    }
+
+    FnSymbol* fn = call->resolvedFunction();
+
+    if (fn == NULL)
+      continue;
+
+    std::pair<const char*, int> line(call->fname(), call->linenum());
+
+    if (uncheckedFns.count(fn) != 0) {
+      uncheckedLines.insert(line);
+
+    } else if ((fn->name == astrThis || fn->name == astr("localAccess")) &&
+               mayCheckBounds(fn)) {
+      if (checkedLines.insert(line).second &&
+          (developer || printsUserLocation(call))) {
+        USR_PRINT(call, "This array access is bounds checked");
+      }
+    }
+  }
+
+  printf("Removed bounds checks from array accesses on %d lines, "
+         "%d lines still have them.\n",
+         (int)uncheckedLines.size(), (int)checkedLines.size());
+}
+
+void removeProvenBoundsChecks() {
+  if (fBoundsCheckElimination == false || fNoBoundsChecks == true)
+    return;
+
+  for_vector(CallExpr, call, provenAccesses) {
+    if (call->inTree() == false)
+      continue;
+
+    // the ref, const ref and value versions of the access
+    if (ContextCallExpr* cc = toContextCallExpr(call->parentExpr)) {
+      for_alist(option, cc->options) {
+        removeChecks(toCallExpr(option));
+      }
+    } else {
+      removeChecks(call);
+    }
+  }
+
+  if (fReportBoundsChecks)
+    reportBoundsChecks();
+
+  // Other passes expect plain block tags
+  forv_Vec(BlockStmt, block, gBlockStmts) {
+    (unsigned&)(block->blockTag) &= ~BLOCK_BOUNDS_CHECK;
+  }
+
+  provenAccesses.clear();
+}
@@ -124,7 +124,7 @@
 //#############################################################################
 
 
-static size_t s_repl_count; ///< The number of pairs replaced by GCP this pass.
+static thread_local size_t s_repl_count; ///< The number of pairs replaced by GCP this pass.
 
 //#############################################################################
 //# LOCAL COPY PROPAGATION
@@ -923,8 +923,23 @@ size_t globalCopyPropagation(FnSymbol* fn) {
   return s_repl_count;
 }
 
+static void copyPropagateFn(FnSymbol* fn) {
+  localCopyPropagation(fn);
+  if (!fNoDeadCodeElimination)
+    deadVariableElimination(fn);
+
+  // Iterate GCP with dead code elimination.
+  while (globalCopyPropagation(fn) > 0)
+  {
+    if (!fNoDeadCodeElimination)
+      deadVariableElimination(fn);
+  }
+}
+
 void copyPropagation(void) {
   if (!fNoCopyPropagation) {
+    std::vector<FnSymbol*> fns;
+
     forv_Vec(FnSymbol, fn, gFnSymbols)
     {
       // BHARSH INIT TODO: Can this be eliminated now that tuples no longer use
@@ -935,17 +950,11 @@ void copyPropagation(void) {
       if (fn->hasFlag(FLAG_EXTERN))
         continue;
 
-      localCopyPropagation(fn);
-      if (!fNoDeadCodeElimination)
-        deadVariableElimination(fn);
-
-      // Iterate GCP with dead code elimination.
-      while (globalCopyPropagation(fn) > 0)
-      {
-        if (!fNoDeadCodeElimination)
-          deadVariableElimination(fn);
-      }
+      fns.push_back(fn);
     }
+
+    // Each function is handled on its own, so spread them over threads.
+    forEachFnInParallel(fns, copyPropagateFn);
   }
 }
 
@@ -46,6 +46,8 @@ static void         cleanupLoopBlocks(FnSymbol* fn);
 
 static unsigned int deadBlockCount;
 static unsigned int deadModuleCount;
+static unsigned int deadFieldCount;
+static unsigned int deadFieldStoreCount;
 
 
 
@@ -455,12 +457,189 @@ static void deadModuleElimination() {
   }
 }
 
+/************************************* | **************************************
+*                                                                             *
+* Dead field elimination: remove fields of records and classes that are      *
+* written but never read anywhere in the program, along with the stores to   *
+* them.  Types whose layout may be seen by C code are left alone.            *
+*                                                                             *
+************************************** | *************************************/
+
+static bool isFieldStore(SymExpr* se) {
+  CallExpr* call = toCallExpr(se->parentExpr);
+  return call != NULL &&
+         call->isPrimitive(PRIM_SET_MEMBER) &&
+         call->get(2) == se;
+}
+
+// Types that are passed to or from extern or export functions, or that
+// a c_ptr can point to.
+static void collectTypesSeenByC(std::set<Type*>& types) {
+  forv_Vec(FnSymbol, fn, gFnSymbols) {
+    if (fn->hasEitherFlag(FLAG_EXTERN, FLAG_EXPORT)) {
+      types.insert(fn->retType->getValType());
+      for_formals(formal, fn) {
+        types.insert(formal->getValType());
+      }
+    }
+  }
+
+  forv_Vec(TypeSymbol, ts, gTypeSymbols) {
+    if (ts->hasFlag(FLAG_DATA_CLASS)) {
+      if (TypeSymbol* elt = getDataClassType(ts)) {
+        types.insert(elt->type);
+      }
+    }
+  }
+}
+
+static bool canRemoveFieldsOf(AggregateType* at,
+                              const std::set<Type*>& seenByC) {
+  TypeSymbol* ts = at->symbol;
+
+  if (!ts->inTree() || isUnion(at))
+    return false;
+
+  if (ts->hasFlag(FLAG_EXTERN) ||
+      ts->hasFlag(FLAG_EXPORT) ||
+      ts->hasFlag(FLAG_REF) ||
+      ts->hasFlag(FLAG_WIDE_REF) ||
+      ts->hasFlag(FLAG_WIDE_CLASS) ||
+      ts->hasFlag(FLAG_DATA_CLASS) ||
+      ts->hasFlag(FLAG_TUPLE) ||
+      ts->hasFlag(FLAG_ITERATOR_CLASS) ||
+      ts->hasFlag(FLAG_ITERATOR_RECORD) ||
+      ts->hasFlag(FLAG_NO_OBJECT))
+    return false;
+
+  return seenByC.count(at) == 0;
+}
+
+static void deadFieldElimination() {
+  deadFieldCount = 0;
+  deadFieldStoreCount = 0;
+
+  if (fNoDeadFieldElimination)
+    return;
+
+  std::set<Type*> seenByC;
+  collectTypesSeenByC(seenByC);
+
+  forv_Vec(AggregateType, at, gAggregateTypes) {
+    if (!canRemoveFieldsOf(at, seenByC))
+      continue;
+
+    std::vector<Symbol*> deadFields;
+
+    for_fields(field, at) {
+      if (field->hasFlag(FLAG_SUPER_CLASS))
+        continue;
+
+      bool isRead = false;
+      for_SymbolSymExprs(se, field) {
+        if (!isFieldStore(se)) {
+          isRead = true;
+          break;
+        }
+      }
+
+      if (!isRead)
+        deadFields.push_back(field);
+    }
+
+    for_vector(Symbol, field, deadFields) {
+      for_SymbolSymExprs(se, field) {
+        se->getStmtExpr()->remove();
+        deadFieldStoreCount++;
+      }
+
+      if (developer || printsUserLocation(field))
+        if (fReportDeadFields)
+          USR_PRINT(field, "removed field '%s' of '%s', which is never read",
+                    field->name, at->symbol->name);
+
+      field->defPoint->remove();
+      deadFieldCount++;
+    }
+  }
+}
+
+//
+// Within straight-line code, remove a store to a field that is followed by
+// another store to the same field of the same object before anything could
+// read it.  Only stores to other fields and moves between locals may come
+// in between; calls, dereferences, reads of the field, copies of the
+// object and anything that rebinds its variable stop the search.
+//
+static bool mayReadField(Expr* stmt, Symbol* base, Symbol* field) {
+  if (isDefExpr(stmt))
+    return false;
+
+  CallExpr* call = toCallExpr(stmt);
+  if (call == NULL)
+    return true;
+
+  if (call->isPrimitive(PRIM_END_OF_STATEMENT))
+    return false;
+
+  if (call->isPrimitive(PRIM_SET_MEMBER)) {
+    SymExpr* value = toSymExpr(call->get(3));
+    return toSymExpr(call->get(2))->symbol() == field ||
+           value == NULL || value->symbol() == base;
+  }
+
+  if (call->isPrimitive(PRIM_MOVE)) {
+    SymExpr* lhs = toSymExpr(call->get(1));
+    if (lhs == NULL || lhs->isRef() || lhs->symbol() == base)
+      return true;
+
+    // Copying the object (e.g. a record) copies the field too
+    if (SymExpr* rhs = toSymExpr(call->get(2)))
+      return rhs->symbol() == base;
+
+    if (CallExpr* rhs = toCallExpr(call->get(2)))
+      if (rhs->isPrimitive(PRIM_GET_MEMBER_VALUE))
+        return toSymExpr(rhs->get(2))->symbol() == field;
+  }
+
+  return true;
+}
+
+static void deadFieldStoreElimination(FnSymbol* fn) {
+  std::vector<CallExpr*> calls;
+  collectCallExprs(fn, calls);
+
+  for_vector(CallExpr, call, calls) {
+    if (!call->isPrimitive(PRIM_SET_MEMBER) || !call->isStmtExpr() ||
+        !isSymExpr(call->get(3)))
+      continue;
+
+    Symbol* base = toSymExpr(call->get(1))->symbol();
+    Symbol* field = toSymExpr(call->get(2))->symbol();
+
+    for (Expr* next = call->next; next != NULL; next = next->next) {
+      CallExpr* store = toCallExpr(next);
+      if (store && store->isPrimitive(PRIM_SET_MEMBER) &&
+          toSymExpr(store->get(1))->symbol() == base &&
+          toSymExpr(store->get(2))->symbol() == field) {
+        call->remove();
+        deadFieldStoreCount++;
+        break;
+      }
+
+      if (mayReadField(next, base, field))
+        break;
+    }
+  }
+}
+
 void deadCodeElimination() {
   if (!fNoDeadCodeElimination) {
     deadBlockElimination();
 
     deadStringLiteralElimination();
 
+    deadFieldElimination();
 
     forv_Vec(FnSymbol, fn, gFnSymbols) {
 
@@ -469,6 +648,9 @@ void deadCodeElimination() {
       // Some of these will break BasicBlock construction. Clean them up.
       cleanupLoopBlocks(fn);
 
+      if (!fNoDeadFieldElimination)
+        deadFieldStoreElimination(fn);
+
       deadVariableElimination(fn);
 
       // 2014/10/17   Noakes and Elliot
@@ -484,6 +666,10 @@ void deadCodeElimination() {
 
     if (fReportDeadModules)
       printf("Removed %d dead modules.\n", deadModuleCount);
+
+    if (fReportDeadFields)
+      printf("Removed %d dead fields and %d dead field stores.\n",
+             deadFieldCount, deadFieldStoreCount);
   }
 }
 
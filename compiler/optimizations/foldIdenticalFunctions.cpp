@@ -0,0 +1,368 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "astutil.h"
+#include "CForLoop.h"
+#include "driver.h"
+#include "expr.h"
+#include "FnSymbol.h"
+#include "passes.h"
+#include "stlUtil.h"
+#include "stmt.h"
+#include "symbol.h"
+#include "virtualDispatch.h"
+#include "WhileStmt.h"
+
+#include <map>
+#include <set>
+#include <string>
+
+/*
+   Merge instantiations of generic functions whose generated code would
+   be the same.
+
+   Instantiations often end up with identical bodies once resolution is
+   done, e.g. ones over 'param' values the body never looks at, or ones
+   that only differ in types that were folded away.  This runs just
+   before codegen and gives each candidate function a key that spells
+   out its denormalized AST:
+
+     - the return type, return tag, flags and formals,
+     - every statement and expression in order, with each primitive,
+       block tag, goto tag and loop property that codegen looks at,
+     - symbols defined in the function numbered by first appearance,
+       along with their type, qualifier, intent and flags, and
+     - every other symbol by its id, and the function itself as "self".
+
+   Functions with equal keys generate the same code, so every call to a
+   later one is pointed at the first and the later one is removed.
+   Folding callees can make their callers' keys equal, so this repeats
+   until nothing changes.
+
+   Only functions that are called directly are folded: nothing that is
+   exported, extern, in a virtual method table or the function table,
+   or whose address is taken.
+
+   --report-fold-identical-functions notes each instantiation in a user
+   module that is folded away.
+ */
+
+struct FoldKey {
+  FoldKey(FnSymbol* fn) : fn(fn) { }
+
+  FnSymbol*              fn;
+  std::map<Symbol*, int> locals;
+  std::string            key;
+};
+
+static void appendInt(FoldKey& k, long value) {
+  k.key += std::to_string(value);
+  k.key += ' ';
+}
+
+static void appendFlags(FoldKey& k, const FlagSet& flags) {
+  k.key += "f ";
+
+  if (flags.any()) {
+    for (int flag = 0; flag < NUM_FLAGS; flag++) {
+      if (flags[flag])
+        appendInt(k, flag);
+    }
+  }
+
+  k.key += "; ";
+}
+
+static void appendType(FoldKey& k, Type* type) {
+  appendInt(k, type != NULL ? type->symbol->id : 0);
+}
+
+static bool appendSymbol(FoldKey& k, Symbol* sym) {
+  if (sym == NULL) {
+    k.key += "- ";
+
+  } else if (sym == k.fn) {
+    k.key += "self ";
+
+  } else if (sym->defPoint != NULL && sym->defPoint->parentSymbol == k.fn) {
+    std::map<Symbol*, int>::iterator it = k.locals.find(sym);
+
+    if (it != k.locals.end()) {
+      k.key += "L";
+      appendInt(k, it->second);
+
+    } else {
+      int index = k.locals.size();
+
+      k.locals[sym] = index;
+
+      k.key += "N";
+      appendInt(k, index);
+      appendInt(k, sym->astTag);
+      appendType(k, sym->type);
+      appendInt(k, sym->qual);
+      appendFlags(k, sym->flags);
+
+      if (ArgSymbol* arg = toArgSymbol(sym)) {
+        appendInt(k, arg->intent);
+
+      } else if (LabelSymbol* label = toLabelSymbol(sym)) {
+        if (label->iterResumeGoto != NULL)
+          return false;
+
+      } else if (isVarSymbol(sym) == false) {
+        return false;
+      }
+    }
+
+  } else {
+    k.key += "G";
+    appendInt(k, sym->id);
+  }
+
+  return true;
+}
+
+static bool appendExpr(FoldKey& k, Expr* expr);
+
+static bool appendList(FoldKey& k, AList& list) {
+  for_alist(expr, list) {
+    if (appendExpr(k, expr) == false)
+      return false;
+  }
+
+  k.key += ") ";
+
+  return true;
+}
+
+static bool appendBlock(FoldKey& k, BlockStmt* block) {
+  appendInt(k, block->blockTag);
+
+  if (block->isLoopStmt() == true) {
+    LoopStmt* loop = toLoopStmt(block);
+
+    appendInt(k, loop->isOrderIndependent());
+    appendInt(k, loop->hasVectorizationHazard());
+    appendInt(k, loop->hasParallelAccessVectorizationHazard());
+
+    if (appendSymbol(k, loop->breakLabelGet())    == false ||
+        appendSymbol(k, loop->continueLabelGet()) == false)
+      return false;
+
+    if (CForLoop* cfor = toCForLoop(block)) {
+      k.key += "for ";
+
+      if (appendExpr(k, cfor->initBlockGet()) == false ||
+          appendExpr(k, cfor->testBlockGet()) == false ||
+          appendExpr(k, cfor->incrBlockGet()) == false)
+        return false;
+
+    } else if (block->isWhileDoStmt() == true ||
+               block->isDoWhileStmt() == true) {
+      WhileStmt* loop = toWhileStmt(block);
+
+      k.key += block->isWhileDoStmt() ? "while " : "do ";
+
+      if (appendExpr(k, loop->condExprGet()) == false)
+        return false;
+
+    } else {
+      // Other loops should have been lowered by now
+      return false;
+    }
+
+  } else if (appendExpr(k, block->blockInfoGet()) == false) {
+    return false;
+  }
+
+  return appendList(k, block->body);
+}
+
+static bool appendExpr(FoldKey& k, Expr* expr) {
+  if (expr == NULL) {
+    k.key += "- ";
+    return true;
+  }
+
+  appendInt(k, expr->astTag);
+
+  switch (expr->astTag) {
+  case E_SymExpr:
+    return appendSymbol(k, toSymExpr(expr)->symbol());
+
+  case E_CallExpr: {
+    CallExpr* call = (CallExpr*) expr;
+
+    appendInt(k, call->primitive != NULL ? call->primitive->tag : -1);
+
+    if (appendExpr(k, call->baseExpr) == false)
+      return false;
+
+    return appendList(k, call->argList);
+  }
+
+  case E_DefExpr: {
+    DefExpr* def = toDefExpr(expr);
+
+    if (isFnSymbol(def->sym) || isTypeSymbol(def->sym))
+      return false;
+
+    return appendSymbol(k, def->sym) &&
+           appendExpr(k, def->init) &&
+           appendExpr(k, def->exprType);
+  }
+
+  case E_BlockStmt:
+    return appendBlock(k, toBlockStmt(expr));
+
+  case E_CondStmt: {
+    CondStmt* cond = toCondStmt(expr);
+
+    return appendExpr(k, cond->condExpr) &&
+           appendExpr(k, cond->thenStmt) &&
+           appendExpr(k, cond->elseStmt);
+  }
+
+  case E_GotoStmt: {
+    GotoStmt* gotoStmt = toGotoStmt(expr);
+
+    appendInt(k, gotoStmt->gotoTag);
+
+    return appendExpr(k, gotoStmt->label);
+  }
+
+  default:
+    return false;
+  }
+}
+
+// Returns false if 'fn' has something the key can't describe
+static bool buildKey(FoldKey& k) {
+  FnSymbol* fn = k.fn;
+
+  appendType(k, fn->retType);
+  appendInt(k, fn->retTag);
+  appendInt(k, fn->throwsError());
+  appendFlags(k, fn->flags);
+
+  for_formals(formal, fn) {
+    if (appendSymbol(k, formal) == false)
+      return false;
+  }
+
+  k.key += "| ";
+
+  return appendExpr(k, fn->body);
+}
+
+static bool isFoldCandidate(FnSymbol* fn, const std::set<FnSymbol*>& inVmt) {
+  if (fn->instantiatedFrom == NULL &&
+      fn->hasFlag(FLAG_INSTANTIATED_GENERIC) == false)
+    return false;
+
+  if (fn->hasFlag(FLAG_EXPORT)                    ||
+      fn->hasFlag(FLAG_EXTERN)                    ||
+      fn->hasFlag(FLAG_NO_FN_BODY)                ||
+      fn->hasFlag(FLAG_NO_CODEGEN)                ||
+      fn->hasFlag(FLAG_GEN_MAIN_FUNC)             ||
+      fn->hasFlag(FLAG_MODULE_INIT)               ||
+      fn->hasFlag(FLAG_ALWAYS_RESOLVE)            ||
+      fn->hasFlag(FLAG_VIRTUAL)                   ||
+      fn->hasFlag(FLAG_BEGIN_BLOCK)               ||
+      fn->hasFlag(FLAG_COBEGIN_OR_COFORALL_BLOCK) ||
+      fn->hasFlag(FLAG_ON_BLOCK))
+    return false;
+
+  if (inVmt.count(fn) != 0 || ftableMap.count(fn) != 0)
+    return false;
+
+  if (isModuleSymbol(fn->defPoint->parentSymbol) == false)
+    return false;
+
+  // Every mention of 'fn' must be a direct call of it
+  for_SymbolSymExprs(se, fn) {
+    CallExpr* call = toCallExpr(se->parentExpr);
+
+    if (call == NULL || call->baseExpr != se)
+      return false;
+  }
+
+  return true;
+}
+
+static void foldInto(FnSymbol* fn, FnSymbol* rep) {
+  if (fReportFoldIdenticalFunctions &&
+      (developer || fn->getModule()->modTag == MOD_USER)) {
+    USR_PRINT(fn, "Folded an instantiation of %s into an identical one",
+              toString(fn));
+  }
+
+  // Remove 'fn' first so that its own recursive calls go with it
+  fn->defPoint->remove();
+
+  for_SymbolSymExprs(se, fn) {
+    se->setSymbol(rep);
+  }
+}
+
+void foldIdenticalFunctions() {
+  typedef MapElem<Type*, Vec<FnSymbol*>*> VmtMapElem;
+
+  std::set<FnSymbol*> inVmt;
+  bool                changed = true;
+
+  if (fNoFoldIdenticalFunctions)
+    return;
+
+  form_Map(VmtMapElem, el, virtualMethodTable) {
+    if (el->value) {
+      forv_Vec(FnSymbol, fn, *el->value) {
+        inVmt.insert(fn);
+      }
+    }
+  }
+
+  while (changed == true) {
+    std::map<std::string, FnSymbol*> reps;
+
+    changed = false;
+
+    forv_Vec(FnSymbol, fn, gFnSymbols) {
+      if (isAlive(fn) == false || isFoldCandidate(fn, inVmt) == false)
+        continue;
+
+      FoldKey k(fn);
+
+      if (buildKey(k) == false)
+        continue;
+
+      std::map<std::string, FnSymbol*>::iterator it = reps.find(k.key);
+
+      if (it == reps.end()) {
+        reps[k.key] = fn;
+
+      } else {
+        foldInto(fn, it->second);
+        changed = true;
+      }
+    }
+  }
+}
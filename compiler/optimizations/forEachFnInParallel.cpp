@@ -0,0 +1,80 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "optimizations.h"
+
+#include "baseAST.h"
+#include "driver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+//
+// Run 'pass' on each function in 'fns', using up to --optimization-threads
+// threads that take the next unprocessed function from a shared index.
+//
+// 'pass' may only change the AST inside the function it is given, and may
+// not create or delete AST nodes; removed nodes are deleted later by
+// cleanAst().  Updates to shared state made through Symbol::addSymExpr()
+// and friends take the SharedAstLock.
+//
+static void runPassOnFns(std::vector<FnSymbol*>* fns,
+                         void                  (*pass)(FnSymbol* fn),
+                         std::atomic<size_t>*    next) {
+  size_t i = 0;
+
+  while ((i = next->fetch_add(1)) < fns->size()) {
+    pass((*fns)[i]);
+  }
+}
+
+void forEachFnInParallel(std::vector<FnSymbol*>& fns,
+                         void (*pass)(FnSymbol* fn)) {
+  size_t numThreads = optimizationThreads;
+
+  if (optimizationThreads <= 0) {
+    numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  numThreads = std::min(numThreads, fns.size());
+
+  if (numThreads <= 1) {
+    for (size_t i = 0; i < fns.size(); i++) {
+      pass(fns[i]);
+    }
+
+  } else {
+    std::atomic<size_t>      next(0);
+    std::vector<std::thread> threads;
+
+    gAstThreadsActive = true;
+
+    for (size_t i = 0; i < numThreads; i++) {
+      threads.push_back(std::thread(runPassOnFns, &fns, pass, &next));
+    }
+
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads[i].join();
+    }
+
+    gAstThreadsActive = false;
+  }
+}
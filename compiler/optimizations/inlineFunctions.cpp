@@ -27,11 +27,15 @@
 #include "stlUtil.h"
 #include "stmt.h"
 #include "stringutil.h"
+#include "virtualDispatch.h"
 
+#include <climits>
+#include <map>
 #include <set>
 #include <vector>
 
 static void updateRefCalls();
+static void markSmallFunctionsInline();
 static void inlineFunctionsImpl();
 static void inlineFunction(FnSymbol* fn, std::set<FnSymbol*>& inlinedSet);
 static void inlineCall(CallExpr* call);
@@ -52,6 +56,9 @@ void inlineFunctions() {
 
   updateRefCalls();
 
+  if (fNoInline == false && inlineSizeThreshold > 0)
+    markSmallFunctionsInline();
+
   inlineFunctionsImpl();
 
   updateDerefCalls();
@@ -59,6 +66,149 @@ void inlineFunctions() {
   inlineCleanup();
 }
 
+/************************************* | **************************************
+*                                                                             *
+* With --inline-size-threshold, mark small functions with the inline flag so  *
+* that accessors, 'this' methods and the like don't cost a call in hot loops. *
+*                                                                             *
+* The size of a function is the number of calls and primitives in its body,   *
+* with calls to functions it will have inlined counted at their size.  A      *
+* function is marked once everything it calls is extern or inlined, working   *
+* up from the leaves until nothing changes, so a recursive cycle is never     *
+* marked and inlineBody() won't complain about one.                           *
+*                                                                             *
+************************************** | *************************************/
+
+static bool isInlineCandidate(FnSymbol* fn, std::set<FnSymbol*>& virtuals);
+static int  inlinedSize(FnSymbol* fn, std::map<FnSymbol*, int>& sizes);
+
+static void markSmallFunctionsInline() {
+  std::set<FnSymbol*>      virtuals;
+  std::vector<FnSymbol*>   candidates;
+  std::map<FnSymbol*, int> sizes;
+  bool                     changed = true;
+
+  for (int i = 0; i < virtualMethodTable.n; i++) {
+    if (virtualMethodTable.v[i].key) {
+      Vec<FnSymbol*>* fns = virtualMethodTable.v[i].value;
+
+      for (int j = 0; j < fns->n; j++)
+        virtuals.insert(fns->v[j]);
+    }
+  }
+
+  forv_Vec(FnSymbol, fn, gFnSymbols) {
+    if (isInlineCandidate(fn, virtuals) == true)
+      candidates.push_back(fn);
+  }
+
+  while (changed == true) {
+    changed = false;
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+      FnSymbol* fn = candidates[i];
+
+      if (fn->hasFlag(FLAG_INLINE) == false &&
+          inlinedSize(fn, sizes) <= inlineSizeThreshold) {
+        fn->addFlag(FLAG_INLINE);
+        changed = true;
+
+        if (fReportAutoInline &&
+            (developer || printsUserLocation(fn))) {
+          int nCalls = fn->calledBy->n;
+
+          USR_PRINT(fn, "inlining '%s' (size %d) at %d call site%s",
+                    fn->name, sizes[fn], nCalls, nCalls == 1 ? "" : "s");
+        }
+      }
+    }
+  }
+}
+
+static bool isInlineCandidate(FnSymbol* fn, std::set<FnSymbol*>& virtuals) {
+  ModuleSymbol* mod = fn->getModule();
+
+  if (fn->hasFlag(FLAG_INLINE)                          ||
+      fn->hasFlag(FLAG_EXTERN)                          ||
+      fn->hasFlag(FLAG_EXPORT)                          ||
+      fn->hasFlag(FLAG_NO_FN_BODY)                      ||
+      fn->hasFlag(FLAG_VIRTUAL)                         ||
+      fn->hasFlag(FLAG_GEN_MAIN_FUNC)                   ||
+      fn->hasFlag(FLAG_ITERATOR_FN)                     ||
+      fn->hasFlag(FLAG_FIRST_CLASS_FUNCTION_INVOCATION) ||
+      fn->hasFlag(FLAG_ON_BLOCK)                        ||
+      fn->hasFlag(FLAG_BEGIN_BLOCK)                     ||
+      fn->hasFlag(FLAG_COBEGIN_OR_COFORALL_BLOCK)       ||
+      isTaskFun(fn)                                     ||
+      virtuals.count(fn) != 0                           ||
+      fn == mod->initFn                                 ||
+      fn == mod->deinitFn                               ||
+      fn->calledBy == NULL                              ||
+      fn->calledBy->n == 0) {
+    return false;
+  }
+
+  // Every mention of the function has to be a call to it, since it is
+  // removed once it has been inlined.
+  for_SymbolSymExprs(se, fn) {
+    CallExpr* call = toCallExpr(se->parentExpr);
+
+    if (call == NULL || call->baseExpr != se)
+      return false;
+  }
+
+  // The inlined body uses the actuals in place of the formals, so a
+  // function can't assign to a formal that isn't a reference.
+  for_formals(formal, fn) {
+    if (formal->isRef() == false) {
+      for_SymbolSymExprs(se, formal) {
+        if (isDefAndOrUse(se) & 1)
+          return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// Returns INT_MAX until everything fn calls is extern or inlined.
+static int inlinedSize(FnSymbol* fn, std::map<FnSymbol*, int>& sizes) {
+  std::vector<CallExpr*> calls;
+  int                    size = 0;
+
+  collectCallExprs(fn->body, calls);
+
+  for_vector(CallExpr, call, calls) {
+    if (call->isPrimitive() == true) {
+      if (call->isPrimitive(PRIM_VIRTUAL_METHOD_CALL))
+        return INT_MAX;
+
+      size++;
+
+    } else if (FnSymbol* calledFn = call->resolvedFunction()) {
+      if (calledFn->hasFlag(FLAG_EXTERN) == true) {
+        size++;
+
+      } else if (calledFn->hasFlag(FLAG_INLINE) == true) {
+        std::map<FnSymbol*, int>::iterator it = sizes.find(calledFn);
+
+        // functions that were inline to begin with count as a call
+        size += (it != sizes.end()) ? it->second : 1;
+
+      } else {
+        return INT_MAX;
+      }
+
+    } else {
+      return INT_MAX;
+    }
+  }
+
+  sizes[fn] = size;
+
+  return size;
+}
+
 /************************************* | **************************************
 *                                                                             *
 * inline all functions with the inline flag                                   *
@@ -36,6 +36,7 @@
 #include "symbol.h"
 #include "timer.h"
 #include "optimizations.h"
+#include "virtualDispatch.h"
 #include "WhileStmt.h"
 
 #include <algorithm>
@@ -77,6 +78,10 @@ Timer overallTimer;
 
 #define MAX_NUM_ALIASES 200000
 
+// Functions that may write a field for which isInvariantField() is true,
+// directly or through something they call
+static std::set<FnSymbol*> invariantFieldWriters;
+
 //TODO The alias analysis is extremely conservative. Beyond possibly not hoisting
 //things that can be, it is also a performance issue because you have a lot more
 //definitions to consider before declaration something invariant.
@@ -213,7 +218,7 @@ typedef std::map<Symbol*,std::vector<SymExpr*>*> symToVecSymExprMap;
 
 //These two functions are used to collect all natural loops from a bunch of basic blocks and ensure the loops are stored
 //from most nested to least nested for any give loop nest
-void collectNaturalLoops(std::vector<Loop*>& loops, BasicBlocks& basicBlocks, BasicBlock* entryBlock, std::vector<BitVec*>& dominators);
+void collectNaturalLoops(std::vector<Loop*>& loops, BasicBlocks& basicBlocks, BasicBlock* entryBlock, const DominatorTree& dominators);
 void collectNaturalLoopForEdge(Loop* loop, BasicBlock* header, BasicBlock* tail);
 
 
@@ -235,7 +240,7 @@ void collectNaturalLoopForEdge(Loop* loop, BasicBlock* header, BasicBlock* tail)
  * given nested loop structure the most nested one is guaranteed to appear before (closer to
  * index 0) than the more outer loops.)
  */
-void collectNaturalLoops(std::vector<Loop*>& loops, BasicBlocks& basicBlocks, BasicBlock* entryBlock, std::vector<BitVec*>& dominators) {
+void collectNaturalLoops(std::vector<Loop*>& loops, BasicBlocks& basicBlocks, BasicBlock* entryBlock, const DominatorTree& dominators) {
 
   for_vector(BasicBlock, block, basicBlocks) {
     //Skip entry blocks
@@ -246,7 +251,7 @@ void collectNaturalLoops(std::vector<Loop*>& loops, BasicBlocks& basicBlocks, Ba
     //for each successor
     for_vector(BasicBlock, successor, block->outs) {
       //if the successor dominates the block, block is a back-edge and successor is a header
-      if(dominates(successor->id, block->id, dominators)) {
+      if(dominators.dominates(successor->id, block->id)) {
         //check if this loop shares a header with any previous one, and if so combine them into one
         bool sharedHeader = false;
         for_vector(Loop, loop, loops) {
@@ -458,6 +463,91 @@ static bool isLoopInvariantPrimitive(PrimitiveOp* primitiveOp)
 }
 
 
+/*
+ * Some fields of the array and domain implementations only change when
+ * the object is initialized or reallocated, and are read on every access.
+ * Loops that don't call anything that could write them can treat them
+ * as invariant even though the loop passes the object to other calls.
+ */
+static bool isInvariantField(Symbol* sym) {
+  if (sym->hasFlag(FLAG_INVARIANT_FIELD))
+    return true;
+
+  TypeSymbol* ts = toTypeSymbol(sym->defPoint->parentSymbol);
+  if (ts == NULL)
+    return false;
+
+  // The array/domain/distribution wrapper records have fields that do
+  // not vary (see remoteValueForwarding.cpp)
+  if (isRecordWrappedType(ts->type))
+    return strcmp(sym->name, "_instance") == 0;
+
+  // The indexing metadata of DefaultRectangular arrays
+  const char* drArrName = "DefaultRectangularArr";
+  if (strncmp(ts->name, drArrName, strlen(drArrName)) == 0) {
+    return strcmp(sym->name, "data") == 0 ||
+           strcmp(sym->name, "shiftedData") == 0 ||
+           strcmp(sym->name, "off") == 0 ||
+           strcmp(sym->name, "blk") == 0 ||
+           strcmp(sym->name, "str") == 0 ||
+           strcmp(sym->name, "factoredOffs") == 0;
+  }
+
+  return false;
+}
+
+static bool isInvariantFieldAccess(CallExpr* call) {
+  if (call->isPrimitive(PRIM_GET_MEMBER_VALUE) ||
+      call->isPrimitive(PRIM_GET_MEMBER) ||
+      call->isPrimitive(PRIM_SET_MEMBER)) {
+    if (SymExpr* se = toSymExpr(call->get(2)))
+      return isInvariantField(se->symbol());
+  }
+  return false;
+}
+
+/*
+ * A function writes an invariant field if it sets it or takes its address,
+ * if it mentions a function that does, or if it is overridden by one.
+ */
+static void computeInvariantFieldWriters() {
+  std::vector<FnSymbol*> workList;
+
+  invariantFieldWriters.clear();
+
+  forv_Vec(CallExpr, call, gCallExprs) {
+    if (call->inTree() &&
+        !call->isPrimitive(PRIM_GET_MEMBER_VALUE) &&
+        isInvariantFieldAccess(call)) {
+      if (FnSymbol* fn = toFnSymbol(call->parentSymbol)) {
+        if (invariantFieldWriters.insert(fn).second)
+          workList.push_back(fn);
+      }
+    }
+  }
+
+  while (!workList.empty()) {
+    FnSymbol* fn = workList.back();
+    workList.pop_back();
+
+    std::vector<FnSymbol*> users;
+    for_SymbolSymExprs(se, fn) {
+      if (FnSymbol* user = toFnSymbol(se->parentSymbol))
+        users.push_back(user);
+    }
+    if (Vec<FnSymbol*>* parents = virtualParentsMap.get(fn)) {
+      forv_Vec(FnSymbol, parent, *parents) {
+        users.push_back(parent);
+      }
+    }
+
+    for_vector(FnSymbol, user, users) {
+      if (invariantFieldWriters.insert(user).second)
+        workList.push_back(user);
+    }
+  }
+}
+
 /*
  * Simple function to check if a symExpr is constant
  */
@@ -551,11 +641,17 @@ static void buildLocalDefUseMaps(Loop* loop, symToVecSymExprMap& localDefMap, sy
             if(CallExpr* callExpr = toCallExpr(symExpr->parentExpr)) {
               if(callExpr->isResolved() || callExpr->isPrimitive(PRIM_VIRTUAL_METHOD_CALL)) {
                 addDefOrUse(localDefMap, symExpr->symbol(), symExpr);
+                FnSymbol* calledFn = callExpr->resolvedOrVirtualFunction();
+                bool mayWriteInvariantFields = calledFn == NULL ||
+                  invariantFieldWriters.count(calledFn) != 0;
                 Type* type = symExpr->symbol()->type->symbol->type;
                 if(AggregateType* curClass = toAggregateType(type)) {
                   for_alist(classField, curClass->fields) {
                     if(DefExpr* classFieldDef = toDefExpr(classField)) {
-                      addDefOrUse(localDefMap, classFieldDef->sym, symExpr);
+                      if(mayWriteInvariantFields ||
+                         !isInvariantField(classFieldDef->sym)) {
+                        addDefOrUse(localDefMap, classFieldDef->sym, symExpr);
+                      }
                     }
                   }
                 }
@@ -952,6 +1048,20 @@ static void computeLoopInvariants(std::vector<SymExpr*>& loopInvariants,
         mightHaveBeenDeffedElseWhere = true;
       }
     }
+    // A ref to a record only matters here when it is used to read an
+    // invariant field, and those are only written by the defs counted
+    // above (see isInvariantField).
+    if (mightHaveBeenDeffedElseWhere &&
+        !isModuleSymbol(defScope) &&
+        isRecord(symExpr->getValType())) {
+      if (CallExpr* call = toCallExpr(symExpr->parentExpr)) {
+        if (call->isPrimitive(PRIM_GET_MEMBER_VALUE) &&
+            call->get(1) == symExpr &&
+            isInvariantFieldAccess(call)) {
+          mightHaveBeenDeffedElseWhere = false;
+        }
+      }
+    }
     //if there were no defs of the symbol, it is invariant
     if(actualDefs.count(symExpr) == 0 && !mightHaveBeenDeffedElseWhere) {
       loopInvariantOperands.insert(symExpr);
@@ -1030,7 +1140,7 @@ static void computeLoopInvariants(std::vector<SymExpr*>& loopInvariants,
  * because that would have the effect of executing first = false before the use.
  *
  */
-static bool defDominatesAllUses(Loop* loop, SymExpr* def, std::vector<BitVec*>& dominators, std::map<SymExpr*, int>& localMap, symToVecSymExprMap& localUseMap) {
+static bool defDominatesAllUses(Loop* loop, SymExpr* def, const DominatorTree& dominators, std::map<SymExpr*, int>& localMap, symToVecSymExprMap& localUseMap) {
 
   if(localUseMap.count(def->symbol()) == 0 ) {
     return false;
@@ -1039,7 +1149,7 @@ static bool defDominatesAllUses(Loop* loop, SymExpr* def, std::vector<BitVec*>&
   int defBlock = localMap[def];
 
   for_vector(SymExpr, symExpr, *localUseMap[def->symbol()]) {
-    if(dominates(defBlock, localMap[symExpr], dominators) == false) {
+    if(dominators.dominates(defBlock, localMap[symExpr]) == false) {
       return false;
     }
   }
@@ -1064,14 +1174,14 @@ static bool defDominatesAllUses(Loop* loop, SymExpr* def, std::vector<BitVec*>&
  * where it may be used.
  *
  */
-static bool defDominatesAllExits(Loop* loop, SymExpr* def, std::vector<BitVec*>& dominators, std::map<SymExpr*, int>& localMap) {
+static bool defDominatesAllExits(Loop* loop, SymExpr* def, const DominatorTree& dominators, std::map<SymExpr*, int>& localMap) {
   int defBlock = localMap[def];
 
   BitVec* bitExits = loop->getBitExits();
 
   for(size_t i = 0; i < bitExits->size(); i++) {
     if(bitExits->test(i)) {
-      if(dominates(defBlock, i, dominators) == false) {
+      if(dominators.dominates(defBlock, i) == false) {
         return false;
       }
     }
@@ -1178,17 +1288,11 @@ static long licmFn(FnSymbol* fn) {
 
   BasicBlock* entryBlock = basicBlocks[0];
 
-  unsigned nBlocks = basicBlocks.size();
-
   stopTimer(buildBBTimer);
 
   //compute the dominators
   startTimer(computeDominatorTimer);
-  std::vector<BitVec*> dominators;
-  for(unsigned i = 0; i < nBlocks; i++) {
-    dominators.push_back(new BitVec(nBlocks));
-  }
-  computeDominators(dominators, basicBlocks);
+  DominatorTree dominators(basicBlocks);
   stopTimer(computeDominatorTimer);
 
   //Collect all of the loops
@@ -1252,11 +1356,6 @@ static long licmFn(FnSymbol* fn) {
     loop = 0;
   }
 
-  for_vector(BitVec, bitVec, dominators) {
-    delete bitVec;
-    bitVec = 0;
-  }
-
   return numLoops;
 }
 
@@ -1269,12 +1368,15 @@ void loopInvariantCodeMotion(void) {
   optimizeForallUnorderedOps();
 
   if(fNoLoopInvariantCodeMotion) {
+    strengthReduceLoops();
     return;
   }
 
   startTimer(overallTimer);
   long numLoops = 0;
 
+  computeInvariantFieldWriters();
+
   //TODO use stl routine here
   forv_Vec(FnSymbol, fn, gFnSymbols) {
     numLoops += licmFn(fn);
@@ -1282,6 +1384,9 @@ void loopInvariantCodeMotion(void) {
 
   stopTimer(overallTimer);
 
+  // after hoisting, so more of the index arithmetic operands are invariant
+  strengthReduceLoops();
+
 #ifdef detailedTiming
   FILE *timingFile;
   FILE *maxTimeFile;
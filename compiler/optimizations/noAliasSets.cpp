@@ -456,7 +456,7 @@ void addNoAliasSetsInFn(FnSymbol* fn) {
               }
             }
           }
-          // TODO: check for chpl_privateObjects[objectPid]
+          // TODO: check for chpl_getPrivatizedClass(objectPid)
           //  -- this should propagate from the _array record
           //     from which we got the id, if present
         } else {
@@ -35,6 +35,8 @@
 #include "virtualDispatch.h"
 #include "wellknown.h"
 
+#include <map>
+#include <set>
 #include <stack>
 
 /*
@@ -56,7 +58,21 @@
    also complete in any order.
 
    This handles PRIM_ASSIGN as well as several chpl_comm_atomic functions
-   by converting them to unordered calls within the runtime.
+   by converting them to unordered calls within the runtime. The runtime
+   buffers unordered PUTs and atomics per task and per destination and
+   flushes them at task end and at the fence after the forall, so this is
+   what aggregates fine-grained remote writes in foralls.
+
+   An assignment is converted when its right-hand side is a reference,
+   which becomes an unordered GET+PUT, or a plain value such as the result
+   of a computation, which becomes an unordered PUT of that value. The
+   runtime copies the value when the PUT is issued.
+
+   Only the last statements can be converted: an earlier write in the
+   iteration could be read, or written again, by a later statement, and
+   telling whether that is the case would need alias analysis we don't
+   have. A read-modify-write like A[B[i]] += 1 reads its target first, so
+   it is only converted when written as an atomic add.
 
    It could handle PRIM_ARRAY_SET_FIRST as well if that becomes
    important in the future.
@@ -756,7 +772,7 @@ static const char* getUnorderedAtomicFunction(const char* cname) {
 // cname -> FnSymbol*
 static std::map<const char*, FnSymbol*> atomicFns;
 
-static void transformAtomicStmt(Expr* stmt) {
+static bool transformAtomicStmt(Expr* stmt) {
   CallExpr* call = toCallExpr(stmt);
   FnSymbol* oldFn = call->resolvedFunction();
   const char* newFnCName = getUnorderedAtomicFunction(oldFn->cname);
@@ -769,7 +785,7 @@ static void transformAtomicStmt(Expr* stmt) {
   // to test the compiler optimization but there is no
   // runtime support / value in the optimization
   if (newFnCName == NULL)
-    return;
+    return false;
 
   // Now lookup up newFn in the map
   if (atomicFns.count(newFnCName) > 0) {
@@ -855,6 +871,7 @@ static void transformAtomicStmt(Expr* stmt) {
   INT_ASSERT(se && se->symbol() == oldFn);
   se->setSymbol(newFn);
 
+  return true;
 }
 
 static bool isOptimizableAssignStmt(Expr* stmt, BlockStmt* loop) {
@@ -876,7 +893,24 @@ static bool isOptimizableAssignStmt(Expr* stmt, BlockStmt* loop) {
 }
 
 
-static void transformAssignStmt(Expr* stmt) {
+// Can 'rhs' be the source of an unordered PUT?  It has to be a value
+// with an address; the runtime copies it when the PUT is issued.
+static bool isUnorderedPutSource(Expr* rhs) {
+  if (SymExpr* se = toSymExpr(rhs)) {
+    Symbol* sym = se->symbol();
+
+    if (sym->isRef() == false && isLcnSymbol(sym)) {
+      if (VarSymbol* var = toVarSymbol(sym))
+        return var->immediate == NULL;
+      else
+        return true;
+    }
+  }
+
+  return false;
+}
+
+static bool transformAssignStmt(Expr* stmt) {
   SET_LINENO(stmt);
 
   CallExpr* call = toCallExpr(stmt);
@@ -935,6 +969,44 @@ static void transformAssignStmt(Expr* stmt) {
     call->remove();
     if (callToRemove)
       callToRemove->remove();
+
+    return true;
+
+  } else if (lhs->isRef() &&
+             isUnorderedPutSource(call->get(2)) &&
+             call->get(2)->typeInfo() == lhs->getValType()) {
+    // a computed value stored through a reference: an unordered put
+    if (fReportOptimizeForallUnordered) {
+      if (developer || printsUserLocation(call)) {
+        USR_PRINT(call, "Optimized assign of a value to be unordered");
+      }
+    }
+
+    call->insertBefore(new CallExpr(PRIM_UNORDERED_ASSIGN, lhs,
+                                    call->get(2)->copy()));
+    call->remove();
+
+    return true;
+  }
+
+  return false;
+}
+
+// Report each loop that had statements converted, once per source line
+// since the follower and fast follower bodies of a forall share one.
+static void reportOptimizedLoops(std::map<LoopStmt*, int>& loopCounts) {
+  std::set<std::pair<const char*, int> > reported;
+  std::map<LoopStmt*, int>::iterator it;
+
+  for (it = loopCounts.begin(); it != loopCounts.end(); ++it) {
+    LoopStmt* loop = it->first;
+    std::pair<const char*, int> loc(loop->fname(), loop->linenum());
+
+    if ((developer || printsUserLocation(loop)) &&
+        reported.insert(loc).second) {
+      USR_PRINT(loop, "Optimized %d statement%s in this loop to be unordered",
+                it->second, it->second == 1 ? "" : "s");
+    }
   }
 }
 
@@ -966,8 +1038,11 @@ void optimizeForallUnorderedOps() {
     }
   }
 
-  std::vector<Expr*> atomicsToOptimize;
-  std::vector<Expr*> assignsToOptimize;
+  std::vector<Expr*>       atomicsToOptimize;
+  std::vector<Expr*>       assignsToOptimize;
+  std::vector<LoopStmt*>   atomicLoops;
+  std::vector<LoopStmt*>   assignLoops;
+  std::map<LoopStmt*, int> loopCounts;
 
   // Gather expressions to optimize. This is done separately from
   // doing the transformation so that the transformation itself does
@@ -982,20 +1057,28 @@ void optimizeForallUnorderedOps() {
         std::vector<Expr*> lastStmts;
         getLastStmts(loop, lastStmts);
         for_vector(Expr, lastStmt, lastStmts) {
-          if (isOptimizableAtomicStmt(lastStmt, loop))
+          if (isOptimizableAtomicStmt(lastStmt, loop)) {
             atomicsToOptimize.push_back(lastStmt);
-          else if (isOptimizableAssignStmt(lastStmt, loop))
+            atomicLoops.push_back(loop);
+          } else if (isOptimizableAssignStmt(lastStmt, loop)) {
             assignsToOptimize.push_back(lastStmt);
+            assignLoops.push_back(loop);
+          }
         }
       }
     }
   }
 
   // Now apply the transformation
-  for_vector(Expr, atomic, atomicsToOptimize) {
-    transformAtomicStmt(atomic);
+  for (size_t i = 0; i < atomicsToOptimize.size(); i++) {
+    if (transformAtomicStmt(atomicsToOptimize[i]))
+      loopCounts[atomicLoops[i]]++;
   }
-  for_vector(Expr, assign, assignsToOptimize) {
-    transformAssignStmt(assign);
+  for (size_t i = 0; i < assignsToOptimize.size(); i++) {
+    if (transformAssignStmt(assignsToOptimize[i]))
+      loopCounts[assignLoops[i]]++;
   }
+
+  if (fReportOptimizeForallUnordered)
+    reportOptimizedLoops(loopCounts);
 }
@@ -32,8 +32,12 @@
 #include "expr.h"
 #include "stlUtil.h"
 #include "stmt.h"
+#include "stringutil.h"
 #include "wellknown.h"
 
+#include <algorithm>
+#include <cstring>
+#include <map>
 #include <vector>
 
 
@@ -149,6 +153,8 @@ classifyPrimitive(CallExpr *call) {
   case PRIM_CAST:
 
   case PRIM_ON_LOCALE_NUM:
+  case PRIM_COFORALL_TREE_NUM_CHILDREN:
+  case PRIM_COFORALL_TREE_CHILD:
   case PRIM_GET_SERIAL:
   case PRIM_SET_SERIAL:
 
@@ -367,34 +373,91 @@ inLocalBlock(CallExpr *call) {
   return false;
 }
 
+//
+// Interprocedural summaries.  Each function is classified once, ignoring
+// the call depth limit, and the result is reused by every caller.  The
+// summary also records the longest chain of calls below the function,
+// so that --optimize-on-clause-limit can still be applied per caller, and
+// why the function is not fast, for --report-optimized-on.
+//
+struct FastOnSummary {
+  int         is;       // FAST_AND_LOCAL etc., ignoring the depth limit
+  int         height;   // longest call chain below this function
+  const char* reason;   // why this isn't FAST_AND_LOCAL, or NULL
+};
+
+static std::map<FnSymbol*, FastOnSummary> fastOnSummaries;
+
+static FastOnSummary
+makeSummary(int is, int height, const char* reason) {
+  FastOnSummary ret = { is, height, reason };
+  return ret;
+}
+
+//
+// Classify runtime functions that the modules declare extern without
+// one of the fast-on pragmas.  Processor atomics are fast unless they
+// are implemented with locks, and memory allocation is local even
+// though it may take a lock.
+//
 static int
-markFastSafeFn(FnSymbol *fn, int recurse, std::set<FnSymbol*>& visited) {
+classifyRuntimeExtern(FnSymbol* fn, const char** reason) {
+  const char* name = fn->cname;
 
-  // First, handle functions we've already visited.
-  if (visited.count(fn) != 0) {
-    if (fn->hasFlag(FLAG_FAST_ON))
-      return FAST_AND_LOCAL;
-    if (fn->hasFlag(FLAG_LOCAL_FN))
+  if (!strncmp(name, "atomic_", 7)) {
+    if (CHPL_ATOMICS != NULL && !strcmp(CHPL_ATOMICS, "locks")) {
+      *reason = "uses processor atomics, which take a lock";
       return LOCAL_NOT_FAST;
-    return NOT_FAST_NOT_LOCAL;
+    }
+    return FAST_AND_LOCAL;
   }
 
-  // Now, add fn to the set of visited functions,
-  // since we will categorize it now.
-  visited.insert(fn);
+  if (!strcmp(name, "chpl_memcpy") || !strcmp(name, "chpl_memmove") ||
+      !strcmp(name, "memcpy") || !strcmp(name, "memmove"))
+    return FAST_AND_LOCAL;
 
-  // Next, classify extern functions
+  if (!strncmp(name, "chpl_mem_", 9)) {
+    *reason = "allocates memory";
+    return LOCAL_NOT_FAST;
+  }
+
+  *reason = astr("calls extern function ", fn->name);
+  return NOT_FAST_NOT_LOCAL;
+}
+
+static FastOnSummary
+computeFastOnSummary(FnSymbol* fn);
+
+static const FastOnSummary&
+summarizeFn(FnSymbol* fn) {
+  std::map<FnSymbol*, FastOnSummary>::iterator it = fastOnSummaries.find(fn);
+
+  if (it != fastOnSummaries.end())
+    return it->second;
+
+  // Calls that get back here before the summary is done are recursive.
+  // Treat them conservatively.
+  FastOnSummary& summary = fastOnSummaries[fn];
+  summary = makeSummary(NOT_FAST_NOT_LOCAL, 0,
+                        astr("calls ", fn->name, " recursively"));
+  summary = computeFastOnSummary(fn);
+
+  return summary;
+}
+
+static FastOnSummary
+computeFastOnSummary(FnSymbol* fn) {
+  // First, classify extern functions
   if (fn->hasFlag(FLAG_EXTERN)) {
     if (fn->hasFlag(FLAG_FAST_ON_SAFE_EXTERN)) {
-      // Make sure the FAST_ON and LOCAL_FN flags are set.
-      fn->addFlag(FLAG_FAST_ON);
-      fn->addFlag(FLAG_LOCAL_FN);
-      return FAST_AND_LOCAL;
+      return makeSummary(FAST_AND_LOCAL, 0, NULL);
     } else if(fn->hasFlag(FLAG_LOCAL_FN)) {
-      return LOCAL_NOT_FAST;
+      return makeSummary(LOCAL_NOT_FAST, 0,
+                         astr("calls extern function ", fn->name));
     } else {
-      // Other extern functions are not fast or local.
-      return NOT_FAST_NOT_LOCAL;
+      const char* reason = NULL;
+      int is = classifyRuntimeExtern(fn, &reason);
+      return makeSummary(is, 0, reason);
     }
   }
 
@@ -405,9 +468,13 @@ markFastSafeFn(FnSymbol *fn, int recurse, std::set<FnSymbol*>& visited) {
   // We will return NOT_FAST_NOT_LOCAL immediately if we see something
   // in the function that is not local.
   bool maybefast = true;
+  const char* reason = NULL;
+  int height = 0;
 
-  if (fn->hasFlag(FLAG_NON_BLOCKING))
+  if (fn->hasFlag(FLAG_NON_BLOCKING)) {
     maybefast = false;
+    reason = "is non-blocking";
+  }
 
   std::vector<CallExpr*> calls;
 
@@ -421,76 +488,102 @@ markFastSafeFn(FnSymbol *fn, int recurse, std::set<FnSymbol*>& visited) {
 
       if (!isLocal(is)) {
         // FAST_NOT_LOCAL or NOT_FAST_NOT_LOCAL
-        return NOT_FAST_NOT_LOCAL;
+        return makeSummary(NOT_FAST_NOT_LOCAL, height,
+                           astr("uses '", call->primitive->name,
+                                "', which communicates"));
       }
 
       // is == FAST_AND_LOCAL requires no action
-      if (is == LOCAL_NOT_FAST) {
+      if (is == LOCAL_NOT_FAST && maybefast) {
         maybefast = false;
+        reason = astr("uses '", call->primitive->name, "', which may block");
       }
 
+    } else if (!call->isResolved()) {
+      // No indirect calls allowed
+      return makeSummary(NOT_FAST_NOT_LOCAL, height,
+                         "makes an indirect call");
+
     } else {
-      if (recurse<=0 || !call->isResolved()) {
-        // didn't resolve or past too much recursion.
-        // No function calls allowed
-        return NOT_FAST_NOT_LOCAL;
-
-      } else {
-        // Handle nested 'on' statements
-        if (call->resolvedFunction()->hasFlag(FLAG_ON_BLOCK)) {
-          if (inLocal) {
-            maybefast = false;
-          } else {
-            return NOT_FAST_NOT_LOCAL;
-          }
+      FnSymbol* callee = call->resolvedFunction();
+
+      // Handle nested 'on' statements
+      if (callee->hasFlag(FLAG_ON_BLOCK)) {
+        if (!inLocal) {
+          return makeSummary(NOT_FAST_NOT_LOCAL, height,
+                             "contains an on statement");
+        }
+        if (maybefast) {
+          maybefast = false;
+          reason = "contains an on statement";
         }
+      }
 
-        // is the call to a fast/local function?
-        int is = markFastSafeFn(call->resolvedFunction(),
-                                recurse - 1,
-                                visited);
+      // is the call to a fast/local function?
+      const FastOnSummary& summary = summarizeFn(callee);
 
-        // Remove NOT_LOCAL parts if it's in a local block
-        is = setLocal(is, inLocal);
+      height = std::max(height, summary.height + 1);
 
-        if (!isLocal(is)) {
-          return NOT_FAST_NOT_LOCAL;
-        }
+      // Remove NOT_LOCAL parts if it's in a local block
+      int is = setLocal(summary.is, inLocal);
 
-        if (is == LOCAL_NOT_FAST) {
-          maybefast = false;
-        }
-        // otherwise, possibly still fast.
+      if (!isLocal(is)) {
+        return makeSummary(NOT_FAST_NOT_LOCAL, height,
+                           astr("calls ", callee->name, ", which ",
+                                summary.reason));
       }
+
+      if (is == LOCAL_NOT_FAST && maybefast) {
+        maybefast = false;
+        reason = astr("calls ", callee->name, ", which ", summary.reason);
+      }
+      // otherwise, possibly still fast.
     }
   }
 
   // Loops can have arbitrary trip counts, don't consider fast
-  std::vector<Expr*> stmts;
-  collect_stmts(fn->body, stmts);
-  for_vector(Expr, stmt, stmts) {
-    if (BlockStmt* block = toBlockStmt(stmt)) {
-      if (block->isLoopStmt()) {
-        maybefast = false;
-        break;
+  if (maybefast) {
+    std::vector<Expr*> stmts;
+    collect_stmts(fn->body, stmts);
+    for_vector(Expr, stmt, stmts) {
+      if (BlockStmt* block = toBlockStmt(stmt)) {
+        if (block->isLoopStmt()) {
+          maybefast = false;
+          reason = "contains a loop";
+          break;
+        }
       }
     }
   }
 
   // At this point we've considered all of the function body
   // so if maybefast is still true, we can consider this function fast.
-
   // We only get to this point if the function is local
   // (otherwise we would return above)
-  fn->addFlag(FLAG_LOCAL_FN);
+  if (maybefast)
+    return makeSummary(FAST_AND_LOCAL, height, NULL);
+  else
+    return makeSummary(LOCAL_NOT_FAST, height, reason);
+}
 
-  if (maybefast) {
-    fn->addFlag(FLAG_FAST_ON);
+static int
+markFastSafeFn(FnSymbol *fn, int recurse, const char** reason) {
+  const FastOnSummary& summary = summarizeFn(fn);
 
-    return FAST_AND_LOCAL;
-  } else {
-    return LOCAL_NOT_FAST;
+  *reason = summary.reason;
+
+  if (summary.height > recurse) {
+    *reason = "has calls nested deeper than --optimize-on-clause-limit";
+    return NOT_FAST_NOT_LOCAL;
   }
+
+  if (isLocal(summary.is))
+    fn->addFlag(FLAG_LOCAL_FN);
+
+  if (summary.is == FAST_AND_LOCAL)
+    fn->addFlag(FLAG_FAST_ON);
+
+  return summary.is;
 }
 
 // Removes PRIM_START_RMEM_FENCE and PRIM_FINISH_RMEM_FENCE
@@ -585,9 +678,9 @@ optimizeOnClauses(void) {
   compute_call_sites();
 
   forv_Vec(FnSymbol, fn, gFnSymbols) {
-    std::set<FnSymbol*> visited;
+    const char* reason = NULL;
 
-    int is = markFastSafeFn(fn, optimize_on_clause_limit, visited);
+    int is = markFastSafeFn(fn, optimize_on_clause_limit, &reason);
 
     bool fastFork = isFast(is);
     bool removeRmemFences = isLocal(is);
@@ -613,7 +706,9 @@ optimizeOnClauses(void) {
       removeRmemFences = removeUnnecessaryFences(fn);
     }
 
-    if ( (fastFork || removeRmemFences) && fReportOptimizedOn) {
+    bool rejected = fn->hasFlag(FLAG_ON_BLOCK) && !fastFork;
+
+    if ( (fastFork || removeRmemFences || rejected) && fReportOptimizedOn) {
       ModuleSymbol *mod = toModuleSymbol(fn->defPoint->parentSymbol);
       INT_ASSERT(mod);
       if (developer ||
@@ -625,9 +720,15 @@ optimizeOnClauses(void) {
           printf("Optimized rmem fence (%s) in module %s (%s:%d)\n",
                fn->cname, mod->name, fn->fname(), fn->linenum());
         }
+        if (rejected) {
+          printf("Did not optimize on clause (%s) in module %s (%s:%d): %s\n",
+               fn->cname, mod->name, fn->fname(), fn->linenum(),
+               reason ? reason : "unknown");
+        }
         if (developer) printf("(id %i)\n", fn->id);
       }
     }
   }
+  fastOnSummaries.clear();
   addRunningTaskModifiers();
 }
@@ -20,7 +20,9 @@
 
 #include "astutil.h"
 #include "ForallStmt.h"
+#include "ForLoop.h"
 #include "LoopStmt.h"
+#include "optimizations.h"
 #include "preNormalizeOptimizations.h"
 #include "resolution.h"
 #include "stlUtil.h"
@@ -35,11 +37,18 @@
 //       followers.
 //     - Does an analysis on foralls to check if regular array accesses can be
 //       replaced with localAccess
+//     - Does an analysis on for and forall loops to find array accesses that
+//       are in bounds by construction
 //
 //   - preFoldMaybeLocalThis
 //
 //     - Replaces `PRIM_MAYBE_LOCAL_THIS` with a regular array access or
 //     localAccess during resolution
+//
+//   - preFoldProvenInBounds
+//
+//     - Replaces `PRIM_PROVEN_IN_BOUNDS` with a regular array access during
+//     resolution, and records it for removeProvenBoundsChecks
 
 static int curLogDepth = 0;
 static void LOG(int depth, const char *msg, BaseAST *node);
@@ -55,7 +64,7 @@ static bool isSubIndexAssignment(Expr *expr,
                                  Symbol *subIndex,
                                  int indexIndex,
                                  Symbol *indexBundle);
-static std::vector<Symbol *> getLoopIndexSymbols(ForallStmt *forall,
+static std::vector<Symbol *> getLoopIndexSymbols(BlockStmt *loopBody,
                                                  Symbol *baseSym);
 static void gatherForallInfo(ForallStmt *forall);
 static bool loopHasValidInductionVariables(ForallStmt *forall);
@@ -89,6 +98,10 @@ static CallExpr *confirmAccess(CallExpr *call);
 
 static void symbolicFastFollowerAnalysis(ForallStmt *forall);
 
+static void markBoundsCheckBlocks();
+static void findProvenAccesses(ForallStmt *forall);
+static void findProvenAccesses(ForLoop *loop);
+
 void doPreNormalizeArrayOptimizations() {
   const bool anyAnalysisNeeded = fAutoLocalAccess ||
                                  !fNoFastFollowers;
@@ -104,6 +117,26 @@ void doPreNormalizeArrayOptimizations() {
       }
     }
   }
+
+  // this has to come after autoLocalAccess so that it sees the loops that
+  // were cloned and the accesses that were turned into PRIM_MAYBE_LOCAL_THIS
+  if (fBoundsCheckElimination && !fNoBoundsChecks) {
+    markBoundsCheckBlocks();
+
+    forv_Vec(ForallStmt, forall, gForallStmts) {
+      if (forall->inTree()) {
+        findProvenAccesses(forall);
+      }
+    }
+
+    forv_Vec(BlockStmt, block, gBlockStmts) {
+      if (ForLoop *loop = toForLoop(block)) {
+        if (loop->inTree()) {
+          findProvenAccesses(loop);
+        }
+      }
+    }
+  }
 }
 
 Expr *preFoldMaybeLocalThis(CallExpr *call) {
@@ -111,11 +144,12 @@ Expr *preFoldMaybeLocalThis(CallExpr *call) {
     // PRIM_MAYBE_LOCAL_THIS looks like
     //
     //  (call "may be local access" arrSymbol, idxSym0, ... ,idxSymN,
-    //                              paramControlFlag, paramStaticallyDetermined)
+    //                              paramControlFlag, paramStaticallyDetermined,
+    //                              provenInBounds)
     //
-    // we need to check the second argument from last to determine whether we
+    // we need to check the third argument from last to determine whether we
     // are confirming this to be a local access or not
-    if (SymExpr *controlSE = toSymExpr(call->get(call->argList.length-1))) {
+    if (SymExpr *controlSE = toSymExpr(call->get(call->argList.length-2))) {
       if (controlSE->symbol() == gTrue) {
         return confirmAccess(call);
       }
@@ -130,6 +164,25 @@ Expr *preFoldMaybeLocalThis(CallExpr *call) {
   return NULL;
 }
 
+Expr *preFoldProvenInBounds(CallExpr *call) {
+  // PRIM_PROVEN_IN_BOUNDS looks like
+  //
+  //  (call "proven in bounds access" arrSymbol, idxSym0, ... ,idxSymN)
+  //
+  // which is just `arrSymbol(idxSym0, ..., idxSymN)` that findProvenAccesses
+  // has shown to be in bounds
+  CallExpr *repl = new CallExpr(new UnresolvedSymExpr("this"),
+                                gMethodToken);
+
+  for_actuals(actual, call) {
+    repl->insertAtTail(new SymExpr(toSymExpr(actual)->symbol()));
+  }
+
+  noteProvenInBoundsAccess(repl);
+
+  return repl;
+}
+
 
 // logging support for --report-auto-local-access
 // during the first analysis phase depth is used roughly in the following way
@@ -372,13 +425,13 @@ static bool isSubIndexAssignment(Expr *expr,
 }
 
 // baseSym must be the tuple tmp that represents `(i,j)` in `forall (i,j) in D`
-static std::vector<Symbol *> getLoopIndexSymbols(ForallStmt *forall,
+static std::vector<Symbol *> getLoopIndexSymbols(BlockStmt *loopBody,
                                                  Symbol *baseSym) {
   std::vector<Symbol *> indexSymbols;
   int indexVarCount = -1;
   int bodyExprCount = 1;
 
-  AList &bodyExprs = forall->loopBody()->body;
+  AList &bodyExprs = loopBody->body;
 
   // find the check_tuple_var_decl and get the size of the tuple
   if (CallExpr *firstCall = toCallExpr(bodyExprs.get(bodyExprCount++))) {
@@ -415,7 +468,6 @@ static std::vector<Symbol *> getLoopIndexSymbols(ForallStmt *forall,
   // pattern.
   if (indexVarCount == -1 ||
       ((std::size_t)indexVarCount) != indexSymbols.size()) {
-    LOG(1, "Can't recognize loop's index symbols", baseSym);
     indexSymbols.clear();
   }
 
@@ -466,7 +518,11 @@ static void gatherForallInfo(ForallStmt *forall) {
     }
 
     if (loopIdxSym->hasFlag(FLAG_INDEX_OF_INTEREST)) {
-      forall->optInfo.multiDIndices = getLoopIndexSymbols(forall, loopIdxSym);
+      forall->optInfo.multiDIndices = getLoopIndexSymbols(forall->loopBody(),
+                                                          loopIdxSym);
+      if (forall->optInfo.multiDIndices.size() == 0) {
+        LOG(1, "Can't recognize loop's index symbols", loopIdxSym);
+      }
     }
     else {
       forall->optInfo.multiDIndices.push_back(loopIdxSym);
@@ -663,6 +719,9 @@ static void replaceCandidate(CallExpr *candidate,
   // accurate logging
   repl->insertAtTail(new SymExpr(doStatic?gTrue:gFalse));
 
+  // findProvenAccesses sets this if the access is known to be in bounds
+  repl->insertAtTail(new SymExpr(gFalse));
+
   candidate->replace(repl);
 }
 
@@ -956,18 +1015,23 @@ static CallExpr *revertAccess(CallExpr *call) {
   CallExpr *repl = new CallExpr(new UnresolvedSymExpr("this"),
                                 gMethodToken);
 
-  // Don't take the last two args; they are the static control symbol, and flag
-  // that tells whether this is a statically-determined access
-  for (int i = 1 ; i < call->argList.length-1 ; i++) {
+  // Don't take the last three args; they are the static control symbol, flag
+  // that tells whether this is a statically-determined access and the flag
+  // that tells whether it is proven to be in bounds
+  for (int i = 1 ; i < call->argList.length-2 ; i++) {
     Symbol *argSym = toSymExpr(call->get(i))->symbol();
     repl->insertAtTail(new SymExpr(argSym));
   }
 
+  if (toSymExpr(call->get(call->argList.length))->symbol() == gTrue) {
+    noteProvenInBoundsAccess(repl);
+  }
+
   return repl;
 }
 
 static CallExpr *confirmAccess(CallExpr *call) {
-  if (toSymExpr(call->get(call->argList.length))->symbol() == gTrue) {
+  if (toSymExpr(call->get(call->argList.length-1))->symbol() == gTrue) {
     LOG(0, "Static check successful. Using localAccess", call);
   }
   else {
@@ -977,13 +1041,16 @@ static CallExpr *confirmAccess(CallExpr *call) {
   CallExpr *repl = new CallExpr(new UnresolvedSymExpr("localAccess"),
                                 gMethodToken);
 
-  // Don't take the last two args; they are the static control symbol, and flag
-  // that tells whether this is a statically-determined access
-  for (int i = 1 ; i < call->argList.length-1 ; i++) {
+  // Don't take the last three args; see revertAccess
+  for (int i = 1 ; i < call->argList.length-2 ; i++) {
     Symbol *argSym = toSymExpr(call->get(i))->symbol();
     repl->insertAtTail(new SymExpr(argSym));
   }
 
+  if (toSymExpr(call->get(call->argList.length))->symbol() == gTrue) {
+    noteProvenInBoundsAccess(repl);
+  }
+
   return repl;
 }
 
@@ -1049,3 +1116,419 @@ static void symbolicFastFollowerAnalysis(ForallStmt *forall) {
   forall->optInfo.confirmedFastFollower = confirm;
 }
 
+
+//
+// Normalize support for bounds check elimination
+//
+// An access `A(i)` in a loop over `A.domain`, over `D` where `A: [D]`, or over
+// a subset of one of those, can't be out of bounds as long as the domain
+// doesn't change while the loop runs. Those accesses are marked here, and
+// removeProvenBoundsChecks redirects them to copies of the array access
+// functions without their `if boundsChecking` blocks once everything is
+// resolved. Everything else keeps its checks.
+//
+
+// Is `expr` the condition built for `if boundsChecking then ...`?
+static bool isBoundsCheckingCond(Expr *expr) {
+  if (CallExpr *ce = toCallExpr(expr)) {
+    if (ce->isNamed("_cond_test") && ce->numActuals() == 1) {
+      expr = ce->get(1);
+    }
+  }
+  if (SymExpr *se = toSymExpr(expr)) {
+    return se->symbol() == gBoundsChecking;
+  }
+  return false;
+}
+
+// Tag the blocks that only run when bounds checking is on. An `else` branch
+// would stop running if the block was dropped, so leave those alone.
+static void markBoundsCheckBlocks() {
+  forv_Vec(CondStmt, cond, gCondStmts) {
+    if (cond->inTree() && cond->elseStmt == NULL &&
+        isBoundsCheckingCond(cond->condExpr)) {
+      (unsigned&)(cond->thenStmt->blockTag) |= BLOCK_BOUNDS_CHECK;
+    }
+  }
+}
+
+static bool getIntLiteral(Expr *expr, int64_t &val) {
+  if (SymExpr *se = toSymExpr(expr)) {
+    if (VarSymbol *var = toVarSymbol(se->symbol())) {
+      if (var->immediate != NULL) {
+        if (var->immediate->const_kind == NUM_KIND_INT) {
+          val = var->immediate->int_value();
+          return true;
+        }
+        if (var->immediate->const_kind == NUM_KIND_UINT &&
+            var->immediate->uint_value() <= INT64_MAX) {
+          val = (int64_t)var->immediate->uint_value();
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+// Is `expr` `0` or `-k` for some literal `k`, which makes `D.expand(expr)` a
+// subset of `D`?
+static bool isNonPositiveLiteral(Expr *expr) {
+  int64_t val = 0;
+  if (CallExpr *ce = toCallExpr(expr)) {
+    if (ce->isNamed("-") && ce->numActuals() == 1) {
+      return getIntLiteral(ce->get(1), val) && val >= 0;
+    }
+    return false;
+  }
+  return getIntLiteral(expr, val) && val <= 0;
+}
+
+// If `sym` is a temp with a single `move sym, expr`, return `expr`. This is
+// what autoLocalAccess leaves in place of a forall's iterand call.
+static Expr *getTempInit(Symbol *sym) {
+  Expr *init = NULL;
+  for_SymbolSymExprs(se, sym) {
+    if (CallExpr *move = toCallExpr(se->parentExpr)) {
+      if (move->isPrimitive(PRIM_MOVE) && move->get(1) == se) {
+        if (init != NULL) {
+          return NULL;
+        }
+        init = move->get(2);
+      }
+    }
+  }
+  return init;
+}
+
+// Find the domain a loop iterates over, where the iterand is
+//
+//   D, A.domain                           the domain itself
+//   X[...], X.expand(-k), X.interior(k)   a subset of X, which is one of these
+//
+// `domSym` is set to the domain's symbol if it is known and `arrSym` to `A` for
+// `A.domain`. Return false if the iterand isn't one of these.
+static bool getBoundingDomain(Expr *iterExpr,
+                              Symbol *&domSym,
+                              Symbol *&arrSym) {
+  if (SymExpr *se = toSymExpr(iterExpr)) {
+    Symbol *sym = se->symbol();
+
+    if (sym->hasFlag(FLAG_TEMP)) {
+      Expr *init = getTempInit(sym);
+      return init != NULL && getBoundingDomain(init, domSym, arrSym);
+    }
+    if (!isVarSymbol(sym) && !isArgSymbol(sym)) {
+      return false;
+    }
+    if (sym->hasFlag(FLAG_TYPE_VARIABLE)) {
+      return false;
+    }
+    domSym = sym;
+    return true;
+  }
+
+  if (Symbol *dotDomBaseSym = getDotDomBaseSym(iterExpr)) {
+    arrSym = dotDomBaseSym;
+    domSym = getDomSym(dotDomBaseSym);
+    return true;
+  }
+
+  if (CallExpr *call = toCallExpr(iterExpr)) {
+    if (call->primitive != NULL) {
+      return false;
+    }
+
+    // X.expand(...), X.interior(...)
+    if (CallExpr *method = toCallExpr(call->baseExpr)) {
+      if (method->isNamedAstr(astrSdot) && getDotDomBaseSym(method) == NULL) {
+        if (SymExpr *nameSE = toSymExpr(method->get(2))) {
+          VarSymbol *nameVar = toVarSymbol(nameSE->symbol());
+          if (nameVar != NULL && nameVar->immediate != NULL &&
+              nameVar->immediate->const_kind == CONST_KIND_STRING) {
+            const char *name = nameVar->immediate->v_string;
+
+            if (strcmp(name, "expand") == 0) {
+              for_actuals(actual, call) {
+                if (!isNonPositiveLiteral(actual)) {
+                  return false;
+                }
+              }
+              return getBoundingDomain(method->get(1), domSym, arrSym);
+            }
+            else if (strcmp(name, "interior") == 0) {
+              return getBoundingDomain(method->get(1), domSym, arrSym);
+            }
+          }
+        }
+      }
+      else if (getDotDomBaseSym(call->baseExpr) != NULL) {
+        // A.domain[...]
+        return getBoundingDomain(call->baseExpr, domSym, arrSym);
+      }
+      return false;
+    }
+
+    // X[...]
+    if (isSymExpr(call->baseExpr)) {
+      return getBoundingDomain(call->baseExpr, domSym, arrSym);
+    }
+  }
+
+  return false;
+}
+
+// Could the domain `domSym` be changed while `loop` runs? Constants can't.
+// Otherwise, it must be a local of the loop's function that isn't mentioned
+// in the loop, nor anywhere else it could be changed from. A domain that
+// isn't known, like that of a `[]` formal, may change.
+static bool domainMayChange(Symbol *domSym, Expr *loop, ForallStmt *forall) {
+  if (domSym == NULL) {
+    return true;
+  }
+
+  if (domSym->hasFlag(FLAG_CONST) || domSym->hasFlag(FLAG_PARAM)) {
+    return false;
+  }
+
+  if (ArgSymbol *arg = toArgSymbol(domSym)) {
+    // domains are passed by const by default
+    return !(arg->intent == INTENT_BLANK ||
+             arg->intent == INTENT_CONST ||
+             arg->intent == INTENT_CONST_IN ||
+             arg->intent == INTENT_CONST_REF);
+  }
+
+  // the `D` in `A: [?D]`
+  if (isArgSymbol(domSym->defPoint->parentSymbol)) {
+    return false;
+  }
+
+  FnSymbol *fn = loop->getFunction();
+  if (fn == NULL || domSym->defPoint->parentSymbol != fn) {
+    return true;
+  }
+
+  for_SymbolSymExprs(se, domSym) {
+    if (se->parentSymbol != fn || loop->contains(se)) {
+      return true;
+    }
+    // `ref D2 = D;` and D2 could change it
+    if (DefExpr *def = toDefExpr(se->parentExpr)) {
+      if (def->sym->hasFlag(FLAG_REF_VAR)) {
+        return true;
+      }
+    }
+  }
+
+  if (forall != NULL) {
+    for_shadow_vars(svar, temp, forall) {
+      if (svar->outerVarSym() == domSym) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+// Is `call` run as part of the loop `loop`, rather than in a task that can
+// outlive it or in a function that can be called from elsewhere?
+static bool isRunByLoop(CallExpr *call, Expr *loop) {
+  if (call->getFunction() != loop->getFunction()) {
+    return false;
+  }
+  for (Expr *cur = call->parentExpr; cur != NULL && cur != loop;
+       cur = cur->parentExpr) {
+    if (BlockStmt *block = toBlockStmt(cur)) {
+      if (CallExpr *info = block->blockInfoGet()) {
+        if (info->isPrimitive(PRIM_BLOCK_BEGIN) ||
+            info->isPrimitive(PRIM_BLOCK_BEGIN_ON)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Return the array and index arguments of `A(i, j)`, or of a
+// PRIM_MAYBE_LOCAL_THIS made from one
+static Symbol *getAccessBaseAndIndices(CallExpr *call,
+                                       std::vector<Symbol *> &indices) {
+  Symbol *base = NULL;
+  int first = 1;
+  int last = call->numActuals();
+
+  if (call->isPrimitive(PRIM_MAYBE_LOCAL_THIS)) {
+    base = toSymExpr(call->get(1))->symbol();
+    first = 2;
+    last -= 3;  // the flags at the end
+  }
+  else if (call->primitive == NULL) {
+    if (SymExpr *baseSE = toSymExpr(call->baseExpr)) {
+      base = baseSE->symbol();
+    }
+  }
+
+  if (base == NULL) {
+    return NULL;
+  }
+
+  for (int i = first ; i <= last ; i++) {
+    SymExpr *arg = toSymExpr(call->get(i));
+    if (arg == NULL) {
+      return NULL;
+    }
+    indices.push_back(arg->symbol());
+  }
+  return base;
+}
+
+static void findProvenAccesses(Expr *loop,
+                               BlockStmt *loopBody,
+                               ForallStmt *forall,
+                               Expr *iterExpr,
+                               const std::vector<Symbol *> &loopIndices) {
+  Symbol *domSym = NULL;
+  Symbol *arrSym = NULL;
+
+  if (loopIndices.size() == 0 ||
+      !getBoundingDomain(iterExpr, domSym, arrSym)) {
+    return;
+  }
+
+  // `A.domain` is only stable if A is declared over a domain that is
+  Symbol *arrDomSym = arrSym != NULL ? getDomSym(arrSym) : NULL;
+  bool domStable = !domainMayChange(domSym, loop, forall);
+  bool arrDomStable = arrSym == NULL ||
+                      !domainMayChange(arrDomSym, loop, forall);
+
+  std::vector<CallExpr *> calls;
+  collectCallExprs(loopBody, calls);
+
+  for_vector(CallExpr, call, calls) {
+    std::vector<Symbol *> indices;
+    Symbol *base = getAccessBaseAndIndices(call, indices);
+
+    if (base == NULL || indices != loopIndices) {
+      continue;
+    }
+
+    // the same restrictions as getCallBaseSymIfSuitable
+    if (CallExpr *parentCall = toCallExpr(call->parentExpr)) {
+      if (parentCall->isPrimitive(PRIM_NEW)) { continue; }
+    }
+    if (!isVarSymbol(base) && !isArgSymbol(base)) { continue; }
+    if (base->hasFlag(FLAG_TYPE_VARIABLE)) { continue; }
+    if (base->hasFlag(FLAG_INDEX_OF_INTEREST)) { continue; }
+    if (loopBody->contains(base->defPoint)) { continue; }
+    if (!isRunByLoop(call, loop)) { continue; }
+
+    bool proven = false;
+
+    // for i in A.domain do ... A[i] ...
+    if (arrSym != NULL && base == arrSym) {
+      proven = arrDomStable;
+    }
+    else if (Symbol *baseDomSym = getDomSym(base)) {
+      // for i in A.domain do ... B[i] ... where B and A share domain
+      // for i in D do ... A[i] ... where D is A's domain
+      if (baseDomSym == domSym || baseDomSym == arrDomSym) {
+        proven = !domainMayChange(baseDomSym, loop, forall);
+      }
+    }
+
+    if (!proven || !domStable) {
+      continue;
+    }
+
+    SET_LINENO(call);
+
+    if (call->isPrimitive(PRIM_MAYBE_LOCAL_THIS)) {
+      toSymExpr(call->get(call->numActuals()))->setSymbol(gTrue);
+    }
+    else {
+      CallExpr *repl = new CallExpr(PRIM_PROVEN_IN_BOUNDS, new SymExpr(base));
+      for_vector(Symbol, index, indices) {
+        repl->insertAtTail(new SymExpr(index));
+      }
+      call->replace(repl);
+    }
+  }
+}
+
+static void findProvenAccesses(ForallStmt *forall) {
+  AList &iterExprs = forall->iteratedExpressions();
+  AList &indexVars = forall->inductionVariables();
+
+  if (forall->zippered() || iterExprs.length != 1 || indexVars.length != 1) {
+    return;
+  }
+
+  DefExpr *indexDef = toDefExpr(indexVars.head);
+  if (indexDef == NULL) {
+    return;
+  }
+
+  std::vector<Symbol *> indices;
+  if (indexDef->sym->hasFlag(FLAG_INDEX_OF_INTEREST)) {
+    indices = getLoopIndexSymbols(forall->loopBody(), indexDef->sym);
+  }
+  else {
+    indices.push_back(indexDef->sym);
+  }
+
+  findProvenAccesses(forall, forall->loopBody(), forall, iterExprs.head,
+                     indices);
+}
+
+// Return `X` from the `move _iterator, _getIterator(X)` that sets up `loop`
+static Expr *getForLoopIterand(ForLoop *loop) {
+  if (loop->zipperedGet() || loop->iteratorGet() == NULL) {
+    return NULL;
+  }
+
+  for_SymbolSymExprs(se, loop->iteratorGet()->symbol()) {
+    if (CallExpr *move = toCallExpr(se->parentExpr)) {
+      if (move->isPrimitive(PRIM_MOVE) && move->get(1) == se) {
+        if (CallExpr *getIter = toCallExpr(move->get(2))) {
+          if (getIter->isNamed("_getIterator") &&
+              getIter->numActuals() == 1) {
+            return getIter->get(1);
+          }
+        }
+      }
+    }
+  }
+  return NULL;
+}
+
+static void findProvenAccesses(ForLoop *loop) {
+  Expr *iterExpr = getForLoopIterand(loop);
+
+  if (iterExpr == NULL || loop->indexGet() == NULL) {
+    return;
+  }
+
+  Symbol *indexSym = loop->indexGet()->symbol();
+  std::vector<Symbol *> indices = getLoopIndexSymbols(loop, indexSym);
+
+  // `for i in D` starts with `def i; move i, _indexOfInterest`
+  if (indices.size() == 0) {
+    if (DefExpr *def = toDefExpr(loop->body.head)) {
+      if (CallExpr *move = toCallExpr(def->next)) {
+        if (move->isPrimitive(PRIM_MOVE)) {
+          SymExpr *lhs = toSymExpr(move->get(1));
+          SymExpr *rhs = toSymExpr(move->get(2));
+          if (lhs != NULL && rhs != NULL &&
+              lhs->symbol() == def->sym && rhs->symbol() == indexSym) {
+            indices.push_back(def->sym);
+          }
+        }
+      }
+    }
+  }
+
+  findProvenAccesses(loop, loop, NULL, iterExpr, indices);
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "astutil.h"
+#include "driver.h"
+#include "expr.h"
+#include "LoopStmt.h"
+#include "optimizations.h"
+#include "stlUtil.h"
+#include "stmt.h"
+#include "symbol.h"
+
+#include <set>
+#include <vector>
+
+/*
+   Issue the reads of remote data in a forall iteration together.
+
+   After insertWideReferences, a read of possibly remote data in a loop
+   body looks like
+
+     move ref, <address computation>
+     ...
+     move tmp, PRIM_DEREF ref
+
+   and each such read is a separate GET, or a miss in the remote data
+   cache, waited for in turn.  For order independent loops (the loops of
+   forall iterators) that do two or more such reads per iteration, this
+   inserts
+
+     move node, PRIM_WIDE_GET_NODE ref
+     PRIM_CHPL_COMM_REMOTE_PREFETCH node ref sizeof(tmp)
+
+   right after each address is computed.  A prefetch starts a
+   non-blocking GET into the remote data cache, so the GETs of an
+   iteration overlap and the reads that follow find their data there or
+   in flight.  This is the inspector/executor idea restricted to one
+   iteration: splitting the loop into chunks would mean duplicating the
+   address computations, which the lowered AST doesn't make safe.
+
+   Prefetches go through the remote data cache, so this only runs with
+   --cache-remote.
+ */
+
+// Is 'stmt' 'move tmp, PRIM_DEREF ref' with 'ref' a wide reference whose
+// one definition is an earlier statement of the same loop body?
+static bool isPrefetchableRead(Expr* stmt, LoopStmt* loop, CallExpr*& refDef) {
+  CallExpr* move = toCallExpr(stmt);
+
+  if (move == NULL || move->isPrimitive(PRIM_MOVE) == false)
+    return false;
+
+  CallExpr* deref = toCallExpr(move->get(2));
+
+  if (deref == NULL || deref->isPrimitive(PRIM_DEREF) == false)
+    return false;
+
+  SymExpr* refSe = toSymExpr(deref->get(1));
+
+  if (refSe == NULL || refSe->isWideRef() == false)
+    return false;
+
+  // the size of the data comes from the type of 'tmp', which for a class
+  // would be the size of the object rather than the pointer
+  Type* valType = move->get(1)->typeInfo();
+
+  if (valType->symbol->hasFlag(FLAG_WIDE_CLASS) || isClassLikeOrPtr(valType))
+    return false;
+
+  SymExpr* def = refSe->symbol()->getSingleDef();
+
+  if (def == NULL)
+    return false;
+
+  CallExpr* defCall = toCallExpr(def->parentExpr);
+
+  if (defCall == NULL ||
+      defCall->isPrimitive(PRIM_MOVE) == false ||
+      defCall->get(1) != def ||
+      defCall->parentExpr != loop)
+    return false;
+
+  for (Expr* e = defCall->next; e != NULL; e = e->next) {
+    if (e == stmt) {
+      refDef = defCall;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void insertPrefetch(CallExpr* refDef, CallExpr* read) {
+  SET_LINENO(refDef);
+
+  Symbol*    ref  = toSymExpr(refDef->get(1))->symbol();
+  Symbol*    tmp  = toSymExpr(read->get(1))->symbol();
+  VarSymbol* node = newTemp("prefetch_node", NODE_ID_TYPE);
+  VarSymbol* size = newTemp("prefetch_size", SIZE_TYPE);
+
+  Expr* after = refDef;
+
+  after->insertAfter(new DefExpr(node));
+  after = after->next;
+  after->insertAfter(new CallExpr(PRIM_MOVE, node,
+                                  new CallExpr(PRIM_WIDE_GET_NODE, ref)));
+  after = after->next;
+  after->insertAfter(new DefExpr(size));
+  after = after->next;
+  after->insertAfter(new CallExpr(PRIM_MOVE, size,
+                                  new CallExpr(PRIM_SIZEOF_BUNDLE, tmp)));
+  after = after->next;
+  after->insertAfter(new CallExpr(PRIM_CHPL_COMM_REMOTE_PREFETCH,
+                                  node, ref, size));
+}
+
+void prefetchForallRemoteReads() {
+  if (fNoPrefetchForallReads || fCacheRemote == false || fLocal)
+    return;
+
+  forv_Vec(BlockStmt, block, gBlockStmts) {
+    LoopStmt* loop = toLoopStmt(block);
+
+    if (loop == NULL || loop->isOrderIndependent() == false ||
+        loop->inTree() == false)
+      continue;
+
+    std::vector<CallExpr*> reads;
+    std::vector<CallExpr*> refDefs;
+    std::set<CallExpr*>    seen;
+
+    for_alist(stmt, loop->body) {
+      CallExpr* refDef = NULL;
+
+      if (isPrefetchableRead(stmt, loop, refDef) &&
+          seen.insert(refDef).second) {
+        reads.push_back(toCallExpr(stmt));
+        refDefs.push_back(refDef);
+      }
+    }
+
+    // A lone read has nothing to overlap with
+    if (reads.size() < 2)
+      continue;
+
+    for (size_t i = 0; i < reads.size(); i++)
+      insertPrefetch(refDefs[i], reads[i]);
+
+    if (fReportPrefetchForallReads &&
+        (developer || printsUserLocation(loop))) {
+      USR_PRINT(loop, "Prefetching %d remote reads in this loop",
+                (int) reads.size());
+    }
+  }
+}
@@ -36,7 +36,12 @@ static void updateLoopBodyClasses(Map<Symbol*, Vec<SymExpr*>*>& defMap,
 static void updateTaskFunctions(Map<Symbol*, Vec<SymExpr*>*>& defMap,
                                 Map<Symbol*, Vec<SymExpr*>*>& useMap);
 
-static void buildSyncAccessFunctionSet(Vec<FnSymbol*>& syncAccessFunctionSet);
+static void buildSyncAccessFunctionSet(Vec<FnSymbol*>& syncAccessFunctionSet,
+                                       bool (*isAccess)(FnSymbol*));
+
+static bool isSyncSingleMethod(FnSymbol* fn);
+
+static bool isAtomicMethod(FnSymbol* fn);
 
 static bool isSafeToDeref(Map<Symbol*, Vec<SymExpr*>*>& defMap,
                           Map<Symbol*, Vec<SymExpr*>*>& useMap,
@@ -196,6 +201,7 @@ static bool isSafeToDerefField(Map<Symbol*, Vec<SymExpr*>*>& defMap,
 static bool canForwardValue(Map<Symbol*, Vec<SymExpr*>*>& defMap,
                             Map<Symbol*, Vec<SymExpr*>*>& useMap,
                             Vec<FnSymbol*>&               syncFns,
+                            Vec<FnSymbol*>&               atomicFns,
                             FnSymbol*                     fn,
                             ArgSymbol*                    arg);
 
@@ -241,8 +247,10 @@ static bool shouldSerialize(ArgSymbol* arg) {
 static void updateTaskFunctions(Map<Symbol*, Vec<SymExpr*>*>& defMap,
                                 Map<Symbol*, Vec<SymExpr*>*>& useMap) {
   Vec<FnSymbol*> syncSet;
+  Vec<FnSymbol*> atomicSet;
 
-  buildSyncAccessFunctionSet(syncSet);
+  buildSyncAccessFunctionSet(syncSet, isSyncSingleMethod);
+  buildSyncAccessFunctionSet(atomicSet, isAtomicMethod);
 
   forv_Vec(FnSymbol, fn, gFnSymbols) {
     if (fn->hasFlag(FLAG_ON) == true) {
@@ -251,7 +259,7 @@ static void updateTaskFunctions(Map<Symbol*, Vec<SymExpr*>*>& defMap,
 
       // For each reference arg that is safe to dereference
       for_formals(arg, fn) {
-        if (canForwardValue(defMap, useMap, syncSet, fn, arg)) {
+        if (canForwardValue(defMap, useMap, syncSet, atomicSet, fn, arg)) {
           if (shouldSerialize(arg)) {
             insertSerialization(fn, arg);
           } else {
@@ -263,9 +271,69 @@ static void updateTaskFunctions(Map<Symbol*, Vec<SymExpr*>*>& defMap,
   }
 }
 
+//
+// Return the size in bytes of a record made only of scalar fields,
+// or -1 for any other type.
+//
+static int podRecordSize(Type* t) {
+  if (t == dtBools[BOOL_SIZE_SYS])
+    return 1;
+
+  if (is_bool_type(t) || is_int_type(t) || is_uint_type(t) ||
+      is_real_type(t) || is_imag_type(t) || is_complex_type(t))
+    return get_width(t) / 8;
+
+  if (is_enum_type(t))
+    return 8;
+
+  AggregateType* at = toAggregateType(t);
+
+  if (at == NULL || !at->isRecord() || isRecordWrappedType(at) ||
+      isSyncType(at) || isSingleType(at) || isAtomicType(at) ||
+      !isPOD(at))
+    return -1;
+
+  int size = 0;
+
+  for_fields(field, at) {
+    if (field->isRef())
+      return -1;
+
+    int fieldSize = podRecordSize(field->type);
+
+    if (fieldSize < 0)
+      return -1;
+
+    size += fieldSize;
+  }
+
+  return size;
+}
+
+//
+// A const ref to a small plain record can be read when a blocking on
+// statement is launched instead of from the remote side, unless the
+// on-body synchronizes with other tasks.  Without synchronization
+// another task changing the record would be a race, so reading it early
+// is allowed.
+//
+static bool canForwardSmallRecord(Vec<FnSymbol*>& syncFns,
+                                  Vec<FnSymbol*>& atomicFns,
+                                  FnSymbol*       fn,
+                                  ArgSymbol*      arg) {
+  if (fn->hasFlag(FLAG_NON_BLOCKING) ||
+      syncFns.set_in(fn) || atomicFns.set_in(fn))
+    return false;
+
+  int size = podRecordSize(arg->getValType());
+
+  return size > 0 && size <= rvf_record_limit;
+}
+
 static bool canForwardValue(Map<Symbol*, Vec<SymExpr*>*>& defMap,
                             Map<Symbol*, Vec<SymExpr*>*>& useMap,
                             Vec<FnSymbol*>&               syncFns,
+                            Vec<FnSymbol*>&               atomicFns,
                             FnSymbol*                     fn,
                             ArgSymbol*                    arg) {
   bool retval = false;
@@ -319,8 +387,10 @@ static bool canForwardValue(Map<Symbol*, Vec<SymExpr*>*>& defMap,
         // to simply get to the wide class pointer. Because the reference is
         // never written to, we can simply RVF the class pointer.
         retval = true;
+      } else if (arg->hasFlag(FLAG_REF_TO_IMMUTABLE)) {
+        retval = true;
       } else {
-        retval = arg->hasFlag(FLAG_REF_TO_IMMUTABLE);
+        retval = canForwardSmallRecord(syncFns, atomicFns, fn, arg);
       }
     } else {
       retval = false;
@@ -704,6 +774,10 @@ static void defaultForwarding(Map<Symbol*, Vec<SymExpr*>*>& useMap,
   }
 }
 
+static bool isAtomicMethod(FnSymbol* fn) {
+  return fn->_this != NULL && isAtomicType(fn->_this->getValType());
+}
+
 static bool isSyncSingleMethod(FnSymbol* fn) {
 
   bool retval = false;
@@ -722,18 +796,19 @@ static bool isSyncSingleMethod(FnSymbol* fn) {
 
 /************************************* | **************************************
 *                                                                             *
-* Compute set of functions that access sync variables.                        *
+* Compute set of functions that access sync (or atomic) variables.            *
 *                                                                             *
 ************************************** | *************************************/
 
-static void buildSyncAccessFunctionSet(Vec<FnSymbol*>& syncAccessFunctionSet) {
+static void buildSyncAccessFunctionSet(Vec<FnSymbol*>& syncAccessFunctionSet,
+                                       bool (*isAccess)(FnSymbol*)) {
   Vec<FnSymbol*> syncAccessFunctionVec;
 
   //
-  // Find all methods on sync/single vars
+  // Find all methods on sync/single vars (or atomics, per isAccess)
   //
   forv_Vec(FnSymbol, fn, gFnSymbols) {
-    if (isSyncSingleMethod(fn)) {
+    if (isAccess(fn)) {
       if (!fn->hasFlag(FLAG_DONT_DISABLE_REMOTE_VALUE_FORWARDING) &&
           !syncAccessFunctionSet.set_in(fn)) {
         syncAccessFunctionSet.set_add(fn);
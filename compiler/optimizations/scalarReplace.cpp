@@ -21,7 +21,10 @@
 //
 // scalarReplace
 //
-// This pass implements scalar replacement of aggregates.
+// This pass implements scalar replacement of aggregates: tuples, iterator
+// classes and records, and, unless --no-scalar-replace-aggregates is
+// given, other records and classes that are allocated and used within
+// one function.
 //
 
 #include "optimizations.h"
@@ -549,6 +552,61 @@ scalarReplaceRecord(AggregateType* ct, Symbol* sym) {
 }
 
 
+//
+// Is a record or class type other than a tuple or iterator type a
+// candidate for scalar replacement?  The replacement itself only fires
+// for variables whose every use is a field access, so this just rules
+// out types whose values carry meaning beyond their fields.
+//
+static bool
+isScalarReplaceableAggregate(TypeSymbol* ts, AggregateType* ct) {
+  if (fNoScalarReplaceAggregates)
+    return false;
+
+  if (ct->fields.length > scalar_replace_limit)
+    return false;
+
+  if (ts->hasFlag(FLAG_EXTERN) ||
+      ts->hasFlag(FLAG_REF) ||
+      ts->hasFlag(FLAG_WIDE_REF) ||
+      ts->hasFlag(FLAG_WIDE_CLASS) ||
+      ts->hasFlag(FLAG_DATA_CLASS) ||
+      ts->hasFlag(FLAG_ARRAY) ||
+      ts->hasFlag(FLAG_DOMAIN) ||
+      ts->hasFlag(FLAG_DISTRIBUTION) ||
+      ts->hasFlag(FLAG_SYNC) ||
+      ts->hasFlag(FLAG_SINGLE) ||
+      ts->hasFlag(FLAG_ATOMIC_TYPE) ||
+      ts->hasFlag(FLAG_GENERIC))
+    return false;
+
+  // Replacing a variable adds its fields to the variable list of their
+  // type, which must not be the list being walked.
+  for_fields(field, ct) {
+    if (field->type == ct)
+      return false;
+  }
+
+  if (ct->isRecord())
+    return true;
+
+  //
+  // Inherited fields live in the embedded parent, which scalarReplaceClass
+  // doesn't know how to take apart, so only consider direct subclasses of
+  // object.
+  //
+  if (ct->isClass()) {
+    forv_Vec(AggregateType, parent, ct->dispatchParents) {
+      if (parent != dtObject)
+        return false;
+    }
+    return true;
+  }
+
+  return false;
+}
+
+
 static void
 debugScalarReplacementFailure(Symbol* var) {
   printf("failed to scalar replace %s[%d]\n", var->cname, var->id);
@@ -580,7 +638,8 @@ scalarReplace() {
         if (ts->hasFlag(FLAG_ITERATOR_CLASS) ||
             ts->hasFlag(FLAG_ITERATOR_RECORD) ||
             (ts->hasFlag(FLAG_TUPLE) &&
-             (ct->fields.length<=scalar_replace_limit))) {
+             (ct->fields.length<=scalar_replace_limit)) ||
+            isScalarReplaceableAggregate(ts, ct)) {
           typeVec.add(ct);
           typeVarMap.put(ct, new Vec<Symbol*>());
           if (AggregateType* rct = toAggregateType(ct->refType))
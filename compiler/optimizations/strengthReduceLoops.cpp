@@ -0,0 +1,338 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "astutil.h"
+#include "CForLoop.h"
+#include "driver.h"
+#include "expr.h"
+#include "optimizations.h"
+#include "stlUtil.h"
+#include "stmt.h"
+#include "symbol.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+/*
+   Replace index arithmetic on the induction variables of C for loops
+   with running sums.
+
+   Indexing a multi-dimensional array computes something like
+
+     move t1, PRIM_MULT i blk1
+     move t2, PRIM_ADD t0 t1
+     move off, PRIM_SUBTRACT t2 factoredOffs
+
+   in the innermost loop, where 'i' is that loop's index and the other
+   operands are invariant in it (LICM runs first and hoists what it can
+   of the rest).  Each of these values changes by a fixed amount per
+   iteration, so this gives each one a variable that is set in the loop's
+   init clause and bumped in its incr clause:
+
+     for (i = lo, t1_sr = i*blk1, ...; i <= hi; i += s, t1_sr += s*blk1, ...)
+       move t1, t1_sr
+       ...
+
+   An induction variable here is one whose only def in the loop is
+   'PRIM_ADD_ASSIGN iv step' in the incr clause with an invariant 'step'.
+   An operand is invariant if it is a local that isn't a reference and
+   isn't defined, and doesn't have its address taken, anywhere in the
+   loop.  A value computed from a reduced one is only reduced when both
+   are computed by statements directly in the loop body.
+ */
+
+namespace {
+  struct AffineVar {
+    Symbol*   value;    // holds the current value during an iteration
+    Symbol*   step;     // what the value goes up by per iteration
+    CallExpr* ivIncr;   // the increment of the underlying induction var
+  };
+}
+
+typedef std::map<Symbol*, AffineVar> AffineMap;
+
+static bool isImmediateOne(Symbol* sym) {
+  Immediate* imm = getSymbolImmediate(sym);
+
+  if (imm == NULL)
+    return false;
+
+  if (imm->const_kind == NUM_KIND_INT)
+    return imm->int_value() == 1;
+
+  if (imm->const_kind == NUM_KIND_UINT)
+    return imm->uint_value() == 1;
+
+  return false;
+}
+
+static bool isLocalScalar(Symbol* sym) {
+  if (isLcnSymbol(sym) == false || sym->isRef())
+    return false;
+
+  if (isFnSymbol(sym->defPoint->parentSymbol) == false)
+    return false;
+
+  return is_int_type(sym->type) || is_uint_type(sym->type);
+}
+
+// Are the mentions of 'sym' in 'loop' all reads, other than 'allowedDef'
+// and, if 'allowInit', anything in the init clause?
+static bool onlyReadInLoop(Symbol*   sym,
+                           CForLoop* loop,
+                           CallExpr* allowedDef,
+                           bool      allowInit) {
+  BlockStmt* initBlock = loop->initBlockGet();
+
+  if (loop->contains(sym->defPoint))
+    return false;
+
+  for_SymbolSymExprs(se, sym) {
+    if (loop->contains(se) == false)
+      continue;
+
+    if (allowInit && initBlock->contains(se))
+      continue;
+
+    if (allowedDef != NULL && se == allowedDef->get(1))
+      continue;
+
+    if (CallExpr* call = toCallExpr(se->parentExpr)) {
+      if (call->isPrimitive(PRIM_ADDR_OF) ||
+          call->isPrimitive(PRIM_SET_REFERENCE))
+        return false;
+    }
+
+    if (isDefAndOrUse(se) & 1)
+      return false;
+  }
+
+  return true;
+}
+
+static bool isInvariantIn(SymExpr* se, CForLoop* loop) {
+  Symbol* sym = se->symbol();
+
+  if (VarSymbol* var = toVarSymbol(sym)) {
+    if (var->immediate != NULL)
+      return true;
+  }
+
+  return isLocalScalar(sym) && onlyReadInLoop(sym, loop, NULL, false);
+}
+
+// Find the induction variables updated in the incr clause of 'loop'
+static void findInductionVars(CForLoop* loop, AffineMap& affine) {
+  for_alist(stmt, loop->incrBlockGet()->body) {
+    CallExpr* incr = toCallExpr(stmt);
+
+    if (incr == NULL || incr->isPrimitive(PRIM_ADD_ASSIGN) == false)
+      continue;
+
+    SymExpr* ivSe   = toSymExpr(incr->get(1));
+    SymExpr* stepSe = toSymExpr(incr->get(2));
+
+    if (ivSe == NULL || stepSe == NULL)
+      continue;
+
+    Symbol* iv = ivSe->symbol();
+
+    if (isLocalScalar(iv) &&
+        iv->type == stepSe->symbol()->type &&
+        isInvariantIn(stepSe, loop) &&
+        onlyReadInLoop(iv, loop, incr, true)) {
+      AffineVar var = { iv, stepSe->symbol(), incr };
+      affine[iv] = var;
+    }
+  }
+}
+
+// Is 'move' the one def of a local scalar, and not under a PRIM_ADDR_OF?
+static bool isOnlyDef(CallExpr* move, Symbol* sym) {
+  if (isLocalScalar(sym) == false)
+    return false;
+
+  for_SymbolSymExprs(se, sym) {
+    if (se == move->get(1))
+      continue;
+
+    if (CallExpr* call = toCallExpr(se->parentExpr)) {
+      if (call->isPrimitive(PRIM_ADDR_OF) ||
+          call->isPrimitive(PRIM_SET_REFERENCE))
+        return false;
+    }
+
+    if (isDefAndOrUse(se) & 1)
+      return false;
+  }
+
+  return true;
+}
+
+// Is 'se' an affine variable that is current wherever 'move' runs?  The
+// induction variables are.  Other values have to be computed by an
+// earlier statement of the loop body, because a def under a conditional,
+// or later in the body, could leave the last iteration's value.
+static bool isCurrentAffine(SymExpr*           se,
+                            CallExpr*          move,
+                            CForLoop*          loop,
+                            AffineMap&         affine,
+                            std::set<Symbol*>& topLevel) {
+  AffineMap::iterator it = affine.find(se->symbol());
+
+  if (it == affine.end())
+    return false;
+
+  if (it->second.value == se->symbol())
+    return true;
+
+  return topLevel.count(se->symbol()) != 0 && move->parentExpr == loop;
+}
+
+static int strengthReduceLoop(CForLoop* loop) {
+  AffineMap affine;
+
+  findInductionVars(loop, affine);
+
+  if (affine.empty())
+    return 0;
+
+  SET_LINENO(loop);
+
+  BlockStmt*             initBlock = loop->initBlockGet();
+  std::vector<CallExpr*> calls;
+  std::set<Symbol*>      topLevel;
+  int                    numReduced = 0;
+
+  for_alist(stmt, loop->body) {
+    collectCallExprs(stmt, calls);
+  }
+
+  for_vector(CallExpr, move, calls) {
+    if (move->isPrimitive(PRIM_MOVE) == false)
+      continue;
+
+    SymExpr*  lhs = toSymExpr(move->get(1));
+    CallExpr* rhs = toCallExpr(move->get(2));
+
+    if (lhs == NULL || rhs == NULL || rhs->numActuals() != 2)
+      continue;
+
+    if (rhs->isPrimitive(PRIM_MULT)     == false &&
+        rhs->isPrimitive(PRIM_ADD)      == false &&
+        rhs->isPrimitive(PRIM_SUBTRACT) == false)
+      continue;
+
+    SymExpr* op1 = toSymExpr(rhs->get(1));
+    SymExpr* op2 = toSymExpr(rhs->get(2));
+    Symbol*  t   = lhs->symbol();
+
+    if (op1 == NULL || op2 == NULL ||
+        op1->symbol()->type != t->type ||
+        op2->symbol()->type != t->type ||
+        isOnlyDef(move, t) == false)
+      continue;
+
+    // Which operand varies?  For subtraction only the first may.
+    SymExpr* varying   = NULL;
+    SymExpr* invariant = NULL;
+
+    if (isCurrentAffine(op1, move, loop, affine, topLevel) &&
+        isInvariantIn(op2, loop)) {
+      varying   = op1;
+      invariant = op2;
+    } else if (rhs->isPrimitive(PRIM_SUBTRACT) == false &&
+               isCurrentAffine(op2, move, loop, affine, topLevel) &&
+               isInvariantIn(op1, loop)) {
+      varying   = op2;
+      invariant = op1;
+    }
+
+    if (varying == NULL)
+      continue;
+
+    AffineVar& from  = affine[varying->symbol()];
+    Symbol*    step  = from.step;
+    VarSymbol* value = newTemp("sr_value", t->type);
+
+    loop->insertBefore(new DefExpr(value));
+
+    // Scaling also scales the step, which is computed before the loop
+    if (rhs->isPrimitive(PRIM_MULT)) {
+      if (isImmediateOne(step)) {
+        step = invariant->symbol();
+      } else {
+        VarSymbol* scaled = newTemp("sr_step", t->type);
+
+        loop->insertBefore(new DefExpr(scaled));
+        loop->insertBefore(new CallExpr(PRIM_MOVE, scaled,
+                                        new CallExpr(PRIM_MULT, step,
+                                                     invariant->copy())));
+        step = scaled;
+      }
+    }
+
+    // Start from the same expression, with the running value in place of
+    // the varying operand
+    CallExpr* start = rhs->copy();
+
+    if (varying == op1)
+      toSymExpr(start->get(1))->setSymbol(from.value);
+    else
+      toSymExpr(start->get(2))->setSymbol(from.value);
+
+    initBlock->insertAtTail(new CallExpr(PRIM_MOVE, value, start));
+    from.ivIncr->insertAfter(new CallExpr(PRIM_ADD_ASSIGN, value, step));
+
+    rhs->replace(new SymExpr(value));
+
+    AffineVar var = { value, step, from.ivIncr };
+    affine[t] = var;
+
+    if (move->parentExpr == loop)
+      topLevel.insert(t);
+
+    numReduced++;
+  }
+
+  return numReduced;
+}
+
+void strengthReduceLoops() {
+  if (fNoStrengthReduction)
+    return;
+
+  forv_Vec(BlockStmt, block, gBlockStmts) {
+    CForLoop* loop = toCForLoop(block);
+
+    // The new variables are set up just before the loop
+    if (loop == NULL || loop->inTree() == false || loop->list == NULL)
+      continue;
+
+    int numReduced = strengthReduceLoop(loop);
+
+    if (fReportStrengthReduction && numReduced > 0 &&
+        (developer || printsUserLocation(loop))) {
+      USR_PRINT(loop, "Strength reduced %d index computations in this loop",
+                numReduced);
+    }
+  }
+}
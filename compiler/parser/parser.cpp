@@ -35,7 +35,11 @@
 #include "symbol.h"
 #include "wellknown.h"
 
+#include <cstdio>
 #include <cstdlib>
+#include <map>
+#include <thread>
+#include <vector>
 
 BlockStmt*           yyblock                       = NULL;
 const char*          yyfilename                    = NULL;
@@ -65,6 +69,10 @@ static void          parseCommandLineFiles();
 
 static void          parseDependentModules(bool isInternal);
 
+static const char*   modNameToPath(const char* modName,
+                                   bool        isInternal,
+                                   ModTag*     modTag);
+
 static ModuleSymbol* parseMod(const char* modName,
                               bool        isInternal);
 
@@ -487,14 +495,73 @@ static void ensureRequiredStandardModulesAreParsed() {
 *                                                                             *
 ************************************** | *************************************/
 
+//
+// The parser isn't reentrant -- its actions build AST nodes and update
+// the module lists -- so files are parsed one at a time, in order.  While
+// one file is being parsed, the files of the modules it uses are read on
+// other threads, so waiting on the file system (often a network file
+// system for CHPL_HOME) overlaps with parsing.
+//
+static void readFilesAhead(std::vector<const char*> paths) {
+  char buf[65536];
+
+  for (size_t i = 0; i < paths.size(); i++) {
+    if (FILE* fp = fopen(paths[i], "r")) {
+      while (fread(buf, 1, sizeof(buf), fp) > 0) {
+      }
+
+      fclose(fp);
+    }
+  }
+}
+
+struct ModuleFile {
+  const char* path;
+  ModTag      modTag;
+};
+
 static void parseDependentModules(bool isInternal) {
-  forv_Vec(const char*, modName, sModNameList) {
-    if (sModDoneSet.set_in(modName)   == NULL &&
-        parseMod(modName, isInternal) != NULL) {
-      sModDoneSet.set_add(modName);
+  std::map<const char*, ModuleFile> files;
+  std::vector<std::thread>          readers;
+  int                               numLookedUp = 0;
+
+  for (int i = 0; i < sModNameList.n; i++) {
+    // Find the files of the modules added since the last lookup, and
+    // start reading them.
+    std::vector<const char*> paths;
+
+    for (; numLookedUp < sModNameList.n; numLookedUp++) {
+      const char* name = sModNameList.v[numLookedUp];
+
+      if (sModDoneSet.set_in(name) == NULL && files.count(name) == 0) {
+        ModuleFile file;
+
+        file.path   = modNameToPath(name, isInternal, &file.modTag);
+        files[name] = file;
+
+        if (file.path != NULL)
+          paths.push_back(file.path);
+      }
+    }
+
+    if (paths.size() > 0)
+      readers.push_back(std::thread(readFilesAhead, paths));
+
+    const char* modName = sModNameList.v[i];
+
+    if (sModDoneSet.set_in(modName) == NULL) {
+      ModuleFile& file = files[modName];
+
+      if (file.path != NULL &&
+          parseFile(file.path, file.modTag, false, false) != NULL) {
+        sModDoneSet.set_add(modName);
+      }
     }
   }
 
+  for (size_t i = 0; i < readers.size(); i++)
+    readers[i].join();
+
   // Clear the list of things we need.  On the first pass, this
   // will be the standard modules used by the internal modules which
   // are already captured in the modReqdByInt vector and will be dealt
@@ -510,21 +577,29 @@ static void parseDependentModules(bool isInternal) {
 *                                                                             *
 ************************************** | *************************************/
 
-static ModuleSymbol* parseMod(const char* modName, bool isInternal) {
-  const char* path   = NULL;
-  ModTag      modTag = MOD_INTERNAL;
+static const char* modNameToPath(const char* modName,
+                                 bool        isInternal,
+                                 ModTag*     modTag) {
+  const char* path = NULL;
 
   if (isInternal == true) {
-    path   = searchThePath(modName, true, sIntModPath);
-    modTag = MOD_INTERNAL;
+    path    = searchThePath(modName, true, sIntModPath);
+    *modTag = MOD_INTERNAL;
 
   } else {
     bool isStandard = false;
 
-    path   = stdModNameToPath(modName, &isStandard);
-    modTag = isStandard ? MOD_STANDARD : MOD_USER;
+    path    = stdModNameToPath(modName, &isStandard);
+    *modTag = isStandard ? MOD_STANDARD : MOD_USER;
   }
 
+  return path;
+}
+
+static ModuleSymbol* parseMod(const char* modName, bool isInternal) {
+  ModTag      modTag = MOD_INTERNAL;
+  const char* path   = modNameToPath(modName, isInternal, &modTag);
+
   return (path != NULL) ? parseFile(path, modTag, false, false) : NULL;
 }
 
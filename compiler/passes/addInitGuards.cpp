@@ -39,6 +39,8 @@
 #include "stringutil.h"
 #include "wellknown.h"
 
+#include <map>
+
 static void addModuleInitBlocks();
 static void addInitGuards();
 static void addInitGuard(FnSymbol* fn, FnSymbol* preInitFn);
@@ -51,7 +53,56 @@ void addInitCalls()
 }
 
 
+//
+// A module's initializer has nothing to do if its body is empty, it has
+// no deinitializer to register, and the initializers it would call for
+// its parent and the modules it uses have nothing to do either.  We
+// don't emit calls to such initializers, which keeps programs that use
+// many declaration-only modules from walking the whole use graph at
+// startup.  A module found again while we're still deciding about it
+// (a use cycle) is treated as nontrivial, to be safe.
+//
+enum InitKind { INIT_DECIDING, INIT_TRIVIAL, INIT_NONTRIVIAL };
+
+static bool isTrivialInit(ModuleSymbol* mod,
+                          std::map<ModuleSymbol*, InitKind>& kinds) {
+  std::map<ModuleSymbol*, InitKind>::iterator it = kinds.find(mod);
+  if (it != kinds.end())
+    return it->second == INIT_TRIVIAL;
+
+  FnSymbol* fn = toFnSymbol(mod->initFn);
+  if (fn == NULL)
+    return false;
+
+  kinds[mod] = INIT_DECIDING;
+
+  bool trivial = (fn->body->length() < 1 && mod->deinitFn == NULL);
+
+  if (trivial)
+    if (ModuleSymbol* parent = mod->defPoint->getModule())
+      if (parent != theProgram && parent != rootModule)
+        trivial = isTrivialInit(parent, kinds);
+
+  for_vector(ModuleSymbol, usedMod, mod->modUseList) {
+    if (!trivial)
+      break;
+    if (usedMod != standardModule)
+      trivial = isTrivialInit(usedMod, kinds);
+  }
+
+  kinds[mod] = trivial ? INIT_TRIVIAL : INIT_NONTRIVIAL;
+  return trivial;
+}
+
+
 void addModuleInitBlocks() {
+  // Decide which initializers are trivial before we add any calls.
+  std::map<ModuleSymbol*, InitKind> kinds;
+  forv_Vec(ModuleSymbol, mod, gModuleSymbols) {
+    if (mod != rootModule)
+      isTrivialInit(mod, kinds);
+  }
+
   forv_Vec(ModuleSymbol, mod, gModuleSymbols) {
     // Not for the root module
     if (mod == rootModule) continue;
@@ -79,12 +130,13 @@ void addModuleInitBlocks() {
     if (ModuleSymbol* parent = mod->defPoint->getModule())
       // The initializer for theProgram is called specially in main.c,
       // so we don't have to call it here.
-      if (parent != theProgram && parent != rootModule)
+      if (parent != theProgram && parent != rootModule &&
+          !isTrivialInit(parent, kinds))
         initBlock->insertAtTail(new CallExpr(parent->initFn));
 
     // Call the initializer for each module I use.
     for_vector(ModuleSymbol, usedMod, mod->modUseList) {
-      if (usedMod != standardModule) {
+      if (usedMod != standardModule && !isTrivialInit(usedMod, kinds)) {
         initBlock->insertAtTail(new CallExpr(usedMod->initFn));
       }
     }
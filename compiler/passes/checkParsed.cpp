@@ -580,7 +580,9 @@ static void warnUnstableLeadingUnderscores() {
           !sym->hasFlag(FLAG_TEMP) &&
           !sym->hasFlag(FLAG_INDEX_VAR) &&
           !sym->hasFlag(FLAG_COMPILER_NESTED_FUNCTION) &&
-          !(fn && fn->hasFlag(FLAG_COMPILER_NESTED_FUNCTION))) {
+          !(fn && fn->hasFlag(FLAG_COMPILER_NESTED_FUNCTION)) &&
+          !sym->hasFlag(FLAG_COFORALL_ON_TREE) &&
+          !(fn && fn->hasFlag(FLAG_COFORALL_ON_TREE))) {
         USR_WARN(def,
                  "Symbol names beginning with 'chpl_' (%s) are unstable.", name);
       }
@@ -57,6 +57,7 @@ void denormalize(void);
 void denormalize(Expr* def, SymExpr* use, Type* castTo);
 void denormalizeOrDeferCandidates(UseDefCastMap& candidates,
     std::set<Symbol*>& deferredSyms);
+void foldReturnTemps(FnSymbol* fn);
 
 int maxDenormalizesPerFunction = 1000;
 
@@ -88,6 +89,9 @@ void denormalize(void) {
       // remove unused epilogue labels
       removeUnnecessaryGotos(fn, true);
 
+      // pass destinations directly to _retArg formals
+      foldReturnTemps(fn);
+
       bool isFirstRound = true;
       do {
         candidates.clear();
@@ -113,6 +117,109 @@ void denormalize(void) {
   }
 }
 
+/*
+ * Calls to functions that return through a _retArg formal look like
+ *
+ *   def tmp;
+ *   f(..., tmp);
+ *   move dst, tmp
+ *
+ * so the callee builds its result in `tmp` only for it to be copied to
+ * `dst`.  Pass `dst` itself when the callee can't tell the difference:
+ *
+ * - `tmp` is mentioned only by the call and the move
+ * - `dst` is a local value of the same type defined in the same block
+ *   as the call and the move, and the move is its first mention, so
+ *   nothing can refer to `dst` while the callee runs
+ */
+void foldReturnTemps(FnSymbol* fn) {
+  std::vector<CallExpr*> calls;
+
+  collectCallExprs(fn, calls);
+
+  for_vector(CallExpr, call, calls) {
+    FnSymbol* calledFn = call->resolvedFunction();
+    BlockStmt* block = toBlockStmt(call->parentExpr);
+
+    if (calledFn == NULL || calledFn->hasFlag(FLAG_FN_RETARG) == false ||
+        block == NULL)
+      continue;
+
+    SymExpr* actual = NULL;
+
+    for_formals_actuals(formal, act, call) {
+      if (formal->hasFlag(FLAG_RETARG))
+        actual = toSymExpr(act);
+    }
+
+    Symbol* tmp = actual != NULL ? actual->symbol() : NULL;
+
+    if (tmp == NULL || tmp->hasFlag(FLAG_TEMP) == false ||
+        tmp->isRefOrWideRef() || tmp->defPoint->parentExpr != block)
+      continue;
+
+    CallExpr* move = NULL;
+    int       mentions = 0;
+
+    for_SymbolSymExprs(se, tmp) {
+      CallExpr* parent = toCallExpr(se->parentExpr);
+
+      if (parent != NULL && parent->isPrimitive(PRIM_MOVE) &&
+          parent->get(2) == se)
+        move = parent;
+
+      mentions++;
+    }
+
+    if (move == NULL || mentions != 2 || move->parentExpr != block)
+      continue;
+
+    SymExpr* dstSe = toSymExpr(move->get(1));
+    Symbol*  dst   = dstSe != NULL ? dstSe->symbol() : NULL;
+
+    if (isVarSymbol(dst) == false || dst->isRefOrWideRef() ||
+        dst->type != tmp->type || dst->defPoint->parentExpr != block)
+      continue;
+
+    // The call and the move must follow dst's definition, in order,
+    // with nothing in between mentioning dst
+    std::set<Expr*> before;
+    bool            sawCall = false;
+    Expr*           stmt    = dst->defPoint->next;
+
+    while (stmt != NULL && stmt != move) {
+      if (stmt == call)
+        sawCall = true;
+
+      before.insert(stmt);
+      stmt = stmt->next;
+    }
+
+    if (stmt == NULL || sawCall == false)
+      continue;
+
+    bool fresh = true;
+
+    for_SymbolSymExprs(se, dst) {
+      Expr* seStmt = se;
+
+      while (seStmt != NULL && seStmt->parentExpr != block)
+        seStmt = seStmt->parentExpr;
+
+      if (seStmt == NULL || before.count(seStmt) != 0) {
+        fresh = false;
+        break;
+      }
+    }
+
+    if (fresh) {
+      actual->setSymbol(dst);
+      move->remove();
+      tmp->defPoint->remove();
+    }
+  }
+}
+
 /*
  * deferring denormalizing over some temporaries and the way it's done
  * is as follows:
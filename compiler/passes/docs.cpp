@@ -385,15 +385,25 @@ void generateSphinxOutput(std::string sphinxDir, std::string outputDir) {
   const char * envVars = astr("export CHPLDOC_AUTHOR='", fDocsAuthor, "' && "
                               "export CHPLDOC_PROJECT_VERSION='", venvProjectVersion, "'");
 
+  // Reading and writing the pages is most of the time spent on a large
+  // package, and sphinx-build can spread that over several processes.
+  const char * jobs = "";
+  if (fDocsSphinxJobs == 0) {
+    jobs = " -j auto";
+  } else if (fDocsSphinxJobs > 1) {
+    jobs = astr(" -j ", istr(fDocsSphinxJobs));
+  }
+
   // Run:
   //   $envVars &&
-  //     sphinx-build -b html
+  //     sphinx-build -b html [-j $jobs]
   //     -d $sphinxDir/build/doctrees -W
   //     $sphinxDir/source $outputDir
   const char * cmdPrefix = astr(envVars, " && ");
+  const char * cmdBuild = astr(sphinxBuild, " -b html", jobs);
   const char * cmd = astr(
     cmdPrefix,
-    sphinxBuild, " -b html -d ",
+    cmdBuild, " -d ",
     sphinxDir.c_str(), "/build/doctrees -W ",
     sphinxDir.c_str(), "/source ", outputDir.c_str());
   if( printSystemCommands ) {
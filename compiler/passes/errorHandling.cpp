@@ -942,6 +942,19 @@ bool ErrorCheckingVisitor::enterCallExpr(CallExpr* node) {
       if (FnSymbol* parentFn = toFnSymbol(node->parentSymbol)) {
         inThrowingFunction = parentFn->throwsError();
 
+        // Check a coforall-on tree function like the coforall it came
+        // from.  It calls itself, so stop at the recursive call.
+        if (calledFn->hasFlag(FLAG_COFORALL_ON_TREE) &&
+            (!inThrowingFunction || taskFunctionDepth > 0)) {
+          if (taskFunctionDepth == 0) {
+            taskFunctionDepth++;
+            calledFn->body->accept(this);
+
+            taskFunctionDepth--;
+          }
+          return true;
+        }
+
         if (!inThrowingFunction && isTaskFun(calledFn)) {
           taskFunctionDepth++;
           calledFn->body->accept(this);
@@ -1019,6 +1032,9 @@ bool canFunctionImplicitlyThrow(FnSymbol* fn)
   // loop-expr functions can be implicit throws
   if (isLoopExprFun(fn))
     return true;
+  // so can the function a coforall-on over Locales was turned into
+  if (fn->hasFlag(FLAG_COFORALL_ON_TREE))
+    return true;
   // initCopy promoting iterators to arrays can be too
   if (fn->hasFlag(FLAG_INIT_COPY_FN))
     if (fn->numFormals() >= 2)  // definedConst is always the last arg
@@ -1226,6 +1242,7 @@ Symbol* getErrorSymbolFromCheckErrorStmt(Expr* e)
 static bool isCompilerGeneratedFunction(FnSymbol* fn)
 {
   return isTaskFun(fn) ||
+         fn->hasFlag(FLAG_COFORALL_ON_TREE) ||
          fn->hasFlag(FLAG_WRAPPER) ||
          fn->hasFlag(FLAG_COMPILER_GENERATED);
 }
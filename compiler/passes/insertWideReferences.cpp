@@ -133,6 +133,22 @@
 //
 // --------------------------------------------------
 //
+// Local pointer inference:
+//
+// Before propagation we look for local class variables whose every def
+// moves in a value that must be local: a cast of a chpl_here_alloc result,
+// nil, the return of a function whose return symbol is itself local, or
+// another such variable. These variables are never widened. The analysis
+// starts by assuming every candidate is local and drops the ones with a
+// def it can't prove, until nothing changes. Candidates can't have their
+// address taken, be passed by ref, or be returned from virtual functions,
+// since those paths can bring in remote values that the defs don't show.
+// Wherever a wide value is expected instead, fixAST's usual temps widen
+// the narrow value on the current locale. --report-local-pointers prints
+// how many symbols this kept narrow.
+//
+// --------------------------------------------------
+//
 // Future Work:
 //
 // There's a lot of work that could be done to reduce the number of wide
@@ -251,6 +267,11 @@ static std::map<FnSymbol*, bool> downstreamFromOn;
 
 static std::set<Symbol*> fieldsToMakeWide;
 
+// Variables that can only hold local values, and the ones among them
+// that propagation would otherwise have widened.
+static std::set<Symbol*> knownLocals;
+static std::set<Symbol*> narrowedLocals;
+
 // A map from a symbol to the BaseASTs that caused it to be wide
 static std::map<Symbol*, std::set<BaseAST*> > causes;
 
@@ -581,6 +602,11 @@ static void printCauses(Symbol* sym) {
 
 static void setWide(BaseAST* cause, Symbol* sym) {
   if (!typeCanBeWide(sym)) return;
+  if (knownLocals.count(sym)) {
+    debug(sym, "is known to be local, will not widen\n");
+    narrowedLocals.insert(sym);
+    return;
+  }
   if (isArgSymbol(sym) && sym->defPoint->parentSymbol->hasFlag(FLAG_LOCAL_ARGS)) return;
   if (isVarSymbol(sym) && sym->defPoint->parentSymbol->hasFlag(FLAG_ARRAY) && !fNoInferLocalFields) {
     // Do not widen the '_instance' field of an _array record
@@ -605,6 +631,10 @@ static void setValWide(BaseAST* cause, Symbol* sym) {
   if (!typeCanBeWide(sym)) return;
   if (!isObj(valType)) return;
   if (isArgSymbol(sym) && sym->defPoint->parentSymbol->hasFlag(FLAG_LOCAL_ARGS)) return;
+  if (knownLocals.count(sym)) {
+    narrowedLocals.insert(sym);
+    return;
+  }
   if (!valIsWideClass(sym)) {
     fixType(sym, false, true);
     addToQueue(sym);
@@ -867,6 +897,139 @@ static void widenSubAggregateTypes(BaseAST* cause, Type* parent) {
 }
 
 
+//
+// Is 'sym' a c_void_ptr that only holds the result of chpl_here_alloc?
+//
+static bool isHereAllocTemp(Symbol* sym) {
+  if (sym->type != dtCVoidPtr || !defMap.get(sym)) return false;
+
+  for_defs(def, defMap, sym) {
+    CallExpr* move = toCallExpr(def->parentExpr);
+    if (!move || !move->isPrimitive(PRIM_MOVE) || def != move->get(1))
+      return false;
+
+    CallExpr* rhs = toCallExpr(move->get(2));
+    if (!rhs || rhs->resolvedFunction() != gChplHereAlloc)
+      return false;
+  }
+
+  return true;
+}
+
+//
+// Does 'rhs', the source of a move into a known-local candidate, only
+// produce local values?
+//
+static bool isLocalSource(Expr* rhs) {
+  if (SymExpr* se = toSymExpr(rhs)) {
+    return se->symbol() == gNil || knownLocals.count(se->symbol());
+  }
+
+  CallExpr* call = toCallExpr(rhs);
+  if (!call) return false;
+
+  if (call->isPrimitive(PRIM_CAST) || call->isPrimitive(PRIM_DYNAMIC_CAST)) {
+    SymExpr* src = toSymExpr(call->get(2));
+    return src && (knownLocals.count(src->symbol()) ||
+                   isHereAllocTemp(src->symbol()));
+  }
+
+  if (FnSymbol* fn = call->resolvedFunction()) {
+    if (fn->hasFlag(FLAG_EXTERN)) return false;
+    return knownLocals.count(fn->getReturnSymbol());
+  }
+
+  return false;
+}
+
+//
+// Can 'sym' be a local pointer without looking at where its values come
+// from? Anything that could let a remote value in without a def of 'sym'
+// showing it disqualifies the variable.
+//
+static bool isLocalPointerCandidate(VarSymbol* var) {
+  FnSymbol* fn = toFnSymbol(var->defPoint->parentSymbol);
+  if (!fn || !isClass(var->type) || var->isRefOrWideRef()) return false;
+  if (!typeCanBeWide(var) || var->hasFlag(FLAG_HEAP)) return false;
+  if (!defMap.get(var)) return false;
+
+  if (var == fn->getReturnSymbol() && fn->hasFlag(FLAG_VIRTUAL)) return false;
+  forv_Vec(FnSymbol, indirectlyCalledFn, ftableVec) {
+    if (fn == indirectlyCalledFn && var == fn->getReturnSymbol())
+      return false;
+  }
+
+  for_uses(use, useMap, var) {
+    CallExpr* call = toCallExpr(use->parentExpr);
+    if (!call) continue;
+
+    if (call->isPrimitive(PRIM_ADDR_OF) ||
+        call->isPrimitive(PRIM_SET_REFERENCE) ||
+        call->isPrimitive(PRIM_VIRTUAL_METHOD_CALL) ||
+        call->isPrimitive(PRIM_REGISTER_GLOBAL_VAR) ||
+        call->isPrimitive(PRIM_CHPL_COMM_ARRAY_GET) ||
+        call->isPrimitive(PRIM_CHPL_COMM_GET)) {
+      return false;
+    }
+
+    if (call->isResolved() && actual_to_formal(use)->isRefOrWideRef())
+      return false;
+  }
+
+  return true;
+}
+
+//
+// Find the variables that can only hold local class pointers. This is an
+// optimistic fixed point: every candidate is assumed local and candidates
+// with a def from a source that isn't known to be local are dropped.
+//
+static void inferLocalPointers() {
+  if (fNoInferLocalPointers) return;
+
+  std::vector<Symbol*> candidates;
+  forv_Vec(VarSymbol, var, gVarSymbols) {
+    if (var->defPoint->parentSymbol && isLocalPointerCandidate(var)) {
+      knownLocals.insert(var);
+      candidates.push_back(var);
+    }
+  }
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for_vector(Symbol, sym, candidates) {
+      if (!knownLocals.count(sym)) continue;
+
+      for_defs(def, defMap, sym) {
+        CallExpr* move = toCallExpr(def->parentExpr);
+        if (!move ||
+            !(move->isPrimitive(PRIM_MOVE) || move->isPrimitive(PRIM_ASSIGN)) ||
+            def != move->get(1) ||
+            !isLocalSource(move->get(2))) {
+          debug(sym, "may hold a remote value\n");
+          knownLocals.erase(sym);
+          changed = true;
+          break;
+        }
+      }
+    }
+  }
+}
+
+static void reportLocalPointers() {
+  int reported = 0;
+  for_set(Symbol, sym, narrowedLocals) {
+    if (developer || printsUserLocation(sym)) {
+      USR_PRINT(sym, "inferred '%s' to be a local pointer", sym->name);
+      reported++;
+    }
+  }
+  printf("Kept %d class variables narrow (%d at user locations) "
+         "of %d inferred to be local\n",
+         (int)narrowedLocals.size(), reported, (int)knownLocals.size());
+}
+
 //
 // Widen variables that we don't know how to keep narrow.
 //
@@ -2452,6 +2615,8 @@ insertWideReferences(void) {
   buildDefUseMaps(defMap, useMap);
   buildTupleDefsUses();
 
+  inferLocalPointers();
+
   //
   // Track functions downstream in the call-chain from a wrapon_fn
   //
@@ -2492,6 +2657,10 @@ insertWideReferences(void) {
   }
   debugTimer.stop();
 
+  if (fReportLocalPointers) {
+    reportLocalPointers();
+  }
+
   //
   // For codegen purposes, it's easier to represent some fields as a wide type.
   // fixAST() will insert local temps in the case that a field is always
@@ -2534,6 +2703,7 @@ insertWideReferences(void) {
 
   handleIsWidePointer();
 
+  prefetchForallRemoteReads();
 
 #ifdef PRINT_WIDEN_SUMMARY
   printf("Spent %2.3f seconds propagating vars\n", debugTimer.elapsedSecs());
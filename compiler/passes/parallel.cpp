@@ -103,6 +103,7 @@ static BundleArgsFnData bundleArgsFnDataInit = { true, NULL, NULL };
 static int broadcastGlobalID = 0;
 
 static void insertEndCounts();
+static void reportCoforallOnTrees();
 static void passArgsToNestedFns();
 static void create_block_fn_wrapper(FnSymbol* fn, CallExpr* fcall, BundleArgsFnData &baData);
 static void call_block_fn_wrapper(FnSymbol* fn, CallExpr* fcall, VarSymbol* args_buf, VarSymbol* args_buf_len, VarSymbol* tempc, FnSymbol *wrap_fn, Symbol* taskList, Symbol* taskListNode);
@@ -984,6 +985,20 @@ buildHeapType(Type* type) {
 }
 
 
+//
+// A const global of class type only holds a pointer, so every locale
+// can have its own copy of it.  insertWideReferences() widens it if it
+// is used on other locales, so the copies refer to the object on the
+// locale that created it.
+//
+static bool isBroadcastableClassType(Type* type) {
+  return isClass(type) &&
+         !type->symbol->hasFlag(FLAG_EXTERN) &&
+         !type->symbol->hasFlag(FLAG_NO_OBJECT) &&
+         !type->symbol->hasFlag(FLAG_C_PTR_CLASS) &&
+         !type->symbol->hasFlag(FLAG_DATA_CLASS);
+}
+
 //
 // In the following, through makeHeapAllocations():
 //   varSet, varVec - symbols that themselves need to be heap-allocated
@@ -994,6 +1009,7 @@ buildHeapType(Type* type) {
 //    Add it to varSet and varVec.
 //  Otherwise, select module-level vars that are not private or extern.
 //   If the var is const and has value semantics except record-wrapped types,
+//    or is a const class reference,
 //    Insert a prim_private_broadcast call after the def.
 //   Otherwise, if it is a record-wrapped type, replicate it.
 //   Otherwise,
@@ -1022,6 +1038,7 @@ static void findHeapVarsAndRefs(Map<Symbol*, Vec<SymExpr*>*>& defMap,
            is_real_type(def->sym->type)    ||
            is_imag_type(def->sym->type)    ||
            is_complex_type(def->sym->type) ||
+           isBroadcastableClassType(def->sym->type) ||
            (isRecord(def->sym->type)             &&
             !isRecordWrappedType(def->sym->type) &&
             !isSyncType(def->sym->type)          &&
@@ -1030,7 +1047,7 @@ static void findHeapVarsAndRefs(Map<Symbol*, Vec<SymExpr*>*>& defMap,
             // another manner
             !(def->sym->type == dtString && def->sym->isImmediate())))) {
 
-        // replicate global const of primitive/record type
+        // replicate global const of primitive/record/class type
 
         Expr* initialization = def->sym->getInitialization();
 
@@ -1339,6 +1356,10 @@ static void replaceRecordWrappedRefs() {
 void parallel() {
   compute_call_sites();
 
+  if (fReportCoforallOnTree) {
+    reportCoforallOnTrees();
+  }
+
   replaceRecordWrappedRefs();
 
   remoteValueForwarding();
@@ -1358,6 +1379,18 @@ void parallel() {
 }
 
 
+// Show the coforall-on loops over Locales that buildCoforallLoopStmt()
+// turned into spanning tree fan-outs and that survived to here.
+static void reportCoforallOnTrees() {
+  forv_Vec(FnSymbol, fn, gFnSymbols) {
+    if (fn->hasFlag(FLAG_COFORALL_ON_TREE) && fn->inTree() &&
+        (developer || printsUserLocation(fn))) {
+      USR_PRINT(fn, "coforall-on over Locales fans out through a spanning tree");
+    }
+  }
+}
+
+
 /* Lowers PRIM_GET_END_COUNT / PRIM_SET_END_COUNT for
    managing the end-counts for cobegin and coforall.
 
@@ -19,21 +19,50 @@
  */
 
 #include "astutil.h"
+#include "driver.h"
 #include "expr.h"
 #include "passes.h"
+#include "resolution.h"
 #include "stmt.h"
 #include "symbol.h"
+#include "virtualDispatch.h"
+
+#include <set>
+
+static bool returnsLargeRecord(FnSymbol*                  fn,
+                               const std::set<FnSymbol*>& inVmt);
+static void returnRecordByRefArg(FnSymbol* fn);
 
 //
 // returnStarTuplesByRefArgs changes all functions that return star
 // tuples into function that take, as arguments, references to these
 // star tuples and assign the values into these references
 //
+// It does the same for functions returning plain records of at least
+// --return-by-ref-record-size bytes (callDestructors has already done
+// it for records that need copy-init or deinit), see
+// returnRecordByRefArg.
+//
 void returnStarTuplesByRefArgs() {
+  typedef MapElem<Type*, Vec<FnSymbol*>*> VmtMapElem;
+
+  std::set<FnSymbol*> inVmt;
+
   compute_call_sites();
 
+  form_Map(VmtMapElem, el, virtualMethodTable) {
+    if (el->value) {
+      forv_Vec(FnSymbol, fn, *el->value) {
+        inVmt.insert(fn);
+      }
+    }
+  }
+
   forv_Vec(FnSymbol, fn, gFnSymbols) {
-    if ((fn->retType->symbol->hasFlag(FLAG_STAR_TUPLE))) {
+    if (returnsLargeRecord(fn, inVmt)) {
+      returnRecordByRefArg(fn);
+
+    } else if ((fn->retType->symbol->hasFlag(FLAG_STAR_TUPLE))) {
       SET_LINENO(fn);
 
       // MPF 2016-10-02: I expect this code is no longer necessary
@@ -117,3 +146,205 @@ void returnStarTuplesByRefArgs() {
     }
   }
 }
+
+//
+// Return the size in bytes of a record made only of scalar and class
+// fields, or -1 for any other type.
+//
+static int recordSize(Type* t) {
+  if (t == dtBools[BOOL_SIZE_SYS])
+    return 1;
+
+  if (is_bool_type(t) || is_int_type(t) || is_uint_type(t) ||
+      is_real_type(t) || is_imag_type(t) || is_complex_type(t))
+    return get_width(t) / 8;
+
+  if (is_enum_type(t) || isClassLikeOrPtr(t))
+    return 8;
+
+  AggregateType* at = toAggregateType(t);
+
+  if (at == NULL || !at->isRecord() || isRecordWrappedType(at) ||
+      isSyncType(at) || isSingleType(at) || isAtomicType(at) ||
+      at->symbol->hasFlag(FLAG_EXTERN) || !isPOD(at))
+    return -1;
+
+  int size = 0;
+
+  for_fields(field, at) {
+    if (field->isRef())
+      return -1;
+
+    int fieldSize = recordSize(field->type);
+
+    if (fieldSize < 0)
+      return -1;
+
+    size += fieldSize;
+  }
+
+  return size;
+}
+
+static bool returnsLargeRecord(FnSymbol*                  fn,
+                               const std::set<FnSymbol*>& inVmt) {
+  AggregateType* at = toAggregateType(fn->retType);
+
+  if (ret_by_ref_record_size <= 0 || isAlive(fn) == false ||
+      fn->retTag != RET_VALUE || at == NULL || at->isRecord() == false ||
+      at->symbol->hasFlag(FLAG_STAR_TUPLE))
+    return false;
+
+  if (fn->hasFlag(FLAG_EXPORT)        ||
+      fn->hasFlag(FLAG_EXTERN)        ||
+      fn->hasFlag(FLAG_NO_FN_BODY)    ||
+      fn->hasFlag(FLAG_NO_CODEGEN)    ||
+      fn->hasFlag(FLAG_GEN_MAIN_FUNC) ||
+      fn->hasFlag(FLAG_VIRTUAL)       ||
+      fn->hasFlag(FLAG_FN_RETARG))
+    return false;
+
+  if (inVmt.count(fn) != 0 || ftableMap.count(fn) != 0)
+    return false;
+
+  int size = recordSize(at);
+
+  if (size < ret_by_ref_record_size)
+    return false;
+
+  CallExpr* ret = toCallExpr(fn->body->body.tail);
+
+  if (ret == NULL || ret->isPrimitive(PRIM_RETURN) == false ||
+      isSymExpr(ret->get(1)) == false)
+    return false;
+
+  // Every mention of 'fn' must be a direct call of it, either on its
+  // own or as the value of a move
+  for_SymbolSymExprs(se, fn) {
+    CallExpr* call = toCallExpr(se->parentExpr);
+
+    if (call == NULL || call->baseExpr != se)
+      return false;
+
+    if (CallExpr* move = toCallExpr(call->parentExpr)) {
+      if (move->isPrimitive(PRIM_MOVE) == false ||
+          move->get(2)                 != call  ||
+          isSymExpr(move->get(1))      == false)
+        return false;
+
+    } else if (isBlockStmt(call->parentExpr) == false) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//
+// The result can be built in the _retArg formal itself if every mention
+// of the return symbol other than the return itself is one that works
+// the same on a reference: an actual, the base of a field access, or
+// either side of a move to or from a value.
+//
+static bool canBuildInPlace(FnSymbol* fn, Symbol* ret) {
+  if (isVarSymbol(ret) == false || ret->isRef() ||
+      ret->defPoint->parentSymbol != fn)
+    return false;
+
+  for_SymbolSymExprs(se, ret) {
+    CallExpr* call = toCallExpr(se->parentExpr);
+
+    if (call == NULL)
+      return false;
+
+    if (call->isResolved()) {
+      if (call->baseExpr == se)
+        return false;
+
+    } else if (call->isPrimitive(PRIM_SET_MEMBER) ||
+               call->isPrimitive(PRIM_GET_MEMBER) ||
+               call->isPrimitive(PRIM_GET_MEMBER_VALUE)) {
+      if (call->get(1) != se)
+        return false;
+
+    } else if (call->isPrimitive(PRIM_MOVE)) {
+      Expr* rhs = call->get(2);
+
+      if (rhs == se) {
+        if (call->get(1)->isRefOrWideRef())
+          return false;
+
+        continue;
+      }
+
+      if (rhs->isRefOrWideRef())
+        return false;
+
+      if (CallExpr* rhsCall = toCallExpr(rhs)) {
+        if (rhsCall->isResolved() == false)
+          return false;
+
+      } else if (isSymExpr(rhs) == false) {
+        return false;
+      }
+
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//
+// Change a function returning a large plain record to return it through
+// a _retArg formal, as callDestructors does for other records.  When
+// it can, the function builds its result directly in the formal rather
+// than in a local copied out at the end.
+//
+// Each call passes a new temp to the formal and moves it to where the
+// result went.  Since the callee now writes its result while it runs,
+// the temp must not be visible to it; denormalize passes the call's
+// destination in its place when that is safe.
+//
+static void returnRecordByRefArg(FnSymbol* fn) {
+  SET_LINENO(fn);
+
+  Type*      type    = fn->retType;
+  Symbol*    ret     = fn->getReturnSymbol();
+  CallExpr*  retCall = toCallExpr(fn->body->body.tail);
+  ArgSymbol* formal  = new ArgSymbol(INTENT_REF, "_retArg", type);
+
+  formal->addFlag(FLAG_RETARG);
+
+  fn->insertFormalAtTail(formal);
+  fn->addFlag(FLAG_FN_RETARG);
+  fn->retType = dtVoid;
+
+  retCall->get(1)->replace(new SymExpr(gVoid));
+
+  if (canBuildInPlace(fn, ret)) {
+    for_SymbolSymExprs(se, ret) {
+      se->setSymbol(formal);
+    }
+
+    ret->defPoint->remove();
+
+  } else {
+    fn->insertIntoEpilogue(new CallExpr(PRIM_MOVE, formal, ret));
+  }
+
+  forv_Vec(CallExpr, call, *fn->calledBy) {
+    SET_LINENO(call);
+
+    Symbol* tmp = newTemp("ret_tmp", type);
+
+    if (CallExpr* move = toCallExpr(call->parentExpr)) {
+      move->replace(call->remove());
+      call->insertAfter(new CallExpr(PRIM_MOVE, move->get(1)->remove(), tmp));
+    }
+
+    call->insertBefore(new DefExpr(tmp));
+    call->insertAtTail(tmp);
+  }
+}
@@ -451,13 +451,21 @@ static found_init_t doFindInitPoints(Symbol* sym,
 *                                                                             *
 ************************************** | *************************************/
 
+// A conditional branch that doesn't mention a variable copied from in
+// the other branch.  The variable is moved into a temporary there when
+// the copies are elided, so it is dead after the conditional either way.
+// The bool is true for the then branch.
+typedef std::pair<CondStmt*, bool> CopyElisionDrop;
+
 struct CopyElisionState {
   bool lastIsCopy;
   bool foundEndOfStmtMentioning;
   std::vector<CallExpr*> points;
+  std::vector<CopyElisionDrop> drops;
 
   void reset() {
     points.clear();
+    drops.clear();
     lastIsCopy = false;
     foundEndOfStmtMentioning = true;
   }
@@ -540,6 +548,31 @@ static bool findCopyElisionCandidate(CallExpr* call,
   return false;
 }
 
+// Move 'var' into a temporary at the start of the branch that doesn't
+// copy from it.  The temporary is destroyed at the end of the branch.
+static void dropElidedVariable(VarSymbol* var, const CopyElisionDrop& drop) {
+  CondStmt*  cond  = drop.first;
+  BlockStmt* block = drop.second ? cond->thenStmt : cond->elseStmt;
+
+  SET_LINENO(cond);
+
+  if (block == NULL) {
+    block = new BlockStmt();
+    cond->elseStmt = block;
+    insert_help(block, cond, cond->parentSymbol);
+  }
+
+  VarSymbol* tmp = newTemp("copy_elision_drop_tmp", var->type);
+
+  if (var->hasFlag(FLAG_INSERT_AUTO_DESTROY))
+    tmp->addFlag(FLAG_INSERT_AUTO_DESTROY);
+  if (var->hasFlag(FLAG_INSERT_AUTO_DESTROY_FOR_EXPLICIT_NEW))
+    tmp->addFlag(FLAG_INSERT_AUTO_DESTROY_FOR_EXPLICIT_NEW);
+
+  block->insertAtHead(new CallExpr(PRIM_ASSIGN_ELIDED_COPY, tmp, var));
+  block->insertAtHead(new DefExpr(tmp));
+}
+
 static void doElideCopies(VarToCopyElisionState &map) {
   for (VarToCopyElisionState::iterator it = map.begin();
        it != map.end();
@@ -634,6 +667,10 @@ static void doElideCopies(VarToCopyElisionState &map) {
           INT_FATAL("code needs adjustment for throwing initializers");
         }
       }
+
+      for (size_t i = 0; i < state.drops.size(); i++) {
+        dropElidedVariable(var, state.drops[i]);
+      }
     }
   }
 
@@ -659,6 +696,56 @@ static void noteUses(Expr* e, VarToCopyElisionState& map) {
   }
 }
 
+static bool isMentionedIn(VarSymbol* var, BlockStmt* block) {
+  if (block == NULL)
+    return false;
+
+  std::vector<SymExpr*> symExprs;
+  collectSymExprs(block, symExprs);
+  for_vector (SymExpr, se, symExprs) {
+    if (se->symbol() == var)
+      return true;
+  }
+
+  return false;
+}
+
+// Note the copy-inits from variables on one side of a conditional when
+// they are the last mention of the variable on that side and the other
+// side doesn't mention it at all.  Variables declared within the branch
+// are noted as-is, since they can't be mentioned after the conditional.
+static void noteOneSidedCopies(CondStmt* cond, bool inThen,
+                               VarToCopyElisionState& sideMap,
+                               VarToCopyElisionState& otherMap,
+                               VarToCopyElisionState& map,
+                               VariablesSet& eligible) {
+  BlockStmt* other = inThen ? cond->elseStmt : cond->thenStmt;
+
+  for (VarToCopyElisionState::iterator it = sideMap.begin();
+       it != sideMap.end();
+       ++it) {
+    VarSymbol* var = it->first;
+    CopyElisionState& state = it->second;
+
+    if (state.lastIsCopy == false)
+      continue;
+
+    if (eligible.count(var) == 0) {
+      map[var] = state;
+    } else {
+      VarToCopyElisionState::iterator otherIt = otherMap.find(var);
+      bool otherCopies = otherIt != otherMap.end() &&
+                         otherIt->second.lastIsCopy;
+
+      if (otherCopies == false && isMentionedIn(var, other) == false) {
+        CopyElisionState& outer = map[var];
+        outer = state;
+        outer.drops.push_back(CopyElisionDrop(cond, !inThen));
+      }
+    }
+  }
+}
+
 static bool canCopyElideVar(Symbol* rhs) {
   return isVarSymbol(rhs) &&
          !rhs->isRef() &&
@@ -906,13 +993,21 @@ static bool doFindCopyElisionPoints(Expr* start,
               for_vector (CallExpr, point, elseState.points) {
                 state.points.push_back(point);
               }
+              state.drops.insert(state.drops.end(),
+                                 ifState.drops.begin(), ifState.drops.end());
+              state.drops.insert(state.drops.end(),
+                                 elseState.drops.begin(),
+                                 elseState.drops.end());
             }
             ++ifIt;
             ++elseIt;
           }
         }
-        // no need to handle leftovers (e.g. ifIt not at end)
-        // because we marked uses above.
+        // Variables copied from on only one side are OK too if the
+        // other side doesn't mention them. Other leftovers don't need
+        // handling because we marked uses above.
+        noteOneSidedCopies(cond, true, ifMap, elseMap, map, eligible);
+        noteOneSidedCopies(cond, false, elseMap, ifMap, map, eligible);
       }
     } else if (isFunctionOrTypeDeclaration(cur)) {
       // OK: mentions like `proc f() { ... x ... }` don't count
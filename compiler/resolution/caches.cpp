@@ -38,6 +38,39 @@ SymbolMapCache promotionsCache;
 
 static bool isCacheEntryMatch(SymbolMap* s1, SymbolMap* s2);
 
+SymbolMapCacheStats::SymbolMapCacheStats() :
+  entries(0), lookups(0), hits(0), compares(0) { }
+
+void SymbolMapCacheStats::print(const char* name) const {
+  fprintf(stderr, "%s cache: %d entries, %d lookups, %d hits, %d compares\n",
+          name, entries, lookups, hits, compares);
+}
+
+//
+// A hash of the map's key-value pairs that doesn't depend on their
+// order.  Pairs with a NULL value are skipped, like isCacheEntryMatch()
+// treats them as missing.
+//
+static unsigned int hashSymbolMap(SymbolMap* map) {
+  unsigned int retval = 0;
+
+  form_Map(SymbolMapElem, e, *map) {
+    if (e->value != NULL) {
+      uintptr_t k = (uintptr_t) e->key;
+      uintptr_t v = (uintptr_t) e->value;
+      uint64_t  h = (uint64_t) k * 0x9E3779B97F4A7C15ULL ^ (uint64_t) v;
+
+      h ^= h >> 29;
+      h *= 0xBF58476D1CE4E5B9ULL;
+      h ^= h >> 32;
+
+      retval += (unsigned int) h;
+    }
+  }
+
+  return retval;
+}
+
 SymbolMapCacheEntry::SymbolMapCacheEntry(FnSymbol* ifn, SymbolMap* imap) :
   fn(ifn), map(*imap) { }
 
@@ -47,26 +80,32 @@ addCache(SymbolMapCache& cache,
          FnSymbol*       oldFn,
          FnSymbol*       fn,
          SymbolMap*      map) {
-  Vec<SymbolMapCacheEntry*>* entries = cache.get(oldFn);
-  SymbolMapCacheEntry*       entry   = new SymbolMapCacheEntry(fn, map);
-
-  if (entries) {
-    entries->add(entry);
+  SymbolMapCacheEntry* entry = new SymbolMapCacheEntry(fn, map);
 
-  } else {
-    entries = new Vec<SymbolMapCacheEntry*>();
-    entries->add(entry);
-    cache.put(oldFn, entries);
-  }
+  cache.fns[oldFn][hashSymbolMap(map)].push_back(entry);
+  cache.stats.entries++;
 }
 
 
 FnSymbol*
 checkCache(SymbolMapCache& cache, FnSymbol* oldFn, SymbolMap* map) {
-  if (Vec<SymbolMapCacheEntry*>* entries = cache.get(oldFn)) {
-    forv_Vec(SymbolMapCacheEntry, entry, *entries) {
-      if (isCacheEntryMatch(map, &entry->map))
-        return entry->fn;
+  std::map<FnSymbol*, SymbolMapCacheBuckets>::iterator fnIt;
+
+  cache.stats.lookups++;
+
+  fnIt = cache.fns.find(oldFn);
+  if (fnIt != cache.fns.end()) {
+    SymbolMapCacheBuckets::iterator it =
+      fnIt->second.find(hashSymbolMap(map));
+
+    if (it != fnIt->second.end()) {
+      for_vector(SymbolMapCacheEntry, entry, it->second) {
+        cache.stats.compares++;
+        if (isCacheEntryMatch(map, &entry->map)) {
+          cache.stats.hits++;
+          return entry->fn;
+        }
+      }
     }
   }
   return NULL;
@@ -75,13 +114,18 @@ checkCache(SymbolMapCache& cache, FnSymbol* oldFn, SymbolMap* map) {
 
 void
 freeCache(SymbolMapCache& cache) {
-  form_Map(SymbolMapCacheElem, elem, cache) {
-    forv_Vec(SymbolMapCacheEntry, entry, *elem->value) {
-      delete entry;
+  std::map<FnSymbol*, SymbolMapCacheBuckets>::iterator fnIt;
+
+  for (fnIt = cache.fns.begin(); fnIt != cache.fns.end(); ++fnIt) {
+    SymbolMapCacheBuckets::iterator it;
+
+    for (it = fnIt->second.begin(); it != fnIt->second.end(); ++it) {
+      for_vector(SymbolMapCacheEntry, entry, it->second) {
+        delete entry;
+      }
     }
-    delete elem->value;
   }
-  cache.clear();
+  cache.fns.clear();
 }
 
 static bool isCacheEntryMatch(SymbolMap* s1, SymbolMap* s2) {
@@ -243,17 +287,10 @@ addCache(SymbolMapScopeCache& cache,
          FnSymbol*       oldFn,
          FnSymbol*       fn,
          SymbolMap*      map) {
-  Vec<SymbolMapScopeCacheEntry*>* entries = cache.get(oldFn);
-  SymbolMapScopeCacheEntry*       entry = new SymbolMapScopeCacheEntry(fn, map);
+  SymbolMapScopeCacheEntry* entry = new SymbolMapScopeCacheEntry(fn, map);
 
-  if (entries) {
-    entries->add(entry);
-
-  } else {
-    entries = new Vec<SymbolMapScopeCacheEntry*>();
-    entries->add(entry);
-    cache.put(oldFn, entries);
-  }
+  cache.fns[oldFn][hashSymbolMap(map)].push_back(entry);
+  cache.stats.entries++;
 }
 
 
@@ -264,11 +301,24 @@ FnSymbol*
 checkCache(SymbolMapScopeCache& cache, FnSymbol* oldFn,
            VisibilityInfo* visInfo, SymbolMap* map)
 {
-  if (Vec<SymbolMapScopeCacheEntry*>* entries = cache.get(oldFn)) {
-    forv_Vec(SymbolMapScopeCacheEntry, entry, *entries) {
-      if (isCacheEntryMatch(map, &entry->map) &&
-          (visInfo == NULL || isApplicableInstantiation(*visInfo, entry->fn)) )
-        return entry->fn;
+  std::map<FnSymbol*, SymbolMapScopeCacheBuckets>::iterator fnIt;
+
+  cache.stats.lookups++;
+
+  fnIt = cache.fns.find(oldFn);
+  if (fnIt != cache.fns.end()) {
+    SymbolMapScopeCacheBuckets::iterator it =
+      fnIt->second.find(hashSymbolMap(map));
+
+    if (it != fnIt->second.end()) {
+      for_vector(SymbolMapScopeCacheEntry, entry, it->second) {
+        cache.stats.compares++;
+        if (isCacheEntryMatch(map, &entry->map) &&
+            (visInfo == NULL || isApplicableInstantiation(*visInfo, entry->fn)) ) {
+          cache.stats.hits++;
+          return entry->fn;
+        }
+      }
     }
   }
 
@@ -278,13 +328,18 @@ checkCache(SymbolMapScopeCache& cache, FnSymbol* oldFn,
 
 void
 freeCache(SymbolMapScopeCache& cache) {
-  form_Map(SymbolMapScopeCacheElem, elem, cache) {
-    forv_Vec(SymbolMapScopeCacheEntry, entry, *elem->value) {
-      delete entry;
+  std::map<FnSymbol*, SymbolMapScopeCacheBuckets>::iterator fnIt;
+
+  for (fnIt = cache.fns.begin(); fnIt != cache.fns.end(); ++fnIt) {
+    SymbolMapScopeCacheBuckets::iterator it;
+
+    for (it = fnIt->second.begin(); it != fnIt->second.end(); ++it) {
+      for_vector(SymbolMapScopeCacheEntry, entry, it->second) {
+        delete entry;
+      }
     }
-    delete elem->value;
   }
-  cache.clear();
+  cache.fns.clear();
 }
 
 //
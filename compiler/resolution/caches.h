@@ -23,6 +23,9 @@
 
 #include "baseAST.h"
 
+#include <map>
+#include <vector>
+
 class CalledFunInfo;
 class VisibilityInfo;
 class GenericsCacheInfo;
@@ -41,6 +44,23 @@ class ResolutionCandidate;
 //
 //   freeCache(cache): frees memory associated with cache
 //
+// The entries for each function are bucketed by a hash of their map
+// that doesn't depend on the order of its elements, so checkCache only
+// compares the maps that hash alike.  Within a bucket, entries are kept
+// in the order they were added.
+//
+class SymbolMapCacheStats {
+public:
+  SymbolMapCacheStats();
+
+  void print(const char* name) const;
+
+  int entries;      // entries added
+  int lookups;      // calls to checkCache
+  int hits;         // lookups that returned a function
+  int compares;     // maps compared element by element
+};
+
 class SymbolMapCacheEntry {
 public:
   SymbolMapCacheEntry(FnSymbol* ifn, SymbolMap* imap);
@@ -49,9 +69,14 @@ public:
   SymbolMap map;
 };
 
-typedef Map<FnSymbol*,     Vec<SymbolMapCacheEntry*>*> SymbolMapCache;
-typedef MapElem<FnSymbol*, Vec<SymbolMapCacheEntry*>*> SymbolMapCacheElem;
+typedef std::map<unsigned int, std::vector<SymbolMapCacheEntry*> >
+                                                        SymbolMapCacheBuckets;
 
+class SymbolMapCache {
+public:
+  std::map<FnSymbol*, SymbolMapCacheBuckets> fns;
+  SymbolMapCacheStats                        stats;
+};
 
 void      addCache(SymbolMapCache& cache,
                    FnSymbol*       oldFn,
@@ -89,6 +114,8 @@ extern SymbolMapCache promotionsCache;
 //
 //   freeCache(cache): frees memory associated with cache
 //
+// The entries are bucketed like those of a SymbolMapCache.
+//
 class SymbolMapScopeCacheEntry {
 public:
   SymbolMapScopeCacheEntry(FnSymbol* ifn, SymbolMap* imap);
@@ -97,8 +124,14 @@ public:
   SymbolMap map;
 };
 
-typedef Map<FnSymbol*,     Vec<SymbolMapScopeCacheEntry*>*> SymbolMapScopeCache;
-typedef MapElem<FnSymbol*, Vec<SymbolMapScopeCacheEntry*>*> SymbolMapScopeCacheElem;
+typedef std::map<unsigned int, std::vector<SymbolMapScopeCacheEntry*> >
+                                                   SymbolMapScopeCacheBuckets;
+
+class SymbolMapScopeCache {
+public:
+  std::map<FnSymbol*, SymbolMapScopeCacheBuckets> fns;
+  SymbolMapCacheStats                             stats;
+};
 
 void      addCache(SymbolMapScopeCache& cache,
                    FnSymbol*       oldFn,
@@ -53,6 +53,7 @@
 #include "postFold.h"
 #include "preFold.h"
 #include "ResolutionCandidate.h"
+#include "resolutionProfile.h"
 #include "resolveFunction.h"
 #include "resolveIntents.h"
 #include "scopeResolve.h"
@@ -3437,6 +3438,8 @@ static FnSymbol* resolveNormalCall(CallInfo& info, check_state_t checkState) {
 
   findVisibleFunctionsAndCandidates(info, visInfo, mostApplicable, candidates);
 
+  profileCandidates(candidates);
+
   numMatches = disambiguateByMatch(info, candidates,
                                    bestRef, bestCref, bestVal);
 
@@ -9042,10 +9045,20 @@ void resolve() {
   if (fPrintUnusedFns || fPrintUnusedInternalFns)
     printUnusedFunctions();
 
+  printResolutionProfile();
+
   pruneResolvedTree();
 
   resolveForallStmts2();
 
+  removeProvenBoundsChecks();
+
+  // --print-statistics c
+  if (strchr(fPrintStatistics, 'c') != NULL) {
+    genericsCache.stats.print("generics");
+    promotionsCache.stats.print("promotions");
+  }
+
   freeCache(genericsCache);
   freeCache(promotionsCache);
 
@@ -28,6 +28,7 @@
 #include "PartialCopyData.h"
 #include "passes.h"
 #include "resolveFunction.h"
+#include "resolutionProfile.h"
 #include "resolveIntents.h"
 #include "stmt.h"
 #include "stringutil.h"
@@ -432,6 +433,7 @@ FnSymbol* instantiateSignature(FnSymbol*  fn,
       // We could not find any cached version. So, add the just-created
       // instantiation to the cache.
       addCache(genericsCache, root, newFn, &allSubs);
+      profileInstantiation(root);
       // And the version without defaultExprs
       if (hasGenericDefaultExpr)
         addCache(genericsCache, root, newFn, &allSubsBeforeDefaultExprs);
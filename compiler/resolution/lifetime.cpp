@@ -376,6 +376,8 @@ static void printLifetimeState(LifetimeState* state);
 static void printDeinitOrderTree(const char* prefix,  DeinitOrderNode* node);
 static void handleDebugOutputOnError(Expr* e, LifetimeState* state);
 static bool shouldCheckLifetimesInFn(FnSymbol* fn);
+static bool needsLifetimeInference(LifetimeState* state, FnSymbol* fn,
+                                   bool debugging);
 static void markArgumentsReturnScope(FnSymbol* fn);
 static void checkFunction(FnSymbol* fn);
 
@@ -442,6 +444,15 @@ void checkLifetimesInFunction(FnSymbol* fn) {
   gather.lifetimes = &state;
   fn->accept(&gather);
 
+  if (needsLifetimeInference(&state, fn, debugging) == false) {
+    // Nothing will read the lifetimes, but the ends of any foralls
+    // still need to be marked.
+    for_set(FnSymbol, inFn, state.inFns) {
+      checkLifetimesForForallUnorderedOps(inFn, NULL);
+    }
+    return;
+  }
+
   // Compute the deinitialization order for local variables
   DeinitOrderVisitor order(&state, debugging);
   fn->accept(&order);
@@ -902,6 +913,27 @@ static bool shouldCheckLifetimesInFn(FnSymbol* fn) {
   return !fNoLifetimeChecking;
 }
 
+// The inferred lifetimes are only used to emit errors for fn and to let
+// the forall unordered ops optimization check the last statements of
+// foralls.  Compiler-generated and task functions often need neither.
+static bool needsLifetimeInference(LifetimeState* state, FnSymbol* fn,
+                                   bool debugging) {
+  if (debugging || shouldCheckLifetimesInFn(fn))
+    return true;
+
+  if (fNoOptimizeForallUnordered)
+    return false;
+
+  for_set(FnSymbol, inFn, state->inFns) {
+    std::vector<ForallStmt*> foralls;
+    collectForallStmts(inFn, foralls);
+    if (foralls.size() > 0)
+      return true;
+  }
+
+  return false;
+}
+
 static bool debuggingLifetimesForFn(FnSymbol* fn)
 {
   if (!fn) return false;
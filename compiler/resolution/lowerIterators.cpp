@@ -39,6 +39,10 @@
 #include "view.h"
 #include "wellknown.h"
 
+#include <map>
+#include <set>
+#include <vector>
+
 bool iteratorsLowered = false;
 
 //
@@ -325,6 +329,217 @@ static bool isCallVectorHazard(CallExpr* call,
   return hazard;
 }
 
+//
+// Reductions of numbers with builtin operators, e.g. '+ reduce A', don't
+// need to go through the reduce op's accumulateOntoState() for each element.
+// Replace those calls in forall bodies with the operation itself on the
+// task's accumulation state, which leaves a loop the back end can vectorize.
+// The reduce op is still used to combine the task states at the end.
+//
+
+enum SpecializedReduceOp {
+  REDUCE_OP_NONE,
+  REDUCE_OP_SUM,
+  REDUCE_OP_PRODUCT,
+  REDUCE_OP_MIN,
+  REDUCE_OP_MAX,
+  REDUCE_OP_BITWISE_AND,
+  REDUCE_OP_BITWISE_OR,
+  REDUCE_OP_BITWISE_XOR
+};
+
+// The reduce intents whose accumulation was specialized.
+static std::set<ShadowVarSymbol*> specializedReductions;
+
+static SpecializedReduceOp getSpecializedReduceOp(Type* opType,
+                                                  Type* accumType) {
+  const char* name    = opType->symbol->name;
+  bool        isInt   = is_int_type(accumType) || is_uint_type(accumType);
+  bool        isReal  = is_real_type(accumType);
+
+  if (startsWith(name, "SumReduceScanOp") &&
+      (isInt || isReal || is_imag_type(accumType)))
+    return REDUCE_OP_SUM;
+
+  if (startsWith(name, "ProductReduceScanOp") && (isInt || isReal))
+    return REDUCE_OP_PRODUCT;
+
+  if (startsWith(name, "MinReduceScanOp") && (isInt || isReal))
+    return REDUCE_OP_MIN;
+
+  if (startsWith(name, "MaxReduceScanOp") && (isInt || isReal))
+    return REDUCE_OP_MAX;
+
+  if (startsWith(name, "BitwiseAndReduceScanOp") && isInt)
+    return REDUCE_OP_BITWISE_AND;
+
+  if (startsWith(name, "BitwiseOrReduceScanOp") && isInt)
+    return REDUCE_OP_BITWISE_OR;
+
+  if (startsWith(name, "BitwiseXorReduceScanOp") && isInt)
+    return REDUCE_OP_BITWISE_XOR;
+
+  return REDUCE_OP_NONE;
+}
+
+// Is 'call' op.accumulateOntoState(AS, x) for this reduce intent?
+static bool isAccumulateOntoState(CallExpr* call, ShadowVarSymbol* AS,
+                                  ShadowVarSymbol* op) {
+  FnSymbol* fn = call->resolvedFunction();
+
+  if (fn == NULL || fn->name != astr("accumulateOntoState") ||
+      call->numActuals() != 4)
+    return false;
+
+  SymExpr* opSe    = toSymExpr(call->get(2));
+  SymExpr* stateSe = toSymExpr(call->get(3));
+  SymExpr* eltSe   = toSymExpr(call->get(4));
+
+  return opSe    != NULL && opSe->symbol()    == op &&
+         stateSe != NULL && stateSe->symbol() == AS &&
+         eltSe   != NULL && eltSe->getValType() == AS->type;
+}
+
+static void specializeAccumulate(CallExpr* call, ShadowVarSymbol* AS,
+                                 SpecializedReduceOp kind) {
+  SET_LINENO(call);
+
+  Symbol* elt = toSymExpr(call->get(4))->symbol();
+
+  if (elt->isRef()) {
+    VarSymbol* deref = newTemp("reduce_elt", AS->type);
+    call->insertBefore(new DefExpr(deref));
+    call->insertBefore(new CallExpr(PRIM_MOVE, deref,
+                                    new CallExpr(PRIM_DEREF, elt)));
+    elt = deref;
+  }
+
+  if (kind == REDUCE_OP_MIN || kind == REDUCE_OP_MAX) {
+    // state = min(state, x), i.e. if state < x then state else x
+    PrimitiveTag cmpTag = kind == REDUCE_OP_MIN ? PRIM_LESS : PRIM_GREATER;
+    VarSymbol*   cmp    = newTemp("reduce_cmp", dtBool);
+
+    call->insertBefore(new DefExpr(cmp));
+    call->insertBefore(new CallExpr(PRIM_MOVE, cmp,
+                                    new CallExpr(cmpTag, AS, elt)));
+    call->insertBefore(new CondStmt(new SymExpr(cmp),
+                                    new BlockStmt(),
+                                    new CallExpr(PRIM_ASSIGN, AS, elt)));
+
+  } else {
+    PrimitiveTag tag = PRIM_ADD;
+
+    switch (kind) {
+      case REDUCE_OP_SUM:         tag = PRIM_ADD;  break;
+      case REDUCE_OP_PRODUCT:     tag = PRIM_MULT; break;
+      case REDUCE_OP_BITWISE_AND: tag = PRIM_AND;  break;
+      case REDUCE_OP_BITWISE_OR:  tag = PRIM_OR;   break;
+      case REDUCE_OP_BITWISE_XOR: tag = PRIM_XOR;  break;
+      default:                    INT_FATAL(call, "unexpected reduce op");
+    }
+
+    VarSymbol* result = newTemp("reduce_tmp", AS->type);
+
+    call->insertBefore(new DefExpr(result));
+    call->insertBefore(new CallExpr(PRIM_MOVE, result,
+                                    new CallExpr(tag, AS, elt)));
+    call->insertBefore(new CallExpr(PRIM_ASSIGN, AS, result));
+  }
+
+  call->remove();
+}
+
+static void specializeReductions() {
+  if (fNoSpecializeReductions)
+    return;
+
+  forv_Vec(ForallStmt, forall, gForallStmts) {
+    if (forall->inTree() == false)
+      continue;
+
+    for_shadow_vars (shadow, temp, forall) {
+      if (shadow->isReduce() == false)
+        continue;
+
+      ShadowVarSymbol* op = shadow->ReduceOpForAccumState();
+
+      if (op == NULL)
+        continue;
+
+      SpecializedReduceOp kind = getSpecializedReduceOp(op->type,
+                                                        shadow->type);
+
+      if (kind == REDUCE_OP_NONE)
+        continue;
+
+      std::vector<CallExpr*> calls;
+      collectCallExprs(forall->loopBody(), calls);
+
+      for_vector(CallExpr, call, calls) {
+        // Only calls that are statements; the call returns nothing
+        if (call == call->getStmtExpr() &&
+            isAccumulateOntoState(call, shadow, op)) {
+          specializeAccumulate(call, shadow, kind);
+          specializedReductions.insert(shadow);
+        }
+      }
+    }
+  }
+}
+
+//
+// With --report-shared-writes, point out forall loops whose body writes an
+// outer scalar through a 'ref' intent.  Every task then writes the same
+// cache line, which stops these loops from scaling; a reduce intent or a
+// task-private variable avoids that.
+//
+
+static bool isWrittenIn(ShadowVarSymbol* svar, BlockStmt* body) {
+  std::vector<SymExpr*> symExprs;
+  collectSymExprsFor(body, svar, symExprs);
+
+  for_vector(SymExpr, se, symExprs) {
+    if (CallExpr* call = toCallExpr(se->parentExpr)) {
+      if (call->isPrimitive(PRIM_ASSIGN) && call->get(1) == se)
+        return true;
+
+      if (call->resolvedFunction() != NULL) {
+        for_formals_actuals(formal, actual, call) {
+          if (actual == se && formal->intent == INTENT_REF)
+            return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+static void reportSharedWrites() {
+  if (fReportSharedWrites == false)
+    return;
+
+  forv_Vec(ForallStmt, forall, gForallStmts) {
+    if (forall->inTree() == false)
+      continue;
+
+    ModuleSymbol* mod = forall->getModule();
+
+    if (developer == false && mod->modTag != MOD_USER)
+      continue;
+
+    for_shadow_vars (shadow, temp, forall) {
+      if (shadow->intent        == TFI_REF &&
+          shadow->outerVarSym() != NULL    &&
+          isPrimitiveScalar(shadow->getValType()) &&
+          isWrittenIn(shadow, forall->loopBody())) {
+        USR_PRINT(forall, "all tasks of this forall write '%s'",
+                  shadow->outerVarSym()->name);
+      }
+    }
+  }
+}
+
 static void markVectorizableForallLoops()
 {
   std::map<FnSymbol*, bool> fnHasVectorHazard;
@@ -402,6 +617,14 @@ static void markVectorizableForallLoops()
           Type* accumType = shadow->type;
           Type* opType = op->type;
           bool ok = false;
+          // Reductions accumulated directly with a builtin operation
+          // that the back end recognizes as a reduction are OK too.
+          if (specializedReductions.count(shadow) != 0) {
+            SpecializedReduceOp kind = getSpecializedReduceOp(opType,
+                                                              accumType);
+            if (kind != REDUCE_OP_MIN && kind != REDUCE_OP_MAX)
+              ok = true;
+          }
           // Only vectorize + reductions on numbers
           if (is_int_type(accumType) ||
               is_uint_type(accumType) ||
@@ -819,6 +1042,8 @@ replaceIteratorFormals(FnSymbol* iterator, Symbol* ic,
 }
 
 static Map<FnSymbol*,FnSymbol*> iteratorFnMap;
+// The loop body wrappers each recursive iterator function is called with.
+static std::map<FnSymbol*, std::vector<FnSymbol*> > loopBodyFnWrappersMap;
 static FnSymbol* argBundleCopyFn = NULL;
 static FnSymbol* argBundleFreeFn = NULL;
 static AggregateType*  argBundleType = NULL;
@@ -1461,6 +1686,139 @@ expandRecursiveIteratorInline(ForLoop* forLoop)
 
     iteratorFnCall->insertAtTail(argBundleTmp);
   }
+
+  loopBodyFnWrappersMap[iteratorFn].push_back(loopBodyFnWrapper);
+}
+
+
+//
+// Is the body of 'forLoop' just a converted 'yield' of its index, i.e.
+//
+//   def tmp; move tmp, index; ... ftable_call(idArg, tmp, argsArg)
+//
+// with nothing else that could observe the values?
+//
+static bool isYieldForwardingBody(ForLoop* forLoop, Symbol* idArg,
+                                  Symbol* argsArg) {
+  std::set<Symbol*> defined;
+  std::set<Symbol*> chain;
+  bool forwarded = false;
+
+  chain.insert(forLoop->indexGet()->symbol());
+
+  for_alist(stmt, forLoop->body) {
+    if (DefExpr* def = toDefExpr(stmt)) {
+      defined.insert(def->sym);
+      continue;
+    }
+
+    CallExpr* call = toCallExpr(stmt);
+    if (call == NULL || forwarded)
+      return false;
+
+    if (call->isPrimitive(PRIM_END_OF_STATEMENT)) {
+      continue;
+    } else if (call->isPrimitive(PRIM_MOVE)) {
+      SymExpr* lhs = toSymExpr(call->get(1));
+      SymExpr* rhs = toSymExpr(call->get(2));
+      if (lhs == NULL || rhs == NULL ||
+          defined.count(lhs->symbol()) == 0 ||
+          chain.count(rhs->symbol()) == 0)
+        return false;
+      chain.insert(lhs->symbol());
+    } else if (call->isPrimitive(PRIM_FTABLE_CALL)) {
+      SymExpr* id = toSymExpr(call->get(1));
+      SymExpr* idx = toSymExpr(call->get(2));
+      SymExpr* args = toSymExpr(call->get(3));
+      if (id == NULL || idx == NULL || args == NULL ||
+          id->symbol() != idArg || args->symbol() != argsArg ||
+          chain.count(idx->symbol()) == 0)
+        return false;
+      forwarded = true;
+    } else {
+      return false;
+    }
+  }
+
+  return forwarded;
+}
+
+
+//
+// Within the function created for a recursive iterator, a loop like
+//
+//   for x in iter(args) do yield x;
+//
+// would otherwise get its own loop body function that calls the outer
+// loop body through the function table, so a value yielded at depth d
+// costs d indirect calls.  Instead, call the iterator function directly,
+// passing along the loop body it was given.
+//
+// Returns true if the loop was replaced.
+//
+static bool forwardRecursiveIteratorLoop(ForLoop* forLoop,
+                                         FnSymbol* iterator) {
+  FnSymbol* iteratorFn = iteratorFnMap.get(iterator);
+
+  if (iteratorFn == NULL ||
+      forLoop->parentSymbol != iteratorFn ||
+      iteratorFn->hasFlag(FLAG_ITERATOR_WITH_ON))
+    return false;
+
+  Symbol* ic = forLoop->iteratorGet()->symbol();
+  ArgSymbol* icArg = iteratorFn->getFormal(1);
+  ArgSymbol* loopBodyFnIDArg = iteratorFn->getFormal(2);
+  ArgSymbol* loopBodyFnArgArgs = iteratorFn->getFormal(3);
+
+  if (icArg->type != ic->type ||
+      !isYieldForwardingBody(forLoop, loopBodyFnIDArg, loopBodyFnArgArgs))
+    return false;
+
+  SET_LINENO(forLoop);
+  forLoop->insertBefore(new CallExpr(iteratorFn, ic, loopBodyFnIDArg,
+                                     loopBodyFnArgArgs));
+  forLoop->remove();
+  return true;
+}
+
+
+//
+// Once all the loops are expanded, a recursive iterator function that is
+// only ever run with one loop body can call it directly rather than
+// through the function table, which lets the back end inline it.  The
+// wrapper stays in the table because the argument bundle copy and free
+// functions still select on its ID.
+//
+static void devirtualizeRecursiveLoopBodyCalls() {
+  std::map<FnSymbol*, std::vector<FnSymbol*> >::iterator it;
+
+  for (it = loopBodyFnWrappersMap.begin();
+       it != loopBodyFnWrappersMap.end();
+       ++it) {
+    FnSymbol* iteratorFn = it->first;
+    if (it->second.size() != 1 || !isAlive(iteratorFn))
+      continue;
+
+    FnSymbol* wrapper = it->second[0];
+    ArgSymbol* loopBodyFnIDArg = iteratorFn->getFormal(2);
+    if (wrapper->getFormal(2)->type != iteratorFn->getFormal(3)->type)
+      continue;
+
+    std::vector<CallExpr*> calls;
+    collectCallExprs(iteratorFn, calls);
+    for_vector(CallExpr, call, calls) {
+      if (call->isPrimitive(PRIM_FTABLE_CALL) &&
+          toSymExpr(call->get(1))->symbol() == loopBodyFnIDArg &&
+          call->get(2)->typeInfo() == wrapper->getFormal(1)->type) {
+        SET_LINENO(call);
+        Expr* args = call->get(3)->remove();
+        Expr* index = call->get(2)->remove();
+        call->replace(new CallExpr(wrapper, index, args));
+      }
+    }
+  }
+
+  loopBodyFnWrappersMap.clear();
 }
 
 
@@ -1563,7 +1921,8 @@ expandIteratorInline(ForLoop* forLoop) {
       // test/library/standard/FileSystem/filerator/bradc/findfiles-par.chpl
       return false;
     } else {
-      expandRecursiveIteratorInline(forLoop);
+      if (!forwardRecursiveIteratorLoop(forLoop, iterator))
+        expandRecursiveIteratorInline(forLoop);
       INT_ASSERT(!forLoop->inTree());
       return true;
     }
@@ -2323,6 +2682,44 @@ buildIteratorCall(Symbol* ret, int fnid, Symbol* iterator, Vec<Type*>& children)
   return outerBlock;
 }
 
+//
+// Should the first iterand of a zippered loop be inlined, with the other
+// iterands advanced through the iterator class protocol in its loop body?
+// This pays off when the first iterand would otherwise need a re-entrant
+// advance function; single loop iterators already lower to a tight loop.
+// The first iterand has to be bounded since it ends the loop, and the body
+// can't jump out since that would skip the other iterands' break blocks.
+//
+static bool canInlineZipperedLeader(ForLoop* forLoop, Symbol* leader) {
+  if (fNoInlineIterators || !forLoop->zipperedGet())
+    return false;
+
+  FnSymbol* iterFn = getTheIteratorFn(leader);
+  Vec<Type*> children;
+  getIteratorChildren(children, leader->type);
+
+  if (iterFn->iteratorInfo == NULL ||
+      children.n > 0 ||
+      !canInlineIterator(iterFn) ||
+      isVirtualIterator(iterFn) ||
+      !isBoundedIterator(iterFn) ||
+      iterFn->throwsError() ||
+      iterFn->hasFlag(FLAG_RECURSIVE_ITERATOR) ||
+      iterFn->hasFlag(FLAG_YIELD_WITHIN_ON) ||
+      iterFn->hasFlag(FLAG_VECTORIZE_YIELDING_LOOPS))
+    return false;
+
+  std::vector<GotoStmt*> gotos;
+  collectGotoStmts(forLoop, gotos);
+  if (gotos.size() > 0)
+    return false;
+
+  iterFn->collapseBlocks();
+  Vec<BaseAST*> asts;
+  collect_asts_postorder(iterFn, asts);
+  return isSingleLoopIterator(iterFn, asts) == NULL;
+}
+
 // Replace a ForLoop with its inline equivalent, if possible.
 // Otherwise, convert it into a C-style for loop.
 // The given forLoop is converted unconditionally.
@@ -2392,12 +2789,20 @@ expandForLoop(ForLoop* forLoop) {
 
     setupSimultaneousIterators(iterators, indices, iterator, index, forLoop);
 
+    // If the first iterand is inlined, the loop below only handles the
+    // others, and their init and incr calls go in the loop body rather
+    // than in the header of a c for loop.
+    bool inlineLeader = canInlineZipperedLeader(forLoop, iterators.v[0]);
+
+    bool reportZip = fReportInlinedIterators &&
+                     (developer || forLoop->getModule()->modTag == MOD_USER);
+
     bool allOrderIndependent = true;
     // For each iterator we add the zip* functions in the appropriate place and
     // if bounds checking was on, we insert the code for that. Note that this
     // code handles iterators that have regular loops, c for loops, and
     // dynamically dispatched iterators. The ordering is VERY important!
-    for (int i = 0; i < iterators.n; i++) {
+    for (int i = inlineLeader ? 1 : 0; i < iterators.n; i++) {
       Vec<Type*> children;
       VarSymbol* cond         = newTemp("_cond", dtBool);
       bool       isNotDynIter = false;
@@ -2412,7 +2817,7 @@ expandForLoop(ForLoop* forLoop) {
 
       isNotDynIter = (children.n == 0);
 
-      if (isNotDynIter) {
+      if (isNotDynIter && !inlineLeader) {
         // add the init, and incr functions to the init, and incr blocks of the
         // c for loop. If the underlying iterator does not have a c for loop,
         // these blocks will be empty
@@ -2439,7 +2844,7 @@ expandForLoop(ForLoop* forLoop) {
       }
 
       if (isBoundedIterator(iterFn)) {
-        if (testBlock == NULL) {
+        if (testBlock == NULL && !inlineLeader) {
           if (isNotDynIter) {
             // note that we have found the first test
             testBlock = buildIteratorCall(NULL, HASMORE, iterators.v[i], children);
@@ -2501,6 +2906,11 @@ expandForLoop(ForLoop* forLoop) {
         if (LoopStmt* loop = LoopStmt::findEnclosingLoop(singleLoopYield)) {
           curOrderIndependent = loop->isOrderIndependent();
         }
+      } else if (reportZip) {
+        printf("Zippered iterand %d (%s) in module %s (%s:%d) "
+               "needs an advance function\n", i + 1, iterFn->cname,
+               forLoop->getModule()->name, forLoop->fname(),
+               forLoop->linenum());
       }
       allOrderIndependent = allOrderIndependent && curOrderIndependent;
     }
@@ -2519,6 +2929,20 @@ expandForLoop(ForLoop* forLoop) {
     if (index != gNone)
       forLoop->insertAtHead(index->defPoint->remove());
 
+    if (inlineLeader) {
+      // Iterate over the first iterand alone and inline it.  The body now
+      // advances the other iterands and assembles the tuple index from
+      // the first iterand's index.
+      Symbol* leaderIndex = indices.v[0];
+      forLoop->insertBefore(leaderIndex->defPoint->remove());
+      forLoop->indexGet()->setSymbol(leaderIndex);
+      forLoop->iteratorGet()->setSymbol(iterators.v[0]);
+
+      bool converted = expandIteratorInline(forLoop);
+      INT_ASSERT(converted);
+      return;
+    }
+
     // Ensure that the test clause for completely unbounded loops contains
     // something.
     // testBlock is only non-NULL if isBoundedIterator() evaluates to true for
@@ -2950,6 +3374,10 @@ static void removeUncalledIterators()
 void lowerIterators() {
   nonLeaderParCheck();
 
+  reportSharedWrites();
+
+  specializeReductions();
+
   markVectorizableForallLoops();
 
   computeRecursiveIteratorSet();
@@ -2992,6 +3420,8 @@ void lowerIterators() {
       expandForLoop(loop);
   }
 
+  devirtualizeRecursiveLoopBodyCalls();
+
   if (fVerify) {
     for_alive_in_Vec(BlockStmt, block, gBlockStmts)
       if (block->isForLoop())
@@ -575,6 +575,11 @@ static Expr* preFoldPrimOp(CallExpr* call) {
     call->replace(retval);
     break;
 
+  case PRIM_PROVEN_IN_BOUNDS:
+    retval = preFoldProvenInBounds(call);
+    call->replace(retval);
+    break;
+
   case PRIM_CALL_RESOLVES:
   case PRIM_CALL_AND_FN_RESOLVES:
   case PRIM_METHOD_CALL_RESOLVES:
@@ -893,6 +898,25 @@ static Expr* preFoldPrimOp(CallExpr* call) {
     break;
   }
 
+  // Arrays of a record marked "soa layout" are stored one array per field,
+  // which only works when elements can be taken apart and put back together
+  // with plain copies.  Other records keep the usual layout.
+  case PRIM_IS_SOA_LAYOUT_TYPE: {
+    Type* t = call->get(1)->typeInfo();
+
+    propagateNotPOD(t);
+
+    if (t->symbol->hasFlag(FLAG_SOA_LAYOUT) && isPOD(t)) {
+      retval = new SymExpr(gTrue);
+    } else {
+      retval = new SymExpr(gFalse);
+    }
+
+    call->replace(retval);
+
+    break;
+  }
+
   case PRIM_IS_ABS_ENUM_TYPE: {
     EnumType* et = toEnumType(call->get(1)->typeInfo());
     if (et && et->isAbstract()) {
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "resolutionProfile.h"
+
+#include "driver.h"
+#include "FnSymbol.h"
+#include "ResolutionCandidate.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+//
+// Counts are kept per source function: instantiations and wrappers share
+// the entry of the generic they came from.  Entries are keyed on name and
+// location so the report doesn't need the symbols, which may be gone.
+//
+
+namespace {
+  struct ProfileKey {
+    const char*   name;
+    std::string   file;
+    int           line;
+
+    bool operator<(const ProfileKey& other) const {
+      if (line != other.line)
+        return line < other.line;
+
+      if (name != other.name)
+        return strcmp(name, other.name) < 0;
+
+      return file < other.file;
+    }
+  };
+
+  struct ProfileEntry {
+    ProfileKey    key;
+    unsigned long usecs;
+    int           resolved;
+    int           instantiations;
+    int           candidates;
+    int           wrappers;
+  };
+}
+
+static std::map<ProfileKey, ProfileEntry> profile;
+
+// One timer per function being resolved; only the top one runs.
+static std::vector<Timer*>                profileTimers;
+
+static ProfileEntry& profileEntry(FnSymbol* fn) {
+  ProfileKey key;
+
+  while (fn->instantiatedFrom != NULL)
+    fn = fn->instantiatedFrom;
+
+  key.name = fn->name;
+  key.file = fn->fname() != NULL ? fn->fname() : "";
+  key.line = fn->linenum();
+
+  std::map<ProfileKey, ProfileEntry>::iterator it = profile.find(key);
+
+  if (it == profile.end()) {
+    ProfileEntry entry = { key, 0, 0, 0, 0, 0 };
+
+    it = profile.insert(std::make_pair(key, entry)).first;
+  }
+
+  return it->second;
+}
+
+void profileResolveFunctionBegin(FnSymbol* fn) {
+  if (fReportResolutionProfile > 0) {
+    if (profileTimers.empty() == false)
+      profileTimers.back()->stop();
+
+    profileTimers.push_back(new Timer());
+    profileTimers.back()->start();
+  }
+}
+
+void profileResolveFunctionEnd(FnSymbol* fn) {
+  if (fReportResolutionProfile > 0 && profileTimers.empty() == false) {
+    Timer*        timer = profileTimers.back();
+    ProfileEntry& entry = profileEntry(fn);
+
+    timer->stop();
+
+    entry.usecs    += timer->elapsedUsecs();
+    entry.resolved += 1;
+
+    profileTimers.pop_back();
+    delete timer;
+
+    if (profileTimers.empty() == false)
+      profileTimers.back()->start();
+  }
+}
+
+void profileInstantiation(FnSymbol* fn) {
+  if (fReportResolutionProfile > 0)
+    profileEntry(fn).instantiations++;
+}
+
+void profileWrapper(FnSymbol* fn) {
+  if (fReportResolutionProfile > 0)
+    profileEntry(fn).wrappers++;
+}
+
+void profileCandidates(Vec<ResolutionCandidate*>& candidates) {
+  if (fReportResolutionProfile > 0) {
+    forv_Vec(ResolutionCandidate, candidate, candidates) {
+      profileEntry(candidate->fn).candidates++;
+    }
+  }
+}
+
+static bool slowerThan(const ProfileEntry* a, const ProfileEntry* b) {
+  return a->usecs > b->usecs;
+}
+
+void printResolutionProfile() {
+  if (fReportResolutionProfile > 0) {
+    std::vector<ProfileEntry*> entries;
+
+    for (std::map<ProfileKey, ProfileEntry>::iterator it = profile.begin();
+         it != profile.end();
+         it++) {
+      entries.push_back(&it->second);
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), slowerThan);
+
+    int n = std::min((int) entries.size(), fReportResolutionProfile);
+
+    printf("Resolution profile: %d of %d functions\n",
+           n, (int) entries.size());
+    printf("%10s %8s %8s %10s %8s  %s\n",
+           "msecs", "resolved", "instant.", "candidates", "wrappers",
+           "function");
+
+    for (int i = 0; i < n; i++) {
+      ProfileEntry* entry = entries[i];
+
+      printf("%10.3f %8d %8d %10d %8d  %s (%s:%d)\n",
+             entry->usecs / 1000.0,
+             entry->resolved,
+             entry->instantiations,
+             entry->candidates,
+             entry->wrappers,
+             entry->key.name,
+             entry->key.file.c_str(),
+             entry->key.line);
+    }
+
+    profile.clear();
+  }
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _RESOLUTION_PROFILE_H_
+#define _RESOLUTION_PROFILE_H_
+
+#include "vec.h"
+
+class FnSymbol;
+class ResolutionCandidate;
+
+//
+// --report-resolution-profile <n>: per source function, count the time
+// spent resolving it and its instantiations, how many instantiations and
+// wrappers were made for it and how often it was a candidate in
+// disambiguation, and print the <n> functions that took the most time.
+//
+// Time is exclusive: resolving a function that resolves another charges
+// the inner one's time to the inner one only.
+//
+
+void profileResolveFunctionBegin(FnSymbol* fn);
+void profileResolveFunctionEnd(FnSymbol* fn);
+
+void profileInstantiation(FnSymbol* fn);
+void profileWrapper(FnSymbol* fn);
+void profileCandidates(Vec<ResolutionCandidate*>& candidates);
+
+void printResolutionProfile();
+
+#endif
@@ -41,6 +41,7 @@
 #include "postFold.h"
 #include "resolution.h"
 #include "resolveIntents.h"
+#include "resolutionProfile.h"
 #include "splitInit.h"
 #include "stmt.h"
 #include "stringutil.h"
@@ -472,6 +473,8 @@ void resolveFunction(FnSymbol* fn, CallExpr* forCall) {
 
     fn->addFlag(FLAG_RESOLVED);
 
+    profileResolveFunctionBegin(fn);
+
     fn->tagIfGeneric();
 
     createCacheInfoIfNeeded(fn);
@@ -526,6 +529,8 @@ void resolveFunction(FnSymbol* fn, CallExpr* forCall) {
     }
     popInstantiationLimit(fn);
     clearCacheInfoIfEmpty(fn);
+
+    profileResolveFunctionEnd(fn);
   }
 }
 
@@ -1248,20 +1248,41 @@ static void checkMethodsOverride() {
 *       this.init(...) c.f. convenience initializers in Swift.  Note that     *
 *       super.init() is covered by exception 1.                               *
 *                                                                             *
+*    3) None of the overrides are in the receiver's static type or below it,  *
+*       so the call can only go to the method it was resolved to.             *
+*                                                                             *
+* If all of the classes that are allocated at or below the receiver's static  *
+* type are one class, the call is also made directly to that class's method   *
+* when the receiver's class id matches, with the dynamic dispatch as the      *
+* fallback.                                                                   *
+*                                                                             *
 ************************************** | *************************************/
 
 static bool wasSuperDot(CallExpr* call);
 
+static void findAllocatedClasses();
+static bool canDevirtualize(CallExpr* call, FnSymbol* fn);
+static bool speculativelyDevirtualize(CallExpr* call, FnSymbol* fn);
+
 void insertDynamicDispatchCalls() {
+  if (fNoDevirtualize == false && fNoSpeculativeDevirtualize == false) {
+    findAllocatedClasses();
+  }
+
   forv_Vec(CallExpr, call, gCallExprs) {
     if (call->inTree()) {
       if (FnSymbol* fn = call->resolvedFunction()) {
 
         if (virtualChildrenMap.get(fn) != NULL  &&   // There are overrides
             wasSuperDot(call)          == false &&   // Not super.<foo>()
-            call->isNamed("init")      == false) {   // Not an initializer
+            call->isNamed("init")      == false &&   // Not an initializer
+            canDevirtualize(call, fn)  == false) {   // Overrides reachable
           SET_LINENO(call);
 
+          if (fNoDevirtualize == false && fNoSpeculativeDevirtualize == false) {
+            speculativelyDevirtualize(call, fn);
+          }
+
           // The variable <cid> must have the same size as the type
           // of chpl__class_id / chpl_cid_* to ensure the value is
           // transmitted correctly for a remote class.
@@ -1299,3 +1320,245 @@ static bool wasSuperDot(CallExpr* call) {
 
   return retval;
 }
+
+// The classes that objects are created with, from the PRIM_SETCIDs that
+// follow their allocations
+static std::set<AggregateType*> allocatedClasses;
+
+// The direct calls made by speculativelyDevirtualize(), which are only
+// reached once the class id has been checked
+static std::set<CallExpr*> speculatedCalls;
+
+static void findAllocatedClasses() {
+  forv_Vec(CallExpr, call, gCallExprs) {
+    if (call->inTree() && call->isPrimitive(PRIM_SETCID)) {
+      FnSymbol* fn = call->getFunction();
+
+      // An initializer sets the class id of an object that is already
+      // allocated, and a subclass's initializer sets it to each parent
+      // class in turn, so only the ones in the 'new' wrappers count.
+      if (fn != NULL && (fn->isInitializer() || fn->isCopyInit()))
+        continue;
+
+      Type* type = canonicalClassType(call->get(1)->getValType());
+
+      if (AggregateType* at = toAggregateType(type)) {
+        allocatedClasses.insert(at);
+      }
+    }
+  }
+}
+
+static void reportDevirtualization(CallExpr* call, const char* msg,
+                                   FnSymbol* fn) {
+  if (fReportDevirtualization &&
+      (developer || printsUserLocation(call))) {
+    USR_PRINT(call, "%s call to %s", msg, toString(fn));
+  }
+}
+
+// The static type of the receiver of a method call, looking through the
+// coercion to the type of the method's 'this'
+static AggregateType* getReceiverType(CallExpr* call) {
+  AggregateType* retval = NULL;
+
+  if (call->numActuals() >= 2) {
+    Expr* receiver = call->get(2);
+
+    retval = toAggregateType(canonicalClassType(receiver->getValType()));
+
+    SymExpr* se = toSymExpr(receiver);
+
+    if (retval != NULL && se != NULL &&
+        se->symbol()->hasFlag(FLAG_COERCE_TEMP)) {
+      if (SymExpr* def = se->symbol()->getSingleDef()) {
+        CallExpr* move = toCallExpr(def->parentExpr);
+
+        if (move != NULL && move->isPrimitive(PRIM_MOVE)) {
+          Expr* src = move->get(2);
+
+          // A subclass actual is coerced with a call to _cast(type, x)
+          if (CallExpr* cast = toCallExpr(src)) {
+            FnSymbol* castFn = cast->resolvedFunction();
+
+            if (cast->isPrimitive(PRIM_CAST) ||
+                (castFn != NULL && castFn->name == astr_cast &&
+                 cast->numActuals() == 2)) {
+              src = cast->get(2);
+            }
+          }
+
+          if (isSymExpr(src)) {
+            Type* srcType = canonicalClassType(src->getValType());
+
+            if (AggregateType* at = toAggregateType(srcType)) {
+              if (at->isClass() && isSubType(at, retval)) {
+                retval = at;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return retval;
+}
+
+// A call to 'fn' can be left direct if no override of 'fn' is in the
+// receiver's static type or one of its subclasses, and none is between the
+// two (resolution would have picked that one, but don't count on it).
+static bool canDevirtualize(CallExpr* call, FnSymbol* fn) {
+  if (speculatedCalls.count(call) != 0)
+    return true;
+
+  if (fNoDevirtualize)
+    return false;
+
+  AggregateType* recvType = getReceiverType(call);
+
+  if (recvType == NULL || recvType->isClass() == false)
+    return false;
+
+  forv_Vec(FnSymbol, child, *virtualChildrenMap.get(fn)) {
+    AggregateType* childType = getReceiverClassType(child);
+
+    if (childType == NULL ||
+        isSubType(childType, recvType) ||
+        isSubType(recvType, childType)) {
+      return false;
+    }
+  }
+
+  reportDevirtualization(call, "Devirtualized", fn);
+
+  return true;
+}
+
+// The method that a call to 'fn' dispatches to for an object of class 'at'
+static FnSymbol* getDispatchTarget(FnSymbol* fn, AggregateType* at) {
+  FnSymbol*      retval     = fn;
+  AggregateType* retvalType = getReceiverClassType(fn);
+
+  forv_Vec(FnSymbol, child, *virtualChildrenMap.get(fn)) {
+    AggregateType* childType = getReceiverClassType(child);
+
+    if (childType != NULL &&
+        isSubType(at, childType) &&
+        isSubType(childType, retvalType)) {
+      retval     = child;
+      retvalType = childType;
+    }
+  }
+
+  return retval;
+}
+
+// Can 'target' be called in place of 'fn' once the receiver is cast?
+static bool hasSameSignature(FnSymbol* fn, FnSymbol* target) {
+  if (fn->numFormals() != target->numFormals() ||
+      fn->retType      != target->retType      ||
+      fn->retTag       != target->retTag) {
+    return false;
+  }
+
+  for (int i = 3; i <= fn->numFormals(); i++) {
+    ArgSymbol* formal       = fn->getFormal(i);
+    ArgSymbol* targetFormal = target->getFormal(i);
+
+    if (formal->type   != targetFormal->type ||
+        formal->intent != targetFormal->intent) {
+      return false;
+    }
+  }
+
+  return target->_this != NULL &&
+         target->_this->isRef()  == false &&
+         fn->_this->isRef()      == false;
+}
+
+//
+// Turn the statement holding 'call' into
+//
+//   if (testcid(receiver, C)) {
+//     def recv: C; move recv, cast(C, receiver)
+//     ... C.method(recv, ...) ...
+//   } else {
+//     ... call ...
+//   }
+//
+// when C is the only class allocated at or below the receiver's static
+// type.  'call' itself then becomes the dynamic dispatch.
+//
+static bool speculativelyDevirtualize(CallExpr* call, FnSymbol* fn) {
+  AggregateType* recvType = getReceiverType(call);
+  AggregateType* likely   = NULL;
+
+  if (recvType == NULL || recvType->isClass() == false)
+    return false;
+
+  for (std::set<AggregateType*>::iterator it = allocatedClasses.begin();
+       it != allocatedClasses.end();
+       ++it) {
+    if (isSubType(*it, recvType)) {
+      if (likely != NULL)
+        return false;
+
+      likely = *it;
+    }
+  }
+
+  if (likely == NULL)
+    return false;
+
+  FnSymbol* target = getDispatchTarget(fn, likely);
+
+  if (hasSameSignature(fn, target) == false ||
+      isSymExpr(call->get(2))      == false ||
+      call->get(2)->isRef())
+    return false;
+
+  // Only handle 'call' and 'move x, call'
+  Expr*     stmt     = call->getStmtExpr();
+  CallExpr* stmtCall = toCallExpr(stmt);
+
+  if (stmt != call &&
+      (stmtCall                         == NULL  ||
+       stmtCall->isPrimitive(PRIM_MOVE) == false ||
+       stmtCall->get(2)                 != call)) {
+    return false;
+  }
+
+  Type*      targetThis = target->_this->type;
+  VarSymbol* test       = newTemp("_devirt_test_", dtBool);
+  VarSymbol* recv       = newTemp("_devirt_recv_", targetThis);
+  BlockStmt* thenBlock  = new BlockStmt();
+  BlockStmt* elseBlock  = new BlockStmt();
+  Expr*      directStmt = stmt->copy();
+  CallExpr*  direct     = stmt == call ? toCallExpr(directStmt)
+                                       : toCallExpr(toCallExpr(directStmt)->get(2));
+
+  thenBlock->insertAtTail(new DefExpr(recv));
+  thenBlock->insertAtTail(new CallExpr(PRIM_MOVE, recv,
+                                       new CallExpr(PRIM_CAST,
+                                                    targetThis->symbol,
+                                                    call->get(2)->copy())));
+  thenBlock->insertAtTail(directStmt);
+
+  direct->get(2)->replace(new SymExpr(recv));
+  direct->setResolvedFunction(target);
+  speculatedCalls.insert(direct);
+
+  stmt->insertBefore(new DefExpr(test));
+  stmt->insertBefore(new CallExpr(PRIM_MOVE, test,
+                                  new CallExpr(PRIM_TESTCID,
+                                               call->get(2)->copy(),
+                                               likely->symbol)));
+  stmt->insertBefore(new CondStmt(new SymExpr(test), thenBlock, elseBlock));
+
+  elseBlock->insertAtTail(stmt->remove());
+
+  reportDevirtualization(call, "Speculatively devirtualized", target);
+
+  return true;
+}
@@ -69,6 +69,32 @@ static Map<BlockStmt*, VisibleFunctionBlock*> visibleFunctionMap;
 
 static int                                    nVisibleFunctions       = 0;
 
+/*
+   Calls with the same name from the same scope usually see the same
+   functions, so the result of a lookup that starts with nothing visited
+   is remembered per name and starting block.  A lookup isn't cached if
+   its result could depend on the call, i.e. it had to check whether a
+   private function or module is visible from it, or if it followed a
+   renaming 'use' or 'import' (an entry is only invalidated when a
+   function with its own name is added).
+ */
+class VisibleFunctionsLookup {
+public:
+  std::vector<FnSymbol*>  fns;
+  std::vector<BlockStmt*> visitedScopes;   // in visited order
+  BlockStmt*              nextPOI;         // NULL if not set
+};
+
+typedef std::pair<BlockStmt*, bool> VisibleFunctionsKey; // block, allPOIs
+
+static std::map<const char*,
+                std::map<VisibleFunctionsKey, VisibleFunctionsLookup> >
+                                              visibleFunctionsCache;
+
+// Set when the lookup in progress has done something that keeps it
+// from being cached.
+static bool                                   lookupIsCallSpecific    = false;
+
 /************************************* | **************************************
 *                                                                             *
 *                                                                             *
@@ -252,6 +278,8 @@ static void buildVisibleFunctionMap() {
         vfb->visibleFunctions.put(fn->name, fns);
       }
       fns->add(fn);
+
+      visibleFunctionsCache.erase(fn->name);
     }
   }
   nVisibleFunctions = gFnSymbols.n;
@@ -873,14 +901,21 @@ static void getVisibleFunctionsImpl(const char*       name,
                                 Vec<FnSymbol*>&       visibleFns,
                                 bool                  inUseChain);
 
+static void getVisibleFunctionsCached(const char*       name,
+                                CallExpr*             call,
+                                BlockStmt*            block,
+                                VisibilityInfo*       visInfo,
+                                std::set<BlockStmt*>& visited,
+                                Vec<FnSymbol*>&       visibleFns);
+
 static void getVisibleFunctionsVI(const char*            name,
                                 CallExpr*                call,
                                 VisibilityInfo*          visInfo,
                                 std::set<BlockStmt*>*    visited,
                                 Vec<FnSymbol*>&          visibleFns)
 {
-  getVisibleFunctionsImpl(name, call, visInfo->currStart, visInfo,
-                          *visited, visibleFns, false);
+  getVisibleFunctionsCached(name, call, visInfo->currStart, visInfo,
+                            *visited, visibleFns);
 }
 
 void getVisibleFunctions(const char*      name,
@@ -889,8 +924,80 @@ void getVisibleFunctions(const char*      name,
   BlockStmt*           block    = getVisibilityScope(call);
   std::set<BlockStmt*> visited;
 
-  getVisibleFunctionsImpl(name, call, block, NULL,
+  getVisibleFunctionsCached(name, call, block, NULL, visited, visibleFns);
+}
+
+// getVisibleFunctionsImpl() for a lookup that isn't in a use chain,
+// reusing the result of an earlier lookup of 'name' from 'block'.
+static void getVisibleFunctionsCached(const char*       name,
+                                CallExpr*             call,
+                                BlockStmt*            block,
+                                VisibilityInfo*       visInfo,
+                                std::set<BlockStmt*>& visited,
+                                Vec<FnSymbol*>&       visibleFns)
+{
+  // Later POI rounds depend on what was visited before
+  if (visited.empty() == false || call->id == breakOnResolveID) {
+    getVisibleFunctionsImpl(name, call, block, visInfo,
+                            visited, visibleFns, false);
+    return;
+  }
+
+  VisibleFunctionsKey key(block, visInfo == NULL);
+  std::map<VisibleFunctionsKey, VisibleFunctionsLookup>& byBlock =
+    visibleFunctionsCache[name];
+  std::map<VisibleFunctionsKey, VisibleFunctionsLookup>::iterator it =
+    byBlock.find(key);
+
+  if (it != byBlock.end()) {
+    VisibleFunctionsLookup& lookup = it->second;
+
+    for_vector(FnSymbol, fn, lookup.fns) {
+      visibleFns.add(fn);
+    }
+
+    if (visInfo != NULL) {
+      for_vector(BlockStmt, scope, lookup.visitedScopes) {
+        visited.insert(scope);
+        visInfo->visitedScopes.push_back(scope);
+      }
+
+      if (lookup.nextPOI != NULL)
+        visInfo->nextPOI = lookup.nextPOI;
+    }
+
+    return;
+  }
+
+  int        startFns    = visibleFns.n;
+  size_t     startScopes = visInfo ? visInfo->visitedScopes.size() : 0;
+  BlockStmt* prevPOI     = visInfo ? visInfo->nextPOI : NULL;
+
+  if (visInfo != NULL)
+    visInfo->nextPOI = NULL;
+
+  lookupIsCallSpecific = false;
+
+  getVisibleFunctionsImpl(name, call, block, visInfo,
                           visited, visibleFns, false);
+
+  BlockStmt* nextPOI = visInfo ? visInfo->nextPOI : NULL;
+
+  if (visInfo != NULL && nextPOI == NULL)
+    visInfo->nextPOI = prevPOI;
+
+  if (lookupIsCallSpecific == false) {
+    VisibleFunctionsLookup& lookup = byBlock[key];
+
+    for (int i = startFns; i < visibleFns.n; i++)
+      lookup.fns.push_back(visibleFns.v[i]);
+
+    if (visInfo != NULL)
+      lookup.visitedScopes.assign(visInfo->visitedScopes.begin() + startScopes,
+                                  visInfo->visitedScopes.end());
+
+    lookup.nextPOI = nextPOI;
+  }
 }
 
 static BlockStmt* getVisibleFnsInstantiationPt(BlockStmt* block) {
@@ -974,6 +1081,7 @@ static void getVisibleFnsFirstVisit(const char*       name,
             // We haven't checked the privacy of a function in this scope yet.
             // Do so now, and remember the result
             privacyChecked = true;
+            lookupIsCallSpecific = true;
             if (fn->isVisible(call)) {
               // We've determined that this function, even though it is
               // private, can be used
@@ -1041,8 +1149,12 @@ static void getVisibleFnsFromUseList(const char*      name,
             // The use statement could be of an enum instead of a module,
             // but only modules can define functions.
 
+            if (mod->hasFlag(FLAG_PRIVATE))
+              lookupIsCallSpecific = true;
+
             if (mod->isVisible(call)) {
               if (use->isARenamedSym(name)) {
+                lookupIsCallSpecific = true;
                 getVisibleFunctionsImpl(use->getRenamedSym(name),
                   call, mod->block, visInfo, visited, visibleFns, true);
               } else {
@@ -1064,8 +1176,13 @@ static void getVisibleFnsFromUseList(const char*      name,
           INT_ASSERT(se);
           ModuleSymbol* mod = toModuleSymbol(se->symbol());
           INT_ASSERT(mod);
+
+          if (mod->hasFlag(FLAG_PRIVATE))
+            lookupIsCallSpecific = true;
+
           if (mod->isVisible(call)) {
             if (import->isARenamedSym(name)) {
+              lookupIsCallSpecific = true;
               getVisibleFunctionsImpl(import->getRenamedSym(name),
                 call, mod->block, visInfo, visited, visibleFns, true);
             } else {
@@ -1275,6 +1392,7 @@ void visibleFunctionsClear() {
   }
 
   visibleFunctionMap.clear();
+  visibleFunctionsCache.clear();
 }
 
 /************************************* | **************************************
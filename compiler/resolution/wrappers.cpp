@@ -56,6 +56,7 @@
 #include "optimizations.h"
 #include "passes.h"
 #include "resolution.h"
+#include "resolutionProfile.h"
 #include "resolveFunction.h"
 #include "resolveIntents.h"
 #include "stlUtil.h"
@@ -115,6 +116,8 @@ static IntentTag getIntent(ArgSymbol* formal);
 typedef struct DefaultExprFnEntry_s {
   FnSymbol* defaultExprFn;
   std::vector<std::pair<ArgSymbol*,ArgSymbol*> > usedFormals;
+  // The param the default folded to, once a call has checked it
+  Symbol* paramValue;
 } DefaultExprFnEntry;
 
 typedef std::map<ArgSymbol*, DefaultExprFnEntry> formalToDefaultExprEntryMap;
@@ -341,6 +344,13 @@ void addDefaultTokensAndReorder(FnSymbol *fn,
   }
 }
 
+static bool isParamDefault(Symbol* sym) {
+  if (VarSymbol* var = toVarSymbol(sym))
+    return var->immediate != NULL;
+
+  return isEnumSymbol(sym);
+}
+
 static void handleDefaultArg(FnSymbol *fn, CallExpr* call,
                              ArgSymbol* formal, SymExpr* actual,
                              SymbolMap& copyMap,
@@ -358,6 +368,17 @@ static void handleDefaultArg(FnSymbol *fn, CallExpr* call,
     return;
   }
 
+  // A default that folds to a param is the same for every call,
+  // so there is no need to build and resolve the call to it again.
+  formalToDefaultExprEntryMap::iterator it =
+    formalToDefaultExprEntry.find(formal);
+
+  if (it != formalToDefaultExprEntry.end() &&
+      it->second.paramValue != NULL) {
+    actual->setSymbol(it->second.paramValue);
+    return;
+  }
+
   // Create a Block to store the default values
   // We'll flatten this back out again in a minute.
   BlockStmt* body = new BlockStmt(BLOCK_SCOPELESS);
@@ -418,6 +439,9 @@ static void handleDefaultArg(FnSymbol *fn, CallExpr* call,
         USR_PRINT(formal, "when calling %s with a default value for %s",
                   fn->name, formal->name);
       }
+
+    } else if (isParamDefault(newActual)) {
+      formalToDefaultExprEntry[formal].paramValue = newActual;
     }
   }
 
@@ -437,6 +461,8 @@ static DefaultExprFnEntry buildDefaultedActualFn(FnSymbol*  fn,
 
   DefaultExprFnEntry ret;
 
+  ret.paramValue = NULL;
+
   SET_LINENO(formal);
 
 
@@ -444,6 +470,8 @@ static DefaultExprFnEntry buildDefaultedActualFn(FnSymbol*  fn,
   FnSymbol* wrapper = new FnSymbol(astr(fn->name, "_default_", formal->name));
   ret.defaultExprFn = wrapper;
 
+  profileWrapper(fn);
+
   wrapper->addFlag(FLAG_INVISIBLE_FN);
   wrapper->addFlag(FLAG_INLINE);
   wrapper->addFlag(FLAG_LINE_NUMBER_OK);
@@ -1277,6 +1305,27 @@ static void errorIfValueCoercionToRef(CallExpr* call, Symbol* actual,
   }
 }
 
+// Is 'sym' the iterator record of a promoted call?
+static bool isPromotedIteratorRecord(Symbol* sym) {
+  AggregateType* at = toAggregateType(sym->getValType());
+
+  return at                                  != NULL &&
+         at->symbol->hasFlag(FLAG_ITERATOR_RECORD)   &&
+         at->iteratorInfo                    != NULL &&
+         at->iteratorInfo->iterator          != NULL &&
+         at->iteratorInfo->iterator->hasFlag(FLAG_PROMOTION_WRAPPER);
+}
+
+// With --report-promotion, note promoted calls whose result has to be
+// stored into a temporary array because it is passed to 'fn'.
+static void reportMaterializedPromotion(FnSymbol* fn, CallExpr* call,
+                                        Symbol* actualSym) {
+  if (fReportPromotion && isPromotedIteratorRecord(actualSym)) {
+    USR_WARN(call, "promotion materialized into an array for %s",
+             toString(fn));
+  }
+}
+
 // Add a coercion; set actual's symbol to a new temp storing the result
 // of a coercion.
 static void addArgCoercion(FnSymbol*  fn,
@@ -1296,6 +1345,8 @@ static void addArgCoercion(FnSymbol*  fn,
   castTemp->addFlag(FLAG_COERCE_TEMP);
   castTemp->addFlag(FLAG_INSERT_AUTO_DESTROY);
 
+  reportMaterializedPromotion(fn, call, prevActual);
+
   if (prevActual->hasFlag(FLAG_ARG_THIS) &&
       isDispatchParent(prevActual->type, formal->type)) {
     castTemp->addFlag(FLAG_ARG_THIS);
@@ -1642,6 +1693,9 @@ static void handleInIntent(FnSymbol* fn, CallExpr* call,
       
       CallExpr* copy = NULL;
 
+      if (!inout)
+        reportMaterializedPromotion(fn, call, actualSym);
+
       Symbol *definedConst = isFormalTempConst(fn, formal) ?  gTrue : gFalse;
       if (coerceRuntimeTypes)
         copy = new CallExpr(astr_coerceCopy, runtimeTypeTemp, actualSym,
@@ -1978,6 +2032,15 @@ static FnSymbol* promotionWrap(FnSymbol* fn,
 
   if (fReportPromotion) {
     USR_WARN(info.call, "promotion on %s", info.toString());
+
+    // Promoted actuals that are themselves promoted calls are iterated
+    // by this promotion directly rather than stored into an array.
+    for (int i = 0; i < info.actuals.n; i++) {
+      if (isPromotedIteratorRecord(info.actuals.v[i])) {
+        USR_PRINT(info.call, "promoted actual %d is fused into this promotion",
+                  i + 1);
+      }
+    }
   }
 
   PromotionInfo promotion(fn, info, actualIdxToFormal);
@@ -2814,6 +2877,8 @@ void buildFastFollowerChecksIfNeeded(CallExpr* checkCall) {
 static FnSymbol* buildEmptyWrapper(FnSymbol* fn) {
   FnSymbol* wrapper = new FnSymbol(fn->name);
 
+  profileWrapper(fn);
+
   wrapper->addFlag(FLAG_WRAPPER);
   wrapper->addFlag(FLAG_INVISIBLE_FN);
   wrapper->addFlag(FLAG_INLINE);
@@ -61,6 +61,8 @@ char libmodeHeadername[FILENAME_MAX + 1]  = "";
 char fortranModulename[FILENAME_MAX + 1]  = "";
 char pythonModulename[FILENAME_MAX + 1]   = "";
 char saveCDir[FILENAME_MAX + 1]           = "";
+char compileCacheDir[FILENAME_MAX + 1]    = "";
+char clangPchCacheDir[FILENAME_MAX + 1]   = "";
 
 std::string ccflags;
 std::string ldflags;
@@ -360,6 +362,64 @@ void closeCFile(fileinfo* fi, bool beautifyIt) {
     beautify(fi);
 }
 
+//
+// Like openCFile/closeCFile, but the new contents are written beside the
+// file and only replace it if they differ.  An unchanged file keeps its
+// timestamp so make doesn't rebuild what depends on it.
+//
+static const char* updateFilename(fileinfo* fi) {
+  return astr(fi->pathname, ".new");
+}
+
+void openCFileIfChanged(fileinfo* fi, const char* name, const char* ext) {
+  if (ext)
+    fi->filename = astr(name, ".", ext);
+  else
+    fi->filename = astr(name);
+
+  fi->pathname = genIntermediateFilename(fi->filename);
+  fi->fptr     = openfile(updateFilename(fi), "w");
+}
+
+static bool sameFileContents(const char* pathA, const char* pathB) {
+  FILE* a      = fopen(pathA, "rb");
+  FILE* b      = fopen(pathB, "rb");
+  bool  retval = (a != NULL && b != NULL);
+
+  while (retval == true) {
+    char   bufA[8192];
+    char   bufB[8192];
+    size_t nA = fread(bufA, 1, sizeof(bufA), a);
+    size_t nB = fread(bufB, 1, sizeof(bufB), b);
+
+    if (nA != nB || memcmp(bufA, bufB, nA) != 0)
+      retval = false;
+    else if (nA == 0)
+      break;
+  }
+
+  if (a != NULL) fclose(a);
+  if (b != NULL) fclose(b);
+
+  return retval;
+}
+
+void closeCFileIfChanged(fileinfo* fi, bool beautifyIt) {
+  fileinfo newfile = { NULL, fi->filename, updateFilename(fi) };
+
+  closefile(fi->fptr);
+  fi->fptr = NULL;
+
+  if (beautifyIt && (saveCDir[0] || printCppLineno))
+    beautify(&newfile);
+
+  if (sameFileContents(newfile.pathname, fi->pathname)) {
+    unlink(newfile.pathname);
+  } else if (rename(newfile.pathname, fi->pathname) != 0) {
+    USR_FATAL("renaming %s: %s", newfile.pathname, strerror(errno));
+  }
+}
+
 fileinfo* openTmpFile(const char* tmpfilename, const char* mode) {
   fileinfo* newfile = (fileinfo*)malloc(sizeof(fileinfo));
 
@@ -707,7 +767,12 @@ void codegen_makefile(fileinfo* mainfile, const char** tmpbinname,
   std::string makeallvars;
   fileinfo makefile;
 
-  openCFile(&makefile, "Makefile");
+  // Incremental builds compile user modules in make rules that depend
+  // on the Makefile, so leave it alone unless it changes.
+  if (fIncrementalCompilation)
+    openCFileIfChanged(&makefile, "Makefile");
+  else
+    openCFile(&makefile, "Makefile");
 
   // Capture different compiler directories.
   fprintf(makefile.fptr, "CHPL_MAKE_HOME = %s\n\n", CHPL_HOME);
@@ -911,7 +976,11 @@ void codegen_makefile(fileinfo* mainfile, const char** tmpbinname,
   fprintf(makefile.fptr, "%s\n\n", incpath.c_str());
 
   genCFileBuildRules(makefile.fptr);
-  closeCFile(&makefile, false);
+
+  if (fIncrementalCompilation)
+    closeCFileIfChanged(&makefile, false);
+  else
+    closeCFile(&makefile, false);
 }
 
 const char* filenameToModulename(const char* filename) {
@@ -36,7 +36,7 @@
 
 #include <inttypes.h>
 
-static ChainHashMap<const char*, StringHashFns, const char*> chapelStringsTable;
+static OpenHashMap<const char*, StringHashFns, const char*> chapelStringsTable;
 
 static const char*
 canonicalize_string(const char *s) {
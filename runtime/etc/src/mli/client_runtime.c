@@ -31,10 +31,43 @@
 
 struct chpl_mli_context chpl_client;
 
+//
+// The request being built and the last reply received, reused by every
+// call.  Replies come back in the order the requests were sent.
+//
+static struct chpl_mli_buffer chpl_mli_req;
+static struct chpl_mli_buffer chpl_mli_rep;
+
+//
+// How many calls are waiting on a reply, and how many calls to routines
+// without a result may be left waiting.  The depth is set with the
+// CHPL_RT_MLI_PIPELINE_DEPTH environment variable, and defaults to zero so
+// that every call waits for the server.
+//
+static int64_t chpl_mli_outstanding = 0;
+static int64_t chpl_mli_pipeline_depth = 0;
+
+//
+// With a shared memory segment, requests are placed in its ring at
+// 'chpl_mli_ring_head' and the ring is free back to 'chpl_mli_ring_tail'
+// (both count bytes ever placed).  For each outstanding request we keep
+// where the head was after it, so that its reply can move the tail.  The
+// segment is offered when CHPL_RT_MLI_SHM_SIZE is set to its size in
+// bytes, and then messages of at least CHPL_RT_MLI_SHM_THRESHOLD bytes
+// (64KiB by default) go through it.
+//
+static uint64_t chpl_mli_ring_head = 0;
+static uint64_t chpl_mli_ring_tail = 0;
+static uint64_t* chpl_mli_ring_ends = NULL;
+static uint64_t chpl_mli_ring_ends_len = 0;
+static uint64_t chpl_mli_ring_ends_first = 0;
+
 void chpl_mli_client_init(struct chpl_mli_context* client);
 void chpl_mli_client_deinit(struct chpl_mli_context* client);
 char* chpl_mli_pull_connection(void);
 void chpl_mli_terminate(enum chpl_mli_errors e);
+struct chpl_mli_buffer* chpl_mli_begin_call(int64_t id);
+struct chpl_mli_buffer* chpl_mli_end_call(int hasResult);
 int chpl_mli_client_launch(int argc, char** argv);
 void chpl_library_init(int argc, char** argv);
 void chpl_library_finalize(void);
@@ -70,9 +103,8 @@ void chpl_mli_client_init(struct chpl_mli_context* client) {
 
   client->context = zmq_ctx_new();
   client->setup_sock = zmq_socket(client->context, ZMQ_PULL);
-  client->main    = zmq_socket(client->context, ZMQ_REQ);
-  client->arg     = zmq_socket(client->context, ZMQ_REQ);
-  client->res     = zmq_socket(client->context, ZMQ_REP);
+  // A DEALER rather than a REQ, so that requests can be pipelined.
+  client->main    = zmq_socket(client->context, ZMQ_DEALER);
 
   return;
 }
@@ -106,6 +138,211 @@ void chpl_mli_terminate(enum chpl_mli_errors e) {
   mli_terminate();
 }
 
+//
+// Start a request to call routine 'id'.  The arguments are packed into the
+// returned buffer.
+//
+struct chpl_mli_buffer* chpl_mli_begin_call(int64_t id) {
+  chpl_mli_req.size = 0;
+  chpl_mli_buf_write(&chpl_mli_req, &id, sizeof(id));
+  return &chpl_mli_req;
+}
+
+static int64_t chpl_mli_pull_reply(void);
+static void chpl_mli_await_reply(void);
+
+//
+// Find room for a 'bytes' byte request in the shared memory ring, waiting
+// for replies to free some if need be.  Returns its offset, or -1 if it
+// won't fit.  Requests never wrap around the end of the ring.
+//
+static
+int64_t chpl_mli_ring_reserve(uint64_t bytes) {
+  uint64_t size = chpl_client.shm.ring_size;
+  uint64_t pos = 0;
+  uint64_t skip = 0;
+
+  bytes = (bytes + 7) & ~((uint64_t) 7);
+  if (bytes > size) { return -1; }
+
+  while (1) {
+    if (chpl_mli_outstanding == 0) {
+      chpl_mli_ring_head = chpl_mli_ring_tail = 0;
+    }
+
+    pos = chpl_mli_ring_head % size;
+    skip = pos + bytes > size ? size - pos : 0;
+
+    if (chpl_mli_ring_head + skip + bytes - chpl_mli_ring_tail <= size) {
+      chpl_mli_ring_head += skip + bytes;
+      return skip ? 0 : (int64_t) pos;
+    }
+
+    chpl_mli_await_reply();
+  }
+}
+
+static
+void chpl_mli_send_request(void) {
+  struct chpl_mli_shm* shm = &chpl_client.shm;
+  int64_t offset = -1;
+  uint64_t last = 0;
+  int err = 0;
+
+  if (shm->base != NULL && chpl_mli_req.size >= shm->threshold) {
+    offset = chpl_mli_ring_reserve(chpl_mli_req.size);
+  }
+
+  // The empty delimiter frame the server's REP socket expects.
+  err = chpl_mli_push(chpl_client.main, NULL, 0, ZMQ_SNDMORE);
+
+  if (err >= 0 && offset >= 0) {
+    memcpy(shm->base + offset, chpl_mli_req.data, chpl_mli_req.size);
+    err = chpl_mli_push_shm_desc(chpl_client.main, offset, chpl_mli_req.size,
+                                 0);
+  } else if (err >= 0) {
+    err = chpl_mli_push_buf(chpl_client.main, &chpl_mli_req, 0);
+  }
+
+  if (err < 0) { chpl_mli_terminate(CHPL_MLI_CODE_ESOCKET); }
+
+  if (chpl_mli_ring_ends != NULL) {
+    last = chpl_mli_ring_ends_first + chpl_mli_outstanding;
+    chpl_mli_ring_ends[last % chpl_mli_ring_ends_len] = chpl_mli_ring_head;
+  }
+
+  chpl_mli_outstanding++;
+}
+
+//
+// Wait for the reply to the oldest outstanding request and return its
+// status code, leaving the reply positioned at the result.
+//
+static
+int64_t chpl_mli_pull_reply(void) {
+  struct chpl_mli_shm* shm = &chpl_client.shm;
+  int64_t st = CHPL_MLI_CODE_NONE;
+  int err = chpl_mli_pull_buf(chpl_client.main, &chpl_mli_rep, 0);
+  if (err >= 0) { err = chpl_mli_pull_buf(chpl_client.main, &chpl_mli_rep, 0); }
+  if (err < 0) { chpl_mli_terminate(CHPL_MLI_CODE_ESOCKET); }
+
+  chpl_mli_buf_resolve_shm(&chpl_mli_rep, shm->reply, shm->reply_size);
+
+  if (chpl_mli_ring_ends != NULL) {
+    uint64_t first = chpl_mli_ring_ends_first++;
+    chpl_mli_ring_tail = chpl_mli_ring_ends[first % chpl_mli_ring_ends_len];
+  }
+
+  chpl_mli_outstanding--;
+  chpl_mli_buf_read(&chpl_mli_rep, &st, sizeof(st));
+  return st;
+}
+
+static
+void chpl_mli_await_reply(void) {
+  int64_t st = chpl_mli_pull_reply();
+  if (st != CHPL_MLI_CODE_NONE) { chpl_mli_terminate(st); }
+}
+
+//
+// Offer the server a shared memory segment, which it will only take if it
+// is on this node.  Either way the name is unlinked afterwards, so that
+// the segment goes away with the last mapping of it.
+//
+static
+void chpl_mli_shm_offer(void) {
+  struct chpl_mli_buffer* buf = NULL;
+  const char* env = getenv("CHPL_RT_MLI_SHM_SIZE");
+  uint64_t size = env ? strtoull(env, NULL, 0) : 0;
+  uint64_t threshold = 64 * 1024;
+  uint64_t len = 0;
+  char name[64];
+  char host[256];
+  void* base = MAP_FAILED;
+  int64_t st = CHPL_MLI_CODE_NONE;
+  int fd = -1;
+
+  if (size == 0) { return; }
+
+  if ((env = getenv("CHPL_RT_MLI_SHM_THRESHOLD")) != NULL) {
+    threshold = strtoull(env, NULL, 0);
+  }
+
+  snprintf(name, sizeof(name), "/chpl_mli_%d", (int) getpid());
+  host[sizeof(host) - 1] = '\0';
+  if (gethostname(host, sizeof(host) - 1) != 0) { return; }
+
+  fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) { return; }
+
+  // Reserve the memory now, rather than faulting when it runs out later.
+#ifdef __linux__
+  if (posix_fallocate(fd, 0, size) == 0)
+#else
+  if (ftruncate(fd, size) == 0)
+#endif
+  {
+    base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+
+  if (base != MAP_FAILED) {
+    buf = chpl_mli_begin_call(CHPL_MLI_SHM_OFFER);
+    chpl_mli_buf_write(buf, &size, sizeof(size));
+    chpl_mli_buf_write(buf, &threshold, sizeof(threshold));
+    len = strlen(host);
+    chpl_mli_buf_write(buf, &len, sizeof(len));
+    chpl_mli_buf_write(buf, host, len);
+    len = strlen(name);
+    chpl_mli_buf_write(buf, &len, sizeof(len));
+    chpl_mli_buf_write(buf, name, len);
+    chpl_mli_send_request();
+    st = chpl_mli_pull_reply();
+  }
+
+  shm_unlink(name);
+
+  if (base == MAP_FAILED) { return; }
+
+  chpl_mli_debugf("Shared memory segment %s: %s\n", name,
+                  st == CHPL_MLI_CODE_NONE ? "in use" : "declined");
+
+  if (st != CHPL_MLI_CODE_NONE) {
+    munmap(base, size);
+    return;
+  }
+
+  chpl_mli_ring_ends_len = chpl_mli_pipeline_depth + 2;
+  chpl_mli_ring_ends = mli_malloc(chpl_mli_ring_ends_len * sizeof(uint64_t));
+  if (chpl_mli_ring_ends == NULL) {
+    munmap(base, size);
+    return;
+  }
+
+  chpl_mli_shm_layout(&chpl_client.shm, (char*) base, size, threshold);
+}
+
+//
+// Send the request started by chpl_mli_begin_call().  A call with a result
+// waits for all the outstanding replies and returns its own, positioned at
+// the result.  Other calls only wait if the pipeline is full, and return
+// NULL.
+//
+struct chpl_mli_buffer* chpl_mli_end_call(int hasResult) {
+  chpl_mli_send_request();
+
+  if (hasResult) {
+    while (chpl_mli_outstanding > 0) { chpl_mli_await_reply(); }
+    return &chpl_mli_rep;
+  }
+
+  while (chpl_mli_outstanding > chpl_mli_pipeline_depth) {
+    chpl_mli_await_reply();
+  }
+
+  return NULL;
+}
+
 //
 // Many of the launchers call `chpl_launch_using_exec`, so we make sure to
 // fork before calling `chpl_launcher_main` to avoid overwriting the client
@@ -169,19 +406,25 @@ void chpl_library_init(int argc, char** argv) {
 
   char* main_conn = chpl_mli_pull_connection();
   chpl_mli_debugf("Connection info for main %s\n", main_conn);
-  char* arg_conn = chpl_mli_pull_connection();
-  chpl_mli_debugf("Connection info for arg %s\n", arg_conn);
-  char* res_conn = chpl_mli_pull_connection();
-  chpl_mli_debugf("Connection info for res %s\n", res_conn);
 
   chpl_mli_connect(chpl_client.main, main_conn);
-  chpl_mli_connect(chpl_client.arg, arg_conn);
-  chpl_mli_connect(chpl_client.res, res_conn);
 
   chpl_mli_debugf("Clean up %s\n", "client port strings");
   mli_free(main_conn);
-  mli_free(arg_conn);
-  mli_free(res_conn);
+
+  chpl_mli_buf_init(&chpl_mli_req);
+  chpl_mli_buf_init(&chpl_mli_rep);
+
+  {
+    const char* depth = getenv("CHPL_RT_MLI_PIPELINE_DEPTH");
+    if (depth != NULL && atoll(depth) > 0) {
+      chpl_mli_pipeline_depth = atoll(depth);
+    }
+    chpl_mli_debugf("Pipeline depth: %lld\n",
+                    (long long) chpl_mli_pipeline_depth);
+  }
+
+  chpl_mli_shm_offer();
 
   return;
 }
@@ -194,19 +437,30 @@ void chpl_library_finalize(void) {
 
   {
     int64_t shutdown = CHPL_MLI_CODE_SHUTDOWN;
-    chpl_mli_push(chpl_client.main, &shutdown, sizeof(shutdown), 0);
-    chpl_mli_pull(chpl_client.main, &shutdown, sizeof(shutdown), 0);
+
+    // Let any pipelined calls finish first.
+    while (chpl_mli_outstanding > 0) { chpl_mli_await_reply(); }
+
+    chpl_mli_begin_call(shutdown);
+    chpl_mli_send_request();
+    shutdown = chpl_mli_pull_reply();
 
     // Can server ever respond with a different error?
     if (shutdown != CHPL_MLI_CODE_SHUTDOWN) { ;;; }
   }
 
+  chpl_mli_buf_free(&chpl_mli_req);
+  chpl_mli_buf_free(&chpl_mli_rep);
+  chpl_mli_shm_unmap(&chpl_client.shm);
+  if (chpl_mli_ring_ends != NULL) {
+    mli_free(chpl_mli_ring_ends);
+    chpl_mli_ring_ends = NULL;
+  }
+
   // TODO: It would be a good idea to set LINGER to 0 as well.
   // TODO: Maybe move the close connections to deinit?
   chpl_mli_close(chpl_client.setup_sock);
   chpl_mli_close(chpl_client.main);
-  chpl_mli_close(chpl_client.arg);
-  chpl_mli_close(chpl_client.res);
 
   chpl_mli_client_deinit(&chpl_client);
 
@@ -28,6 +28,9 @@
 #include <stdarg.h>
 #include <assert.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <zmq.h>
 
 //
@@ -128,6 +131,16 @@ enum chpl_mli_errors {
 };
 
 const char* chpl_mli_errstr(enum chpl_mli_errors e);
+void chpl_mli_terminate(enum chpl_mli_errors e);
+
+//
+// Request IDs (and reply status codes) that are neither routine IDs nor
+// errors.  A message starting with CHPL_MLI_SHM_DESC is followed by the
+// offset and size of the real message in the shared memory segment, and
+// one starting with CHPL_MLI_SHM_OFFER asks the server to map a segment.
+//
+#define CHPL_MLI_SHM_DESC  INT64_MIN
+#define CHPL_MLI_SHM_OFFER (INT64_MIN + 1)
 
 const char* chpl_mli_errstr(enum chpl_mli_errors e) {
   static const char* mli_errors_[] = {
@@ -148,6 +161,24 @@ const char* chpl_mli_errstr(enum chpl_mli_errors e) {
   return mli_errors_[-e];
 }
 
+//
+// When the client and server are on the same node they can share a memory
+// segment, and then messages of at least 'threshold' bytes are copied into
+// it and only described over ZMQ.  The first 'ring_size' bytes are a ring
+// of requests, which the client reuses once their replies arrive, and the
+// rest holds the one reply the client is waiting on.
+//
+struct chpl_mli_shm {
+
+  char* base;
+  size_t size;
+  size_t ring_size;
+  char* reply;
+  size_t reply_size;
+  size_t threshold;
+
+};
+
 //
 // Both the client and server will be using this to communicate.
 //
@@ -156,11 +187,102 @@ struct chpl_mli_context {
   void* context;
   void* setup_sock;
   void* main;
-  void* arg;
-  void* res;
+  struct chpl_mli_shm shm;
 
 };
 
+//
+// Every call is a single message each way.  A request is the int64 ID of
+// the routine to call followed by its packed arguments, and a reply is an
+// int64 status code followed by the packed result.  Scalars are packed as
+// their raw bytes, and strings, bytes and arrays of scalars as a uint64
+// length followed by their contents.
+//
+struct chpl_mli_buffer {
+
+  char* data;
+  size_t size;
+  size_t cap;
+  size_t pos;
+
+};
+
+static
+void chpl_mli_buf_init(struct chpl_mli_buffer* buf) {
+  buf->data = NULL;
+  buf->size = 0;
+  buf->cap = 0;
+  buf->pos = 0;
+}
+
+static
+void chpl_mli_buf_free(struct chpl_mli_buffer* buf) {
+  if (buf->data != NULL) { mli_free(buf->data); }
+  chpl_mli_buf_init(buf);
+}
+
+static
+void chpl_mli_buf_reserve(struct chpl_mli_buffer* buf, size_t bytes) {
+  size_t cap = buf->cap ? buf->cap : 256;
+  char* data = NULL;
+
+  if (buf->size + bytes <= buf->cap) { return; }
+
+  while (cap < buf->size + bytes) { cap *= 2; }
+
+  data = mli_malloc(cap);
+  if (data == NULL) { chpl_mli_terminate(CHPL_MLI_CODE_EMEMORY); }
+
+  if (buf->data != NULL) {
+    memcpy(data, buf->data, buf->size);
+    mli_free(buf->data);
+  }
+
+  buf->data = data;
+  buf->cap = cap;
+}
+
+static
+void chpl_mli_buf_write(struct chpl_mli_buffer* buf, const void* src,
+                        size_t bytes) {
+  if (bytes == 0) { return; }
+  chpl_mli_buf_reserve(buf, bytes);
+  memcpy(buf->data + buf->size, src, bytes);
+  buf->size += bytes;
+}
+
+static
+void chpl_mli_buf_read(struct chpl_mli_buffer* buf, void* dst,
+                       size_t bytes) {
+  if (bytes > buf->size - buf->pos) {
+    chpl_mli_terminate(CHPL_MLI_CODE_ESOCKET);
+  }
+  if (bytes == 0) { return; }
+  memcpy(dst, buf->data + buf->pos, bytes);
+  buf->pos += bytes;
+}
+
+//
+// Read 'bytes' bytes into newly allocated memory, with a trailing NUL so
+// that strings can be used as they are.
+//
+static
+void* chpl_mli_buf_read_alloc(struct chpl_mli_buffer* buf, size_t bytes) {
+  char* result = mli_malloc(bytes + 1);
+  if (result == NULL) { chpl_mli_terminate(CHPL_MLI_CODE_EMEMORY); }
+  chpl_mli_buf_read(buf, result, bytes);
+  result[bytes] = '\0';
+  return result;
+}
+
+//
+// Used as the free function for arrays whose elements were unpacked here.
+//
+static
+void chpl_mli_free_elts(void* elts) {
+  if (elts != NULL) { mli_free(elts); }
+}
+
 static
 char* chpl_mli_concat(size_t count, ...) {
   char* result = NULL;
@@ -237,6 +359,89 @@ int chpl_mli_pull(void* socket, void* buffer, size_t bytes, int flags) {
   return zmq_recv(socket, buffer, bytes, flags);
 }
 
+static
+int chpl_mli_push_buf(void* socket, struct chpl_mli_buffer* buf, int flags) {
+  return zmq_send(socket, buf->data ? buf->data : "", buf->size, flags);
+}
+
+//
+// Receive a whole message, whatever its size, into 'buf'.  Descriptors of
+// messages in a shared memory area need chpl_mli_buf_resolve_shm() too.
+//
+static
+int chpl_mli_pull_buf(void* socket, struct chpl_mli_buffer* buf, int flags) {
+  zmq_msg_t msg;
+  int err = 0;
+
+  zmq_msg_init(&msg);
+  err = zmq_msg_recv(&msg, socket, flags);
+
+  if (err >= 0) {
+    buf->size = 0;
+    buf->pos = 0;
+    chpl_mli_buf_write(buf, zmq_msg_data(&msg), zmq_msg_size(&msg));
+  }
+
+  zmq_msg_close(&msg);
+
+  return err;
+}
+
+static
+void chpl_mli_shm_layout(struct chpl_mli_shm* shm, char* base, size_t size,
+                         size_t threshold) {
+  shm->base = base;
+  shm->size = size;
+  shm->ring_size = (size / 2) & ~((size_t) 7);
+  shm->reply = base + shm->ring_size;
+  shm->reply_size = size - shm->ring_size;
+  shm->threshold = threshold;
+}
+
+static
+void chpl_mli_shm_unmap(struct chpl_mli_shm* shm) {
+  if (shm->base == NULL) { return; }
+  munmap(shm->base, shm->size);
+  shm->base = NULL;
+}
+
+//
+// Send a descriptor for the 'bytes' byte message at 'offset' in a shared
+// memory area.
+//
+static
+int chpl_mli_push_shm_desc(void* socket, uint64_t offset, uint64_t bytes,
+                           int flags) {
+  int64_t desc[3];
+  desc[0] = CHPL_MLI_SHM_DESC;
+  desc[1] = (int64_t) offset;
+  desc[2] = (int64_t) bytes;
+  return chpl_mli_push(socket, desc, sizeof(desc), flags);
+}
+
+//
+// If 'buf' holds a descriptor, replace it with the message it describes in
+// the 'size' byte shared memory 'area'.
+//
+static
+void chpl_mli_buf_resolve_shm(struct chpl_mli_buffer* buf, const char* area,
+                              size_t size) {
+  int64_t desc[3];
+
+  if (area == NULL || buf->size != sizeof(desc)) { return; }
+
+  memcpy(desc, buf->data, sizeof(desc));
+  if (desc[0] != CHPL_MLI_SHM_DESC) { return; }
+
+  if ((uint64_t) desc[1] > size || (uint64_t) desc[2] > size - desc[1]) {
+    chpl_mli_terminate(CHPL_MLI_CODE_ESOCKET);
+  }
+
+  buf->size = 0;
+  buf->pos = 0;
+  chpl_mli_buf_write(buf, area + desc[1], desc[2]);
+}
+
 // Determine connection information for that socket.
 static
 char * chpl_mli_connection_info(void* socket) {
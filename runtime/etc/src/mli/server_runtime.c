@@ -30,9 +30,12 @@ void chpl_mli_terminate(enum chpl_mli_errors e);
 void chpl_mli_smain(const char* setup_conn);
 
 //
-// The definition of this is generated by the compiler.
+// The definition of this is generated by the compiler.  It unpacks the
+// arguments of routine 'id' from 'req', calls it and packs the result into
+// 'rep'.
 //
-int64_t chpl_mli_sdispatch(int64_t id);
+int64_t chpl_mli_sdispatch(int64_t id, struct chpl_mli_buffer* req,
+                           struct chpl_mli_buffer* rep);
 
 //
 // Contains sockets.
@@ -45,8 +48,6 @@ void chpl_mli_server_init(struct chpl_mli_context* server) {
   server->context = zmq_ctx_new();
   server->setup_sock = zmq_socket(server->context, ZMQ_PUSH);
   server->main    = zmq_socket(server->context, ZMQ_REP);
-  server->arg     = zmq_socket(server->context, ZMQ_REP);
-  server->res     = zmq_socket(server->context, ZMQ_REQ);
 
   return;
 }
@@ -76,7 +77,77 @@ void chpl_mli_terminate(enum chpl_mli_errors e) {
   mli_terminate();
 }
 
+//
+// Map the shared memory segment the client offers in 'req', if the client
+// is on this node.  Returns the status code of the reply.
+//
+static
+int64_t chpl_mli_shm_accept(struct chpl_mli_buffer* req) {
+  struct chpl_mli_shm* shm = &chpl_server.shm;
+  uint64_t size = 0;
+  uint64_t threshold = 0;
+  uint64_t len = 0;
+  char* client_host = NULL;
+  char* name = NULL;
+  char host[256];
+  struct stat st;
+  void* base = MAP_FAILED;
+  int fd = -1;
+
+  chpl_mli_buf_read(req, &size, sizeof(size));
+  chpl_mli_buf_read(req, &threshold, sizeof(threshold));
+  chpl_mli_buf_read(req, &len, sizeof(len));
+  client_host = chpl_mli_buf_read_alloc(req, len);
+  chpl_mli_buf_read(req, &len, sizeof(len));
+  name = chpl_mli_buf_read_alloc(req, len);
+
+  host[sizeof(host) - 1] = '\0';
+  if (shm->base == NULL &&
+      gethostname(host, sizeof(host) - 1) == 0 &&
+      strcmp(host, client_host) == 0) {
+    fd = shm_open(name, O_RDWR, 0);
+  }
+
+  if (fd >= 0) {
+    if (fstat(fd, &st) == 0 && (uint64_t) st.st_size == size) {
+      base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+  }
+
+  chpl_mli_debugf("Shared memory segment %s: %s\n", name,
+                  base == MAP_FAILED ? "declined" : "mapped");
+
+  if (base != MAP_FAILED) {
+    chpl_mli_shm_layout(shm, (char*) base, size, threshold);
+  }
+
+  mli_free(client_host);
+  mli_free(name);
+
+  return base == MAP_FAILED ? CHPL_MLI_CODE_EUNKNOWN : CHPL_MLI_CODE_NONE;
+}
+
+//
+// Send the reply, through the shared memory segment if it is big enough
+// to be worth it and fits.
+//
+static
+int chpl_mli_push_reply(struct chpl_mli_buffer* rep) {
+  struct chpl_mli_shm* shm = &chpl_server.shm;
+
+  if (shm->base != NULL && rep->size >= shm->threshold &&
+      rep->size <= shm->reply_size) {
+    memcpy(shm->reply, rep->data, rep->size);
+    return chpl_mli_push_shm_desc(chpl_server.main, 0, rep->size, 0);
+  }
+
+  return chpl_mli_push_buf(chpl_server.main, rep, 0);
+}
+
 void chpl_mli_smain(const char* setup_conn) {
+  struct chpl_mli_buffer req;
+  struct chpl_mli_buffer rep;
   int64_t id = -1;
   int64_t ack = 0;
   int execute = 1;
@@ -96,68 +167,68 @@ void chpl_mli_smain(const char* setup_conn) {
   char* main_conn = chpl_mli_connection_info(chpl_server.main);
   chpl_mli_debugf("Main port on: %s\n", main_conn);
 
-  chpl_mli_bind(chpl_server.arg);
-  char* arg_conn = chpl_mli_connection_info(chpl_server.arg);
-  chpl_mli_debugf("Arg port on: %s\n", arg_conn);
-
-  chpl_mli_bind(chpl_server.res);
-  char* res_conn = chpl_mli_connection_info(chpl_server.res);
-  chpl_mli_debugf("Res port on: %s\n", res_conn);
-
-  // Send main, arg, res connection info to the client
+  // Send main connection info to the client
   chpl_mli_debugf("%s\n", "Sending connection information to the client");
   chpl_mli_push_connection(main_conn);
-  chpl_mli_push_connection(arg_conn);
-  chpl_mli_push_connection(res_conn);
 
   chpl_mli_debugf("%s\n", "Clean up obtained connection strings");
   mli_free(main_conn);
-  mli_free(arg_conn);
-  mli_free(res_conn);
+
+  // The buffers are reused for every call, so they only grow.
+  chpl_mli_buf_init(&req);
+  chpl_mli_buf_init(&rep);
 
   while (execute) {
 
     chpl_mli_debugf("%s\n", "Listening...");
-    
-    // Every transaction starts by reading an int64 off the wire.
-    err = chpl_mli_pull(
-              chpl_server.main,
-              &id,
-              sizeof(id),
-              0);
+
+    // Every transaction is one request carrying an ID and the arguments.
+    err = chpl_mli_pull_buf(chpl_server.main, &req, 0);
 
     // TODO: Handle socket errors on inbound read.
     if (err < 0) {
       chpl_mli_debugf("Socket error on read: %d\n", err);
-      ack = CHPL_MLI_CODE_ESOCKET;
+      continue;
     }
 
-    if (id < 0) {
+    chpl_mli_buf_resolve_shm(&req, chpl_server.shm.base,
+                             chpl_server.shm.ring_size);
+    chpl_mli_buf_read(&req, &id, sizeof(id));
+
+    // Leave room for the status code ahead of the result.
+    ack = CHPL_MLI_CODE_NONE;
+    rep.size = 0;
+    chpl_mli_buf_write(&rep, &ack, sizeof(ack));
+
+    if (id == CHPL_MLI_SHM_OFFER) {
+      ack = chpl_mli_shm_accept(&req);
+    } else if (id < 0) {
       chpl_mli_debugf("Client sent code: %s\n", chpl_mli_errstr(id));
       ack = CHPL_MLI_CODE_SHUTDOWN;
       execute = 0;
     } else {
       chpl_mli_debugf("Received request for ID: %lld\n", id);
-      ack = CHPL_MLI_CODE_NONE;
+      ack = chpl_mli_sdispatch(id, &req, &rep);
+      if (ack != CHPL_MLI_CODE_NONE) { rep.size = sizeof(ack); }
     }
- 
-    chpl_mli_debugf("Responding with code: %s\n", chpl_mli_errstr(0));
-    err = chpl_mli_push(chpl_server.main, &ack, sizeof(ack), 0);
 
-    if (err < 0) { chpl_mli_debugf("Socket error on write: %d\n", err); }
+    chpl_mli_debugf("Responding with code: %s\n", chpl_mli_errstr(ack));
+    memcpy(rep.data, &ack, sizeof(ack));
+    err = chpl_mli_push_reply(&rep);
 
-    // TODO: This ack value is currently just overwritten...
-    if (execute && id > 0) { ack = chpl_mli_sdispatch(id); }
+    if (err < 0) { chpl_mli_debugf("Socket error on write: %d\n", err); }
   }
 
+  chpl_mli_buf_free(&req);
+  chpl_mli_buf_free(&rep);
+  chpl_mli_shm_unmap(&chpl_server.shm);
+
   chpl_mli_debugf("Shutdown, code: %s\n", chpl_mli_errstr(id));
 
   seconds = (double) (clock() - before) / (double) CLOCKS_PER_SEC;
 
   chpl_mli_close(chpl_server.setup_sock);
   chpl_mli_close(chpl_server.main);
-  chpl_mli_close(chpl_server.arg);
-  chpl_mli_close(chpl_server.res);
 
   chpl_mli_server_deinit(&chpl_server);
 
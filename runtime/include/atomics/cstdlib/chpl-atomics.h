@@ -251,6 +251,65 @@ DECLARE_REAL_ATOMICS(_real32);
 DECLARE_REAL_ATOMICS(_real64);
 
 
+//
+// 128-bit atomics, for things that have to be swapped as a unit, such
+// as a wide pointer or a pointer and an ABA counter.  Both C11 and C++
+// compilers implement 16-byte standard atomics by calling out to
+// libatomic, which we don't link with, so these use the 16-byte
+// compare-and-swap builtin instead, where the target has it inline.
+//
+#if defined(__SIZEOF_INT128__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define CHPL_HAVE_ATOMIC_UINT128 1
+typedef unsigned __int128 chpl_uint128_t;
+typedef __attribute__ ((aligned (16))) chpl_uint128_t atomic_uint128_t;
+
+static inline chpl_bool atomic_is_lock_free_uint128_t(atomic_uint128_t * obj) {
+  return true;
+}
+static inline void atomic_init_uint128_t(atomic_uint128_t * obj, chpl_uint128_t value) {
+  *obj = value;
+}
+static inline void atomic_destroy_uint128_t(atomic_uint128_t * obj) {
+}
+static inline chpl_bool atomic_compare_exchange_strong_explicit_uint128_t(atomic_uint128_t * obj, chpl_uint128_t * expected, chpl_uint128_t desired, memory_order succ, memory_order fail) {
+  chpl_uint128_t old_expected = *expected;
+  chpl_uint128_t old_value = __sync_val_compare_and_swap(obj, old_expected, desired);
+  if (old_value == old_expected) return true;
+  *expected = old_value;
+  return false;
+}
+static inline chpl_bool atomic_compare_exchange_strong_uint128_t(atomic_uint128_t * obj, chpl_uint128_t * expected, chpl_uint128_t desired) {
+  return atomic_compare_exchange_strong_explicit_uint128_t(obj, expected, desired, memory_order_seq_cst, memory_order_seq_cst);
+}
+static inline chpl_bool atomic_compare_exchange_weak_explicit_uint128_t(atomic_uint128_t * obj, chpl_uint128_t * expected, chpl_uint128_t desired, memory_order succ, memory_order fail) {
+  return atomic_compare_exchange_strong_explicit_uint128_t(obj, expected, desired, succ, fail);
+}
+static inline chpl_bool atomic_compare_exchange_weak_uint128_t(atomic_uint128_t * obj, chpl_uint128_t * expected, chpl_uint128_t desired) {
+  return atomic_compare_exchange_strong_uint128_t(obj, expected, desired);
+}
+static inline chpl_uint128_t atomic_load_explicit_uint128_t(atomic_uint128_t * obj, memory_order order) {
+  return __sync_val_compare_and_swap(obj, (chpl_uint128_t) 0, (chpl_uint128_t) 0);
+}
+static inline chpl_uint128_t atomic_load_uint128_t(atomic_uint128_t * obj) {
+  return atomic_load_explicit_uint128_t(obj, memory_order_seq_cst);
+}
+static inline chpl_uint128_t atomic_exchange_explicit_uint128_t(atomic_uint128_t * obj, chpl_uint128_t value, memory_order order) {
+  chpl_uint128_t old_val = *obj;
+  while (!atomic_compare_exchange_strong_uint128_t(obj, &old_val, value)) { }
+  return old_val;
+}
+static inline chpl_uint128_t atomic_exchange_uint128_t(atomic_uint128_t * obj, chpl_uint128_t value) {
+  return atomic_exchange_explicit_uint128_t(obj, value, memory_order_seq_cst);
+}
+static inline void atomic_store_explicit_uint128_t(atomic_uint128_t * obj, chpl_uint128_t value, memory_order order) {
+  (void) atomic_exchange_explicit_uint128_t(obj, value, order);
+}
+static inline void atomic_store_uint128_t(atomic_uint128_t * obj, chpl_uint128_t value) {
+  atomic_store_explicit_uint128_t(obj, value, memory_order_seq_cst);
+}
+#endif
+
+
 #undef DECLARE_ATOMICS_BASE
 #undef DECLARE_ATOMICS_EXCHANGE_OPS
 #undef DECLARE_ATOMICS_FETCH_OPS
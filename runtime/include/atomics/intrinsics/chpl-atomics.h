@@ -57,6 +57,19 @@ typedef uint32_t atomic__real32;
 
 typedef volatile uint8_t atomic_spinlock_t;
 
+//
+// 128-bit atomics, for things that have to be swapped as a unit, such
+// as a wide pointer or a pointer and an ABA counter.  We only have
+// these where the target can do a 16-byte compare-and-swap inline
+// (x86_64 with -mcx16, aarch64), since otherwise the compiler calls
+// out to libatomic, which we don't link with.
+//
+#if defined(__SIZEOF_INT128__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define CHPL_HAVE_ATOMIC_UINT128 1
+typedef unsigned __int128 chpl_uint128_t;
+typedef SIZE_ALIGN_TYPE(chpl_uint128_t) atomic_uint128_t;
+#endif
+
 #undef SIZE_ALIGN_TYPE
 
 typedef enum {
@@ -343,6 +356,11 @@ DECLARE_ATOMICS_BASE(uintptr_t, uintptr_t);
 DECLARE_ATOMICS_EXCHANGE_OPS(uintptr_t, uintptr_t);
 DECLARE_ATOMICS_FETCH_OPS(uintptr_t);
 
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+DECLARE_ATOMICS_BASE(uint128_t, chpl_uint128_t);
+DECLARE_ATOMICS_EXCHANGE_OPS(uint128_t, chpl_uint128_t);
+#endif
+
 
 #define DECLARE_REAL_ATOMICS(type, uinttype) \
   DECLARE_REAL_ATOMICS_BASE(type, uinttype) \
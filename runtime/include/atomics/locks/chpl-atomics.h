@@ -101,6 +101,19 @@ typedef struct atomic__real64_s {
   _real64 v;
 } atomic__real64;
 
+//
+// 128-bit atomics, for things that have to be swapped as a unit, such
+// as a wide pointer or a pointer and an ABA counter.
+//
+#ifdef __SIZEOF_INT128__
+#define CHPL_HAVE_ATOMIC_UINT128 1
+typedef unsigned __int128 chpl_uint128_t;
+typedef struct atomic_uint128_s {
+  pthread_mutex_t lock;
+  chpl_uint128_t v;
+} atomic_uint128_t;
+#endif
+
 typedef pthread_spinlock_t atomic_spinlock_t;
 
 typedef enum {
@@ -305,6 +318,10 @@ DECLARE_ATOMICS(uint_least64_t);
 DECLARE_ATOMICS_BASE(uintptr_t, uintptr_t);
 DECLARE_ATOMICS_FETCH_OPS(uintptr_t);
 
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+DECLARE_ATOMICS_BASE(uint128_t, chpl_uint128_t);
+#endif
+
 DECLARE_REAL_ATOMICS(_real32);
 DECLARE_REAL_ATOMICS(_real64);
 
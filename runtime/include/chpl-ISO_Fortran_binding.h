@@ -18,12 +18,88 @@
  * limitations under the License.
  */
 
+#ifndef _chpl_ISO_Fortran_binding_h_
+#define _chpl_ISO_Fortran_binding_h_
+
+#include <stdint.h>
+
 #ifdef __ICC
 #include "ISO_Fortran_binding.h"
+#define CHPL_HAVE_ISO_FORTRAN_BINDING
 #else
 #ifdef _CRAYC
 #include "ISO_Fortran_binding.h"
+#define CHPL_HAVE_ISO_FORTRAN_BINDING
 #else
 // Stub it out for other compilers
 #endif
 #endif
+
+#ifdef CHPL_HAVE_ISO_FORTRAN_BINDING
+
+//
+// A Fortran array described by a CFI_cdesc_t, in terms a Chapel array
+// view can use directly: the address of its first element and, for each
+// dimension, the lower bound, the extent and the stride in elements.
+// Strided sections are described the same way as contiguous arrays, so
+// neither needs to be copied.
+//
+typedef struct {
+  void* elts;
+  int64_t rank;
+  int64_t lower[CFI_MAX_RANK];
+  int64_t extent[CFI_MAX_RANK];
+  int64_t stride[CFI_MAX_RANK];
+} chpl_cfi_view;
+
+//
+// Fill in 'view' for 'desc'.  Returns 0 on success, or -1 if 'desc' isn't
+// allocated or a stride isn't a whole number of elements (which a view
+// can't express, and so the array still needs a copy).
+//
+static inline
+int chpl_cfi_make_view(const CFI_cdesc_t* desc, chpl_cfi_view* view) {
+  int64_t elt_len = (int64_t) desc->elem_len;
+  int i;
+
+  if (desc->base_addr == NULL || elt_len <= 0 || desc->rank > CFI_MAX_RANK)
+    return -1;
+
+  view->elts = desc->base_addr;
+  view->rank = desc->rank;
+
+  for (i = 0; i < desc->rank; i++) {
+    int64_t sm = (int64_t) desc->dim[i].sm;
+
+    if (sm % elt_len != 0)
+      return -1;
+
+    view->lower[i] = (int64_t) desc->dim[i].lower_bound;
+    view->extent[i] = (int64_t) desc->dim[i].extent;
+    view->stride[i] = sm / elt_len;
+  }
+
+  return 0;
+}
+
+//
+// Whether the elements of 'desc' are contiguous in Fortran (column-major)
+// order, so that it can be viewed as a plain external array.
+//
+static inline
+int chpl_cfi_is_contiguous(const CFI_cdesc_t* desc) {
+  int64_t expected = (int64_t) desc->elem_len;
+  int i;
+
+  for (i = 0; i < desc->rank; i++) {
+    if (desc->dim[i].extent > 1 && (int64_t) desc->dim[i].sm != expected)
+      return 0;
+    expected *= (int64_t) desc->dim[i].extent;
+  }
+
+  return 1;
+}
+
+#endif // CHPL_HAVE_ISO_FORTRAN_BINDING
+
+#endif
@@ -31,6 +31,14 @@
 extern "C" {
 #endif
 
+// The cache line size assumed when keeping data written by different
+// tasks apart, e.g. the per-task reduce op instances the compiler creates.
+#ifndef CHPL_CACHE_LINE_SIZE
+#define CHPL_CACHE_LINE_SIZE 64
+#endif
+
+#define CHPL_CACHE_LINE_ALIGNED __attribute__((aligned(CHPL_CACHE_LINE_SIZE)))
+
 // If we have a mask representing 2^n - 1,
 // round an offset down to a multiple of 2^n.
 static inline
@@ -28,6 +28,16 @@ extern "C" {
 // This is the type of the task private data used by the cache
 typedef struct {
   int64_t last_acquire; // cache acquire barrier sets this
+  uint64_t shared_acquire_epoch; // ... and this, if the shared tier is on
+  // stride prefetcher state
+  uintptr_t stride_last_raddr; // remote address of the last demand GET
+  intptr_t stride;             // last observed stride between GETs
+  uintptr_t stride_prefetched; // furthest address prefetched for this stride
+  int32_t stride_node;         // node of the last demand GET
+  int16_t stride_confidence;   // how many times in a row we saw 'stride'
+  int16_t stride_prefetching;  // set while issuing stride prefetches
+  // per-callsite statistics for the current cache operation, or NULL
+  struct chpl_cache_callsite_s* callsite;
 } chpl_cache_taskPrvData_t;
 
 #ifdef __cplusplus
@@ -98,6 +98,11 @@ void chpl_cache_comm_getput_unordered_task_fence(void);
 void chpl_cache_print(void);
 void chpl_cache_assert_released(void);
 void chpl_cache_print_stats(void);
+
+// Per-callsite statistics, gathered while comm diagnostics are on if
+// CHPL_RT_CACHE_CALLSITE_STATS is set. These act on this node only.
+void chpl_cache_print_callsite_stats(void);
+void chpl_cache_reset_callsite_stats(void);
 // just stores 0s in the cache; here to exercise the data structures
 // returns 1 if the data was cached
 int chpl_cache_mock_get(c_nodeid_t node, uint64_t raddr, size_t size);
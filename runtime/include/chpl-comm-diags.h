@@ -55,10 +55,27 @@ extern int chpl_comm_diags_print_unstable;
   MACRO(execute_on) \
   MACRO(execute_on_fast) \
   MACRO(execute_on_nb) \
+  MACRO(am_batches) \
+  MACRO(am_batched_reqs) \
+  MACRO(tci_alloc_contended) \
+  MACRO(mr_cache_hits) \
+  MACRO(mr_cache_misses) \
+  MACRO(bounce_pool_misses) \
+  MACRO(amo_agg_combined) \
+  MACRO(amo_cas_retries) \
   MACRO(cache_get_hits) \
   MACRO(cache_get_misses) \
   MACRO(cache_put_hits) \
-  MACRO(cache_put_misses)
+  MACRO(cache_put_misses) \
+  MACRO(cache_stride_prefetches) \
+  MACRO(cache_stride_prefetch_hits) \
+  MACRO(cache_stride_prefetch_unused) \
+  MACRO(cache_shared_hits) \
+  MACRO(cache_shared_misses) \
+  MACRO(cache_ain_evictions) \
+  MACRO(cache_am_evictions) \
+  MACRO(cache_aout_evictions) \
+  MACRO(cache_am_promotions)
 
 
 typedef struct _chpl_commDiagnostics {
@@ -79,6 +96,41 @@ void chpl_comm_stopDiagnosticsHere(void);
 void chpl_comm_resetDiagnosticsHere(void);
 void chpl_comm_getDiagnosticsHere(chpl_commDiagnostics *cd);
 
+//
+// Message size histograms.  Bin 0 counts sizes 0 and 1, and bin i > 0
+// counts sizes in [2^i, 2^(i+1)), with everything larger landing in the
+// last bin.  These are kept whenever the counters above are.
+//
+#define CHPL_COMM_DIAGS_HIST_BINS 32
+
+#define CHPL_COMM_DIAGS_HISTS_ALL(MACRO) \
+  MACRO(put) \
+  MACRO(get) \
+  MACRO(execute_on)
+
+typedef struct _chpl_commDiagsHists {
+#define _COMM_DIAGS_HIST_DECL(cdh) uint64_t cdh[CHPL_COMM_DIAGS_HIST_BINS];
+  CHPL_COMM_DIAGS_HISTS_ALL(_COMM_DIAGS_HIST_DECL)
+#undef _COMM_DIAGS_HIST_DECL
+} chpl_commDiagsHists;
+
+void chpl_comm_getDiagsHistsHere(chpl_commDiagsHists *cdh);
+
+//
+// Per-destination traffic: bytes sent from here by PUTs, GETs (their
+// replies, really), and executeOn arguments, by node.  Together, the
+// nodes' rows make up an N x N traffic matrix.  This is only kept if
+// CHPL_RT_COMM_DIAGS_TRAFFIC is true; otherwise this returns zeroes.
+// 'bytes' must have room for chpl_numNodes entries.
+//
+void chpl_comm_getDiagsTrafficHere(uint64_t *bytes);
+
+//
+// If CHPL_RT_COMM_DIAGS_CSV is set, write this node's counters,
+// histograms and traffic row to <value>.<nodeID>.csv.  Called at exit.
+//
+void chpl_comm_diags_dump_csv(void);
+
 
 ////////////////////
 //
@@ -90,16 +142,33 @@ typedef struct _chpl_atomic_commDiagnostics {
 #undef _COMM_DIAGS_DECL_ATOMIC
 } chpl_atomic_commDiagnostics;
 
+typedef struct _chpl_atomic_commDiagsHists {
+#define _COMM_DIAGS_HIST_DECL_ATOMIC(cdh) \
+        atomic_uint_least64_t cdh[CHPL_COMM_DIAGS_HIST_BINS];
+  CHPL_COMM_DIAGS_HISTS_ALL(_COMM_DIAGS_HIST_DECL_ATOMIC)
+#undef _COMM_DIAGS_HIST_DECL_ATOMIC
+} chpl_atomic_commDiagsHists;
+
 extern chpl_atomic_commDiagnostics chpl_comm_diags_counters;
+extern chpl_atomic_commDiagsHists chpl_comm_diags_hists;
+extern atomic_uint_least64_t* chpl_comm_diags_traffic;
 extern atomic_int_least16_t chpl_comm_diags_disable_flag;
 
+void chpl_comm_diags_init_traffic(void);
+
 static inline
 void chpl_comm_diags_init(void) {
 #define _COMM_DIAGS_INIT(cdv) \
         atomic_init_uint_least64_t(&chpl_comm_diags_counters.cdv, 0);
   CHPL_COMM_DIAGS_VARS_ALL(_COMM_DIAGS_INIT);
 #undef _COMM_DIAGS_INIT
+#define _COMM_DIAGS_HIST_INIT(cdh)                                      \
+        for (int i = 0; i < CHPL_COMM_DIAGS_HIST_BINS; i++)             \
+          atomic_init_uint_least64_t(&chpl_comm_diags_hists.cdh[i], 0);
+  CHPL_COMM_DIAGS_HISTS_ALL(_COMM_DIAGS_HIST_INIT);
+#undef _COMM_DIAGS_HIST_INIT
   atomic_init_int_least16_t(&chpl_comm_diags_disable_flag, 0);
+  chpl_comm_diags_init_traffic();
 }
 
 static inline
@@ -108,6 +177,16 @@ void chpl_comm_diags_reset(void) {
         atomic_store_uint_least64_t(&chpl_comm_diags_counters.cdv, 0);
  CHPL_COMM_DIAGS_VARS_ALL(_COMM_DIAGS_RESET);
 #undef _COMM_DIAGS_RESET
+#define _COMM_DIAGS_HIST_RESET(cdh)                                     \
+        for (int i = 0; i < CHPL_COMM_DIAGS_HIST_BINS; i++)             \
+          atomic_store_uint_least64_t(&chpl_comm_diags_hists.cdh[i], 0);
+  CHPL_COMM_DIAGS_HISTS_ALL(_COMM_DIAGS_HIST_RESET);
+#undef _COMM_DIAGS_HIST_RESET
+  if (chpl_comm_diags_traffic != NULL) {
+    for (int i = 0; i < chpl_numNodes; i++) {
+      atomic_store_uint_least64_t(&chpl_comm_diags_traffic[i], 0);
+    }
+  }
 }
 
 static inline
@@ -133,51 +212,84 @@ int chpl_comm_diags_is_enabled(void) {
   return (atomic_load_int_least16_t(&chpl_comm_diags_disable_flag) <= 0);
 }
 
+//
+// Verbose comm output can be thinned out or summarized.  If
+// CHPL_RT_COMM_VERBOSE_SAMPLE=N is set only every Nth event is printed,
+// and if CHPL_RT_COMM_VERBOSE_SAMPLE_USECS=T is set at most one event
+// is printed every T microseconds.  If CHPL_RT_COMM_VERBOSE_AGGREGATE
+// is true nothing is printed per event; instead events are counted by
+// (line, file, op, node) and the totals are printed when verbose comm
+// is stopped on this node or the program exits.  This decides whether
+// to print the event, recording it if we're aggregating.
+//
+chpl_bool chpl_comm_diags_verbose_take(const char* op, const char* kind,
+                                       int node, size_t size,
+                                       int ln, int32_t fn);
+void chpl_comm_diags_verbose_flush_aggregate(void);
+
 #define chpl_comm_diags_verbose_printf(is_unstable, format, ...)   \
   do {                                                             \
     if (chpl_verbose_comm                                          \
         && chpl_comm_diags_is_enabled()                            \
         && (!is_unstable || chpl_comm_diags_print_unstable)) {     \
-      char* stack = NULL;                                          \
-      if (chpl_verbose_comm_stacktrace) {                          \
-        stack = chpl_stack_unwind_to_string(' ');                  \
-      }                                                            \
-      if (stack != NULL) {                                         \
-        printf("%d: " format " <%s>\n", chpl_nodeID, __VA_ARGS__, stack); \
-        chpl_mem_free(stack, 0, 0);                                \
-      } else {                                                     \
-        printf("%d: " format "\n", chpl_nodeID, __VA_ARGS__);      \
-      }                                                            \
+      _chpl_comm_diags_verbose_print(format, __VA_ARGS__);         \
+    }                                                              \
+  } while(0)
+
+#define chpl_comm_diags_verbose_event(is_unstable, op, kind, node, size, \
+                                      ln, fn, format, ...)       \
+  do {                                                             \
+    if (chpl_verbose_comm                                          \
+        && chpl_comm_diags_is_enabled()                            \
+        && (!is_unstable || chpl_comm_diags_print_unstable)        \
+        && chpl_comm_diags_verbose_take(op, kind, node, size,      \
+                                        ln, fn)) {                 \
+      _chpl_comm_diags_verbose_print(format, __VA_ARGS__);         \
+    }                                                              \
+  } while(0)
+
+#define _chpl_comm_diags_verbose_print(format, ...)                \
+  do {                                                             \
+    char* stack = NULL;                                            \
+    if (chpl_verbose_comm_stacktrace) {                            \
+      stack = chpl_stack_unwind_to_string(' ');                    \
+    }                                                              \
+    if (stack != NULL) {                                           \
+      printf("%d: " format " <%s>\n", chpl_nodeID, __VA_ARGS__, stack); \
+      chpl_mem_free(stack, 0, 0);                                  \
+    } else {                                                       \
+      printf("%d: " format "\n", chpl_nodeID, __VA_ARGS__);        \
     }                                                              \
   } while(0)
 
 #define chpl_comm_diags_verbose_rdma(op, node, size, ln, fn, commid)     \
-  chpl_comm_diags_verbose_printf(false,                                  \
-                                 "%s:%d: remote %s, node %d, %zu bytes, " \
-                                 "commid %d",                            \
-                                 chpl_lookupFilename(fn), ln, op,        \
-                                 (int) node, size, (int) commid)
+  chpl_comm_diags_verbose_event(false, op, "", node, size, ln, fn,       \
+                                "%s:%d: remote %s, node %d, %zu bytes, " \
+                                "commid %d",                             \
+                                chpl_lookupFilename(fn), ln, op,         \
+                                (int) node, size, (int) commid)
 
 #define chpl_comm_diags_verbose_rdmaStrd(op, node, ln, fn, commid)      \
-  chpl_comm_diags_verbose_printf(false,                                 \
-                                 "%s:%d: remote strided %s, node %d, "  \
-                                 "commid %d",                           \
-                                 chpl_lookupFilename(fn), ln, op,       \
-                                 (int) node, (int) commid)
+  chpl_comm_diags_verbose_event(false, "strided", op, node, 0, ln, fn,  \
+                                "%s:%d: remote strided %s, node %d, "   \
+                                "commid %d",                            \
+                                chpl_lookupFilename(fn), ln, op,        \
+                                (int) node, (int) commid)
 
 #define chpl_comm_diags_verbose_amo(op, node, ln, fn)                   \
-  chpl_comm_diags_verbose_printf(true,                                  \
-                                 "%s:%d: remote %s, node %d",           \
-                                 chpl_lookupFilename(fn), ln, op,       \
-                                 (int) node)
+  chpl_comm_diags_verbose_event(true, op, "", node, 0, ln, fn,          \
+                                "%s:%d: remote %s, node %d",            \
+                                chpl_lookupFilename(fn), ln, op,        \
+                                (int) node)
 
 #define chpl_comm_diags_verbose_executeOn(kind, node, ln, fn)           \
-  chpl_comm_diags_verbose_printf(false,                                 \
-                                 "%s:%d: remote %-*sexecuteOn, node %d", \
-                                 chpl_lookupFilename(fn), ln,           \
-                                 ((int) strlen(kind)                    \
-                                  + ((strlen(kind) == 0) ? 0 : 1)),     \
-                                 kind, (int) node)
+  chpl_comm_diags_verbose_event(false, kind, "executeOn", node, 0,      \
+                                ln, fn,                                 \
+                                "%s:%d: remote %-*sexecuteOn, node %d", \
+                                chpl_lookupFilename(fn), ln,            \
+                                ((int) strlen(kind)                     \
+                                 + ((strlen(kind) == 0) ? 0 : 1)),      \
+                                kind, (int) node)
 
 #define chpl_comm_diags_incr(_ctr)                                           \
   do {                                                                       \
@@ -188,6 +300,42 @@ int chpl_comm_diags_is_enabled(void) {
     }                                                                        \
   } while(0)
 
+#define chpl_comm_diags_add(_ctr, _n)                                        \
+  do {                                                                       \
+    if (chpl_comm_diagnostics && chpl_comm_diags_is_enabled()) {             \
+      atomic_uint_least64_t* ctrAddr = &chpl_comm_diags_counters._ctr;       \
+      (void) atomic_fetch_add_explicit_uint_least64_t(ctrAddr, (_n),         \
+                                                      memory_order_relaxed); \
+    }                                                                        \
+  } while(0)
+
+static inline
+int chpl_comm_diags_hist_bin(size_t size) {
+  if (size <= 1) {
+    return 0;
+  }
+  const int bin = 63 - __builtin_clzll((unsigned long long) size);
+  return (bin < CHPL_COMM_DIAGS_HIST_BINS)
+         ? bin
+         : CHPL_COMM_DIAGS_HIST_BINS - 1;
+}
+
+#define chpl_comm_diags_size(_hist, _node, _size)                            \
+  do {                                                                       \
+    if (chpl_comm_diagnostics && chpl_comm_diags_is_enabled()) {             \
+      const size_t _sz = (_size);                                            \
+      atomic_uint_least64_t* binAddr =                                       \
+        &chpl_comm_diags_hists._hist[chpl_comm_diags_hist_bin(_sz)];         \
+      (void) atomic_fetch_add_explicit_uint_least64_t(binAddr, 1,            \
+                                                      memory_order_relaxed); \
+      if (chpl_comm_diags_traffic != NULL) {                                 \
+        (void) atomic_fetch_add_explicit_uint_least64_t                      \
+                 (&chpl_comm_diags_traffic[(_node)], _sz,                    \
+                  memory_order_relaxed);                                     \
+      }                                                                      \
+    }                                                                        \
+  } while(0)
+
 #ifdef __cplusplus
 }
 #endif
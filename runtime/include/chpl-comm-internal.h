@@ -49,12 +49,19 @@ extern void** chpl_rt_priv_bcast_tab;
 extern int chpl_rt_priv_bcast_tab_len;
 extern size_t chpl_rt_priv_bcast_lens[];
 
+//
+// Node 0's gather buffer for the collectives; see chpl_comm_allgather().
+// This is in chpl-comm.c.
+//
+extern void* chpl_comm_coll_buf;
+
 #define CHPL_RT_PRV_BCAST_TAB_ENTRIES(MACRO) \
   MACRO(chpl_verbose_comm)                   \
   MACRO(chpl_comm_diagnostics)               \
   MACRO(chpl_comm_diags_print_unstable)      \
   MACRO(chpl_verbose_comm_stacktrace)        \
-  MACRO(chpl_verbose_mem)
+  MACRO(chpl_verbose_mem)                    \
+  MACRO(chpl_comm_coll_buf)
 
 #define _RT_PRV_BCAST_M(sym)  chpl_rt_prv_tab_ ## sym ## _idx,
 typedef enum {
@@ -68,6 +75,32 @@ typedef enum {
 //
 void chpl_comm_init_prv_bcast_tab(void);
 
+//
+// Support for tree-structured collectives.  These describe a k-ary
+// tree spanning all the nodes, rooted at 'root'.  Nodes are placed in
+// the tree by their distance from the root, so root 0 gives the usual
+// heap layout (children of n are k*n+1 .. k*n+k) and other roots get
+// the same shape.  These are in chpl-comm.c.
+//
+c_nodeid_t chpl_comm_tree_parent(c_nodeid_t node, c_nodeid_t root, int k);
+int chpl_comm_tree_num_children(c_nodeid_t node, c_nodeid_t root, int k);
+c_nodeid_t chpl_comm_tree_child(c_nodeid_t node, c_nodeid_t root, int k,
+                                int i);
+
+//
+// Prefaulting the registered heap, with CHPL_RT_COMM_PREFAULT_HEAP=true.
+// The start function splits the heap across the NUMA domains and
+// starts threads that touch each domain's pages from that domain, so
+// the kernel faults them in in parallel and places them locally.  The
+// comm layer can do other setup before calling the wait function,
+// which must happen before anything else uses the heap and before it
+// is registered.  The third function gives how long the touching took,
+// for the startup report.  These are in chpl-comm.c.
+//
+void chpl_comm_prefault_heap_start(void* start, size_t size);
+void chpl_comm_prefault_heap_wait(void);
+uint64_t chpl_comm_prefault_heap_ns(void);
+
 //
 // Broadcast one of our runtime-specific variables.
 //
@@ -114,6 +114,19 @@ DECL_CHPL_COMM_ATOMIC_CMPXCHG(uint64)
 DECL_CHPL_COMM_ATOMIC_CMPXCHG(real32)
 DECL_CHPL_COMM_ATOMIC_CMPXCHG(real64)
 
+//
+// 128-bit compare and exchange, for objects such as wide pointers that
+// have to be swapped as a unit.  This is the only 128-bit operation;
+// a read can be done as a compare and exchange of any value for
+// itself, which either succeeds or returns the current value.  The
+// comm layer does it on the network if the NIC can, and otherwise on
+// the target's CPU, so it is coherent only with other 128-bit compare
+// and exchanges on the same object.
+//
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+DECL_CHPL_COMM_ATOMIC_CMPXCHG(uint128)
+#endif
+
 //
 // Do a remote atomic binary operation, non-fetching or fetching.  In
 // either case, the operand is *operand on the local node and the target
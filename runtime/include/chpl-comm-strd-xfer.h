@@ -45,6 +45,40 @@
 extern "C" {
 #endif
 
+//
+// Compress retired (NULL) transactions out of the list, returning the
+// number left.
+//
+static inline
+size_t strd_nb_compress(chpl_comm_nb_handle_t* handles, size_t currHandles)
+{
+  size_t iOut, iIn;
+
+  for (iOut = iIn = 0; iIn < currHandles; ) {
+    if (handles[iIn] == NULL)
+      iIn++;
+    else
+      handles[iOut++] = handles[iIn++];
+  }
+
+  return iOut;
+}
+
+
+//
+// Wait for all of the transactions still in flight.  A wait only
+// promises that at least one more has completed, so keep at it.
+//
+static inline
+void strd_nb_wait_all(chpl_comm_nb_handle_t* handles, size_t currHandles)
+{
+  while (currHandles > 0) {
+    chpl_comm_wait_nb_some(handles, currHandles);
+    currHandles = strd_nb_compress(handles, currHandles);
+  }
+}
+
+
 //
 //
 // Common versions of the strided bulk transfer functions, for comm
@@ -82,19 +116,7 @@ void strd_nb_helper(chpl_comm_nb_handle_t (*xferFn)(void*, int32_t, void*,
       (yieldFn)();
     }
 
-    // compress retired transactions out of the list
-    {
-      size_t iOut, iIn;
-
-      for (iOut = iIn = 0; iIn < currHandles; ) {
-        if (handles[iIn] == NULL)
-          iIn++;
-        else
-          handles[iOut++] = handles[iIn++];
-      }
-
-      currHandles = iOut;
-    }
+    currHandles = strd_nb_compress(handles, currHandles);
   }
 
   handles[currHandles] = (*xferFn)(localAddr, remoteLocale, remoteAddr, cnt,
@@ -246,9 +268,7 @@ void put_strd_common(void* dstaddr_arg, size_t* dststrides, int32_t dstlocale,
     break;
   }
 
-  if (currHandles > 0) {
-    (void) chpl_comm_wait_nb_some(handles, currHandles);
-  }
+  strd_nb_wait_all(handles, currHandles);
 }
 
 
@@ -395,9 +415,7 @@ void get_strd_common(void* dstaddr_arg, size_t* dststrides, int32_t srclocale,
     break;
   }
 
-  if (currHandles > 0) {
-    (void) chpl_comm_wait_nb_some(handles, currHandles);
-  }
+  strd_nb_wait_all(handles, currHandles);
 }
 
 static inline
@@ -145,7 +145,9 @@ int chpl_comm_test_nb_complete(chpl_comm_nb_handle_t h);
 
 // Wait on handles created by chpl_comm_start_....  ignores completed handles.
 // Clears out completed handles so that calling chpl_comm_nb_handle_is_complete
-// on them returns nonzero.
+// on them returns nonzero.  Returns once at least one has completed (or none
+// were outstanding), so waiting for all of them requires a loop.  This may
+// call chpl_task_yield.
 void chpl_comm_wait_nb_some(chpl_comm_nb_handle_t* h, size_t nhandles);
 
 // Try handles created by chpl_comm_start_....  ignores completed handles.
@@ -262,6 +264,16 @@ void chpl_comm_rollcall(void);
 //   perhaps not performance-optimal, to first try to free it here, and
 //   only free it elsewhere if this function returns false.
 //
+// chpl_comm_regMemAdd()
+//   Tell the comm layer about memory that the memory layer got from
+//   somewhere other than the registered heap: pinned host memory when
+//   gpuDev is negative, or memory on GPU gpuDev otherwise.  The comm
+//   layer may register it, so that RMA can move data directly to or
+//   from it.  This is only an optimization and may do nothing.
+//
+// chpl_comm_regMemRemove()
+//   Undo chpl_comm_regMemAdd(), before the memory is freed.
+//
 #ifndef CHPL_COMM_IMPL_REG_MEM_HEAP_INFO
 #define CHPL_COMM_IMPL_REG_MEM_HEAP_INFO(start_p, size_p)   \
         do { *(start_p) = NULL ; *(size_p) = 0; } while (0)
@@ -331,6 +343,22 @@ chpl_bool chpl_comm_regMemFree(void* p, size_t size) {
   return CHPL_COMM_IMPL_REG_MEM_FREE(p, size);
 }
 
+#ifndef CHPL_COMM_IMPL_REG_MEM_ADD
+#define CHPL_COMM_IMPL_REG_MEM_ADD(p, size, gpuDev) return
+#endif
+static inline
+void chpl_comm_regMemAdd(void* p, size_t size, int gpuDev) {
+  CHPL_COMM_IMPL_REG_MEM_ADD(p, size, gpuDev);
+}
+
+#ifndef CHPL_COMM_IMPL_REG_MEM_REMOVE
+#define CHPL_COMM_IMPL_REG_MEM_REMOVE(p) return
+#endif
+static inline
+void chpl_comm_regMemRemove(void* p) {
+  CHPL_COMM_IMPL_REG_MEM_REMOVE(p);
+}
+
 //
 // These routines are used by the Chapel runtime to broadcast the
 // locations of module-level ("global") variables to all locales
@@ -352,7 +380,20 @@ chpl_bool chpl_comm_regMemFree(void* p, size_t size) {
 // 'broadcast' call.  Currently we do the latter in order to
 // reduce startup overhead.
 //
+// With packed wide pointers the generated code and the runtime have
+// to agree on the size of wide_ptr_t, so the runtime's function has a
+// different name in order to make a mismatch fail at link time instead
+// of overwriting globals.
+//
+#ifdef CHPL_WIDE_POINTER_PACKED
+void chpl_comm_register_global_var_packed(int i, wide_ptr_t* ptr_to_wide_ptr);
+static inline
+void chpl_comm_register_global_var(int i, wide_ptr_t* ptr_to_wide_ptr) {
+  chpl_comm_register_global_var_packed(i, ptr_to_wide_ptr);
+}
+#else
 void chpl_comm_register_global_var(int i, wide_ptr_t* ptr_to_wide_ptr);
+#endif
 void chpl_comm_broadcast_global_vars(int numGlobals);
 
 //
@@ -392,6 +433,59 @@ void chpl_comm_broadcast_private(int id, size_t size);
 //
 void chpl_comm_barrier(const char *msg);
 
+//
+// Collectives over all top-level locales.  Like chpl_comm_barrier(),
+// these must be called by exactly one task on every locale, in the
+// same order everywhere, and they block until every locale has
+// contributed.  They may be called from Chapel tasks once the comm
+// layer is fully initialized.
+//
+// chpl_comm_allgather() copies 'size' bytes from 'src' on each locale
+// into slot chpl_nodeID of 'dst' on every locale, so 'dst' must have
+// room for chpl_numNodes * size bytes.
+//
+// chpl_comm_allreduce() combines the 'count' elements of type 'type'
+// at 'src' across all locales using 'op', leaving the result in 'dst'
+// on every locale.  Elements are combined in locale order, so every
+// locale gets bitwise identical results even for floating point.  The
+// bitwise ops are only valid for the integral types.
+//
+typedef enum {
+  CHPL_COMM_COLL_INT32,
+  CHPL_COMM_COLL_INT64,
+  CHPL_COMM_COLL_UINT32,
+  CHPL_COMM_COLL_UINT64,
+  CHPL_COMM_COLL_REAL32,
+  CHPL_COMM_COLL_REAL64,
+} chpl_comm_coll_type_t;
+
+typedef enum {
+  CHPL_COMM_COLL_SUM,
+  CHPL_COMM_COLL_PROD,
+  CHPL_COMM_COLL_MIN,
+  CHPL_COMM_COLL_MAX,
+  CHPL_COMM_COLL_BAND,
+  CHPL_COMM_COLL_BOR,
+  CHPL_COMM_COLL_BXOR,
+} chpl_comm_coll_op_t;
+
+void chpl_comm_allgather(void* dst, const void* src, size_t size);
+void chpl_comm_allreduce(void* dst, const void* src, size_t count,
+                         chpl_comm_coll_type_t type,
+                         chpl_comm_coll_op_t op);
+
+//
+// Shape of the spanning tree the compiler uses to fan a
+// 'coforall loc in Locales do on loc' out from node 'root' (see
+// --coforall-on-tree).  Each node forks the body onto its children,
+// runs it locally, and waits for its subtree, so no one node does all
+// the remote forks or handles all the completions.  The children of
+// the calling node are numbered 0 .. num_children-1.  The degree of
+// the tree comes from CHPL_RT_COFORALL_ON_TREE_DEGREE.
+//
+int64_t chpl_comm_coforall_tree_num_children(int64_t root);
+int64_t chpl_comm_coforall_tree_child(int64_t root, int64_t i);
+
 //
 // Do exit processing that has to occur before the tasking layer is
 // shut down.  "The "all" parameter is true for normal, collective
@@ -77,6 +77,13 @@ size_t chpl_env_rt_get_size(const char* ev, size_t dflt) {
 void chpl_env_set(const char*, const char*, int);
 void chpl_env_set_uint(const char*, uint64_t, int);
 
+//
+// If CHPL_RT_ENV_FILE names a file of NAME=value entries, as written by
+// a launcher with CHPL_LAUNCHER_ENV_FILE set, sets any of those that
+// aren't already set in our environment.
+//
+void chpl_env_load_file(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -79,6 +79,20 @@ qioerr chpl_fs_symlink(const char* orig, const char* linkName);
 
 mode_t chpl_fs_umask(mode_t mask);
 
+// Walk the directory tree under root using nthreads threads (0 means one
+// per accessible core), calling fn once for every entry below root with
+// its path and its lstat() information.  Subdirectories are handed out
+// to the threads through a shared queue, entries are read in large
+// batches, and each one is stat-ed relative to its directory's fd.
+// Symbolic links are reported but not followed.  fn is called from
+// several threads at once, in no particular order, so it must be
+// thread-safe; if it returns nonzero the walk stops early.  Returns the
+// first error encountered, after which the walk also stops.
+typedef int (*chpl_fs_walk_fn_t)(const char* path, const struct stat* st,
+                                 void* arg);
+qioerr chpl_fs_walk_parallel(const char* root, int nthreads,
+                             chpl_fs_walk_fn_t fn, void* arg);
+
 qioerr chpl_fs_viewmode(int* ret, const char* name);
 
 #ifdef __cplusplus
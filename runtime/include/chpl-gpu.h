@@ -0,0 +1,81 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Runtime support for running code on GPUs under the gpu locale model.
+// Kernels are compiled ahead of time into a device image (PTX or a fat
+// binary) that the generated code hands to chpl_gpu_launch_kernel(), which
+// loads it on first use.  Device memory is not tracked by the Chapel
+// memory layer.
+//
+// Other locale models don't define HAS_GPU_LOCALE, and then there are no
+// devices and everything other than chpl_gpu_num_devices() is an error.
+//
+
+#ifndef _chpl_gpu_h_
+#define _chpl_gpu_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void chpl_gpu_init(void);
+
+// The number of GPUs on this node.
+int chpl_gpu_num_devices(void);
+
+void* chpl_gpu_mem_alloc(int dev, size_t size,
+                         int32_t lineno, int32_t filename);
+void chpl_gpu_mem_free(int dev, void* ptr, int32_t lineno, int32_t filename);
+
+// Managed memory on device 'dev', which the host can also access.  It is
+// freed with chpl_gpu_mem_free().
+void* chpl_gpu_mem_alloc_managed(int dev, size_t size,
+                                 int32_t lineno, int32_t filename);
+
+// Page-locked host memory that every device can DMA to and from.
+void* chpl_gpu_mem_alloc_host(size_t size, int32_t lineno, int32_t filename);
+void chpl_gpu_mem_free_host(void* ptr, int32_t lineno, int32_t filename);
+
+void chpl_gpu_copy_host_to_device(int dev, void* dst, const void* src,
+                                  size_t size,
+                                  int32_t lineno, int32_t filename);
+void chpl_gpu_copy_device_to_host(int dev, void* dst, const void* src,
+                                  size_t size,
+                                  int32_t lineno, int32_t filename);
+
+//
+// Run 'num_threads' threads of the kernel 'name' from the device image
+// 'image' on device 'dev', in blocks of 'block_size' threads, and wait for
+// it to finish.  'args' points at each of the 'nargs' kernel arguments.
+//
+void chpl_gpu_launch_kernel(int dev, const void* image, const char* name,
+                            int64_t num_threads, int block_size,
+                            int nargs, void** args,
+                            int32_t lineno, int32_t filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _chpl_gpu_h_
@@ -82,6 +82,7 @@ extern "C" {
   m(TASK_POOL_DESC,       "task pool descriptor",                     false), \
   m(TASK_ARG_AND_POOL_DESC, "task body argument and pool descriptor", false), \
   m(TASK_LIST_DESC,       "task list descriptor",                     false), \
+  m(TASK_ARENA,           "task arena chunk",                         false), \
   m(TASK_LAYER_UNSPEC,    "tasking layer unspecified data",           false), \
   m(THREAD_PRV_DATA,      "thread private data",                      false), \
   m(THREAD_LIST_DESC,     "thread list descriptor",                   false), \
@@ -91,6 +92,7 @@ extern "C" {
   m(GMP,                  "gmp data",                                 true ), \
   m(GETS_PUTS_STRIDES,    "put_strd/get_strd array of strides",       true ), \
   m(MLI_DATA,             "multilocale interop data",                 true ), \
+  m(GPU_LAYER_DATA,       "GPU layer data",                           false), \
   m(NUM,                  "*** this must be the last entry ***",      true )
 
 
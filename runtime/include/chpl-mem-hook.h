@@ -91,6 +91,8 @@ void chpl_memhook_malloc_post(void* memAlloc,
     chpl_memhook_check_post(memAlloc, description, lineno, filename);
   if (CHPL_MEMHOOKS_ACTIVE)
     chpl_track_malloc(memAlloc, number, size, description, lineno, filename);
+  chpl_mem_sample_malloc(memAlloc, number * size, description,
+                         lineno, filename);
 }
 
 
@@ -102,6 +104,7 @@ void chpl_memhook_free_pre(void* memAlloc,
     chpl_memhook_check_pre(0, 0, 0, lineno, filename);
     chpl_track_free(memAlloc, lineno, filename);
   }
+  chpl_mem_sample_free(memAlloc);
 }
 
 
@@ -113,6 +116,9 @@ void chpl_memhook_realloc_pre(void* memAlloc, size_t size,
     chpl_memhook_check_pre(1, size, description, lineno, filename);
     chpl_track_realloc_pre(memAlloc, size, description, lineno, filename);
   }
+  // A failed realloc is fatal, so we can forget the old one now.  Doing
+  // it after could lose a race with a new allocation at the same address.
+  chpl_mem_sample_free(memAlloc);
 }
 
 
@@ -126,6 +132,7 @@ void chpl_memhook_realloc_post(void* moreMemAlloc, void* memAlloc,
   if (CHPL_MEMHOOKS_ACTIVE)
     chpl_track_realloc_post(moreMemAlloc, memAlloc, size, description,
                        lineno, filename);
+  chpl_mem_sample_malloc(moreMemAlloc, size, description, lineno, filename);
 }
 
 #ifdef __cplusplus
@@ -74,6 +74,37 @@ void chpl_mem_exit(void);
 
 int chpl_mem_inited(void);
 
+//
+// Zero (zero==true) or just first-touch (zero==false) a block of memory
+// using a set of threads spread over the NUMA domains, each handling a
+// page-aligned chunk.  The chunks go to the domains in order, the same
+// as with chpl_topo_setMemSubchunkLocality().  First-touching stores to
+// one byte per page, so it is only for memory whose contents don't
+// matter yet.
+//
+void chpl_mem_touchParallel(void* p, size_t size, chpl_bool zero);
+
+// Zeroed allocations at least this big use chpl_mem_touchParallel()
+// (CHPL_RT_MEM_PARALLEL_ZERO_MIN; 0 means never).
+extern size_t chpl_mem_parallelZeroMin;
+
+//
+// With CHPL_RT_MEM_NUMA_CHECK set, memory that has been placed on a
+// particular NUMA domain can be checked to see where it really landed.
+// The totals are reported when the program exits.  This samples the
+// pages, and skips the check entirely when it's off.
+//
+extern chpl_bool chpl_mem_numaCheck;
+
+void chpl_mem_checkNumaPlacementImpl(void* p, size_t size,
+                                     c_sublocid_t subloc);
+
+static inline
+void chpl_mem_checkNumaPlacement(void* p, size_t size, c_sublocid_t subloc) {
+  if (chpl_mem_numaCheck && isActualSublocID(subloc))
+    chpl_mem_checkNumaPlacementImpl(p, size, subloc);
+}
+
 
 static inline
 void* chpl_mem_allocMany(size_t number, size_t size,
@@ -99,7 +130,14 @@ void* chpl_mem_allocManyZero(size_t number, size_t size,
                              int32_t lineno, int32_t filename) {
   void* memAlloc;
   chpl_memhook_malloc_pre(number, size, description, lineno, filename);
-  memAlloc = chpl_calloc(number, size);
+  if (chpl_mem_parallelZeroMin > 0
+      && number > 0 && size <= SIZE_MAX / number
+      && number * size >= chpl_mem_parallelZeroMin) {
+    if ((memAlloc = chpl_malloc(number * size)) != NULL)
+      chpl_mem_touchParallel(memAlloc, number * size, true);
+  } else {
+    memAlloc = chpl_calloc(number, size);
+  }
   chpl_memhook_malloc_post(memAlloc, number, size, description,
                            lineno, filename);
   return memAlloc;
@@ -152,6 +190,30 @@ void chpl_mem_free(void* memAlloc, int32_t lineno, int32_t filename) {
   chpl_free(memAlloc);
 }
 
+//
+// Memory for moving data to and from devices and the network.
+//
+// chpl_mem_allocPinned() returns page-locked host memory, which GPUs can
+// DMA to and from directly.  Without GPUs it is ordinary page-aligned
+// memory.  Either way the comm layer is told about it, so it can register
+// it for RMA.  It must be freed with chpl_mem_freePinned().
+//
+// chpl_mem_allocSubloc() returns memory on sublocale 'subloc'.  With the
+// gpu locale model and a GPU sublocale, that is managed memory on the
+// GPU, or plain device memory if CHPL_RT_MEM_GPU_MANAGED is false.
+// Otherwise it is the same as chpl_mem_alloc().  It must be freed with
+// chpl_mem_freeSubloc(), passing the same sublocale.
+//
+void* chpl_mem_allocPinned(size_t size, chpl_mem_descInt_t description,
+                           int32_t lineno, int32_t filename);
+void chpl_mem_freePinned(void* memAlloc, int32_t lineno, int32_t filename);
+
+void* chpl_mem_allocSubloc(size_t size, c_sublocid_t subloc,
+                           chpl_mem_descInt_t description,
+                           int32_t lineno, int32_t filename);
+void chpl_mem_freeSubloc(void* memAlloc, c_sublocid_t subloc,
+                         int32_t lineno, int32_t filename);
+
 // Provide handles to instrument Chapel calls to memcpy and memmove
 static inline
 void* chpl_memcpy(void* dest, const void* src, size_t num)
@@ -176,6 +238,26 @@ static inline size_t chpl_mem_good_alloc_size(size_t minSize, int32_t lineno, in
   return chpl_good_alloc_size(minSize);
 }
 
+// Try to grow the allocation at memAlloc to at least size bytes without
+// moving it.  If that works it returns true and the bytes past the old
+// size are uninitialized.  Otherwise it returns false and leaves the
+// allocation alone, and the caller can fall back to allocating anew.
+// This is for callers that would otherwise allocate and copy themselves,
+// such as growing arrays whose elements have to be moved one by one;
+// chpl_mem_realloc() already extends in place when it can.
+static inline
+chpl_bool chpl_mem_try_expand(void* memAlloc, size_t size,
+                              chpl_mem_descInt_t description,
+                              int32_t lineno, int32_t filename) {
+  if (memAlloc == NULL || size == 0 || !chpl_try_expand(memAlloc, size)) {
+    return false;
+  }
+  chpl_memhook_realloc_pre(memAlloc, size, description, lineno, filename);
+  chpl_memhook_realloc_post(memAlloc, memAlloc, size, description,
+                            lineno, filename);
+  return true;
+}
+
 // free a c_string, no error checking.
 // The argument type is explicitly c_string, since only an "owned" string
 // should be freed.
@@ -22,6 +22,7 @@
 #define _chpl_privatization_h_
 #ifndef LAUNCHER
 #include <stdint.h>
+#include "chpl-bitops.h"
 #include "chpltypes.h"
 
 #ifdef __cplusplus
@@ -36,13 +37,36 @@ typedef struct chpl_privateObject_s {
   void* obj;
 } chpl_privateObject_t;
 
-// This is a dynamically-allocated array of chpl_privateObject_t.
-extern chpl_privateObject_t* chpl_privateObjects;
+//
+// The privatized objects live in a two-level table: a fixed directory of
+// segments, where segment k holds 2^(k + CHPL_PRIVATIZATION_LOG2_SEG0)
+// entries.  Segments are allocated as needed and never move or go away,
+// so lookups need no lock even while the table is growing.
+//
+#define CHPL_PRIVATIZATION_LOG2_SEG0 6
+#define CHPL_PRIVATIZATION_NUM_SEGS (64 - CHPL_PRIVATIZATION_LOG2_SEG0)
 
-// Compiler generates accesses like chpl_privateObjects[i];
-// see chpl_getPrivatizedCopy.
-// This allows TBAA information for chpl_privateObjects to be used.
-// At the very least, inlining it would be important for performance.
+extern chpl_privateObject_t*
+       chpl_privateObjectSegs[CHPL_PRIVATIZATION_NUM_SEGS];
+
+// Find the segment and offset within it for a given pid.
+static inline
+int chpl_privatization_seg(int64_t pid, int64_t* off) {
+  const uint64_t idx = (uint64_t) pid
+                       + ((uint64_t) 1 << CHPL_PRIVATIZATION_LOG2_SEG0);
+  const int msb = 63 - (int) chpl_bitops_clz_64(idx);
+  *off = (int64_t) (idx - ((uint64_t) 1 << msb));
+  return msb - CHPL_PRIVATIZATION_LOG2_SEG0;
+}
+
+// The generated code gets privatized objects through this; see
+// chpl_getPrivatizedCopy.  Inlining it is important for performance.
+static inline
+void* chpl_getPrivatizedClass(int64_t pid) {
+  int64_t off;
+  const int seg = chpl_privatization_seg(pid, &off);
+  return chpl_privateObjectSegs[seg][off].obj;
+}
 
 void chpl_clearPrivatizedClass(int64_t);
 
@@ -38,7 +38,13 @@ struct chpl_chpl____wide_chpl_string_s;
 
 chpl_string chpl_wide_string_copy(struct chpl_chpl____wide_chpl_string_s* x, int32_t lineno, int32_t filename);
 
-#define CHPL_SHORT_STRING_SIZE 8
+//
+// Strings' remote-copy code GETs buffers of at most this many bytes
+// into a chpl__inPlaceBuffer on the stack instead of a new heap buffer.
+// 16 covers a 15-byte string and its trailing NUL, which takes in most
+// map keys and identifiers, at the cost of 8 more bytes of stack.
+//
+#define CHPL_SHORT_STRING_SIZE 16
 
 typedef struct chpl__inPlaceBuffer_t {
   uint8_t data[CHPL_SHORT_STRING_SIZE];
@@ -41,8 +41,22 @@ extern "C" {
 // is not an expectation that it will be retained when the Chapel task
 // hosted by a runtime task moves to another node due to an on-stmt.
 //
+//
+// Per-task bump arena, for runtime allocations that live no longer than
+// the task that makes them.  See chpl_task_arenaAlloc() below.
+//
+typedef struct chpl_task_arenaChunk chpl_task_arenaChunk_t;
+
+typedef struct {
+  chpl_task_arenaChunk_t* chunks;       // all chunks, current one first
+  char* next;                           // next free byte in current chunk
+  char* end;                            // end of current chunk
+} chpl_task_arena_t;
+
 typedef struct {
   chpl_comm_taskPrvData_t comm_data;
+  chpl_task_arena_t arena;
+  void** locals;                        // task-local values, by key
 } chpl_task_infoRuntime_t;
 
 //
@@ -311,6 +325,19 @@ void chpl_task_yield(void);
 //
 void chpl_task_sleep(double);
 
+//
+// Wait until a file descriptor is ready for reading and/or writing.
+// The tasking layer should let other tasks use the thread while this
+// one waits, if it can.  The timeout is in microseconds; a negative
+// timeout means wait forever.  Returns 0 if the fd is ready (or has
+// an error or hangup pending, which the next I/O call will report),
+// ETIMEDOUT if the timeout expired, or an errno value.
+//
+#define CHPL_TASK_FD_READ  0x1
+#define CHPL_TASK_FD_WRITE 0x2
+
+int chpl_task_waitForFd(int fd, int events, int64_t timeout_usec);
+
 //
 // Get the current task's runtime-related per-task information.
 //
@@ -429,6 +456,13 @@ uint32_t chpl_task_getNumThreads(void);
 //
 uint32_t chpl_task_getNumIdleThreads(void);
 
+//
+// returns, in seconds, how long this locale's threads have spent
+// spinning and parked while waiting for tasks to run, summed over the
+// threads.  Tasking layers that don't track this return 0 for both.
+//
+void chpl_task_getIdleTimes(double* spinSecs, double* parkSecs);
+
 
 //
 // This gets any per-locale thread count specified in the environment.
@@ -452,6 +486,64 @@ size_t chpl_task_getEnvCallStackSize(void);
 //
 size_t chpl_task_getDefaultCallStackSize(void);
 
+//
+// This waits for fd readiness by polling and yielding.  It is a
+// fallback chpl_task_waitForFd() for tasking implementations that
+// don't have anything better, and is implemented in
+// runtime/src/chpl-tasks.c.
+//
+int chpl_task_waitForFdYielding(int fd, int events, int64_t timeout_usec);
+
+//
+// Allocate from the current task's arena.  The memory must not be freed
+// individually; it all goes away in bulk when the task ends, so this is
+// only for things that can't outlive the task, such as task-private
+// buffers.  Returns NULL if there is no current task.  This and the
+// release function are common to all tasking implementations and are
+// implemented in runtime/src/chpl-tasks.c.  The tasking layer calls
+// chpl_task_arenaRelease() on a task's infoRuntime when the task ends.
+//
+void* chpl_task_arenaAlloc(size_t size, int32_t lineno, int32_t filename);
+void chpl_task_arenaRelease(chpl_task_infoRuntime_t*);
+
+//
+// Task-local storage, for per-task caches such as aggregation buffers,
+// scratch space or RNG state.  A key names a pointer-sized value that
+// each task on this locale has its own copy of, NULL until it is set.
+// If the key has a constructor, the first chpl_task_localGet() in a
+// task that hasn't set the value calls it to create the value; if it
+// has a destructor, that is called on each non-NULL value when its
+// task ends, from chpl_task_arenaRelease().  Keys are per locale and
+// can't be deleted; chpl_task_localKeyCreate() returns -1 once there
+// are CHPL_TASK_LOCAL_MAX_KEYS of them.  Like tasks' runtime info,
+// values stay with runtime tasks, so a Chapel task sees a different
+// set across an on-stmt.  This is common to all tasking
+// implementations and is implemented in runtime/src/chpl-tasks.c,
+// apart from chpl_task_localGet(), which is inline below.  The tasking
+// layer calls chpl_task_localsInit() from chpl_task_init().
+//
+#define CHPL_TASK_LOCAL_MAX_KEYS 64
+
+typedef int chpl_task_localKey_t;
+typedef void* (*chpl_task_localCtor_t)(void);
+typedef void (*chpl_task_localDtor_t)(void*);
+
+void chpl_task_localsInit(void);
+chpl_task_localKey_t chpl_task_localKeyCreate(chpl_task_localCtor_t,
+                                              chpl_task_localDtor_t);
+void chpl_task_localSet(chpl_task_localKey_t, void*);
+void* chpl_task_localGetSlow(chpl_task_localKey_t);
+
+static inline
+void* chpl_task_localGet(chpl_task_localKey_t key) {
+  chpl_task_infoRuntime_t* infoRuntime = chpl_task_getInfoRuntime();
+
+  if (infoRuntime != NULL && infoRuntime->locals != NULL
+      && infoRuntime->locals[key] != NULL)
+    return infoRuntime->locals[key];
+  return chpl_task_localGetSlow(key);
+}
+
 //
 // These are service functions provided to the runtime by the module
 // code.
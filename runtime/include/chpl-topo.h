@@ -44,6 +44,13 @@ void chpl_topo_exit(void);
 //
 void* chpl_topo_getHwlocTopology(void);
 
+//
+// bind the calling thread to the CPUs reserved for comm layer progress
+// threads (see CHPL_RT_RESERVE_COMM_CORES); returns false, leaving the
+// thread unbound, if there aren't any
+//
+chpl_bool chpl_topo_bindToReservedCPUs(void);
+
 //
 // How many CPUs are there?
 //
@@ -55,6 +62,17 @@ int chpl_topo_getNumCPUsLogical(chpl_bool /*accessible_only*/);
 //
 int chpl_topo_getNumNumaDomains(void);
 
+//
+// Data cache information, for choosing block sizes and the like.  These
+// describe the data (or unified) caches above the first accessible CPU,
+// by level (1 for L1, and so on), and return 0 if there is no such cache
+// or it can't be determined.
+//
+int chpl_topo_getNumCacheLevels(void);
+uint64_t chpl_topo_getCacheSize(int /*level*/);
+int chpl_topo_getCacheLineSize(int /*level*/);
+int chpl_topo_getCacheNumSharingCPUs(int /*level*/);  // logical CPUs
+
 //
 // set the sublocale where the current thread is running
 //
@@ -65,6 +83,12 @@ void chpl_topo_setThreadLocality(c_sublocid_t);
 //
 c_sublocid_t chpl_topo_getThreadLocality(void);
 
+//
+// get the sublocale the current thread is bound to, or c_sublocid_any
+// if its CPU binding isn't confined to a single NUMA domain
+//
+c_sublocid_t chpl_topo_getThreadBoundLocality(void);
+
 //
 // set the locality of a block of memory, to a specific NUMA domain
 //
@@ -110,6 +134,22 @@ void chpl_topo_touchMemFromSubloc(void*, size_t, chpl_bool, c_sublocid_t);
 //
 c_sublocid_t chpl_topo_getMemLocality(void*);
 
+//
+// check where the pages of a block of memory actually are, for
+// diagnostics: up to 256 of the pages strictly within the block are
+// sampled, evenly spread, and those not yet backed by memory are
+// skipped
+//
+// args:
+//   base address
+//   size (bytes)
+//   expected sublocale (NUMA domain)
+//   address of result: number of pages checked
+//   address of result: how many of those were on some other domain
+//
+void chpl_topo_checkMemLocality(void*, size_t, c_sublocid_t,
+                                size_t*, size_t*);
+
 
 #ifdef __cplusplus
 } // end extern "C"
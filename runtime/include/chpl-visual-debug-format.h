@@ -0,0 +1,296 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Visual Debug event records, shared by the runtime and tools/chplvis.
+// This only relies on the C library so chplvis can include it.
+//
+// With CHPL_RT_VDEBUG_BINARY set, a data file has the usual text lines
+// up to the file and function tables, then a line "Binary: 1", then
+// binary records.  Every number in a record is a varint (7 bits per
+// byte, low bits first), so the format has no byte order:
+//
+//   kind nfields seq sec usec field[nfields] slen string[slen]
+//
+// The fields are zigzag encoded and are those of the matching text
+// record.  seq numbers the events of a node in the order they were
+// logged; records are buffered per thread, so the file isn't in seq
+// order and readers need to sort on it.
+//
+
+#ifndef _chpl_visual_debug_format_h_
+#define _chpl_visual_debug_format_h_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define CHPL_VDEBUG_BINARY_LINE "Binary: 1\n"
+
+typedef enum {
+  chpl_vdebug_rec_nb_put = 1,
+  chpl_vdebug_rec_nb_get,
+  chpl_vdebug_rec_put,
+  chpl_vdebug_rec_get,
+  chpl_vdebug_rec_st_put,
+  chpl_vdebug_rec_st_get,
+  chpl_vdebug_rec_fork,
+  chpl_vdebug_rec_fork_nb,
+  chpl_vdebug_rec_f_fork,
+  chpl_vdebug_rec_task,
+  chpl_vdebug_rec_Btask,
+  chpl_vdebug_rec_Etask,
+  chpl_vdebug_rec_VdbMark,
+  chpl_vdebug_rec_tname,
+  chpl_vdebug_rec_Tag,
+  chpl_vdebug_rec_Pause,
+  chpl_vdebug_rec_End
+} chpl_vdebug_rec_kind_t;
+
+#define CHPL_VDEBUG_REC_MAX_FIELDS 10
+
+// Upper bound on an encoded record, not counting its string.
+#define CHPL_VDEBUG_REC_MAX_BYTES (2 + 10 * (CHPL_VDEBUG_REC_MAX_FIELDS + 5))
+
+typedef struct {
+  int kind;
+  int nfields;
+  uint64_t seq;
+  int64_t sec;
+  int64_t usec;
+  int64_t f[CHPL_VDEBUG_REC_MAX_FIELDS];
+} chpl_vdebug_rec_t;
+
+static inline
+void chpl_vdebug_rec_add(chpl_vdebug_rec_t* r, int64_t v) {
+  if (r->nfields < CHPL_VDEBUG_REC_MAX_FIELDS)
+    r->f[r->nfields++] = v;
+}
+
+static inline
+unsigned char* chpl_vdebug_put_varint(unsigned char* p, uint64_t v) {
+  while (v >= 0x80) {
+    *p++ = (unsigned char) (v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (unsigned char) v;
+  return p;
+}
+
+static inline
+int chpl_vdebug_get_varint(FILE* fp, uint64_t* v) {
+  uint64_t x = 0;
+  int shift = 0;
+  int c;
+  do {
+    if (shift > 63 || (c = getc(fp)) == EOF)
+      return 0;
+    x |= (uint64_t) (c & 0x7f) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  *v = x;
+  return 1;
+}
+
+static inline
+uint64_t chpl_vdebug_zigzag(int64_t v) {
+  return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static inline
+int64_t chpl_vdebug_unzigzag(uint64_t v) {
+  return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+// Encodes r and slen bytes of str into out, which must have room for
+// CHPL_VDEBUG_REC_MAX_BYTES + slen bytes.  Returns the encoded length.
+static inline
+size_t chpl_vdebug_rec_encode(const chpl_vdebug_rec_t* r,
+                              const char* str, size_t slen,
+                              unsigned char* out) {
+  unsigned char* p = out;
+  int i;
+
+  *p++ = (unsigned char) r->kind;
+  p = chpl_vdebug_put_varint(p, r->nfields);
+  p = chpl_vdebug_put_varint(p, r->seq);
+  p = chpl_vdebug_put_varint(p, chpl_vdebug_zigzag(r->sec));
+  p = chpl_vdebug_put_varint(p, chpl_vdebug_zigzag(r->usec));
+  for (i = 0; i < r->nfields; i++)
+    p = chpl_vdebug_put_varint(p, chpl_vdebug_zigzag(r->f[i]));
+  p = chpl_vdebug_put_varint(p, slen);
+  for (i = 0; i < (int) slen; i++)
+    *p++ = (unsigned char) str[i];
+
+  return p - out;
+}
+
+// Reads the next record from fp; its string (truncated to fit) goes to
+// str.  Returns 1 for a record, 0 at the end of the file and -1 if the
+// data is bad.
+static inline
+int chpl_vdebug_rec_read(FILE* fp, chpl_vdebug_rec_t* r,
+                         char* str, size_t strsize) {
+  uint64_t v;
+  uint64_t slen;
+  uint64_t i;
+  int c;
+
+  if ((c = getc(fp)) == EOF)
+    return 0;
+  r->kind = c;
+
+  if (!chpl_vdebug_get_varint(fp, &v) || v > CHPL_VDEBUG_REC_MAX_FIELDS)
+    return -1;
+  r->nfields = (int) v;
+  if (!chpl_vdebug_get_varint(fp, &r->seq))
+    return -1;
+  if (!chpl_vdebug_get_varint(fp, &v))
+    return -1;
+  r->sec = chpl_vdebug_unzigzag(v);
+  if (!chpl_vdebug_get_varint(fp, &v))
+    return -1;
+  r->usec = chpl_vdebug_unzigzag(v);
+  for (i = 0; i < (uint64_t) r->nfields; i++) {
+    if (!chpl_vdebug_get_varint(fp, &v))
+      return -1;
+    r->f[i] = chpl_vdebug_unzigzag(v);
+  }
+
+  if (!chpl_vdebug_get_varint(fp, &slen))
+    return -1;
+  for (i = 0; i < slen; i++) {
+    if ((c = getc(fp)) == EOF)
+      return -1;
+    if (i + 1 < strsize)
+      str[i] = (char) c;
+  }
+  if (strsize > 0)
+    str[slen < strsize ? slen : strsize - 1] = 0;
+
+  return 1;
+}
+
+// Formats r as the equivalent text record.  Returns what snprintf does,
+// or -1 if r isn't a record this knows about.
+static inline
+int chpl_vdebug_rec_format(const chpl_vdebug_rec_t* r, const char* str,
+                           char* buf, size_t size) {
+  const int64_t* f = r->f;
+  long long sec = (long long) r->sec;
+  long long usec = (long long) r->usec;
+  const char* name = NULL;
+
+  switch (r->kind) {
+    case chpl_vdebug_rec_nb_put:  name = "nb_put";  break;
+    case chpl_vdebug_rec_nb_get:  name = "nb_get";  break;
+    case chpl_vdebug_rec_put:     name = "put";     break;
+    case chpl_vdebug_rec_get:     name = "get";     break;
+    case chpl_vdebug_rec_st_put:  name = "st_put";  break;
+    case chpl_vdebug_rec_st_get:  name = "st_get";  break;
+    case chpl_vdebug_rec_fork:    name = "fork";    break;
+    case chpl_vdebug_rec_fork_nb: name = "fork_nb"; break;
+    case chpl_vdebug_rec_f_fork:  name = "f_fork";  break;
+    case chpl_vdebug_rec_Btask:   name = "Btask";   break;
+    case chpl_vdebug_rec_Etask:   name = "Etask";   break;
+    case chpl_vdebug_rec_Tag:     name = "Tag";     break;
+    case chpl_vdebug_rec_Pause:   name = "Pause";   break;
+  }
+
+  switch (r->kind) {
+    // kind: tv srcNodeID dstNodeID commTaskID addr raddr elemSize length
+    //       commID lineNumber fileno
+    case chpl_vdebug_rec_nb_put:
+    case chpl_vdebug_rec_nb_get:
+    case chpl_vdebug_rec_put:
+    case chpl_vdebug_rec_get:
+    case chpl_vdebug_rec_st_put:
+    case chpl_vdebug_rec_st_get:
+      if (r->nfields < 10) return -1;
+      return snprintf(buf, size,
+                      "%s: %lld.%06lld %d %d %llu %#llx %#llx %lld %lld %d %d %d\n",
+                      name, sec, usec, (int) f[0], (int) f[1],
+                      (unsigned long long) f[2], (unsigned long long) f[3],
+                      (unsigned long long) f[4], (long long) f[5],
+                      (long long) f[6], (int) f[7], (int) f[8], (int) f[9]);
+
+    // kind: tv nodeId forkNodeId subLoc funcId arg argSize forkTaskId
+    //       lineNumber fileno
+    case chpl_vdebug_rec_fork:
+    case chpl_vdebug_rec_fork_nb:
+    case chpl_vdebug_rec_f_fork:
+      if (r->nfields < 9) return -1;
+      return snprintf(buf, size,
+                      "%s: %lld.%06lld %d %d %d %d %#llx %lld %llu %d %d\n",
+                      name, sec, usec, (int) f[0], (int) f[1], (int) f[2],
+                      (int) f[3], (unsigned long long) f[4], (long long) f[5],
+                      (unsigned long long) f[6], (int) f[7], (int) f[8]);
+
+    // task: tv nodeId taskId parentTaskId On/Local lineNum fileno fid
+    case chpl_vdebug_rec_task:
+      if (r->nfields < 7) return -1;
+      return snprintf(buf, size,
+                      "task: %lld.%06lld %lld %llu %llu %s %lld %d %d\n",
+                      sec, usec, (long long) f[0], (unsigned long long) f[1],
+                      (unsigned long long) f[2], f[3] ? "O" : "L",
+                      (long long) f[4], (int) f[5], (int) f[6]);
+
+    // Btask/Etask: tv nodeId taskId
+    case chpl_vdebug_rec_Btask:
+    case chpl_vdebug_rec_Etask:
+      if (r->nfields < 2) return -1;
+      return snprintf(buf, size, "%s: %lld.%06lld %lld %llu\n",
+                      name, sec, usec, (long long) f[0],
+                      (unsigned long long) f[1]);
+
+    // VdbMark: tv nodeId taskId
+    case chpl_vdebug_rec_VdbMark:
+      if (r->nfields < 2) return -1;
+      return snprintf(buf, size, "VdbMark: %lld.%06lld %d %llu\n",
+                      sec, usec, (int) f[0], (unsigned long long) f[1]);
+
+    // tname: tag# tagname
+    case chpl_vdebug_rec_tname:
+      if (r->nfields < 1) return -1;
+      return snprintf(buf, size, "tname: %d %s\n", (int) f[0], str);
+
+    // Tag/Pause: tv user.time sys.time nodeId taskId tag#
+    case chpl_vdebug_rec_Tag:
+    case chpl_vdebug_rec_Pause:
+      if (r->nfields < 7) return -1;
+      return snprintf(buf, size,
+                      "%s: %lld.%06lld %lld.%06lld %lld.%06lld %d %llu %d\n",
+                      name, sec, usec, (long long) f[0], (long long) f[1],
+                      (long long) f[2], (long long) f[3], (int) f[4],
+                      (unsigned long long) f[5], (int) f[6]);
+
+    // End: tv user.time sys.time nodeId taskId
+    case chpl_vdebug_rec_End:
+      if (r->nfields < 6) return -1;
+      return snprintf(buf, size,
+                      "End: %lld.%06lld %lld.%06lld %lld.%06lld %d %llu\n",
+                      sec, usec, (long long) f[0], (long long) f[1],
+                      (long long) f[2], (long long) f[3], (int) f[4],
+                      (unsigned long long) f[5]);
+  }
+
+  return -1;
+}
+
+#endif
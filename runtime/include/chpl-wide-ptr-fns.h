@@ -37,6 +37,89 @@ extern "C" {
 // a variety of wide pointer types with the structure representation,
 // since one can't cast a structure...
 
+#ifdef CHPL_WIDE_POINTER_PACKED
+
+// Packed wide pointers hold the node in the high bits of a 64-bit
+// pointer, above the CHPL_WIDE_POINTER_ADDR_BITS bits of address that
+// current 64-bit processors actually use.  There is no room for a
+// sublocale, so this only works with the flat locale model, and only
+// up to CHPL_WIDE_POINTER_MAX_NODES nodes.  The compiler's LLVM wide
+// pointer optimization builds and takes apart packed pointers inline;
+// it needs to agree with these definitions.
+
+#define CHPL_WIDE_POINTER_ADDR_BITS 48
+#define CHPL_WIDE_POINTER_NODE_BITS (64 - CHPL_WIDE_POINTER_ADDR_BITS)
+#define CHPL_WIDE_POINTER_MAX_NODES \
+        ((int64_t) 1 << CHPL_WIDE_POINTER_NODE_BITS)
+#define CHPL_WIDE_POINTER_ADDR_MASK \
+        (((uint64_t) 1 << CHPL_WIDE_POINTER_ADDR_BITS) - 1)
+
+static inline
+wide_ptr_t chpl_return_wide_ptr_node(c_nodeid_t node, void* addr)
+{
+  uint64_t bits = (uint64_t) (uintptr_t) addr;
+  if( (bits & ~CHPL_WIDE_POINTER_ADDR_MASK) != 0 )
+    chpl_internal_error("address too large for a packed wide pointer");
+  bits |= ((uint64_t) node) << CHPL_WIDE_POINTER_ADDR_BITS;
+  return (wide_ptr_t) (uintptr_t) bits;
+}
+
+static inline
+void chpl_check_wide_ptr(wide_ptr_t ptr)
+{
+}
+
+static inline
+wide_ptr_t chpl_return_wide_ptr_loc(chpl_localeID_t loc, void * addr)
+{
+  return chpl_return_wide_ptr_node(chpl_rt_nodeFromLocaleID(loc), addr);
+}
+
+static inline
+wide_ptr_t chpl_return_wide_ptr_loc_ptr(const chpl_localeID_t* loc, void * addr)
+{
+  return chpl_return_wide_ptr_loc(*loc, addr);
+}
+
+
+static inline
+c_nodeid_t chpl_wide_ptr_get_node(wide_ptr_t ptr)
+{
+  return (c_nodeid_t) (((uint64_t) (uintptr_t) ptr)
+                       >> CHPL_WIDE_POINTER_ADDR_BITS);
+}
+
+static inline
+void* chpl_wide_ptr_get_address(wide_ptr_t ptr)
+{
+  return (void*) (uintptr_t) (((uint64_t) (uintptr_t) ptr)
+                              & CHPL_WIDE_POINTER_ADDR_MASK);
+}
+
+static inline
+chpl_localeID_t chpl_wide_ptr_get_localeID(wide_ptr_t ptr)
+{
+  return chpl_rt_buildLocaleID(chpl_wide_ptr_get_node(ptr), c_sublocid_any);
+}
+
+static inline
+void chpl_wide_ptr_read_localeID(wide_ptr_t ptr,
+                                 chpl_localeID_t* loc)
+{
+  *loc = chpl_wide_ptr_get_localeID(ptr);
+}
+
+
+static inline
+wide_ptr_t chpl_return_wide_ptr_add(wide_ptr_t ptr, size_t amt)
+{
+  // The address is in the low bits, so this leaves the node alone
+  // as long as the result is still a valid address.
+  return (wide_ptr_t) (((unsigned char*)ptr) + amt);
+}
+
+#else
+
 static inline
 wide_ptr_t chpl_return_wide_ptr_node(c_nodeid_t node, void* addr)
 {
@@ -107,6 +190,8 @@ wide_ptr_t chpl_return_wide_ptr_add(wide_ptr_t ptr, size_t amt)
   return ptr;
 }
 
+#endif // CHPL_WIDE_POINTER_PACKED
+
 #ifdef __cplusplus
 }
 #endif
@@ -45,6 +45,7 @@ int chpl_launch_using_exec(const char* command, char * const argv1[],
 int chpl_launch_using_system(char* command, char* argv0);
 
 char* chpl_get_enviro_keys(char sep);
+const char* chpl_launcher_write_env_file(void);
 int chpl_get_charset_env_nargs(void);
 int chpl_get_charset_env_args(char *argv[]);
 
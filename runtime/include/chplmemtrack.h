@@ -56,6 +56,11 @@ void chpl_stopVerboseMem(void);
 void chpl_startVerboseMemHere(void);
 void chpl_stopVerboseMemHere(void);
 
+// Snapshot the totals printMemAllocStats() reports, without the
+// --memTrack check; they are all 0 if we aren't tracking.
+void chpl_memTrack_getTotals(size_t* allocNow, size_t* allocMax,
+                             size_t* allocSum, size_t* freeSum);
+
 
 ///// These entry points are the essential memory tracking interface, called
 //    at memory allocation and deallocation points.
@@ -71,6 +76,37 @@ void chpl_track_realloc_post(void* moreMemAlloc,
                          chpl_mem_descInt_t description,
                          int32_t lineno, int32_t filename);
 
+
+///// Sampling heap profiler (see chpl-mem-sample.c).  These are called
+//    at the same points as the tracking interface above, but are cheap
+//    enough to leave on in optimized builds.
+extern size_t chpl_mem_sample_interval;   // 0 means not sampling
+extern int chpl_mem_sample_nLive;         // # of live sampled allocations
+extern __thread int64_t chpl_mem_sample_countdown;
+
+void chpl_mem_sample_init(void);
+void chpl_mem_sample_exit(void);
+void chpl_mem_sample_dump(int seq);
+void chpl_mem_sample_record(void* memAlloc, size_t size,
+                            chpl_mem_descInt_t description,
+                            int32_t lineno, int32_t filename);
+void chpl_mem_sample_forget(void* memAlloc);
+
+static inline
+void chpl_mem_sample_malloc(void* memAlloc, size_t size,
+                            chpl_mem_descInt_t description,
+                            int32_t lineno, int32_t filename) {
+  if (chpl_mem_sample_interval != 0 && memAlloc != NULL
+      && (chpl_mem_sample_countdown -= (int64_t) size) < 0)
+    chpl_mem_sample_record(memAlloc, size, description, lineno, filename);
+}
+
+static inline
+void chpl_mem_sample_free(void* memAlloc) {
+  if (chpl_mem_sample_nLive != 0 && memAlloc != NULL)
+    chpl_mem_sample_forget(memAlloc);
+}
+
 #else // LAUNCHER
 
 #define chpl_setMemmax(value)
@@ -35,6 +35,13 @@ uint64_t chpl_sys_physicalMemoryBytes(void);
 int chpl_sys_getNumCPUsPhysical(chpl_bool accessible_only);
 int chpl_sys_getNumCPUsLogical(chpl_bool accessible_only);
 
+//
+// hugepage support for memory not provided by the comm layer
+//
+size_t chpl_sys_getHugePageSize(void);   // default hugetlb size; 0 if none
+int chpl_sys_adviseHugePages(void* p, size_t size);  // 0 on success
+uint64_t chpl_sys_anonHugePageBytes(void);  // THP-backed bytes, this proc
+
 //
 // returns the name of a locale via uname -n or the like
 //
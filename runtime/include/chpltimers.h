@@ -23,7 +23,9 @@
 
 #include "chpltypes.h"  // For _real64.
 
+#include <stdint.h>
 #include <sys/time.h>   // For struct timeval.
+#include <time.h>       // For clock_gettime().
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,6 +39,53 @@ int64_t chpl_timevalue_seconds(_timevalue t);
 int64_t chpl_timevalue_microseconds(_timevalue t);
 void chpl_timevalue_parts(_timevalue t, int32_t* seconds, int32_t* minutes, int32_t* hours, int32_t* mday, int32_t* month, int32_t* year, int32_t* wday, int32_t* yday, int32_t* isdst);
 
+//
+// Nanoseconds on the monotonic clock, for timing intervals.  The
+// starting point is arbitrary, so only differences mean anything.
+//
+static inline
+uint64_t chpl_now_monotonic_ns(void) {
+  struct timespec ts;
+  (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+//
+// A cycle counter that is much cheaper to read than the clock, for
+// timing very short things: the TSC on x86_64, the virtual counter
+// on aarch64, and the monotonic clock elsewhere.  It counts at a
+// constant rate of chpl_cycle_rate() ticks per second (on x86_64 this
+// assumes an invariant TSC, which all recent CPUs have).  As with the
+// monotonic clock, only differences between readings mean anything,
+// and only between readings on the same node.
+//
+static inline
+uint64_t chpl_cycle_count(void) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  uint32_t lo, hi;
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+  uint64_t v;
+  __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (v));
+  return v;
+#else
+  return chpl_now_monotonic_ns();
+#endif
+}
+
+//
+// Ticks per second of chpl_cycle_count().  On x86_64 this is measured
+// against the monotonic clock the first time it's called, which takes
+// about 10 milliseconds.
+//
+double chpl_cycle_rate(void);
+
+static inline
+double chpl_cycles_to_ns(uint64_t cycles) {
+  return cycles * (1e9 / chpl_cycle_rate());
+}
+
 #ifndef LAUNCHER
 
 _real64 chpl_now_time(void);
@@ -118,10 +118,15 @@ static inline int isActualSublocID(c_sublocid_t subloc) {
 // problems building the launcher).
 
 #include "chpl-locale-model.h"
+#ifdef CHPL_WIDE_POINTER_PACKED
+// The node is in the high bits; see chpl-wide-ptr-fns.h.
+typedef void* wide_ptr_t;
+#else
 typedef struct wide_ptr_s {
   chpl_localeID_t locale;
   void* addr;
 } wide_ptr_t;
+#endif
 typedef wide_ptr_t* ptr_wide_ptr_t;
 
 #else
@@ -37,6 +37,14 @@ void chpl_comm_impl_regMemHeapInfo(void** start_p, size_t* size_p);
         chpl_comm_impl_regMemHeapPageSize()
 size_t chpl_comm_impl_regMemHeapPageSize(void);
 
+#define CHPL_COMM_IMPL_REG_MEM_ADD(p, size, gpuDev) \
+        chpl_comm_impl_regMemAdd(p, size, gpuDev)
+void chpl_comm_impl_regMemAdd(void* p, size_t size, int gpuDev);
+
+#define CHPL_COMM_IMPL_REG_MEM_REMOVE(p) \
+        chpl_comm_impl_regMemRemove(p)
+void chpl_comm_impl_regMemRemove(void* p);
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,6 +33,10 @@
 #include "chpl-cache-task-decls.h"
 #define HAS_CHPL_CACHE_FNS
 
+// chpl_comm_put_unordered() buffers small PUTs and initiates them
+// together at chpl_comm_getput_unordered_task_fence().
+#define HAS_CHPL_COMM_BUFFERED_PUT_UNORDERED
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -41,11 +45,14 @@ typedef struct {
   chpl_bool taskIsEnding;       // task is ending? (anticipate _downEndCount())
   chpl_bool amDonePending;      // some delayed AM 'done' is expected?
   uint8_t amDone;               // delayed 'done' indicator
+  c_nodeid_t amDoneNode;        // node the delayed 'done' comes from
   void* putBitmap;              // PUT target nodes
   chpl_cache_taskPrvData_t cache_data;
   void* amo_nf_buff;
   void* get_buff;
   void* put_buff;
+  void* agg_put_buff;           // aggregated ordinary PUTs, if enabled
+  void* agg_amo_buff;           // aggregated ordinary AMOs, if enabled
 } chpl_comm_taskPrvData_t;
 
 //
@@ -30,6 +30,10 @@
 #include "chpl-cache-task-decls.h"
 #define HAS_CHPL_CACHE_FNS
 
+// chpl_comm_put_unordered() buffers small PUTs and initiates them
+// together at chpl_comm_getput_unordered_task_fence().
+#define HAS_CHPL_COMM_BUFFERED_PUT_UNORDERED
+
 #ifdef __cplusplus
 extern "C" {
 #endif
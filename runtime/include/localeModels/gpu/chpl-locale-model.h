@@ -24,6 +24,9 @@
 #include "sys_basic.h"
 #include "chpltypes.h"
 
+// The runtime's GPU layer (chpl-gpu.h) is only built for this locale model.
+#define HAS_GPU_LOCALE
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -71,6 +74,15 @@ c_sublocid_t chpl_rt_sublocFromLocaleID(chpl_localeID_t loc) {
   return loc.subloc;
 }
 
+//
+// Sublocale 0 is the CPU and sublocale d+1 is GPU d.  This returns the
+// GPU for a sublocale, or -1 if it isn't a GPU sublocale.
+//
+static inline
+int chpl_localeModel_sublocToGpuDevice(c_sublocid_t subloc) {
+  return (subloc >= 1) ? (int) subloc - 1 : -1;
+}
+
 //
 // These functions are exported from the locale model for use by
 // the tasking layer to convert between a full sublocale and an
@@ -63,6 +63,19 @@ static inline size_t chpl_good_alloc_size(size_t minSize) {
 #endif
 }
 
+// The system allocator can't be asked to grow a block in place, so the
+// best we can do is notice when it already has room.  (For big blocks
+// glibc's realloc() uses mremap(), so those don't get copied anyway.)
+static inline int chpl_try_expand(void* ptr, size_t size) {
+#if defined(__GLIBC__)
+  return malloc_usable_size(ptr) >= size;
+#elif defined(__APPLE__)
+  return malloc_size(ptr) >= size;
+#else
+  return 0;
+#endif
+}
+
 #define CHPL_USING_CSTDLIB_MALLOC 1
 
 #ifdef __cplusplus
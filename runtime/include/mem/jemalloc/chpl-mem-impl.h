@@ -42,6 +42,8 @@ extern "C" {
 #define CHPL_JE_RALLOCX CHPL_JE_(rallocx)
 #define CHPL_JE_DALLOCX CHPL_JE_(dallocx)
 #define CHPL_JE_NALLOCX CHPL_JE_(nallocx)
+#define CHPL_JE_XALLOCX CHPL_JE_(xallocx)
+#define CHPL_JE_SALLOCX CHPL_JE_(sallocx)
 #define CHPL_JE_MALLCTL CHPL_JE_(mallctl)
 
 
@@ -49,10 +51,18 @@ extern "C" {
 // Determine which arena to use. For large allocations (32 MiB) use a dedicated
 // arena to reduce fragmentation
 extern unsigned CHPL_JE_LG_ARENA;
+// When there are per-NUMA-domain arenas, each thread is pointed at one for
+// its domain the first time it allocates.
+extern int chpl_je_numa_arenas;
+extern __thread int chpl_je_thread_arena_chosen;
+void chpl_je_choose_thread_arena(void);
 static inline int CHPL_JE_MALLOCX_ARENA_FLAG(size_t size) {
   if (size >= ((size_t) 32 << 20)) {
     return MALLOCX_ARENA(CHPL_JE_LG_ARENA);
   }
+  if (chpl_je_numa_arenas && !chpl_je_thread_arena_chosen) {
+    chpl_je_choose_thread_arena();
+  }
   return MALLOCX_NO_FLAGS;
 }
 
@@ -107,6 +117,15 @@ static inline size_t chpl_good_alloc_size(size_t minSize) {
   return CHPL_JE_NALLOCX(minSize, MALLOCX_NO_FLAGS);
 }
 
+// Grow an allocation to at least size bytes without moving it, if
+// jemalloc can.  Never shrinks it.  Returns nonzero on success.
+static inline int chpl_try_expand(void* ptr, size_t size) {
+  if (CHPL_JE_SALLOCX(ptr, MALLOCX_NO_FLAGS) >= size) {
+    return 1;
+  }
+  return CHPL_JE_XALLOCX(ptr, size, 0, MALLOCX_NO_FLAGS) >= size;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,7 +36,6 @@
 #include <stdint.h>
 
 #include <sys/uio.h>
-#include "deque.h"
 
 typedef uint_least64_t qb_refcnt_base_t;
 #if defined(__cplusplus) && defined(QIO_USE_STD_ATOMICS_REF_CNT)
@@ -101,6 +100,8 @@ extern "C" {
 
 // how large is an iobuf?
 extern size_t qbytes_iobuf_size;
+// how many freed iobufs each thread keeps for reuse?
+extern size_t qbytes_iobuf_pool_max;
 
 struct qbytes_s;
 
@@ -163,6 +164,18 @@ void _qbytes_init_generic(qbytes_t* ret, void* give_data, int64_t len, qbytes_fr
 qioerr qbytes_create_generic(qbytes_t** out, void* give_data, int64_t len, qbytes_free_t free_function);
 qioerr _qbytes_init_iobuf(qbytes_t* ret);
 qioerr qbytes_create_iobuf(qbytes_t** out);
+
+// Counts for the per-thread pools of freed iobufs, summed over threads.
+typedef struct qbytes_iobuf_pool_stats_s {
+  uint64_t hits; // qbytes_create_iobuf reused a pooled iobuf
+  uint64_t misses; // ... or had to allocate one
+  uint64_t returned; // a freed iobuf went into a pool
+  uint64_t dropped; // ... or was freed because the pool was full
+} qbytes_iobuf_pool_stats_t;
+
+void qbytes_iobuf_pool_stats(qbytes_iobuf_pool_stats_t* stats);
+// Frees the iobufs pooled by the calling thread.
+void qbytes_iobuf_pool_drain(void);
 qioerr _qbytes_init_calloc(qbytes_t* ret, int64_t len);
 
 // The caller is responsible for calling qbytes_release on the return value.
@@ -209,9 +222,22 @@ typedef struct qbuffer_part_s {
  * A buffer should be wrapped as a record; the destructor
  * should be called when it goes out of scope.
  */
+/* The parts of a buffer are kept in a ring whose size is a power of 2.
+ * Parts are numbered consecutively (modulo 2^64) in buffer order and
+ * part number n is in ring[n & mask], so iterating is just counting.
+ * A part pushed on the front gets number head-1, one pushed on the
+ * back gets number tail, and the ring doubles in size when it's full.
+ */
+typedef struct qbuffer_parts_s {
+  qbuffer_part_t* ring;
+  uint64_t mask; // number of parts the ring can hold, minus 1
+  uint64_t head; // number of the first part
+  uint64_t tail; // number of the part after the last one
+} qbuffer_parts_t;
+
 typedef struct qbuffer_s {
   qbytes_refcnt_t ref_cnt; // atomically updated
-  deque_t deque; // contains qbuffer_part_t s 
+  qbuffer_parts_t parts; // contains qbuffer_part_t s
   int64_t offset_start;
   int64_t offset_end;
 } qbuffer_t;
@@ -220,17 +246,26 @@ typedef qbuffer_t _qbuffer_ptr_t;
 typedef qbuffer_t* qbuffer_ptr_t;
 #define QBUFFER_PTR_NULL NULL
 
+/* An iterator names a part by number, so it stays valid while
+ * parts are added at either end of the buffer.
+ */
 typedef struct qbuffer_iter_s {
   int64_t offset; // valid iter has offset_start <= offset <= offset_end
-  deque_iterator_t iter;
+  qbuffer_parts_t* parts; // parts of the buffer iterated over
+  uint64_t part; // number of the part containing offset, or parts->tail
 } qbuffer_iter_t;
 
 static inline
 qbuffer_iter_t qbuffer_iter_null(void) {
-  qbuffer_iter_t ret = {0, deque_iterator_null()};
+  qbuffer_iter_t ret = {0, NULL, 0};
   return ret;
 }
 
+static inline
+qbuffer_part_t* qbuffer_part_at(qbuffer_parts_t* parts, uint64_t part) {
+  return &parts->ring[part & parts->mask];
+}
+
 void debug_print_qbuffer_iter(qbuffer_iter_t* iter);
 void debug_print_qbuffer(qbuffer_t* buf);
 void debug_print_iovec(const struct iovec* iov, int iovcnt, size_t maxbytes);
@@ -238,11 +273,11 @@ void debug_print_iovec(const struct iovec* iov, int iovcnt, size_t maxbytes);
 
 static inline
 void qbuffer_init_uninitialized(qbuffer_t* buf) {
-  deque_init_uninitialized(&buf->deque);
+  buf->parts.ring = NULL;
 }
 static inline
 int qbuffer_is_initialized(qbuffer_t* buf) {
-  return deque_is_initialized(&buf->deque);
+  return buf->parts.ring != NULL;
 }
 
 /* Initialize a buffer */
@@ -306,14 +341,14 @@ qbuffer_iter_t qbuffer_end(qbuffer_t* buf);
 static inline
 ssize_t qbuffer_num_parts(qbuffer_t* buf)
 {
-  return deque_size(sizeof(qbuffer_part_t), & buf->deque);
+  return (ssize_t) (buf->parts.tail - buf->parts.head);
 }
 
 /* do a and b refer to the same part?
  */
 static inline
 char qbuffer_iter_same_part(qbuffer_iter_t a, qbuffer_iter_t b) {
-  return deque_it_equals(a.iter, b.iter);
+  return a.part == b.part;
 }
 
 /* Moves to the beginning of the next part
@@ -351,7 +386,7 @@ qbuffer_iter_t qbuffer_iter_at(qbuffer_t* buf, int64_t offset);
 static inline
 ssize_t qbuffer_iter_num_parts(qbuffer_iter_t start, qbuffer_iter_t end)
 {
-  return 1 + deque_it_difference(sizeof(qbuffer_part_t), end.iter, start.iter);
+  return 1 + (ssize_t) (end.part - start.part);
 }
 
 static inline
@@ -389,7 +424,7 @@ int64_t qbuffer_iter_num_bytes_before(qbuffer_t* buf, qbuffer_iter_t iter)
 static inline
 void qbuffer_iter_get(qbuffer_iter_t iter, qbuffer_iter_t end, qbytes_t** bytes_out, int64_t* skip_out, int64_t* len_out)
 {
-  qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter.iter);
+  qbuffer_part_t* qbp = qbuffer_part_at(iter.parts, iter.part);
   int64_t iter_offset_within = iter.offset - (qbp->end_offset - qbp->len_bytes);
   int64_t part_len = qbp->len_bytes - iter_offset_within;
   int64_t len = end.offset - iter.offset;
@@ -99,6 +99,7 @@ typedef struct {
   atomic_spinlock_t lock;
   chpl_taskID_t owner; // task ID of owner.
   uint64_t count; // how many times owner has locked.
+  chpl_bool bound; // owner keeps it locked; see qio_lock_bind
 } qio_lock_t;
 
 #define NULL_OWNER chpl_nullTaskID
@@ -106,14 +107,26 @@ typedef struct {
 qioerr qio_lock(qio_lock_t* x);
 void qio_unlock(qio_lock_t* x);
 
+// Binds the lock to the calling task, which must not already hold it.
+// Until qio_lock_unbind, lock and unlock by that task do nothing, and
+// no other task may use the lock (checked only in debug builds).
+qioerr qio_lock_bind(qio_lock_t* x);
+void qio_lock_unbind(qio_lock_t* x);
+
 static inline qioerr qio_lock_init(qio_lock_t* x) {
   x->owner = NULL_OWNER;
   x->count = 0;
+  x->bound = false;
   atomic_init_spinlock_t(&x->lock);
   return 0;
 }
 
 static inline void qio_lock_destroy(qio_lock_t* x) {
+  if( x->bound ) {
+    // the last reference can go away on any task
+    x->bound = false;
+    atomic_unlock_spinlock_t(&x->lock);
+  }
   atomic_destroy_spinlock_t(&x->lock);
 }
 
@@ -133,27 +146,65 @@ static inline void qio_lock_destroy(qio_lock_t* x) {
 extern "C" {
 #endif
 
-typedef pthread_mutex_t qio_lock_t;
+typedef struct {
+  pthread_mutex_t mutex;
+  int bound; // see qio_lock_bind
+  pthread_t owner; // when bound
+} qio_lock_t;
+
 // these should return 0 on success; otherwise, an error number.
 static inline qioerr qio_lock(qio_lock_t* x) {
-  return qio_int_to_err(pthread_mutex_lock(x));
+  if( x->bound ) {
+    assert( pthread_equal(x->owner, pthread_self()) );
+    return 0;
+  }
+  return qio_int_to_err(pthread_mutex_lock(&x->mutex));
 }
 
 // qio_unlock does not return an error because it can only usefully
 // return the error that the mutex isn't owned by this process
 // (or possibly that it's invalid), both of which are programming errors
 // and not anything that can reasonably be responded to.
-static inline void qio_unlock(qio_lock_t* x) { int rc = pthread_mutex_unlock(x); if( rc ) { assert(rc == 0); abort(); } }
+static inline void qio_unlock(qio_lock_t* x) {
+  int rc;
+  if( x->bound ) {
+    assert( pthread_equal(x->owner, pthread_self()) );
+    return;
+  }
+  rc = pthread_mutex_unlock(&x->mutex);
+  if( rc ) { assert(rc == 0); abort(); }
+}
+
+static inline qioerr qio_lock_bind(qio_lock_t* x) {
+  if( x->bound ) {
+    assert( pthread_equal(x->owner, pthread_self()) );
+    return 0;
+  }
+  int rc = pthread_mutex_lock(&x->mutex);
+  if( rc ) return qio_int_to_err(rc);
+  x->owner = pthread_self();
+  x->bound = 1;
+  return 0;
+}
+
+static inline void qio_lock_unbind(qio_lock_t* x) {
+  if( ! x->bound ) return;
+  assert( pthread_equal(x->owner, pthread_self()) );
+  x->bound = 0;
+  qio_unlock(x);
+}
 
 static inline qioerr qio_lock_init(qio_lock_t* x) {
   pthread_mutexattr_t attr;
   err_t err, newerr;
 
+  x->bound = 0;
+
   err = pthread_mutexattr_init(&attr);
   if( err ) return qio_int_to_err(err);
   err = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
   if( ! err ) {
-    err = pthread_mutex_init(x, &attr);
+    err = pthread_mutex_init(&x->mutex, &attr);
   }
 
   newerr = pthread_mutexattr_destroy(&attr);
@@ -163,7 +214,15 @@ static inline qioerr qio_lock_init(qio_lock_t* x) {
 }
 
 // returns void for the same reason as qio_unlock.
-static inline void qio_lock_destroy(qio_lock_t* x) { int rc = pthread_mutex_destroy(x); if( rc ) { assert(rc == 0); abort(); } }
+static inline void qio_lock_destroy(qio_lock_t* x) {
+  int rc;
+  if( x->bound ) {
+    x->bound = 0;
+    pthread_mutex_unlock(&x->mutex);
+  }
+  rc = pthread_mutex_destroy(&x->mutex);
+  if( rc ) { assert(rc == 0); abort(); }
+}
 
 #ifdef __cplusplus
 } // end extern "C"
@@ -178,6 +237,13 @@ extern "C" {
 extern ssize_t qio_too_small_for_default_mmap;
 extern ssize_t qio_too_large_for_default_mmap;
 extern ssize_t qio_mmap_chunk_iobufs;
+extern ssize_t qio_mmap_window_iobufs;
+extern int qio_mmap_windows;
+extern int qio_uring_default;
+extern ssize_t qio_uring_readahead_iobufs;
+extern ssize_t qio_pipeline_depth;
+extern int qio_pipeline_threads;
+extern ssize_t qio_direct_align;
 
 /* Wrap system calls readv, writev, preadv, pwritev
  * to take a buffer.
@@ -225,6 +291,7 @@ char* qio_chtype_to_string(qio_chtype_t type);
      -- noreuse -- pread/pwrite
      -- cached -- mmap for reads and writes
      -- force_readwrite
+     -- uring -- io_uring, if asked for or CHPL_RT_QIO_URING is set
  */
 
 #define QIO_HINT_AFTERCHTYPE 0x0010
@@ -235,13 +302,14 @@ typedef enum {
   QIO_METHOD_FREADFWRITE = 3*QIO_HINT_AFTERCHTYPE,
   QIO_METHOD_MMAP = 4*QIO_HINT_AFTERCHTYPE,
   QIO_METHOD_MEMORY = 5*QIO_HINT_AFTERCHTYPE,
+  QIO_METHOD_URING = 6*QIO_HINT_AFTERCHTYPE,
   //QIO_METHOD_LIBEVENT,
 } qio_method_t;
 #define QIO_METHODMASK 0x00f0
 #define QIO_HINT_AFTERMETHOD 0x0100
 #define QIO_METHOD_DEFAULT 0
 #define QIO_MIN_METHOD QIO_METHOD_READWRITE
-#define QIO_MAX_METHOD QIO_METHOD_MEMORY
+#define QIO_MAX_METHOD QIO_METHOD_URING
 
 enum {
   QIO_HINT_RANDOM       = QIO_HINT_AFTERMETHOD,
@@ -256,9 +324,11 @@ enum {
      // user buffer must be page-aligned. This should more or
      // less work the way you expect for a buffered channel,
      // but you'll have to round out all files to a multiple of 512
-     // bytes. This library could help by turning off O_DIRECT when
-     // encountering improper alignment, but the linux open man page
-     // says:
+     // bytes. Unbuffered channels do handle improper alignment, by
+     // doing the unaligned head and tail of each transfer through a
+     // second descriptor without O_DIRECT (and bouncing the aligned
+     // middle through an aligned iobuf if the user buffer isn't
+     // aligned). The linux open man page says:
 //Applications should avoid mixing O_DIRECT and normal I/O to the same file, and
 //especially to overlapping byte regions in the same file.  Even when the file
 //system correctly handles the coherency issues in this situation, overall I/O
@@ -336,6 +406,9 @@ char* qio_hints_to_string(qio_hint_t hint)
       case QIO_METHOD_MEMORY:
         strcat(buf, " memory"); ok = 1;
         break;
+      case QIO_METHOD_URING:
+        strcat(buf, " uring"); ok = 1;
+        break;
       // no default to get warned if any are added.
     }
   }
@@ -357,6 +430,15 @@ char* qio_hints_to_string(qio_hint_t hint)
 }
 #endif
 
+// A read-only mapping of part of a file, shared by the buffered-mmap
+// reading channels on that file. See _buffered_get_mmap.
+#define QIO_MMAP_WINDOWS_MAX 16
+typedef struct qio_mmap_window_s {
+  qbytes_t* bytes; // NULL if this slot is unused
+  int64_t start; // file offset of bytes->data
+  uint64_t last_use; // for LRU eviction
+} qio_mmap_window_t;
+
 typedef struct qio_file_s {
   // reference count which is atomically updated
   qbytes_refcnt_t ref_cnt;
@@ -369,6 +451,7 @@ typedef struct qio_file_s {
   // An (arguably) better solution is to put 
   FILE* fp; // set if this file wraps a FILE*
   fd_t fd; // -1 if not set
+  fd_t nodirect_fd; // with QIO_HINT_DIRECT: fd without O_DIRECT, or -1
   int use_fp; // we only default to FREADFWRITE if this and fp are set.
   qbuffer_t* buf; // NULL if not set.
                   // if set, fp==NULL, fd==-1, is memory-only file.
@@ -378,6 +461,8 @@ typedef struct qio_file_s {
 
   //void* fs_info; // Holds the filesystem information (as a user defined struct)
   void* file_info; // Holds the file information (as a user defined struct)
+  // The functions handling file_info, or NULL for the chpl_qio_ ones.
+  const struct qio_plugin_ops_s* plugin_ops;
 
   qio_fdflag_t fdflags;
   bool closed;
@@ -391,6 +476,10 @@ typedef struct qio_file_s {
   //  but the mapping is fixed for the lifetime of
   //  the file. That's so that no locking is necessary
   //  on the file object itself).
+
+  // Unlike mmap above, these come and go (protected by the file lock).
+  qio_mmap_window_t mmap_windows[QIO_MMAP_WINDOWS_MAX];
+  uint64_t mmap_window_clock;
   
   // When writing files with buffered-mmap, we will mmap
   // the file in chunks. As a result, we might need to extend
@@ -432,6 +521,10 @@ qioerr qio_readv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer
 qioerr qio_writev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, ssize_t* num_written);
 qioerr qio_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read);
 qioerr qio_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written);
+// Like qio_preadv/qio_pwritev, but each buffer part is a separate io_uring
+// op and all of them are in flight at once.
+qioerr qio_uring_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read);
+qioerr qio_uring_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written);
 
 // if fp is not null, fd is ignored; if fp is null, we use fd.
 // the QIO file takes ownership of fp or fd, closing it when the QIO file is closed.
@@ -455,6 +548,34 @@ qioerr qio_get_fs_type(qio_file_t* fl, int* out);
 qioerr qio_get_chunk(qio_file_t* fl, int64_t* len_out);
 qioerr qio_locales_for_region(qio_file_t* fl, off_t start, off_t end, const char*** locale_names_out, int64_t* num_locs_out);
 
+// A plan for reading [start, end) of a file in parallel on several
+// nodes.  Chunk i is [chunk_start[i], chunk_start[i+1]) and is read by
+// node chunk_node[i].  Chunk boundaries are at multiples of a chunk
+// size that is itself a multiple of qio_get_chunk().
+typedef struct qio_read_plan_s {
+  int64_t num_chunks;
+  int64_t num_nodes;
+  int64_t* chunk_start; // num_chunks+1 entries
+  int64_t* chunk_node;
+} qio_read_plan_t;
+
+extern int64_t qio_parallel_read_min_chunk;
+
+// Splits [start, end) into chunks and assigns them to nodes 0..num_nodes-1.
+// If the file system can report locality (qio_locales_for_region) and
+// node_names (the host names of the nodes, may be NULL) is given, chunks
+// go to a node holding them where that keeps the load balanced.  The
+// rest are given out in contiguous runs.  min_chunk <= 0 means
+// qio_parallel_read_min_chunk.
+qioerr qio_plan_parallel_read(qio_file_t* fl, int64_t start, int64_t end, int64_t num_nodes, const char** node_names, int64_t min_chunk, qio_read_plan_t** plan_out);
+void qio_read_plan_free(qio_read_plan_t* plan);
+// Returns the first chunk >= chunk that belongs to node, or -1.
+int64_t qio_read_plan_next(const qio_read_plan_t* plan, int64_t node, int64_t chunk);
+// For text formats: moves a chunk's ends forward to just after the next
+// 'sep' (e.g. newline), so that every record of [region_start,
+// region_end) lands in exactly one chunk.
+qioerr qio_align_chunk_to_records(qio_file_t* fl, int64_t region_start, int64_t region_end, int64_t start, int64_t end, int32_t sep, int64_t* start_out, int64_t* end_out);
+
 // This can be called to run close and to check the return value.
 // That's important because some implementations (such as NFS)
 // actually write data on the close() call, so here's where we'll
@@ -702,6 +823,10 @@ typedef struct qio_channel_s {
 
   qbuffer_t buf;
 
+  // Background read-ahead/write-behind state, if any (see
+  // qio_pipeline_depth).
+  struct qio_pipeline_s* pipeline;
+
   // For reading/writing bits (ie less than a byte) at a time
   qio_bitbuffer_t bit_buffer;
   void* cached_end_bits; // cause flush before byte I/O
@@ -941,6 +1066,22 @@ void qio_channel_unlock(qio_channel_t* ch)
   qio_unlock(&ch->lock);
 }
 
+// For channels only ever used by one task: after this, the calling
+// task's operations on ch skip locking until qio_channel_unbind_owner.
+// Using ch from any other task while it is bound is an error, which
+// debug builds catch with an assertion.
+static inline
+qioerr qio_channel_bind_owner(qio_channel_t* ch)
+{
+  return qio_lock_bind(&ch->lock);
+}
+
+static inline
+void qio_channel_unbind_owner(qio_channel_t* ch)
+{
+  qio_lock_unbind(&ch->lock);
+}
+
 static inline
 qio_file_t* qio_channel_get_file(qio_channel_t* ch)
 {
@@ -1202,6 +1343,14 @@ qioerr qio_channel_end_peek_cached(const int threadsafe, qio_channel_t* ch, void
 
 qioerr qio_channel_advance_past_byte(const int threadsafe, qio_channel_t* ch, int byte);
 
+size_t qio_find_byte_offsets(const void* ptr, size_t len, int byte, int64_t* offsets, size_t max_offsets);
+
+// Finds up to max_offsets occurrences of byte in the data the channel
+// already has buffered (reading some if there is none), storing their
+// channel offsets.  Doesn't move the channel; a line reader can consume
+// the lines found and call this again.  Returns EEOF at end of input.
+qioerr qio_channel_find_byte_offsets(const int threadsafe, qio_channel_t* ch, int byte, int64_t* offsets, size_t max_offsets, size_t* num_out);
+
 qioerr qio_channel_begin_peek_buffer(const int threadsafe, qio_channel_t* ch, int64_t require, int writing, qbuffer_t** buf_out, qbuffer_iter_t* start_out, qbuffer_iter_t* end_out);
 
 qioerr qio_channel_end_peek_buffer(const int threadsafe, qio_channel_t* ch, int64_t advance);
@@ -1267,6 +1416,21 @@ qioerr qio_channel_put_bytes(const int threadsafe, qio_channel_t* ch, qbytes_t*
 
 qioerr qio_channel_put_buffer(const int threadsafe, qio_channel_t* ch, qbuffer_t* src, qbuffer_iter_t src_start, qbuffer_iter_t src_end);
 
+// Moves len bytes (or, if len < 0, everything up to EOF) from src to dst,
+// as if read from one and written to the other.  When both are channels
+// on fds, the kernel does the copy (copy_file_range, sendfile or
+// splice); otherwise buffers are passed along without copying where
+// possible.  *num_out is the number of bytes moved.
+qioerr qio_channel_transfer(const int threadsafe, qio_channel_t* dst, qio_channel_t* src, int64_t len, int64_t* num_out);
+
+// Read or write count elt_size-byte (1, 2, 4 or 8) values, converting
+// each from/to byteorder (QIO_NATIVE, QIO_BIG or QIO_LITTLE).  Requests
+// of at least an iobuf on fd-backed buffered channels go directly
+// between ptr and the file instead of through the channel buffer.
+// The read returns the number of whole values read in *num_read_out.
+qioerr qio_channel_read_array(const int threadsafe, const int byteorder, qio_channel_t* restrict ch, void* restrict ptr, size_t elt_size, ssize_t count, ssize_t* restrict num_read_out);
+qioerr qio_channel_write_array(const int threadsafe, const int byteorder, qio_channel_t* restrict ch, const void* restrict ptr, size_t elt_size, ssize_t count);
+
 
 static inline
 qioerr qio_channel_flush(const int threadsafe, qio_channel_t* ch)
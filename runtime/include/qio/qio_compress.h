@@ -0,0 +1,61 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _QIO_COMPRESS_H_
+#define _QIO_COMPRESS_H_
+
+#include "sys_basic.h"
+#include "qio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Streaming compression for channels, built on the plugin interface in
+// qio_plugin_api.h. The runtime only supports the codecs it was built
+// with (-DSYS_HAS_ZSTD / -DSYS_HAS_LZ4, see CHPL_QIO_COMPRESS).
+typedef enum {
+  QIO_COMPRESS_ZSTD = 1,
+  QIO_COMPRESS_LZ4 = 2,
+} qio_compress_codec_t;
+
+// Compression level for writers; 0 means the codec's default.
+extern int qio_compress_level;
+// How many worker threads compress for each zstd writer. 0 compresses
+// in the writing task; -1 means use CHPL_RT_QIO_COMPRESS_THREADS (4).
+extern int qio_compress_threads;
+
+// Returns true if codec is available in this runtime.
+int qio_compress_supported(qio_compress_codec_t codec);
+
+// Creates a file whose channels decompress what they read from, or
+// compress what they write to, the file backing (which is retained).
+// A compressed stream is not seekable, so channels on the new file
+// must start at offset 0; each writing channel produces a complete
+// compressed frame when it is closed.
+qioerr qio_file_open_compressed(qio_file_t** file_out, qio_file_t* backing,
+                                qio_compress_codec_t codec,
+                                const qio_style_t* style);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
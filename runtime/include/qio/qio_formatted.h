@@ -197,6 +197,25 @@ qioerr qio_channel_read_uvarint(const int threadsafe, qio_channel_t* restrict ch
 qioerr qio_channel_read_svarint(const int threadsafe, qio_channel_t* restrict ch, int64_t* restrict ptr);
 qioerr qio_channel_write_uvarint(const int threadsafe, qio_channel_t* restrict ch, uint64_t num);
 qioerr qio_channel_write_svarint(const int threadsafe, qio_channel_t* restrict ch, int64_t num);
+// The same for arrays of count values.  The read functions return
+// the number of values read in *num_read_out.
+qioerr qio_channel_read_uvarints(const int threadsafe, qio_channel_t* restrict ch, uint64_t* restrict ptr, ssize_t count, ssize_t* restrict num_read_out);
+qioerr qio_channel_read_svarints(const int threadsafe, qio_channel_t* restrict ch, int64_t* restrict ptr, ssize_t count, ssize_t* restrict num_read_out);
+qioerr qio_channel_write_uvarints(const int threadsafe, qio_channel_t* restrict ch, const uint64_t* restrict ptr, ssize_t count);
+qioerr qio_channel_write_svarints(const int threadsafe, qio_channel_t* restrict ch, const int64_t* restrict ptr, ssize_t count);
+// Decode up to count varints from the len bytes at buf, e.g. a packed
+// repeated field in a buffer that is already in memory.  Stops early at
+// the end of the region; *used_out is the number of bytes decoded.
+// Returns EEOF if the last varint is cut off at the end of the region
+// and EFORMAT if one doesn't fit in 64 bits.
+qioerr qio_decode_uvarints(const void* restrict buf, size_t len, uint64_t* restrict ptr, ssize_t count, ssize_t* restrict num_read_out, size_t* restrict used_out);
+qioerr qio_decode_svarints(const void* restrict buf, size_t len, int64_t* restrict ptr, ssize_t count, ssize_t* restrict num_read_out, size_t* restrict used_out);
+
+// Read len bytes without copying them when they are in one bytes object
+// of the channel's buffer, as they are for memory and memory-mapped
+// files.  The data is at *skip_out in *bytes_out, which the caller must
+// release; bytes that span objects are copied into a new one.
+qioerr qio_channel_read_bytes_ref(const int threadsafe, qio_channel_t* restrict ch, int64_t len, qbytes_t** restrict bytes_out, int64_t* restrict skip_out);
 
 
 static inline
@@ -762,6 +781,23 @@ int32_t qio_skip_json_field_unlocked(qio_channel_t* restrict ch);
 
 qioerr qio_channel_skip_json_field(const int threadsafe, qio_channel_t* ch);
 
+// One field of a JSON object, as channel offsets.  The bytes are not
+// copied or decoded; to read one, mark the channel before the object
+// and seek back to it.
+typedef struct qio_json_field_s {
+  int64_t name_start; // first byte of the name, after the quote;
+                      // -1 if the object had no more fields
+  int64_t name_end; // the closing quote of the name
+  int64_t value_start; // first byte of the value
+  int64_t value_end; // just past the value
+  int32_t value_kind; // '"' '{' '[' 't' 'f' 'n', or '0' for a number
+  int32_t last; // the object's closing '}' was read
+} qio_json_field_t;
+
+// Reads the next field of a JSON object whose '{' was already read,
+// along with the ',' or '}' after it.  Call it again until field->last.
+qioerr qio_channel_json_next_field(const int threadsafe, qio_channel_t* ch, qio_json_field_t* field);
+
 enum {
   QIO_CONV_UNK = 0,
   QIO_CONV_ARG_TYPE_NUMERIC,
@@ -52,6 +52,25 @@ syserr chpl_qio_get_locales_for_region(void* file, int64_t start, int64_t end, v
 
 // close a file
 syserr chpl_qio_file_close(void* file);
+
+// The plugin functions a file uses. Files from qio_file_init_plugin
+// use the chpl_qio_ functions above; a plugin built into the runtime
+// (e.g. qio_compress.c) passes its own to qio_file_init_plugin_ops.
+typedef struct qio_plugin_ops_s {
+  syserr (*setup_plugin_channel)(void* file, void** plugin_ch, int64_t start, int64_t end, qio_channel_t* qio_ch);
+  syserr (*read_atleast)(void* plugin_ch, int64_t amt);
+  syserr (*write)(void* plugin_ch, int64_t amt);
+  syserr (*channel_close)(void* ch);
+  syserr (*filelength)(void* file, int64_t* length);
+  syserr (*getpath)(void* file, const char** str, int64_t* len);
+  syserr (*fsync)(void* file);
+  syserr (*get_chunk)(void* file, int64_t* length);
+  syserr (*get_locales_for_region)(void* file, int64_t start, int64_t end, void **localeNamesPtr, int64_t* nLocales);
+  syserr (*file_close)(void* file);
+} qio_plugin_ops_t;
+
+qioerr qio_file_init_plugin_ops(qio_file_t** file_out, void* file_info, const qio_plugin_ops_t* ops, int fdflags, const qio_style_t* style);
+
 #ifdef __cplusplus
 }
 #endif
@@ -61,6 +61,16 @@ qioerr qio_proc_communicate(
     qio_channel_t* output,
     qio_channel_t* error);
 
+// Copies in_src to a child's stdin pipe and the child's stdout pipe to
+// out_dst at the same time, so that a child which writes while it reads
+// can't deadlock against us. Uses splice/sendfile where the kernel
+// supports them. The pipe ends are made non-blocking while pumping and
+// the task waits for them with a poller; stdin_fd is closed once in_src
+// is exhausted. Pass -1 to skip a direction. Returns once both are done.
+qioerr qio_proc_pump(fd_t in_src, fd_t stdin_fd,
+                     fd_t stdout_fd, fd_t out_dst,
+                     int64_t* in_bytes_out, int64_t* out_bytes_out);
+
 qioerr qio_send_signal(int64_t pid, int qio_sig);
 
 #ifdef __cplusplus
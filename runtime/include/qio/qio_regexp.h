@@ -142,6 +142,53 @@ int64_t qio_regexp_replace(qio_regexp_t* regexp, const char* repl, int64_t repl_
 //
 qioerr qio_regexp_channel_match(const qio_regexp_t* regexp, const int threadsafe, struct qio_channel_s* ch, int64_t maxlen, int anchor, qio_bool can_discard, qio_bool keep_unmatched, qio_bool keep_whole_pattern, qio_regexp_string_piece_t* submatch, int64_t nsubmatch);
 
+// A set of patterns that are all matched in one pass over the text.
+// Patterns are added to a new set and it is then compiled; after that it
+// can only be matched against (from any number of threads) and released.
+typedef struct qio_regexp_set_s {
+  void* set;
+} qio_regexp_set_t;
+
+static inline
+qio_regexp_set_t qio_regexp_set_null(void)
+{
+  qio_regexp_set_t ret;
+  ret.set = NULL;
+  return ret;
+}
+
+// The set returned in set_out must be released by the caller.
+// anchor is one of QIO_REGEXP_ANCHOR_* and applies to every pattern.
+void qio_regexp_set_create(const qio_regexp_options_t* options, int anchor, qio_regexp_set_t* set_out);
+void qio_regexp_set_retain(const qio_regexp_set_t* set);
+void qio_regexp_set_release(qio_regexp_set_t* set);
+
+// Adds a pattern and returns the index that identifies it in match
+// results, counting from 0. Returns -1 if the pattern does not parse or
+// the set is already compiled; if error_out is not NULL, it is then set
+// to an error message that the caller must free.
+int64_t qio_regexp_set_add(qio_regexp_set_t* set, const char* str, int64_t str_len, const char** error_out);
+// Returns false if the set could not be compiled.
+qio_bool qio_regexp_set_compile(qio_regexp_set_t* set);
+// Returns the number of patterns in the set.
+int64_t qio_regexp_set_size(const qio_regexp_set_t* set);
+
+// Matches every pattern in a compiled set against str. Stores the indices
+// of up to nmatches matching patterns, in increasing order, in matches and
+// returns how many patterns matched (which may be more than nmatches), or
+// -1 if the set is not compiled or the matcher ran out of memory.
+int64_t qio_regexp_set_match(const qio_regexp_set_t* set, const char* str, int64_t str_len, int64_t* matches, int64_t nmatches);
+
+// Matches a compiled set against the next record from a channel, for
+// example one line of a log, and advances the channel past it. The record
+// ends just before the next delim byte (which is consumed too) or at EOF;
+// if delim is negative, it is the next maxlen bytes. At most maxlen bytes
+// of a record are matched against. Stores the results as
+// qio_regexp_set_match does, with the count in nmatched_out.
+// Returns EEOF if there is no record left, EINVAL if delim is negative
+// and maxlen unbounded, or an IO error.
+qioerr qio_regexp_set_channel_match(const qio_regexp_set_t* set, const int threadsafe, struct qio_channel_s* ch, int64_t maxlen, int delim, int64_t* matches, int64_t nmatches, int64_t* nmatched_out);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
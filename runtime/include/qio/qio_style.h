@@ -186,6 +186,8 @@ typedef struct qio_style_s {
 
   // realfmt does not apply to integers.
   uint8_t realfmt; //0 -> print with %g; 1 -> print with %f; 2 -> print with %e
+                   //3 -> shortest digits that read back exactly (like %g
+                   //     when a precision is given)
 
   // Other data type choices
   //
@@ -201,6 +201,31 @@ err_t sys_writev(fd_t fd, const struct iovec* iov, int iovcnt, ssize_t* num_writ
 err_t sys_preadv(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_read_out);
 err_t sys_pwritev(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_written_out);
 
+/* Batched positional I/O through io_uring (Linux).  Each op is one
+ * buffer at its own file offset; all of them are submitted together and
+ * the caller waits, without blocking its thread, until every one has
+ * completed.  On return each op's result holds the byte count or
+ * -errno.  Returns ENOSYS if io_uring is unavailable, in which case no
+ * op was started.
+ */
+typedef struct sys_uring_op_s {
+  struct iovec iov;
+  off_t offset;
+  ssize_t result;
+  int* pending; // internal: the batch's outstanding op count
+} sys_uring_op_t;
+
+int sys_uring_available(void);
+err_t sys_uring_rw(fd_t fd, int writing, sys_uring_op_t* ops, int nops);
+
+/* Copies up to len bytes from in_fd to out_fd inside the kernel, using
+ * copy_file_range, sendfile or splice, whichever can handle the pair.
+ * A NULL offset means use (and advance) that fd's file position;
+ * otherwise the offset is used and advanced.  Returns ENOSYS, having
+ * copied nothing, if none of them can.
+ */
+err_t sys_copy_fd(fd_t in_fd, off_t* in_off, fd_t out_fd, off_t* out_off, size_t len, ssize_t* num_copied_out);
+
 err_t sys_fsync(fd_t fd);
 
 err_t sys_fcntl(fd_t fd, int cmd, int* ret);
@@ -302,6 +327,32 @@ static inline void sys_fd_zero(fd_set* set) {
   FD_ZERO(set);
 }
 
+// Waiting for any of many fds to become ready (epoll, kqueue, or poll).
+#define SYS_POLL_READ    0x1
+#define SYS_POLL_WRITE   0x2
+#define SYS_POLL_ERROR   0x4 // only reported: error or hangup on the fd
+#define SYS_POLL_ONESHOT 0x8 // only report once, until sys_poller_modify
+
+typedef struct sys_poller_s sys_poller_t;
+
+typedef struct sys_poll_event_s {
+  fd_t fd;
+  int events; // SYS_POLL_READ/WRITE/ERROR that happened
+  void* data; // as passed to sys_poller_add/modify
+} sys_poll_event_t;
+
+err_t sys_poller_create(sys_poller_t** poller_out);
+err_t sys_poller_destroy(sys_poller_t* p);
+// Each fd can be added once; modify changes its events and data.
+err_t sys_poller_add(sys_poller_t* p, fd_t fd, int events, void* data);
+err_t sys_poller_modify(sys_poller_t* p, fd_t fd, int events, void* data);
+err_t sys_poller_remove(sys_poller_t* p, fd_t fd);
+// Waits up to timeout_usec (forever if negative) for registered fds to
+// become ready and returns up to max of them.  Other tasks can run on
+// this thread while it waits.  With kqueue, an fd waiting for both
+// reading and writing can show up twice.
+err_t sys_poller_wait(sys_poller_t* p, sys_poll_event_t* events, int max, int64_t timeout_usec, int* num_out);
+
 
 err_t sys_unlink(const char* path);
 
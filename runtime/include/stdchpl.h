@@ -37,6 +37,7 @@
 #include <chpl_md.h>
 
 #include "arg.h"
+#include "chpl-align.h"
 #include "config.h"
 #include "chplcast.h"
 #include "chplcgfns.h"
@@ -60,6 +60,26 @@ typedef pthread_cond_t chpl_thread_condvar_t;
 //
 // Sync variables
 //
+// On Linux these are built on futexes: a lock word plus, for each of
+// full and empty, a sequence word that waiters park on and a count of
+// parked waiters, so that signaling costs no system call when nobody
+// is waiting.  Elsewhere (or with CHPL_TASKS_FIFO_NO_FUTEX_SYNC) they
+// use a mutex and condition variables.
+//
+#if defined(__linux__) && !defined(CHPL_TASKS_FIFO_NO_FUTEX_SYNC)
+#define CHPL_TASKS_FIFO_FUTEX_SYNC
+#endif
+
+#ifdef CHPL_TASKS_FIFO_FUTEX_SYNC
+typedef struct {
+  volatile chpl_bool is_full;
+  uint32_t lock;                // 0: free, 1: held, 2: held, maybe waiters
+  uint32_t full_seq;            // bumped each time it is marked full
+  uint32_t empty_seq;           // bumped each time it is marked empty
+  uint32_t full_waiters;        // number parked waiting for full
+  uint32_t empty_waiters;       // number parked waiting for empty
+} chpl_sync_aux_t;
+#else
 typedef struct {
   volatile chpl_bool  is_full;
   chpl_thread_mutex_t lock;
@@ -67,6 +87,7 @@ typedef struct {
   chpl_thread_condvar_t signal_empty; // wait for empty; signal this when empty
   //  threadlayer_sync_aux_t tl_aux;
 } chpl_sync_aux_t;
+#endif
 
 #ifdef __cplusplus
 } // end extern "C"
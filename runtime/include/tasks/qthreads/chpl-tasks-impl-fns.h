@@ -73,11 +73,53 @@ typedef struct chpl_qthread_tls_s {
   // That would reduce the size of the task local storage,
   // but increase the size of executeOn bundles.
   chpl_task_infoRuntime_t infoRuntime;
+  // Time blocked on sync vars, when the task profiler is on.
+  uint64_t prof_sync_ns;
 } chpl_qthread_tls_t;
 
 extern pthread_t chpl_qthread_process_pthread;
 extern pthread_t chpl_qthread_comm_pthread;
 
+//
+// Number of shepherds serving each sublocale.  Normally this is 1 and
+// shepherd i is sublocale i, but in NUMA shepherd mode with a scheduler
+// that has only one worker per shepherd, each NUMA domain gets a
+// contiguous range of shepherds.
+//
+extern int chpl_qthread_sheps_per_subloc;
+
+static inline
+c_sublocid_t chpl_qthread_shepToSubloc(qthread_shepherd_id_t shep)
+{
+    if (shep == NO_SHEPHERD || chpl_qthread_sheps_per_subloc <= 1)
+        return (c_sublocid_t) shep;
+    return (c_sublocid_t) (shep / chpl_qthread_sheps_per_subloc);
+}
+
+//
+// Pick a shepherd for the given execution sublocale.  Stay on the
+// current shepherd if it's already serving that sublocale, otherwise
+// spread tasks across the sublocale's shepherds.
+//
+static inline
+qthread_shepherd_id_t chpl_qthread_sublocToShep(c_sublocid_t subloc)
+{
+    static __thread unsigned int next = 0;
+    qthread_shepherd_id_t curr_shep;
+
+    if (chpl_qthread_sheps_per_subloc <= 1)
+        return (qthread_shepherd_id_t) subloc;
+
+    curr_shep = qthread_shep();
+    if (curr_shep != NO_SHEPHERD
+        && chpl_qthread_shepToSubloc(curr_shep) == subloc)
+        return curr_shep;
+
+    return (qthread_shepherd_id_t)
+           (subloc * chpl_qthread_sheps_per_subloc
+            + next++ % chpl_qthread_sheps_per_subloc);
+}
+
 extern chpl_qthread_tls_t chpl_qthread_process_tls;
 extern chpl_qthread_tls_t chpl_qthread_comm_task_tls;
 
@@ -160,7 +202,7 @@ static inline
 c_sublocid_t chpl_task_getSubloc(void)
 {
     return chpl_localeModel_sublocMerge(chpl_task_getRequestedSubloc(),
-                                        (c_sublocid_t) qthread_shep());
+                                        chpl_qthread_shepToSubloc(qthread_shep()));
 }
 
 #ifdef CHPL_TASK_SETSUBLOC_IMPL_DECL
@@ -195,8 +237,8 @@ void chpl_task_setSubloc(c_sublocid_t full_subloc)
         }
 
         if (execution_subloc != c_sublocid_any &&
-            (qthread_shepherd_id_t) execution_subloc != curr_shep) {
-            qthread_migrate_to((qthread_shepherd_id_t) execution_subloc);
+            execution_subloc != chpl_qthread_shepToSubloc(curr_shep)) {
+            qthread_migrate_to(chpl_qthread_sublocToShep(execution_subloc));
         }
     }
 }
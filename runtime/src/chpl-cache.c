@@ -159,10 +159,10 @@ remote address. The pointer tree uses separate chaining (ie, each hash table
 element is actually a linked list of elements that go into that bucket).
 
 The cache consists of 'cache entries', one per 'cache page'. A 'cache page' is
-1024 bytes in the current implementation. The pointer tree and the 2Q queues
+1024 bytes by default. The pointer tree and the 2Q queues
 consist of cache entries which may point to a 1024-byte cache page. However, a
-GET is always rounded up to entire 'cache line'. A cache line is currently 64
-bytes. Each cache entry tracks which cache lines are valid (ie, for which cache
+GET is always rounded up to entire 'cache line'. A cache line is 64 bytes by
+default. Each cache entry tracks which cache lines are valid (ie, for which cache
 lines in the cache page have we done a GET?) and for pages that have been
 written to in a PUT - aka 'dirty pages' - which bytes in the page have been
 written to.
@@ -181,6 +181,11 @@ from an 8 byte request. We chose 1024 bytes for the cache page size because it
 is the smallest request size that allows close to peak bandwidth in our
 network.
 
+These are only defaults. The page size, line size, number of pages, and
+prefetch window can be chosen at program startup with the CHPL_RT_CACHE_*
+environment variables described below, so that one binary can use a small
+cache on memory-constrained nodes and a large one elsewhere.
+
 When processing a GET, we first check to see if the requested cache page is
 in the pointer tree. If not, we find an unused cache page and immediately start
 a nonblocking get into the appropriate portion of that page. While the get is
@@ -274,6 +279,7 @@ use.
 #include "chplrt.h"
 #include "chpl-comm.h"
 #include "chpl-comm-diags.h"
+#include "chpl-env.h"
 #include "chpl-tasks.h"
 #include "chpl-mem.h"
 #include "chpl-atomics.h"
@@ -287,6 +293,8 @@ use.
 
 
 #include <string.h> // memcpy, memset, etc.
+#include <stdlib.h> // qsort
+#include <time.h> // clock_gettime
 #include <assert.h>
 
 
@@ -306,42 +314,85 @@ use.
 // How many pending operations can we have at once?
 #define MAX_PENDING 32
 
+// The cache geometry (page size, line size, number of pages, and
+// prefetch window) is chosen at program startup by cache_init_geometry()
+// from these defaults and the following environment variables:
+//
+//   CHPL_RT_CACHE_PAGE_SIZE          cache page size in bytes
+//   CHPL_RT_CACHE_LINE_SIZE          cache line size in bytes
+//   CHPL_RT_CACHE_PAGES              number of cache pages per pthread
+//   CHPL_RT_CACHE_PREFETCH_PAGES     maximum pages per prefetch/readahead
+//   CHPL_RT_CACHE_STRIDE_PREFETCH_DISTANCE
+//                                    strides to prefetch ahead (0 disables)
+//   CHPL_RT_CACHE_VERBOSE            report the chosen geometry at startup
+//   CHPL_RT_CACHE_CALLSITE_STATS     count cache events per source line
+//   CHPL_RT_CACHE_SHARED_PAGES       pages in the node-wide shared tier
+//                                    (0, the default, disables it)
+//   CHPL_RT_CACHE_ADAPTIVE_2Q        adapt the Ain size to ghost hits
+//
+// Sizes must be powers of 2; other values are rounded down.
+
 // CACHEPAGE_BITS
 // Controls the cache page size - the cache manages items of this many bytes
 // but also includes facilities for partial pages (valid and dirty bits).
 //
 // Reasonable values for CACHEPAGE_BITS are between 6 and 12
 // (64 bytes and 4k bytes. CACHEPAGE_BITS should not be larger than the
-// page size) and it must currently be even.
-// Here we set it to 1k bytes (ie 2^10).
-#define CACHEPAGE_BITS 10
-#define CACHEPAGE_SIZE (1 << CACHEPAGE_BITS)
-#define CACHEPAGE_MASK (CACHEPAGE_SIZE-1)
+// page size). The default is 1k bytes (ie 2^10).
+// MAX_CACHEPAGE_BITS sizes the dirty bitmask in each dirty entry.
+#define DEFAULT_CACHEPAGE_BITS 10
+#define MIN_CACHEPAGE_BITS 6
+#define MAX_CACHEPAGE_BITS 12
 
 // CACHELINE_BITS
 // Controls the cache line size - that is, the minimum number of bytes
 // that are fetched for any 'get' operation.
 //
 // Reasonable values for CACHELINE_BITS are between 6 and CACHEPAGE_BITS.
-// Here we set it to 64 bytes (ie 2^6)
-#define CACHELINE_BITS 6
+// The default is 64 bytes (ie 2^6).
+#define DEFAULT_CACHELINE_BITS 6
+#define MIN_CACHELINE_BITS 6
+
+// How many cache pages does each pthread's cache have by default?
+// This used to grow based on the number of locales, but that
+// would mean increasing memory usage per node, which isn't acceptable.
+// The number of pages must be a power of 2.
+#define DEFAULT_CACHE_PAGES 1024
+#define MIN_CACHE_PAGES 64
+#define MAX_CACHE_PAGES (1 << 20)
+
+// When prefetching, what is the maximum number of pages
+// we are willing to prefetch? This is also the maximum
+// readahead window size for sequential access.
+#define DEFAULT_MAX_PAGES_PER_PREFETCH 2
+#define MAX_MAX_PAGES_PER_PREFETCH 16
+
+// The geometry actually in use. These are set once in chpl_cache_init
+// (before any cache is created) and are read-only after that.
+static int cachepage_bits = DEFAULT_CACHEPAGE_BITS;
+static int cacheline_bits = DEFAULT_CACHELINE_BITS;
+static int cache_num_pages = DEFAULT_CACHE_PAGES;
+static int max_pages_per_prefetch = DEFAULT_MAX_PAGES_PER_PREFETCH;
+
+#define CACHEPAGE_BITS cachepage_bits
+#define CACHEPAGE_SIZE (1 << CACHEPAGE_BITS)
+#define CACHEPAGE_MASK (CACHEPAGE_SIZE-1)
+
+#define CACHELINE_BITS cacheline_bits
 #define CACHELINE_SIZE (1 << CACHELINE_BITS)
 #define CACHELINE_MASK (CACHELINE_SIZE-1)
 
+#define MAX_PAGES_PER_PREFETCH max_pages_per_prefetch
+
 // What type can store the number of cache lines in a cache page?
 typedef int8_t line_per_page_t;
 // What type for a number of lines to read ahead?
-typedef int16_t readahead_distance_t;
+typedef int32_t readahead_distance_t;
 
 // used to compress top_index_list / bottom_index arrays
 // the entry pointer is entry_base + idx*sizeof(entry type)
 typedef int16_t entry_id_t;
 
-// When prefetching, what is the maximum number of pages
-// we are willing to prefetch? This is also the maximum
-// readahead window size for sequential access.
-#define MAX_PAGES_PER_PREFETCH 2
-
 // Should we enable sequential readahead?
 // For sequential access If we're reading
 #define ENABLE_READAHEAD 1
@@ -351,6 +402,12 @@ typedef int16_t entry_id_t;
 
 #define MAX_SEQUENTIAL_READAHEAD_BYTES (MAX_PAGES_PER_PREFETCH*CACHEPAGE_SIZE)
 
+// Should a release fence hand small dirty regions from all pages to the
+// comm layer as one batch of unordered PUTs (where the comm layer buffers
+// those)? How large can such a region be?
+#define ENABLE_WRITE_COMBINING 1
+#define MAX_COMBINED_PUT_BYTES 256
+
 // These defines can enable different kinds of debugging output.
 
 //#define TIME
@@ -454,6 +511,134 @@ static long time_duration(const struct timespec* t1, const struct timespec* t2)
 // ----------  SUPPORT FUNCTIONS
 #include "chpl-cache-support.c"
 
+// ----------  PER-CALLSITE STATISTICS
+//
+// If CHPL_RT_CACHE_CALLSITE_STATS is set, then while comm diagnostics
+// are on we count cache events for each source line that calls into the
+// cache. The public entry points record their callsite in the task
+// private data, so that evictions and waits they cause are charged to
+// that line too. The counts for this node are printed, sorted by misses,
+// at exit and whenever chpl_cache_print_callsite_stats() is called.
+
+#define CALLSITE_TABLE_BITS 10
+#define CALLSITE_TABLE_SIZE (1 << CALLSITE_TABLE_BITS)
+
+#define CHPL_CACHE_CALLSITE_VARS_ALL(MACRO) \
+  MACRO(hits) \
+  MACRO(misses) \
+  MACRO(readaheads) \
+  MACRO(evictions) \
+  MACRO(wait_ns)
+
+struct chpl_cache_callsite_s {
+  atomic_uint_least64_t key; // 0 means unused; see callsite_key()
+#define _CALLSITE_DECL(csv) atomic_uint_least64_t csv;
+  CHPL_CACHE_CALLSITE_VARS_ALL(_CALLSITE_DECL)
+#undef _CALLSITE_DECL
+};
+
+static int callsite_stats_enabled = 0;
+static struct chpl_cache_callsite_s* callsite_table = NULL;
+// Events from callsites that did not fit in the table are counted here.
+static struct chpl_cache_callsite_s callsite_overflow;
+
+static inline
+uint64_t callsite_key(int ln, int32_t fn)
+{
+  return ((((uint64_t)(uint32_t) fn) << 32) | (uint32_t) ln) + 1;
+}
+
+// Returns the counters for ln/fn, adding them to the table if needed,
+// or NULL if we are not counting right now.
+static
+struct chpl_cache_callsite_s* callsite_lookup(int ln, int32_t fn)
+{
+  uint64_t key;
+  unsigned int start, probe;
+
+  if (!callsite_stats_enabled ||
+      !chpl_comm_diagnostics || !chpl_comm_diags_is_enabled())
+    return NULL;
+
+  key = callsite_key(ln, fn);
+  start = (unsigned int) ((key * 0x9e3779b97f4a7c15ULL) >>
+                          (64 - CALLSITE_TABLE_BITS));
+
+  for (probe = 0; probe < CALLSITE_TABLE_SIZE; probe++) {
+    struct chpl_cache_callsite_s* cs =
+      &callsite_table[(start + probe) & (CALLSITE_TABLE_SIZE - 1)];
+    uint64_t cur = atomic_load_uint_least64_t(&cs->key);
+    if (cur == 0) {
+      // On failure, cur is updated to the key another task stored.
+      if (atomic_compare_exchange_strong_uint_least64_t(&cs->key, &cur, key))
+        return cs;
+    }
+    if (cur == key)
+      return cs;
+  }
+
+  return &callsite_overflow;
+}
+
+#define callsite_add(_cs, _ctr, _n)                                          \
+  do {                                                                       \
+    struct chpl_cache_callsite_s* _csp = (_cs);                              \
+    if (_csp != NULL) {                                                      \
+      (void) atomic_fetch_add_explicit_uint_least64_t(&_csp->_ctr, (_n),     \
+                                                      memory_order_relaxed); \
+    }                                                                        \
+  } while(0)
+
+static inline
+uint64_t callsite_now_ns(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t) t.tv_sec * 1000000000 + (uint64_t) t.tv_nsec;
+}
+
+// Sort order for printing: most misses first, then most waiting.
+static
+int compare_callsites(const void* a, const void* b)
+{
+  struct chpl_cache_callsite_s* x = *(struct chpl_cache_callsite_s* const*) a;
+  struct chpl_cache_callsite_s* y = *(struct chpl_cache_callsite_s* const*) b;
+  uint64_t xm = atomic_load_uint_least64_t(&x->misses);
+  uint64_t ym = atomic_load_uint_least64_t(&y->misses);
+  uint64_t xw, yw;
+
+  if (xm != ym)
+    return (xm > ym) ? -1 : 1;
+  xw = atomic_load_uint_least64_t(&x->wait_ns);
+  yw = atomic_load_uint_least64_t(&y->wait_ns);
+  if (xw != yw)
+    return (xw > yw) ? -1 : 1;
+  return 0;
+}
+
+static
+void callsite_print_at_exit(void)
+{
+  chpl_cache_print_callsite_stats();
+}
+
+static
+void callsite_init(void)
+{
+  callsite_stats_enabled =
+    chpl_env_rt_get_bool("CACHE_CALLSITE_STATS", false);
+  if (!callsite_stats_enabled)
+    return;
+
+  callsite_table = (struct chpl_cache_callsite_s*)
+                   chpl_calloc(CALLSITE_TABLE_SIZE,
+                               sizeof(struct chpl_cache_callsite_s));
+  if (callsite_table == NULL)
+    chpl_internal_error("could not allocate cache callsite statistics");
+
+  atexit(callsite_print_at_exit);
+}
+
 
 
 
@@ -469,6 +654,8 @@ struct rdcache_s;
 // How many uint64_t words do we need to create a bitmask for CACHEPAGE_SIZE?
 // Divide # bytes in cache by 64, rounding up.
 #define CACHEPAGE_BITMASK_WORDS ((CACHEPAGE_SIZE+63)/64)
+// ... and for the largest supported page size (used to size arrays)
+#define MAX_CACHEPAGE_BITMASK_WORDS (((1 << MAX_CACHEPAGE_BITS)+63)/64)
 
 // How many cache lines per cache page?
 #define CACHE_LINES_PER_PAGE (CACHEPAGE_SIZE/CACHELINE_SIZE)
@@ -476,6 +663,9 @@ struct rdcache_s;
 // How many uint64_t words do we need to create a bitmask for CACHE_LINES_PER_PAGE
 // ie, a mask recording a bit per cache line?
 #define CACHE_LINES_PER_PAGE_BITMASK_WORDS (((CACHEPAGE_SIZE/CACHELINE_SIZE)+63)/64)
+// ... and for the largest supported number of lines per page
+#define MAX_CACHE_LINES_PER_PAGE_BITMASK_WORDS \
+  ((((1 << MAX_CACHEPAGE_BITS) >> MIN_CACHELINE_BITS)+63)/64)
 
 // Storing a remote address (node number is separate).
 typedef uintptr_t raddr_t;
@@ -523,7 +713,7 @@ struct dirty_entry_s {
   // which cache entry are we talking about here?
   struct cache_entry_s* entry;
   // Which of the page's bytes are dirty?
-  uint64_t dirty[CACHEPAGE_BITMASK_WORDS]; // ie we need to create a put for these bytes
+  uint64_t dirty[MAX_CACHEPAGE_BITMASK_WORDS]; // ie we need to create a put for these bytes
 };
 
 #define QUEUE_FREE 0
@@ -548,6 +738,9 @@ struct cache_entry_s {
   struct cache_list_entry_s base; // contains raddr, node, next offset
   // Queue information. This entry could be in Ain, Aout, or Am queues.
   int queue;
+  // For an entry in Aout: was it evicted from Am (vs. from Ain)?
+  // Only set when the 2Q queue sizes are adaptive.
+  int ghost_from_am;
 
   // Since e.g. with ugni, a comm event can cause the implementation
   // to switch tasks, only allow one task at a time to manipulate
@@ -566,7 +759,10 @@ struct cache_entry_s {
   // This refers to CACHEPAGE_SIZE bytes of memory.
   unsigned char* page;
   // Which of the cache lines have we done 'get's for?
-  uint64_t valid_lines[CACHE_LINES_PER_PAGE_BITMASK_WORDS];
+  uint64_t valid_lines[MAX_CACHE_LINES_PER_PAGE_BITMASK_WORDS];
+  // Which of the valid lines did the stride prefetcher bring in
+  // that have not been read yet?
+  uint64_t stride_lines[MAX_CACHE_LINES_PER_PAGE_BITMASK_WORDS];
   // dirty info if this cache page is dirty, NULL otherwise.
   struct dirty_entry_s* dirty;
   // What is the minimum sequence number stored in this cache entry?
@@ -602,9 +798,173 @@ static int set_valid_lines(uint64_t* valid, uintptr_t skip, uintptr_t len)
 // Note skip/len are in line numbers, NOT byte offsets!
 static void unset_valid_lines(uint64_t* valid, uintptr_t skip, uintptr_t len)
 {
-  uint64_t myvalid[CACHE_LINES_PER_PAGE_BITMASK_WORDS];
+  uint64_t myvalid[MAX_CACHE_LINES_PER_PAGE_BITMASK_WORDS];
   unset_valids_for_skip_len(valid, myvalid, skip, len, CACHE_LINES_PER_PAGE_BITMASK_WORDS);
 }
+// Clears the lines in skip/len from valid, returning how many were set.
+// Note skip/len are in line numbers, NOT byte offsets!
+static int take_valid_lines(uint64_t* valid, uintptr_t skip, uintptr_t len)
+{
+  uint64_t region[MAX_CACHE_LINES_PER_PAGE_BITMASK_WORDS];
+  int count = 0;
+  int i;
+  memset(region, 0, sizeof(region));
+  set_valids_for_skip_len(region, skip, len, CACHE_LINES_PER_PAGE_BITMASK_WORDS);
+  for( i = 0; i < CACHE_LINES_PER_PAGE_BITMASK_WORDS; i++ ) {
+    count += chpl_bitops_popcount_64(valid[i] & region[i]);
+    valid[i] &= ~region[i];
+  }
+  return count;
+}
+
+// ----------  SHARED (NODE-WIDE) CACHE TIER
+//
+// If CHPL_RT_CACHE_SHARED_PAGES is nonzero, a direct-mapped, read-only
+// cache of that many pages is shared by all of the per-pthread caches on
+// a node. When a per-pthread cache misses, it copies the lines it needs
+// out of the shared tier if they are there and usable. If they are not,
+// a demand GET fetches them into the shared tier and then copies them
+// out, so read-mostly data used by every worker on a node is only
+// fetched once. Prefetches and readaheads only take lines that are
+// already present; otherwise they proceed as before.
+//
+// Shared lines must respect each task's acquire fences just as lines
+// in the per-pthread caches do. Each acquire fence advances shared_epoch
+// and records the new value in the task. Lines are stamped with the
+// value of shared_epoch from before they were fetched, and a task can only
+// use lines whose stamp is at least its own acquire epoch.
+//
+// Writes from this node must also be visible to later reads from this
+// node. Whenever a write-back from this node is known to have completed,
+// shared_write_gen is advanced, and that discards the whole shared tier.
+// The tier is meant for read-mostly data, so this coarse rule is OK.
+
+struct shared_slot_s {
+  atomic_bool busy;       // set while a task is using this slot
+  c_nodeid_t node;
+  raddr_t raddr;          // raddr of the page, 0 if the slot is empty
+  uint64_t epoch;         // shared_epoch value before the lines were fetched
+  uint64_t gen;           // shared_write_gen value then
+  uint64_t valid_lines[MAX_CACHE_LINES_PER_PAGE_BITMASK_WORDS];
+  unsigned char* page;
+};
+
+static int shared_num_pages = 0; // a power of 2, or 0 if disabled
+static struct shared_slot_s* shared_slots = NULL;
+static atomic_uint_least64_t shared_epoch;
+static atomic_uint_least64_t shared_write_gen;
+
+static inline
+int shared_tier_enabled(void)
+{
+  return shared_slots != NULL;
+}
+
+// Call this after writes from this node have completed.
+static inline
+void shared_note_writes(void)
+{
+  if (shared_tier_enabled())
+    (void) atomic_fetch_add_uint_least64_t(&shared_write_gen, 1);
+}
+
+static inline
+struct shared_slot_s* shared_slot_for(c_nodeid_t node, raddr_t ra_page)
+{
+  uint64_t key = ((uint64_t) ra_page >> CACHEPAGE_BITS) ^
+                 ((uint64_t) node * 0x9e3779b97f4a7c15ULL);
+  key *= 0x9e3779b97f4a7c15ULL;
+  return &shared_slots[(key >> 32) & (shared_num_pages - 1)];
+}
+
+// Returns 1 once the slot is ours. If wait is 0, returns 0 if it is busy.
+static inline
+int shared_slot_acquire(struct shared_slot_s* slot, int wait)
+{
+  while (atomic_exchange_bool(&slot->busy, true)) {
+    if (!wait) return 0;
+    // Whoever has it may be waiting on comm; let them (or others) run.
+    chpl_task_yield();
+  }
+  return 1;
+}
+
+static inline
+void shared_slot_release(struct shared_slot_s* slot)
+{
+  atomic_store_bool(&slot->busy, false);
+}
+
+// Can task_local use the lines in slot for node:ra_page?
+static inline
+int shared_slot_usable(struct shared_slot_s* slot,
+                       chpl_cache_taskPrvData_t* task_local,
+                       c_nodeid_t node, raddr_t ra_page)
+{
+  return slot->raddr == ra_page && slot->node == node &&
+         slot->gen == atomic_load_uint_least64_t(&shared_write_gen) &&
+         slot->epoch >= task_local->shared_acquire_epoch;
+}
+
+// Try to provide the lines ra_line..ra_line_end-1 of page ra_page on node
+// from the shared tier, copying them to dst. Returns 1 if it did so, in
+// which case the data is already in place (there is nothing to wait for).
+static
+int shared_get(chpl_cache_taskPrvData_t* task_local, unsigned char* dst,
+               c_nodeid_t node, raddr_t ra_page,
+               raddr_t ra_line, raddr_t ra_line_end, int isprefetch,
+               int32_t commID, int ln, int32_t fn)
+{
+  struct shared_slot_s* slot = shared_slot_for(node, ra_page);
+  uintptr_t skip_lines = (ra_line - ra_page) >> CACHELINE_BITS;
+  uintptr_t num_lines = (ra_line_end - ra_line) >> CACHELINE_BITS;
+  uint64_t epoch, gen;
+
+  // Prefetches don't wait for another task filling this slot.
+  if (!shared_slot_acquire(slot, !isprefetch))
+    return 0;
+
+  if (shared_slot_usable(slot, task_local, node, ra_page) &&
+      check_valid_lines(slot->valid_lines, skip_lines, num_lines)) {
+    chpl_memcpy(dst, slot->page + (ra_line - ra_page), ra_line_end - ra_line);
+    shared_slot_release(slot);
+    chpl_comm_diags_incr(cache_shared_hits);
+    return 1;
+  }
+
+  if (isprefetch) {
+    shared_slot_release(slot);
+    return 0;
+  }
+
+  // Fetch the lines into the shared tier. If the slot held lines that
+  // this task can't use, start over with this page.
+  epoch = atomic_load_uint_least64_t(&shared_epoch);
+  gen = atomic_load_uint_least64_t(&shared_write_gen);
+  if (!shared_slot_usable(slot, task_local, node, ra_page)) {
+    slot->node = node;
+    slot->raddr = ra_page;
+    slot->epoch = epoch;
+    slot->gen = gen;
+    memset(slot->valid_lines, 0, sizeof(slot->valid_lines));
+  }
+
+  // Note: chpl_comm_get can yield, but the slot stays busy.
+  chpl_comm_get(slot->page + (ra_line - ra_page), node, (void*) ra_line,
+                ra_line_end - ra_line, commID, ln, fn);
+  chpl_memcpy(dst, slot->page + (ra_line - ra_page), ra_line_end - ra_line);
+
+  // If writes from this node completed while we were fetching,
+  // we can't tell whether we saw them, so don't keep the lines.
+  if (atomic_load_uint_least64_t(&shared_write_gen) == gen)
+    set_valid_lines(slot->valid_lines, skip_lines, num_lines);
+  else
+    slot->raddr = 0;
+
+  shared_slot_release(slot);
+  chpl_comm_diags_incr(cache_shared_misses);
+  return 1;
+}
 
 struct rdcache_s {
   // A 2Q cache.
@@ -673,6 +1033,9 @@ struct rdcache_s {
 
   // Ain, a FIFO queue of entries not seen before
   unsigned int ain_max; // maximum; corresponds to Kin
+  // bounds on ain_max when it adapts (see adapt_ain_max)
+  unsigned int ain_min;
+  unsigned int ain_limit;
   unsigned int ain_current; // current length of ain list
   struct cache_entry_s *ain_head;
   struct cache_entry_s *ain_tail;
@@ -681,6 +1044,7 @@ struct rdcache_s {
   // note entries in Aout should have entry->addr==NULL
   unsigned int aout_max; // maximum; corresponds to Kout
   unsigned int aout_current; // current length of aout list
+  unsigned int aout_from_am; // how many of those were evicted from Am
   struct cache_entry_s *aout_head;
   struct cache_entry_s *aout_tail;
 
@@ -692,8 +1056,11 @@ struct rdcache_s {
 
   // List of dirty pages (for write-combining)
   int num_dirty_pages;
+  int max_dirty_pages;
   struct dirty_entry_s *dirty_lru_head;
   struct dirty_entry_s *dirty_lru_tail;
+  // Scratch space for cache_clean_dirty_combined (max_dirty_pages long)
+  struct cache_entry_s **combine_entries;
 
   // chpl-comm handles for pending operations
   // After requests are started, they will be stored here..
@@ -777,9 +1144,8 @@ struct rdcache_s* cache_create(void) {
   unsigned char* buffer;
   unsigned char* pages;
 
-  // This used to grow based on the number of locales, but that
-  // would mean increasing memory usage per node, which isn't acceptable.
-  cache_pages = 1024;
+  // Chosen by cache_init_geometry(); always a power of 2.
+  cache_pages = cache_num_pages;
 
   ain_pages = cache_pages / 4; // 2Q: "Kin should be 25% of page slots"
                                // but here we set it smaller so that
@@ -814,6 +1180,7 @@ struct rdcache_s* cache_create(void) {
   total_size += sizeof(struct page_list_s) * cache_pages;
   total_size += sizeof(struct cache_entry_s) * n_entries;
   total_size += sizeof(struct dirty_entry_s) * dirty_pages;
+  total_size += sizeof(struct cache_entry_s*) * dirty_pages;
   total_size += sizeof(chpl_comm_nb_handle_t) * pending_len;
   total_size += sizeof(cache_seqn_t) * pending_len;
   // We allocate an extra page for alignment
@@ -841,6 +1208,9 @@ struct rdcache_s* cache_create(void) {
   // dirty entries
   dirty_nodes = (struct dirty_entry_s*) (buffer + total_size);
   total_size += sizeof(struct dirty_entry_s) * dirty_pages;
+  // scratch space for write combining
+  c->combine_entries = (struct cache_entry_s**) (buffer + total_size);
+  total_size += sizeof(struct cache_entry_s*) * dirty_pages;
   // and the pending data area
   c->pending = (chpl_comm_nb_handle_t*) (buffer + total_size);
   total_size += sizeof(chpl_comm_nb_handle_t) * pending_len;
@@ -897,6 +1267,8 @@ struct rdcache_s* cache_create(void) {
 
 
   c->ain_max = ain_pages;
+  c->ain_min = ain_pages / 4 > 0 ? ain_pages / 4 : 1;
+  c->ain_limit = 3 * (cache_pages / 4);
   c->ain_current = 0;
   c->ain_head = NULL;
   c->ain_tail = NULL;
@@ -904,6 +1276,7 @@ struct rdcache_s* cache_create(void) {
 
   c->aout_max = aout_pages;
   c->aout_current = 0;
+  c->aout_from_am = 0;
   c->aout_head = NULL;
   c->aout_tail = NULL;
 
@@ -912,6 +1285,7 @@ struct rdcache_s* cache_create(void) {
   c->am_lru_tail = NULL;
 
   c->num_dirty_pages = 0;
+  c->max_dirty_pages = dirty_pages;
   c->dirty_lru_head = NULL;
   c->dirty_lru_tail = NULL;
   // set up dirty_lru as a linked list of dirty entries
@@ -1304,6 +1678,37 @@ void unreserve_entry(struct rdcache_s* cache,
                    struct cache_entry_s* entry);
 
 
+// Should the share of pages given to Ain adapt to the workload?
+static int adaptive_2q = 0;
+
+// When adaptive_2q is set, a hit on an Aout entry adjusts ain_max
+// in the style of ARC. If the entry was evicted from Ain, Ain was too
+// small to keep it until it was used again, so Ain grows. If it was
+// evicted from Am, Am was too small, so Ain shrinks (and since reclaim()
+// takes from Ain whenever it is over ain_max, Am grows). The step is
+// larger when the other kind of ghost is more common, as in ARC.
+static
+void adapt_ain_max(struct rdcache_s* cache, struct cache_entry_s* ghost)
+{
+  unsigned int from_am = cache->aout_from_am;
+  unsigned int from_ain = cache->aout_current - from_am;
+  unsigned int delta;
+
+  if( ghost->ghost_from_am ) {
+    delta = (from_am > 0 && from_ain > from_am) ? from_ain / from_am : 1;
+    if( cache->ain_max > cache->ain_min + delta )
+      cache->ain_max -= delta;
+    else
+      cache->ain_max = cache->ain_min;
+  } else {
+    delta = (from_ain > 0 && from_am > from_ain) ? from_am / from_ain : 1;
+    if( cache->ain_max + delta < cache->ain_limit )
+      cache->ain_max += delta;
+    else
+      cache->ain_max = cache->ain_limit;
+  }
+}
+
 static
 void aout_evict(struct rdcache_s* cache)
 {
@@ -1319,6 +1724,8 @@ void aout_evict(struct rdcache_s* cache)
   // Remove the tail element from Aout
   DOUBLE_REMOVE_TAIL(cache, aout);
   cache->aout_current--;
+  if( z->ghost_from_am ) cache->aout_from_am--;
+  chpl_comm_diags_incr(cache_aout_evictions);
 
   // Remove entry (which we are kicking off of Aout) from the tree
   tree_remove(cache, z);
@@ -1371,13 +1778,16 @@ void ain_evict(struct rdcache_s* cache,
     // immediately wait for them to complete, before we modify the contents
     // of Ain in any way (or reuse the associated page).
     flush_entry(cache, task_local, y, FLUSH_EVICT, 0, CACHEPAGE_SIZE);
+    callsite_add(task_local->callsite, evictions, 1);
     assert(y->entryReservedByTask == task_local);
     assert(y->queue == QUEUE_AIN && y == cache->ain_tail);
 
     DOUBLE_REMOVE_TAIL(cache, ain);
     cache->ain_current--;
+    chpl_comm_diags_incr(cache_ain_evictions);
 
     y->queue = QUEUE_AOUT;
+    y->ghost_from_am = 0;
 
     // Since we are kicking entry off of Ain, we have to add it to Aout.
     DOUBLE_PUSH_HEAD(cache, y, aout);
@@ -1431,11 +1841,32 @@ void am_evict(struct rdcache_s *cache,
     // immediately wait for them to complete, before we modify the contents
     // of Ain in any way (or reuse the associated page).
     flush_entry(cache, task_local, y, FLUSH_EVICT, 0, CACHEPAGE_SIZE);
+    callsite_add(task_local->callsite, evictions, 1);
     assert(y->entryReservedByTask == task_local);
     assert(y->queue == QUEUE_AM && y == cache->am_lru_tail);
 
     DOUBLE_REMOVE_TAIL(cache, am_lru);
     cache->am_current--;
+    chpl_comm_diags_incr(cache_am_evictions);
+
+    if( adaptive_2q ) {
+      // Remember y in Aout, so that if it is used again soon we
+      // know that Am was too small (see adapt_ain_max).
+      y->queue = QUEUE_AOUT;
+      y->ghost_from_am = 1;
+      DOUBLE_PUSH_HEAD(cache, y, aout);
+      cache->aout_current++;
+      cache->aout_from_am++;
+
+      // "unlock" entry y
+      unreserve_entry(cache, task_local, y);
+
+      if( cache->aout_current > cache->aout_max ) {
+        // Remove the tail element from aout.
+        aout_evict(cache);
+      }
+      return;
+    }
 
     // Remove this entry in Am from the pointer tree.
     tree_remove(cache, y);
@@ -1580,6 +2011,20 @@ struct dirty_entry_s* allocate_dirty(struct rdcache_s* cache,
   return dirty;
 }
 
+// Remove the dirty structure from the entry and put it back on
+// its free list. This has the effect of clearing the dirty bits.
+static void release_dirty(struct rdcache_s* cache, struct cache_entry_s* entry)
+{
+  struct dirty_entry_s* dirty = entry->dirty;
+
+  DOUBLE_REMOVE(cache, dirty, dirty_lru);
+  dirty->entry = NULL;
+  entry->dirty = NULL;
+  DOUBLE_PUSH_TAIL(cache, dirty, dirty_lru);
+  // ... and decrement the number of dirty pages.
+  cache->num_dirty_pages--;
+}
+
 static void use_dirty(struct rdcache_s* cache, struct dirty_entry_s* dirty)
 {
   DOUBLE_REMOVE(cache, dirty, dirty_lru);
@@ -1590,11 +2035,21 @@ static void use_dirty(struct rdcache_s* cache, struct dirty_entry_s* dirty)
 static
 void do_wait_for(struct rdcache_s* cache, cache_seqn_t sn);
 
+static
+chpl_cache_taskPrvData_t* task_private_cache_data(void);
+
 static inline
 void wait_for(struct rdcache_s* cache, cache_seqn_t sn)
 {
   // Do nothing if we have already completed sn.
   if( sn <= cache->completed_request_number ) return;
+  if( callsite_stats_enabled ) {
+    struct chpl_cache_callsite_s* cs = task_private_cache_data()->callsite;
+    uint64_t start = callsite_now_ns();
+    do_wait_for(cache, sn);
+    callsite_add(cs, wait_ns, callsite_now_ns() - start);
+    return;
+  }
   do_wait_for(cache, sn);
 }
 
@@ -2008,6 +2463,7 @@ void flush_entry(struct rdcache_s* cache,
   uintptr_t num_lines, skip_lines;
   chpl_comm_nb_handle_t handle;
   uintptr_t got_skip, got_len;
+  int unused;
 
   assert(entry->entryReservedByTask == task_local);
 
@@ -2076,12 +2532,7 @@ void flush_entry(struct rdcache_s* cache,
         }
         // Now remove the dirty structure and put it back on its free list.
         // This has the effect of clearing the dirty bits.
-        DOUBLE_REMOVE(cache, dirty, dirty_lru);
-        dirty->entry = NULL;
-        entry->dirty = NULL;
-        DOUBLE_PUSH_TAIL(cache, dirty, dirty_lru);
-        // ... and decrement the number of dirty pages.
-        cache->num_dirty_pages--;
+        release_dirty(cache, entry);
       }
     }
   }
@@ -2091,7 +2542,12 @@ void flush_entry(struct rdcache_s* cache,
   if( op & FLUSH_DO_PENDING ) {
     // If there is a pending put sequence number not completed, we must
     // wait for it now (since we don't know which region it corresponded to).
-    wait_for(cache, entry->max_put_sequence_number);
+    if( entry->max_put_sequence_number != NO_SEQUENCE_NUMBER ) {
+      wait_for(cache, entry->max_put_sequence_number);
+      entry->max_put_sequence_number = NO_SEQUENCE_NUMBER;
+      // The shared tier might have lines from before these PUTs landed.
+      shared_note_writes();
+    }
 
     // If the previously valid cache lines overlap with the
     // request, we must wait for them now.
@@ -2109,13 +2565,21 @@ void flush_entry(struct rdcache_s* cache,
       entry->max_put_sequence_number = NO_SEQUENCE_NUMBER;
       entry->max_prefetch_sequence_number = NO_SEQUENCE_NUMBER;
       memset(entry->valid_lines, 0, CACHE_LINES_PER_PAGE_BITMASK_WORDS*sizeof(uint64_t));
+      unused = take_valid_lines(entry->stride_lines, 0, CACHE_LINES_PER_PAGE);
     } else {
       unset_valid_lines(entry->valid_lines, skip_lines, num_lines);
+      unused = take_valid_lines(entry->stride_lines, skip_lines, num_lines);
     }
+    if (unused)
+      chpl_comm_diags_add(cache_stride_prefetch_unused, unused);
   }
 
   // If evicting, remove the page from the cache and put it on a free list.
   if( op & FLUSH_DO_EVICT ) {
+    unused = take_valid_lines(entry->stride_lines, 0, CACHE_LINES_PER_PAGE);
+    if (unused)
+      chpl_comm_diags_add(cache_stride_prefetch_unused, unused);
+
     // But, our entry no longer can have a page associated with it.
     page = entry->page;
     entry->page = NULL;
@@ -2190,9 +2654,14 @@ struct cache_entry_s* make_entry(struct rdcache_s* tree,
     assert(bottom_match->queue == QUEUE_AOUT);
 
     DEBUG_PRINT(("%d: Found %p in Aout\n", chpl_nodeID, (void*) raddr));
+    if( adaptive_2q )
+      adapt_ain_max(tree, bottom_match);
+    chpl_comm_diags_incr(cache_am_promotions);
     // add X to the head of Am
     DOUBLE_REMOVE(tree, bottom_match, aout);
     tree->aout_current--;
+    if( bottom_match->ghost_from_am ) tree->aout_from_am--;
+    bottom_match->ghost_from_am = 0;
     DOUBLE_PUSH_HEAD(tree, bottom_match, am_lru);
     tree->am_current++;
 
@@ -2204,6 +2673,7 @@ struct cache_entry_s* make_entry(struct rdcache_s* tree,
     bottom_match->page = page;
     // Clear the valid lines
     memset(&bottom_match->valid_lines, 0, sizeof(uint64_t)*CACHE_LINES_PER_PAGE_BITMASK_WORDS);
+    memset(&bottom_match->stride_lines, 0, sizeof(uint64_t)*CACHE_LINES_PER_PAGE_BITMASK_WORDS);
     // Clear the dirty pointer and sequence numbers.
     bottom_match->dirty = NULL;
     bottom_match->min_sequence_number = NO_SEQUENCE_NUMBER;
@@ -2225,6 +2695,7 @@ struct cache_entry_s* make_entry(struct rdcache_s* tree,
     bottom_tmp->base.next = NULL;
 
     bottom_tmp->queue = QUEUE_AIN;
+    bottom_tmp->ghost_from_am = 0;
     bottom_tmp->entryReservedByTask = NULL;
     bottom_tmp->readahead_skip = 0;
     bottom_tmp->readahead_len = 0;
@@ -2233,6 +2704,7 @@ struct cache_entry_s* make_entry(struct rdcache_s* tree,
     bottom_tmp->prev = NULL;
     bottom_tmp->page = page;
     memset(&bottom_tmp->valid_lines, 0, sizeof(uint64_t)*CACHE_LINES_PER_PAGE_BITMASK_WORDS);
+    memset(&bottom_tmp->stride_lines, 0, sizeof(uint64_t)*CACHE_LINES_PER_PAGE_BITMASK_WORDS);
     bottom_tmp->dirty = NULL;
     bottom_tmp->min_sequence_number = NO_SEQUENCE_NUMBER;
     bottom_tmp->max_put_sequence_number = NO_SEQUENCE_NUMBER;
@@ -2685,6 +3157,7 @@ void cache_get_trigger_readahead(struct rdcache_s* cache,
                              chpl_nodeID, (int)chpl_task_getId(),
                              (void*) (prefetch_start), (void*) (prefetch_end)));
 
+      callsite_add(task_local->callsite, readaheads, 1);
       cache_get(cache, task_local,
                 /* addr */ NULL /* means prefetch */,
                 node, prefetch_start, prefetch_end - prefetch_start,
@@ -2818,6 +3291,8 @@ int cache_get_in_page(struct rdcache_s* cache,
   int entry_after_acquire;
   chpl_comm_nb_handle_t handle;
   uintptr_t readahead_len, readahead_skip;
+  int stride_hits;
+  int stride_lines;
 
   isprefetch = (addr == NULL);
 
@@ -2911,6 +3386,14 @@ int cache_get_in_page(struct rdcache_s* cache,
       // Copy the data out.
       chpl_memcpy(addr, entry->page + (raddr-ra_page), size);
 
+      // Count lines that are being read for the first time after
+      // the stride prefetcher brought them in.
+      stride_hits = take_valid_lines(entry->stride_lines,
+                                     (ra_line - ra_page) >> CACHELINE_BITS,
+                                     (ra_line_end - ra_line) >> CACHELINE_BITS);
+      if (stride_hits)
+        chpl_comm_diags_add(cache_stride_prefetch_hits, stride_hits);
+
 #ifdef DUMP
       {
         // printing out gotten data for debug
@@ -2987,12 +3470,20 @@ int cache_get_in_page(struct rdcache_s* cache,
                (int) chpl_nodeID, page+(ra_line-ra_page), node, (void*) ra_line,
                (int) (ra_line_end - ra_line)));
 
-  // Note: chpl_comm_get_nb could cause a different task body to run.
-  // That should be OK because we marked entry as "reserved".
-  handle = chpl_comm_get_nb(entry->page + (ra_line-ra_page), /*local addr*/
-                            node, (void*) ra_line,
-                            ra_line_end - ra_line /*size*/,
-                            commID, ln, fn);
+  // Note: chpl_comm_get_nb and shared_get could cause a different task
+  // body to run. That should be OK because we marked entry as "reserved".
+  if (shared_tier_enabled() &&
+      shared_get(task_local, entry->page + (ra_line-ra_page),
+                 node, ra_page, ra_line, ra_line_end, isprefetch,
+                 commID, ln, fn)) {
+    // The lines are already in the page.
+    handle = NULL;
+  } else {
+    handle = chpl_comm_get_nb(entry->page + (ra_line-ra_page), /*local addr*/
+                              node, (void*) ra_line,
+                              ra_line_end - ra_line /*size*/,
+                              commID, ln, fn);
+  }
   if (EXTRA_YIELDS) {
     TRACE_YIELD_PRINT(("%d: task %d cache %p yielding in cache_get_in_page "
                        "for chpl_comm_get_nb\n",
@@ -3012,6 +3503,21 @@ int cache_get_in_page(struct rdcache_s* cache,
                   (ra_line - ra_page) >> CACHELINE_BITS,
                   (ra_line_end - ra_line) >> CACHELINE_BITS);
 
+  // Any stride-prefetched lines we just fetched again went unused;
+  // if this GET is itself a stride prefetch, remember its lines.
+  stride_lines = take_valid_lines(entry->stride_lines,
+                                  (ra_line - ra_page) >> CACHELINE_BITS,
+                                  (ra_line_end - ra_line) >> CACHELINE_BITS);
+  if (stride_lines)
+    chpl_comm_diags_add(cache_stride_prefetch_unused, stride_lines);
+  if (isprefetch && task_local->stride_prefetching) {
+    set_valid_lines(entry->stride_lines,
+                    (ra_line - ra_page) >> CACHELINE_BITS,
+                    (ra_line_end - ra_line) >> CACHELINE_BITS);
+    chpl_comm_diags_add(cache_stride_prefetches,
+                        (ra_line_end - ra_line) >> CACHELINE_BITS);
+  }
+
   if (!isprefetch) {
     // This will increment next request number so cache events are recorded.
     sn = cache->next_request_number;
@@ -3214,6 +3720,115 @@ int cache_get(struct rdcache_s* cache,
   return all_hits;
 }
 
+// Stride prefetching.
+//
+// The readahead above only notices accesses to adjacent lines and pages.
+// A task sweeping remote memory with a fixed stride larger than a cache
+// line (e.g. down a column of a row-major array) would take a demand
+// miss on every access. Like a hardware stride prefetcher, each task
+// remembers the address of its last demand GET and the stride between
+// its last two; once the same stride has been seen STRIDE_CONFIDENCE
+// times in a row, we start non-blocking GETs for the next
+// stride_prefetch_distance predicted addresses.
+//
+// Lines brought in this way are tracked in entry->stride_lines so that
+// the comm diagnostics can report how many were later read
+// (cache_stride_prefetch_hits) and how many were evicted, invalidated
+// or refetched first (cache_stride_prefetch_unused). All three stride
+// counters are in units of cache lines.
+#define STRIDE_CONFIDENCE 2
+#define DEFAULT_STRIDE_PREFETCH_DISTANCE 4
+#define MAX_STRIDE_PREFETCH_DISTANCE 32
+
+static int stride_prefetch_distance = DEFAULT_STRIDE_PREFETCH_DISTANCE;
+
+static
+void cache_stride_prefetch(struct rdcache_s* cache,
+                           chpl_cache_taskPrvData_t* task_local,
+                           c_nodeid_t node, raddr_t raddr, size_t size,
+                           int32_t commID, int ln, int32_t fn)
+{
+  intptr_t stride;
+  raddr_t request_page, pf_raddr;
+  size_t page_size;
+  int k;
+
+  if (stride_prefetch_distance == 0) return;
+
+  if (task_local->stride_node != node || task_local->stride_last_raddr == 0) {
+    // Start tracking a new stream.
+    task_local->stride_node = node;
+    task_local->stride_last_raddr = raddr;
+    task_local->stride = 0;
+    task_local->stride_confidence = 0;
+    task_local->stride_prefetched = 0;
+    return;
+  }
+
+  stride = (intptr_t) (raddr - task_local->stride_last_raddr);
+  task_local->stride_last_raddr = raddr;
+
+  // Repeated accesses to the same address don't break the pattern.
+  if (stride == 0) return;
+
+  if (stride != task_local->stride) {
+    task_local->stride = stride;
+    task_local->stride_confidence = 0;
+    task_local->stride_prefetched = 0;
+    return;
+  }
+
+  if (task_local->stride_confidence < STRIDE_CONFIDENCE)
+    task_local->stride_confidence++;
+  if (task_local->stride_confidence < STRIDE_CONFIDENCE) return;
+
+  // Strides of up to a line are sequential access, which the cache
+  // lines and the readahead machinery already handle.
+  if (stride <= CACHELINE_SIZE && stride >= -CACHELINE_SIZE) return;
+
+  page_size = sys_page_size();
+  request_page = round_down_to_mask(raddr, page_size-1);
+
+  task_local->stride_prefetching = 1;
+  for (k = 1; k <= stride_prefetch_distance; k++) {
+    pf_raddr = raddr + k * stride;
+
+    // Stop on address wrap-around.
+    if ((stride > 0) != (pf_raddr > raddr)) break;
+
+    // Skip addresses an earlier access already prefetched.
+    if (task_local->stride_prefetched != 0) {
+      if (stride > 0 && pf_raddr <= task_local->stride_prefetched) continue;
+      if (stride < 0 && pf_raddr >= task_local->stride_prefetched) continue;
+    }
+
+    // Don't overwhelm the pending operation queue.
+    if (fifo_circleb_count(cache->pending_first_entry,
+                           cache->pending_last_entry,
+                           cache->pending_len) > cache->pending_len / 2)
+      break;
+
+    // As with readahead, only prefetch memory we know is gettable,
+    // or else memory on the same system page as the request.
+    if (chpl_task_guardPagesInUse() ||
+        !chpl_comm_addr_gettable(node, (void*) pf_raddr, size)) {
+      if (round_down_to_mask(pf_raddr, page_size-1) != request_page ||
+          round_down_to_mask(pf_raddr+size-1, page_size-1) != request_page)
+        break;
+    }
+
+    TRACE_READAHEAD_PRINT(("%d: task %d stride prefetch %p stride %ld\n",
+                           chpl_nodeID, (int)chpl_task_getId(),
+                           (void*) pf_raddr, (long) stride));
+
+    // note: can yield
+    cache_get(cache, task_local, /* addr */ NULL /* means prefetch */,
+              node, pf_raddr, size, 0, commID, ln, fn);
+    task_local->stride_prefetched = pf_raddr;
+  }
+  task_local->stride_prefetching = 0;
+}
+
 // This is intended to match cache_get but
 //  * it will never prefetch
 //  * it doesn't actually GET; just memsets to 0 instead.
@@ -3506,11 +4121,107 @@ void cache_invalidate(struct rdcache_s* cache,
   }
 }
 
+#ifdef HAS_CHPL_COMM_BUFFERED_PUT_UNORDERED
+// Sort order for write combining: by node, then by remote address.
+static
+int compare_entries_by_raddr(const void* a, const void* b)
+{
+  const struct cache_entry_s* x = *(struct cache_entry_s* const*) a;
+  const struct cache_entry_s* y = *(struct cache_entry_s* const*) b;
+
+  if (x->base.node != y->base.node)
+    return (x->base.node < y->base.node) ? -1 : 1;
+  if (x->base.raddr != y->base.raddr)
+    return (x->base.raddr < y->base.raddr) ? -1 : 1;
+  return 0;
+}
+
+// Start PUTs for all of the dirty pages at once, instead of one entry
+// at a time as flush_entry does. Small dirty regions are handed to
+// chpl_comm_put_unordered(), which on this comm layer buffers them and
+// initiates them together as a batch, so many tiny scattered writes
+// cost about one injection each instead of one round trip each. The
+// regions are issued sorted by node and address, so that dirty regions
+// that are contiguous across adjacent pages go out back to back.
+//
+// Each entry stays reserved until the buffered PUTs have been completed
+// by the task fence, so that no other task on this pthread can read or
+// overwrite those bytes in the meantime. Entries reserved by other tasks
+// are left for the caller's per-entry loop.
+static
+void cache_clean_dirty_combined(struct rdcache_s* cache,
+                                chpl_cache_taskPrvData_t* task_local)
+{
+  struct dirty_entry_s* cur;
+  int n = 0;
+  int any_unordered = 0;
+  int i;
+
+  // Gather and reserve the dirty entries. This loop cannot yield.
+  for( cur = cache->dirty_lru_head; cur && cur->entry; cur = cur->next ) {
+    if (try_reserve_entry(cache, task_local, cur->entry)) {
+      assert(n < cache->max_dirty_pages);
+      cache->combine_entries[n++] = cur->entry;
+    }
+  }
+
+  if (n == 0) return;
+
+  qsort(cache->combine_entries, n, sizeof(struct cache_entry_s*),
+        compare_entries_by_raddr);
+
+  for( i = 0; i < n; i++ ) {
+    struct cache_entry_s* entry = cache->combine_entries[i];
+    uint64_t* dirty_bits = entry->dirty->dirty;
+    unsigned char* page = entry->page;
+    uintptr_t start = 0;
+    uintptr_t got_skip, got_len;
+
+    assert(page && entry->entryReservedByTask == task_local);
+
+    while( get_skip_len_for_valids(dirty_bits, start, &got_skip, &got_len,
+                                   CACHEPAGE_BITMASK_WORDS) ) {
+      if (got_len <= MAX_COMBINED_PUT_BYTES) {
+        chpl_comm_put_unordered(page+got_skip, entry->base.node,
+                                (void*)(entry->base.raddr+got_skip),
+                                got_len, CHPL_COMM_UNKNOWN_ID, -1, 0);
+        any_unordered = 1;
+      } else {
+        chpl_comm_nb_handle_t handle;
+        // Note: chpl_comm_put_nb, pending_push can yield
+        handle = chpl_comm_put_nb(page+got_skip, entry->base.node,
+                                  (void*)(entry->base.raddr+got_skip),
+                                  got_len, CHPL_COMM_UNKNOWN_ID, -1, 0);
+        entry->max_put_sequence_number = pending_push(cache, handle);
+      }
+      start = got_skip + got_len;
+    }
+  }
+
+  // Initiate and complete the buffered PUTs.
+  if (any_unordered) {
+    chpl_comm_getput_unordered_task_fence();
+    shared_note_writes();
+  }
+
+  for( i = 0; i < n; i++ ) {
+    struct cache_entry_s* entry = cache->combine_entries[i];
+    release_dirty(cache, entry);
+    unreserve_entry(cache, task_local, entry);
+  }
+}
+#endif
+
 static
 void cache_clean_dirty(struct rdcache_s* cache,
                        chpl_cache_taskPrvData_t* task_local)
 {
 
+#ifdef HAS_CHPL_COMM_BUFFERED_PUT_UNORDERED
+  if (ENABLE_WRITE_COMBINING)
+    cache_clean_dirty_combined(cache, task_local);
+#endif
+
   while (1) {
     struct dirty_entry_s* cur;
     struct cache_entry_s* victim;
@@ -3609,6 +4320,137 @@ void chpl_cache_do_init(void)
   }
 }
 
+static
+void shared_tier_init(void)
+{
+  int64_t n = chpl_env_rt_get_int("CACHE_SHARED_PAGES", 0);
+  int i;
+
+  atomic_init_uint_least64_t(&shared_epoch, 0);
+  atomic_init_uint_least64_t(&shared_write_gen, 0);
+
+  if (n <= 0)
+    return;
+
+  if (n > MAX_CACHE_PAGES)
+    n = MAX_CACHE_PAGES;
+  // round down to a power of 2
+  shared_num_pages = 1;
+  while (2 * (int64_t) shared_num_pages <= n)
+    shared_num_pages *= 2;
+
+  shared_slots = (struct shared_slot_s*)
+                 chpl_calloc(shared_num_pages, sizeof(struct shared_slot_s));
+  if (shared_slots == NULL)
+    chpl_internal_error("could not allocate the shared remote cache");
+  for (i = 0; i < shared_num_pages; i++) {
+    atomic_init_bool(&shared_slots[i].busy, false);
+    shared_slots[i].page = (unsigned char*) chpl_malloc(CACHEPAGE_SIZE);
+    if (shared_slots[i].page == NULL)
+      chpl_internal_error("could not allocate the shared remote cache");
+  }
+
+  if (chpl_nodeID == 0 && chpl_env_rt_get_bool("CACHE_VERBOSE", false)) {
+    printf("remote cache shared tier: %d pages of %d bytes\n",
+           shared_num_pages, CACHEPAGE_SIZE);
+  }
+}
+
+// Returns floor(log2(v)) for v > 0.
+static
+int cache_floor_log2(size_t v)
+{
+  int bits = 0;
+  while ((v >> 1) != 0) {
+    v >>= 1;
+    bits++;
+  }
+  return bits;
+}
+
+// Reads a power-of-2 size (in bytes) from a CHPL_RT_* environment variable
+// and returns its log2, clamped to [min_bits, max_bits]. Warns about values
+// that had to be adjusted.
+static
+int cache_env_size_bits(const char* ev, int dflt_bits,
+                        int min_bits, int max_bits)
+{
+  size_t sz = chpl_env_rt_get_size(ev, ((size_t) 1) << dflt_bits);
+  int bits;
+
+  if (sz == 0)
+    return dflt_bits;
+
+  bits = cache_floor_log2(sz);
+  if (bits < min_bits) bits = min_bits;
+  if (bits > max_bits) bits = max_bits;
+
+  if (sz != ((size_t) 1) << bits && chpl_nodeID == 0) {
+    char msg[128];
+    snprintf(msg, sizeof(msg),
+             "CHPL_RT_%s=%zu is not supported; using %zu", ev, sz,
+             ((size_t) 1) << bits);
+    chpl_warning(msg, 0, 0);
+  }
+
+  return bits;
+}
+
+// Choose the cache geometry. This must run before any cache is created
+// since cache_create() and all of the cache operations rely on it.
+static
+void cache_init_geometry(void)
+{
+  int64_t pages;
+  int64_t prefetch_pages;
+  int page_bits;
+  int max_page_bits = MAX_CACHEPAGE_BITS;
+
+  // A cache page should not be larger than a system page
+  // (see the readahead code's handling of ungettable addresses).
+  if (sys_page_size() > 0) {
+    page_bits = cache_floor_log2(sys_page_size());
+    if (page_bits < max_page_bits)
+      max_page_bits = page_bits;
+  }
+
+  cachepage_bits = cache_env_size_bits("CACHE_PAGE_SIZE",
+                                       DEFAULT_CACHEPAGE_BITS,
+                                       MIN_CACHEPAGE_BITS, max_page_bits);
+  cacheline_bits = cache_env_size_bits("CACHE_LINE_SIZE",
+                                       DEFAULT_CACHELINE_BITS,
+                                       MIN_CACHELINE_BITS, cachepage_bits);
+
+  pages = chpl_env_rt_get_int("CACHE_PAGES", DEFAULT_CACHE_PAGES);
+  if (pages < MIN_CACHE_PAGES) pages = MIN_CACHE_PAGES;
+  if (pages > MAX_CACHE_PAGES) pages = MAX_CACHE_PAGES;
+  // The lookup table sizing requires a power of 2.
+  cache_num_pages = 1 << cache_floor_log2((size_t) pages);
+
+  prefetch_pages = chpl_env_rt_get_int("CACHE_PREFETCH_PAGES",
+                                       DEFAULT_MAX_PAGES_PER_PREFETCH);
+  if (prefetch_pages < 1) prefetch_pages = 1;
+  if (prefetch_pages > MAX_MAX_PAGES_PER_PREFETCH)
+    prefetch_pages = MAX_MAX_PAGES_PER_PREFETCH;
+  // Don't let the readahead window take over a small cache.
+  if (prefetch_pages > cache_num_pages / 16)
+    prefetch_pages = cache_num_pages / 16;
+  max_pages_per_prefetch = (int) prefetch_pages;
+
+  assert(CACHEPAGE_BITMASK_WORDS <= MAX_CACHEPAGE_BITMASK_WORDS);
+  assert(CACHE_LINES_PER_PAGE_BITMASK_WORDS <=
+         MAX_CACHE_LINES_PER_PAGE_BITMASK_WORDS);
+
+  if (chpl_nodeID == 0 && chpl_env_rt_get_bool("CACHE_VERBOSE", false)) {
+    printf("remote cache geometry: %d pages of %d bytes, "
+           "%d-byte lines, %d-page prefetch, %zu bytes of data per pthread\n",
+           cache_num_pages, CACHEPAGE_SIZE, CACHELINE_SIZE,
+           max_pages_per_prefetch,
+           (size_t) cache_num_pages * (size_t) CACHEPAGE_SIZE);
+    fflush(stdout);
+  }
+}
+
 // The implementation of functions in chpl-cache.h
 
 void chpl_cache_init(void) {
@@ -3618,6 +4460,18 @@ void chpl_cache_init(void) {
   }
 
   //printf("CACHE IS ENABLED\n");
+  cache_init_geometry();
+  callsite_init();
+  shared_tier_init();
+  adaptive_2q = chpl_env_rt_get_bool("CACHE_ADAPTIVE_2Q", false);
+
+  stride_prefetch_distance =
+    (int) chpl_env_rt_get_int("CACHE_STRIDE_PREFETCH_DISTANCE",
+                              DEFAULT_STRIDE_PREFETCH_DISTANCE);
+  if (stride_prefetch_distance < 0)
+    stride_prefetch_distance = 0;
+  if (stride_prefetch_distance > MAX_STRIDE_PREFETCH_DISTANCE)
+    stride_prefetch_distance = MAX_STRIDE_PREFETCH_DISTANCE;
   chpl_cache_do_init();
 }
 
@@ -3636,6 +4490,8 @@ void chpl_cache_fence(int acquire, int release, int ln, int32_t fn)
 
     INFO_PRINT(("%i fence acquire %i release %i %s:%i\n", chpl_nodeID, acquire, release, fn, ln));
 
+    task_local->callsite = callsite_lookup(ln, fn);
+
     TRACE_FENCE_PRINT(("%d: task %d in chpl_cache_fence(acquire=%i,release=%i)"
                        " on cache %p from %s:%d\n",
                        chpl_nodeID, (int) chpl_task_getId(), acquire, release,
@@ -3649,6 +4505,9 @@ void chpl_cache_fence(int acquire, int release, int ln, int32_t fn)
     if( acquire ) {
       task_local->last_acquire = cache->next_request_number;
       cache->next_request_number++;
+      if (shared_tier_enabled())
+        task_local->shared_acquire_epoch =
+          atomic_fetch_add_uint_least64_t(&shared_epoch, 1) + 1;
     }
 
     if( release ) {
@@ -3675,6 +4534,7 @@ void chpl_cache_invalidate(c_nodeid_t node, void* raddr, size_t size,
                chpl_lookupFilename(fn), ln,
                (int)size, node, raddr, addr));
 
+  task_local->callsite = callsite_lookup(ln, fn);
   cache_invalidate(cache, task_local, node, (raddr_t)raddr, size);
 }
 
@@ -3695,9 +4555,12 @@ void chpl_cache_comm_put(void* addr, c_nodeid_t node, void* raddr,
   chpl_cache_taskPrvData_t* task_local = task_private_cache_data();
   int all_hits;
 
+  task_local->callsite = callsite_lookup(ln, fn);
+
   if (size_merits_direct_comm(cache, size)) {
     cache_invalidate(cache, task_local, node, (raddr_t)raddr, size);
     chpl_comm_put(addr, node, raddr, size, commID, ln, fn);
+    shared_note_writes();
     if (EXTRA_YIELDS) {
       TRACE_YIELD_PRINT(("%d: task %d cache %p yielding for chpl_comm_put\n",
                          chpl_nodeID, (int) chpl_task_getId(), cache));
@@ -3724,10 +4587,13 @@ void chpl_cache_comm_put(void* addr, c_nodeid_t node, void* raddr,
                        commID, ln, fn);
 
   if (size != 0) {
-    if (all_hits)
+    if (all_hits) {
       chpl_comm_diags_incr(cache_put_hits);
-    else
+      callsite_add(task_local->callsite, hits, 1);
+    } else {
       chpl_comm_diags_incr(cache_put_misses);
+      callsite_add(task_local->callsite, misses, 1);
+    }
   }
 
   return;
@@ -3741,6 +4607,8 @@ void chpl_cache_comm_get(void *addr, c_nodeid_t node, void* raddr,
   chpl_cache_taskPrvData_t* task_local = task_private_cache_data();
   int all_hits;
 
+  task_local->callsite = callsite_lookup(ln, fn);
+
   if (size_merits_direct_comm(cache, size)) {
     cache_invalidate(cache, task_local, node, (raddr_t)raddr, size);
     chpl_comm_get(addr, node, raddr, size, commID, ln, fn);
@@ -3770,10 +4638,16 @@ void chpl_cache_comm_get(void *addr, c_nodeid_t node, void* raddr,
                        0, commID, ln, fn);
 
   if (size != 0) {
-    if (all_hits)
+    if (all_hits) {
       chpl_comm_diags_incr(cache_get_hits);
-    else
+      callsite_add(task_local->callsite, hits, 1);
+    } else {
       chpl_comm_diags_incr(cache_get_misses);
+      callsite_add(task_local->callsite, misses, 1);
+    }
+
+    cache_stride_prefetch(cache, task_local, node, (raddr_t)raddr, size,
+                          commID, ln, fn);
   }
 
   return;
@@ -3789,6 +4663,8 @@ void chpl_cache_comm_prefetch(c_nodeid_t node, void* raddr,
 
   chpl_comm_diags_verbose_rdma("prefetch", node, size, ln, fn, commID);
 
+  task_local->callsite = callsite_lookup(ln, fn);
+
   // Always use the cache for prefetches.
   cache_get(cache, task_local,
             /* addr */ NULL, node, (raddr_t)raddr, size,
@@ -3834,6 +4710,7 @@ void strd_invalidate(void *addr, void *dststr, c_nodeid_t node,
   struct cache_strd_callback_ctx ctx;
   ctx.cache = cache;
   ctx.task_local = task_local;
+  task_local->callsite = callsite_lookup(ln, fn);
   strd_common_call(addr, dststr, node,
                    raddr, srcstr, count, strlevels, elemSize,
                    &ctx, &strd_invalidate_fn, commID, ln, fn);
@@ -3902,6 +4779,7 @@ void chpl_cache_comm_put_strd(void *addr, void *dststr, c_nodeid_t node,
   // do the strided put.
   chpl_comm_put_strd(addr, dststr, node, raddr, srcstr, count, strlevels,
                      elemSize, commID, ln, fn);
+  shared_note_writes();
   if (EXTRA_YIELDS) {
 #ifdef TRACE_YIELDS
     struct rdcache_s* cache = tls_cache_remote_data();
@@ -3981,6 +4859,7 @@ void chpl_cache_comm_getput_unordered(c_nodeid_t dstnode, void* dstaddr,
 void chpl_cache_comm_getput_unordered_task_fence(void)
 {
   chpl_comm_getput_unordered_task_fence();
+  shared_note_writes();
 }
 
 // This is for debugging.
@@ -4055,18 +4934,89 @@ void chpl_cache_print_stats(void) {
 
   printf("%d: task %d cache statistics "
          "ain=%i/%i "
-         "aout=%i/%i am=%i "
+         "aout=%i/%i (%i from am) am=%i "
          "table=(%i lists/%i full/%i used/%i slots and %i/%i sub-slots) "
          "entries=%i/%i\n",
          chpl_nodeID, (int) chpl_task_getId(),
          cache->ain_current, cache->ain_max,
-         cache->aout_current, cache->aout_max,
+         cache->aout_current, cache->aout_max, cache->aout_from_am,
          cache->am_current,
          n_colliding_slots, n_full_slots, n_used_slots, table_slots,
          n_full_subslots, n_subslots,
          n_bottom_entries, cache->max_entries);
 }
 
+void chpl_cache_print_callsite_stats(void)
+{
+  struct chpl_cache_callsite_s** sorted;
+  int n = 0;
+  int i;
+
+  if (!callsite_stats_enabled)
+    return;
+
+  sorted = (struct chpl_cache_callsite_s**)
+           chpl_malloc((CALLSITE_TABLE_SIZE + 1) * sizeof(*sorted));
+  if (sorted == NULL)
+    return;
+
+  for (i = 0; i < CALLSITE_TABLE_SIZE; i++) {
+    if (atomic_load_uint_least64_t(&callsite_table[i].key) != 0)
+      sorted[n++] = &callsite_table[i];
+  }
+  if (atomic_load_uint_least64_t(&callsite_overflow.hits) != 0 ||
+      atomic_load_uint_least64_t(&callsite_overflow.misses) != 0)
+    sorted[n++] = &callsite_overflow;
+
+  qsort(sorted, n, sizeof(*sorted), compare_callsites);
+
+  printf("%d: remote cache statistics by callsite\n", chpl_nodeID);
+  printf("%d: %12s %12s %12s %12s %12s  %s\n", chpl_nodeID,
+         "hits", "misses", "readaheads", "evictions", "wait (us)",
+         "callsite");
+  for (i = 0; i < n; i++) {
+    struct chpl_cache_callsite_s* cs = sorted[i];
+    uint64_t key = atomic_load_uint_least64_t(&cs->key) - 1;
+    char where[256];
+
+    if (cs == &callsite_overflow)
+      snprintf(where, sizeof(where), "(other callsites)");
+    else
+      snprintf(where, sizeof(where), "%s:%d",
+               chpl_lookupFilename((int32_t) (key >> 32)),
+               (int) (uint32_t) key);
+
+    printf("%d: %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64
+           " %12" PRIu64 "  %s\n",
+           chpl_nodeID,
+           atomic_load_uint_least64_t(&cs->hits),
+           atomic_load_uint_least64_t(&cs->misses),
+           atomic_load_uint_least64_t(&cs->readaheads),
+           atomic_load_uint_least64_t(&cs->evictions),
+           atomic_load_uint_least64_t(&cs->wait_ns) / 1000,
+           where);
+  }
+  fflush(stdout);
+
+  chpl_free(sorted);
+}
+
+void chpl_cache_reset_callsite_stats(void)
+{
+  int i;
+
+  if (!callsite_stats_enabled)
+    return;
+
+#define _CALLSITE_RESET(csv) atomic_store_uint_least64_t(&cs->csv, 0);
+  for (i = 0; i <= CALLSITE_TABLE_SIZE; i++) {
+    struct chpl_cache_callsite_s* cs =
+      (i < CALLSITE_TABLE_SIZE) ? &callsite_table[i] : &callsite_overflow;
+    CHPL_CACHE_CALLSITE_VARS_ALL(_CALLSITE_RESET)
+  }
+#undef _CALLSITE_RESET
+}
+
 // Returns 1 if the data was already cached
 int chpl_cache_mock_get(c_nodeid_t node, uint64_t raddr, size_t size)
 {
@@ -28,12 +28,20 @@
 #include "chpl-comm.h"
 #include "chpl-comm-diags.h"
 #include "chpl-comm-internal.h"
+#include "chpl-env.h"
+#include "chpl-linefile-support.h"
+#include "chpl-mem.h"
 #include "chpl-mem-consistency.h"
+#include "chpltimers.h"
 #include "error.h"
 
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 int chpl_verbose_comm = 0;
 int chpl_verbose_comm_stacktrace = 0;
@@ -42,6 +50,8 @@ int chpl_comm_diags_print_unstable = 0;
 
 atomic_int_least16_t chpl_comm_diags_disable_flag;
 chpl_atomic_commDiagnostics chpl_comm_diags_counters;
+chpl_atomic_commDiagsHists chpl_comm_diags_hists;
+atomic_uint_least64_t* chpl_comm_diags_traffic;
 
 static pthread_once_t bcastPrintUnstable_once = PTHREAD_ONCE_INIT;
 
@@ -71,6 +81,7 @@ void chpl_comm_startVerbose(chpl_bool stacktrace, chpl_bool print_unstable) {
 
 void chpl_comm_stopVerbose() {
   chpl_verbose_comm = 0;
+  chpl_comm_diags_verbose_flush_aggregate();
   chpl_comm_diags_disable();
   chpl_comm_bcast_rt_private(chpl_verbose_comm);
   chpl_comm_diags_enable();
@@ -86,6 +97,7 @@ void chpl_comm_startVerboseHere(chpl_bool stacktrace, chpl_bool print_unstable)
 
 void chpl_comm_stopVerboseHere() {
   chpl_verbose_comm = 0;
+  chpl_comm_diags_verbose_flush_aggregate();
 }
 
 
@@ -143,3 +155,227 @@ void chpl_comm_resetDiagnosticsHere() {
 void chpl_comm_getDiagnosticsHere(chpl_commDiagnostics *cd) {
   chpl_comm_diags_copy(cd);
 }
+
+
+void chpl_comm_getDiagsHistsHere(chpl_commDiagsHists *cdh) {
+#define _COMM_DIAGS_HIST_COPY(h)                                        \
+  for (int i = 0; i < CHPL_COMM_DIAGS_HIST_BINS; i++)                   \
+    cdh->h[i] = atomic_load_uint_least64_t(&chpl_comm_diags_hists.h[i]);
+  CHPL_COMM_DIAGS_HISTS_ALL(_COMM_DIAGS_HIST_COPY);
+#undef _COMM_DIAGS_HIST_COPY
+}
+
+
+void chpl_comm_diags_init_traffic(void) {
+  if (chpl_comm_diags_traffic != NULL
+      || !chpl_env_rt_get_bool("COMM_DIAGS_TRAFFIC", false)) {
+    return;
+  }
+
+  chpl_comm_diags_traffic =
+    chpl_mem_allocMany(chpl_numNodes, sizeof(chpl_comm_diags_traffic[0]),
+                       CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0);
+  for (int i = 0; i < chpl_numNodes; i++) {
+    atomic_init_uint_least64_t(&chpl_comm_diags_traffic[i], 0);
+  }
+}
+
+
+void chpl_comm_getDiagsTrafficHere(uint64_t *bytes) {
+  for (int i = 0; i < chpl_numNodes; i++) {
+    bytes[i] = (chpl_comm_diags_traffic == NULL)
+               ? 0
+               : atomic_load_uint_least64_t(&chpl_comm_diags_traffic[i]);
+  }
+}
+
+
+void chpl_comm_diags_dump_csv(void) {
+  const char* prefix = chpl_env_rt_get("COMM_DIAGS_CSV", NULL);
+  if (prefix == NULL || prefix[0] == '\0') {
+    return;
+  }
+
+  char fname[FILENAME_MAX];
+  (void) snprintf(fname, sizeof(fname), "%s.%d.csv", prefix, chpl_nodeID);
+  FILE* f;
+  if ((f = fopen(fname, "w")) == NULL) {
+    char msg[FILENAME_MAX + 50];
+    (void) snprintf(msg, sizeof(msg),
+                    "cannot open comm diagnostics file \"%s\"", fname);
+    chpl_warning(msg, 0, 0);
+    return;
+  }
+
+  //
+  // One record per line: kind,name,index,value.  The index is the
+  // histogram bin for histograms, and the destination node for
+  // traffic, and empty for counters.
+  //
+  (void) fprintf(f, "kind,name,index,value\n");
+
+  chpl_commDiagnostics cd;
+  chpl_comm_diags_copy(&cd);
+#define _COMM_DIAGS_CSV(cdv) \
+  (void) fprintf(f, "counter,%s,,%" PRIu64 "\n", #cdv, cd.cdv);
+  CHPL_COMM_DIAGS_VARS_ALL(_COMM_DIAGS_CSV);
+#undef _COMM_DIAGS_CSV
+
+  chpl_commDiagsHists cdh;
+  chpl_comm_getDiagsHistsHere(&cdh);
+#define _COMM_DIAGS_HIST_CSV(h)                                         \
+  for (int i = 0; i < CHPL_COMM_DIAGS_HIST_BINS; i++)                   \
+    if (cdh.h[i] != 0)                                                  \
+      (void) fprintf(f, "hist,%s,%d,%" PRIu64 "\n", #h, i, cdh.h[i]);
+  CHPL_COMM_DIAGS_HISTS_ALL(_COMM_DIAGS_HIST_CSV);
+#undef _COMM_DIAGS_HIST_CSV
+
+  if (chpl_comm_diags_traffic != NULL) {
+    for (int i = 0; i < chpl_numNodes; i++) {
+      (void) fprintf(f, "traffic,bytes,%d,%" PRIu64 "\n", i,
+                     atomic_load_uint_least64_t(&chpl_comm_diags_traffic[i]));
+    }
+  }
+
+  (void) fclose(f);
+}
+
+
+//
+// Verbose comm sampling and per-callsite aggregation.
+//
+static pthread_once_t verboseSettings_once = PTHREAD_ONCE_INIT;
+static uint64_t verboseSampleEvery;
+static uint64_t verboseSampleNsecs;
+static chpl_bool verboseAggregate;
+
+static atomic_uint_least64_t verboseEventCount;
+static atomic_uint_least64_t verboseLastPrintNsecs;
+
+#define VERBOSE_AGG_TAB_SIZE 4096    // must be a power of 2
+
+typedef struct {
+  const char* op;
+  const char* kind;
+  int node;
+  int ln;
+  int32_t fn;
+  uint64_t count;
+  uint64_t bytes;
+} verboseAggEntry_t;
+
+static pthread_mutex_t verboseAggLock = PTHREAD_MUTEX_INITIALIZER;
+static verboseAggEntry_t verboseAggTab[VERBOSE_AGG_TAB_SIZE];
+static int verboseAggNumUsed;
+static uint64_t verboseAggDropped;
+
+
+static
+void verbose_settings_init(void) {
+  verboseSampleEvery = chpl_env_rt_get_uint("COMM_VERBOSE_SAMPLE", 0);
+  verboseSampleNsecs =
+    1000 * (uint64_t) chpl_env_rt_get_uint("COMM_VERBOSE_SAMPLE_USECS", 0);
+  verboseAggregate = chpl_env_rt_get_bool("COMM_VERBOSE_AGGREGATE", false);
+  atomic_init_uint_least64_t(&verboseEventCount, 0);
+  atomic_init_uint_least64_t(&verboseLastPrintNsecs, 0);
+}
+
+
+static inline
+uint64_t verbose_now_nsecs(void) {
+  return chpl_now_monotonic_ns();
+}
+
+
+static
+void verbose_aggregate(const char* op, const char* kind, int node,
+                       size_t size, int ln, int32_t fn) {
+  uint64_t h = ((uint64_t) (uintptr_t) op * 31
+                + (uint64_t) (uintptr_t) kind) * 31;
+  h = ((h + (uint64_t) node) * 31 + (uint64_t) ln) * 31 + (uint64_t) fn;
+  h ^= h >> 29;
+
+  if (pthread_mutex_lock(&verboseAggLock) != 0) {
+    chpl_internal_error("pthread_mutex_lock(&verboseAggLock) failed");
+  }
+
+  for (int i = 0; i < VERBOSE_AGG_TAB_SIZE; i++) {
+    verboseAggEntry_t* e = &verboseAggTab[(h + i) & (VERBOSE_AGG_TAB_SIZE - 1)];
+    if (e->count == 0) {
+      *e = (verboseAggEntry_t) { .op = op, .kind = kind, .node = node,
+                                 .ln = ln, .fn = fn, .count = 0, .bytes = 0 };
+      verboseAggNumUsed++;
+    } else if (e->ln != ln || e->fn != fn || e->node != node
+               || strcmp(e->op, op) != 0 || strcmp(e->kind, kind) != 0) {
+      continue;
+    }
+    e->count++;
+    e->bytes += size;
+    (void) pthread_mutex_unlock(&verboseAggLock);
+    return;
+  }
+
+  verboseAggDropped++;
+  (void) pthread_mutex_unlock(&verboseAggLock);
+}
+
+
+chpl_bool chpl_comm_diags_verbose_take(const char* op, const char* kind,
+                                       int node, size_t size,
+                                       int ln, int32_t fn) {
+  if (pthread_once(&verboseSettings_once, verbose_settings_init) != 0) {
+    chpl_internal_error("pthread_once(&verboseSettings_once) failed");
+  }
+
+  if (verboseAggregate) {
+    verbose_aggregate(op, kind, node, size, ln, fn);
+    return false;
+  }
+
+  if (verboseSampleEvery > 1
+      && (atomic_fetch_add_uint_least64_t(&verboseEventCount, 1)
+          % verboseSampleEvery) != 0) {
+    return false;
+  }
+
+  if (verboseSampleNsecs > 0) {
+    const uint64_t now = verbose_now_nsecs();
+    uint64_t last = atomic_load_uint_least64_t(&verboseLastPrintNsecs);
+    if (now - last < verboseSampleNsecs
+        || !atomic_compare_exchange_strong_uint_least64_t
+              (&verboseLastPrintNsecs, &last, now)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+void chpl_comm_diags_verbose_flush_aggregate(void) {
+  if (pthread_mutex_lock(&verboseAggLock) != 0) {
+    chpl_internal_error("pthread_mutex_lock(&verboseAggLock) failed");
+  }
+
+  if (verboseAggNumUsed > 0 || verboseAggDropped > 0) {
+    for (int i = 0; i < VERBOSE_AGG_TAB_SIZE; i++) {
+      verboseAggEntry_t* e = &verboseAggTab[i];
+      if (e->count > 0) {
+        printf("%d: %s:%d: remote %s%s%s, node %d, "
+               "%" PRIu64 " events, %" PRIu64 " bytes\n",
+               chpl_nodeID, chpl_lookupFilename(e->fn), e->ln,
+               e->op, (e->kind[0] == '\0') ? "" : " ", e->kind,
+               e->node, e->count, e->bytes);
+        e->count = 0;
+      }
+    }
+    if (verboseAggDropped > 0) {
+      printf("%d: (%" PRIu64 " more events at other callsites)\n",
+             chpl_nodeID, verboseAggDropped);
+    }
+    verboseAggNumUsed = 0;
+    verboseAggDropped = 0;
+  }
+
+  (void) pthread_mutex_unlock(&verboseAggLock);
+}
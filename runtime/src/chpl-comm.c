@@ -29,6 +29,10 @@
 #include "chpl-comm-internal.h"
 #include "chpl-env.h"
 #include "chpl-mem.h"
+#include "chpl-mem-sys.h"
+#include "chpl-topo.h"
+#include "chplsys.h"
+#include "error.h"
 
 // Don't get warning macros for chpl_comm_get etc.
 #include "chpl-comm-no-warning-macros.h"
@@ -36,6 +40,7 @@
 #include <pthread.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 int32_t chpl_nodeID = -1;
@@ -45,7 +50,11 @@ int32_t chpl_numNodes = -1;
 //
 // Global variable broadcast support.
 //
+#ifdef CHPL_WIDE_POINTER_PACKED
+void chpl_comm_register_global_var_packed(int i, wide_ptr_t *ptr_to_wide_ptr) {
+#else
 void chpl_comm_register_global_var(int i, wide_ptr_t *ptr_to_wide_ptr) {
+#endif
   chpl_globals_registry[i] = ptr_to_wide_ptr;
 }
 
@@ -126,6 +135,218 @@ void chpl_comm_init_prv_bcast_tab(void) {
 }
 
 
+
+//
+// Tree-structured collective support.
+//
+c_nodeid_t chpl_comm_tree_parent(c_nodeid_t node, c_nodeid_t root, int k) {
+  const c_nodeid_t rel = (node - root + chpl_numNodes) % chpl_numNodes;
+  if (rel == 0) {
+    return -1;
+  }
+  return ((rel - 1) / k + root) % chpl_numNodes;
+}
+
+
+int chpl_comm_tree_num_children(c_nodeid_t node, c_nodeid_t root, int k) {
+  const c_nodeid_t rel = (node - root + chpl_numNodes) % chpl_numNodes;
+  const int64_t relFirst = (int64_t) k * rel + 1;
+  if (relFirst >= chpl_numNodes) {
+    return 0;
+  }
+  return (relFirst + k <= chpl_numNodes) ? k : chpl_numNodes - relFirst;
+}
+
+
+c_nodeid_t chpl_comm_tree_child(c_nodeid_t node, c_nodeid_t root, int k,
+                                int i) {
+  const c_nodeid_t rel = (node - root + chpl_numNodes) % chpl_numNodes;
+  return ((int64_t) k * rel + 1 + i + root) % chpl_numNodes;
+}
+
+
+
+//
+// Collectives.
+//
+// These are built from chpl_comm_put(), chpl_comm_get(), the private
+// broadcast, and chpl_comm_barrier(), so every comm layer gets them.
+// Node 0 allocates a gather buffer and broadcasts its address, every
+// node PUTs its contribution into its slot there, and then every node
+// GETs the whole buffer back.  The reduction is done locally over the
+// gathered values so that all nodes combine them in the same order.
+//
+void* chpl_comm_coll_buf;
+
+void chpl_comm_allgather(void* dst, const void* src, size_t size) {
+  if (chpl_numNodes == 1) {
+    memmove(dst, src, size);
+    return;
+  }
+
+  const size_t totSize = chpl_numNodes * size;
+
+  if (chpl_nodeID == 0) {
+    chpl_comm_coll_buf = chpl_mem_alloc(totSize, CHPL_RT_MD_COMM_UTIL, 0, 0);
+    chpl_comm_bcast_rt_private(chpl_comm_coll_buf);
+  }
+  chpl_comm_barrier("allgather setup");
+
+  void* buf = chpl_comm_coll_buf;
+  chpl_comm_put((void*) src, 0, (char*) buf + chpl_nodeID * size, size,
+                CHPL_COMM_UNKNOWN_ID, 0, -1);
+  chpl_comm_barrier("allgather contribute");
+
+  if (chpl_nodeID == 0) {
+    memcpy(dst, buf, totSize);
+  } else {
+    chpl_comm_get(dst, 0, buf, totSize, CHPL_COMM_UNKNOWN_ID, 0, -1);
+  }
+  chpl_comm_barrier("allgather done");
+
+  if (chpl_nodeID == 0) {
+    chpl_mem_free(buf, 0, 0);
+  }
+}
+
+
+static
+size_t coll_type_size(chpl_comm_coll_type_t type) {
+  switch (type) {
+  case CHPL_COMM_COLL_INT32:  return sizeof(int32_t);
+  case CHPL_COMM_COLL_INT64:  return sizeof(int64_t);
+  case CHPL_COMM_COLL_UINT32: return sizeof(uint32_t);
+  case CHPL_COMM_COLL_UINT64: return sizeof(uint64_t);
+  case CHPL_COMM_COLL_REAL32: return sizeof(float);
+  case CHPL_COMM_COLL_REAL64: return sizeof(double);
+  }
+  chpl_internal_error("unknown collective type");
+  return 0;
+}
+
+
+#define COLL_ARITH_REDUCE(_t)                                           \
+  case CHPL_COMM_COLL_SUM:                                              \
+    for (size_t i = 0; i < count; i++) acc[i] += ((_t*) in)[i];         \
+    break;                                                              \
+  case CHPL_COMM_COLL_PROD:                                             \
+    for (size_t i = 0; i < count; i++) acc[i] *= ((_t*) in)[i];         \
+    break;                                                              \
+  case CHPL_COMM_COLL_MIN:                                              \
+    for (size_t i = 0; i < count; i++)                                  \
+      if (((_t*) in)[i] < acc[i]) acc[i] = ((_t*) in)[i];               \
+    break;                                                              \
+  case CHPL_COMM_COLL_MAX:                                              \
+    for (size_t i = 0; i < count; i++)                                  \
+      if (((_t*) in)[i] > acc[i]) acc[i] = ((_t*) in)[i];               \
+    break
+
+#define COLL_INT_REDUCE(_t)                                             \
+  do {                                                                  \
+    _t* acc = (_t*) dst;                                                \
+    switch (op) {                                                       \
+    COLL_ARITH_REDUCE(_t);                                              \
+    case CHPL_COMM_COLL_BAND:                                           \
+      for (size_t i = 0; i < count; i++) acc[i] &= ((_t*) in)[i];       \
+      break;                                                            \
+    case CHPL_COMM_COLL_BOR:                                            \
+      for (size_t i = 0; i < count; i++) acc[i] |= ((_t*) in)[i];       \
+      break;                                                            \
+    case CHPL_COMM_COLL_BXOR:                                           \
+      for (size_t i = 0; i < count; i++) acc[i] ^= ((_t*) in)[i];       \
+      break;                                                            \
+    }                                                                   \
+  } while (0)
+
+#define COLL_REAL_REDUCE(_t)                                            \
+  do {                                                                  \
+    _t* acc = (_t*) dst;                                                \
+    switch (op) {                                                       \
+    COLL_ARITH_REDUCE(_t);                                              \
+    default:                                                            \
+      chpl_internal_error("bitwise reduction of real type");            \
+    }                                                                   \
+  } while (0)
+
+static
+void coll_reduce(void* dst, const void* in, size_t count,
+                 chpl_comm_coll_type_t type, chpl_comm_coll_op_t op) {
+  switch (type) {
+  case CHPL_COMM_COLL_INT32:  COLL_INT_REDUCE(int32_t);  break;
+  case CHPL_COMM_COLL_INT64:  COLL_INT_REDUCE(int64_t);  break;
+  case CHPL_COMM_COLL_UINT32: COLL_INT_REDUCE(uint32_t); break;
+  case CHPL_COMM_COLL_UINT64: COLL_INT_REDUCE(uint64_t); break;
+  case CHPL_COMM_COLL_REAL32: COLL_REAL_REDUCE(float);   break;
+  case CHPL_COMM_COLL_REAL64: COLL_REAL_REDUCE(double);  break;
+  }
+}
+
+#undef COLL_REAL_REDUCE
+#undef COLL_INT_REDUCE
+#undef COLL_ARITH_REDUCE
+
+
+void chpl_comm_allreduce(void* dst, const void* src, size_t count,
+                         chpl_comm_coll_type_t type,
+                         chpl_comm_coll_op_t op) {
+  const size_t size = count * coll_type_size(type);
+
+  if (chpl_numNodes == 1) {
+    memmove(dst, src, size);
+    return;
+  }
+
+  char* all = chpl_mem_alloc(chpl_numNodes * size, CHPL_RT_MD_COMM_UTIL,
+                             0, 0);
+  chpl_comm_allgather(all, src, size);
+
+  memcpy(dst, all, size);
+  for (c_nodeid_t node = 1; node < chpl_numNodes; node++) {
+    coll_reduce(dst, all + node * size, count, type, op);
+  }
+
+  chpl_mem_free(all, 0, 0);
+}
+
+
+//
+// Spanning tree for the compiler's coforall-on fan-out.
+//
+static pthread_once_t coforallTreeDegree_once = PTHREAD_ONCE_INIT;
+static int coforallTreeDegree;
+
+static
+void set_coforallTreeDegree(void)
+{
+  int64_t k = chpl_env_rt_get_int("COFORALL_ON_TREE_DEGREE", 8);
+  if (k < 1) {
+    chpl_warning("CHPL_RT_COFORALL_ON_TREE_DEGREE must be positive, using 8",
+                 0, 0);
+    k = 8;
+  }
+  coforallTreeDegree = (int) k;
+}
+
+static inline
+int coforallTreeDegreeGet(void)
+{
+  if (pthread_once(&coforallTreeDegree_once, set_coforallTreeDegree) != 0) {
+    chpl_internal_error("pthread_once(&coforallTreeDegree_once) failed");
+  }
+
+  return coforallTreeDegree;
+}
+
+int64_t chpl_comm_coforall_tree_num_children(int64_t root) {
+  return chpl_comm_tree_num_children(chpl_nodeID, root,
+                                     coforallTreeDegreeGet());
+}
+
+int64_t chpl_comm_coforall_tree_child(int64_t root, int64_t i) {
+  return chpl_comm_tree_child(chpl_nodeID, root, coforallTreeDegreeGet(), i);
+}
+
+
 static pthread_once_t maxHeapSize_once = PTHREAD_ONCE_INIT;
 static size_t maxHeapSize;
 
@@ -154,6 +375,115 @@ size_t chpl_comm_getenvMaxHeapSize(void)
 }
 
 
+//
+// Heap prefaulting.  This runs before the tasking layer is up, so it
+// uses bare pthreads, and before the memory layer is, so it gets its
+// own memory from the system.
+//
+typedef struct {
+  pthread_t thread;
+  unsigned char* start;
+  size_t size;
+  c_sublocid_t subloc;
+  uint64_t doneNs;
+} prefault_chunk_t;
+
+static prefault_chunk_t* prefaultChunks;
+static int prefaultNumChunks;
+static uint64_t prefaultStartNs;
+static uint64_t prefaultNs;
+
+static uint64_t prefault_now(void) {
+  struct timespec ts;
+  (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void* prefault_thread(void* arg) {
+  prefault_chunk_t* chunk = (prefault_chunk_t*) arg;
+  chpl_topo_touchMemFromSubloc(chunk->start, chunk->size, false,
+                               chunk->subloc);
+  chunk->doneNs = prefault_now();
+  return NULL;
+}
+
+void chpl_comm_prefault_heap_start(void* start, size_t size) {
+  if (start == NULL || size == 0
+      || !chpl_env_rt_get_bool("COMM_PREFAULT_HEAP", false)) {
+    return;
+  }
+
+  //
+  // Give each NUMA domain an equal share of the pages and each domain's
+  // cores an equal share of that.  Settle the heap page size here, so
+  // the threads don't all race to figure it out.
+  //
+  const size_t pgSize = chpl_getHeapPageSize();
+  const size_t nPages = size / pgSize;
+  int numDomains = chpl_topo_getNumNumaDomains();
+  if (numDomains < 1) {
+    numDomains = 1;
+  }
+  int perDomain = chpl_topo_getNumCPUsPhysical(true) / numDomains;
+  if (perDomain < 1) {
+    perDomain = 1;
+  }
+  int numChunks = numDomains * perDomain;
+  if ((size_t) numChunks > nPages) {
+    numChunks = (nPages > 0) ? nPages : 1;
+    perDomain = (numChunks + numDomains - 1) / numDomains;
+  }
+
+  prefaultChunks = sys_calloc(numChunks, sizeof(prefaultChunks[0]));
+  if (prefaultChunks == NULL) {
+    chpl_internal_error("cannot allocate heap prefault info");
+  }
+  prefaultNumChunks = numChunks;
+  prefaultStartNs = prefault_now();
+
+  for (int i = 0; i < numChunks; i++) {
+    const size_t pgLo = nPages * i / numChunks;
+    const size_t pgHi = nPages * (i + 1) / numChunks;
+    prefault_chunk_t* chunk = &prefaultChunks[i];
+    chunk->start = (unsigned char*) start + pgLo * pgSize;
+    chunk->size = (i == numChunks - 1)
+                  ? (size_t) ((unsigned char*) start + size - chunk->start)
+                  : (pgHi - pgLo) * pgSize;
+    chunk->subloc = (numDomains > 1) ? i / perDomain : 0;
+    if (chunk->subloc >= numDomains) {
+      chunk->subloc = numDomains - 1;
+    }
+    if (pthread_create(&chunk->thread, NULL, prefault_thread, chunk) != 0) {
+      chpl_internal_error("cannot create heap prefault thread");
+    }
+  }
+}
+
+void chpl_comm_prefault_heap_wait(void) {
+  if (prefaultChunks == NULL) {
+    return;
+  }
+
+  uint64_t lastNs = prefaultStartNs;
+  for (int i = 0; i < prefaultNumChunks; i++) {
+    if (pthread_join(prefaultChunks[i].thread, NULL) != 0) {
+      chpl_internal_error("cannot join heap prefault thread");
+    }
+    if (prefaultChunks[i].doneNs > lastNs) {
+      lastNs = prefaultChunks[i].doneNs;
+    }
+  }
+  prefaultNs = lastNs - prefaultStartNs;
+
+  sys_free(prefaultChunks);
+  prefaultChunks = NULL;
+}
+
+uint64_t chpl_comm_prefault_heap_ns(void) {
+  return prefaultNs;
+}
+
+
 void* chpl_get_global_serialize_table(int64_t idx) {
   return chpl_global_serialize_table[idx];
 }
@@ -21,6 +21,7 @@
 #include "chplrt.h"
 
 #include "chpl-env.h"
+#include "chpl-mem-sys.h"
 #include "chpltypes.h"
 #include "error.h"
 
@@ -31,6 +32,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -190,3 +192,46 @@ void chpl_env_set_uint(const char* evName, uint64_t evVal, int overwrite) {
   snprintf(buf, sizeof(buf), "%" PRIu64, evVal);
   chpl_env_set(evName, buf, overwrite);
 }
+
+
+void chpl_env_load_file(void) {
+  const char* fname = getenv("CHPL_RT_ENV_FILE");
+  if (fname == NULL || fname[0] == '\0')
+    return;
+
+  FILE* f;
+  if ((f = fopen(fname, "r")) == NULL) {
+    char buf[FILENAME_MAX + 50];
+    snprintf(buf, sizeof(buf), "cannot open environment file \"%s\"", fname);
+    chpl_error(buf, 0, 0);
+  }
+
+  long size;
+  char* data = NULL;
+  if (fseek(f, 0, SEEK_END) != 0
+      || (size = ftell(f)) < 0
+      || fseek(f, 0, SEEK_SET) != 0
+      || (data = sys_malloc(size + 1)) == NULL
+      || fread(data, 1, size, f) != (size_t) size) {
+    char buf[FILENAME_MAX + 50];
+    snprintf(buf, sizeof(buf), "cannot read environment file \"%s\"", fname);
+    chpl_error(buf, 0, 0);
+  }
+  (void) fclose(f);
+  data[size] = '\0';
+
+  //
+  // The launcher wrote NAME=value entries, each ending in a '\0'.  We
+  // don't override anything already set here, so that what the job
+  // launcher sets up for this particular process wins.
+  //
+  for (char* ent = data; ent < data + size; ent += strlen(ent) + 1) {
+    char* eq = strchr(ent, '=');
+    if (eq == NULL || eq == ent)
+      continue;
+    *eq = '\0';
+    (void) setenv(ent, eq + 1, 0);
+  }
+
+  sys_free(data);
+}
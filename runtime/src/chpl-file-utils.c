@@ -25,12 +25,24 @@
 #endif
 
 #include "chpl-file-utils.h"
+#ifndef CHPL_RT_UNIT_TEST
+#include "chpl-topo.h"
+#endif
 
 #include <stdio.h>
 #include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
 #include <sys/param.h> // MAXPATHLEN
 #include <sys/stat.h>
 #include <utime.h> // Defines utimbuf and utime()
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 
 qioerr chpl_fs_chdir(const char* name) {
@@ -453,6 +465,254 @@ qioerr chpl_fs_symlink(const char* orig, const char* linkName) {
 
 }
 
+//
+// Parallel directory walk.  Directories still to be read are kept on a
+// shared stack.  The walk is over when the stack is empty and no thread
+// is reading a directory (which could add more), or when it's stopped.
+//
+typedef struct walkDir_s {
+  struct walkDir_s* next;
+  char path[];
+} walkDir_t;
+
+typedef struct {
+  chpl_fs_walk_fn_t fn;
+  void* arg;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  walkDir_t* todo;
+  int nBusy;
+  int done;
+  qioerr err;
+} walkState_t;
+
+// Room for the directory entries one getdents64() call returns.
+#define WALK_BUF_SIZE (256 * 1024)
+
+#if defined(__linux__) && defined(SYS_getdents64)
+// The kernel's record layout; libc doesn't always declare it.
+typedef struct {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+} walkDirent64_t;
+#endif
+
+static int walkStopped(walkState_t* ws) {
+  return __atomic_load_n(&ws->done, __ATOMIC_RELAXED);
+}
+
+static qioerr walkPush(walkState_t* ws, const char* path, size_t len) {
+  walkDir_t* d = (walkDir_t*) qio_malloc(sizeof(walkDir_t) + len + 1);
+  if (d == NULL)
+    return QIO_ENOMEM;
+  memcpy(d->path, path, len + 1);
+
+  pthread_mutex_lock(&ws->lock);
+  d->next = ws->todo;
+  ws->todo = d;
+  pthread_cond_signal(&ws->cond);
+  pthread_mutex_unlock(&ws->lock);
+  return 0;
+}
+
+// Handle one entry of the directory open on dirfd, whose path (without a
+// trailing '/') is in path[0..plen).  Sets *stop if fn asked to stop.
+static qioerr walkEntry(walkState_t* ws, int dirfd, char* path, size_t plen,
+                        const char* name, int* stop) {
+  struct stat st;
+  size_t nlen;
+
+  if (name[0] == '.'
+      && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+    return 0;
+
+  if (fstatat(dirfd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+    // It may have gone away since we read the directory.
+    return (errno == ENOENT) ? 0 : qio_mkerror_errno();
+  }
+
+  nlen = strlen(name);
+  if (plen + 1 + nlen >= MAXPATHLEN)
+    QIO_RETURN_CONSTANT_ERROR(ENAMETOOLONG, "path too long in directory walk");
+  path[plen] = '/';
+  memcpy(&path[plen + 1], name, nlen + 1);
+
+  if (ws->fn(path, &st, ws->arg) != 0) {
+    *stop = 1;
+    return 0;
+  }
+
+  if (S_ISDIR(st.st_mode))
+    return walkPush(ws, path, plen + 1 + nlen);
+  return 0;
+}
+
+static qioerr walkDir(walkState_t* ws, const char* dirPath, char* buf,
+                      int* stop) {
+  char path[MAXPATHLEN];
+  size_t plen = strlen(dirPath);
+  qioerr err = 0;
+  int fd;
+
+  if (plen >= MAXPATHLEN)
+    QIO_RETURN_CONSTANT_ERROR(ENAMETOOLONG, "path too long in directory walk");
+  memcpy(path, dirPath, plen + 1);
+  while (plen > 1 && path[plen - 1] == '/')
+    path[--plen] = '\0';
+
+  if ((fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+    return qio_mkerror_errno();
+
+#if defined(__linux__) && defined(SYS_getdents64)
+  while (!err && !*stop && !walkStopped(ws)) {
+    long n = syscall(SYS_getdents64, fd, buf, WALK_BUF_SIZE);
+    if (n < 0) {
+      err = qio_mkerror_errno();
+      break;
+    }
+    if (n == 0)
+      break;
+    for (long off = 0; off < n && !err && !*stop; ) {
+      walkDirent64_t* de = (walkDirent64_t*) (buf + off);
+      off += de->d_reclen;
+      err = walkEntry(ws, fd, path, (plen == 1 && path[0] == '/') ? 0 : plen,
+                      de->d_name, stop);
+    }
+  }
+  (void) close(fd);
+#else
+  {
+    DIR* dir;
+    struct dirent* de;
+
+    if ((dir = fdopendir(fd)) == NULL) {
+      err = qio_mkerror_errno();
+      (void) close(fd);
+      return err;
+    }
+    while (!err && !*stop && !walkStopped(ws)) {
+      errno = 0;
+      if ((de = readdir(dir)) == NULL) {
+        if (errno != 0)
+          err = qio_mkerror_errno();
+        break;
+      }
+      err = walkEntry(ws, fd, path, (plen == 1 && path[0] == '/') ? 0 : plen,
+                      de->d_name, stop);
+    }
+    (void) closedir(dir);
+  }
+#endif
+
+  return err;
+}
+
+static void* walkWorker(void* arg) {
+  walkState_t* ws = (walkState_t*) arg;
+  char* buf = (char*) qio_malloc(WALK_BUF_SIZE);
+
+  pthread_mutex_lock(&ws->lock);
+  if (buf == NULL) {
+    if (!ws->err)
+      ws->err = QIO_ENOMEM;
+    __atomic_store_n(&ws->done, 1, __ATOMIC_RELAXED);
+    pthread_cond_broadcast(&ws->cond);
+  }
+
+  while (1) {
+    walkDir_t* d;
+    qioerr err;
+    int stop = 0;
+
+    while (!ws->done && ws->todo == NULL && ws->nBusy > 0)
+      pthread_cond_wait(&ws->cond, &ws->lock);
+    if (ws->done || ws->todo == NULL) {
+      __atomic_store_n(&ws->done, 1, __ATOMIC_RELAXED);
+      pthread_cond_broadcast(&ws->cond);
+      break;
+    }
+
+    d = ws->todo;
+    ws->todo = d->next;
+    ws->nBusy++;
+    pthread_mutex_unlock(&ws->lock);
+
+    err = walkDir(ws, d->path, buf, &stop);
+    qio_free(d);
+
+    pthread_mutex_lock(&ws->lock);
+    ws->nBusy--;
+    if (err && !ws->err)
+      ws->err = err;
+    if (err || stop)
+      __atomic_store_n(&ws->done, 1, __ATOMIC_RELAXED);
+    if (ws->done || (ws->todo == NULL && ws->nBusy == 0))
+      pthread_cond_broadcast(&ws->cond);
+  }
+  pthread_mutex_unlock(&ws->lock);
+
+  if (buf != NULL)
+    qio_free(buf);
+  return NULL;
+}
+
+qioerr chpl_fs_walk_parallel(const char* root, int nthreads,
+                             chpl_fs_walk_fn_t fn, void* arg) {
+  walkState_t ws;
+  pthread_t* threads = NULL;
+  int nStarted = 0;
+  qioerr err;
+
+  memset(&ws, 0, sizeof(ws));
+  ws.fn = fn;
+  ws.arg = arg;
+  pthread_mutex_init(&ws.lock, NULL);
+  pthread_cond_init(&ws.cond, NULL);
+
+  if (nthreads <= 0) {
+#ifndef CHPL_RT_UNIT_TEST
+    nthreads = chpl_topo_getNumCPUsPhysical(true);
+#endif
+    if (nthreads <= 0)
+      nthreads = 1;
+  }
+
+  err = walkPush(&ws, root, strlen(root));
+
+  if (!err && nthreads > 1) {
+    threads = (pthread_t*) qio_calloc(nthreads - 1, sizeof(pthread_t));
+    if (threads != NULL) {
+      for ( ; nStarted < nthreads - 1; nStarted++) {
+        if (pthread_create(&threads[nStarted], NULL, walkWorker, &ws) != 0)
+          break;
+      }
+    }
+  }
+
+  // This thread works too.
+  if (!err) {
+    (void) walkWorker(&ws);
+    for (int i = 0; i < nStarted; i++)
+      (void) pthread_join(threads[i], NULL);
+    err = ws.err;
+  }
+
+  while (ws.todo != NULL) {
+    walkDir_t* d = ws.todo;
+    ws.todo = d->next;
+    qio_free(d);
+  }
+  if (threads != NULL)
+    qio_free(threads);
+  pthread_cond_destroy(&ws.cond);
+  pthread_mutex_destroy(&ws.lock);
+
+  return err;
+}
+
 mode_t chpl_fs_umask(mode_t mask) {
   return umask(mask);
 }
@@ -0,0 +1,311 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "chplrt.h"
+
+#include "chpl-gpu.h"
+#include "chpl-mem.h"
+#include "chpl-threads.h"
+#include "error.h"
+
+#include <stdio.h>
+
+#ifdef HAS_GPU_LOCALE
+
+#include <cuda.h>
+
+//
+// One context per device, created on first use, and the modules loaded
+// into each one, found by the address of their device image.
+//
+typedef struct chpl_gpu_module_s {
+  const void* image;
+  CUmodule module;
+  struct chpl_gpu_module_s* next;
+} chpl_gpu_module_t;
+
+static chpl_thread_mutex_t chpl_gpu_lock;
+static int chpl_gpu_initialized = 0;
+static int chpl_gpu_ndevices = 0;
+static CUcontext* chpl_gpu_contexts = NULL;
+static chpl_gpu_module_t** chpl_gpu_modules = NULL;
+
+static void chpl_gpu_check(CUresult res, const char* what,
+                           int32_t lineno, int32_t filename) {
+  const char* msg = NULL;
+  char buf[256];
+
+  if (res == CUDA_SUCCESS)
+    return;
+
+  if (cuGetErrorString(res, &msg) != CUDA_SUCCESS)
+    msg = "unknown error";
+  snprintf(buf, sizeof(buf), "GPU %s failed: %s", what, msg);
+  chpl_error(buf, lineno, filename);
+}
+
+static void chpl_gpu_init_devices(void) {
+  int i;
+
+  // Safe to test without the lock: it is only ever set from 0 to 1, after
+  // everything else has been set up.
+  if (chpl_gpu_initialized)
+    return;
+
+  chpl_thread_mutexLock(&chpl_gpu_lock);
+  if (!chpl_gpu_initialized) {
+    if (cuInit(0) != CUDA_SUCCESS ||
+        cuDeviceGetCount(&chpl_gpu_ndevices) != CUDA_SUCCESS) {
+      chpl_gpu_ndevices = 0;
+    }
+
+    if (chpl_gpu_ndevices > 0) {
+      chpl_gpu_contexts = chpl_mem_allocManyZero(chpl_gpu_ndevices,
+                                                 sizeof(CUcontext),
+                                                 CHPL_RT_MD_GPU_LAYER_DATA,
+                                                 0, 0);
+      chpl_gpu_modules = chpl_mem_allocManyZero(chpl_gpu_ndevices,
+                                                sizeof(chpl_gpu_module_t*),
+                                                CHPL_RT_MD_GPU_LAYER_DATA,
+                                                0, 0);
+    }
+
+    for (i = 0; i < chpl_gpu_ndevices; i++) {
+      CUdevice device;
+      chpl_gpu_check(cuDeviceGet(&device, i), "device lookup", 0, 0);
+      chpl_gpu_check(cuDevicePrimaryCtxRetain(&chpl_gpu_contexts[i], device),
+                     "context creation", 0, 0);
+    }
+
+    __sync_synchronize();
+    chpl_gpu_initialized = 1;
+  }
+  chpl_thread_mutexUnlock(&chpl_gpu_lock);
+}
+
+// Make 'dev' the current device of this thread.
+static void chpl_gpu_use_device(int dev, int32_t lineno, int32_t filename) {
+  chpl_gpu_init_devices();
+
+  if (dev < 0 || dev >= chpl_gpu_ndevices) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "GPU %d does not exist (this node has %d)",
+             dev, chpl_gpu_ndevices);
+    chpl_error(buf, lineno, filename);
+  }
+
+  chpl_gpu_check(cuCtxSetCurrent(chpl_gpu_contexts[dev]), "context switch",
+                 lineno, filename);
+}
+
+static CUmodule chpl_gpu_get_module(int dev, const void* image,
+                                    int32_t lineno, int32_t filename) {
+  chpl_gpu_module_t* m;
+  CUmodule module = NULL;
+
+  chpl_thread_mutexLock(&chpl_gpu_lock);
+
+  for (m = chpl_gpu_modules[dev]; m != NULL; m = m->next) {
+    if (m->image == image) {
+      module = m->module;
+      break;
+    }
+  }
+
+  if (module == NULL) {
+    chpl_gpu_check(cuModuleLoadData(&module, image), "module load",
+                   lineno, filename);
+    m = chpl_mem_alloc(sizeof(*m), CHPL_RT_MD_GPU_LAYER_DATA, 0, 0);
+    m->image = image;
+    m->module = module;
+    m->next = chpl_gpu_modules[dev];
+    chpl_gpu_modules[dev] = m;
+  }
+
+  chpl_thread_mutexUnlock(&chpl_gpu_lock);
+
+  return module;
+}
+
+void chpl_gpu_init(void) {
+  // The devices themselves are set up on first use, so that programs
+  // which never use them don't pay for it.
+  chpl_thread_mutexInit(&chpl_gpu_lock);
+}
+
+int chpl_gpu_num_devices(void) {
+  chpl_gpu_init_devices();
+  return chpl_gpu_ndevices;
+}
+
+void* chpl_gpu_mem_alloc(int dev, size_t size,
+                         int32_t lineno, int32_t filename) {
+  CUdeviceptr ptr = 0;
+
+  chpl_gpu_use_device(dev, lineno, filename);
+  if (size == 0)
+    return NULL;
+  chpl_gpu_check(cuMemAlloc(&ptr, size), "allocation", lineno, filename);
+
+  return (void*) ptr;
+}
+
+void chpl_gpu_mem_free(int dev, void* ptr, int32_t lineno, int32_t filename) {
+  if (ptr == NULL)
+    return;
+  chpl_gpu_use_device(dev, lineno, filename);
+  chpl_gpu_check(cuMemFree((CUdeviceptr) ptr), "free", lineno, filename);
+}
+
+void* chpl_gpu_mem_alloc_managed(int dev, size_t size,
+                                 int32_t lineno, int32_t filename) {
+  CUdeviceptr ptr = 0;
+
+  chpl_gpu_use_device(dev, lineno, filename);
+  if (size == 0)
+    return NULL;
+  chpl_gpu_check(cuMemAllocManaged(&ptr, size, CU_MEM_ATTACH_GLOBAL),
+                 "managed allocation", lineno, filename);
+
+  return (void*) ptr;
+}
+
+void* chpl_gpu_mem_alloc_host(size_t size, int32_t lineno, int32_t filename) {
+  void* ptr = NULL;
+
+  // Pinned memory belongs to a context, so there has to be a current one.
+  chpl_gpu_use_device(0, lineno, filename);
+  if (size == 0)
+    return NULL;
+  chpl_gpu_check(cuMemHostAlloc(&ptr, size, CU_MEMHOSTALLOC_PORTABLE),
+                 "pinned allocation", lineno, filename);
+
+  return ptr;
+}
+
+void chpl_gpu_mem_free_host(void* ptr, int32_t lineno, int32_t filename) {
+  if (ptr == NULL)
+    return;
+  chpl_gpu_use_device(0, lineno, filename);
+  chpl_gpu_check(cuMemFreeHost(ptr), "pinned free", lineno, filename);
+}
+
+void chpl_gpu_copy_host_to_device(int dev, void* dst, const void* src,
+                                  size_t size,
+                                  int32_t lineno, int32_t filename) {
+  chpl_gpu_use_device(dev, lineno, filename);
+  chpl_gpu_check(cuMemcpyHtoD((CUdeviceptr) dst, src, size),
+                 "copy to device", lineno, filename);
+}
+
+void chpl_gpu_copy_device_to_host(int dev, void* dst, const void* src,
+                                  size_t size,
+                                  int32_t lineno, int32_t filename) {
+  chpl_gpu_use_device(dev, lineno, filename);
+  chpl_gpu_check(cuMemcpyDtoH(dst, (CUdeviceptr) src, size),
+                 "copy from device", lineno, filename);
+}
+
+void chpl_gpu_launch_kernel(int dev, const void* image, const char* name,
+                            int64_t num_threads, int block_size,
+                            int nargs, void** args,
+                            int32_t lineno, int32_t filename) {
+  CUmodule module;
+  CUfunction function;
+  int64_t grid_size;
+
+  if (num_threads <= 0)
+    return;
+  if (block_size <= 0)
+    block_size = 256;
+  grid_size = (num_threads + block_size - 1) / block_size;
+
+  chpl_gpu_use_device(dev, lineno, filename);
+  module = chpl_gpu_get_module(dev, image, lineno, filename);
+  chpl_gpu_check(cuModuleGetFunction(&function, module, name),
+                 "kernel lookup", lineno, filename);
+
+  (void) nargs;
+  chpl_gpu_check(cuLaunchKernel(function,
+                                (unsigned int) grid_size, 1, 1,
+                                (unsigned int) block_size, 1, 1,
+                                0, NULL, args, NULL),
+                 "kernel launch", lineno, filename);
+  chpl_gpu_check(cuCtxSynchronize(), "kernel", lineno, filename);
+}
+
+#else // HAS_GPU_LOCALE
+
+static void chpl_gpu_unsupported(int32_t lineno, int32_t filename) {
+  chpl_error("this runtime was built without GPU support", lineno, filename);
+}
+
+void chpl_gpu_init(void) {
+}
+
+int chpl_gpu_num_devices(void) {
+  return 0;
+}
+
+void* chpl_gpu_mem_alloc(int dev, size_t size,
+                         int32_t lineno, int32_t filename) {
+  chpl_gpu_unsupported(lineno, filename);
+  return NULL;
+}
+
+void chpl_gpu_mem_free(int dev, void* ptr, int32_t lineno, int32_t filename) {
+  chpl_gpu_unsupported(lineno, filename);
+}
+
+void* chpl_gpu_mem_alloc_managed(int dev, size_t size,
+                                 int32_t lineno, int32_t filename) {
+  chpl_gpu_unsupported(lineno, filename);
+  return NULL;
+}
+
+void* chpl_gpu_mem_alloc_host(size_t size, int32_t lineno, int32_t filename) {
+  chpl_gpu_unsupported(lineno, filename);
+  return NULL;
+}
+
+void chpl_gpu_mem_free_host(void* ptr, int32_t lineno, int32_t filename) {
+  chpl_gpu_unsupported(lineno, filename);
+}
+
+void chpl_gpu_copy_host_to_device(int dev, void* dst, const void* src,
+                                  size_t size,
+                                  int32_t lineno, int32_t filename) {
+  chpl_gpu_unsupported(lineno, filename);
+}
+
+void chpl_gpu_copy_device_to_host(int dev, void* dst, const void* src,
+                                  size_t size,
+                                  int32_t lineno, int32_t filename) {
+  chpl_gpu_unsupported(lineno, filename);
+}
+
+void chpl_gpu_launch_kernel(int dev, const void* image, const char* name,
+                            int64_t num_threads, int block_size,
+                            int nargs, void** args,
+                            int32_t lineno, int32_t filename) {
+  chpl_gpu_unsupported(lineno, filename);
+}
+
+#endif // HAS_GPU_LOCALE
@@ -26,23 +26,32 @@
 #include "chplcgfns.h"
 #include "chpl-cache.h"
 #include "chpl-comm.h"
+#include "chpl-comm-internal.h"
+#include "chpl-env.h"
+#include "chpl-gpu.h"
 #include "chplexit.h"
 #include "chplio.h"
 #include "chpl-init.h"
 #include "chpl-mem.h"
 #include "chplmemtrack.h"
 #include "chpl-privatization.h"
+#include "chpl-stats-dump.h"
 #include "chpl-tasks.h"
+#include "chpl-task-counters.h"
 #include "chpl-topo.h"
+#include "chpl-tracer.h"
+#include "chpl-wide-ptr-fns.h"
 #include "chpl-linefile-support.h"
 #include "chplsys.h"
 #include "config.h"
 #include "error.h"
 
+#include <inttypes.h>
 #include <stdint.h>
 #include <string.h>
 #include <locale.h>
 #include <time.h>
+#include <unistd.h>
 #include <sys.h>
 
 static const int32_t myFilename = CHPL_FILE_IDX_INTERNAL;
@@ -70,6 +79,116 @@ void printAdditionalHelp(void) {
 }
 
 
+//
+// Startup timeline, reported with CHPL_RT_REPORT_STARTUP.  Every locale
+// records how long each phase of its startup took, and at the end of
+// the pre-user-code hook node 0 gathers them and prints the minimum
+// and maximum time for each phase across the locales.  The times are
+// wall clock times so that the launcher's start time, which it passes
+// in CHPL_RT_LAUNCH_START_NS, can be compared to ours.  Phases that
+// end at a barrier include waiting for the slowest locale.  The heap
+// prefault (CHPL_RT_COMM_PREFAULT_HEAP) overlaps other phases, so it is
+// listed but not counted in the total.
+//
+typedef enum {
+  startup_launch,
+  startup_topo,
+  startup_comm,
+  startup_mem,
+  startup_comm_barrier,
+  startup_task,
+  startup_post_task,
+  startup_rollcall,
+  startup_string_literals,
+  startup_globals,
+  startup_module_init,
+  startup_user_code_hook,
+  startup_heap_prefault,
+  startup_num_phases
+} startup_phase_t;
+
+static const char* startupPhaseNames[startup_num_phases] = {
+  [startup_launch] = "launch",
+  [startup_topo] = "topology init",
+  [startup_comm] = "comm init",
+  [startup_mem] = "memory init",
+  [startup_comm_barrier] = "comm init barrier",
+  [startup_task] = "tasking init",
+  [startup_post_task] = "post-tasking init",
+  [startup_rollcall] = "rollcall and barrier",
+  [startup_string_literals] = "string literals",
+  [startup_globals] = "global var broadcast",
+  [startup_module_init] = "module init",
+  [startup_user_code_hook] = "pre-user-code hook",
+  [startup_heap_prefault] = "heap prefault",
+};
+
+static uint64_t startupStart;
+static uint64_t startupLast;
+static uint64_t startupNs[startup_num_phases];
+
+static uint64_t startupNow(void) {
+  struct timespec ts;
+  (void) clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Records the end of the given phase, which began at the previous mark.
+static void startupMark(startup_phase_t phase) {
+  const uint64_t now = startupNow();
+  startupNs[phase] = now - startupLast;
+  startupLast = now;
+}
+
+static void startupReport(void) {
+  if (!chpl_env_rt_get_bool("REPORT_STARTUP", false)) {
+    return;
+  }
+
+  const uint64_t launched = chpl_env_rt_get_uint("LAUNCH_START_NS",
+                                                 startupStart);
+  startupNs[startup_launch] = (launched < startupStart)
+                              ? startupStart - launched
+                              : 0;
+  startupNs[startup_heap_prefault] = chpl_comm_prefault_heap_ns();
+
+  const size_t size = sizeof(startupNs);
+  uint64_t* all = chpl_mem_alloc(chpl_numNodes * size,
+                                 CHPL_RT_MD_COMM_UTIL, 0, 0);
+  chpl_comm_allgather(all, startupNs, size);
+
+  if (chpl_nodeID == 0) {
+    uint64_t total = 0;
+    fprintf(stderr, "startup: %-22s %10s %6s %10s %6s\n",
+            "phase", "min (s)", "node", "max (s)", "node");
+    for (int ph = 0; ph < startup_num_phases; ph++) {
+      c_nodeid_t minNode = 0;
+      c_nodeid_t maxNode = 0;
+      for (c_nodeid_t n = 1; n < chpl_numNodes; n++) {
+        if (all[n * startup_num_phases + ph]
+            < all[minNode * startup_num_phases + ph]) {
+          minNode = n;
+        }
+        if (all[n * startup_num_phases + ph]
+            > all[maxNode * startup_num_phases + ph]) {
+          maxNode = n;
+        }
+      }
+      fprintf(stderr, "startup: %-22s %10.3f %6d %10.3f %6d\n",
+              startupPhaseNames[ph],
+              all[minNode * startup_num_phases + ph] / 1e9, (int) minNode,
+              all[maxNode * startup_num_phases + ph] / 1e9, (int) maxNode);
+      if (ph != startup_heap_prefault) {
+        total += all[ph];
+      }
+    }
+    fprintf(stderr, "startup: %-22s %10.3f on node 0\n", "total", total / 1e9);
+  }
+
+  chpl_mem_free(all, 0, 0);
+}
+
+
 static void recordExecutionCommand(int argc, char *argv[]) {
   int i, length = 0;
   for (i = 0; i < argc; i++) {
@@ -105,6 +224,7 @@ void chpl_rt_preUserCodeHook(void) {
   // module init can change the running task count on any node.
   //
   chpl_comm_barrier("pre-user-code hook: init done");
+  startupMark(startup_module_init);
   chpl_taskRunningCntReset(0, 0);
   if (chpl_nodeID == 0) {
     chpl_taskRunningCntInc(0, 0);
@@ -119,6 +239,10 @@ void chpl_rt_preUserCodeHook(void) {
   //
   chpl_comm_barrier("pre-user-code hook: task counts stable");
   chpl_setMemFlags();
+  chpl_mem_sample_init();
+  chpl_trace_init();
+  chpl_task_counters_init();
+  chpl_stats_dump_init();
 
   //
   // Finally, we have to do a third barrier to make sure all the nodes
@@ -126,6 +250,8 @@ void chpl_rt_preUserCodeHook(void) {
   // user code and execution starts spreading around the nodes.
   //
   chpl_comm_barrier("pre-user-code hook: mem tracking inited");
+  startupMark(startup_user_code_hook);
+  startupReport();
 }
 
 
@@ -156,6 +282,8 @@ void chpl_rt_init(int argc, char* argv[]) {
   int runInGDB;
   int runInLLDB;
 
+  startupStart = startupLast = startupNow();
+
   // Check that we can get the page size.
   assert( sys_page_size() > 0 );
 
@@ -169,17 +297,42 @@ void chpl_rt_init(int argc, char* argv[]) {
 
   //
   // Handle options that set the environment before doing any other
-  // runtime initialization.
+  // runtime initialization.  The launcher may have put our environment
+  // in a file rather than passing it to each process; load that first.
   //
+  chpl_env_load_file();
   parseArgs(false, parse_dash_E, &argc, argv);
 
   chpl_error_init();  // This does local-only initialization
   chpl_topo_init();
+  startupMark(startup_topo);
   chpl_comm_init(&argc, &argv);
+  startupMark(startup_comm);
+#ifdef CHPL_WIDE_POINTER_PACKED
+  if (chpl_numNodes > CHPL_WIDE_POINTER_MAX_NODES) {
+    char msg[100];
+    snprintf(msg, sizeof(msg),
+             "packed wide pointers support at most %" PRId64 " locales",
+             CHPL_WIDE_POINTER_MAX_NODES);
+    chpl_error(msg, 0, 0);
+  }
+#endif
   chpl_mem_init();
   chpl_comm_post_mem_init();
+  startupMark(startup_mem);
 
   chpl_comm_barrier("about to leave comm init code");
+  startupMark(startup_comm_barrier);
+
+  //
+  // Everyone has loaded the environment file by now, if there was one.
+  //
+  if (chpl_nodeID == 0) {
+    const char* envFile = chpl_env_rt_get("ENV_FILE", NULL);
+    if (envFile != NULL && envFile[0] != '\0') {
+      (void) unlink(envFile);
+    }
+  }
 
   CreateConfigVarTable();      // get ready to start tracking config vars
   chpl_gen_main_arg.argv = chpl_malloc(argc * sizeof(char*));
@@ -218,10 +371,14 @@ void chpl_rt_init(int argc, char* argv[]) {
   // Initialize the task management layer.
   //
   chpl_task_init();
+  startupMark(startup_task);
 
   // Initialize privatization, needs to happen before hitting module init
   chpl_privatization_init();
 
+  // Set up GPU support; the devices are looked at on first use.
+  chpl_gpu_init();
+
   //
   // Some comm layer initialization has to wait until after the
   // tasking layer is initialized.
@@ -230,6 +387,7 @@ void chpl_rt_init(int argc, char* argv[]) {
 #ifdef HAS_CHPL_CACHE_FNS
   chpl_cache_init();
 #endif
+  startupMark(startup_post_task);
   chpl_comm_rollcall();
 
   //
@@ -237,6 +395,7 @@ void chpl_rt_init(int argc, char* argv[]) {
   // running Chapel code.
   //
   chpl_comm_barrier("barrier before main");
+  startupMark(startup_rollcall);
 }
 
 //
@@ -258,7 +417,9 @@ void chpl_std_module_init(void) {
   // need to setup the literals on every locale before any other chapel code is
   // run.
   chpl__initStringLiterals();
+  startupMark(startup_string_literals);
   chpl__heapAllocateGlobals(); // allocate global vars on heap for multilocale
+  startupMark(startup_globals);
 
   if (chpl_nodeID == 0) {
     //
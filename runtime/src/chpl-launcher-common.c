@@ -26,9 +26,11 @@
 #include <sys/select.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
 #include "chplcgfns.h"
 #include "chpl-comm-launch.h"
 #include "chpl-comm-locales.h"
+#include "chpl-env.h"
 #include "chpllaunch.h"
 #include "chpl-mem.h"
 #include "chpltypes.h"
@@ -529,6 +531,60 @@ char* chpl_get_enviro_keys(char sep)
   return ret;
 }
 
+//
+// If CHPL_LAUNCHER_ENV_FILE is set, write our environment to a file in
+// the directory it names (the current directory if it's empty) and set
+// CHPL_RT_ENV_FILE to the file's path, so that the launcher only has
+// to propagate that one variable and each program instance can load
+// the rest itself at startup (see chpl_env_load_file()).  That keeps
+// large environments off the command lines of job launchers, which
+// can dominate startup time at scale.  The directory must be visible
+// on all the compute nodes.  Node 0 removes the file once everyone has
+// read it.
+//
+// Returns the file's path, or NULL if we aren't using an env file.
+//
+const char* chpl_launcher_write_env_file(void) {
+  static char fname[FILENAME_MAX];
+  const char* dir = getenv("CHPL_LAUNCHER_ENV_FILE");
+  FILE* f;
+  int i;
+
+  if (dir == NULL) {
+    return NULL;
+  }
+  if (fname[0] != '\0') {
+    return fname;
+  }
+
+  snprintf(fname, sizeof(fname), "%s/.chpl-env-%d",
+           (dir[0] == '\0') ? "." : dir, (int) getpid());
+  if ((f = fopen(fname, "w")) == NULL) {
+    char msg[FILENAME_MAX + 50];
+    snprintf(msg, sizeof(msg), "cannot create environment file '%s': %s",
+             fname, strerror(errno));
+    chpl_error(msg, 0, 0);
+  }
+
+  for (i = 0; environ && environ[i]; i++) {
+    if (strncmp(environ[i], "CHPL_RT_ENV_FILE=",
+                sizeof("CHPL_RT_ENV_FILE=") - 1) != 0) {
+      fputs(environ[i], f);
+      fputc('\0', f);
+    }
+  }
+
+  if (fclose(f) != 0) {
+    char msg[FILENAME_MAX + 50];
+    snprintf(msg, sizeof(msg), "cannot write environment file '%s': %s",
+             fname, strerror(errno));
+    chpl_error(msg, 0, 0);
+  }
+
+  chpl_env_set("CHPL_RT_ENV_FILE", fname, 1);
+  return fname;
+}
+
 static const int charset_env_nargs = 4;
 
 int chpl_get_charset_env_nargs()
@@ -732,8 +788,28 @@ int chpl_launch_prep(int* c_argc, char* argv[], int32_t* c_execNumLocales) {
 }
 
 
+static double launcher_secs(const struct timespec* from,
+                            const struct timespec* to) {
+  return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
 int chpl_launcher_main(int argc, char* argv[]) {
   int32_t execNumLocales;
+  const chpl_bool reportStartup = chpl_env_rt_get_bool("REPORT_STARTUP",
+                                                       false);
+  struct timespec tStart, tPrepped, tDone;
+
+  //
+  // With CHPL_RT_REPORT_STARTUP, pass our start time along so that the
+  // program can report how long it took to get launched, and report
+  // the launcher's own phases here.
+  //
+  if (reportStartup) {
+    (void) clock_gettime(CLOCK_REALTIME, &tStart);
+    chpl_env_set_uint("CHPL_RT_LAUNCH_START_NS",
+                      (uint64_t) tStart.tv_sec * 1000000000 + tStart.tv_nsec,
+                      1);
+  }
 
   //
   // The chpl_launch_prep function calls parseArgs, which modifies argc, so
@@ -744,11 +820,23 @@ int chpl_launcher_main(int argc, char* argv[]) {
     return -1;
   }
 
+  if (reportStartup) {
+    (void) clock_gettime(CLOCK_REALTIME, &tPrepped);
+    fprintf(stderr, "launcher: prep %.3f s\n",
+            launcher_secs(&tStart, &tPrepped));
+  }
+
   //
   // Launch the program.
   // This may not return (e.g., if calling chpl_launch_using_exec()).
   //
   int retval = chpl_launch(argc, argv, execNumLocales);
+
+  if (reportStartup) {
+    (void) clock_gettime(CLOCK_REALTIME, &tDone);
+    fprintf(stderr, "launcher: launch and run %.3f s\n",
+            launcher_secs(&tPrepped, &tDone));
+  }
   chpl_mem_free(chpl_real_binary_name, 0, 0);
   return retval;
 }
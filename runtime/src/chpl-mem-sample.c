@@ -0,0 +1,519 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Sampling heap profiler.
+//
+// If CHPL_RT_MEM_HEAP_PROFILE is set to a file name prefix, we sample
+// allocations on average once every CHPL_RT_MEM_HEAP_PROFILE_INTERVAL
+// bytes (default 512 KiB), recording the memory descriptor and the
+// source location of each sampled allocation.  At exit, and whenever
+// the CHPL_RT_MEM_HEAP_PROFILE_SIGNAL signal (default SIGUSR2) arrives,
+// each node writes a pprof-format profile to <prefix>.<node>.pb (or
+// <prefix>.<node>.<seq>.pb for signal-triggered ones).  The profile
+// has allocated and in-use objects and space, in the same sampled
+// form as Go and tcmalloc heap profiles, so 'pprof' can read it.
+//
+// Unlike --memTrack, unsampled allocations and frees cost only a
+// thread-local countdown and a check of whether anything sampled is
+// live, respectively.
+//
+
+#include "chplrt.h"
+
+#include "chplmemtrack.h"
+#include "chpl-comm.h"
+#include "chpl-env.h"
+#include "chpl-linefile-support.h"
+#include "chpl-mem-desc.h"
+#include "chpl-mem-sys.h"  // must not recurse into the tracked allocator
+#include "chpltypes.h"
+#include "error.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+size_t chpl_mem_sample_interval = 0;
+int chpl_mem_sample_nLive = 0;
+__thread int64_t chpl_mem_sample_countdown = 0;
+
+static const char* profilePrefix = NULL;
+
+static __thread int threadInited = 0;
+static __thread uint64_t threadRandState;
+static __thread int inSampler = 0;
+
+static volatile sig_atomic_t dumpRequested = 0;
+static int dumpSeq = 0;
+
+
+//
+// Allocation sites, keyed by descriptor and source location.  These
+// are only touched with the lock held.
+//
+typedef struct {
+  chpl_mem_descInt_t description;
+  int32_t lineno;
+  int32_t filename;
+  int used;
+  double allocCount;
+  double allocBytes;
+  double inuseCount;
+  double inuseBytes;
+} sampleSite_t;
+
+#define MAX_SITES 4096
+
+static sampleSite_t sites[MAX_SITES];
+static int numSites = 0;
+static size_t numDropped = 0;
+
+static pthread_mutex_t sampleLock = PTHREAD_MUTEX_INITIALIZER;
+
+//
+// Live sampled allocations.  This is an open-addressed table so that a
+// free can look for its address without taking the lock.  Insertions
+// happen only with the lock held; a free removes its entry by swapping
+// in a tombstone.
+//
+#define LIVE_EMPTY ((void*) 0)
+#define LIVE_TOMB  ((void*) 1)
+
+typedef struct {
+  void* ptr;
+  int site;
+  size_t size;
+} liveSample_t;
+
+#define LOG2_LIVE_SLOTS 17
+#define LIVE_SLOTS (1 << LOG2_LIVE_SLOTS)
+#define LIVE_MAX_PROBES 64
+
+static liveSample_t* live = NULL;
+
+
+static inline
+unsigned liveHash(void* p) {
+  uint64_t h = (uint64_t) ((uintptr_t) p >> 4) * UINT64_C(0x9e3779b97f4a7c15);
+  return (unsigned) (h >> (64 - LOG2_LIVE_SLOTS));
+}
+
+
+static inline
+uint64_t nextRand(void) {
+  // xorshift64*
+  uint64_t x = threadRandState;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  threadRandState = x;
+  return x * UINT64_C(0x2545f4914f6cdd1d);
+}
+
+
+// Draw the number of bytes until the next sample.  Distributing these
+// exponentially makes each byte equally likely to be sampled.
+static int64_t nextSampleInterval(void) {
+  double u = ((double) (nextRand() >> 11) + 0.5) / (double) (UINT64_C(1) << 53);
+  return (int64_t) (-log(u) * (double) chpl_mem_sample_interval) + 1;
+}
+
+
+// The expected number of allocations of 'size' bytes each sample of
+// that size represents.
+static double sampleWeight(size_t size) {
+  double p = 1.0 - exp(-(double) size / (double) chpl_mem_sample_interval);
+  return (p > 0.0) ? 1.0 / p : 1.0;
+}
+
+
+static int findSite(chpl_mem_descInt_t description,
+                    int32_t lineno, int32_t filename) {
+  unsigned h = ((unsigned) description * 31 + (unsigned) lineno) * 31
+               + (unsigned) filename;
+  for (int i = 0; i < MAX_SITES; i++) {
+    sampleSite_t* s = &sites[(h + i) % MAX_SITES];
+    if (!s->used) {
+      if (numSites >= MAX_SITES / 2)
+        return -1;
+      s->used = 1;
+      s->description = description;
+      s->lineno = lineno;
+      s->filename = filename;
+      numSites++;
+      return (h + i) % MAX_SITES;
+    }
+    if (s->description == description
+        && s->lineno == lineno && s->filename == filename)
+      return (h + i) % MAX_SITES;
+  }
+  return -1;
+}
+
+
+static void requestDump(int sig) {
+  dumpRequested = 1;
+}
+
+
+void chpl_mem_sample_init(void) {
+  const char* prefix = chpl_env_rt_get("MEM_HEAP_PROFILE", NULL);
+  if (prefix == NULL || prefix[0] == '\0') {
+    return;
+  }
+
+  size_t interval = chpl_env_rt_get_size("MEM_HEAP_PROFILE_INTERVAL",
+                                         512 * 1024);
+  if (interval == 0) {
+    return;
+  }
+
+  if ((live = sys_calloc(LIVE_SLOTS, sizeof(*live))) == NULL) {
+    chpl_warning("cannot allocate heap profiler table; not profiling", 0, 0);
+    return;
+  }
+
+  //
+  // Dumps on signal are done by the next thread to take a sample, not
+  // in the handler, where writing a file isn't safe.  We don't take
+  // over the signal if someone else already has.
+  //
+  int sig = chpl_env_rt_get_int("MEM_HEAP_PROFILE_SIGNAL", SIGUSR2);
+  if (sig > 0) {
+    struct sigaction sa;
+    if (sigaction(sig, NULL, &sa) == 0 && sa.sa_handler == SIG_DFL) {
+      memset(&sa, 0, sizeof(sa));
+      sa.sa_handler = requestDump;
+      sigemptyset(&sa.sa_mask);
+      sa.sa_flags = SA_RESTART;
+      (void) sigaction(sig, &sa, NULL);
+    }
+  }
+
+  profilePrefix = prefix;
+  chpl_mem_sample_interval = interval;
+}
+
+
+void chpl_mem_sample_record(void* memAlloc, size_t size,
+                            chpl_mem_descInt_t description,
+                            int32_t lineno, int32_t filename) {
+  if (inSampler) {
+    return;
+  }
+
+  if (!threadInited) {
+    // Start each thread at a random point in its first interval.
+    threadRandState = (uint64_t) (uintptr_t) &threadInited
+                      ^ (uint64_t) (uintptr_t) memAlloc
+                      ^ UINT64_C(0x5851f42d4c957f2d);
+    if (threadRandState == 0)
+      threadRandState = 1;
+    threadInited = 1;
+    chpl_mem_sample_countdown = nextSampleInterval();
+    return;
+  }
+
+  inSampler = 1;
+  chpl_mem_sample_countdown = nextSampleInterval();
+
+  double w = sampleWeight(size);
+
+  pthread_mutex_lock(&sampleLock);
+
+  int site = findSite(description, lineno, filename);
+  if (site < 0) {
+    numDropped++;
+  } else {
+    sites[site].allocCount += w;
+    sites[site].allocBytes += w * size;
+
+    unsigned h = liveHash(memAlloc);
+    int i;
+    for (i = 0; i < LIVE_MAX_PROBES; i++) {
+      liveSample_t* ls = &live[(h + i) & (LIVE_SLOTS - 1)];
+      void* p = __atomic_load_n(&ls->ptr, __ATOMIC_RELAXED);
+      if (p == LIVE_EMPTY || p == LIVE_TOMB) {
+        ls->site = site;
+        ls->size = size;
+        __atomic_store_n(&ls->ptr, memAlloc, __ATOMIC_RELEASE);
+        break;
+      }
+    }
+    if (i < LIVE_MAX_PROBES) {
+      sites[site].inuseCount += w;
+      sites[site].inuseBytes += w * size;
+      (void) __atomic_fetch_add(&chpl_mem_sample_nLive, 1, __ATOMIC_RELAXED);
+    }
+  }
+
+  pthread_mutex_unlock(&sampleLock);
+
+  if (dumpRequested) {
+    dumpRequested = 0;
+    chpl_mem_sample_dump(++dumpSeq);
+  }
+
+  inSampler = 0;
+}
+
+
+void chpl_mem_sample_forget(void* memAlloc) {
+  unsigned h = liveHash(memAlloc);
+
+  for (int i = 0; i < LIVE_MAX_PROBES; i++) {
+    liveSample_t* ls = &live[(h + i) & (LIVE_SLOTS - 1)];
+    void* p = __atomic_load_n(&ls->ptr, __ATOMIC_ACQUIRE);
+    if (p == LIVE_EMPTY) {
+      return;
+    }
+    if (p == memAlloc) {
+      int site = ls->site;
+      size_t size = ls->size;
+      if (!__atomic_compare_exchange_n(&ls->ptr, &p, LIVE_TOMB, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return;
+      }
+      double w = sampleWeight(size);
+      pthread_mutex_lock(&sampleLock);
+      sites[site].inuseCount -= w;
+      sites[site].inuseBytes -= w * size;
+      pthread_mutex_unlock(&sampleLock);
+      (void) __atomic_fetch_sub(&chpl_mem_sample_nLive, 1, __ATOMIC_RELAXED);
+      return;
+    }
+  }
+}
+
+
+//
+// Minimal protocol buffer encoding, just enough for pprof's profile.proto.
+//
+typedef struct {
+  unsigned char* p;
+  size_t len;
+  size_t cap;
+} pbuf_t;
+
+static void pb_bytes(pbuf_t* b, const void* src, size_t n) {
+  if (b->len + n > b->cap) {
+    size_t cap = (b->cap == 0) ? 4096 : b->cap;
+    while (b->len + n > cap)
+      cap *= 2;
+    unsigned char* p = sys_realloc(b->p, cap);
+    if (p == NULL)
+      chpl_internal_error("out of memory writing heap profile");
+    b->p = p;
+    b->cap = cap;
+  }
+  memcpy(b->p + b->len, src, n);
+  b->len += n;
+}
+
+static void pb_varint(pbuf_t* b, uint64_t v) {
+  unsigned char tmp[10];
+  int n = 0;
+  do {
+    tmp[n] = (v & 0x7f) | ((v > 0x7f) ? 0x80 : 0);
+    v >>= 7;
+    n++;
+  } while (v != 0);
+  pb_bytes(b, tmp, n);
+}
+
+static void pb_int(pbuf_t* b, int field, int64_t v) {
+  pb_varint(b, (uint64_t) field << 3);      // wire type 0: varint
+  pb_varint(b, (uint64_t) v);
+}
+
+static void pb_lenDelim(pbuf_t* b, int field, const void* src, size_t n) {
+  pb_varint(b, ((uint64_t) field << 3) | 2); // wire type 2: length-delimited
+  pb_varint(b, n);
+  pb_bytes(b, src, n);
+}
+
+static void pb_message(pbuf_t* b, int field, pbuf_t* sub) {
+  pb_lenDelim(b, field, sub->p, sub->len);
+  sub->len = 0;
+}
+
+
+// String table indices for the fixed strings.
+enum {
+  STR_EMPTY,
+  STR_ALLOC_OBJECTS,
+  STR_COUNT,
+  STR_ALLOC_SPACE,
+  STR_BYTES,
+  STR_INUSE_OBJECTS,
+  STR_INUSE_SPACE,
+  STR_SPACE,
+  STR_NUM_FIXED
+};
+
+static const char* fixedStrings[STR_NUM_FIXED] = {
+  "",
+  "alloc_objects",
+  "count",
+  "alloc_space",
+  "bytes",
+  "inuse_objects",
+  "inuse_space",
+  "space",
+};
+
+
+void chpl_mem_sample_dump(int seq) {
+  pbuf_t prof = { NULL, 0, 0 };
+  pbuf_t msg = { NULL, 0, 0 };
+  pbuf_t sub = { NULL, 0, 0 };
+  int64_t vals[4];
+
+  if (chpl_mem_sample_interval == 0) {
+    return;
+  }
+
+  //
+  // sample_type: the four values each sample has, in Go's order.
+  //
+  static const int sampleTypes[4][2] = {
+    { STR_ALLOC_OBJECTS, STR_COUNT },
+    { STR_ALLOC_SPACE, STR_BYTES },
+    { STR_INUSE_OBJECTS, STR_COUNT },
+    { STR_INUSE_SPACE, STR_BYTES },
+  };
+  for (int i = 0; i < 4; i++) {
+    pb_int(&msg, 1, sampleTypes[i][0]);
+    pb_int(&msg, 2, sampleTypes[i][1]);
+    pb_message(&prof, 1, &msg);
+  }
+
+  for (int i = 0; i < STR_NUM_FIXED; i++) {
+    pb_lenDelim(&prof, 6, fixedStrings[i], strlen(fixedStrings[i]));
+  }
+
+  //
+  // One sample, location, and function per site.  The function name is
+  // the memory descriptor, and its file and line are the allocation's.
+  // Each site adds two strings to the table after the fixed ones.
+  //
+  pthread_mutex_lock(&sampleLock);
+
+  int nextStr = STR_NUM_FIXED;
+  for (int s = 0; s < MAX_SITES; s++) {
+    sampleSite_t* site = &sites[s];
+    if (!site->used)
+      continue;
+
+    const uint64_t id = s + 1;
+    const char* desc = chpl_mem_descString(site->description);
+    const char* fname = (site->filename == 0)
+                        ? "--"
+                        : chpl_lookupFilename(site->filename);
+    const int descStr = nextStr++;
+    const int fnameStr = nextStr++;
+
+    pb_lenDelim(&prof, 6, desc, strlen(desc));
+    pb_lenDelim(&prof, 6, fname, strlen(fname));
+
+    // Sample: location_id (packed), value (packed)
+    pb_varint(&sub, id);
+    pb_message(&msg, 1, &sub);
+    vals[0] = (int64_t) llround(site->allocCount);
+    vals[1] = (int64_t) llround(site->allocBytes);
+    vals[2] = (int64_t) llround(site->inuseCount);
+    vals[3] = (int64_t) llround(site->inuseBytes);
+    for (int i = 0; i < 4; i++)
+      pb_varint(&sub, (uint64_t) (vals[i] < 0 ? 0 : vals[i]));
+    pb_message(&msg, 2, &sub);
+    pb_message(&prof, 2, &msg);
+
+    // Location: id, line { function_id, line }
+    pb_int(&msg, 1, id);
+    pb_int(&sub, 1, id);
+    pb_int(&sub, 2, site->lineno);
+    pb_message(&msg, 4, &sub);
+    pb_message(&prof, 4, &msg);
+
+    // Function: id, name, system_name, filename
+    pb_int(&msg, 1, id);
+    pb_int(&msg, 2, descStr);
+    pb_int(&msg, 3, descStr);
+    pb_int(&msg, 4, fnameStr);
+    pb_message(&prof, 5, &msg);
+  }
+
+  size_t dropped = numDropped;
+
+  pthread_mutex_unlock(&sampleLock);
+
+  // period_type, period
+  pb_int(&msg, 1, STR_SPACE);
+  pb_int(&msg, 2, STR_BYTES);
+  pb_message(&prof, 11, &msg);
+  pb_int(&prof, 12, chpl_mem_sample_interval);
+
+  char fname[FILENAME_MAX];
+  if (seq == 0) {
+    (void) snprintf(fname, sizeof(fname), "%s.%d.pb",
+                    profilePrefix, (int) chpl_nodeID);
+  } else {
+    (void) snprintf(fname, sizeof(fname), "%s.%d.%d.pb",
+                    profilePrefix, (int) chpl_nodeID, seq);
+  }
+
+  FILE* f;
+  if ((f = fopen(fname, "w")) == NULL) {
+    char msgBuf[FILENAME_MAX + 50];
+    (void) snprintf(msgBuf, sizeof(msgBuf),
+                    "cannot open heap profile file \"%s\"", fname);
+    chpl_warning(msgBuf, 0, 0);
+  } else {
+    (void) fwrite(prof.p, 1, prof.len, f);
+    (void) fclose(f);
+  }
+
+  if (dropped > 0 && seq == 0) {
+    char msgBuf[100];
+    (void) snprintf(msgBuf, sizeof(msgBuf),
+                    "heap profile: %zu samples dropped (too many sites)",
+                    dropped);
+    chpl_warning(msgBuf, 0, 0);
+  }
+
+  sys_free(prof.p);
+  sys_free(msg.p);
+  sys_free(sub.p);
+}
+
+
+void chpl_mem_sample_exit(void) {
+  if (chpl_mem_sample_interval == 0) {
+    return;
+  }
+  inSampler = 1;
+  chpl_mem_sample_dump(0);
+  chpl_mem_sample_interval = 0;
+}
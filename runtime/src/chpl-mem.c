@@ -23,29 +23,269 @@
 //
 #include "chplrt.h"
 
+#include "chpl-comm.h"
+#include "chpl-env.h"
+#include "chpl-gpu.h"
 #include "chpl-mem.h"
+#include "chpl-mem-sys.h"
+#include "chpl-topo.h"
 #include "chpltypes.h"
 #include "error.h"
 #include "chplsys.h"
 
+#include <pthread.h>
+#include <stdio.h>
+
 static int heapInitialized = 0;
 
+size_t chpl_mem_parallelZeroMin = 0;
+
+static chpl_bool gpuMemManaged = true;
+
+chpl_bool chpl_mem_numaCheck = false;
+static size_t numaCheckPages;
+static size_t numaCheckRemote;
+
 
 void chpl_mem_init(void) {
+  // Before the layer init, so the memory layer's own first chunks count.
+  chpl_mem_numaCheck = chpl_env_rt_get_bool("MEM_NUMA_CHECK", false);
   chpl_mem_layerInit();
+  chpl_mem_parallelZeroMin =
+    chpl_env_rt_get_size("MEM_PARALLEL_ZERO_MIN", (size_t) 64 << 20);
+  gpuMemManaged = chpl_env_rt_get_bool("MEM_GPU_MANAGED", true);
   heapInitialized = 1;
 }
 
 
 void chpl_mem_exit(void) {
+  if (chpl_mem_numaCheck) {
+    size_t nPages = __atomic_load_n(&numaCheckPages, __ATOMIC_RELAXED);
+    size_t nRemote = __atomic_load_n(&numaCheckRemote, __ATOMIC_RELAXED);
+    printf("%d: NUMA placement: %zd of %zd sampled pages (%.1f%%) "
+           "were on another domain\n",
+           (int) chpl_nodeID, nRemote, nPages,
+           (nPages == 0) ? 0.0 : 100.0 * nRemote / nPages);
+  }
   chpl_mem_layerExit();
 }
 
 
+void chpl_mem_checkNumaPlacementImpl(void* p, size_t size,
+                                     c_sublocid_t subloc) {
+  size_t nPages;
+  size_t nRemote;
+
+  chpl_topo_checkMemLocality(p, size, subloc, &nPages, &nRemote);
+  if (nPages > 0) {
+    (void) __atomic_fetch_add(&numaCheckPages, nPages, __ATOMIC_RELAXED);
+    (void) __atomic_fetch_add(&numaCheckRemote, nRemote, __ATOMIC_RELAXED);
+  }
+}
+
+
 int chpl_mem_inited(void) {
   return heapInitialized;
 }
 
+//
+// Parallel zeroing/first-touch.  We use plain pthreads rather than
+// tasks, so this works no matter what the tasking layer is up to.
+//
+typedef struct {
+  unsigned char* p;
+  size_t size;
+  size_t pgSize;
+  c_sublocid_t subloc;
+  chpl_bool zero;
+  pthread_t thread;
+  chpl_bool started;
+} touchChunk_t;
+
+static void touchRange(unsigned char* p, size_t size,
+                       size_t pgSize, chpl_bool zero) {
+  if (zero) {
+    memset(p, 0, size);
+  } else {
+    for (size_t off = 0; off < size; off += pgSize)
+      p[off] = 0;
+  }
+}
+
+static void* touchChunk(void* arg) {
+  touchChunk_t* c = (touchChunk_t*) arg;
+  if (c->subloc != c_sublocid_any)
+    chpl_topo_setThreadLocality(c->subloc);
+  touchRange(c->p, c->size, c->pgSize, c->zero);
+  chpl_mem_checkNumaPlacement(c->p, c->size, c->subloc);
+  return NULL;
+}
+
+void chpl_mem_touchParallel(void* p, size_t size, chpl_bool zero) {
+  // Below this much per thread, starting threads costs more than it saves.
+  const size_t minPerThread = (size_t) 16 << 20;
+  const int maxThreads = 256;
+
+  const size_t pgSize = chpl_getHeapPageSize();
+  unsigned char* pCh = (unsigned char*) p;
+  unsigned char* pPgLo;
+  unsigned char* pPgHi;
+  size_t nPages;
+  int numDomains;
+  int perDomain;
+  int nThreads;
+  touchChunk_t* chunks;
+
+  //
+  // Partial pages at the ends get done here; the thread chunks are
+  // whole pages.
+  //
+  pPgLo = (unsigned char*) (((uintptr_t) pCh + pgSize - 1) & ~(pgSize - 1));
+  pPgHi = (unsigned char*) (((uintptr_t) pCh + size) & ~(pgSize - 1));
+  if (pPgHi <= pPgLo) {
+    touchRange(pCh, size, pgSize, zero);
+    return;
+  }
+  nPages = (pPgHi - pPgLo) / pgSize;
+
+  nThreads = chpl_topo_getNumCPUsPhysical(true);
+  if (nThreads > maxThreads)
+    nThreads = maxThreads;
+  if (nThreads > (pPgHi - pPgLo) / minPerThread)
+    nThreads = (pPgHi - pPgLo) / minPerThread;
+
+  numDomains = chpl_topo_getNumNumaDomains();
+  if (numDomains < 1)
+    numDomains = 1;
+  if ((perDomain = nThreads / numDomains) < 1)
+    perDomain = 1;
+  nThreads = perDomain * numDomains;
+
+  if (nThreads <= 1
+      || (chunks = sys_calloc(nThreads, sizeof(*chunks))) == NULL) {
+    touchRange(pCh, size, pgSize, zero);
+    return;
+  }
+
+  touchRange(pCh, pPgLo - pCh, pgSize, zero);
+  touchRange(pPgHi, pCh + size - pPgHi, pgSize, zero);
+
+  for (int d = 0, i = 0; d < numDomains; d++) {
+    // This domain's pages, split the same way setMemSubchunkLocality does.
+    const size_t dLo = (d == 0) ? 0 : 1 + (nPages * d - 1) / numDomains;
+    const size_t dHi = (d == numDomains - 1)
+                       ? nPages
+                       : 1 + (nPages * (d + 1) - 1) / numDomains;
+    for (int t = 0; t < perDomain; t++, i++) {
+      const size_t lo = dLo + (dHi - dLo) * t / perDomain;
+      const size_t hi = dLo + (dHi - dLo) * (t + 1) / perDomain;
+      touchChunk_t* c = &chunks[i];
+      c->p = pPgLo + lo * pgSize;
+      c->size = (hi - lo) * pgSize;
+      c->pgSize = pgSize;
+      c->subloc = (numDomains > 1) ? d : c_sublocid_any;
+      c->zero = zero;
+      c->started = (pthread_create(&c->thread, NULL, touchChunk, c) == 0);
+      if (!c->started)
+        touchRange(c->p, c->size, pgSize, zero);
+    }
+  }
+
+  for (int i = 0; i < nThreads; i++) {
+    if (chunks[i].started)
+      (void) pthread_join(chunks[i].thread, NULL);
+  }
+
+  sys_free(chunks);
+}
+
+
+//
+// Pinned and sublocale memory.
+//
+static int sublocGpuDevice(c_sublocid_t subloc) {
+#ifdef HAS_GPU_LOCALE
+  return chpl_localeModel_sublocToGpuDevice(subloc);
+#else
+  return -1;
+#endif
+}
+
+// Whether pinned memory comes from the GPU layer; decided on first use.
+static int pinnedFromGpu = -1;
+
+static chpl_bool usePinnedFromGpu(void) {
+  if (pinnedFromGpu < 0)
+    pinnedFromGpu = (chpl_gpu_num_devices() > 0);
+  return pinnedFromGpu != 0;
+}
+
+void* chpl_mem_allocPinned(size_t size, chpl_mem_descInt_t description,
+                           int32_t lineno, int32_t filename) {
+  void* memAlloc;
+
+  chpl_memhook_malloc_pre(1, size, description, lineno, filename);
+  if (usePinnedFromGpu())
+    memAlloc = chpl_gpu_mem_alloc_host(size, lineno, filename);
+  else
+    memAlloc = chpl_memalign(chpl_getSysPageSize(), size);
+  chpl_memhook_malloc_post(memAlloc, 1, size, description, lineno, filename);
+
+  if (memAlloc != NULL)
+    chpl_comm_regMemAdd(memAlloc, size, -1);
+  return memAlloc;
+}
+
+void chpl_mem_freePinned(void* memAlloc, int32_t lineno, int32_t filename) {
+  if (memAlloc == NULL)
+    return;
+
+  chpl_comm_regMemRemove(memAlloc);
+  chpl_memhook_free_pre(memAlloc, lineno, filename);
+  if (usePinnedFromGpu())
+    chpl_gpu_mem_free_host(memAlloc, lineno, filename);
+  else
+    chpl_free(memAlloc);
+}
+
+void* chpl_mem_allocSubloc(size_t size, c_sublocid_t subloc,
+                           chpl_mem_descInt_t description,
+                           int32_t lineno, int32_t filename) {
+  const int dev = sublocGpuDevice(subloc);
+  void* memAlloc;
+
+  if (dev < 0)
+    return chpl_mem_alloc(size, description, lineno, filename);
+
+  chpl_memhook_malloc_pre(1, size, description, lineno, filename);
+  memAlloc = gpuMemManaged
+             ? chpl_gpu_mem_alloc_managed(dev, size, lineno, filename)
+             : chpl_gpu_mem_alloc(dev, size, lineno, filename);
+  chpl_memhook_malloc_post(memAlloc, 1, size, description, lineno, filename);
+
+  if (memAlloc != NULL)
+    chpl_comm_regMemAdd(memAlloc, size, dev);
+  return memAlloc;
+}
+
+void chpl_mem_freeSubloc(void* memAlloc, c_sublocid_t subloc,
+                         int32_t lineno, int32_t filename) {
+  const int dev = sublocGpuDevice(subloc);
+
+  if (dev < 0) {
+    chpl_mem_free(memAlloc, lineno, filename);
+    return;
+  }
+
+  if (memAlloc == NULL)
+    return;
+
+  chpl_comm_regMemRemove(memAlloc);
+  chpl_memhook_free_pre(memAlloc, lineno, filename);
+  chpl_gpu_mem_free(dev, memAlloc, lineno, filename);
+}
+
+
 int chpl_posix_memalign_check_valid(size_t alignment) {
   size_t tmp;
   int power;
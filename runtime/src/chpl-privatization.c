@@ -21,73 +21,64 @@
 #include "chplrt.h"
 #include "chpl-privatization.h"
 #include "chpl-mem.h"
-#include "chpl-atomics.h"
 
-static int64_t chpl_capPrivateObjects = 0;
-static atomic_spinlock_t lock;
-
-chpl_privateObject_t* chpl_privateObjects = NULL;
+chpl_privateObject_t* chpl_privateObjectSegs[CHPL_PRIVATIZATION_NUM_SEGS];
 
 void chpl_privatization_init(void) {
-  atomic_init_spinlock_t(&lock);
+  // Nothing to do: the directory starts out empty.
 }
 
-static inline int64_t max(int64_t a, int64_t b) {
-  return a > b ? a : b;
+// Get the segment for a pid, allocating it if it isn't there yet.  If
+// two tasks race to allocate the same segment, the loser frees its copy.
+static chpl_privateObject_t* getSeg(int seg) {
+  chpl_privateObject_t* p;
+  chpl_privateObject_t* expected = NULL;
+
+  p = __atomic_load_n(&chpl_privateObjectSegs[seg], __ATOMIC_ACQUIRE);
+  if (p != NULL)
+    return p;
+
+  p = chpl_mem_allocManyZero((size_t) 1 << (seg + CHPL_PRIVATIZATION_LOG2_SEG0),
+                             sizeof(chpl_privateObject_t),
+                             CHPL_RT_MD_COMM_PRV_OBJ_ARRAY, 0, 0);
+  if (!__atomic_compare_exchange_n(&chpl_privateObjectSegs[seg], &expected, p,
+                                   false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    chpl_mem_free(p, 0, 0);
+    p = expected;
+  }
+  return p;
 }
 
 // Note that this function can be called in parallel and more notably it can be
 // called with non-monotonic pid's. e.g. this may be called with pid 27, and
-// then pid 2, so it has to ensure that the privatized array has at least pid+1
-// elements. Be __very__ careful if you have to update it.
+// then pid 2.  Existing entries never move, so neither of these need a lock.
 void chpl_newPrivatizedClass(void* v, int64_t pid) {
-  atomic_lock_spinlock_t(&lock);
-
-  // initialize array to a default size
-  if (chpl_privateObjects == NULL) {
-    chpl_capPrivateObjects = 2*max(pid, 4);
-    chpl_privateObjects =
-        chpl_mem_allocManyZero(chpl_capPrivateObjects,
-                               sizeof(chpl_privateObject_t),
-                               CHPL_RT_MD_COMM_PRV_OBJ_ARRAY, 0, 0);
-  } else {
-    // if we're out of space, double (or more) the array size
-    if (pid >= chpl_capPrivateObjects) {
-      chpl_privateObject_t* tmp;
-      int64_t oldCap;
-
-      oldCap = chpl_capPrivateObjects;
-      chpl_capPrivateObjects = 2*max(pid, oldCap);
-
-      tmp = chpl_mem_allocManyZero(chpl_capPrivateObjects,
-                                   sizeof(chpl_privateObject_t),
-                                   CHPL_RT_MD_COMM_PRV_OBJ_ARRAY, 0, 0);
-      chpl_memcpy((void*)tmp, (void*)chpl_privateObjects,
-                  (oldCap)*sizeof(chpl_privateObject_t));
-      chpl_privateObjects = tmp;
-      // purposely leak old copies of chpl_privateObject to avoid the need to
-      // lock chpl_getPrivatizedClass; TODO: fix with lock free data structure
-    }
-  }
-  chpl_privateObjects[pid].obj = v;
-
-  atomic_unlock_spinlock_t(&lock);
+  int64_t off;
+  const int seg = chpl_privatization_seg(pid, &off);
+  __atomic_store_n(&getSeg(seg)[off].obj, v, __ATOMIC_RELEASE);
 }
 
 void chpl_clearPrivatizedClass(int64_t i) {
-  atomic_lock_spinlock_t(&lock);
-  chpl_privateObjects[i].obj = NULL;
-  atomic_unlock_spinlock_t(&lock);
+  int64_t off;
+  const int seg = chpl_privatization_seg(i, &off);
+  __atomic_store_n(&chpl_privateObjectSegs[seg][off].obj, NULL,
+                   __ATOMIC_RELEASE);
 }
 
 // Used to check for leaks of privatized classes
 int64_t chpl_numPrivatizedClasses(void) {
   int64_t ret = 0;
-  atomic_lock_spinlock_t(&lock);
-  for (int64_t i = 0; i < chpl_capPrivateObjects; i++) {
-    if (chpl_privateObjects[i].obj)
-      ret++;
+  for (int seg = 0; seg < CHPL_PRIVATIZATION_NUM_SEGS; seg++) {
+    chpl_privateObject_t* p =
+      __atomic_load_n(&chpl_privateObjectSegs[seg], __ATOMIC_ACQUIRE);
+    if (p == NULL)
+      continue;
+    for (int64_t i = 0;
+         i < ((int64_t) 1 << (seg + CHPL_PRIVATIZATION_LOG2_SEG0));
+         i++) {
+      if (__atomic_load_n(&p[i].obj, __ATOMIC_RELAXED))
+        ret++;
+    }
   }
-  atomic_unlock_spinlock_t(&lock);
   return ret;
 }
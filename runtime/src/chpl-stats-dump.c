@@ -0,0 +1,286 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// On-demand runtime statistics snapshots.
+//
+// If CHPL_RT_STATS_DUMP is set to a file name prefix, each node starts
+// a helper thread that, whenever asked, writes a snapshot of the node's
+// runtime statistics to <prefix>.<node>.<seq>.txt without stopping the
+// program.  The snapshot has the comm diagnostics counters (these are
+// only counted while comm diagnostics are on, and include the remote
+// cache's), the --memTrack totals, and the tasking layer's queued task,
+// blocked task and thread counts, and the time its threads have spent
+// spinning and parked while idle.
+//
+// A snapshot is asked for by sending the CHPL_RT_STATS_DUMP_SIGNAL
+// signal (default SIGUSR1, 0 for none) to a node's process, or, if
+// CHPL_RT_STATS_DUMP_SOCKET is set to a path prefix, by connecting to
+// the Unix domain socket <path>.<node>.  A socket client gets back the
+// name of the file that was written.
+//
+// The signal handler just writes a byte to a pipe.  The helper thread
+// waits on that and the socket, and does all the work.
+//
+
+#include "chplrt.h"
+
+#include "chpl-stats-dump.h"
+#include "chpl-comm.h"
+#include "chpl-comm-diags.h"
+#include "chpl-env.h"
+#include "chplmemtrack.h"
+#include "chpl-tasks.h"
+#include "error.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static const char* dumpPrefix = NULL;
+static int dumpSeq = 0;
+
+static int wakeFds[2] = { -1, -1 };
+static int listenFd = -1;
+static char sockPath[sizeof(((struct sockaddr_un*) 0)->sun_path)];
+
+static pthread_t helperThread;
+static chpl_bool helperRunning = false;
+
+
+static void requestDump(int sig) {
+  const char c = 'd';
+  int saveErrno = errno;
+  (void) write(wakeFds[1], &c, 1);
+  errno = saveErrno;
+}
+
+
+//
+// Write one snapshot, and return its file name in 'fname'.  Returns
+// false (after warning) if the file couldn't be written.
+//
+static chpl_bool writeDump(char* fname, size_t fnameSize) {
+  (void) snprintf(fname, fnameSize, "%s.%d.%d.txt",
+                  dumpPrefix, (int) chpl_nodeID, ++dumpSeq);
+  FILE* f;
+  if ((f = fopen(fname, "w")) == NULL) {
+    char msg[FILENAME_MAX + 50];
+    (void) snprintf(msg, sizeof(msg),
+                    "cannot open runtime stats file \"%s\"", fname);
+    chpl_warning(msg, 0, 0);
+    return false;
+  }
+
+  (void) fprintf(f, "node: %d of %d\n", (int) chpl_nodeID,
+                 (int) chpl_numNodes);
+  (void) fprintf(f, "time: %lld\n", (long long) time(NULL));
+
+  (void) fprintf(f, "\n[comm]\n");
+  (void) fprintf(f, "diagnostics_on: %d\n", chpl_comm_diagnostics);
+  chpl_commDiagnostics cd;
+  chpl_comm_getDiagnosticsHere(&cd);
+#define _STATS_DUMP_COUNTER(cdv) \
+  (void) fprintf(f, "%s: %" PRIu64 "\n", #cdv, cd.cdv);
+  CHPL_COMM_DIAGS_VARS_ALL(_STATS_DUMP_COUNTER);
+#undef _STATS_DUMP_COUNTER
+
+  (void) fprintf(f, "\n[memory]\n");
+  (void) fprintf(f, "tracking_on: %d\n", chpl_memTrack);
+  size_t allocNow, allocMax, allocSum, freeSum;
+  chpl_memTrack_getTotals(&allocNow, &allocMax, &allocSum, &freeSum);
+  (void) fprintf(f, "allocated_now: %zu\n", allocNow);
+  (void) fprintf(f, "allocated_high_water_mark: %zu\n", allocMax);
+  (void) fprintf(f, "sum_of_allocations: %zu\n", allocSum);
+  (void) fprintf(f, "sum_of_frees: %zu\n", freeSum);
+
+  (void) fprintf(f, "\n[tasks]\n");
+  (void) fprintf(f, "queued: %" PRIu32 "\n", chpl_task_getNumQueuedTasks());
+  (void) fprintf(f, "blocked: %" PRId32 "\n", chpl_task_getNumBlockedTasks());
+  (void) fprintf(f, "threads: %" PRIu32 "\n", chpl_task_getNumThreads());
+  (void) fprintf(f, "idle_threads: %" PRIu32 "\n",
+                 chpl_task_getNumIdleThreads());
+  double spinSecs, parkSecs;
+  chpl_task_getIdleTimes(&spinSecs, &parkSecs);
+  (void) fprintf(f, "idle_spin_seconds: %.6f\n", spinSecs);
+  (void) fprintf(f, "idle_park_seconds: %.6f\n", parkSecs);
+
+  if (fclose(f) != 0) {
+    char msg[FILENAME_MAX + 50];
+    (void) snprintf(msg, sizeof(msg),
+                    "cannot write runtime stats file \"%s\"", fname);
+    chpl_warning(msg, 0, 0);
+    return false;
+  }
+
+  return true;
+}
+
+
+static void* helper(void* arg) {
+  struct pollfd pfds[2] = {
+    { .fd = wakeFds[0], .events = POLLIN },
+    { .fd = listenFd, .events = POLLIN },
+  };
+  const nfds_t nPfds = (listenFd >= 0) ? 2 : 1;
+  char fname[FILENAME_MAX];
+
+  while (true) {
+    if (poll(pfds, nPfds, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      chpl_warning("poll() failed in runtime stats helper; stopping", 0, 0);
+      return NULL;
+    }
+
+    if ((pfds[0].revents & POLLIN) != 0) {
+      char c;
+      if (read(wakeFds[0], &c, 1) == 1) {
+        if (c == 'q') {
+          return NULL;
+        }
+        (void) writeDump(fname, sizeof(fname));
+      }
+    }
+
+    if (nPfds > 1 && (pfds[1].revents & POLLIN) != 0) {
+      int fd;
+      if ((fd = accept(listenFd, NULL, NULL)) >= 0) {
+        if (writeDump(fname, sizeof(fname))) {
+          (void) write(fd, fname, strlen(fname));
+          (void) write(fd, "\n", 1);
+        }
+        (void) close(fd);
+      }
+    }
+  }
+}
+
+
+static void openSocket(const char* pathPrefix) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (snprintf(sockPath, sizeof(sockPath), "%s.%d",
+               pathPrefix, (int) chpl_nodeID) >= (int) sizeof(sockPath)) {
+    chpl_warning("CHPL_RT_STATS_DUMP_SOCKET path is too long; not using it",
+                 0, 0);
+    sockPath[0] = '\0';
+    return;
+  }
+  strcpy(addr.sun_path, sockPath);
+
+  int fd;
+  if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+    chpl_warning("cannot create runtime stats socket", 0, 0);
+    sockPath[0] = '\0';
+    return;
+  }
+  (void) unlink(sockPath);
+  if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0
+      || listen(fd, 4) != 0) {
+    char msg[sizeof(sockPath) + 50];
+    (void) snprintf(msg, sizeof(msg),
+                    "cannot listen on runtime stats socket \"%s\"", sockPath);
+    chpl_warning(msg, 0, 0);
+    (void) close(fd);
+    sockPath[0] = '\0';
+    return;
+  }
+
+  (void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+  listenFd = fd;
+}
+
+
+void chpl_stats_dump_init(void) {
+  const char* prefix = chpl_env_rt_get("STATS_DUMP", NULL);
+  if (prefix == NULL || prefix[0] == '\0') {
+    return;
+  }
+  dumpPrefix = prefix;
+
+  if (pipe(wakeFds) != 0) {
+    chpl_warning("cannot create runtime stats pipe; not dumping stats", 0, 0);
+    return;
+  }
+  (void) fcntl(wakeFds[0], F_SETFD, FD_CLOEXEC);
+  (void) fcntl(wakeFds[1], F_SETFD, FD_CLOEXEC);
+  (void) fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+
+  const char* pathPrefix = chpl_env_rt_get("STATS_DUMP_SOCKET", NULL);
+  if (pathPrefix != NULL && pathPrefix[0] != '\0') {
+    openSocket(pathPrefix);
+  }
+
+  if (pthread_create(&helperThread, NULL, helper, NULL) != 0) {
+    chpl_warning("cannot start runtime stats thread; not dumping stats",
+                 0, 0);
+    return;
+  }
+  helperRunning = true;
+
+  //
+  // As with the heap profiler, we don't take over the signal if
+  // someone else already has.
+  //
+  int sig = chpl_env_rt_get_int("STATS_DUMP_SIGNAL", SIGUSR1);
+  if (sig > 0) {
+    struct sigaction sa;
+    if (sigaction(sig, NULL, &sa) == 0 && sa.sa_handler == SIG_DFL) {
+      memset(&sa, 0, sizeof(sa));
+      sa.sa_handler = requestDump;
+      sigemptyset(&sa.sa_mask);
+      sa.sa_flags = SA_RESTART;
+      (void) sigaction(sig, &sa, NULL);
+    }
+  }
+}
+
+
+void chpl_stats_dump_exit(void) {
+  if (!helperRunning) {
+    return;
+  }
+
+  const char c = 'q';
+  while (write(wakeFds[1], &c, 1) < 0
+         && (errno == EINTR || errno == EAGAIN))
+    ;
+  (void) pthread_join(helperThread, NULL);
+  helperRunning = false;
+
+  if (listenFd >= 0) {
+    (void) close(listenFd);
+    (void) unlink(sockPath);
+  }
+}
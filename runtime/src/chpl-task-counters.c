@@ -0,0 +1,417 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Hardware counters per task function.
+//
+// If CHPL_RT_TASK_COUNTERS is set to a file name prefix, each node
+// reads the CPU's cycle, instruction, last level cache miss and
+// backend stall counters when a task begins and ends, sums the
+// differences by the function the task runs, and at exit writes the
+// sums to <prefix>.<node>.csv.
+//
+// The counters come from Linux perf_event_open(2).  Each thread opens
+// one counter group, with cycles as the leader, the first time it runs
+// a task, so reading all the counters is a single read() and they are
+// scheduled onto the PMU together.  Counters the CPU or kernel doesn't
+// support are left out and reported as empty in the CSV.  If even the
+// cycle counter can't be opened (no PMU, or perf_event_paranoid too
+// high) we warn once and count nothing.
+//
+// Counts are per thread, so a task that blocks and lets another task
+// run on its thread is charged for that task's events too.
+//
+
+#include "chplrt.h"
+
+#include "chpl-task-counters.h"
+#include "chpl-comm.h"
+#include "chpl-env.h"
+#include "chpl-linefile-support.h"
+#include "chpl-mem-sys.h"  // tables are allocated outside the tracked heap
+#include "chpl-tasks.h"
+#include "chpl-tasks-callbacks.h"
+#include "chplcgfns.h"
+#include "error.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+typedef enum {
+  ctr_cycles,         // group leader
+  ctr_instructions,
+  ctr_llc_misses,
+  ctr_stalled_cycles,
+  ctr_num
+} ctr_kind_t;
+
+static const char* ctrNames[ctr_num] = {
+  "cycles",
+  "instructions",
+  "llc_misses",
+  "stalled_cycles",
+};
+
+typedef struct {
+  uint64_t tasks;
+  uint64_t v[ctr_num];
+} fidCounts_t;
+
+//
+// Tasks begun on this thread and not yet ended.  Nesting deeper than
+// this only happens with many blocked tasks; those past the limit
+// aren't counted.
+//
+#define CTR_STACK_MAX 64
+
+typedef struct {
+  uint64_t id;
+  int fid;
+  uint64_t start[ctr_num];
+} ctrFrame_t;
+
+typedef struct ctrThread_s {
+  int fd[ctr_num];          // -1 if the counter isn't available
+  int pos[ctr_num];         // position of the counter in a group read
+  int numOpen;
+  int depth;
+  ctrFrame_t stack[CTR_STACK_MAX];
+  struct ctrThread_s* next;
+  fidCounts_t counts[];     // numFids of them
+} ctrThread_t;
+
+static const char* ctrPrefix = NULL;
+static int numFids = 0;     // 0 means not counting
+
+static __thread ctrThread_t* myThread = NULL;
+static __thread int threadFailed = 0;
+
+static ctrThread_t* threads = NULL;
+static pthread_mutex_t threadLock = PTHREAD_MUTEX_INITIALIZER;
+
+// The union of the counters that opened on any thread.
+static int ctrSeen[ctr_num];
+static int openWarned = 0;
+
+
+#ifdef __linux__
+static int ctrOpen(ctr_kind_t k, int group) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  switch (k) {
+  case ctr_cycles:
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    break;
+  case ctr_instructions:
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+  case ctr_llc_misses:
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    break;
+  default:
+    attr.config = PERF_COUNT_HW_STALLED_CYCLES_BACKEND;
+    break;
+  }
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.disabled = (group == -1);
+
+  // This thread, any CPU.
+  return (int) syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+}
+#endif
+
+
+static ctrThread_t* threadInit(void) {
+  ctrThread_t* t;
+
+  if (threadFailed) {
+    return NULL;
+  }
+  if ((t = sys_calloc(1, sizeof(*t) + numFids * sizeof(fidCounts_t)))
+      == NULL) {
+    threadFailed = 1;
+    return NULL;
+  }
+
+  for (int k = 0; k < ctr_num; k++) {
+    t->fd[k] = -1;
+  }
+
+#ifdef __linux__
+  if ((t->fd[ctr_cycles] = ctrOpen(ctr_cycles, -1)) >= 0) {
+    t->pos[ctr_cycles] = t->numOpen++;
+    for (int k = ctr_cycles + 1; k < ctr_num; k++) {
+      if ((t->fd[k] = ctrOpen((ctr_kind_t) k, t->fd[ctr_cycles])) >= 0) {
+        t->pos[k] = t->numOpen++;
+      }
+    }
+    (void) ioctl(t->fd[ctr_cycles], PERF_EVENT_IOC_ENABLE,
+                 PERF_IOC_FLAG_GROUP);
+  }
+#endif
+
+  if (t->numOpen == 0) {
+    pthread_mutex_lock(&threadLock);
+    if (!openWarned) {
+      openWarned = 1;
+#ifdef __linux__
+      chpl_warning("cannot open hardware counters (see "
+                   "/proc/sys/kernel/perf_event_paranoid); "
+                   "CHPL_RT_TASK_COUNTERS is ignored", 0, 0);
+#else
+      chpl_warning("hardware counters need Linux perf events; "
+                   "CHPL_RT_TASK_COUNTERS is ignored", 0, 0);
+#endif
+    }
+    pthread_mutex_unlock(&threadLock);
+    sys_free(t);
+    threadFailed = 1;
+    return NULL;
+  }
+
+  pthread_mutex_lock(&threadLock);
+  for (int k = 0; k < ctr_num; k++) {
+    if (t->fd[k] >= 0) {
+      ctrSeen[k] = 1;
+    }
+  }
+  t->next = threads;
+  threads = t;
+  pthread_mutex_unlock(&threadLock);
+
+  myThread = t;
+  return t;
+}
+
+
+static int ctrRead(ctrThread_t* t, uint64_t* v) {
+#ifdef __linux__
+  // PERF_FORMAT_GROUP: the number of counters, then their values.
+  uint64_t buf[1 + ctr_num];
+  ssize_t want = (1 + t->numOpen) * sizeof(buf[0]);
+  if (read(t->fd[ctr_cycles], buf, want) != want) {
+    return 0;
+  }
+  for (int k = 0; k < ctr_num; k++) {
+    v[k] = (t->fd[k] >= 0) ? buf[1 + t->pos[k]] : 0;
+  }
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+
+static void cbTaskBegin(const chpl_task_cb_info_t* info) {
+  ctrThread_t* t = myThread;
+  if (numFids == 0 || (t == NULL && (t = threadInit()) == NULL)) {
+    return;
+  }
+
+  int fid = info->iu.full.fid;
+  if (t->depth >= CTR_STACK_MAX || fid < 0 || fid >= numFids) {
+    return;
+  }
+
+  ctrFrame_t* fr = &t->stack[t->depth];
+  if (!ctrRead(t, fr->start)) {
+    return;
+  }
+  fr->id = info->iu.full.id;
+  fr->fid = fid;
+  t->depth++;
+}
+
+
+static void cbTaskEnd(const chpl_task_cb_info_t* info) {
+  ctrThread_t* t = myThread;
+  if (numFids == 0 || t == NULL || t->depth == 0) {
+    return;
+  }
+
+  uint64_t now[ctr_num];
+  if (!ctrRead(t, now)) {
+    return;
+  }
+
+  //
+  // The ending task is usually the innermost one, but blocked tasks
+  // can finish in any order.  Tasks that end on other threads than
+  // they began on are never found here, and just aren't counted.
+  //
+  const uint64_t id = info->iu.id_only.id;
+  int i;
+  for (i = t->depth - 1; i >= 0 && t->stack[i].id != id; i--)
+    ;
+  if (i < 0) {
+    return;
+  }
+
+  ctrFrame_t* fr = &t->stack[i];
+  fidCounts_t* c = &t->counts[fr->fid];
+  c->tasks++;
+  for (int k = 0; k < ctr_num; k++) {
+    c->v[k] += now[k] - fr->start[k];
+  }
+
+  memmove(fr, fr + 1, (t->depth - i - 1) * sizeof(*fr));
+  t->depth--;
+}
+
+
+void chpl_task_counters_init(void) {
+  const char* prefix = chpl_env_rt_get("TASK_COUNTERS", NULL);
+  if (prefix == NULL || prefix[0] == '\0') {
+    return;
+  }
+
+  int n;
+  for (n = 0; chpl_finfo[n].name != NULL; n++)
+    ;
+  if (n == 0) {
+    return;
+  }
+
+  ctrPrefix = prefix;
+  numFids = n;
+
+  int failed = 0;
+  failed |= chpl_task_install_callback(chpl_task_cb_event_kind_begin,
+                                       chpl_task_cb_info_kind_full,
+                                       cbTaskBegin);
+  failed |= chpl_task_install_callback(chpl_task_cb_event_kind_end,
+                                       chpl_task_cb_info_kind_id_only,
+                                       cbTaskEnd);
+  if (failed) {
+    chpl_warning("cannot install task counter callbacks; "
+                 "CHPL_RT_TASK_COUNTERS is ignored", 0, 0);
+    (void) chpl_task_uninstall_callback(chpl_task_cb_event_kind_begin,
+                                        cbTaskBegin);
+    numFids = 0;
+  }
+}
+
+
+static void writeCsvString(FILE* f, const char* s) {
+  fputc('"', f);
+  for (; *s != '\0'; s++) {
+    if (*s == '"') {
+      fputc('"', f);
+    }
+    fputc(*s, f);
+  }
+  fputc('"', f);
+}
+
+
+void chpl_task_counters_exit(void) {
+  if (numFids == 0) {
+    return;
+  }
+
+  (void) chpl_task_uninstall_callback(chpl_task_cb_event_kind_begin,
+                                      cbTaskBegin);
+  (void) chpl_task_uninstall_callback(chpl_task_cb_event_kind_end,
+                                      cbTaskEnd);
+
+  const int n = numFids;
+  numFids = 0;
+
+  pthread_mutex_lock(&threadLock);
+
+  if (threads == NULL) {
+    // Either no tasks ran, or we already warned that we couldn't count.
+    pthread_mutex_unlock(&threadLock);
+    return;
+  }
+
+  // Sum all the threads into the first one.
+  fidCounts_t* sum = threads->counts;
+  for (ctrThread_t* t = threads->next; t != NULL; t = t->next) {
+    for (int fid = 0; fid < n; fid++) {
+      sum[fid].tasks += t->counts[fid].tasks;
+      for (int k = 0; k < ctr_num; k++) {
+        sum[fid].v[k] += t->counts[fid].v[k];
+      }
+    }
+  }
+
+  char fname[FILENAME_MAX];
+  (void) snprintf(fname, sizeof(fname), "%s.%d.csv",
+                  ctrPrefix, (int) chpl_nodeID);
+
+  FILE* f;
+  if ((f = fopen(fname, "w")) == NULL) {
+    pthread_mutex_unlock(&threadLock);
+    char msgBuf[FILENAME_MAX + 50];
+    (void) snprintf(msgBuf, sizeof(msgBuf),
+                    "cannot open task counters file \"%s\"", fname);
+    chpl_warning(msgBuf, 0, 0);
+    return;
+  }
+
+  //
+  // One line per task function that ran.  Counters that weren't
+  // available on this CPU are empty.
+  //
+  (void) fprintf(f, "fid,function,file,line,tasks");
+  for (int k = 0; k < ctr_num; k++) {
+    (void) fprintf(f, ",%s", ctrNames[k]);
+  }
+  (void) fprintf(f, "\n");
+
+  for (int fid = 0; fid < n; fid++) {
+    if (sum[fid].tasks == 0) {
+      continue;
+    }
+    const chpl_fn_info* fi = &chpl_finfo[fid];
+    (void) fprintf(f, "%d,", fid);
+    writeCsvString(f, fi->name);
+    fputc(',', f);
+    writeCsvString(f, chpl_lookupFilename(fi->fileno));
+    (void) fprintf(f, ",%d,%" PRIu64, fi->lineno, sum[fid].tasks);
+    for (int k = 0; k < ctr_num; k++) {
+      if (ctrSeen[k]) {
+        (void) fprintf(f, ",%" PRIu64, sum[fid].v[k]);
+      } else {
+        fputc(',', f);
+      }
+    }
+    fputc('\n', f);
+  }
+
+  pthread_mutex_unlock(&threadLock);
+  (void) fclose(f);
+}
@@ -23,17 +23,22 @@
 // tasks/<tasklayer>/tasks-<tasklayer>.c
 //
 #include "chplrt.h"
+#include "chpl-atomics.h"
 #include "chpl-comm.h"
+#include "chpl-mem.h"
 #include "chpl-tasks.h"
 #include "chpl-topo.h"
 #include "error.h"
 
+#include <errno.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/resource.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 
@@ -208,3 +213,235 @@ size_t chpl_task_getDefaultCallStackSize(void)
 
   return deflt;
 }
+
+
+int chpl_task_waitForFdYielding(int fd, int events, int64_t timeout_usec)
+{
+  struct pollfd  pfd;
+  struct timeval deadline;
+  struct timeval now;
+
+  pfd.fd = fd;
+  pfd.events = (((events & CHPL_TASK_FD_READ) != 0) ? POLLIN : 0)
+               | (((events & CHPL_TASK_FD_WRITE) != 0) ? POLLOUT : 0);
+
+  if (timeout_usec >= 0) {
+    gettimeofday(&deadline, NULL);
+    deadline.tv_sec += timeout_usec / 1000000;
+    deadline.tv_usec += timeout_usec % 1000000;
+    if (deadline.tv_usec >= 1000000) {
+      deadline.tv_sec++;
+      deadline.tv_usec -= 1000000;
+    }
+  }
+
+  while (1) {
+    int got = poll(&pfd, 1, 0);
+    if (got > 0)
+      return 0;
+    if (got < 0 && errno != EINTR)
+      return errno;
+
+    if (timeout_usec >= 0) {
+      gettimeofday(&now, NULL);
+      if (now.tv_sec > deadline.tv_sec
+          || (now.tv_sec == deadline.tv_sec
+              && now.tv_usec >= deadline.tv_usec))
+        return ETIMEDOUT;
+    }
+
+    chpl_task_yield();
+  }
+}
+
+
+//
+// Task arenas.  Chunks start small, because most tasks that use the
+// arena at all only need a little, and double up to a limit.  Requests
+// too big to fit well get a chunk of their own, which is put behind
+// the current chunk so the rest of that can still be used.
+//
+struct chpl_task_arenaChunk {
+  chpl_task_arenaChunk_t* next;
+  size_t size;
+};
+
+#define ARENA_ALIGN            16
+#define ARENA_HDR_SIZE         ((sizeof(chpl_task_arenaChunk_t) + ARENA_ALIGN - 1) \
+                                & ~(size_t) (ARENA_ALIGN - 1))
+#define ARENA_MIN_CHUNK_SIZE   ((size_t) 4 << 10)
+#define ARENA_MAX_CHUNK_SIZE   ((size_t) 64 << 10)
+
+void* chpl_task_arenaAlloc(size_t size, int32_t lineno, int32_t filename)
+{
+  chpl_task_infoRuntime_t* infoRuntime;
+  chpl_task_arena_t* a;
+  chpl_task_arenaChunk_t* c;
+  size_t chunkSize;
+  void* p;
+
+  if ((infoRuntime = chpl_task_getInfoRuntime()) == NULL)
+    return NULL;
+  a = &infoRuntime->arena;
+
+  size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+  if (size <= (size_t) (a->end - a->next)) {
+    p = a->next;
+    a->next += size;
+    return p;
+  }
+
+  if (a->chunks == NULL)
+    chunkSize = ARENA_MIN_CHUNK_SIZE;
+  else if ((chunkSize = 2 * a->chunks->size) > ARENA_MAX_CHUNK_SIZE)
+    chunkSize = ARENA_MAX_CHUNK_SIZE;
+
+  if (ARENA_HDR_SIZE + size > chunkSize / 2) {
+    c = chpl_mem_alloc(ARENA_HDR_SIZE + size, CHPL_RT_MD_TASK_ARENA,
+                       lineno, filename);
+    c->size = ARENA_HDR_SIZE + size;
+    if (a->chunks == NULL) {
+      c->next = NULL;
+      a->chunks = c;
+    } else {
+      c->next = a->chunks->next;
+      a->chunks->next = c;
+    }
+    return (char*) c + ARENA_HDR_SIZE;
+  }
+
+  c = chpl_mem_alloc(chunkSize, CHPL_RT_MD_TASK_ARENA, lineno, filename);
+  c->size = chunkSize;
+  c->next = a->chunks;
+  a->chunks = c;
+  p = (char*) c + ARENA_HDR_SIZE;
+  a->next = (char*) p + size;
+  a->end = (char*) c + chunkSize;
+  return p;
+}
+
+
+static void localsRelease(chpl_task_infoRuntime_t*);
+
+void chpl_task_arenaRelease(chpl_task_infoRuntime_t* infoRuntime)
+{
+  chpl_task_arena_t* a = &infoRuntime->arena;
+
+  // The task-local values table is in the arena, so it goes first.
+  localsRelease(infoRuntime);
+
+  while (a->chunks != NULL) {
+    chpl_task_arenaChunk_t* c = a->chunks;
+    a->chunks = c->next;
+    chpl_mem_free(c, 0, 0);
+  }
+  a->next = a->end = NULL;
+}
+
+
+//
+// Task-local storage.  The constructors and destructors for the keys
+// are written before the key is handed out.  Each task's values table
+// has room for every key and comes from its arena the first time the
+// task needs it, so it is freed along with the arena.
+//
+static atomic_int_least32_t localKeyCnt;
+static chpl_task_localCtor_t localCtors[CHPL_TASK_LOCAL_MAX_KEYS];
+static chpl_task_localDtor_t localDtors[CHPL_TASK_LOCAL_MAX_KEYS];
+
+void chpl_task_localsInit(void)
+{
+  atomic_init_int_least32_t(&localKeyCnt, 0);
+}
+
+
+chpl_task_localKey_t chpl_task_localKeyCreate(chpl_task_localCtor_t ctor,
+                                              chpl_task_localDtor_t dtor)
+{
+  int_least32_t key = atomic_fetch_add_int_least32_t(&localKeyCnt, 1);
+
+  if (key >= CHPL_TASK_LOCAL_MAX_KEYS) {
+    atomic_fetch_sub_int_least32_t(&localKeyCnt, 1);
+    return -1;
+  }
+
+  localCtors[key] = ctor;
+  localDtors[key] = dtor;
+  return (chpl_task_localKey_t) key;
+}
+
+
+static void** getLocals(chpl_task_infoRuntime_t* infoRuntime)
+{
+  if (infoRuntime->locals == NULL) {
+    size_t size = CHPL_TASK_LOCAL_MAX_KEYS * sizeof(void*);
+
+    infoRuntime->locals = chpl_task_arenaAlloc(size, 0, 0);
+    memset(infoRuntime->locals, 0, size);
+  }
+  return infoRuntime->locals;
+}
+
+
+void chpl_task_localSet(chpl_task_localKey_t key, void* value)
+{
+  chpl_task_infoRuntime_t* infoRuntime;
+
+  if ((infoRuntime = chpl_task_getInfoRuntime()) == NULL)
+    chpl_internal_error("task-local value set outside of a task");
+  getLocals(infoRuntime)[key] = value;
+}
+
+
+void* chpl_task_localGetSlow(chpl_task_localKey_t key)
+{
+  chpl_task_infoRuntime_t* infoRuntime;
+  void** locals;
+
+  if ((infoRuntime = chpl_task_getInfoRuntime()) == NULL)
+    return NULL;
+
+  locals = getLocals(infoRuntime);
+  if (locals[key] == NULL && localCtors[key] != NULL)
+    locals[key] = (*localCtors[key])();
+  return locals[key];
+}
+
+
+//
+// Destructors can use task-local values themselves, so this goes
+// around again while a pass destroys anything, up to a limit in case
+// they keep creating new values.
+//
+#define LOCALS_DTOR_PASSES 4
+
+static void localsRelease(chpl_task_infoRuntime_t* infoRuntime)
+{
+  void** locals = infoRuntime->locals;
+  chpl_bool again = true;
+  int pass;
+
+  if (locals == NULL)
+    return;
+
+  for (pass = 0; again && pass < LOCALS_DTOR_PASSES; pass++) {
+    int_least32_t cnt = atomic_load_int_least32_t(&localKeyCnt);
+    int_least32_t i;
+
+    again = false;
+    if (cnt > CHPL_TASK_LOCAL_MAX_KEYS)
+      cnt = CHPL_TASK_LOCAL_MAX_KEYS;
+    for (i = 0; i < cnt; i++) {
+      void* value = locals[i];
+
+      if (value != NULL) {
+        locals[i] = NULL;
+        if (localDtors[i] != NULL) {
+          (*localDtors[i])(value);
+          again = true;
+        }
+      }
+    }
+  }
+  infoRuntime->locals = NULL;
+}
@@ -24,6 +24,7 @@
 
 #include "chpltimers.h"
 
+#include <pthread.h>
 #include <time.h>   // For struct tm.
 
 _timevalue chpl_null_timevalue(void) {
@@ -56,3 +57,38 @@ void chpl_timevalue_parts(_timevalue t, int32_t* seconds, int32_t* minutes, int3
   if( yday ) *yday = localt.tm_yday;
   if( isdst ) *isdst = localt.tm_isdst;
 }
+
+
+static double cycleRate;
+static pthread_once_t cycleRateOnce = PTHREAD_ONCE_INIT;
+
+static void cycle_rate_init(void) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  //
+  // Count cycles across about 10 ms of the monotonic clock.  Reading
+  // the clock on both sides of each cycle count and using the middle
+  // keeps the read costs out of the result.
+  //
+  uint64_t t0a = chpl_now_monotonic_ns();
+  uint64_t c0 = chpl_cycle_count();
+  uint64_t t0b = chpl_now_monotonic_ns();
+  uint64_t t1a, t1b, c1;
+  do {
+    t1a = chpl_now_monotonic_ns();
+    c1 = chpl_cycle_count();
+    t1b = chpl_now_monotonic_ns();
+  } while (t1a - t0b < 10000000);
+  cycleRate = (c1 - c0) * 2e9 / ((t1a + t1b) - (t0a + t0b));
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+  uint64_t freq;
+  __asm__ __volatile__ ("mrs %0, cntfrq_el0" : "=r" (freq));
+  cycleRate = (double) freq;
+#else
+  cycleRate = 1e9;
+#endif
+}
+
+double chpl_cycle_rate(void) {
+  (void) pthread_once(&cycleRateOnce, cycle_rate_init);
+  return cycleRate;
+}
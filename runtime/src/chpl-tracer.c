@@ -0,0 +1,374 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Task and communication event tracer.
+//
+// If CHPL_RT_TRACE is set to a file name prefix, each node records its
+// task create/begin/end and comm callback events, and at exit writes
+// them to <prefix>.<node>.json in the Chrome trace event format, which
+// chrome://tracing, Perfetto and other trace viewers read.  Timestamps
+// are wall clock times, so the files from all nodes can be loaded
+// together.
+//
+// Each thread records into its own ring of CHPL_RT_TRACE_EVENTS events
+// (default 65536, rounded up to a power of 2), so recording an event
+// takes no locks and writes no shared memory.  When a ring fills, its
+// oldest events are overwritten; we warn about that at exit.
+//
+
+#include "chplrt.h"
+
+#include "chpl-tracer.h"
+#include "chpl-atomics.h"
+#include "chpl-comm.h"
+#include "chpl-comm-callbacks.h"
+#include "chpl-env.h"
+#include "chpl-linefile-support.h"
+#include "chpl-mem-sys.h"  // rings are allocated outside the tracked heap
+#include "chpl-tasks.h"
+#include "chpl-tasks-callbacks.h"
+#include "error.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+//
+// Event kinds are the task callback kinds followed by the comm ones.
+//
+#define TRACE_COMM_KIND(k) (chpl_task_cb_num_event_kinds + (k))
+#define TRACE_NUM_KINDS TRACE_COMM_KIND(chpl_comm_cb_num_event_kinds)
+
+static const char* kindNames[TRACE_NUM_KINDS] = {
+  [chpl_task_cb_event_kind_create] = "create",
+  [chpl_task_cb_event_kind_begin] = "task",
+  [chpl_task_cb_event_kind_end] = "task",
+  [TRACE_COMM_KIND(chpl_comm_cb_event_kind_put)] = "put",
+  [TRACE_COMM_KIND(chpl_comm_cb_event_kind_put_nb)] = "put_nb",
+  [TRACE_COMM_KIND(chpl_comm_cb_event_kind_put_strd)] = "put_strd",
+  [TRACE_COMM_KIND(chpl_comm_cb_event_kind_get)] = "get",
+  [TRACE_COMM_KIND(chpl_comm_cb_event_kind_get_nb)] = "get_nb",
+  [TRACE_COMM_KIND(chpl_comm_cb_event_kind_get_strd)] = "get_strd",
+  [TRACE_COMM_KIND(chpl_comm_cb_event_kind_executeOn)] = "executeOn",
+  [TRACE_COMM_KIND(chpl_comm_cb_event_kind_executeOn_nb)] = "executeOn_nb",
+  [TRACE_COMM_KIND(chpl_comm_cb_event_kind_executeOn_fast)] = "executeOn_fast",
+};
+
+typedef struct {
+  uint64_t time;        // ns since the epoch
+  uint64_t id;          // task ID
+  int64_t size;         // bytes moved; function ID for creates
+  int32_t kind;
+  int32_t node;         // remote node; is_executeOn for creates
+  int32_t lineno;
+  int32_t filename;
+} traceEvent_t;
+
+//
+// Only the owning thread writes a ring.  It publishes each event by
+// advancing head with a release store, so the exit-time reader sees
+// whole events.
+//
+typedef struct traceRing_s {
+  atomic_uint_least64_t head;  // number of events ever recorded
+  int tid;
+  struct traceRing_s* next;
+  traceEvent_t ev[];
+} traceRing_t;
+
+static const char* tracePrefix = NULL;
+static uint64_t ringSize = 0;  // 0 means not tracing
+
+static __thread traceRing_t* myRing = NULL;
+static __thread int ringFailed = 0;
+
+static traceRing_t* rings = NULL;
+static int numRings = 0;
+static pthread_mutex_t ringLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static traceRing_t* ringInit(void) {
+  traceRing_t* r;
+
+  if (ringFailed) {
+    return NULL;
+  }
+  if ((r = sys_malloc(sizeof(*r) + ringSize * sizeof(traceEvent_t))) == NULL) {
+    ringFailed = 1;
+    return NULL;
+  }
+  atomic_init_uint_least64_t(&r->head, 0);
+
+  pthread_mutex_lock(&ringLock);
+  r->tid = numRings++;
+  r->next = rings;
+  rings = r;
+  pthread_mutex_unlock(&ringLock);
+
+  myRing = r;
+  return r;
+}
+
+
+static inline
+void traceRecord(int kind, uint64_t id, int64_t size, int32_t node,
+                 int32_t lineno, int32_t filename) {
+  const uint64_t nSlots = ringSize;
+  traceRing_t* r = myRing;
+  if (nSlots == 0 || (r == NULL && (r = ringInit()) == NULL)) {
+    return;
+  }
+
+  struct timespec ts;
+  (void) clock_gettime(CLOCK_REALTIME, &ts);
+
+  uint_least64_t h = atomic_load_explicit_uint_least64_t(&r->head,
+                                                         memory_order_relaxed);
+  traceEvent_t* e = &r->ev[h & (nSlots - 1)];
+  e->time = (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+  e->id = id;
+  e->size = size;
+  e->kind = kind;
+  e->node = node;
+  e->lineno = lineno;
+  e->filename = filename;
+  atomic_store_explicit_uint_least64_t(&r->head, h + 1, memory_order_release);
+}
+
+
+static void cbTaskCreate(const chpl_task_cb_info_t* info) {
+  traceRecord(chpl_task_cb_event_kind_create, info->iu.full.id,
+              info->iu.full.fid, info->iu.full.is_executeOn,
+              info->iu.full.lineno, info->iu.full.filename);
+}
+
+static void cbTaskBegin(const chpl_task_cb_info_t* info) {
+  traceRecord(chpl_task_cb_event_kind_begin, info->iu.id_only.id, 0, 0, 0, 0);
+}
+
+static void cbTaskEnd(const chpl_task_cb_info_t* info) {
+  traceRecord(chpl_task_cb_event_kind_end, info->iu.id_only.id, 0, 0, 0, 0);
+}
+
+static void cbComm(const chpl_comm_cb_info_t* info) {
+  int64_t size = 0;
+  int32_t lineno = 0;
+  int32_t filename = 0;
+
+  switch (info->event_kind) {
+  case chpl_comm_cb_event_kind_put:
+  case chpl_comm_cb_event_kind_put_nb:
+  case chpl_comm_cb_event_kind_get:
+  case chpl_comm_cb_event_kind_get_nb:
+    size = info->iu.comm.size;
+    lineno = info->iu.comm.lineno;
+    filename = info->iu.comm.filename;
+    break;
+  case chpl_comm_cb_event_kind_put_strd:
+  case chpl_comm_cb_event_kind_get_strd:
+    size = info->iu.comm_strd.elemSize;
+    for (int32_t i = 0; i < info->iu.comm_strd.stridelevels; i++) {
+      size *= info->iu.comm_strd.count[i];
+    }
+    lineno = info->iu.comm_strd.lineno;
+    filename = info->iu.comm_strd.filename;
+    break;
+  case chpl_comm_cb_event_kind_executeOn:
+  case chpl_comm_cb_event_kind_executeOn_nb:
+  case chpl_comm_cb_event_kind_executeOn_fast:
+    size = info->iu.executeOn.arg_size;
+    lineno = info->iu.executeOn.lineno;
+    filename = info->iu.executeOn.filename;
+    break;
+  default:
+    return;
+  }
+
+  traceRecord(TRACE_COMM_KIND(info->event_kind), chpl_task_getId(), size,
+              info->remoteNodeID, lineno, filename);
+}
+
+
+void chpl_trace_init(void) {
+  const char* prefix = chpl_env_rt_get("TRACE", NULL);
+  if (prefix == NULL || prefix[0] == '\0') {
+    return;
+  }
+
+  int64_t events = chpl_env_rt_get_int("TRACE_EVENTS", 65536);
+  if (events <= 0) {
+    return;
+  }
+  uint64_t size = 1;
+  while (size < (uint64_t) events) {
+    size <<= 1;
+  }
+
+  tracePrefix = prefix;
+  ringSize = size;
+
+  int failed = 0;
+  failed |= chpl_task_install_callback(chpl_task_cb_event_kind_create,
+                                       chpl_task_cb_info_kind_full,
+                                       cbTaskCreate);
+  failed |= chpl_task_install_callback(chpl_task_cb_event_kind_begin,
+                                       chpl_task_cb_info_kind_id_only,
+                                       cbTaskBegin);
+  failed |= chpl_task_install_callback(chpl_task_cb_event_kind_end,
+                                       chpl_task_cb_info_kind_id_only,
+                                       cbTaskEnd);
+  for (int k = 0; k < chpl_comm_cb_num_event_kinds; k++) {
+    failed |= chpl_comm_install_callback((chpl_comm_cb_event_kind_t) k,
+                                         cbComm);
+  }
+  if (failed) {
+    chpl_warning("cannot install all tracer callbacks; trace is incomplete",
+                 0, 0);
+  }
+}
+
+
+//
+// JSON strings we write are file names, so this only needs to escape
+// quotes, backslashes and control characters.
+//
+static void writeJsonString(FILE* f, const char* s) {
+  fputc('"', f);
+  for (; *s != '\0'; s++) {
+    unsigned char c = (unsigned char) *s;
+    if (c == '"' || c == '\\') {
+      fputc('\\', f);
+      fputc(c, f);
+    } else if (c < 0x20) {
+      fprintf(f, "\\u%04x", c);
+    } else {
+      fputc(c, f);
+    }
+  }
+  fputc('"', f);
+}
+
+
+static void writeEvent(FILE* f, const traceRing_t* r, const traceEvent_t* e) {
+  const int node = (int) chpl_nodeID;
+
+  fprintf(f, ",\n{\"name\":\"%s\",\"pid\":%d,\"tid\":%d,"
+          "\"ts\":%" PRIu64 ".%03u,",
+          kindNames[e->kind], node, r->tid,
+          e->time / 1000, (unsigned) (e->time % 1000));
+
+  switch (e->kind) {
+  case chpl_task_cb_event_kind_begin:
+  case chpl_task_cb_event_kind_end:
+    // Async events, since a task can move between threads and
+    // tasks on one thread don't nest.
+    fprintf(f, "\"cat\":\"task\",\"ph\":\"%s\","
+            "\"id2\":{\"local\":\"%" PRIu64 "\"}}",
+            e->kind == chpl_task_cb_event_kind_begin ? "b" : "e", e->id);
+    return;
+  case chpl_task_cb_event_kind_create:
+    fprintf(f, "\"cat\":\"task\",\"ph\":\"i\",\"s\":\"t\","
+            "\"args\":{\"task\":%" PRIu64 ",\"on\":%d,\"fid\":%" PRId64 ",",
+            e->id, (int) e->node, e->size);
+    break;
+  default:
+    fprintf(f, "\"cat\":\"comm\",\"ph\":\"i\",\"s\":\"t\","
+            "\"args\":{\"task\":%" PRIu64 ",\"remote\":%d,"
+            "\"bytes\":%" PRId64 ",",
+            e->id, (int) e->node, e->size);
+    break;
+  }
+
+  fputs("\"file\":", f);
+  writeJsonString(f, e->filename == 0 ? "--" : chpl_lookupFilename(e->filename));
+  fprintf(f, ",\"line\":%d}}", (int) e->lineno);
+}
+
+
+void chpl_trace_exit(void) {
+  if (ringSize == 0) {
+    return;
+  }
+
+  (void) chpl_task_uninstall_callback(chpl_task_cb_event_kind_create,
+                                      cbTaskCreate);
+  (void) chpl_task_uninstall_callback(chpl_task_cb_event_kind_begin,
+                                      cbTaskBegin);
+  (void) chpl_task_uninstall_callback(chpl_task_cb_event_kind_end,
+                                      cbTaskEnd);
+  for (int k = 0; k < chpl_comm_cb_num_event_kinds; k++) {
+    (void) chpl_comm_uninstall_callback((chpl_comm_cb_event_kind_t) k, cbComm);
+  }
+
+  char fname[FILENAME_MAX];
+  (void) snprintf(fname, sizeof(fname), "%s.%d.json",
+                  tracePrefix, (int) chpl_nodeID);
+
+  FILE* f;
+  if ((f = fopen(fname, "w")) == NULL) {
+    char msgBuf[FILENAME_MAX + 50];
+    (void) snprintf(msgBuf, sizeof(msgBuf),
+                    "cannot open trace file \"%s\"", fname);
+    chpl_warning(msgBuf, 0, 0);
+    ringSize = 0;
+    return;
+  }
+
+  fprintf(f, "{\"traceEvents\":[\n"
+          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+          "\"args\":{\"name\":\"locale %d\"}}",
+          (int) chpl_nodeID, (int) chpl_nodeID);
+
+  uint64_t overwritten = 0;
+
+  pthread_mutex_lock(&ringLock);
+  for (traceRing_t* r = rings; r != NULL; r = r->next) {
+    uint64_t head = atomic_load_explicit_uint_least64_t(&r->head,
+                                                        memory_order_acquire);
+    uint64_t first = (head > ringSize) ? head - ringSize : 0;
+    overwritten += first;
+
+    fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+            "\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+            (int) chpl_nodeID, r->tid, r->tid);
+    for (uint64_t i = first; i < head; i++) {
+      writeEvent(f, r, &r->ev[i & (ringSize - 1)]);
+    }
+  }
+  pthread_mutex_unlock(&ringLock);
+
+  fputs("\n]}\n", f);
+  (void) fclose(f);
+
+  if (overwritten > 0) {
+    char msgBuf[150];
+    (void) snprintf(msgBuf, sizeof(msgBuf),
+                    "trace: %" PRIu64 " early events were overwritten "
+                    "(see CHPL_RT_TRACE_EVENTS)", overwritten);
+    chpl_warning(msgBuf, 0, 0);
+  }
+
+  ringSize = 0;
+}
@@ -23,7 +23,13 @@
 //
 
 #include "chpl-visual-debug.h"
+#include "chpl-visual-debug-format.h"
 #include "chplrt.h"
+#include "chpl-atomics.h"
+#include "chpl-env.h"
+#include "chpl-mem-sys.h"
+#include "chpl-threads.h"
+#include "chpl-thread-local-storage.h"
 #include "chpl-comm.h"
 #include "chpl-tasks.h"
 #include "chpl-tasks-callbacks.h"
@@ -34,6 +40,7 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/types.h>
@@ -67,8 +74,24 @@ int chpl_vdebug = 0;
 
 #define TID_STRING(buff, tid) (chpl_task_idToString(buff, CHPL_TASK_ID_STRING_MAX_LEN, tid))
 
-#define VDEBUG_GETPUT_FORMAT_NAMES "kind tv srcNodeID dstNodeID commTaskID addr raddr elemSize length commID lineNumber fileno"
-#define VDEBUG_GETPUT_FORMAT_STRING "%s: %lld.%06ld %d %d %s %#lx %#lx %zd %zd %d %d %d\n"
+// Binary records (CHPL_RT_VDEBUG_BINARY) are collected in per-thread
+// buffers and written a buffer at a time; text records are written as
+// they happen.  See chpl-visual-debug-format.h.
+#define VDEBUG_BUF_SIZE (64 * 1024)
+
+typedef struct vdebug_buf_s {
+  chpl_thread_mutex_t lock;
+  size_t len;
+  struct vdebug_buf_s* next;
+  unsigned char data[VDEBUG_BUF_SIZE];
+} vdebug_buf_t;
+
+static int vdebug_binary = 0;
+static int vdebug_inited = 0;
+static atomic_uint_least64_t vdebug_seq;
+static CHPL_TLS_DECL(vdebug_buf_t*, vdebug_tbuf);
+static vdebug_buf_t* vdebug_bufs = NULL;
+static chpl_thread_mutex_t vdebug_bufs_lock;
 
 int chpl_dprintf (int fd, const char * format, ...) {
   char buffer[2048]; 
@@ -87,6 +110,158 @@ int chpl_dprintf (int fd, const char * format, ...) {
   return -1;
 }
 
+static void vdebug_write (const void *data, size_t len) {
+  size_t off = 0;
+  while (off < len && chpl_vdebug_fd >= 0) {
+    ssize_t wrv = write (chpl_vdebug_fd, (const char *) data + off, len - off);
+    if (wrv < 0 && errno == EINTR) continue;
+    if (wrv <= 0) break;
+    off += wrv;
+  }
+}
+
+// Write out a thread buffer.  The caller holds its lock.
+
+static void vdebug_flush_buf (vdebug_buf_t *b) {
+  vdebug_write (b->data, b->len);
+  b->len = 0;
+}
+
+static void vdebug_flush_all (void) {
+  vdebug_buf_t *b;
+  if (!vdebug_inited) return;
+  chpl_thread_mutexLock (&vdebug_bufs_lock);
+  for (b = vdebug_bufs; b != NULL; b = b->next) {
+    chpl_thread_mutexLock (&b->lock);
+    vdebug_flush_buf (b);
+    chpl_thread_mutexUnlock (&b->lock);
+  }
+  chpl_thread_mutexUnlock (&vdebug_bufs_lock);
+}
+
+static vdebug_buf_t *vdebug_get_buf (void) {
+  vdebug_buf_t *b = CHPL_TLS_GET(vdebug_tbuf);
+  if (b == NULL) {
+    b = (vdebug_buf_t *) sys_malloc (sizeof (vdebug_buf_t));
+    if (b == NULL) return NULL;
+    chpl_thread_mutexInit (&b->lock);
+    b->len = 0;
+    chpl_thread_mutexLock (&vdebug_bufs_lock);
+    b->next = vdebug_bufs;
+    vdebug_bufs = b;
+    chpl_thread_mutexUnlock (&vdebug_bufs_lock);
+    CHPL_TLS_SET(vdebug_tbuf, b);
+  }
+  return b;
+}
+
+static void vdebug_rec_init (chpl_vdebug_rec_t *r, int kind,
+                             const struct timeval *tv) {
+  r->kind = kind;
+  r->nfields = 0;
+  r->seq = 0;
+  r->sec = tv ? tv->tv_sec : 0;
+  r->usec = tv ? tv->tv_usec : 0;
+}
+
+// Log a record, in binary or as its text line.
+
+static void vdebug_put (chpl_vdebug_rec_t *r, const char *str) {
+  if (chpl_vdebug_fd < 0) return;
+
+  if (vdebug_binary) {
+    unsigned char rec[CHPL_VDEBUG_REC_MAX_BYTES + 512];
+    size_t slen = str ? strlen (str) : 0;
+    size_t len;
+    vdebug_buf_t *b;
+
+    if (slen > 512) slen = 512;
+    r->seq = atomic_fetch_add_uint_least64_t (&vdebug_seq, 1);
+    len = chpl_vdebug_rec_encode (r, str, slen, rec);
+
+    b = vdebug_get_buf ();
+    if (b == NULL) {
+      vdebug_write (rec, len);
+      return;
+    }
+    chpl_thread_mutexLock (&b->lock);
+    if (b->len + len > VDEBUG_BUF_SIZE)
+      vdebug_flush_buf (b);
+    memcpy (b->data + b->len, rec, len);
+    b->len += len;
+    chpl_thread_mutexUnlock (&b->lock);
+  } else {
+    char buffer[2048];
+    int retval = chpl_vdebug_rec_format (r, str, buffer, sizeof (buffer));
+    if (retval > 0)
+      vdebug_write (buffer, retval < (int) sizeof (buffer)
+                            ? (size_t) retval : sizeof (buffer) - 1);
+  }
+}
+
+// Get/put records all have the same fields.
+
+static void vdebug_comm (int kind, const chpl_comm_cb_info_t *info,
+                         void *addr, void *raddr, size_t elemSize,
+                         size_t length, int commID, int lineno, int fileno) {
+  struct timeval tv;
+  chpl_vdebug_rec_t r;
+  (void) gettimeofday (&tv, NULL);
+  vdebug_rec_init (&r, kind, &tv);
+  chpl_vdebug_rec_add (&r, info->localNodeID);
+  chpl_vdebug_rec_add (&r, info->remoteNodeID);
+  chpl_vdebug_rec_add (&r, (int64_t) chpl_task_getId());
+  chpl_vdebug_rec_add (&r, (int64_t) (uintptr_t) addr);
+  chpl_vdebug_rec_add (&r, (int64_t) (uintptr_t) raddr);
+  chpl_vdebug_rec_add (&r, elemSize);
+  chpl_vdebug_rec_add (&r, length);
+  chpl_vdebug_rec_add (&r, commID);
+  chpl_vdebug_rec_add (&r, lineno);
+  chpl_vdebug_rec_add (&r, fileno);
+  vdebug_put (&r, NULL);
+}
+
+// As do the executeOn records.
+
+static void vdebug_fork (int kind, const chpl_comm_cb_info_t *info) {
+  const struct chpl_comm_info_comm_executeOn *cm = &info->iu.executeOn;
+  struct timeval tv;
+  chpl_vdebug_rec_t r;
+  (void) gettimeofday (&tv, NULL);
+  vdebug_rec_init (&r, kind, &tv);
+  chpl_vdebug_rec_add (&r, info->localNodeID);
+  chpl_vdebug_rec_add (&r, info->remoteNodeID);
+  chpl_vdebug_rec_add (&r, cm->subloc);
+  chpl_vdebug_rec_add (&r, cm->fid);
+  chpl_vdebug_rec_add (&r, (int64_t) (uintptr_t) cm->arg);
+  chpl_vdebug_rec_add (&r, cm->arg_size);
+  chpl_vdebug_rec_add (&r, (int64_t) chpl_task_getId());
+  chpl_vdebug_rec_add (&r, cm->lineno);
+  chpl_vdebug_rec_add (&r, cm->filename);
+  vdebug_put (&r, NULL);
+}
+
+// Tag, Pause and End records carry the user and system times.
+
+static void vdebug_times (chpl_vdebug_rec_t *r, int kind) {
+  struct rusage ru;
+  struct timeval tv;
+  (void) gettimeofday (&tv, NULL);
+  if ( getrusage (RUSAGE_SELF, &ru) < 0) {
+    ru.ru_utime.tv_sec = 0;
+    ru.ru_utime.tv_usec = 0;
+    ru.ru_stime.tv_sec = 0;
+    ru.ru_stime.tv_usec = 0;
+  }
+  vdebug_rec_init (r, kind, &tv);
+  chpl_vdebug_rec_add (r, ru.ru_utime.tv_sec);
+  chpl_vdebug_rec_add (r, ru.ru_utime.tv_usec);
+  chpl_vdebug_rec_add (r, ru.ru_stime.tv_sec);
+  chpl_vdebug_rec_add (r, ru.ru_stime.tv_usec);
+  chpl_vdebug_rec_add (r, chpl_nodeID);
+  chpl_vdebug_rec_add (r, (int64_t) chpl_task_getId());
+}
+
 static int chpl_make_vdebug_file (const char *rootname) {
     char fname[MAXPATHLEN]; 
     struct stat sb;
@@ -137,6 +312,16 @@ void chpl_vdebug_start (const char *fileroot, double now) {
 
   chpl_vdebug = 0;
 
+  if (!vdebug_inited) {
+    CHPL_TLS_INIT(vdebug_tbuf);
+    chpl_thread_mutexInit (&vdebug_bufs_lock);
+    atomic_init_uint_least64_t (&vdebug_seq, 0);
+    vdebug_inited = 1;
+    // Don't lose buffered records if the program doesn't stop Vdebug.
+    atexit (vdebug_flush_all);
+  }
+  vdebug_binary = chpl_env_rt_get_bool ("VDEBUG_BINARY", false);
+
   // Close any open files.
   if (chpl_vdebug_fd >= 0)
     chpl_vdebug_stop ();
@@ -192,6 +377,10 @@ void chpl_vdebug_start (const char *fileroot, double now) {
                     chpl_finfo[ix].lineno, chpl_finfo[ix].fileno,
                     chpl_finfo[ix].name);
   }
+
+  // Everything after this line is binary records
+  if (vdebug_binary)
+    chpl_dprintf (chpl_vdebug_fd, "%s", CHPL_VDEBUG_BINARY_LINE);
   
   chpl_vdebug = 1;
 }
@@ -201,10 +390,7 @@ void chpl_vdebug_start (const char *fileroot, double now) {
 // Should be the last record in the file.
 
 void chpl_vdebug_stop (void) {
-  struct rusage ru;  
-  struct timeval tv;
-  chpl_taskID_t stopTask = chpl_task_getId();
-  char buff[CHPL_TASK_ID_STRING_MAX_LEN];
+  chpl_vdebug_rec_t r;
 
   // First, shutdown VisualDebug
   chpl_vdebug = 0;
@@ -212,20 +398,12 @@ void chpl_vdebug_stop (void) {
 
   // Now log the stop
   if (chpl_vdebug_fd >= 0) {
-    (void) gettimeofday (&tv, NULL);
-    if ( getrusage (RUSAGE_SELF, &ru) < 0) {
-      ru.ru_utime.tv_sec = 0;
-      ru.ru_utime.tv_usec = 0;
-      ru.ru_stime.tv_sec = 0;
-      ru.ru_stime.tv_usec = 0;
-    }
     // Generate the End record
-    chpl_dprintf (chpl_vdebug_fd, "End: %lld.%06ld %ld.%06ld %ld.%06ld %d %s\n",
-                  (long long) tv.tv_sec, (long) tv.tv_usec,
-                  (long) ru.ru_utime.tv_sec, (long) ru.ru_utime.tv_usec,
-                  (long) ru.ru_stime.tv_sec, (long) ru.ru_stime.tv_usec,
-                  chpl_nodeID, TID_STRING(buff, stopTask));
+    vdebug_times (&r, chpl_vdebug_rec_End);
+    vdebug_put (&r, NULL);
+    vdebug_flush_all ();
     close (chpl_vdebug_fd);
+    chpl_vdebug_fd = -1;
   }
 }
 
@@ -237,65 +415,46 @@ void chpl_vdebug_stop (void) {
 
 void chpl_vdebug_mark (void) {
   struct timeval tv;
-  chpl_taskID_t tagTask = chpl_task_getId();
-  char buff[CHPL_TASK_ID_STRING_MAX_LEN];
+  chpl_vdebug_rec_t r;
   (void) gettimeofday (&tv, NULL);
-  chpl_dprintf (chpl_vdebug_fd, "VdbMark: %lld.%06ld %d %s\n",
-                (long long) tv.tv_sec, (long) tv.tv_usec, chpl_nodeID, TID_STRING(buff, tagTask) );
+  vdebug_rec_init (&r, chpl_vdebug_rec_VdbMark, &tv);
+  chpl_vdebug_rec_add (&r, chpl_nodeID);
+  chpl_vdebug_rec_add (&r, (int64_t) chpl_task_getId());
+  vdebug_put (&r, NULL);
 }
 
 // Record>  tname: tag# tagname
 
 void chpl_vdebug_tagname (const char* tagname, int tagno) {
-  chpl_dprintf (chpl_vdebug_fd, "tname: %d %s\n", tagno, tagname);
+  chpl_vdebug_rec_t r;
+  vdebug_rec_init (&r, chpl_vdebug_rec_tname, NULL);
+  chpl_vdebug_rec_add (&r, tagno);
+  vdebug_put (&r, tagname);
 }
 
 // Record>  Tag: time.sec user.time sys.time nodeId taskId tag# 
 
 void chpl_vdebug_tag (int tagno) {
-  struct rusage ru;
-  struct timeval tv;
-  
-  chpl_taskID_t tagTask = chpl_task_getId();
-  char buff[CHPL_TASK_ID_STRING_MAX_LEN];
+  chpl_vdebug_rec_t r;
 
-  (void) gettimeofday (&tv, NULL);
-  if ( getrusage (RUSAGE_SELF, &ru) < 0) {
-    ru.ru_utime.tv_sec = 0;
-    ru.ru_utime.tv_usec = 0;
-    ru.ru_stime.tv_sec = 0;
-    ru.ru_stime.tv_usec = 0;
-  }
-  chpl_dprintf (chpl_vdebug_fd, "Tag: %lld.%06ld %ld.%06ld %ld.%06ld %d %s %d\n",
-                (long long) tv.tv_sec, (long) tv.tv_usec,
-                (long) ru.ru_utime.tv_sec, (long) ru.ru_utime.tv_usec,
-                (long) ru.ru_stime.tv_sec, (long) ru.ru_stime.tv_usec,
-                chpl_nodeID, TID_STRING(buff, tagTask), tagno);
+  vdebug_times (&r, chpl_vdebug_rec_Tag);
+  chpl_vdebug_rec_add (&r, tagno);
+  vdebug_put (&r, NULL);
   chpl_vdebug = 1;
 }
 
 // Record>  Pause: time.sec user.time sys.time nodeId taskId tag#
 
 void chpl_vdebug_pause (int tagno) {
-  struct rusage ru;
-  struct timeval tv;
-  chpl_taskID_t pauseTask = chpl_task_getId();
-  char buff[CHPL_TASK_ID_STRING_MAX_LEN];
+  chpl_vdebug_rec_t r;
 
   if (chpl_vdebug_fd >=0 && chpl_vdebug == 1) {
-    (void) gettimeofday (&tv, NULL);
-    if ( getrusage (RUSAGE_SELF, &ru) < 0) {
-      ru.ru_utime.tv_sec = 0;
-      ru.ru_utime.tv_usec = 0;
-      ru.ru_stime.tv_sec = 0;
-      ru.ru_stime.tv_usec = 0;
-    }
-    chpl_dprintf (chpl_vdebug_fd, "Pause: %lld.%06ld %ld.%06ld %ld.%06ld %d %s %d\n",
-                  (long long) tv.tv_sec, (long) tv.tv_usec,
-                  (long) ru.ru_utime.tv_sec, (long) ru.ru_utime.tv_usec,
-                  (long) ru.ru_stime.tv_sec, (long) ru.ru_stime.tv_usec,
-                  chpl_nodeID, TID_STRING(buff, pauseTask), tagno);
+    vdebug_times (&r, chpl_vdebug_rec_Pause);
+    chpl_vdebug_rec_add (&r, tagno);
+    vdebug_put (&r, NULL);
     chpl_vdebug = 0;
+    // Nothing is logged until the next tag, so write out what we have.
+    vdebug_flush_all ();
   }
 }
 
@@ -311,17 +470,9 @@ void chpl_vdebug_pause (int tagno) {
 
 void cb_comm_put_nb (const chpl_comm_cb_info_t *info) {
   if (chpl_vdebug) {
-    struct timeval tv;
     const struct chpl_comm_info_comm *cm = &info->iu.comm;
-    chpl_taskID_t commTask = chpl_task_getId();
-    char buff[CHPL_TASK_ID_STRING_MAX_LEN];
-    (void) gettimeofday (&tv, NULL);
-    chpl_dprintf (chpl_vdebug_fd, 
-                  VDEBUG_GETPUT_FORMAT_STRING, "nb_put",
-                  (long long) tv.tv_sec, (long) tv.tv_usec,  info->localNodeID,
-                  info->remoteNodeID, TID_STRING(buff, commTask), (unsigned long) cm->addr,
-                  (unsigned long) cm->raddr, (size_t)1, cm->size,
-                  cm->commID, cm->lineno, cm->filename);
+    vdebug_comm (chpl_vdebug_rec_nb_put, info, cm->addr, cm->raddr, 1,
+                 cm->size, cm->commID, cm->lineno, cm->filename);
   }
 }
 
@@ -332,17 +483,9 @@ void cb_comm_put_nb (const chpl_comm_cb_info_t *info) {
 
 void cb_comm_get_nb (const chpl_comm_cb_info_t *info) {
   if (chpl_vdebug) {
-    struct timeval tv;
     const struct chpl_comm_info_comm *cm = &info->iu.comm;
-    chpl_taskID_t commTask = chpl_task_getId();
-    char buff[CHPL_TASK_ID_STRING_MAX_LEN];
-    (void) gettimeofday (&tv, NULL);
-    chpl_dprintf (chpl_vdebug_fd,
-                  VDEBUG_GETPUT_FORMAT_STRING, "nb_get",
-                  (long long) tv.tv_sec, (long) tv.tv_usec,  info->localNodeID,
-                  info->remoteNodeID, TID_STRING(buff, commTask), (unsigned long) cm->addr,
-                  (unsigned long) cm->raddr, (size_t)1, cm->size,
-                  cm->commID, cm->lineno, cm->filename);
+    vdebug_comm (chpl_vdebug_rec_nb_get, info, cm->addr, cm->raddr, 1,
+                 cm->size, cm->commID, cm->lineno, cm->filename);
   }
 }
 
@@ -352,17 +495,9 @@ void cb_comm_get_nb (const chpl_comm_cb_info_t *info) {
 
 void cb_comm_put (const chpl_comm_cb_info_t *info) {
   if (chpl_vdebug) {
-    struct timeval tv;
     const struct chpl_comm_info_comm *cm = &info->iu.comm;
-    chpl_taskID_t commTask = chpl_task_getId();
-    char buff[CHPL_TASK_ID_STRING_MAX_LEN];
-    (void) gettimeofday (&tv, NULL);
-    chpl_dprintf (chpl_vdebug_fd,
-                  VDEBUG_GETPUT_FORMAT_STRING, "put",
-                  (long long) tv.tv_sec, (long) tv.tv_usec, info->localNodeID,
-                  info->remoteNodeID, TID_STRING(buff, commTask), (unsigned long) cm->addr,
-                  (unsigned long) cm->raddr, (size_t)1, cm->size,
-                  cm->commID, cm->lineno, cm->filename);
+    vdebug_comm (chpl_vdebug_rec_put, info, cm->addr, cm->raddr, 1,
+                 cm->size, cm->commID, cm->lineno, cm->filename);
   }
 }
 
@@ -373,17 +508,9 @@ void cb_comm_put (const chpl_comm_cb_info_t *info) {
 
 void cb_comm_get (const chpl_comm_cb_info_t *info) {
   if (chpl_vdebug) {
-    struct timeval tv;
     const struct chpl_comm_info_comm *cm = &info->iu.comm;
-    chpl_taskID_t commTask = chpl_task_getId();
-    char buff[CHPL_TASK_ID_STRING_MAX_LEN];
-    (void) gettimeofday (&tv, NULL);
-    chpl_dprintf (chpl_vdebug_fd,
-                  VDEBUG_GETPUT_FORMAT_STRING, "get",
-                  (long long) tv.tv_sec, (long) tv.tv_usec,  info->localNodeID,
-                  info->remoteNodeID, TID_STRING(buff, commTask), (unsigned long) cm->addr,
-                  (unsigned long) cm->raddr, (size_t)1, cm->size,
-                  cm->commID, cm->lineno, cm->filename);
+    vdebug_comm (chpl_vdebug_rec_get, info, cm->addr, cm->raddr, 1,
+                 cm->size, cm->commID, cm->lineno, cm->filename);
   }
 }
 
@@ -391,25 +518,17 @@ void cb_comm_get (const chpl_comm_cb_info_t *info) {
 //                  length lineNumber fileName
 
 void cb_comm_put_strd (const chpl_comm_cb_info_t *info) {
-    if (chpl_vdebug) {
-    struct timeval tv;
+  if (chpl_vdebug) {
     size_t length;
     const struct chpl_comm_info_comm_strd *cm = &info->iu.comm_strd;
-    chpl_taskID_t commTask = chpl_task_getId();
-    char buff[CHPL_TASK_ID_STRING_MAX_LEN];
-    (void) gettimeofday (&tv, NULL);
 
     length = 1;
     for (int32_t i = 0; i < cm->stridelevels; i++) {
       length *= cm->count[i];
     }
 
-    chpl_dprintf (chpl_vdebug_fd,
-                  VDEBUG_GETPUT_FORMAT_STRING, "st_put",
-                  (long long) tv.tv_sec, (long) tv.tv_usec,  info->localNodeID, 
-                  info->remoteNodeID, TID_STRING(buff, commTask),
-                  (unsigned long) cm->srcaddr, (unsigned long) cm->dstaddr, cm->elemSize,
-                  length, cm->commID, cm->lineno, cm->filename);
+    vdebug_comm (chpl_vdebug_rec_st_put, info, cm->srcaddr, cm->dstaddr,
+                 cm->elemSize, length, cm->commID, cm->lineno, cm->filename);
     // printout srcstrides and dststrides and stridelevels and count?
   }
 
@@ -422,24 +541,16 @@ void cb_comm_put_strd (const chpl_comm_cb_info_t *info) {
 
 void cb_comm_get_strd (const chpl_comm_cb_info_t *info) {
   if (chpl_vdebug) {
-    struct timeval tv;
     size_t length;
     const struct chpl_comm_info_comm_strd *cm = &info->iu.comm_strd;
-    chpl_taskID_t commTask = chpl_task_getId();
-    char buff[CHPL_TASK_ID_STRING_MAX_LEN];
-    (void) gettimeofday (&tv, NULL);
 
     length = 1;
     for (int32_t i = 0; i < cm->stridelevels; i++) {
       length *= cm->count[i];
     }
 
-    chpl_dprintf (chpl_vdebug_fd,
-                  VDEBUG_GETPUT_FORMAT_STRING, "st_get",
-                  (long long) tv.tv_sec, (long) tv.tv_usec, info->localNodeID,
-                  info->remoteNodeID, TID_STRING(buff, commTask),
-                  (unsigned long) cm->dstaddr, (unsigned long) cm->srcaddr, cm->elemSize,
-                  length, cm->commID, cm->lineno, cm->filename);
+    vdebug_comm (chpl_vdebug_rec_st_get, info, cm->dstaddr, cm->srcaddr,
+                 cm->elemSize, length, cm->commID, cm->lineno, cm->filename);
     // print out the srcstrides and dststrides and stridelevels and count?
   }
 }
@@ -450,17 +561,7 @@ void cb_comm_executeOn (const chpl_comm_cb_info_t *info) {
 
   // Visual Debug Support
   if (chpl_vdebug) {
-    const struct chpl_comm_info_comm_executeOn *cm = &info->iu.executeOn;
-    chpl_taskID_t executeOnTask = chpl_task_getId();
-    char buff[CHPL_TASK_ID_STRING_MAX_LEN];
-    struct timeval tv;
-    (void) gettimeofday (&tv, NULL);
-    chpl_dprintf (chpl_vdebug_fd,
-                  "fork: %lld.%06ld %d %d %d %d %#lx %zd %s %d %d\n",
-                  (long long) tv.tv_sec, (long) tv.tv_usec, info->localNodeID,
-                  info->remoteNodeID, cm->subloc, cm->fid, (unsigned long) cm->arg,
-                  cm->arg_size, TID_STRING(buff, executeOnTask),
-                  cm->lineno, cm->filename);
+    vdebug_fork (chpl_vdebug_rec_fork, info);
   }
 }
 
@@ -469,16 +570,7 @@ void cb_comm_executeOn (const chpl_comm_cb_info_t *info) {
 
 void  cb_comm_executeOn_nb (const chpl_comm_cb_info_t *info) {
   if (chpl_vdebug) {
-    const struct chpl_comm_info_comm_executeOn *cm = &info->iu.executeOn;
-    chpl_taskID_t executeOnTask = chpl_task_getId();
-    char buff[CHPL_TASK_ID_STRING_MAX_LEN];
-    struct timeval tv;
-    (void) gettimeofday (&tv, NULL);
-    chpl_dprintf (chpl_vdebug_fd, "fork_nb: %lld.%06ld %d %d %d %d %#lx %zd %s %d %d\n",
-                  (long long) tv.tv_sec, (long) tv.tv_usec, info->localNodeID,
-                  info->remoteNodeID, cm->subloc, cm->fid, (unsigned long) cm->arg, 
-                  cm->arg_size, TID_STRING(buff, executeOnTask),
-                  cm->lineno, cm->filename);
+    vdebug_fork (chpl_vdebug_rec_fork_nb, info);
   }
 }
 
@@ -486,17 +578,7 @@ void  cb_comm_executeOn_nb (const chpl_comm_cb_info_t *info) {
 
 void cb_comm_executeOn_fast (const chpl_comm_cb_info_t *info) {
   if (chpl_vdebug) {
-    const struct chpl_comm_info_comm_executeOn *cm = &info->iu.executeOn;
-    chpl_taskID_t executeOnTask = chpl_task_getId();
-    char buff[CHPL_TASK_ID_STRING_MAX_LEN];
-    struct timeval tv;
-    (void) gettimeofday (&tv, NULL);
-    chpl_dprintf (chpl_vdebug_fd,
-                  "f_fork: %lld.%06ld %d %d %d %d %#lx %zd %s %d %d\n",
-                  (long long) tv.tv_sec, (long) tv.tv_usec, info->localNodeID,
-                  info->remoteNodeID, cm->subloc, cm->fid, (unsigned long)cm->arg, 
-                  cm->arg_size, TID_STRING(buff, executeOnTask),
-                  cm->lineno, cm->filename);
+    vdebug_fork (chpl_vdebug_rec_f_fork, info);
   }
 }
 
@@ -600,22 +682,22 @@ int uninstall_callbacks (void) {
 
 void cb_task_create (const chpl_task_cb_info_t *info) {
   struct timeval tv;
+  chpl_vdebug_rec_t r;
   if (!chpl_vdebug) return;
   if (chpl_vdebug_fd >= 0) {
-    chpl_taskID_t taskId = chpl_task_getId();
-    char buff[CHPL_TASK_ID_STRING_MAX_LEN];
     //printf ("taskCB: event: %d, node %d proc %s task id: %llu, new task id: %llu\n",
     //         (int)info->event_kind, (int)info->nodeID,
     //        (info->iu.full.is_executeOn ? "O" : "L"), taskId, info->iu.full.id);
     (void)gettimeofday(&tv, NULL);
-    chpl_dprintf (chpl_vdebug_fd, "task: %lld.%06ld %lld %ld %s %s %ld %d %d\n",
-                  (long long) tv.tv_sec, (long) tv.tv_usec,
-                  (long long) info->nodeID, (long int) info->iu.full.id,
-                  TID_STRING(buff, taskId),
-                  (info->iu.full.is_executeOn ? "O" : "L"),
-                  (long int) info->iu.full.lineno,
-                  info->iu.full.filename,
-                  info->iu.full.fid);
+    vdebug_rec_init (&r, chpl_vdebug_rec_task, &tv);
+    chpl_vdebug_rec_add (&r, info->nodeID);
+    chpl_vdebug_rec_add (&r, (int64_t) info->iu.full.id);
+    chpl_vdebug_rec_add (&r, (int64_t) chpl_task_getId());
+    chpl_vdebug_rec_add (&r, info->iu.full.is_executeOn ? 1 : 0);
+    chpl_vdebug_rec_add (&r, info->iu.full.lineno);
+    chpl_vdebug_rec_add (&r, info->iu.full.filename);
+    chpl_vdebug_rec_add (&r, info->iu.full.fid);
+    vdebug_put (&r, NULL);
    }
 }
 
@@ -623,13 +705,14 @@ void cb_task_create (const chpl_task_cb_info_t *info) {
 
 void cb_task_begin (const chpl_task_cb_info_t *info) {
   struct timeval tv;
+  chpl_vdebug_rec_t r;
   if (!chpl_vdebug) return;
   if (chpl_vdebug_fd >= 0) {
     (void)gettimeofday(&tv, NULL);
-    chpl_dprintf (chpl_vdebug_fd, "Btask: %lld.%06ld %lld %lu\n",
-                  (long long) tv.tv_sec, (long) tv.tv_usec,
-                  (long long) info->nodeID, (unsigned long) info->iu.full.id);
- 
+    vdebug_rec_init (&r, chpl_vdebug_rec_Btask, &tv);
+    chpl_vdebug_rec_add (&r, info->nodeID);
+    chpl_vdebug_rec_add (&r, (int64_t) info->iu.full.id);
+    vdebug_put (&r, NULL);
   }
 }
 
@@ -637,12 +720,13 @@ void cb_task_begin (const chpl_task_cb_info_t *info) {
 
 void cb_task_end (const chpl_task_cb_info_t *info) {
   struct timeval tv;
+  chpl_vdebug_rec_t r;
   if (!chpl_vdebug) return;
   if (chpl_vdebug_fd >= 0) {
     (void)gettimeofday(&tv, NULL);
-    chpl_dprintf (chpl_vdebug_fd, "Etask: %lld.%06ld %lld %lu\n",
-                  (long long) tv.tv_sec, (long) tv.tv_usec,
-                  (long long) info->nodeID, (unsigned long) info->iu.id_only.id);
- 
+    vdebug_rec_init (&r, chpl_vdebug_rec_Etask, &tv);
+    chpl_vdebug_rec_add (&r, info->nodeID);
+    chpl_vdebug_rec_add (&r, (int64_t) info->iu.id_only.id);
+    vdebug_put (&r, NULL);
   }
 }
@@ -22,10 +22,14 @@
 
 #include "chpl_rt_utils_static.h"
 #include "chpl-comm.h"
+#include "chpl-comm-diags.h"
 #include "chplexit.h"
 #include "chpl-mem.h"
 #include "chplmemtrack.h"
+#include "chpl-stats-dump.h"
+#include "chpl-task-counters.h"
 #include "chpl-topo.h"
+#include "chpl-tracer.h"
 #include "gdb.h"
 
 #include <stdio.h>
@@ -39,8 +43,14 @@ static void chpl_exit_common(int status, int all) {
   }
   chpl_comm_pre_task_exit(all);
   if (all) {
+    chpl_stats_dump_exit();
     chpl_task_exit();
     chpl_reportMemInfo();
+    chpl_mem_sample_exit();
+    chpl_trace_exit();
+    chpl_task_counters_exit();
+    chpl_comm_diags_dump_csv();
+    chpl_comm_diags_verbose_flush_aggregate();
   }
   chpl_comm_exit(all, status);
   if (all) {
@@ -75,16 +75,33 @@ typedef struct memTableEntry_struct { /* table entry */
   struct memTableEntry_struct* nextInBucket;
 } memTableEntry;
 
-#define NUM_HASH_SIZE_INDICES 20
+#define NUM_HASH_SIZE_INDICES 23
 
-static int hashSizes[NUM_HASH_SIZE_INDICES] = { 1543, 3079, 6151, 12289, 24593, 49157, 98317,
+static int hashSizes[NUM_HASH_SIZE_INDICES] = { 193, 389, 769,
+                                                1543, 3079, 6151, 12289, 24593, 49157, 98317,
                                                 196613, 393241, 786433, 1572869, 3145739,
                                                 6291469, 12582917, 25165843, 50331653,
                                                 100663319, 201326611, 402653189, 805306457 };
-static int hashSizeIndex = 0;
-static int hashSize = 0;
 
-static memTableEntry** memTable = NULL;
+//
+// The memory table is split into shards by address, each with its own
+// lock and hash table, so that concurrent allocations and frees rarely
+// contend.  (We shard by address rather than by thread because memory
+// is often freed by a different thread than the one that allocated it.)
+// Reports merge across all the shards.
+//
+#define LOG2_NUM_MEM_TABLE_SHARDS 6
+#define NUM_MEM_TABLE_SHARDS (1 << LOG2_NUM_MEM_TABLE_SHARDS)
+
+typedef struct {
+  pthread_mutex_t lock;
+  memTableEntry** table;
+  int hashSizeIndex;
+  int hashSize;
+  size_t numEntries;                /* number of entries in hash table */
+} memTableShard;
+
+static memTableShard memTables[NUM_MEM_TABLE_SHARDS];
 
 static _Bool memStats = false;
 static _Bool memLeaksByType = false;
@@ -100,7 +117,6 @@ static size_t totalMem = 0;       /* total memory currently allocated */
 static size_t maxMem = 0;         /* maximum total memory during run  */
 static size_t totalAllocated = 0; /* total memory allocated */
 static size_t totalFreed = 0;     /* total memory freed */
-static size_t totalEntries = 0;     /* number of entries in hash table */
 
 
 // We can't use a sync var for concurrency control here.  The Qthreads
@@ -109,22 +125,42 @@ static size_t totalEntries = 0;     /* number of entries in hash table */
 // sync var here when exiting (to report memTrack results, say), after
 // the tasking layer is shut down, ends up trying to create a qthread in
 // the terminated Qthreads library.  Chaos results.  We also cannot use
-// an atomic var, because with CHPL_ATOMICS=locks those are implemented
-// by means of sync vars.  So, we use a pthread mutex.  Note that this
-// is only safe if we cannot switch tasks on a pthread while holding the
-// mutex and then try to lock it recursively.  Currently that is the
-// case, since we do not yield while holding the mutex.
-// 
-static pthread_mutex_t memTrack_lockVar = PTHREAD_MUTEX_INITIALIZER;
+// a Chapel atomic var, because with CHPL_ATOMICS=locks those are
+// implemented by means of sync vars.  So, we use a pthread mutex per
+// table shard, and compiler atomics for the totals above.  Note that
+// this is only safe if we cannot switch tasks on a pthread while holding
+// a mutex and then try to lock it recursively.  Currently that is the
+// case, since we do not yield while holding a mutex.
+//
+
+static inline
+memTableShard* memTrack_shard(void* memAlloc) {
+  uint64_t h = (uint64_t) ((uintptr_t) memAlloc >> 4)
+               * UINT64_C(0x9e3779b97f4a7c15);
+  return &memTables[h >> (64 - LOG2_NUM_MEM_TABLE_SHARDS)];
+}
 
 static inline
-void memTrack_lock(void) {
-  (void) pthread_mutex_lock(&memTrack_lockVar);
+void memTrack_lock(memTableShard* shard) {
+  (void) pthread_mutex_lock(&shard->lock);
 }
 
 static inline
-void memTrack_unlock(void) {
-  (void) pthread_mutex_unlock(&memTrack_lockVar);
+void memTrack_unlock(memTableShard* shard) {
+  (void) pthread_mutex_unlock(&shard->lock);
+}
+
+// Reports lock all the shards, so they see a consistent table.
+static
+void memTrack_lockAll(void) {
+  for (int i = 0; i < NUM_MEM_TABLE_SHARDS; i++)
+    memTrack_lock(&memTables[i]);
+}
+
+static
+void memTrack_unlockAll(void) {
+  for (int i = NUM_MEM_TABLE_SHARDS - 1; i >= 0; i--)
+    memTrack_unlock(&memTables[i]);
 }
 
 
@@ -180,9 +216,14 @@ void chpl_setMemFlags(void) {
   }
 
   if (chpl_memTrack) {
-    hashSizeIndex = 0;
-    hashSize = hashSizes[hashSizeIndex];
-    memTable = sys_calloc(hashSize, sizeof(memTableEntry*));
+    for (int i = 0; i < NUM_MEM_TABLE_SHARDS; i++) {
+      memTableShard* shard = &memTables[i];
+      (void) pthread_mutex_init(&shard->lock, NULL);
+      shard->hashSizeIndex = 0;
+      shard->hashSize = hashSizes[shard->hashSizeIndex];
+      shard->table = sys_calloc(shard->hashSize, sizeof(memTableEntry*));
+      shard->numEntries = 0;
+    }
   }
 }
 
@@ -200,36 +241,40 @@ static unsigned hash(void* memAlloc, int hashSize) {
 
 
 static void increaseMemStat(size_t chunk, int32_t lineno, int32_t filename) {
-  totalMem += chunk;
-  totalAllocated += chunk;
-  if (memMax && (totalMem > memMax)) {
+  size_t newTotal = __atomic_add_fetch(&totalMem, chunk, __ATOMIC_RELAXED);
+  size_t oldMax;
+  (void) __atomic_fetch_add(&totalAllocated, chunk, __ATOMIC_RELAXED);
+  if (memMax && (newTotal > memMax)) {
     chpl_error("Exceeded memory limit", lineno, filename);
   }
-  if (totalMem > maxMem)
-    maxMem = totalMem;
+  oldMax = __atomic_load_n(&maxMem, __ATOMIC_RELAXED);
+  while (newTotal > oldMax
+         && !__atomic_compare_exchange_n(&maxMem, &oldMax, newTotal, true,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
 }
 
 
 static void decreaseMemStat(size_t chunk) {
-  totalMem -= chunk; // > totalMem ? 0 : totalMem - chunk;
-  totalFreed += chunk;
+  (void) __atomic_fetch_sub(&totalMem, chunk, __ATOMIC_RELAXED);
+  (void) __atomic_fetch_add(&totalFreed, chunk, __ATOMIC_RELAXED);
 }
 
 
 static void
-resizeTable(int direction) {
+resizeTable(memTableShard* shard, int direction) {
   memTableEntry** newMemTable = NULL;
   int newHashSizeIndex, newHashSize, newHashValue;
   int i;
   memTableEntry* me;
   memTableEntry* next;
 
-  newHashSizeIndex = hashSizeIndex + direction;
+  newHashSizeIndex = shard->hashSizeIndex + direction;
   newHashSize = hashSizes[newHashSizeIndex];
   newMemTable = sys_calloc(newHashSize, sizeof(memTableEntry*));
 
-  for (i = 0; i < hashSize; i++) {
-    for (me = memTable[i]; me != NULL; me = next) {
+  for (i = 0; i < shard->hashSize; i++) {
+    for (me = shard->table[i]; me != NULL; me = next) {
       next = me->nextInBucket;
       newHashValue = hash(me->memAlloc, newHashSize);
       me->nextInBucket = newMemTable[newHashValue];
@@ -237,20 +282,22 @@ resizeTable(int direction) {
     }
   }
 
-  sys_free(memTable);
-  memTable = newMemTable;
-  hashSize = newHashSize;
-  hashSizeIndex = newHashSizeIndex;
+  sys_free(shard->table);
+  shard->table = newMemTable;
+  shard->hashSize = newHashSize;
+  shard->hashSizeIndex = newHashSizeIndex;
 }
 
-static void addMemTableEntry(void *memAlloc, size_t number, size_t size,
+static void addMemTableEntry(memTableShard* shard,
+                             void *memAlloc, size_t number, size_t size,
                              chpl_mem_descInt_t description, int32_t lineno,
                              int32_t filename) {
   unsigned hashValue;
   memTableEntry* memEntry;
 
-  if ((totalEntries+1)*2 > hashSize && hashSizeIndex < NUM_HASH_SIZE_INDICES-1)
-    resizeTable(1);
+  if ((shard->numEntries+1)*2 > shard->hashSize
+      && shard->hashSizeIndex < NUM_HASH_SIZE_INDICES-1)
+    resizeTable(shard, 1);
 
   memEntry = (memTableEntry*) sys_calloc(1, sizeof(memTableEntry));
   if (!memEntry) {
@@ -258,9 +305,9 @@ static void addMemTableEntry(void *memAlloc, size_t number, size_t size,
                lineno, filename);
   }
 
-  hashValue = hash(memAlloc, hashSize);
-  memEntry->nextInBucket = memTable[hashValue];
-  memTable[hashValue] = memEntry;
+  hashValue = hash(memAlloc, shard->hashSize);
+  memEntry->nextInBucket = shard->table[hashValue];
+  shard->table[hashValue] = memEntry;
   memEntry->description = description;
   memEntry->memAlloc = memAlloc;
   memEntry->lineno = lineno;
@@ -268,23 +315,24 @@ static void addMemTableEntry(void *memAlloc, size_t number, size_t size,
   memEntry->number = number;
   memEntry->size = size;
   increaseMemStat(number*size, lineno, filename);
-  totalEntries += 1;
+  shard->numEntries += 1;
 }
 
 
-static memTableEntry* removeMemTableEntry(void* address) {
-  unsigned hashValue = hash(address, hashSize);
-  memTableEntry* thisBucketEntry = memTable[hashValue];
+static memTableEntry* removeMemTableEntry(memTableShard* shard,
+                                          void* address) {
+  unsigned hashValue = hash(address, shard->hashSize);
+  memTableEntry* thisBucketEntry = shard->table[hashValue];
   memTableEntry* deletedBucket = NULL;
 
   if (!thisBucketEntry)
     return NULL;
 
   if (thisBucketEntry->memAlloc == address) {
-    memTable[hashValue] = thisBucketEntry->nextInBucket;
+    shard->table[hashValue] = thisBucketEntry->nextInBucket;
     deletedBucket = thisBucketEntry;
   } else {
-    for (thisBucketEntry = memTable[hashValue];
+    for (thisBucketEntry = shard->table[hashValue];
          thisBucketEntry != NULL;
          thisBucketEntry = thisBucketEntry->nextInBucket) {
 
@@ -298,9 +346,9 @@ static memTableEntry* removeMemTableEntry(void* address) {
   }
   if (deletedBucket) {
     decreaseMemStat(deletedBucket->number * deletedBucket->size);
-    totalEntries -= 1;
-    if (totalEntries*8 < hashSize && hashSizeIndex > 0)
-      resizeTable(-1);
+    shard->numEntries -= 1;
+    if (shard->numEntries*8 < shard->hashSize && shard->hashSizeIndex > 0)
+      resizeTable(shard, -1);
   }
   return deletedBucket;
 }
@@ -313,7 +361,16 @@ uint64_t chpl_memoryUsed(int32_t lineno, int32_t filename) {
     return 0;
   }
 
-  return (uint64_t)totalMem;
+  return (uint64_t) __atomic_load_n(&totalMem, __ATOMIC_RELAXED);
+}
+
+
+void chpl_memTrack_getTotals(size_t* allocNow, size_t* allocMax,
+                             size_t* allocSum, size_t* freeSum) {
+  *allocNow = __atomic_load_n(&totalMem, __ATOMIC_RELAXED);
+  *allocMax = __atomic_load_n(&maxMem, __ATOMIC_RELAXED);
+  *allocSum = __atomic_load_n(&totalAllocated, __ATOMIC_RELAXED);
+  *freeSum = __atomic_load_n(&totalFreed, __ATOMIC_RELAXED);
 }
 
 
@@ -345,17 +402,19 @@ void chpl_printMemAllocStats(int32_t lineno, int32_t filename) {
   }
 
   //
-  // Take a pre-run through the descriptions and values to figure
-  // out how long each line will need to be.
+  // Snapshot the values, then take a pre-run through the descriptions
+  // and values to figure out how long each line will need to be.
   //
-  static const struct {
+  const struct {
     const char* desc;
-    size_t* val;
+    size_t val;
   } descsVals[] = {
-    { "Allocated Now:", &totalMem },
-    { "Allocation High Water Mark:", &maxMem },
-    { "Sum of Allocations:", &totalAllocated },
-    { "Sum of Frees:", &totalFreed },
+    { "Allocated Now:", __atomic_load_n(&totalMem, __ATOMIC_RELAXED) },
+    { "Allocation High Water Mark:",
+      __atomic_load_n(&maxMem, __ATOMIC_RELAXED) },
+    { "Sum of Allocations:",
+      __atomic_load_n(&totalAllocated, __ATOMIC_RELAXED) },
+    { "Sum of Frees:", __atomic_load_n(&totalFreed, __ATOMIC_RELAXED) },
   };
   const int nDescsVals = sizeof(descsVals) / sizeof(descsVals[0]);
 
@@ -367,9 +426,9 @@ void chpl_printMemAllocStats(int32_t lineno, int32_t filename) {
     if (thisDescWidth > descWidth)
       descWidth = thisDescWidth;
     const int thisMemWidth =
-                (*descsVals[i].val == 0)
+                (descsVals[i].val == 0)
                 ? 1
-                : (int) lrint(ceil(log10((double) *descsVals[i].val)));
+                : (int) lrint(ceil(log10((double) descsVals[i].val)));
     if (thisMemWidth > memWidth)
       memWidth = thisMemWidth;
   }
@@ -381,19 +440,15 @@ void chpl_printMemAllocStats(int32_t lineno, int32_t filename) {
   char buf[4 * (strlen(prefixBuf) + 1 + descWidth + 1 + memWidth + 1) + 1];
   size_t len;
 
-  memTrack_lock();
-
   len = 0;
   for (int i = 0; i < nDescsVals; i++) {
     len += snprintf(buf + len, sizeof(buf) - len,
                     "%s %-*s %*zd\n",
                     prefixBuf,
                     descWidth, descsVals[i].desc,
-                    memWidth, *descsVals[i].val);
+                    memWidth, descsVals[i].val);
   }
 
-  memTrack_unlock();
-
   fputs(buf, memLogFile);
 }
 
@@ -421,13 +476,18 @@ static void printMemAllocsByType(_Bool forLeaks,
 
   table = (size_t*)sys_calloc(numEntries, 3*sizeof(size_t));
 
-  for (i = 0; i < hashSize; i++) {
-    for (me = memTable[i]; me != NULL; me = me->nextInBucket) {
-      table[3*me->description] += me->number*me->size;
-      table[3*me->description+1] += 1;
-      table[3*me->description+2] = me->description;
+  memTrack_lockAll();
+  for (int s = 0; s < NUM_MEM_TABLE_SHARDS; s++) {
+    memTableShard* shard = &memTables[s];
+    for (i = 0; i < shard->hashSize; i++) {
+      for (me = shard->table[i]; me != NULL; me = me->nextInBucket) {
+        table[3*me->description] += me->number*me->size;
+        table[3*me->description+1] += 1;
+        table[3*me->description+2] = me->description;
+      }
     }
   }
+  memTrack_unlockAll();
 
   qsort(table, numEntries, 3*sizeof(size_t), memTableEntryCmp);
 
@@ -537,21 +597,30 @@ printMemAllocs(chpl_mem_descInt_t description, int64_t threshold,
     return;
   }
 
+  //
+  // Hold all the shard locks from here until we're done with the
+  // entries, so nothing is freed out from under us.
+  //
+  memTrack_lockAll();
+
   n = 0;
   filenameWidth = strlen("Allocated Memory (Bytes)");
-  for (i = 0; i < hashSize; i++) {
-    for (memEntry = memTable[i]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
-      size_t chunk = memEntry->number * memEntry->size;
-      if (chunk < threshold)
-        continue;
-      if (description != -1 && memEntry->description != description)
-        continue;
-      n += 1;
-      if (memEntry->filename) {
-        memEntryFilename = chpl_lookupFilename(memEntry->filename);
-        filenameLength = strlen(memEntryFilename);
-        if (filenameLength > filenameWidth)
-          filenameWidth = filenameLength;
+  for (int s = 0; s < NUM_MEM_TABLE_SHARDS; s++) {
+    memTableShard* shard = &memTables[s];
+    for (i = 0; i < shard->hashSize; i++) {
+      for (memEntry = shard->table[i]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
+        size_t chunk = memEntry->number * memEntry->size;
+        if (chunk < threshold)
+          continue;
+        if (description != -1 && memEntry->description != description)
+          continue;
+        n += 1;
+        if (memEntry->filename) {
+          memEntryFilename = chpl_lookupFilename(memEntry->filename);
+          filenameLength = strlen(memEntryFilename);
+          if (filenameLength > filenameWidth)
+            filenameWidth = filenameLength;
+        }
       }
     }
   }
@@ -584,14 +653,17 @@ printMemAllocs(chpl_mem_descInt_t description, int64_t threshold,
     chpl_error("out of memory printing memory table", lineno, filename);
 
   n = 0;
-  for (i = 0; i < hashSize; i++) {
-    for (memEntry = memTable[i]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
-      size_t chunk = memEntry->number * memEntry->size;
-      if (chunk < threshold)
-        continue;
-      if (description != -1 && memEntry->description != description)
-        continue;
-      table[n++] = memEntry;
+  for (int s = 0; s < NUM_MEM_TABLE_SHARDS; s++) {
+    memTableShard* shard = &memTables[s];
+    for (i = 0; i < shard->hashSize; i++) {
+      for (memEntry = shard->table[i]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
+        size_t chunk = memEntry->number * memEntry->size;
+        if (chunk < threshold)
+          continue;
+        if (description != -1 && memEntry->description != description)
+          continue;
+        table[n++] = memEntry;
+      }
     }
   }
   qsort(table, n, sizeof(memTableEntry*), descCmp);
@@ -619,6 +691,8 @@ printMemAllocs(chpl_mem_descInt_t description, int64_t threshold,
   fprintf(memLogFile, "\n");
   putchar('\n');
 
+  memTrack_unlockAll();
+
   sys_free(table);
   sys_free(loc);
 }
@@ -666,9 +740,11 @@ void chpl_track_malloc(void* memAlloc, size_t number, size_t size,
                        int32_t lineno, int32_t filename) {
   if (number * size > memThreshold) {
     if (chpl_memTrack && chpl_mem_descTrack(description)) {
-      memTrack_lock();
-      addMemTableEntry(memAlloc, number, size, description, lineno, filename);
-      memTrack_unlock();
+      memTableShard* shard = memTrack_shard(memAlloc);
+      memTrack_lock(shard);
+      addMemTableEntry(shard, memAlloc, number, size, description,
+                       lineno, filename);
+      memTrack_unlock(shard);
     }
     if (chpl_verbose_mem) {
       fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32
@@ -684,8 +760,9 @@ void chpl_track_malloc(void* memAlloc, size_t number, size_t size,
 void chpl_track_free(void* memAlloc, int32_t lineno, int32_t filename) {
   memTableEntry* memEntry = NULL;
   if (chpl_memTrack) {
-    memTrack_lock();
-    memEntry = removeMemTableEntry(memAlloc);
+    memTableShard* shard = memTrack_shard(memAlloc);
+    memTrack_lock(shard);
+    memEntry = removeMemTableEntry(shard, memAlloc);
     if (memEntry) {
       if (chpl_verbose_mem) {
         fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32
@@ -696,7 +773,7 @@ void chpl_track_free(void* memAlloc, int32_t lineno, int32_t filename) {
       }
       sys_free(memEntry);
     }
-    memTrack_unlock();
+    memTrack_unlock(shard);
   } else if (chpl_verbose_mem && !memEntry) {
     fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32 ": free at %p\n",
             chpl_nodeID, (filename ? chpl_lookupFilename(filename) : "--"),
@@ -710,14 +787,13 @@ void chpl_track_realloc_pre(void* memAlloc, size_t size,
                          int32_t lineno, int32_t filename) {
   memTableEntry* memEntry = NULL;
 
-  if (chpl_memTrack && size > memThreshold) {
-    memTrack_lock();
-    if (memAlloc) {
-      memEntry = removeMemTableEntry(memAlloc);
-      if (memEntry)
-        sys_free(memEntry);
-    }
-    memTrack_unlock();
+  if (chpl_memTrack && size > memThreshold && memAlloc) {
+    memTableShard* shard = memTrack_shard(memAlloc);
+    memTrack_lock(shard);
+    memEntry = removeMemTableEntry(shard, memAlloc);
+    if (memEntry)
+      sys_free(memEntry);
+    memTrack_unlock(shard);
   }
 }
 
@@ -728,9 +804,11 @@ void chpl_track_realloc_post(void* moreMemAlloc,
                          int32_t lineno, int32_t filename) {
   if (size > memThreshold) {
     if (chpl_memTrack && chpl_mem_descTrack(description)) {
-      memTrack_lock();
-      addMemTableEntry(moreMemAlloc, 1, size, description, lineno, filename);
-      memTrack_unlock();
+      memTableShard* shard = memTrack_shard(moreMemAlloc);
+      memTrack_lock(shard);
+      addMemTableEntry(shard, moreMemAlloc, 1, size, description,
+                       lineno, filename);
+      memTrack_unlock(shard);
     }
     if (chpl_verbose_mem) {
       fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32
@@ -414,6 +414,64 @@ uint64_t chpl_sys_physicalMemoryBytes(void) {
 #endif
 }
 
+
+//
+// Read a "<key>: <n> kB" line out of a /proc file such as /proc/meminfo,
+// returning the value in bytes, or 0 if it isn't there.
+//
+static uint64_t readProcKbValue(const char* fname, const char* key) {
+#ifdef __linux__
+  FILE* f;
+  char buf[256];
+  size_t keyLen = strlen(key);
+  uint64_t val = 0;
+
+  if ((f = fopen(fname, "r")) == NULL)
+    return 0;
+  while (fgets(buf, sizeof(buf), f) != NULL) {
+    unsigned long long kb;
+    if (strncmp(buf, key, keyLen) == 0 && buf[keyLen] == ':'
+        && sscanf(buf + keyLen + 1, "%llu", &kb) == 1) {
+      val = (uint64_t) kb * 1024;
+      break;
+    }
+  }
+  (void) fclose(f);
+  return val;
+#else
+  return 0;
+#endif
+}
+
+
+size_t chpl_sys_getHugePageSize(void) {
+  static size_t hugePageSize = (size_t) -1;
+
+  if (hugePageSize == (size_t) -1)
+    hugePageSize = (size_t) readProcKbValue("/proc/meminfo", "Hugepagesize");
+  return hugePageSize;
+}
+
+
+int chpl_sys_adviseHugePages(void* p, size_t size) {
+#ifdef MADV_HUGEPAGE
+  size_t pgSize = chpl_getSysPageSize();
+  uintptr_t lo = ((uintptr_t) p + pgSize - 1) & ~(pgSize - 1);
+  uintptr_t hi = ((uintptr_t) p + size) & ~(pgSize - 1);
+  if (hi <= lo)
+    return 0;
+  return (madvise((void*) lo, hi - lo, MADV_HUGEPAGE) == 0) ? 0 : errno;
+#else
+  return ENOSYS;
+#endif
+}
+
+
+uint64_t chpl_sys_anonHugePageBytes(void) {
+  return readProcKbValue("/proc/self/smaps_rollup", "AnonHugePages");
+}
+
+
 #if defined(__linux__) || defined(__NetBSD__)
 //
 // Return information about the processors on the system.
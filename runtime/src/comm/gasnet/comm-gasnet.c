@@ -29,6 +29,7 @@
 #include "chpl-comm-callbacks.h"
 #include "chpl-comm-callbacks-internal.h"
 #include "chpl-comm-internal.h"
+#include "chpl-comm-strd-xfer.h"
 #include "chpl-env.h"
 #include "chpl-mem.h"
 #include "chplsys.h"
@@ -232,6 +233,64 @@ typedef struct {
   size_t size; // number of bytes.
 } xfer_info_t;
 
+//
+// Large forks whose argument bundle fits in a landing slot are sent as
+// one Long AM that deposits the bundle directly in the target's
+// segment, instead of a header the target has to follow with a GET.
+// Each node has one slot on every other node, at the front of its
+// segment just past the global variables table.  A slot is claimed by
+// the sender and freed by the target's reply once the bundle has been
+// copied out.  If our slot on the target is busy we use the GET path.
+//
+static size_t       fork_long_slot_size = 0;  // 0: no Long AM forks
+static size_t       fork_long_area_off = 0;   // slots start here in segment
+static size_t       fork_long_area_size = 0;
+static atomic_bool* fork_long_busy = NULL;    // our slot on node i in use?
+
+static inline
+void* fork_long_slot(c_nodeid_t node)
+{
+  return (char*) seginfo_table[node].addr + fork_long_area_off
+         + chpl_nodeID * fork_long_slot_size;
+}
+
+static inline
+chpl_bool fork_long_claim(c_nodeid_t node, size_t size)
+{
+  if (size > fork_long_slot_size)
+    return false;
+  return (!atomic_load_explicit_bool(&fork_long_busy[node],
+                                     memory_order_relaxed)
+          && !atomic_exchange_explicit_bool(&fork_long_busy[node], true,
+                                            memory_order_acquire));
+}
+
+//
+// Small forks to the same node can be coalesced into one Medium AM.
+// Whichever task finds nobody already sending to that node sends what
+// has accumulated, and keeps doing so until no more has come in, so a
+// request is never held back waiting for company.
+//
+typedef struct {
+  uint32_t op;          // FORK_SMALL or FORK_NB_SMALL
+  uint32_t size;        // size of the small fork message that follows
+} fork_batch_item_t;
+
+#define FORK_BATCH_ITEM_SIZE(sz)   ((sizeof(fork_batch_item_t) + (sz) + 7) & ~(size_t) 7)
+
+typedef struct {
+  atomic_spinlock_t lock;
+  chpl_bool         posting;    // someone is sending to this node
+  int               cnt;        // pending requests
+  size_t            len;        // bytes of pending requests
+  char*             pend;       // pending requests
+  char*             send;       // batch being sent
+} fork_coalesce_t;
+
+static chpl_bool        fork_coalesce_enabled = false;
+static size_t           fork_batch_space;
+static fork_coalesce_t* fork_coalesce = NULL;
+
 
 //
 // AM functions
@@ -245,6 +304,10 @@ typedef enum {
   FORK_NB_LARGE,        // non-blocking fork with a huge argument
   FORK_FAST,            // run the function in the handler (use with care)
   FORK_FAST_SMALL,      // run the function in the handler (use with care)
+  FORK_LONG,            // synchronous fork, bundle in a Long AM payload
+  FORK_NB_LONG,         // non-blocking fork, bundle in a Long AM payload
+  FORK_LONG_FREE,       // reply: the sender's landing slot is free again
+  FORK_BATCH,           // several coalesced small forks
 
   SIGNAL,               // ack to a done_t via gasnet_AMReplyShortM()
   SIGNAL_LONG,          // ack to a done_t via gasnet_AMReplyLongM()
@@ -489,6 +552,45 @@ static void AM_fork_nb_large(gasnet_token_t token, void* buf, size_t nbytes) {
                            f->hdr.subloc, chpl_nullTaskID);
 }
 
+//
+// The bundle has landed in the sender's slot in our segment.  Starting
+// the task copies it out, so after that the sender can have the slot
+// back.
+//
+static void AM_fork_long(gasnet_token_t token, void* buf, size_t nbytes) {
+  AM_fork(token, buf, nbytes);
+  GASNET_Safe(gasnet_AMReplyShort0(token, FORK_LONG_FREE));
+}
+
+static void AM_fork_nb_long(gasnet_token_t token, void* buf, size_t nbytes) {
+  AM_fork_nb(token, buf, nbytes);
+  GASNET_Safe(gasnet_AMReplyShort0(token, FORK_LONG_FREE));
+}
+
+static void AM_fork_long_free(gasnet_token_t token) {
+  gasnet_node_t src;
+
+  GASNET_Safe(gasnet_AMGetMsgSource(token, &src));
+  atomic_store_explicit_bool(&fork_long_busy[src], false,
+                             memory_order_release);
+}
+
+static void AM_fork_batch(gasnet_token_t token, void* buf, size_t nbytes) {
+  char* p = buf;
+  char* end = p + nbytes;
+
+  while (p < end) {
+    fork_batch_item_t* item = (fork_batch_item_t*) p;
+
+    if (item->op == FORK_SMALL)
+      AM_fork_small(token, item + 1, item->size);
+    else
+      AM_fork_nb_small(token, item + 1, item->size);
+
+    p += FORK_BATCH_ITEM_SIZE(item->size);
+  }
+}
+
 static void AM_signal(gasnet_token_t token, gasnet_handlerarg_t a0, gasnet_handlerarg_t a1) {
   done_t* done = (done_t*) get_ptr_from_args(a0, a1);
   uint_least32_t prev;
@@ -585,6 +687,10 @@ static gasnet_handlerentry_t ftable[] = {
   {FORK_NB_LARGE, AM_fork_nb_large},
   {FORK_FAST,     AM_fork_fast},
   {FORK_FAST_SMALL, AM_fork_fast_small},
+  {FORK_LONG,     AM_fork_long},
+  {FORK_NB_LONG,  AM_fork_nb_long},
+  {FORK_LONG_FREE, AM_fork_long_free},
+  {FORK_BATCH,    AM_fork_batch},
   {SIGNAL,        AM_signal},
   {SIGNAL_LONG,   AM_signal_long},
   {PRIV_BCAST,    AM_priv_bcast},
@@ -629,6 +735,7 @@ chpl_comm_nb_handle_t chpl_comm_put_nb(void *addr, c_nodeid_t node, void* raddr,
   ret = gasnet_put_nb_bulk(node, raddr, addr, size);
 
   chpl_comm_diags_incr(put_nb);
+  chpl_comm_diags_size(put, node, size);
 
   return (chpl_comm_nb_handle_t) ret;
 }
@@ -663,6 +770,7 @@ chpl_comm_nb_handle_t chpl_comm_get_nb(void* addr, c_nodeid_t node, void* raddr,
   ret = gasnet_get_nb_bulk(addr, node, raddr, size);
 
   chpl_comm_diags_incr(get_nb);
+  chpl_comm_diags_size(get, node, size);
 
   return (chpl_comm_nb_handle_t) ret;
 }
@@ -672,15 +780,41 @@ int chpl_comm_test_nb_complete(chpl_comm_nb_handle_t h)
   return ((void*)h) == NULL;
 }
 
+static inline
+int any_nb_pending(chpl_comm_nb_handle_t* h, size_t nhandles)
+{
+  size_t i;
+
+  for (i = 0; i < nhandles; i++) {
+    if (h[i] != NULL)
+      return 1;
+  }
+  return 0;
+}
+
 void chpl_comm_wait_nb_some(chpl_comm_nb_handle_t* h, size_t nhandles)
 {
   assert(NULL == GASNET_INVALID_HANDLE);  // serious confusion if not so
-  gasnet_wait_syncnb_some((gasnet_handle_t*) h, nhandles);
+
+  //
+  // Rather than gasnet_wait_syncnb_some(), which would hold onto this
+  // thread until something completed, poll and yield in between so
+  // that other tasks (the remote cache's readahead, for example) can
+  // make progress meanwhile.  Return once at least one has completed
+  // or none are left in flight.
+  //
+  while (any_nb_pending(h, nhandles)) {
+    if (gasnet_try_syncnb_some((gasnet_handle_t*) h, nhandles) == GASNET_OK)
+      return;
+    chpl_task_yield();
+  }
 }
 
 int chpl_comm_try_nb_some(chpl_comm_nb_handle_t* h, size_t nhandles)
 {
   assert(NULL == GASNET_INVALID_HANDLE);  // serious confusion if not so
+  if (!any_nb_pending(h, nhandles))
+    return 0;
   return gasnet_try_syncnb_some((gasnet_handle_t*) h, nhandles) == GASNET_OK;
 }
 
@@ -744,6 +878,8 @@ static inline void am_poll_try(void) {
 }
 
 static void polling(void* x) {
+  (void) chpl_topo_bindToReservedCPUs();
+
   pollingRunning = 1;
 
   while (!pollingQuit) {
@@ -820,6 +956,76 @@ static void set_num_comm_domains() {
 #endif
 }
 
+//
+// Decide whether we can deliver large fork bundles in Long AM payloads,
+// and if so carve out the landing slots.  Every node must come to the
+// same conclusion, since senders compute slot addresses themselves, so
+// this only depends on things all the nodes agree on.
+//
+static void setup_fork_long(void) {
+#if defined(GASNET_SEGMENT_FAST) || defined(GASNET_SEGMENT_LARGE)
+  size_t slot_size;
+  size_t min_seg_size;
+  size_t globals_size;
+  int i;
+
+  slot_size = chpl_env_rt_get_size("COMM_GASNET_FORK_LONG_SLOT_SIZE",
+                                   64 * 1024);
+  if (slot_size > gasnet_AMMaxLongRequest())
+    slot_size = gasnet_AMMaxLongRequest();
+
+  //
+  // Don't let the slots take more than 1/64 of the smallest segment.
+  //
+  min_seg_size = seginfo_table[0].size;
+  for (i = 1; i < chpl_numNodes; i++) {
+    if (seginfo_table[i].size < min_seg_size)
+      min_seg_size = seginfo_table[i].size;
+  }
+  if (slot_size > min_seg_size / 64 / chpl_numNodes)
+    slot_size = min_seg_size / 64 / chpl_numNodes;
+  slot_size &= ~(size_t) 63;
+
+  // Anything not bigger than a Medium AM payload doesn't need a slot.
+  if (chpl_numNodes == 1 || slot_size <= gasnet_AMMaxMedium())
+    return;
+
+  globals_size = chpl_numGlobalsOnHeap * sizeof(wide_ptr_t);
+  fork_long_slot_size = slot_size;
+  fork_long_area_off = (globals_size + 63) & ~(size_t) 63;
+  fork_long_area_size = fork_long_area_off - globals_size
+                        + chpl_numNodes * slot_size;
+
+  fork_long_busy = (atomic_bool*) sys_malloc(chpl_numNodes
+                                             * sizeof(fork_long_busy[0]));
+  for (i = 0; i < chpl_numNodes; i++)
+    atomic_init_bool(&fork_long_busy[i], false);
+#endif
+}
+
+static void setup_fork_coalesce(void) {
+  int i;
+
+  fork_coalesce_enabled = chpl_env_rt_get_bool("COMM_GASNET_FORK_COALESCE",
+                                               false);
+  if (!fork_coalesce_enabled)
+    return;
+
+  fork_batch_space = gasnet_AMMaxMedium();
+  fork_coalesce = chpl_mem_allocManyZero(chpl_numNodes,
+                                         sizeof(fork_coalesce[0]),
+                                         CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0);
+  for (i = 0; i < chpl_numNodes; i++) {
+    atomic_init_spinlock_t(&fork_coalesce[i].lock);
+    fork_coalesce[i].pend = chpl_mem_alloc(fork_batch_space,
+                                           CHPL_RT_MD_COMM_PER_LOC_INFO,
+                                           0, 0);
+    fork_coalesce[i].send = chpl_mem_alloc(fork_batch_space,
+                                           CHPL_RT_MD_COMM_PER_LOC_INFO,
+                                           0, 0);
+  }
+}
+
 void chpl_comm_init(int *argc_p, char ***argv_p) {
 //  int status; // Some compilers complain about unused variable 'status'.
 
@@ -903,12 +1109,15 @@ void chpl_comm_init(int *argc_p, char ***argv_p) {
   chpl_comm_barrier("making sure everyone's done with the broadcast");
 #endif
 
+  setup_fork_long();
+
   gasnet_set_waitmode(GASNET_WAIT_BLOCK);
 
 }
 
 void chpl_comm_post_mem_init(void) {
   chpl_comm_init_prv_bcast_tab();
+  setup_fork_coalesce();
 }
 
 //
@@ -940,9 +1149,11 @@ void chpl_comm_rollcall(void) {
 void chpl_comm_impl_regMemHeapInfo(void** start_p, size_t* size_p) {
 #if defined(GASNET_SEGMENT_FAST) || defined(GASNET_SEGMENT_LARGE)
   *start_p = chpl_numGlobalsOnHeap * sizeof(wide_ptr_t)
+             + fork_long_area_size
              + (char*)seginfo_table[chpl_nodeID].addr;
   *size_p  = seginfo_table[chpl_nodeID].size
-             - chpl_numGlobalsOnHeap * sizeof(wide_ptr_t);
+             - chpl_numGlobalsOnHeap * sizeof(wide_ptr_t)
+             - fork_long_area_size;
 #else /* GASNET_SEGMENT_EVERYTHING */
   *start_p = NULL;
   *size_p  = 0;
@@ -1096,6 +1307,7 @@ void  chpl_comm_put(void* addr, c_nodeid_t node, void* raddr,
 
     chpl_comm_diags_verbose_rdma("put", node, size, ln, fn, commID);
     chpl_comm_diags_incr(put);
+    chpl_comm_diags_size(put, node, size);
 
     // Handle remote address not in remote segment.
 #ifdef GASNET_SEGMENT_EVERYTHING
@@ -1171,6 +1383,7 @@ void  chpl_comm_get(void* addr, c_nodeid_t node, void* raddr,
 
     chpl_comm_diags_verbose_rdma("get", node, size, ln, fn, commID);
     chpl_comm_diags_incr(get);
+    chpl_comm_diags_size(get, node, size);
 
     // Handle remote address not in remote segment.
 
@@ -1270,6 +1483,37 @@ void  chpl_comm_get(void* addr, c_nodeid_t node, void* raddr,
   }
 }
 
+//
+// GASNet VIS needs the remote side of a strided transfer to be in the
+// target's segment.  When it isn't (with SEGMENT_FAST or SEGMENT_LARGE,
+// memory allocated outside the Chapel heap), break the transfer up and
+// do the pieces with chpl_comm_put_nb()/get_nb(), which know how to
+// reach such memory.
+//
+#define STRD_MAX_HANDLES 16
+
+static inline
+chpl_bool strd_remote_in_segment(c_nodeid_t node, void* raddr,
+                                 size_t* strides, size_t* count,
+                                 int32_t stridelevels, size_t elemSize)
+{
+#ifdef GASNET_SEGMENT_EVERYTHING
+  return true;
+#else
+  size_t extent = count[0] * elemSize;
+  int32_t i;
+
+  for (i = 0; i < stridelevels; i++)
+    extent += strides[i] * elemSize * (count[i + 1] - 1);
+
+  return chpl_comm_addr_gettable(node, raddr, extent);
+#endif
+}
+
+static void strd_yield(void) {
+  chpl_task_yield();
+}
+
 //
 // This is an adapter from Chapel code to GASNet's gasnet_gets_bulk. It does:
 // * convert count[0] and all of 'srcstr' and 'dststr' from counts of element
@@ -1287,6 +1531,15 @@ void  chpl_comm_get_strd(void* dstaddr, size_t* dststrides, c_nodeid_t srcnode_i
   size_t srcstr[strlvls];
   size_t cnt[strlvls+1];
 
+  if (!strd_remote_in_segment(srcnode_id, srcaddr, srcstrides, count,
+                              stridelevels, elemSize)) {
+    get_strd_common(dstaddr, dststrides, srcnode_id,
+                    srcaddr, srcstrides, count, stridelevels, elemSize,
+                    STRD_MAX_HANDLES, strd_yield,
+                    commID, ln, fn);
+    return;
+  }
+
   // Only count[0] and strides are measured in number of bytes.
   cnt[0] = count[0] * elemSize;
 
@@ -1316,7 +1569,6 @@ void  chpl_comm_get_strd(void* dstaddr, size_t* dststrides, c_nodeid_t srcnode_i
     chpl_comm_diags_incr(get);
   }
 
-  // TODO -- handle strided get for non-registered memory
   gasnet_gets_bulk(dstaddr, dststr, srcnode, srcaddr, srcstr, cnt, strlvls);
 }
 
@@ -1333,6 +1585,15 @@ void  chpl_comm_put_strd(void* dstaddr, size_t* dststrides, c_nodeid_t dstnode_i
   size_t srcstr[strlvls];
   size_t cnt[strlvls+1];
 
+  if (!strd_remote_in_segment(dstnode_id, dstaddr, dststrides, count,
+                              stridelevels, elemSize)) {
+    put_strd_common(dstaddr, dststrides, dstnode_id,
+                    srcaddr, srcstrides, count, stridelevels, elemSize,
+                    STRD_MAX_HANDLES, strd_yield,
+                    commID, ln, fn);
+    return;
+  }
+
   // Only count[0] and strides are measured in number of bytes.
   cnt[0] = count[0] * elemSize;
   if (strlvls>0) {
@@ -1361,7 +1622,6 @@ void  chpl_comm_put_strd(void* dstaddr, size_t* dststrides, c_nodeid_t dstnode_i
     chpl_comm_diags_incr(put);
   }
 
-  // TODO -- handle strided put for non-registered memory
   gasnet_puts_bulk(dstnode, dstaddr, dststr, srcaddr, srcstr, cnt, strlvls);
 }
 
@@ -1413,6 +1673,75 @@ void chpl_comm_put_unordered(void* addr, c_nodeid_t node, void* raddr,
 
 void chpl_comm_getput_unordered_task_fence(void) { }
 
+static
+void fork_coalesce_drain(c_nodeid_t node)
+{
+  fork_coalesce_t* fc = &fork_coalesce[node];
+  char* batch;
+  size_t len;
+  int cnt;
+
+  atomic_lock_spinlock_t(&fc->lock);
+  while (fc->cnt > 0) {
+    batch = fc->pend;
+    len = fc->len;
+    cnt = fc->cnt;
+    fc->pend = fc->send;
+    fc->send = batch;
+    fc->cnt = 0;
+    fc->len = 0;
+    atomic_unlock_spinlock_t(&fc->lock);
+
+    if (cnt == 1) {
+      fork_batch_item_t* item = (fork_batch_item_t*) batch;
+      GASNET_Safe(gasnet_AMRequestMedium0(node, item->op, item + 1,
+                                          item->size));
+    } else {
+      chpl_comm_diags_incr(am_batches);
+      chpl_comm_diags_add(am_batched_reqs, cnt);
+      GASNET_Safe(gasnet_AMRequestMedium0(node, FORK_BATCH, batch, len));
+    }
+
+    atomic_lock_spinlock_t(&fc->lock);
+  }
+  fc->posting = false;
+  atomic_unlock_spinlock_t(&fc->lock);
+}
+
+static
+void fork_coalesce_post(c_nodeid_t node, int op,
+                        small_fork_hdr_t* f, size_t size)
+{
+  fork_coalesce_t* fc = &fork_coalesce[node];
+  size_t item_size = FORK_BATCH_ITEM_SIZE(size);
+  fork_batch_item_t* item;
+  chpl_bool must_post;
+
+  //
+  // If the pending batch is full someone must be sending it, so wait
+  // until they've taken it.
+  //
+  while (true) {
+    atomic_lock_spinlock_t(&fc->lock);
+    if (fc->len + item_size <= fork_batch_space)
+      break;
+    atomic_unlock_spinlock_t(&fc->lock);
+    chpl_task_yield();
+  }
+  item = (fork_batch_item_t*) (fc->pend + fc->len);
+  item->op = op;
+  item->size = size;
+  memcpy(item + 1, f, size);
+  fc->len += item_size;
+  fc->cnt++;
+  must_post = !fc->posting;
+  fc->posting = true;
+  atomic_unlock_spinlock_t(&fc->lock);
+
+  if (must_post)
+    fork_coalesce_drain(node);
+}
+
 static inline
 void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
                         chpl_fn_int_t fid,
@@ -1423,6 +1752,7 @@ void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
   size_t small_msg_size = payload_size + sizeof(small_fork_hdr_t);
   int large = (arg_size > gasnet_AMMaxMedium());
   int small = (small_msg_size < sizeof(special_fork_t) && !large);
+  int use_long;
 
   int op;
 
@@ -1435,6 +1765,12 @@ void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
   // handler has to GET the bundle.
   fast = fast && ! large;
 
+  // If the bundle fits in our landing slot on the target, send it all
+  // in one Long AM and don't treat it as a large one any more.
+  use_long = large && fork_long_claim(node, arg_size);
+  if (use_long)
+    large = 0;
+
   op = 0;
   if (fast) {
     // At this point, a fast implies !large.
@@ -1443,13 +1779,15 @@ void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
     if (small)      op = FORK_FAST_SMALL;
     else            op = FORK_FAST;
   } else if(blocking) {
-    if (small)      op = FORK_SMALL;
-    else if (large) op = FORK_LARGE;
-    else            op = FORK;
+    if (small)         op = FORK_SMALL;
+    else if (large)    op = FORK_LARGE;
+    else if (use_long) op = FORK_LONG;
+    else               op = FORK;
   } else {
-    if (small)      op = FORK_NB_SMALL;
-    else if (large) op = FORK_NB_LARGE;
-    else            op = FORK_NB;
+    if (small)         op = FORK_NB_SMALL;
+    else if (large)    op = FORK_NB_LARGE;
+    else if (use_long) op = FORK_NB_LONG;
+    else               op = FORK_NB;
   }
 
   if (large) {
@@ -1480,8 +1818,11 @@ void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
       // Copy in the payload
       memcpy(f + 1, arg + 1, payload_size);
 
-      // Send the AM
-      GASNET_Safe(gasnet_AMRequestMedium0(node, op, f, small_msg_size));
+      // Send the AM, or add it to a batch for the target
+      if (fork_coalesce_enabled && !fast)
+        fork_coalesce_post(node, op, f, small_msg_size);
+      else
+        GASNET_Safe(gasnet_AMRequestMedium0(node, op, f, small_msg_size));
     } else {
       // Setup a small message pointing to arg
       // so the other side can GET from it
@@ -1520,7 +1861,13 @@ void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
     arg->comm.caller = chpl_nodeID;
     arg->comm.ack = blocking ? &done : NULL;
 
-    GASNET_Safe(gasnet_AMRequestMedium0(node, op, arg, arg_size));
+    // A Long AM request doesn't return until arg can be reused, so
+    // unlike the GET path a non-blocking one needn't copy it.
+    if (use_long)
+      GASNET_Safe(gasnet_AMRequestLong0(node, op, arg, arg_size,
+                                        fork_long_slot(node)));
+    else
+      GASNET_Safe(gasnet_AMRequestMedium0(node, op, arg, arg_size));
   }
 
   if (blocking)
@@ -1547,6 +1894,7 @@ void  chpl_comm_execute_on(c_nodeid_t node, c_sublocid_t subloc,
 
     chpl_comm_diags_verbose_executeOn("", node, ln, fn);
     chpl_comm_diags_incr(execute_on);
+    chpl_comm_diags_size(execute_on, node, arg_size);
 
     execute_on_common(node, subloc, fid, arg, arg_size,
                      /*fast*/ false, /*blocking*/ true);
@@ -1571,6 +1919,7 @@ void  chpl_comm_execute_on_nb(c_nodeid_t node, c_sublocid_t subloc,
 
     chpl_comm_diags_verbose_executeOn("non-blocking", node, ln, fn);
     chpl_comm_diags_incr(execute_on_nb);
+    chpl_comm_diags_size(execute_on, node, arg_size);
 
     execute_on_common(node, subloc, fid, arg, arg_size,
                       /*fast*/ false, /*blocking*/ false);
@@ -1596,6 +1945,7 @@ void  chpl_comm_execute_on_fast(c_nodeid_t node, c_sublocid_t subloc,
 
     chpl_comm_diags_verbose_executeOn("fast", node, ln, fn);
     chpl_comm_diags_incr(execute_on_fast);
+    chpl_comm_diags_size(execute_on, node, arg_size);
 
     execute_on_common(node, subloc, fid, arg, arg_size,
                       /*fast*/ true, /*blocking*/ true);
@@ -22,6 +22,11 @@
 // OFI-based implementation of Chapel communication interface.
 //
 
+#ifndef _GNU_SOURCE
+// get process_vm_readv(), process_vm_writev()
+#define _GNU_SOURCE
+#endif
+
 #include "chplrt.h"
 #include "chpl-env-gen.h"
 
@@ -112,19 +117,15 @@ static struct fid_fabric* ofi_fabric;   // fabric domain
 static struct fid_domain* ofi_domain;   // fabric access domain
 static int useScalableTxEp;             // use a scalable tx endpoint?
 static struct fid_ep* ofi_txEpScal;     // scalable transmit endpoint
-static struct fid_poll* ofi_amhPollSet; // poll set for AM handler
-static int pollSetSize = 0;             // number of fids in the poll set
-static struct fid_wait* ofi_amhWaitSet; // wait set for AM handler
 
 static int haveDeliveryComplete;        // delivery-complete? (vs. msg order)
 
 //
 // We direct RMA traffic and AM traffic to different endpoints so we can
 // spread the progress load across all the threads when we're doing
-// manual progress.
+// manual progress.  The AM receive endpoints are per AM handler; see
+// struct perAmHandlerInfo_t, below.
 //
-static struct fid_ep* ofi_rxEp;         // AM req receive endpoint
-static struct fid_cq* ofi_rxCQ;         // AM req receive endpoint CQ
 static struct fid_ep* ofi_rxEpRma;      // RMA/AMO target endpoint
 static struct fid_cq* ofi_rxCQRma;      // RMA/AMO target endpoint CQ
 static struct fid_cntr* ofi_rxCntrRma;  // RMA/AMO target endpoint counter
@@ -134,8 +135,53 @@ static void (*checkRxRmaCmplsFn)(void); // fn: check for RMA/AMO EP completions
 static struct fid_av* ofi_av;           // address vector
 static fi_addr_t* ofi_rxAddrs;          // table of remote endpoint addresses
 
-#define rxMsgAddr(tcip, n) (ofi_rxAddrs[2 * (n)])
-#define rxRmaAddr(tcip, n) (ofi_rxAddrs[2 * (n) + 1])
+//
+// With CHPL_RT_COMM_OFI_LAZY_AV=true we don't insert a node's endpoint
+// addresses into the AV until we first talk to it.  Until then its
+// ofi_rxAddrs[] entries are FI_ADDR_NOTAVAIL and its raw addresses are
+// kept in rxAddrNames[].  (See rxNodeAddrs().)
+//
+static chpl_bool lazyAvInsert = false;
+static char* rxAddrNames;               // lazy AV: every node's raw addrs
+static size_t rxAddrNamesLen;           // lazy AV: raw addr bytes per node
+static atomic_bool* rxAddrsInAv;        // lazy AV: node's addrs are in AV
+static pthread_mutex_t rxAddrsLock = PTHREAD_MUTEX_INITIALIZER;
+
+//
+// Co-located nodes.  With CHPL_RT_COMM_OFI_CMA=true we find the other
+// nodes on our host and do RMA with them by copying directly between
+// the processes, using Linux cross-memory attach, instead of through
+// the provider.  (See init_ofiCma().)  cmaPids[n] is node n's pid if we
+// can reach it that way, otherwise 0.  cmaPids is NULL if we can't
+// reach anyone.
+//
+static pid_t* cmaPids;
+
+#define cmaReachable(n) (cmaPids != NULL && cmaPids[n] != 0)
+
+//
+// Each node has an AM receive endpoint per AM handler followed by its
+// RMA endpoint in ofi_rxAddrs[].  We always send our AM requests to
+// the same one of a node's AM handlers, chosen by our own node ID, so
+// that they are handled in the order we sent them.
+//
+static int rxAddrsPerNode;              // numAmHandlers + 1
+static int rxAmHandlerIdx;              // AM handler we send AMs to
+
+static void rxAddrsInsert(c_nodeid_t);
+
+static inline
+fi_addr_t* rxNodeAddrs(c_nodeid_t node) {
+  if (lazyAvInsert
+      && !atomic_load_explicit_bool(&rxAddrsInAv[node],
+                                    memory_order_acquire)) {
+    rxAddrsInsert(node);
+  }
+  return &ofi_rxAddrs[rxAddrsPerNode * node];
+}
+
+#define rxMsgAddr(tcip, n) (rxNodeAddrs(n)[rxAmHandlerIdx])
+#define rxRmaAddr(tcip, n) (rxNodeAddrs(n)[rxAddrsPerNode - 1])
 
 //
 // Transmit support.
@@ -146,6 +192,8 @@ static int numRxCtxs;
 struct perTxCtxInfo_t {
   atomic_bool allocated;        // true: in use; false: available
   chpl_bool bound;              // true: bound to an owner (usually a thread)
+  atomic_bool onFreeList;       // true: in the worker free list
+  atomic_uint_least32_t nextFree; // free list link (tciTab index + 1)
   struct fid_ep* txCtx;         // transmit context (endpoint, if not scalable)
   struct fid_cq* txCQ;          // completion CQ
   struct fid_cntr* txCntr;      // completion counter (AM handler tx ctx only)
@@ -162,7 +210,22 @@ static int tciTabLen;
 static struct perTxCtxInfo_t* tciTab;
 static chpl_bool tciTabFixedAssignments;
 
+//
+// Free list of unbound worker tx contexts.  The head packs an ABA tag
+// in the upper 32 bits with the top entry's tciTab index + 1 (0 means
+// empty) in the lower ones.
+//
+static atomic_uint_least64_t tciFreeHead;
+static atomic_int_least32_t tciNumBound; // # of bound worker tx contexts
+
 static int txCQLen;
+static size_t txCQReadCount;    // max CQ entries we read at once
+
+//
+// How many times to poll for progress while waiting for a transaction
+// before starting to sched_yield() between polls.
+//
+static int txnWaitSpins = 0;
 
 //
 // Memory registration support.
@@ -187,6 +250,86 @@ typedef struct memEntry (memTab_t)[MAX_MEM_REGIONS];
 static memTab_t memTab;
 static memTab_t* memTabMap;
 
+//
+// Multi-rail support.  With CHPL_RT_COMM_OFI_RAILS=n (n > 1) we open
+// up to n-1 more access domains, on other NICs our provider offers,
+// each with just an RMA target endpoint and some tx endpoints of its
+// own.  Large PUTs and GETs are striped across the main domain and
+// these, and smaller but still bulky ones go through the NIC nearest
+// the calling thread's NUMA domain, if we know that.  (See
+// init_ofiRails() and railRma().)  Only PUTs and GETs use the extra
+// rails.  Everything they do is done with delivery-complete and
+// waited for before we return, so they need no help from the rest of
+// our MCM conformance machinery.
+//
+struct railTxCtx_t {
+  atomic_bool busy;             // true: some thread is using this one
+  struct fid_ep* ep;
+  struct fid_cq* cq;
+};
+
+struct rail_t {
+  struct fi_info* info;
+  struct fid_fabric* fabric;
+  struct fid_domain* domain;
+  struct fid_av* av;
+  struct fid_ep* rxEp;          // RMA target endpoint
+  struct fid_cq* rxCQ;          // RMA target endpoint CQ
+  struct fid_mr* mrTab[MAX_MEM_REGIONS];
+  memTab_t memTab;              // our regions, registered on this rail
+  memTab_t* memTabMap;          // everyone's (NULL: scalable mem reg)
+  fi_addr_t* rxAddrs;           // every node's RMA endpoint on this rail
+  int numTxCtxs;
+  struct railTxCtx_t* txCtxs;
+  c_sublocid_t subloc;          // NUMA domain nearest the NIC, or any
+};
+
+static int numRails = 1;                // main domain plus extra rails
+static struct rail_t* railTab;          // the extra rails
+static c_sublocid_t mainRailSubloc = c_sublocid_any;
+static size_t railStripeMinSize = 1 << 20;
+static size_t railNearMinSize = 64 * 1024;
+
+//
+// Registration cache for local RMA buffers outside the regions above.
+// (See mrCacheAcquire().)
+//
+struct mrCacheEntry {
+  char* addr;
+  size_t size;
+  struct fid_mr* mr;
+  void* desc;
+  int refs;
+  uint64_t lastUse;
+};
+
+static struct mrCacheEntry* mrCache;
+static int mrCacheLen = 32;
+static size_t mrCacheMinSize = 64 * 1024;
+static pthread_mutex_t mrCacheLock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t mrCacheClock;
+static uint64_t mrCacheNextKey = MAX_MEM_REGIONS;
+
+//
+// Local registrations of pinned host and GPU memory that the memory
+// layer has told us about.  (See chpl_comm_impl_regMemAdd().)  These
+// are looked up after the fixed regions, and share the MR cache's lock
+// and key space.
+//
+#define MAX_EXT_MEM_REGIONS 64
+
+struct extMemEntry {
+  char* addr;
+  size_t size;
+  struct fid_mr* mr;
+  void* desc;
+};
+
+static struct extMemEntry extMemTab[MAX_EXT_MEM_REGIONS];
+static atomic_int_least32_t numExtMemRegions;
+static chpl_bool hmemEnabled;
+static chpl_bool extMemReady;
+
 //
 // Messaging (AM) support.
 //
@@ -203,15 +346,49 @@ struct amRequest_execOnLrg_t {
   void* pPayload;                 // addr of arg payload on initiator node
 };
 
+//
+// What the AM handler passes to the task it starts for a large on-stmt.
+// If 'bundle' is non-NULL the handler has already started the GET of
+// the payload into it, and sets *pGetDone when that finishes.
+//
+struct taskArg_execOnLrg_t {
+  struct amRequest_execOnLrg_t xol;
+  chpl_comm_on_bundle_t* bundle;
+  atomic_bool* pGetDone;
+};
+
 static int numAmHandlers = 1;
 
 //
-// AM request landing zones.
+// Fan-out of the trees we use for the barrier and broadcasts.
+//
+#define BAR_TREE_NUM_CHILDREN 64
+
+//
+// Per AM handler information.  Each AM handler has its own receive
+// endpoint and landing zones for AM requests and, if we can use them,
+// its own poll and wait sets.  The first AM handler also takes care
+// of progress on the RMA/AMO target endpoint.
 //
-static void* amLZs[2];
-static struct iovec ofi_iov_reqs[2];
-static struct fi_msg ofi_msg_reqs[2];
-static int ofi_msg_i;
+struct perAmHandlerInfo_t {
+  struct fid_ep* rxEp;          // AM req receive endpoint
+  struct fid_cq* rxCQ;          // AM req receive endpoint CQ
+  struct fid_poll* pollSet;     // poll set for this AM handler
+  int pollSetSize;              // number of fids in the poll set
+  struct fid_wait* waitSet;     // wait set for this AM handler
+
+  //
+  // AM request landing zones.
+  //
+  void* lzs[2];
+  struct iovec iovReqs[2];
+  struct fi_msg msgReqs[2];
+  int msgI;
+};
+
+static struct perAmHandlerInfo_t* amhTab;
+
+static __thread struct perAmHandlerInfo_t* amhip; // AM handler's own entry
 
 
 ////////////////////////////////////////
@@ -223,6 +400,7 @@ static void emit_delayedFixedHeapMsgs(void);
 
 static inline struct perTxCtxInfo_t* tciAlloc(void);
 static inline struct perTxCtxInfo_t* tciAllocForAmHandler(void);
+static void tciFreeListInit(int);
 static inline void tciFree(struct perTxCtxInfo_t*);
 static inline chpl_comm_nb_handle_t ofi_put(const void*, c_nodeid_t,
                                             void*, size_t);
@@ -230,6 +408,9 @@ static inline void ofi_put_ll(const void*, c_nodeid_t,
                               void*, size_t, void*, struct perTxCtxInfo_t*,
                               chpl_bool);
 static inline void do_remote_put_buff(void*, c_nodeid_t, void*, size_t);
+static inline void do_remote_put_agg(void*, c_nodeid_t, void*, size_t);
+static inline void agg_put_flush_node(c_nodeid_t);
+static inline void agg_put_flush_all(void);
 static inline chpl_comm_nb_handle_t ofi_get(void*, c_nodeid_t,
                                             void*, size_t);
 static inline void ofi_get_ll(void*, c_nodeid_t,
@@ -237,6 +418,10 @@ static inline void ofi_get_ll(void*, c_nodeid_t,
 static inline void do_remote_get_buff(void*, c_nodeid_t, void*, size_t);
 static inline void do_remote_amo_nf_buff(void*, c_nodeid_t, void*, size_t,
                                          enum fi_op, enum fi_datatype);
+static inline chpl_bool do_remote_amo_agg(const void*, c_nodeid_t, void*,
+                                          size_t, int, enum fi_datatype);
+static inline void agg_amo_flush_node(c_nodeid_t);
+static inline void agg_amo_flush_all(void);
 static void amEnsureProgress(struct perTxCtxInfo_t*);
 static void checkRxRmaCmplsCQ(void);
 static void checkRxRmaCmplsCntr(void);
@@ -337,6 +522,38 @@ static atomic_bool amHandlersExit;
 static chpl_bool amDoLivenessChecks = false;
 
 
+//
+// Should we batch AM requests we don't wait for?  (See amBatchAdd().)
+// With amBatchEnabled we batch all kinds of them.  Otherwise, with
+// amBatchAmos we batch just the AMOs done by AM because the provider
+// can't do them (see amoPath()), and only if there are such types.
+// amBatching says whether either of these is in effect.
+//
+static chpl_bool amBatchEnabled = false;
+static chpl_bool amBatchAmos = true;
+static chpl_bool amBatching = false;
+static size_t amBatchMaxBytes = 1024;
+static double amBatchMaxAge = 20e-6; // seconds
+
+
+//
+// On-stmt arg bundles up to this size are sent in the AM request
+// itself; the target retrieves larger ones.  (See init_ofiForAms().)
+//
+static size_t amExecOnEagerMaxBytes = 8 * 1024;
+
+
+//
+// Which barrier algorithm chpl_comm_barrier() uses.  (See init_bar().)
+//
+typedef enum {
+  bar_algTree,
+  bar_algDissemination,
+} bar_alg_t;
+
+static bar_alg_t barAlg = bar_algTree;
+
+
 //
 // The ofi_rxm provider may return -FI_EAGAIN for read/write/send while
 // doing on-demand connection when emulating FI_RDM endpoints.  The man
@@ -718,9 +935,89 @@ chpl_comm_taskPrvData_t* get_comm_taskPrvdata(void) {
 enum BuffType {
   amo_nf_buff = 1 << 0,
   get_buff    = 1 << 1,
-  put_buff    = 1 << 2
+  put_buff    = 1 << 2,
+  agg_put_buff = 1 << 3,
+  agg_amo_buff = 1 << 4
 };
 
+//
+// Aggregation of ordinary (ordered) PUTs.  When enabled, small
+// chpl_comm_put()s are gathered in a per-task buffer like the one for
+// unordered PUTs, and initiated together.  The buffer is flushed when
+// it holds CHPL_RT_COMM_OFI_AGGREGATE_BYTES bytes or MAX_CHAINED_PUT_LEN
+// PUTs, when a new PUT is added more than CHPL_RT_COMM_OFI_AGGREGATE_USECS
+// after the oldest one, and before anything that MCM conformance says
+// must see the PUTs: any other transaction from this task to one of the
+// target nodes, and every point at which we make all of our PUTs
+// visible (see waitForPutsVisAllNodes()).  A PUT that overlaps one
+// already in the buffer flushes the buffer first, to keep their order.
+//
+static chpl_bool aggPutsEnabled = false;
+static size_t aggPutsMaxBytes = 16 * 1024;
+static double aggPutsMaxAge = 100e-6; // seconds
+
+//
+// Aggregation of ordinary non-fetching AMOs.  When enabled, remote
+// non-fetching integer adds (and subs) and bitwise ops that we can do
+// natively are gathered in a per-task buffer like the one for
+// unordered AMOs, except that a new AMO with the same target object,
+// op, and type as one already in the buffer is combined into that one
+// instead of getting its own entry.  So a task doing lots of adds to a
+// few hot counters ends up doing just a few network AMOs.  The buffer
+// is flushed when it is full, and before anything that MCM conformance
+// says must see the AMOs: any other AMO by this task, any PUT or GET
+// or AM from this task to one of the target nodes, and every point at
+// which we make all of our PUTs visible (see waitForPutsVisAllNodes()).
+//
+static chpl_bool aggAmosEnabled = false;
+
+//
+// How we do each kind of AMO on each type.  A type the provider can
+// do a fetching compare-and-swap on (directly, or as the unsigned
+// integer type of the same size) is done on the network, natively for
+// the kinds of AMOs the provider supports on it and as a loop around
+// that compare-and-swap for the others (see doCasAMO()).  Any other
+// type is done on the target's CPU, by AM if the target is remote.
+// We can't split one type between the network and the CPU, because
+// network atomics aren't necessarily atomic with respect to processor
+// ones.
+//
+typedef enum {
+  amo_pathAm,                  // on the target's CPU, by AM if needed
+  amo_pathNative,              // native network AMO
+  amo_pathCas,                 // loop around a network compare-and-swap
+} amoPath_t;
+
+static uint8_t amoPathTab[FI_DATATYPE_LAST][FI_ATOMIC_OP_LAST][2];
+static enum fi_datatype amoCasType[FI_DATATYPE_LAST];
+static chpl_bool amoAnyPathAm;  // at least one type is done by AM
+
+//
+// The only 128-bit AMO is compare-and-swap.  Libfabric has had a
+// 128-bit datatype since 1.18; with an older one we use a placeholder
+// type that amoPath() always sends to the CPU.
+//
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+#if FI_VERSION_GE(FI_VERSION(FI_MAJOR_VERSION, FI_MINOR_VERSION), \
+                  FI_VERSION(1, 18))
+#define OFI_HAVE_UINT128
+#define OFI_UINT128 FI_UINT128
+#else
+#define OFI_UINT128 FI_DATATYPE_LAST
+#endif
+#endif
+
+//
+// Strided PUTs and GETs.  Rather than doing the contiguous chunks of a
+// strided transfer one at a time, we gather as many as MAX_CHAINED_
+// STRD_LEN of them and initiate them together as a chained vector
+// transfer, waiting only once per batch.  Chunks that can't be done
+// directly to or from the user's memory go one at a time as before.
+//
+#define MAX_CHAINED_STRD_LEN MAX_TXNS_IN_FLIGHT
+
+static chpl_bool strdVectored = true;
+
 // Per task information about non-fetching AMO buffers
 typedef struct {
   chpl_bool          new;
@@ -751,6 +1048,8 @@ typedef struct {
 typedef struct {
   chpl_bool     new;
   int           vi;
+  size_t        bytes;                  // (aggregation) total buffered
+  double        firstTime;              // (aggregation) when vi became 1
   void*         tgt_addr_v[MAX_CHAINED_PUT_LEN];
   c_nodeid_t    locale_v[MAX_CHAINED_PUT_LEN];
   void*         src_addr_v[MAX_CHAINED_PUT_LEN];
@@ -761,7 +1060,8 @@ typedef struct {
   struct bitmap_t nodeBitmap;
 } put_buff_task_info_t;
 
-// Acquire a task local buffer, initializing if needed
+// Acquire a task local buffer, initializing if needed.  These live in
+// the task arena, so they are released in bulk when the task ends.
 static inline
 void* task_local_buff_acquire(enum BuffType t, size_t extra_size) {
   chpl_comm_taskPrvData_t* prvData = get_comm_taskPrvdata();
@@ -771,8 +1071,8 @@ void* task_local_buff_acquire(enum BuffType t, size_t extra_size) {
   if (t == TLS_NAME) {                                                        \
     TYPE* info = prvData->TLS_NAME;                                           \
     if (info == NULL) {                                                       \
-      prvData->TLS_NAME = chpl_mem_alloc(sizeof(TYPE) + extra_size,           \
-                                         CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0); \
+      prvData->TLS_NAME = chpl_task_arenaAlloc(sizeof(TYPE) + extra_size,     \
+                                               0, 0);                         \
       info = prvData->TLS_NAME;                                               \
       info->new = true;                                                       \
       info->vi = 0;                                                           \
@@ -783,12 +1083,15 @@ void* task_local_buff_acquire(enum BuffType t, size_t extra_size) {
   DEFINE_INIT(amo_nf_buff_task_info_t, amo_nf_buff);
   DEFINE_INIT(get_buff_task_info_t, get_buff);
   DEFINE_INIT(put_buff_task_info_t, put_buff);
+  DEFINE_INIT(put_buff_task_info_t, agg_put_buff);
+  DEFINE_INIT(amo_nf_buff_task_info_t, agg_amo_buff);
 
 #undef DEFINE_INIT
   return NULL;
 }
 
 static void amo_nf_buff_task_info_flush(amo_nf_buff_task_info_t* info);
+static void agg_amo_buff_task_info_flush(amo_nf_buff_task_info_t* info);
 static void get_buff_task_info_flush(get_buff_task_info_t* info);
 static void put_buff_task_info_flush(put_buff_task_info_t* info);
 
@@ -810,11 +1113,15 @@ void task_local_buff_flush(enum BuffType t) {
                amo_nf_buff_task_info_flush);
   DEFINE_FLUSH(get_buff_task_info_t, get_buff, get_buff_task_info_flush);
   DEFINE_FLUSH(put_buff_task_info_t, put_buff, put_buff_task_info_flush);
+  DEFINE_FLUSH(put_buff_task_info_t, agg_put_buff, put_buff_task_info_flush);
+  DEFINE_FLUSH(amo_nf_buff_task_info_t, agg_amo_buff,
+               agg_amo_buff_task_info_flush);
 
 #undef DEFINE_FLUSH
 }
 
-// Flush and destroy one or more task local buffers
+// Flush one or more task local buffers at a fence or task end.  The
+// buffers themselves stay around for reuse until the task arena goes.
 static inline
 void task_local_buff_end(enum BuffType t) {
   chpl_comm_taskPrvData_t* prvData = get_comm_taskPrvdata();
@@ -825,8 +1132,6 @@ void task_local_buff_end(enum BuffType t) {
     TYPE* info = prvData->TLS_NAME;                                           \
     if (info != NULL && info->vi > 0) {                                       \
       FLUSH_NAME(info);                                                       \
-      chpl_mem_free(info, 0, 0);                                              \
-      prvData->TLS_NAME = NULL;                                               \
     }                                                                         \
   }
 
@@ -834,6 +1139,9 @@ void task_local_buff_end(enum BuffType t) {
              amo_nf_buff_task_info_flush);
   DEFINE_END(get_buff_task_info_t, get_buff, get_buff_task_info_flush);
   DEFINE_END(put_buff_task_info_t, put_buff, put_buff_task_info_flush);
+  DEFINE_END(put_buff_task_info_t, agg_put_buff, put_buff_task_info_flush);
+  DEFINE_END(amo_nf_buff_task_info_t, agg_amo_buff,
+             agg_amo_buff_task_info_flush);
 
 #undef END
 }
@@ -854,7 +1162,9 @@ static void init_ofiEpNumCtxs(void);
 static void init_ofiEpTxCtx(int, chpl_bool,
                             struct fi_cq_attr*, struct fi_cntr_attr*);
 static void init_ofiExchangeAvInfo(void);
+static void init_ofiCma(void);
 static void init_ofiForMem(void);
+static void init_ofiRails(void);
 static void init_ofiForRma(void);
 static void init_ofiForAms(void);
 
@@ -890,7 +1200,71 @@ void chpl_comm_init(int *argc_p, char ***argv_p) {
     }
   }
 
+  aggPutsEnabled = chpl_env_rt_get_bool("COMM_OFI_AGGREGATE_PUTS", false);
+  aggPutsMaxBytes = chpl_env_rt_get_size("COMM_OFI_AGGREGATE_BYTES",
+                                         aggPutsMaxBytes);
+  aggPutsMaxAge = 1e-6 * chpl_env_rt_get_int("COMM_OFI_AGGREGATE_USECS",
+                                             (int64_t) (aggPutsMaxAge * 1e6));
+
+  aggAmosEnabled = chpl_env_rt_get_bool("COMM_OFI_AGGREGATE_AMOS", false);
+
+  strdVectored = chpl_env_rt_get_bool("COMM_OFI_STRD_VECTORED", true);
+
+  txnWaitSpins = chpl_env_rt_get_int("COMM_OFI_WAIT_SPINS", txnWaitSpins);
+
+  lazyAvInsert = chpl_env_rt_get_bool("COMM_OFI_LAZY_AV", false);
+
+  amBatchEnabled = chpl_env_rt_get_bool("COMM_OFI_AM_BATCH", false);
+  amBatchAmos = chpl_env_rt_get_bool("COMM_OFI_AM_BATCH_AMOS", amBatchAmos);
+  amBatchMaxBytes = chpl_env_rt_get_size("COMM_OFI_AM_BATCH_BYTES",
+                                         amBatchMaxBytes);
+  amBatchMaxAge = 1e-6 * chpl_env_rt_get_int("COMM_OFI_AM_BATCH_USECS",
+                                             (int64_t) (amBatchMaxAge * 1e6));
+
+  //
+  // Barrier algorithm: "tree" (the default), "dissemination", or
+  // "fi_barrier".  We don't join libfabric collectives (that needs an
+  // EQ on every tx endpoint and an AV set), so for now "fi_barrier"
+  // gets the dissemination barrier, which has the same round count as
+  // the usual provider implementations.
+  //
+  {
+    const char* s = chpl_env_rt_get("COMM_OFI_BARRIER", "tree");
+    if (strcmp(s, "tree") == 0) {
+      barAlg = bar_algTree;
+    } else if (strcmp(s, "dissemination") == 0) {
+      barAlg = bar_algDissemination;
+    } else if (strcmp(s, "fi_barrier") == 0) {
+      if (chpl_nodeID == 0) {
+        chpl_warning("CHPL_RT_COMM_OFI_BARRIER=fi_barrier is not "
+                     "supported yet, using \"dissemination\"", 0, 0);
+      }
+      barAlg = bar_algDissemination;
+    } else {
+      if (chpl_nodeID == 0) {
+        char msg[100];
+        (void) snprintf(msg, sizeof(msg),
+                        "unknown CHPL_RT_COMM_OFI_BARRIER \"%s\", "
+                        "using \"tree\"", s);
+        chpl_warning(msg, 0, 0);
+      }
+      barAlg = bar_algTree;
+    }
+  }
+
   pthread_that_inited = pthread_self();
+
+  //
+  // Get the fixed heap now, if we'll have one, and start prefaulting
+  // it if asked to, so that overlaps memory and tasking init.  We wait
+  // for that in init_ofiForMem(), before registering it.
+  //
+  {
+    void* start;
+    size_t size;
+    chpl_comm_impl_regMemHeapInfo(&start, &size);
+    chpl_comm_prefault_heap_start(start, size);
+  }
 }
 
 
@@ -933,7 +1307,9 @@ void init_ofi(void) {
   init_ofiDoProviderChecks();
   init_ofiEp();
   init_ofiExchangeAvInfo();
+  init_ofiCma();
   init_ofiForMem();
+  init_ofiRails();
   init_ofiForRma();
   init_ofiForAms();
 
@@ -945,9 +1321,11 @@ void init_ofi(void) {
                               sizeof(orderDummyMap[0]));
 
   DBG_PRINTF(DBG_CFG,
-             "AM config: recv buf size %zd MiB, %s, responses use %s",
-             ofi_iov_reqs[ofi_msg_i].iov_len / (1L << 20),
-             (ofi_amhPollSet == NULL) ? "explicit polling" : "poll+wait sets",
+             "AM config: %d handler%s, recv buf size %zd MiB, %s, "
+             "responses use %s",
+             numAmHandlers, (numAmHandlers == 1) ? "" : "s",
+             amhTab[0].iovReqs[0].iov_len / (1L << 20),
+             (amhTab[0].pollSet == NULL) ? "explicit polling" : "poll+wait sets",
              (tciTab[tciTabLen - 1].txCQ != NULL) ? "CQ" : "counter");
   if (useScalableTxEp) {
     DBG_PRINTF(DBG_CFG,
@@ -1210,6 +1588,15 @@ void init_ofiFabricDomain(void) {
       && (prov_name == NULL || isInProvName("gni", prov_name))) {
     hints->caps |= FI_ATOMIC;
   }
+#ifdef HAS_GPU_LOCALE
+  //
+  // Asking for FI_HMEM rules out providers that can't register GPU
+  // memory, so only do it on request.
+  //
+  if (chpl_env_rt_get_bool("COMM_OFI_HMEM", false)) {
+    hints->caps |= FI_HMEM;
+  }
+#endif
   hints->tx_attr->op_flags = FI_COMPLETION;
   hints->tx_attr->msg_order = FI_ORDER_SAS;
   hints->rx_attr->msg_order = hints->tx_attr->msg_order;
@@ -1506,24 +1893,64 @@ void init_ofiEp(void) {
   // seems to work properly during execution, we haven't found a way to
   // avoid getting -FI_EBUSY when we try to close it.
   //
+  // Each AM handler gets its own poll and wait sets, so that it only
+  // wakes up for its own work.  If the provider can give the first one
+  // these it should be able to give them all, so we only allow for
+  // failure there.
+  //
+  // The user can ask for more than one AM handler, which helps when a
+  // lot of inbound on-stmts and AMOs keep a single one busy.  Each
+  // handler has its own receive endpoint, and each initiator sends to
+  // just one of the handlers on a target node, based on its node ID.
+  // All nodes must use the same number.
+  //
+  numAmHandlers = chpl_env_rt_get_int("COMM_OFI_NUM_AM_HANDLERS",
+                                      numAmHandlers);
+  if (numAmHandlers < 1) {
+    chpl_warning("CHPL_RT_COMM_OFI_NUM_AM_HANDLERS < 1, using 1", 0, 0);
+    numAmHandlers = 1;
+  }
+  if (numAmHandlers > chpl_numNodes) {
+    numAmHandlers = chpl_numNodes; // don't need more than # of initiators
+  }
+  rxAddrsPerNode = numAmHandlers + 1;
+  rxAmHandlerIdx = chpl_nodeID % numAmHandlers;
+
+  CHPL_CALLOC(amhTab, numAmHandlers);
+
   if (!providerInUse(provType_efa)
       && !providerInUse(provType_gni)) {
-    int ret;
-    struct fi_poll_attr pollSetAttr = (struct fi_poll_attr)
-                                      { .flags = 0, };
-    OFI_CHK_2(fi_poll_open(ofi_domain, &pollSetAttr, &ofi_amhPollSet),
-              ret, -FI_ENOSYS);
-    if (ret == FI_SUCCESS) {
-      struct fi_wait_attr waitSetAttr = (struct fi_wait_attr)
-                                        { .wait_obj = FI_WAIT_UNSPEC, };
-      OFI_CHK_2(fi_wait_open(ofi_fabric, &waitSetAttr, &ofi_amhWaitSet),
-                ret, -FI_ENOSYS);
-      if (ret != FI_SUCCESS) {
-        ofi_amhPollSet = NULL;
-        ofi_amhWaitSet = NULL;
+    for (int i = 0; i < numAmHandlers; i++) {
+      struct perAmHandlerInfo_t* amh = &amhTab[i];
+      int ret;
+      struct fi_poll_attr pollSetAttr = (struct fi_poll_attr)
+                                        { .flags = 0, };
+      if (i == 0) {
+        OFI_CHK_2(fi_poll_open(ofi_domain, &pollSetAttr, &amh->pollSet),
+                  ret, -FI_ENOSYS);
+      } else {
+        OFI_CHK(fi_poll_open(ofi_domain, &pollSetAttr, &amh->pollSet));
+        ret = FI_SUCCESS;
+      }
+      if (ret == FI_SUCCESS) {
+        struct fi_wait_attr waitSetAttr = (struct fi_wait_attr)
+                                          { .wait_obj = FI_WAIT_UNSPEC, };
+        if (i == 0) {
+          OFI_CHK_2(fi_wait_open(ofi_fabric, &waitSetAttr, &amh->waitSet),
+                    ret, -FI_ENOSYS);
+        } else {
+          OFI_CHK(fi_wait_open(ofi_fabric, &waitSetAttr, &amh->waitSet));
+        }
+        if (ret != FI_SUCCESS) {
+          amh->pollSet = NULL;
+          amh->waitSet = NULL;
+        }
+      } else {
+        amh->pollSet = NULL;
+      }
+      if (amh->pollSet == NULL) {
+        break;
       }
-    } else {
-      ofi_amhPollSet = NULL;
     }
   }
 
@@ -1552,7 +1979,7 @@ void init_ofiEp(void) {
   //
   struct fi_av_attr avAttr = (struct fi_av_attr)
                              { .type = FI_AV_TABLE,
-                               .count = chpl_numNodes * 2 /* AM, RMA+AMO */,
+                               .count = chpl_numNodes * rxAddrsPerNode,
                                .name = NULL,
                                .rx_ctx_bits = 0, };
   if (provCtl_sizeAvsByNumEps) {
@@ -1590,34 +2017,50 @@ void init_ofiEp(void) {
                .size = 100 + MAX_TXNS_IN_FLIGHT,
                .wait_obj = FI_WAIT_NONE, };
     txCQLen = cqAttr.size;
+
+    //
+    // A completion poll usually finds only a few events, and with the
+    // ofi_rxm-based providers (tcp, verbs) every entry we offer to
+    // fi_cq_read() costs something even when it isn't filled.  So read
+    // in small batches by default there, and allow overriding that.
+    //
+    txCQReadCount = providerInUse(provType_rxm) ? 16 : txCQLen;
+    txCQReadCount = chpl_env_rt_get_size("COMM_OFI_CQ_READ_COUNT",
+                                         txCQReadCount);
+    if (txCQReadCount < 1) {
+      txCQReadCount = 1;
+    } else if (txCQReadCount > txCQLen) {
+      txCQReadCount = txCQLen;
+    }
+
     for (int i = 0; i < numWorkerTxCtxs; i++) {
       init_ofiEpTxCtx(i, false /*isAMHandler*/, &cqAttr, NULL);
     }
+    tciFreeListInit(numWorkerTxCtxs);
   }
 
   //
   // TX contexts for the AM handler(s) can just use counters, if the
   // provider supports them.  Otherwise, they have to use CQs also.
   //
-  const enum fi_wait_obj waitObj = (ofi_amhWaitSet == NULL)
+  const enum fi_wait_obj waitObj = (amhTab[0].waitSet == NULL)
                                    ? FI_WAIT_NONE
                                    : FI_WAIT_SET;
-  if (true /*ofi_info->domain_attr->cntr_cnt == 0*/) { // disable tx counters
-    cqAttr = (struct fi_cq_attr)
-             { .format = FI_CQ_FORMAT_MSG,
-               .size = 100,
-               .wait_obj = waitObj,
-               .wait_cond = FI_CQ_COND_NONE,
-               .wait_set = ofi_amhWaitSet, };
-    for (int i = numWorkerTxCtxs; i < tciTabLen; i++) {
-      init_ofiEpTxCtx(i, true /*isAMHandler*/, &cqAttr, NULL);
-    }
-  } else {
-    cntrAttr = (struct fi_cntr_attr)
-               { .events = FI_CNTR_EVENTS_COMP,
+  for (int i = numWorkerTxCtxs; i < tciTabLen; i++) {
+    struct fid_wait* waitSet = amhTab[i - numWorkerTxCtxs].waitSet;
+    if (true /*ofi_info->domain_attr->cntr_cnt == 0*/) { // disable tx cntrs
+      cqAttr = (struct fi_cq_attr)
+               { .format = FI_CQ_FORMAT_MSG,
+                 .size = 100,
                  .wait_obj = waitObj,
-                 .wait_set = ofi_amhWaitSet, };
-    for (int i = numWorkerTxCtxs; i < tciTabLen; i++) {
+                 .wait_cond = FI_CQ_COND_NONE,
+                 .wait_set = waitSet, };
+      init_ofiEpTxCtx(i, true /*isAMHandler*/, &cqAttr, NULL);
+    } else {
+      cntrAttr = (struct fi_cntr_attr)
+                 { .events = FI_CNTR_EVENTS_COMP,
+                   .wait_obj = waitObj,
+                   .wait_set = waitSet, };
       init_ofiEpTxCtx(i, true /*isAMHandler*/, NULL, &cntrAttr);
     }
   }
@@ -1626,24 +2069,35 @@ void init_ofiEp(void) {
   // Create receive contexts.
   //
   // For the CQ length, allow for an appreciable proportion of the job
-  // to send requests to us at once.
+  // to send requests to us at once.  Each AM handler only hears from
+  // its share of the job.
   //
+  for (int i = 0; i < numAmHandlers; i++) {
+    struct perAmHandlerInfo_t* amh = &amhTab[i];
+    cqAttr = (struct fi_cq_attr)
+             { .size = (chpl_numNodes + numAmHandlers - 1) / numAmHandlers
+                       * numWorkerTxCtxs,
+               .format = FI_CQ_FORMAT_DATA,
+               .wait_obj = waitObj,
+               .wait_cond = FI_CQ_COND_NONE,
+               .wait_set = amh->waitSet, };
+    OFI_CHK(fi_endpoint(ofi_domain, ofi_info, &amh->rxEp, NULL));
+    OFI_CHK(fi_ep_bind(amh->rxEp, &ofi_av->fid, 0));
+    OFI_CHK(fi_cq_open(ofi_domain, &cqAttr, &amh->rxCQ, &amh->rxCQ));
+    OFI_CHK(fi_ep_bind(amh->rxEp, &amh->rxCQ->fid, FI_TRANSMIT | FI_RECV));
+    OFI_CHK(fi_enable(amh->rxEp));
+  }
+
   cqAttr = (struct fi_cq_attr)
            { .size = chpl_numNodes * numWorkerTxCtxs,
              .format = FI_CQ_FORMAT_DATA,
              .wait_obj = waitObj,
              .wait_cond = FI_CQ_COND_NONE,
-             .wait_set = ofi_amhWaitSet, };
+             .wait_set = amhTab[0].waitSet, };
   cntrAttr = (struct fi_cntr_attr)
              { .events = FI_CNTR_EVENTS_COMP,
                .wait_obj = waitObj,
-               .wait_set = ofi_amhWaitSet, };
-
-  OFI_CHK(fi_endpoint(ofi_domain, ofi_info, &ofi_rxEp, NULL));
-  OFI_CHK(fi_ep_bind(ofi_rxEp, &ofi_av->fid, 0));
-  OFI_CHK(fi_cq_open(ofi_domain, &cqAttr, &ofi_rxCQ, &ofi_rxCQ));
-  OFI_CHK(fi_ep_bind(ofi_rxEp, &ofi_rxCQ->fid, FI_TRANSMIT | FI_RECV));
-  OFI_CHK(fi_enable(ofi_rxEp));
+               .wait_set = amhTab[0].waitSet, };
 
   OFI_CHK(fi_endpoint(ofi_domain, ofi_info, &ofi_rxEpRma, NULL));
   OFI_CHK(fi_ep_bind(ofi_rxEpRma, &ofi_av->fid, 0));
@@ -1663,21 +2117,27 @@ void init_ofiEp(void) {
 
   //
   // If we're using poll and wait sets, put all the progress-related
-  // CQs and/or counters in the poll set.
-  //
-  if (ofi_amhPollSet != NULL) {
-    OFI_CHK(fi_poll_add(ofi_amhPollSet, &ofi_rxCQ->fid, 0));
-    OFI_CHK(fi_poll_add(ofi_amhPollSet, ofi_rxCmplFidRma, 0));
-    OFI_CHK(fi_poll_add(ofi_amhPollSet, tciTab[tciTabLen - 1].txCmplFid, 0));
-    pollSetSize = 3;
+  // CQs and/or counters in the poll sets.  Only the first AM handler
+  // watches the RMA endpoint.
+  //
+  if (amhTab[0].pollSet != NULL) {
+    for (int i = 0; i < numAmHandlers; i++) {
+      struct perAmHandlerInfo_t* amh = &amhTab[i];
+      OFI_CHK(fi_poll_add(amh->pollSet, &amh->rxCQ->fid, 0));
+      OFI_CHK(fi_poll_add(amh->pollSet,
+                          tciTab[numWorkerTxCtxs + i].txCmplFid, 0));
+      amh->pollSetSize = 2;
+      if (i == 0) {
+        OFI_CHK(fi_poll_add(amh->pollSet, ofi_rxCmplFidRma, 0));
+        amh->pollSetSize++;
+      }
+    }
   }
 }
 
 
 static
 void init_ofiEpNumCtxs(void) {
-  CHK_TRUE(numAmHandlers == 1); // force reviewing this if #AM handlers changes
-
   //
   // Note for future maintainers: if interoperability between Chapel
   // and other languages someday results in non-tasking layer threads
@@ -1764,6 +2224,8 @@ void init_ofiEpTxCtx(int i, chpl_bool isAMHandler,
   struct perTxCtxInfo_t* tcip = &tciTab[i];
   atomic_init_bool(&tcip->allocated, false);
   tcip->bound = false;
+  atomic_init_bool(&tcip->onFreeList, false);
+  atomic_init_uint_least32_t(&tcip->nextFree, 0);
 
   if (useScalableTxEp) {
     OFI_CHK(fi_tx_context(ofi_txEpScal, i, NULL, &tcip->txCtx, NULL));
@@ -1813,9 +2275,15 @@ void init_ofiExchangeAvInfo(void) {
     size_t len = 0;
     size_t lenRma = 0;
 
-    OFI_CHK_1(fi_getname(&ofi_rxEp->fid, NULL, &len), -FI_ETOOSMALL);
+    OFI_CHK_1(fi_getname(&amhTab[0].rxEp->fid, NULL, &len), -FI_ETOOSMALL);
     OFI_CHK_1(fi_getname(&ofi_rxEpRma->fid, NULL, &lenRma), -FI_ETOOSMALL);
     CHK_TRUE(len == lenRma);
+    for (int i = 1; i < numAmHandlers; i++) {
+      size_t lenAm = 0;
+      OFI_CHK_1(fi_getname(&amhTab[i].rxEp->fid, NULL, &lenAm),
+                -FI_ETOOSMALL);
+      CHK_TRUE(len == lenAm);
+    }
 
     size_t* lens;
     CHPL_CALLOC(lens, chpl_numNodes);
@@ -1831,11 +2299,16 @@ void init_ofiExchangeAvInfo(void) {
   char* addrs;
   size_t my_addr_len = 0;
 
-  OFI_CHK_1(fi_getname(&ofi_rxEp->fid, NULL, &my_addr_len), -FI_ETOOSMALL);
-  CHPL_CALLOC_SZ(my_addr, 2 * my_addr_len, 1);
-  OFI_CHK(fi_getname(&ofi_rxEp->fid, my_addr, &my_addr_len));
-  OFI_CHK(fi_getname(&ofi_rxEpRma->fid, my_addr + my_addr_len, &my_addr_len));
-  CHPL_CALLOC_SZ(addrs, chpl_numNodes, 2 * my_addr_len);
+  OFI_CHK_1(fi_getname(&amhTab[0].rxEp->fid, NULL, &my_addr_len),
+            -FI_ETOOSMALL);
+  CHPL_CALLOC_SZ(my_addr, rxAddrsPerNode * my_addr_len, 1);
+  for (int i = 0; i < numAmHandlers; i++) {
+    OFI_CHK(fi_getname(&amhTab[i].rxEp->fid, my_addr + i * my_addr_len,
+                       &my_addr_len));
+  }
+  char* my_addrRma = my_addr + numAmHandlers * my_addr_len;
+  OFI_CHK(fi_getname(&ofi_rxEpRma->fid, my_addrRma, &my_addr_len));
+  CHPL_CALLOC_SZ(addrs, chpl_numNodes, rxAddrsPerNode * my_addr_len);
   if (DBG_TEST_MASK(DBG_CFG_AV)) {
     char nameBuf[128];
     size_t nameLen;
@@ -1844,14 +2317,14 @@ void init_ofiExchangeAvInfo(void) {
     size_t nameLen2;
     nameLen2 = sizeof(nameBuf2);
     (void) fi_av_straddr(ofi_av, my_addr, nameBuf, &nameLen);
-    (void) fi_av_straddr(ofi_av, my_addr + my_addr_len, nameBuf2, &nameLen2);
+    (void) fi_av_straddr(ofi_av, my_addrRma, nameBuf2, &nameLen2);
     DBG_PRINTF(DBG_CFG_AV, "my_addrs: %.*s%s, %.*s%s",
                (int) nameLen, nameBuf,
                (nameLen <= sizeof(nameBuf)) ? "" : "[...]",
                (int) nameLen2, nameBuf2,
                (nameLen2 <= sizeof(nameBuf2)) ? "" : "[...]");
   }
-  chpl_comm_ofi_oob_allgather(my_addr, addrs, 2 * my_addr_len);
+  chpl_comm_ofi_oob_allgather(my_addr, addrs, rxAddrsPerNode * my_addr_len);
 
   //
   // Insert the addresses into the address vector and build up a vector
@@ -1863,12 +2336,120 @@ void init_ofiExchangeAvInfo(void) {
   // Only when the provider cannot support scalable EPs and we have
   // multiple actual endpoints are the AVs individualized to those.
   //
-  CHPL_CALLOC(ofi_rxAddrs, 2 * chpl_numNodes);
-  CHK_TRUE(fi_av_insert(ofi_av, addrs, 2 * chpl_numNodes, ofi_rxAddrs, 0, NULL)
-           == 2 * chpl_numNodes);
+  const size_t numAddrs = rxAddrsPerNode * chpl_numNodes;
+  CHPL_CALLOC(ofi_rxAddrs, numAddrs);
+
+  if (lazyAvInsert) {
+    //
+    // Keep the raw addresses and insert each node's when we first need
+    // them.  Start with our own, which we're sure to use.
+    //
+    for (size_t i = 0; i < numAddrs; i++) {
+      ofi_rxAddrs[i] = FI_ADDR_NOTAVAIL;
+    }
+    CHPL_CALLOC(rxAddrsInAv, chpl_numNodes);
+    for (int i = 0; i < chpl_numNodes; i++) {
+      atomic_init_bool(&rxAddrsInAv[i], false);
+    }
+    rxAddrNames = addrs;
+    rxAddrNamesLen = rxAddrsPerNode * my_addr_len;
+    rxAddrsInsert(chpl_nodeID);
+  } else {
+    CHK_TRUE(fi_av_insert(ofi_av, addrs, numAddrs, ofi_rxAddrs, 0, NULL)
+             == numAddrs);
+    CHPL_FREE(addrs);
+  }
 
   CHPL_FREE(my_addr);
-  CHPL_FREE(addrs);
+}
+
+
+static
+void init_ofiCma(void) {
+  if (!chpl_env_rt_get_bool("COMM_OFI_CMA", false)) {
+    return;
+  }
+
+#ifdef __linux__
+  //
+  // Find the nodes on our host by name, then make sure we can actually
+  // read each one's memory, by reading a value it has set to something
+  // only it would have.  That fails if the kernel doesn't let us, or
+  // if the pid we have belongs to some other process, as it would if
+  // the peer is in another pid namespace.
+  //
+  static volatile uint64_t cmaProbe;
+  const uint64_t cmaProbeMagic = 0x636d6170726f6265; // "cmaprobe"
+
+  struct cmaNodeInfo {
+    char host[64];
+    pid_t pid;
+    volatile uint64_t* probe;
+  };
+
+  struct cmaNodeInfo my;
+  memset(&my, 0, sizeof(my));
+  (void) gethostname(my.host, sizeof(my.host) - 1);
+  my.pid = getpid();
+  my.probe = &cmaProbe;
+  cmaProbe = cmaProbeMagic ^ (uint64_t) my.pid;
+
+  struct cmaNodeInfo* all;
+  CHPL_CALLOC(all, chpl_numNodes);
+  chpl_comm_ofi_oob_allgather(&my, all, sizeof(my));
+
+  int numReachable = 0;
+  CHPL_CALLOC(cmaPids, chpl_numNodes);
+  for (int i = 0; i < chpl_numNodes; i++) {
+    if (i == chpl_nodeID || strcmp(all[i].host, my.host) != 0) {
+      continue;
+    }
+
+    uint64_t val = 0;
+    struct iovec liov = { .iov_base = &val, .iov_len = sizeof(val), };
+    struct iovec riov = { .iov_base = (void*) all[i].probe,
+                          .iov_len = sizeof(val), };
+    if (process_vm_readv(all[i].pid, &liov, 1, &riov, 1, 0) == sizeof(val)
+        && val == (cmaProbeMagic ^ (uint64_t) all[i].pid)) {
+      cmaPids[i] = all[i].pid;
+      numReachable++;
+    } else {
+      DBG_PRINTF(DBG_CFG, "CMA: cannot reach co-located node %d: %s",
+                 i, (val == 0) ? strerror(errno) : "wrong process");
+    }
+  }
+
+  CHPL_FREE(all);
+
+  DBG_PRINTF(DBG_CFG, "CMA: %d co-located node%s reachable",
+             numReachable, (numReachable == 1) ? "" : "s");
+
+  if (numReachable == 0) {
+    CHPL_FREE(cmaPids);
+    cmaPids = NULL;
+  }
+#endif
+}
+
+
+static
+void rxAddrsInsert(c_nodeid_t node) {
+  //
+  // Insert a node's endpoint addresses into the AV, the first time
+  // anyone needs them.  The AV was opened with room for everyone, so
+  // the provider doesn't have to grow it under other threads' feet.
+  //
+  PTHREAD_CHK(pthread_mutex_lock(&rxAddrsLock));
+  if (!atomic_load_explicit_bool(&rxAddrsInAv[node], memory_order_relaxed)) {
+    DBG_PRINTF(DBG_CFG_AV, "lazy AV insert: node %d", (int) node);
+    CHK_TRUE(fi_av_insert(ofi_av, rxAddrNames + node * rxAddrNamesLen,
+                          rxAddrsPerNode, &ofi_rxAddrs[rxAddrsPerNode * node],
+                          0, NULL)
+             == rxAddrsPerNode);
+    atomic_store_explicit_bool(&rxAddrsInAv[node], true,
+                               memory_order_release);
+  }
+  PTHREAD_CHK(pthread_mutex_unlock(&rxAddrsLock));
 }
 
 
@@ -1877,6 +2458,7 @@ void init_ofiForMem(void) {
   void* fixedHeapStart;
   size_t fixedHeapSize;
   chpl_comm_impl_regMemHeapInfo(&fixedHeapStart, &fixedHeapSize);
+  chpl_comm_prefault_heap_wait();
 
   //
   // We default to scalable registration if none of the settings that
@@ -1953,105 +2535,428 @@ void init_ofiForMem(void) {
     CHPL_CALLOC(memTabMap, chpl_numNodes);
     chpl_comm_ofi_oob_allgather(&memTab, memTabMap, sizeof(memTabMap[0]));
   }
-}
 
-
-static int isAtomicValid(enum fi_datatype);
-
-static
-void init_ofiForRma(void) {
   //
-  // We need to make an initial call to isAtomicValid() to let it
-  // initialize its internals.  The datatype here doesn't matter.
+  // With non-scalable registration, set up the cache of registrations
+  // for local buffers that aren't in the regions above.  We don't use
+  // it with FI_MR_ENDPOINT, where each registration would also have to
+  // be bound to an endpoint.
   //
-  (void) isAtomicValid(FI_INT32);
-}
+  mrCacheLen = chpl_env_rt_get_int("COMM_OFI_MR_CACHE_ENTRIES", mrCacheLen);
+  mrCacheMinSize = chpl_env_rt_get_size("COMM_OFI_MR_CACHE_MIN_SIZE",
+                                        mrCacheMinSize);
+  if (scalableMemReg
+      || (ofi_info->domain_attr->mr_mode & FI_MR_ENDPOINT) != 0
+      || mrCacheLen < 0) {
+    mrCacheLen = 0;
+  }
+  if (mrCacheLen > 0) {
+    CHPL_CALLOC(mrCache, mrCacheLen);
+  }
+  DBG_PRINTF(DBG_MR, "MR cache: %d entries, min size %zd",
+             mrCacheLen, mrCacheMinSize);
 
+  hmemEnabled = ((ofi_info->caps & FI_HMEM) != 0);
+  extMemReady = true;
+}
 
-static void init_amHandling(void);
 
+//
+// Find the NUMA domain nearest a NIC, from the sysfs entry for its PCI
+// device.
+//
 static
-void init_ofiForAms(void) {
-  //
-  // Compute the amount of space we should allow for AM landing zones.
-  // We should have enough that we needn't re-post the multi-receive
-  // buffer more often than, say, every tenth of a second.  We know from
-  // the Chapel performance/comm/low-level/many-to-one test that the
-  // comm=ugni AM handler can handle just over 150k "fast" AM requests
-  // in 0.1 sec.  Assuming an average AM request size of 256 bytes, a 40
-  // MiB buffer is enough to give us the desired 0.1 sec lifetime before
-  // it needs renewing.  We actually then split this in half and create
-  // 2 half-sized buffers (see below), so reflect that here also.
-  //
-  const size_t amLZSize = ((size_t) 40 << 20) / 2;
-
-  //
-  // Set the minimum multi-receive buffer space.  Make it big enough to
-  // hold a max-sized request from every potential sender, but no more
-  // than 10% of the buffer size.  Some providers don't have fi_setopt()
-  // for some ep types, so allow this to fail in that case.  But note
-  // that if it does fail and we get overruns we'll die or, worse yet,
-  // silently compute wrong results.
-  //
-  {
-    size_t sz = chpl_numNodes * tciTabLen * sizeof(struct amRequest_execOn_t);
-    if (sz > amLZSize / 10) {
-        sz = amLZSize / 10;
+c_sublocid_t getNicSubloc(struct fi_info* info) {
+#ifdef __linux__
+  if (info->nic == NULL
+      || info->nic->bus_attr == NULL
+      || info->nic->bus_attr->bus_type != FI_BUS_PCI) {
+    return c_sublocid_any;
+  }
+
+  const struct fi_pci_attr* pci = &info->nic->bus_attr->attr.pci;
+  char path[128];
+  int numaNode = -1;
+  FILE* f;
+
+  snprintf(path, sizeof(path),
+           "/sys/bus/pci/devices/%04x:%02x:%02x.%x/numa_node",
+           pci->domain_id, pci->bus_id, pci->device_id, pci->function_id);
+  if ((f = fopen(path, "r")) != NULL) {
+    if (fscanf(f, "%d", &numaNode) != 1) {
+      numaNode = -1;
     }
-    int ret;
-    OFI_CHK_2(fi_setopt(&ofi_rxEp->fid, FI_OPT_ENDPOINT,
-                        FI_OPT_MIN_MULTI_RECV, &sz, sizeof(sz)),
-              ret, -FI_ENOSYS);
-  }
-
-  //
-  // Pre-post multi-receive buffer for inbound AM requests.  In reality
-  // set up two of these and swap back and forth between them, to hedge
-  // against receiving "buffer filled and released" events out of order
-  // with respect to the messages stored within them.
-  //
-  CHPL_CALLOC_SZ(amLZs[0], 1, amLZSize);
-  CHPL_CALLOC_SZ(amLZs[1], 1, amLZSize);
-
-  ofi_iov_reqs[0] = (struct iovec) { .iov_base = amLZs[0],
-                                     .iov_len = amLZSize, };
-  ofi_iov_reqs[1] = (struct iovec) { .iov_base = amLZs[1],
-                                     .iov_len = amLZSize, };
-  ofi_msg_reqs[0] = (struct fi_msg) { .msg_iov = &ofi_iov_reqs[0],
-                                      .desc = NULL,
-                                      .iov_count = 1,
-                                      .addr = FI_ADDR_UNSPEC,
-                                      .context = txnTrkEncodeId(__LINE__),
-                                      .data = 0x0, };
-  ofi_msg_reqs[1] = (struct fi_msg) { .msg_iov = &ofi_iov_reqs[1],
-                                      .desc = NULL,
-                                      .iov_count = 1,
-                                      .addr = FI_ADDR_UNSPEC,
-                                      .context = txnTrkEncodeId(__LINE__),
-                                      .data = 0x0, };
-  ofi_msg_i = 0;
-  OFI_CHK(fi_recvmsg(ofi_rxEp, &ofi_msg_reqs[ofi_msg_i], FI_MULTI_RECV));
-  DBG_PRINTF(DBG_AM_BUF,
-             "pre-post fi_recvmsg(AMLZs %p, len %#zx)",
-             ofi_msg_reqs[ofi_msg_i].msg_iov->iov_base,
-             ofi_msg_reqs[ofi_msg_i].msg_iov->iov_len);
+    fclose(f);
+  }
 
-  init_amHandling();
+  if (numaNode >= 0 && numaNode < chpl_topo_getNumNumaDomains()) {
+    return numaNode;
+  }
+#endif
+  return c_sublocid_any;
 }
 
 
-#if 0
 static
-void init_ofiPerThread(void) {
-}
-#endif
+void init_ofiRail(struct rail_t* rail, int numWorkerTxCtxs) {
+  struct fi_info* info = rail->info;
 
+  OFI_CHK(fi_fabric(info->fabric_attr, &rail->fabric, NULL));
+  OFI_CHK(fi_domain(rail->fabric, info, &rail->domain, NULL));
 
-void chpl_comm_rollcall(void) {
-  DBG_PRINTF(DBG_IFACE_SETUP, "%s()", __func__);
+  struct fi_av_attr avAttr = (struct fi_av_attr)
+                             { .type = FI_AV_TABLE,
+                               .count = chpl_numNodes, };
+  OFI_CHK(fi_av_open(rail->domain, &avAttr, &rail->av, NULL));
 
-  // Initialize diags
-  chpl_comm_diags_init();
+  //
+  // The RMA target endpoint.  Its CQ never gets anything, because no
+  // one asks for remote completions, but some providers insist on it.
+  //
+  struct fi_cq_attr cqAttr = (struct fi_cq_attr)
+                             { .format = FI_CQ_FORMAT_CONTEXT,
+                               .size = 100,
+                               .wait_obj = FI_WAIT_NONE, };
+  OFI_CHK(fi_endpoint(rail->domain, info, &rail->rxEp, NULL));
+  OFI_CHK(fi_ep_bind(rail->rxEp, &rail->av->fid, 0));
+  OFI_CHK(fi_cq_open(rail->domain, &cqAttr, &rail->rxCQ, NULL));
+  OFI_CHK(fi_ep_bind(rail->rxEp, &rail->rxCQ->fid, FI_TRANSMIT | FI_RECV));
+  OFI_CHK(fi_enable(rail->rxEp));
+
+  //
+  // Transmit endpoints.  Any thread can use any of these, so there's
+  // no point in having more than there are worker tx contexts.
+  //
+  rail->numTxCtxs = info->domain_attr->ep_cnt - 1;
+  if (rail->numTxCtxs > numWorkerTxCtxs) {
+    rail->numTxCtxs = numWorkerTxCtxs;
+  }
+  CHK_TRUE(rail->numTxCtxs > 0);
+  CHPL_CALLOC(rail->txCtxs, rail->numTxCtxs);
+  for (int i = 0; i < rail->numTxCtxs; i++) {
+    struct railTxCtx_t* rtcp = &rail->txCtxs[i];
+    atomic_init_bool(&rtcp->busy, false);
+    OFI_CHK(fi_endpoint(rail->domain, info, &rtcp->ep, NULL));
+    OFI_CHK(fi_ep_bind(rtcp->ep, &rail->av->fid, 0));
+    OFI_CHK(fi_cq_open(rail->domain, &cqAttr, &rtcp->cq, NULL));
+    OFI_CHK(fi_ep_bind(rtcp->ep, &rtcp->cq->fid, FI_TRANSMIT | FI_RECV));
+    OFI_CHK(fi_enable(rtcp->ep));
+  }
+
+  //
+  // Register the same memory regions we did on the main domain.
+  //
+  const chpl_bool prov_key =
+    ((info->domain_attr->mr_mode & FI_MR_PROV_KEY) != 0);
+
+  uint64_t bufAcc = FI_RECV | FI_REMOTE_READ | FI_REMOTE_WRITE;
+  if ((info->domain_attr->mr_mode & FI_MR_LOCAL) != 0) {
+    bufAcc |= FI_SEND | FI_READ | FI_WRITE;
+  }
+
+  for (int i = 0; i < numMemRegions; i++) {
+    rail->memTab[i] = memTab[i];
+    OFI_CHK(fi_mr_reg(rail->domain,
+                      memTab[i].addr, memTab[i].size,
+                      bufAcc, (prov_key ? 0 : i), 0, 0, &rail->mrTab[i],
+                      NULL));
+    rail->memTab[i].desc = fi_mr_desc(rail->mrTab[i]);
+    rail->memTab[i].key  = fi_mr_key(rail->mrTab[i]);
+    CHK_TRUE(prov_key || rail->memTab[i].key == i);
+    if ((info->domain_attr->mr_mode & FI_MR_ENDPOINT) != 0) {
+      OFI_CHK(fi_mr_bind(rail->mrTab[i], &rail->rxEp->fid, 0));
+      OFI_CHK(fi_mr_enable(rail->mrTab[i]));
+    }
+  }
+
+  if (!scalableMemReg) {
+    CHPL_CALLOC(rail->memTabMap, chpl_numNodes);
+    chpl_comm_ofi_oob_allgather(&rail->memTab, rail->memTabMap,
+                                sizeof(rail->memTabMap[0]));
+  }
+
+  //
+  // Exchange RMA endpoint addresses.
+  //
+  char* my_addr;
+  char* addrs;
+  size_t my_addr_len = 0;
+
+  OFI_CHK_1(fi_getname(&rail->rxEp->fid, NULL, &my_addr_len),
+            -FI_ETOOSMALL);
+  CHPL_CALLOC_SZ(my_addr, my_addr_len, 1);
+  OFI_CHK(fi_getname(&rail->rxEp->fid, my_addr, &my_addr_len));
+  CHPL_CALLOC_SZ(addrs, chpl_numNodes, my_addr_len);
+  chpl_comm_ofi_oob_allgather(my_addr, addrs, my_addr_len);
+  CHPL_CALLOC(rail->rxAddrs, chpl_numNodes);
+  CHK_TRUE(fi_av_insert(rail->av, addrs, chpl_numNodes, rail->rxAddrs, 0,
+                        NULL)
+           == chpl_numNodes);
+  CHPL_FREE(addrs);
+  CHPL_FREE(my_addr);
+
+  rail->subloc = getNicSubloc(info);
+}
+
+
+static
+void init_ofiRails(void) {
+  numRails = chpl_env_rt_get_int("COMM_OFI_RAILS", 1);
+  if (numRails < 1) {
+    chpl_warning("CHPL_RT_COMM_OFI_RAILS < 1, using 1", 0, 0);
+    numRails = 1;
+  }
+  if (numRails > 16) {
+    numRails = 16;  // more NICs per node than this seems unlikely
+  }
+  if (numRails == 1) {
+    return;
+  }
+
+  railStripeMinSize = chpl_env_rt_get_size("COMM_OFI_RAIL_STRIPE_MIN_SIZE",
+                                           railStripeMinSize);
+  railNearMinSize = chpl_env_rt_get_size("COMM_OFI_RAIL_NEAR_MIN_SIZE",
+                                         railNearMinSize);
+
+  //
+  // Find the other domains our provider offers.  We need the same
+  // capabilities and modes as the main domain, except that since we
+  // only do RMA on the extra rails and wait for everything to complete
+  // anyway, we just need delivery-complete, not any ordering.  We also
+  // require automatic data progress, because no one is going to poll
+  // the rail target endpoints.
+  //
+  const char* noRailsWhy = NULL;
+  struct fi_info* infoList = NULL;
+  struct fi_info* railInfos[numRails];
+  int numFound = 0;
+
+  if (!haveDeliveryComplete) {
+    noRailsWhy = "provider does not do delivery-complete";
+  } else {
+    struct fi_info* hints;
+    CHK_TRUE((hints = fi_allocinfo()) != NULL);
+    hints->caps = ofi_info->caps;
+    hints->mode = ofi_info->mode;
+    hints->addr_format = ofi_info->addr_format;
+    hints->tx_attr->op_flags = FI_DELIVERY_COMPLETE;
+    hints->ep_attr->type = FI_EP_RDM;
+    hints->domain_attr->threading = FI_THREAD_DOMAIN;
+    hints->domain_attr->resource_mgmt = FI_RM_ENABLED;
+    hints->domain_attr->av_type = FI_AV_TABLE;
+    hints->domain_attr->data_progress = FI_PROGRESS_AUTO;
+    hints->domain_attr->mr_mode = ofi_info->domain_attr->mr_mode;
+    hints->fabric_attr->prov_name = strdup(ofi_info->fabric_attr->prov_name);
+
+    int ret;
+    OFI_CHK_2(fi_getinfo(COMM_OFI_FI_VERSION, NULL, NULL, 0, hints,
+                         &infoList),
+              ret, -FI_ENODATA);
+    fi_freeinfo(hints);
+
+    for (struct fi_info* info = (ret == FI_SUCCESS) ? infoList : NULL;
+         info != NULL && numFound < numRails - 1;
+         info = info->next) {
+      if (strcmp(info->fabric_attr->prov_name,
+                 ofi_info->fabric_attr->prov_name) != 0
+          || info->domain_attr->mr_mode != ofi_info->domain_attr->mr_mode
+          || info->ep_attr->max_msg_size < railStripeMinSize / numRails
+          || strcmp(info->domain_attr->name,
+                    ofi_info->domain_attr->name) == 0) {
+        continue;
+      }
+      chpl_bool dup = false;
+      for (int i = 0; i < numFound; i++) {
+        if (strcmp(info->domain_attr->name,
+                   railInfos[i]->domain_attr->name) == 0) {
+          dup = true;
+        }
+      }
+      if (!dup) {
+        railInfos[numFound++] = info;
+      }
+    }
+
+    if (numFound == 0) {
+      noRailsWhy = "no other usable domains";
+    }
+  }
+
+  //
+  // Everyone has to open the same number of rails, because we do the
+  // setup collectively.  Take the smallest number anyone found.
+  //
+  int* allFound;
+  CHPL_CALLOC(allFound, chpl_numNodes);
+  chpl_comm_ofi_oob_allgather(&numFound, allFound, sizeof(numFound));
+  for (int i = 0; i < chpl_numNodes; i++) {
+    if (allFound[i] < numFound) {
+      numFound = allFound[i];
+      if (noRailsWhy == NULL && numFound == 0) {
+        noRailsWhy = "some other node has no other usable domains";
+      }
+    }
+  }
+  CHPL_FREE(allFound);
+
+  if (numFound == 0) {
+    if (chpl_nodeID == 0) {
+      char msg[200];
+      snprintf(msg, sizeof(msg),
+               "CHPL_RT_COMM_OFI_RAILS ignored: %s", noRailsWhy);
+      chpl_warning(msg, 0, 0);
+    }
+    numRails = 1;
+    if (infoList != NULL) {
+      fi_freeinfo(infoList);
+    }
+    return;
+  }
+
+  numRails = numFound + 1;
+  CHPL_CALLOC(railTab, numRails - 1);
+  for (int i = 0; i < numRails - 1; i++) {
+    railTab[i].info = fi_dupinfo(railInfos[i]);
+    init_ofiRail(&railTab[i], tciTabLen - numAmHandlers);
+  }
+  fi_freeinfo(infoList);
+
+  mainRailSubloc = getNicSubloc(ofi_info);
+
+  DBG_PRINTF(DBG_CFG, "rails: %d, main domain %s (subloc %d)",
+             numRails, ofi_info->domain_attr->name, (int) mainRailSubloc);
+  for (int i = 0; i < numRails - 1; i++) {
+    DBG_PRINTF(DBG_CFG, "rail %d: domain %s (subloc %d), %d tx ctxs",
+               i + 1, railTab[i].info->domain_attr->name,
+               (int) railTab[i].subloc, railTab[i].numTxCtxs);
+  }
+}
+
+
+static void init_amoPaths(void);
+
+static
+void init_ofiForRma(void) {
+  init_amoPaths();
+}
+
+
+static void init_amHandling(void);
+
+static
+void init_ofiForAms(void) {
+  //
+  // Compute the amount of space we should allow for AM landing zones.
+  // We should have enough that we needn't re-post the multi-receive
+  // buffer more often than, say, every tenth of a second.  We know from
+  // the Chapel performance/comm/low-level/many-to-one test that the
+  // comm=ugni AM handler can handle just over 150k "fast" AM requests
+  // in 0.1 sec.  Assuming an average AM request size of 256 bytes, a 40
+  // MiB buffer is enough to give us the desired 0.1 sec lifetime before
+  // it needs renewing.  We actually then split this in half and create
+  // 2 half-sized buffers (see below), so reflect that here also.  With
+  // more than one AM handler, each only hears from its share of the
+  // nodes and gets that share of the space.
+  //
+  const size_t amLZSize = ((size_t) 40 << 20) / 2 / numAmHandlers;
+  const int numSendersPerAmh = (chpl_numNodes + numAmHandlers - 1)
+                               / numAmHandlers;
+
+  //
+  // On-stmts with arg bundles larger than a regular AM request but no
+  // more than amExecOnEagerMaxBytes are sent eagerly, with the bundle
+  // in the request, to save the target a round trip to retrieve it.
+  // All nodes must use the same limit, since the receive buffer space
+  // below allows for it.
+  //
+  amExecOnEagerMaxBytes = chpl_env_rt_get_size("COMM_OFI_AM_EAGER_MAX_SIZE",
+                                               amExecOnEagerMaxBytes);
+  if (amExecOnEagerMaxBytes < sizeof(struct amRequest_execOn_t)) {
+    amExecOnEagerMaxBytes = sizeof(struct amRequest_execOn_t);
+  } else if (amExecOnEagerMaxBytes > ofi_info->ep_attr->max_msg_size) {
+    amExecOnEagerMaxBytes = ofi_info->ep_attr->max_msg_size;
+  }
+
+  //
+  // Set the minimum multi-receive buffer space.  Make it big enough to
+  // hold a max-sized request (a largest eager on-stmt) from every
+  // potential sender, but no more
+  // than 10% of the buffer size.  Some providers don't have fi_setopt()
+  // for some ep types, so allow this to fail in that case.  But note
+  // that if it does fail and we get overruns we'll die or, worse yet,
+  // silently compute wrong results.
+  //
+  // AM request batches are injected, so they can be no larger than the
+  // inject size, and every sender might have one of those in flight as
+  // well.
+  //
+  amBatching = amBatchEnabled || (amBatchAmos && amoAnyPathAm);
+  if (amBatching
+      && amBatchMaxBytes > ofi_info->tx_attr->inject_size) {
+    amBatchMaxBytes = ofi_info->tx_attr->inject_size;
+  }
+
+  size_t minMultiRecv = numSendersPerAmh * tciTabLen
+                        * amExecOnEagerMaxBytes;
+  if (amBatching) {
+    minMultiRecv += numSendersPerAmh * amBatchMaxBytes;
+  }
+  if (minMultiRecv > amLZSize / 10) {
+    minMultiRecv = amLZSize / 10;
+  }
+
+  for (int i = 0; i < numAmHandlers; i++) {
+    struct perAmHandlerInfo_t* amh = &amhTab[i];
+
+    {
+      int ret;
+      OFI_CHK_2(fi_setopt(&amh->rxEp->fid, FI_OPT_ENDPOINT,
+                          FI_OPT_MIN_MULTI_RECV,
+                          &minMultiRecv, sizeof(minMultiRecv)),
+                ret, -FI_ENOSYS);
+    }
+
+    //
+    // Pre-post multi-receive buffer for inbound AM requests.  In reality
+    // set up two of these and swap back and forth between them, to hedge
+    // against receiving "buffer filled and released" events out of order
+    // with respect to the messages stored within them.
+    //
+    for (int j = 0; j < 2; j++) {
+      CHPL_CALLOC_SZ(amh->lzs[j], 1, amLZSize);
+      amh->iovReqs[j] = (struct iovec) { .iov_base = amh->lzs[j],
+                                         .iov_len = amLZSize, };
+      amh->msgReqs[j] = (struct fi_msg) { .msg_iov = &amh->iovReqs[j],
+                                          .desc = NULL,
+                                          .iov_count = 1,
+                                          .addr = FI_ADDR_UNSPEC,
+                                          .context = txnTrkEncodeId(__LINE__),
+                                          .data = 0x0, };
+    }
+    amh->msgI = 0;
+    OFI_CHK(fi_recvmsg(amh->rxEp, &amh->msgReqs[amh->msgI], FI_MULTI_RECV));
+    DBG_PRINTF(DBG_AM_BUF,
+               "pre-post fi_recvmsg(AMLZs %p, len %#zx) for AM handler %d",
+               amh->msgReqs[amh->msgI].msg_iov->iov_base,
+               amh->msgReqs[amh->msgI].msg_iov->iov_len, i);
+  }
+
+  init_amHandling();
+}
+
+
+#if 0
+static
+void init_ofiPerThread(void) {
+}
+#endif
+
+
+void chpl_comm_rollcall(void) {
+  DBG_PRINTF(DBG_IFACE_SETUP, "%s()", __func__);
+
+  // Initialize diags
+  chpl_comm_diags_init();
 
   chpl_msg(2, "executing on node %d of %d node(s): %s\n", chpl_nodeID,
            chpl_numNodes, chpl_nodeName());
@@ -2111,9 +3016,20 @@ void init_broadcast_private(void) {
 }
 
 
+static void privBcastSubtree(int, size_t, c_nodeid_t);
+
 void chpl_comm_broadcast_private(int id, size_t size) {
   DBG_PRINTF(DBG_IFACE_SETUP, "%s(%d, %zd)", __func__, id, size);
 
+  //
+  // With more nodes than fit in one level of the tree, send the value
+  // down a tree rooted here rather than doing all the PUTs ourselves.
+  //
+  if (chpl_numNodes > BAR_TREE_NUM_CHILDREN + 1) {
+    privBcastSubtree(id, size, chpl_nodeID);
+    return;
+  }
+
   for (int i = 0; i < chpl_numNodes; i++) {
     if (i != chpl_nodeID) {
       (void) ofi_put(chpl_rt_priv_bcast_tab[id], i,
@@ -2201,23 +3117,83 @@ void fini_ofi(void) {
     OFI_CHK(fi_close(&ofiMrTab[i]->fid));
   }
 
+  for (int i = 0; i < MAX_EXT_MEM_REGIONS; i++) {
+    if (extMemTab[i].mr != NULL) {
+      OFI_CHK(fi_close(&extMemTab[i].mr->fid));
+    }
+  }
+
+  if (mrCache != NULL) {
+    for (int i = 0; i < mrCacheLen; i++) {
+      if (mrCache[i].mr != NULL) {
+        OFI_CHK(fi_close(&mrCache[i].mr->fid));
+      }
+    }
+    CHPL_FREE(mrCache);
+  }
+
   if (memTabMap != NULL) {
     CHPL_FREE(memTabMap);
   }
 
-  CHPL_FREE(amLZs[1]);
-  CHPL_FREE(amLZs[0]);
+  for (int r = 0; r < numRails - 1; r++) {
+    struct rail_t* rail = &railTab[r];
+    for (int i = 0; i < numMemRegions; i++) {
+      OFI_CHK(fi_close(&rail->mrTab[i]->fid));
+    }
+    if (rail->memTabMap != NULL) {
+      CHPL_FREE(rail->memTabMap);
+    }
+    for (int i = 0; i < rail->numTxCtxs; i++) {
+      OFI_CHK(fi_close(&rail->txCtxs[i].ep->fid));
+      OFI_CHK(fi_close(&rail->txCtxs[i].cq->fid));
+      atomic_destroy_bool(&rail->txCtxs[i].busy);
+    }
+    CHPL_FREE(rail->txCtxs);
+    OFI_CHK(fi_close(&rail->rxEp->fid));
+    OFI_CHK(fi_close(&rail->rxCQ->fid));
+    OFI_CHK(fi_close(&rail->av->fid));
+    OFI_CHK(fi_close(&rail->domain->fid));
+    OFI_CHK(fi_close(&rail->fabric->fid));
+    CHPL_FREE(rail->rxAddrs);
+    fi_freeinfo(rail->info);
+  }
+  if (railTab != NULL) {
+    CHPL_FREE(railTab);
+  }
 
   CHPL_FREE(ofi_rxAddrs);
+  if (cmaPids != NULL) {
+    CHPL_FREE(cmaPids);
+  }
+  if (lazyAvInsert) {
+    for (int i = 0; i < chpl_numNodes; i++) {
+      atomic_destroy_bool(&rxAddrsInAv[i]);
+    }
+    CHPL_FREE(rxAddrsInAv);
+    CHPL_FREE(rxAddrNames);
+  }
+
+  const int numWorkerTxCtxs = tciTabLen - numAmHandlers;
+  for (int i = 0; i < numAmHandlers; i++) {
+    struct perAmHandlerInfo_t* amh = &amhTab[i];
+
+    CHPL_FREE(amh->lzs[1]);
+    CHPL_FREE(amh->lzs[0]);
 
-  if (ofi_amhPollSet != NULL) {
-    OFI_CHK(fi_poll_del(ofi_amhPollSet, tciTab[tciTabLen - 1].txCmplFid, 0));
-    OFI_CHK(fi_poll_del(ofi_amhPollSet, ofi_rxCmplFidRma, 0));
-    OFI_CHK(fi_poll_del(ofi_amhPollSet, &ofi_rxCQ->fid, 0));
+    if (amh->pollSet != NULL) {
+      if (i == 0) {
+        OFI_CHK(fi_poll_del(amh->pollSet, ofi_rxCmplFidRma, 0));
+      }
+      OFI_CHK(fi_poll_del(amh->pollSet,
+                          tciTab[numWorkerTxCtxs + i].txCmplFid, 0));
+      OFI_CHK(fi_poll_del(amh->pollSet, &amh->rxCQ->fid, 0));
+    }
+
+    OFI_CHK(fi_close(&amh->rxEp->fid));
+    OFI_CHK(fi_close(&amh->rxCQ->fid));
   }
 
-  OFI_CHK(fi_close(&ofi_rxEp->fid));
-  OFI_CHK(fi_close(&ofi_rxCQ->fid));
   OFI_CHK(fi_close(&ofi_rxEpRma->fid));
   OFI_CHK(fi_close(ofi_rxCmplFidRma));
 
@@ -2232,10 +3208,13 @@ void fini_ofi(void) {
 
   OFI_CHK(fi_close(&ofi_av->fid));
 
-  if (ofi_amhPollSet != NULL) {
-    OFI_CHK(fi_close(&ofi_amhWaitSet->fid));
-    OFI_CHK(fi_close(&ofi_amhPollSet->fid));
+  for (int i = 0; i < numAmHandlers; i++) {
+    if (amhTab[i].pollSet != NULL) {
+      OFI_CHK(fi_close(&amhTab[i].waitSet->fid));
+      OFI_CHK(fi_close(&amhTab[i].pollSet->fid));
+    }
   }
+  CHPL_FREE(amhTab);
 
   OFI_CHK(fi_close(&ofi_domain->fid));
   OFI_CHK(fi_close(&ofi_fabric->fid));
@@ -2452,11 +3431,36 @@ struct memEntry* getMemEntry(memTab_t* tab, void* addr, size_t size) {
 }
 
 
+static
+int extMemGetDesc(void** pDesc, void* addr, size_t size) {
+  char* myAddr = (char*) addr;
+  int found = 0;
+
+  PTHREAD_CHK(pthread_mutex_lock(&mrCacheLock));
+  for (int i = 0; i < MAX_EXT_MEM_REGIONS; i++) {
+    struct extMemEntry* e = &extMemTab[i];
+    if (e->mr != NULL
+        && myAddr >= e->addr && myAddr + size <= e->addr + e->size) {
+      *pDesc = e->desc;
+      found = 1;
+      break;
+    }
+  }
+  PTHREAD_CHK(pthread_mutex_unlock(&mrCacheLock));
+
+  return found;
+}
+
+
 static inline
 int mrGetDesc(void** pDesc, void* addr, size_t size) {
   void* desc;
 
-  if (scalableMemReg) {
+  if (atomic_load_int_least32_t(&numExtMemRegions) > 0
+      && extMemGetDesc(&desc, addr, size)) {
+    DBG_PRINTF(DBG_MR_DESC, "mrGetDesc(%p, %zd): ext desc %p",
+               addr, size, desc);
+  } else if (scalableMemReg) {
     desc = NULL;
   } else {
     struct memEntry* mr;
@@ -2513,6 +3517,214 @@ int mrGetLocalKey(void* addr, size_t size) {
 }
 
 
+//
+// Find or make a local registration covering a buffer that isn't in
+// one of our fixed memory regions, so that large RMA can be done
+// directly from or into it rather than through a bounce buffer.  The
+// entries are kept in LRU order, and an entry is only replaced when no
+// transaction is using it.  The caller must hand back a non-NULL
+// return value with mrCacheRelease() once its transaction has
+// completed.  Registrations are page-aligned, so one entry can serve
+// nearby buffers too.
+//
+// Note that as with the similar caches in MPI implementations, if a
+// cached buffer's pages are unmapped and something else is mapped at
+// the same address, we will still use the stale registration.  In
+// practice the buffers this sees (task stacks, static data, memory
+// from outside the Chapel heap) aren't unmapped while the program is
+// running.  Setting CHPL_RT_COMM_OFI_MR_CACHE_ENTRIES=0 turns the
+// cache off.
+//
+static
+struct mrCacheEntry* mrCacheAcquire(void** pDesc, void* addr, size_t size) {
+  if (mrCacheLen == 0 || size < mrCacheMinSize) {
+    return NULL;
+  }
+
+  char* myAddr = (char*) addr;
+  struct mrCacheEntry* victim = NULL;
+
+  PTHREAD_CHK(pthread_mutex_lock(&mrCacheLock));
+
+  for (int i = 0; i < mrCacheLen; i++) {
+    struct mrCacheEntry* e = &mrCache[i];
+    if (e->mr != NULL
+        && myAddr >= e->addr && myAddr + size <= e->addr + e->size) {
+      e->refs++;
+      e->lastUse = ++mrCacheClock;
+      *pDesc = e->desc;
+      PTHREAD_CHK(pthread_mutex_unlock(&mrCacheLock));
+      chpl_comm_diags_incr(mr_cache_hits);
+      DBG_PRINTF(DBG_MR_DESC, "mrCacheAcquire(%p, %zd): hit [%d]",
+                 addr, size, i);
+      return e;
+    }
+    if (e->refs == 0
+        && (victim == NULL
+            || (victim->mr != NULL
+                && (e->mr == NULL || e->lastUse < victim->lastUse)))) {
+      victim = e;
+    }
+  }
+
+  chpl_comm_diags_incr(mr_cache_misses);
+
+  if (victim == NULL) {
+    PTHREAD_CHK(pthread_mutex_unlock(&mrCacheLock));
+    DBG_PRINTF(DBG_MR_DESC, "mrCacheAcquire(%p, %zd): all busy",
+               addr, size);
+    return NULL;
+  }
+
+  if (victim->mr != NULL) {
+    DBG_PRINTF(DBG_MR, "MR cache evict %p, %#zx",
+               victim->addr, victim->size);
+    OFI_CHK(fi_close(&victim->mr->fid));
+    victim->mr = NULL;
+  }
+
+  const uintptr_t pgSize = chpl_getSysPageSize();
+  char* regAddr = (char*) ((uintptr_t) myAddr & ~(pgSize - 1));
+  size_t regSize = ((((uintptr_t) myAddr + size + pgSize - 1)
+                     & ~(pgSize - 1))
+                    - (uintptr_t) regAddr);
+
+  const chpl_bool prov_key =
+    ((ofi_info->domain_attr->mr_mode & FI_MR_PROV_KEY) != 0);
+  struct fid_mr* mr;
+  int ret = fi_mr_reg(ofi_domain, regAddr, regSize,
+                      FI_SEND | FI_RECV | FI_READ | FI_WRITE,
+                      0, prov_key ? 0 : mrCacheNextKey++, 0, &mr, NULL);
+  if (ret != FI_SUCCESS) {
+    //
+    // Not fatal; the caller will just use a bounce buffer.
+    //
+    PTHREAD_CHK(pthread_mutex_unlock(&mrCacheLock));
+    DBG_PRINTF(DBG_MR, "MR cache fi_mr_reg(%p, %#zx) failed: %s",
+               regAddr, regSize, fi_strerror(-ret));
+    return NULL;
+  }
+
+  DBG_PRINTF(DBG_MR, "MR cache fi_mr_reg(%p, %#zx)", regAddr, regSize);
+  victim->addr = regAddr;
+  victim->size = regSize;
+  victim->mr = mr;
+  victim->desc = fi_mr_desc(mr);
+  victim->refs = 1;
+  victim->lastUse = ++mrCacheClock;
+  *pDesc = victim->desc;
+
+  PTHREAD_CHK(pthread_mutex_unlock(&mrCacheLock));
+  return victim;
+}
+
+
+static inline
+void mrCacheRelease(struct mrCacheEntry* e) {
+  if (e != NULL) {
+    PTHREAD_CHK(pthread_mutex_lock(&mrCacheLock));
+    e->refs--;
+    PTHREAD_CHK(pthread_mutex_unlock(&mrCacheLock));
+  }
+}
+
+
+//
+// Register pinned host or GPU memory for local RMA, so transfers from
+// or into it don't need a bounce buffer.  With scalable registration
+// host memory is already covered, and GPU memory can only be registered
+// when the provider supports FI_HMEM.  Only the local side benefits:
+// the keys aren't shared, so other nodes still reach this memory the
+// usual way.  Failing to register is not an error.
+//
+void chpl_comm_impl_regMemAdd(void* p, size_t size, int gpuDev) {
+  DBG_PRINTF(DBG_IFACE_SETUP, "%s(%p, %zd, %d)", __func__, p, size, gpuDev);
+
+  if (!extMemReady
+      || (gpuDev < 0 && scalableMemReg)
+      || (gpuDev >= 0 && !hmemEnabled)) {
+    return;
+  }
+
+  PTHREAD_CHK(pthread_mutex_lock(&mrCacheLock));
+
+  struct extMemEntry* e = NULL;
+  for (int i = 0; i < MAX_EXT_MEM_REGIONS; i++) {
+    if (extMemTab[i].mr == NULL) {
+      e = &extMemTab[i];
+      break;
+    }
+  }
+
+  if (e != NULL) {
+    const chpl_bool prov_key =
+      ((ofi_info->domain_attr->mr_mode & FI_MR_PROV_KEY) != 0);
+    struct iovec iov = { p, size };
+    struct fi_mr_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.mr_iov = &iov;
+    attr.iov_count = 1;
+    attr.access = FI_SEND | FI_RECV | FI_READ | FI_WRITE;
+    attr.requested_key = prov_key ? 0 : mrCacheNextKey++;
+    if (gpuDev >= 0) {
+      attr.iface = FI_HMEM_CUDA;
+      attr.device.cuda = gpuDev;
+    } else {
+      attr.iface = FI_HMEM_SYSTEM;
+    }
+
+    struct fid_mr* mr;
+    int ret = fi_mr_regattr(ofi_domain, &attr, 0, &mr);
+    if (ret == FI_SUCCESS
+        && (ofi_info->domain_attr->mr_mode & FI_MR_ENDPOINT) != 0) {
+      if ((ret = fi_mr_bind(mr, &ofi_rxEpRma->fid, 0)) == FI_SUCCESS) {
+        ret = fi_mr_enable(mr);
+      }
+      if (ret != FI_SUCCESS) {
+        OFI_CHK(fi_close(&mr->fid));
+      }
+    }
+
+    if (ret == FI_SUCCESS) {
+      e->addr = (char*) p;
+      e->size = size;
+      e->mr = mr;
+      e->desc = fi_mr_desc(mr);
+      (void) atomic_fetch_add_int_least32_t(&numExtMemRegions, 1);
+      DBG_PRINTF(DBG_MR, "ext fi_mr_regattr(%p, %#zx, dev %d)",
+                 p, size, gpuDev);
+    } else {
+      DBG_PRINTF(DBG_MR, "ext fi_mr_regattr(%p, %#zx, dev %d) failed: %s",
+                 p, size, gpuDev, fi_strerror(-ret));
+    }
+  }
+
+  PTHREAD_CHK(pthread_mutex_unlock(&mrCacheLock));
+}
+
+
+void chpl_comm_impl_regMemRemove(void* p) {
+  DBG_PRINTF(DBG_IFACE_SETUP, "%s(%p)", __func__, p);
+
+  if (atomic_load_int_least32_t(&numExtMemRegions) == 0) {
+    return;
+  }
+
+  PTHREAD_CHK(pthread_mutex_lock(&mrCacheLock));
+  for (int i = 0; i < MAX_EXT_MEM_REGIONS; i++) {
+    struct extMemEntry* e = &extMemTab[i];
+    if (e->mr != NULL && e->addr == (char*) p) {
+      DBG_PRINTF(DBG_MR, "ext fi_close(%p, %#zx)", e->addr, e->size);
+      OFI_CHK(fi_close(&e->mr->fid));
+      e->mr = NULL;
+      (void) atomic_fetch_sub_int_least32_t(&numExtMemRegions, 1);
+      break;
+    }
+  }
+  PTHREAD_CHK(pthread_mutex_unlock(&mrCacheLock));
+}
+
+
 ////////////////////////////////////////
 //
 // Interface: memory consistency
@@ -2595,7 +3807,8 @@ void chpl_comm_impl_task_create(void) {
 void chpl_comm_impl_task_end(void) {
   DBG_PRINTF(DBG_IFACE_MCM, "%s()", __func__);
 
-  task_local_buff_end(get_buff | put_buff | amo_nf_buff);
+  task_local_buff_end(get_buff | put_buff | amo_nf_buff | agg_put_buff
+                      | agg_amo_buff);
   retireDelayedAmDone(true /*taskIsEnding*/);
   waitForPutsVisAllNodes(NULL, NULL, true /*taskIsEnding*/);
 }
@@ -2615,6 +3828,8 @@ typedef enum {
   am_opFree,                               // free some memory
   am_opNop,                                // do nothing; for MCM & liveness
   am_opShutdown,                           // signal main process for shutdown
+  am_opBatch,                              // several of the above
+  am_opPrivBcast,                          // forward a private broadcast
 } amOp_t;
 
 #ifdef CHPL_COMM_DEBUG
@@ -2658,6 +3873,9 @@ typedef union {
   uint64_t u64;
   _real32 r32;
   _real64 r64;
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+  chpl_uint128_t u128;
+#endif
 } chpl_amo_datum_t;
 
 struct amRequest_AMO_t {
@@ -2676,6 +3894,27 @@ struct amRequest_free_t {
   void* p;                      // address to free, on AM target node
 };
 
+//
+// A batch is this header followed by 'numReqs' records, each of which
+// is a size_t request size and then the request itself.  Records start
+// on 8-byte boundaries.
+//
+struct amRequest_batch_t {
+  struct amRequest_base_t b;
+  uint32_t numReqs;             // number of requests that follow
+};
+
+struct amRequest_privBcast_t {
+  struct amRequest_base_t b;
+  int id;                       // private broadcast table index
+  c_nodeid_t root;              // broadcast tree root
+  size_t size;                  // number of bytes
+};
+
+#define AM_BATCH_ALIGN(sz) (((sz) + 7) & ~(size_t) 7)
+#define AM_BATCH_HDR_SIZE AM_BATCH_ALIGN(sizeof(struct amRequest_batch_t))
+#define AM_BATCH_REC_SIZE(reqSz) AM_BATCH_ALIGN(sizeof(size_t) + (reqSz))
+
 typedef union {
   struct amRequest_base_t b;
   struct amRequest_execOn_t xo;      // present only to set the max req size
@@ -2683,6 +3922,8 @@ typedef union {
   struct amRequest_RMA_t rma;
   struct amRequest_AMO_t amo;
   struct amRequest_free_t free;
+  struct amRequest_batch_t batch;
+  struct amRequest_privBcast_t privBcast;
 } amRequest_t;
 
 struct taskArg_RMA_t {
@@ -2690,6 +3931,11 @@ struct taskArg_RMA_t {
   struct amRequest_RMA_t rma;
 };
 
+struct taskArg_privBcast_t {
+  chpl_task_bundle_t hdr;
+  struct amRequest_privBcast_t pb;
+};
+
 
 #ifdef CHPL_COMM_DEBUG
 static const char* am_opName(amOp_t);
@@ -2708,9 +3954,15 @@ static void amRequestAMO(c_nodeid_t, void*, const void*, const void*, void*,
                          int, enum fi_datatype, size_t);
 static void amRequestFree(c_nodeid_t, void*);
 static void amRequestNop(c_nodeid_t, chpl_bool);
+static void amRequestPrivBcast(c_nodeid_t, int, size_t, c_nodeid_t,
+                               amDone_t*);
 static void amRequestCommon(c_nodeid_t, amRequest_t*, size_t,
                             amDone_t**, chpl_bool, struct perTxCtxInfo_t*);
 static inline void amWaitForDone(amDone_t*);
+static chpl_bool amBatchAdd(c_nodeid_t, amRequest_t*, size_t,
+                            struct perTxCtxInfo_t*);
+static void amBatchFlush(c_nodeid_t, struct perTxCtxInfo_t*);
+static void amBatchFlushAll(struct perTxCtxInfo_t*, chpl_bool);
 
 
 void chpl_comm_execute_on(c_nodeid_t node, c_sublocid_t subloc,
@@ -2732,6 +3984,7 @@ void chpl_comm_execute_on(c_nodeid_t node, c_sublocid_t subloc,
 
   chpl_comm_diags_verbose_executeOn("", node, ln, fn);
   chpl_comm_diags_incr(execute_on);
+  chpl_comm_diags_size(execute_on, node, argSize);
 
   amRequestExecOn(node, subloc, fid, arg, argSize, false, true);
 }
@@ -2756,6 +4009,7 @@ void chpl_comm_execute_on_nb(c_nodeid_t node, c_sublocid_t subloc,
 
   chpl_comm_diags_verbose_executeOn("non-blocking", node, ln, fn);
   chpl_comm_diags_incr(execute_on_nb);
+  chpl_comm_diags_size(execute_on, node, argSize);
 
   amRequestExecOn(node, subloc, fid, arg, argSize, false, false);
 }
@@ -2780,6 +4034,7 @@ void chpl_comm_execute_on_fast(c_nodeid_t node, c_sublocid_t subloc,
 
   chpl_comm_diags_verbose_executeOn("fast", node, ln, fn);
   chpl_comm_diags_incr(execute_on_fast);
+  chpl_comm_diags_size(execute_on, node, argSize);
 
   amRequestExecOn(node, subloc, fid, arg, argSize, true, true);
 }
@@ -2801,9 +4056,9 @@ void amRequestExecOn(c_nodeid_t node, c_sublocid_t subloc,
                                          .subloc = subloc,
                                          .argSize = argSize, };
 
-  if (argSize <= sizeof(amRequest_t)) {
+  if (argSize <= amExecOnEagerMaxBytes) {
     //
-    // The arg bundle will fit in max-sized AM request; just send it.
+    // The arg bundle is small enough to send eagerly; just send it.
     //
     arg->kind = am_opExecOn;
     amRequestCommon(node, (amRequest_t*) arg, argSize,
@@ -2895,6 +4150,9 @@ void amRequestAMO(c_nodeid_t node, void* object,
   amDone_t* pAmDone = NULL;
   if (myResult == NULL) {
     delayBlocking = setUpDelayedAmDone(&prvData, (void**) &pAmDone);
+    if (pAmDone != NULL) {
+      prvData->amDoneNode = node;
+    }
   } else {
     if (mrGetLocalKey(myResult, resSize) != 0) {
       myResult = allocBounceBuf(resSize);
@@ -2953,6 +4211,64 @@ void amRequestNop(c_nodeid_t node, chpl_bool blocking) {
 }
 
 
+static inline
+void amRequestPrivBcast(c_nodeid_t node, int id, size_t size,
+                        c_nodeid_t root, amDone_t* pAmDone) {
+  //
+  // Ask the node to forward a private broadcast to its subtree.  We
+  // don't wait here; the caller waits for *pAmDone, so that it can
+  // have requests to all its children in flight at once.
+  //
+  amRequest_t req = { .privBcast = { .b = { .op = am_opPrivBcast,
+                                            .node = chpl_nodeID,
+                                            .pAmDone = pAmDone, },
+                                     .id = id,
+                                     .root = root,
+                                     .size = size, }, };
+  amRequestCommon(node, &req, sizeof(req.privBcast),
+                  NULL, false /*yieldDuringTxnWait*/, NULL);
+}
+
+
+static
+void privBcastSubtree(int id, size_t size, c_nodeid_t root) {
+  //
+  // Send a private broadcast value to our children in the broadcast
+  // tree and have each of them forward it to its own children.  Return
+  // once our whole subtree has it.
+  //
+  const int numChildren = chpl_comm_tree_num_children(chpl_nodeID, root,
+                                                      BAR_TREE_NUM_CHILDREN);
+  if (numChildren == 0) {
+    return;
+  }
+
+  amDone_t* dones = allocBounceBuf(numChildren * sizeof(*dones));
+  CHK_TRUE(mrGetLocalKey(dones, numChildren * sizeof(*dones)) == 0);
+  memset(dones, 0, numChildren * sizeof(*dones));
+  chpl_atomic_thread_fence(memory_order_release);
+
+  for (int i = 0; i < numChildren; i++) {
+    c_nodeid_t child = chpl_comm_tree_child(chpl_nodeID, root,
+                                            BAR_TREE_NUM_CHILDREN, i);
+    (void) ofi_put(chpl_rt_priv_bcast_tab[id], child,
+                   chplPrivBcastTabMap[child][id], size);
+    amRequestPrivBcast(child, id, size, root, &dones[i]);
+  }
+
+  for (int i = 0; i < numChildren; i++) {
+    if (amBatching) {
+      amBatchFlush(chpl_comm_tree_child(chpl_nodeID, root,
+                                        BAR_TREE_NUM_CHILDREN, i),
+                   NULL);
+    }
+    amWaitForDone(&dones[i]);
+  }
+
+  freeBounceBuf(dones);
+}
+
+
 static inline
 void amRequestShutdown(c_nodeid_t node) {
   assert(!isAmHandler);
@@ -3021,15 +4337,6 @@ void amRequestCommon(c_nodeid_t node,
     CHK_TRUE((myTcip = tciAlloc()) != NULL);
   }
 
-  amRequest_t* myReq = req;
-  void* mrDesc = NULL;
-  if (mrGetDesc(&mrDesc, myReq, reqSize) != 0) {
-    myReq = allocBounceBuf(reqSize);
-    DBG_PRINTF(DBG_AM | DBG_AM_SEND, "AM req BB: %p", myReq);
-    CHK_TRUE(mrGetDesc(NULL, myReq, reqSize) == 0);
-    memcpy(myReq, req, reqSize);
-  }
-
   //
   // We're ready to send the request.  But for on-stmts and AMOs that
   // might modify their target variable, MCM conformance requires us
@@ -3046,15 +4353,44 @@ void amRequestCommon(c_nodeid_t node,
   // be strictly correct we need to allow for overlapping transfers to
   // go via different methods.
   //
-  if (myReq->b.op == am_opExecOn
-      || myReq->b.op == am_opExecOnLrg
-      || (myReq->b.op == am_opAMO && myReq->amo.ofiOp != FI_ATOMIC_READ)) {
+  if (req->b.op == am_opExecOn
+      || req->b.op == am_opExecOnLrg
+      || (req->b.op == am_opAMO && req->amo.ofiOp != FI_ATOMIC_READ)) {
     waitForPutsVisAllNodes(myTcip, NULL, false /*taskIsEnding*/);
-  } else if (myReq->b.op == am_opGet
-             || myReq->b.op == am_opPut) {
+  } else if (req->b.op == am_opGet
+             || req->b.op == am_opPut
+             || req->b.op == am_opPrivBcast) {
     waitForPutsVisOneNode(node, myTcip, NULL);
   }
 
+  //
+  // If we're batching and won't wait for this request, add it to the
+  // batch for the target node.  Otherwise, send any batch we have for
+  // that node first, so the target sees our requests in order.  The AM
+  // handler doesn't batch, because it can't wait for other senders.
+  //
+  if (amBatching && !isAmHandler) {
+    if (pAmDone == NULL
+        && req->b.op != am_opShutdown
+        && (amBatchEnabled || req->b.op == am_opAMO)
+        && amBatchAdd(node, req, reqSize, myTcip)) {
+      if (tcip == NULL) {
+        tciFree(myTcip);
+      }
+      return;
+    }
+    amBatchFlush(node, myTcip);
+  }
+
+  amRequest_t* myReq = req;
+  void* mrDesc = NULL;
+  if (mrGetDesc(&mrDesc, myReq, reqSize) != 0) {
+    myReq = allocBounceBuf(reqSize);
+    DBG_PRINTF(DBG_AM | DBG_AM_SEND, "AM req BB: %p", myReq);
+    CHK_TRUE(mrGetDesc(NULL, myReq, reqSize) == 0);
+    memcpy(myReq, req, reqSize);
+  }
+
   //
   // Inject the message if it's small enough and we're not going to wait
   // for it anyway.  Otherwise, do a regular send.  Don't count injected
@@ -3106,6 +4442,214 @@ void amRequestCommon(c_nodeid_t node,
 }
 
 
+//
+// AM request batching
+//
+// With CHPL_RT_COMM_OFI_AM_BATCH=true, AM requests whose completion we
+// don't wait for (nonblocking on-stmts, non-fetching AMOs with delayed
+// or no 'done' indicators, frees, and nonblocking no-ops) are gathered
+// in a node-wide buffer per target node and sent together as a single
+// am_opBatch message, which the target's AM handler unpacks.  Without
+// that, CHPL_RT_COMM_OFI_AM_BATCH_AMOS (true by default) does the same
+// for just the non-fetching AMOs we do by AM because the provider
+// can't do atomics on their type, so that lots of those don't each
+// cost an AM of their own.  A batch is sent when the next request
+// won't fit in it, before any unbatched request to the same node (to
+// keep the target seeing our requests in order), before waiting for a
+// delayed 'done' from that node, and by our AM handler once it is more
+// than CHPL_RT_COMM_OFI_AM_BATCH_USECS old.  The last of these means a
+// task that sends a nonblocking AM and then waits for its effects
+// without any more comm still progresses.  Batches are injected, so
+// CHPL_RT_COMM_OFI_AM_BATCH_BYTES is limited by the provider's inject
+// size.  The am_batches and am_batched_reqs comm diags counters give
+// the average number of requests per batch.
+//
+struct amBatch_t {
+  pthread_mutex_t lock;
+  size_t len;                   // bytes used in buf, header included
+  double firstTime;             // when the first request was added
+  char* buf;                    // struct amRequest_batch_t, then records
+};
+
+static struct amBatch_t* amBatches;         // one per target node
+static atomic_uint_least32_t amBatchesPending; // # of non-empty batches
+
+
+static
+void init_amBatching(void) {
+  //
+  // A batch has to be able to hold at least two of the smallest request
+  // we'd put in it.
+  //
+  const size_t minReqSize = amBatchEnabled
+                            ? sizeof(struct amRequest_free_t)
+                            : sizeof(struct amRequest_AMO_t);
+  if (amBatching
+      && amBatchMaxBytes < AM_BATCH_HDR_SIZE
+                           + 2 * AM_BATCH_REC_SIZE(minReqSize)) {
+    amBatchEnabled = false;
+    amBatching = false;
+  }
+
+  if (!amBatching) {
+    return;
+  }
+
+  atomic_init_uint_least32_t(&amBatchesPending, 0);
+  CHPL_CALLOC(amBatches, chpl_numNodes);
+  for (int i = 0; i < chpl_numNodes; i++) {
+    struct amBatch_t* bat = &amBatches[i];
+    PTHREAD_CHK(pthread_mutex_init(&bat->lock, NULL));
+    CHPL_CALLOC_SZ(bat->buf, 1, amBatchMaxBytes);
+    struct amRequest_batch_t* hdr = (struct amRequest_batch_t*) bat->buf;
+    hdr->b.op = am_opBatch;
+    hdr->b.node = chpl_nodeID;
+    bat->len = AM_BATCH_HDR_SIZE;
+  }
+
+  DBG_PRINTF(DBG_CFG, "AM batching: %zd bytes, %.0f usecs",
+             amBatchMaxBytes, amBatchMaxAge * 1e6);
+}
+
+
+static inline
+chpl_bool amBatchIsEmpty(struct amBatch_t* bat) {
+  return bat->len == AM_BATCH_HDR_SIZE;
+}
+
+
+static
+void amBatchSendLocked(c_nodeid_t node, struct amBatch_t* bat,
+                       struct perTxCtxInfo_t* tcip) {
+  //
+  // Send the batch for the given node.  The caller holds its lock.  A
+  // batch of one is sent as just that request; the target needn't know.
+  //
+  struct amRequest_batch_t* hdr = (struct amRequest_batch_t*) bat->buf;
+  void* msg = bat->buf;
+  size_t msgSize = bat->len;
+  if (hdr->numReqs == 1) {
+    char* rec = bat->buf + AM_BATCH_HDR_SIZE;
+    msg = rec + sizeof(size_t);
+    msgSize = *(size_t*) rec;
+  }
+
+  DBG_PRINTF(DBG_AM | DBG_AM_SEND,
+             "tx AM batch inject to %d: %" PRIu32 " reqs, sz %zd",
+             (int) node, hdr->numReqs, msgSize);
+  OFI_RIDE_OUT_EAGAIN(tcip,
+                      fi_inject(tcip->txCtx, msg, msgSize,
+                                rxMsgAddr(tcip, node)));
+  tcip->numTxnsSent++;
+
+  chpl_comm_diags_incr(am_batches);
+  chpl_comm_diags_add(am_batched_reqs, hdr->numReqs);
+
+  hdr->numReqs = 0;
+  bat->len = AM_BATCH_HDR_SIZE;
+  (void) atomic_fetch_sub_uint_least32_t(&amBatchesPending, 1);
+}
+
+
+static
+chpl_bool amBatchAdd(c_nodeid_t node, amRequest_t* req, size_t reqSize,
+                     struct perTxCtxInfo_t* tcip) {
+  //
+  // Add a request to the batch for the given node, sending that first
+  // if the request won't fit.  Return false if it wouldn't fit even in
+  // an empty batch, in which case the caller has to send it by itself.
+  //
+  const size_t recSize = AM_BATCH_REC_SIZE(reqSize);
+  if (AM_BATCH_HDR_SIZE + recSize > amBatchMaxBytes) {
+    return false;
+  }
+
+  struct amBatch_t* bat = &amBatches[node];
+  PTHREAD_CHK(pthread_mutex_lock(&bat->lock));
+
+  if (bat->len + recSize > amBatchMaxBytes) {
+    amBatchSendLocked(node, bat, tcip);
+  }
+
+  if (amBatchIsEmpty(bat)) {
+    bat->firstTime = chpl_comm_ofi_time_get();
+    (void) atomic_fetch_add_uint_least32_t(&amBatchesPending, 1);
+  }
+
+  char* rec = bat->buf + bat->len;
+  *(size_t*) rec = reqSize;
+  memcpy(rec + sizeof(size_t), req, reqSize);
+  bat->len += recSize;
+  ((struct amRequest_batch_t*) bat->buf)->numReqs++;
+
+  if (DBG_TEST_MASK(DBG_AM | DBG_AM_SEND)
+      || (req->b.op == am_opAMO && DBG_TEST_MASK(DBG_AMO))) {
+    DBG_DO_PRINTF("tx AM req batched for %d: %s",
+                  (int) node, am_reqStr(node, req, reqSize));
+  }
+
+  PTHREAD_CHK(pthread_mutex_unlock(&bat->lock));
+  return true;
+}
+
+
+static
+void amBatchFlush(c_nodeid_t node, struct perTxCtxInfo_t* tcip) {
+  //
+  // Send any batch we have for the given node.
+  //
+  if (atomic_load_uint_least32_t(&amBatchesPending) == 0) {
+    return;
+  }
+
+  struct perTxCtxInfo_t* myTcip = tcip;
+  struct amBatch_t* bat = &amBatches[node];
+  PTHREAD_CHK(pthread_mutex_lock(&bat->lock));
+  if (!amBatchIsEmpty(bat)) {
+    if (myTcip == NULL) {
+      CHK_TRUE((myTcip = tciAlloc()) != NULL);
+    }
+    amBatchSendLocked(node, bat, myTcip);
+  }
+  PTHREAD_CHK(pthread_mutex_unlock(&bat->lock));
+
+  if (myTcip != tcip) {
+    tciFree(myTcip);
+  }
+}
+
+
+static
+void amBatchFlushAll(struct perTxCtxInfo_t* tcip, chpl_bool onlyStale) {
+  //
+  // Send our batches: all of them, or, for the AM handler, those older
+  // than the limit.  The AM handler only trylocks, because a task that
+  // holds a batch lock may be waiting for the target to make room for
+  // it, and the target may be waiting similarly on us.
+  //
+  if (atomic_load_uint_least32_t(&amBatchesPending) == 0) {
+    return;
+  }
+
+  double now = onlyStale ? chpl_comm_ofi_time_get() : 0.0;
+  for (c_nodeid_t node = 0; node < chpl_numNodes; node++) {
+    struct amBatch_t* bat = &amBatches[node];
+    if (onlyStale) {
+      if (pthread_mutex_trylock(&bat->lock) != 0) {
+        continue;
+      }
+    } else {
+      PTHREAD_CHK(pthread_mutex_lock(&bat->lock));
+    }
+    if (!amBatchIsEmpty(bat)
+        && (!onlyStale || now - bat->firstTime > amBatchMaxAge)) {
+      amBatchSendLocked(node, bat, tcip);
+    }
+    PTHREAD_CHK(pthread_mutex_unlock(&bat->lock));
+  }
+}
+
+
 static inline
 void amWaitForDone(amDone_t* pAmDone) {
   //
@@ -3162,6 +4706,9 @@ void retireDelayedAmDone(chpl_bool taskIsEnding) {
   chpl_comm_taskPrvData_t* prvData = get_comm_taskPrvdata();
   if (prvData != NULL) {
     if (prvData->amDonePending) {
+      if (amBatching) {
+        amBatchFlush(prvData->amDoneNode, NULL);
+      }
       amWaitForDone((amDone_t*) &prvData->amDone);
       prvData->amDonePending = false;
     }
@@ -3183,10 +4730,13 @@ static pthread_mutex_t amStartStopMutex = PTHREAD_MUTEX_INITIALIZER;
 
 static void amHandler(void*);
 static void processRxAmReq(struct perTxCtxInfo_t*);
+static void amHandleRequest(amRequest_t*, size_t);
+static void amHandleBatch(struct amRequest_batch_t*);
+static void amWrapPrivBcast(struct taskArg_privBcast_t*);
 static void amHandleExecOn(chpl_comm_on_bundle_t*);
 static inline void amWrapExecOnBody(void*);
 static void amHandleExecOnLrg(chpl_comm_on_bundle_t*);
-static void amWrapExecOnLrgBody(struct amRequest_execOnLrg_t*);
+static void amWrapExecOnLrgBody(struct taskArg_execOnLrg_t*);
 static void amWrapGet(struct taskArg_RMA_t*);
 static void amWrapPut(struct taskArg_RMA_t*);
 static void amHandleAMO(struct amRequest_AMO_t*);
@@ -3197,6 +4747,8 @@ static inline void doCpuAMO(void*, const void*, const void*, void*,
                             enum fi_op, enum fi_datatype, size_t size);
 
 
+static void init_amBatching(void);
+
 static
 void init_amHandling(void) {
   //
@@ -3207,6 +4759,8 @@ void init_amHandling(void) {
     CHK_TRUE(sizeof(pd.amDone) >= sizeof(amDone_t));
   }
 
+  init_amBatching();
+
   //
   // Start AM handler thread(s).  Don't proceed from here until at
   // least one is running.
@@ -3215,7 +4769,7 @@ void init_amHandling(void) {
 
   PTHREAD_CHK(pthread_mutex_lock(&amStartStopMutex));
   for (int i = 0; i < numAmHandlers; i++) {
-    CHK_TRUE(chpl_task_createCommTask(amHandler, NULL) == 0);
+    CHK_TRUE(chpl_task_createCommTask(amHandler, &amhTab[i]) == 0);
   }
   PTHREAD_CHK(pthread_cond_wait(&amStartStopCond, &amStartStopMutex));
   PTHREAD_CHK(pthread_mutex_unlock(&amStartStopMutex));
@@ -3227,6 +4781,16 @@ void fini_amHandling(void) {
   if (chpl_numNodes <= 1)
     return;
 
+  //
+  // Send any AM request batches that are still waiting.
+  //
+  if (amBatching) {
+    struct perTxCtxInfo_t* tcip;
+    CHK_TRUE((tcip = tciAlloc()) != NULL);
+    amBatchFlushAll(tcip, false /*onlyStale*/);
+    tciFree(tcip);
+  }
+
   //
   // Tear down the AM handler thread(s).  On node 0, don't proceed from
   // here until the last one has finished.
@@ -3246,14 +4810,22 @@ void fini_amHandling(void) {
 static __thread struct perTxCtxInfo_t* amTcip;
 
 static
-void amHandler(void* argNil) {
+void amHandler(void* arg) {
+  amhip = (struct perAmHandlerInfo_t*) arg;
+  const chpl_bool amhIsFirst = (amhip == &amhTab[0]);
+
   struct perTxCtxInfo_t* tcip;
   CHK_TRUE((tcip = tciAllocForAmHandler()) != NULL);
   amTcip = tcip;
 
   isAmHandler = true;
 
-  DBG_PRINTF(DBG_AM, "AM handler running");
+  if (chpl_topo_bindToReservedCPUs()) {
+    DBG_PRINTF(DBG_AM, "AM handler %td bound to reserved CPUs",
+               amhip - amhTab);
+  }
+
+  DBG_PRINTF(DBG_AM, "AM handler %td running", amhip - amhTab);
 
   //
   // Count this AM handler thread as running.  The creator thread
@@ -3269,19 +4841,28 @@ void amHandler(void* argNil) {
   // Process AM requests and watch transmit responses arrive.
   //
   while (!atomic_load_bool(&amHandlersExit)) {
-    if (ofi_amhPollSet != NULL) {
-      void* contexts[pollSetSize];
+    if (amhip->pollSet != NULL) {
+      void* contexts[amhip->pollSetSize];
       int ret;
-      OFI_CHK_COUNT(fi_poll(ofi_amhPollSet, contexts, pollSetSize), ret);
+      OFI_CHK_COUNT(fi_poll(amhip->pollSet, contexts, amhip->pollSetSize),
+                    ret);
 
-      if (ret == 0) {
-        ret = fi_wait(ofi_amhWaitSet, 100 /*ms*/);
+      //
+      // Don't block waiting if we have batched AM requests that will
+      // need sending.
+      //
+      if (ret == 0
+          && !(amhIsFirst
+               && amBatching
+               && atomic_load_uint_least32_t(&amBatchesPending) > 0)) {
+        ret = fi_wait(amhip->waitSet, 100 /*ms*/);
         if (ret != FI_SUCCESS
             && ret != -FI_EINTR
             && ret != -FI_ETIMEDOUT) {
-          OFI_ERR("fi_wait(ofi_amhWaitSet)", ret, fi_strerror(ret));
+          OFI_ERR("fi_wait(amhip->waitSet)", ret, fi_strerror(ret));
         }
-        OFI_CHK_COUNT(fi_poll(ofi_amhPollSet, contexts, pollSetSize), ret);
+        OFI_CHK_COUNT(fi_poll(amhip->pollSet, contexts, amhip->pollSetSize),
+                      ret);
       }
 
       //
@@ -3291,7 +4872,7 @@ void amHandler(void* argNil) {
       // progress, and the poll call itself did that.
       //
       for (int i = 0; i < ret; i++) {
-        if (contexts[i] == &ofi_rxCQ) {
+        if (contexts[i] == &amhip->rxCQ) {
           processRxAmReq(tcip);
         } else if (contexts[i] == &tcip->checkTxCmplsFn) {
           (*tcip->checkTxCmplsFn)(tcip);
@@ -3308,13 +4889,24 @@ void amHandler(void* argNil) {
       //
       processRxAmReq(tcip);
       (*tcip->checkTxCmplsFn)(tcip);
-      (*checkRxRmaCmplsFn)();
+      if (amhIsFirst) {
+        (*checkRxRmaCmplsFn)();
+      }
 
       sched_yield();
     }
 
-    if (amDoLivenessChecks) {
-      amCheckLiveness();
+    //
+    // The first AM handler does the periodic work.
+    //
+    if (amhIsFirst) {
+      if (amBatching) {
+        amBatchFlushAll(tcip, true /*onlyStale*/);
+      }
+
+      if (amDoLivenessChecks) {
+        amCheckLiveness();
+      }
     }
   }
 
@@ -3328,7 +4920,7 @@ void amHandler(void* argNil) {
     PTHREAD_CHK(pthread_cond_signal(&amStartStopCond));
   PTHREAD_CHK(pthread_mutex_unlock(&amStartStopMutex));
 
-  DBG_PRINTF(DBG_AM, "AM handler done");
+  DBG_PRINTF(DBG_AM, "AM handler %td done", amhip - amhTab);
 }
 
 
@@ -3340,11 +4932,11 @@ void processRxAmReq(struct perTxCtxInfo_t* tcip) {
   struct fi_cq_data_entry cqes[5];
   const size_t maxEvents = sizeof(cqes) / sizeof(cqes[0]);
   ssize_t ret;
-  CHK_TRUE((ret = fi_cq_read(ofi_rxCQ, cqes, maxEvents)) > 0
+  CHK_TRUE((ret = fi_cq_read(amhip->rxCQ, cqes, maxEvents)) > 0
            || ret == -FI_EAGAIN
            || ret == -FI_EAVAIL);
   if (ret == -FI_EAVAIL) {
-    reportCQError(ofi_rxCQ);
+    reportCQError(amhip->rxCQ);
   }
 
   const size_t numEvents = (ret == -FI_EAGAIN) ? 0 : ret;
@@ -3357,11 +4949,11 @@ void processRxAmReq(struct perTxCtxInfo_t* tcip) {
       amRequest_t* req = (amRequest_t*) cqes[i].buf;
       DBG_PRINTF(DBG_AM_BUF,
                  "CQ rx AM req @ buffer offset %zd, sz %zd, seqId %s",
-                 (char*) req - (char*) ofi_iov_reqs[ofi_msg_i].iov_base,
+                 (char*) req - (char*) amhip->iovReqs[amhip->msgI].iov_base,
                  cqes[i].len, am_seqIdStr(req));
 
 #if defined(CHPL_COMM_DEBUG) && defined(DEBUG_CRC_MSGS)
-      if (DBG_TEST_MASK(DBG_AM)) {
+      if (DBG_TEST_MASK(DBG_AM) && req->b.op != am_opBatch) {
         uint32_t sent_crc, rcvd_crc;
         size_t reqSize;
         if (op_uses_on_bundle(req->b.op)) {
@@ -3386,80 +4978,115 @@ void processRxAmReq(struct perTxCtxInfo_t* tcip) {
       }
 #endif
 
-      DBG_PRINTF(DBG_AM | DBG_AM_RECV,
-                 "rx AM req: %s",
-                 am_reqStr(chpl_nodeID, req, cqes[i].len));
-      switch (req->b.op) {
-      case am_opExecOn:
-        if (req->xo.hdr.comm.fast) {
-          amWrapExecOnBody(&req->xo.hdr);
-        } else {
-          amHandleExecOn(&req->xo.hdr);
-        }
-        break;
+      amHandleRequest(req, cqes[i].len);
+    }
 
-      case am_opExecOnLrg:
-        amHandleExecOnLrg(&req->xol.hdr);
-        break;
+    if ((cqes[i].flags & FI_MULTI_RECV) != 0) {
+      //
+      // Multi-receive buffer filled; post the other one.
+      //
+      amhip->msgI = 1 - amhip->msgI;
+      OFI_CHK(fi_recvmsg(amhip->rxEp, &amhip->msgReqs[amhip->msgI],
+                         FI_MULTI_RECV));
+      DBG_PRINTF(DBG_AM_BUF,
+                 "re-post fi_recvmsg(AMLZs %p, len %#zx)",
+                 amhip->msgReqs[amhip->msgI].msg_iov->iov_base,
+                 amhip->msgReqs[amhip->msgI].msg_iov->iov_len);
+    }
 
-      case am_opGet:
-        {
-          struct taskArg_RMA_t arg = { .hdr.kind = CHPL_ARG_BUNDLE_KIND_TASK,
-                                       .rma = req->rma, };
-          chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapGet,
-                                   &arg, sizeof(arg), c_sublocid_any,
-                                   chpl_nullTaskID);
-        }
-        break;
+    CHK_TRUE((cqes[i].flags & ~(FI_MSG | FI_RECV | FI_MULTI_RECV)) == 0);
+  }
+}
 
-      case am_opPut:
-        {
-          struct taskArg_RMA_t arg = { .hdr.kind = CHPL_ARG_BUNDLE_KIND_TASK,
-                                       .rma = req->rma, };
-          chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapPut,
-                                   &arg, sizeof(arg), c_sublocid_any,
-                                   chpl_nullTaskID);
-        }
-        break;
 
-      case am_opAMO:
-        amHandleAMO(&req->amo);
-        break;
+static
+void amHandleRequest(amRequest_t* req, size_t reqSize) {
+  DBG_PRINTF(DBG_AM | DBG_AM_RECV,
+             "rx AM req: %s",
+             am_reqStr(chpl_nodeID, req, reqSize));
+  switch (req->b.op) {
+  case am_opExecOn:
+    if (req->xo.hdr.comm.fast) {
+      amWrapExecOnBody(&req->xo.hdr);
+    } else {
+      amHandleExecOn(&req->xo.hdr);
+    }
+    break;
 
-      case am_opFree:
-        CHPL_FREE(req->free.p);
-        break;
+  case am_opExecOnLrg:
+    amHandleExecOnLrg(&req->xol.hdr);
+    break;
 
-      case am_opNop:
-        DBG_PRINTF(DBG_AM | DBG_AM_RECV, "%s", am_reqDoneStr(req));
-        if (req->b.pAmDone != NULL) {
-          amSendDone(req->b.node, req->b.pAmDone);
-        }
-        break;
+  case am_opGet:
+    {
+      struct taskArg_RMA_t arg = { .hdr.kind = CHPL_ARG_BUNDLE_KIND_TASK,
+                                   .rma = req->rma, };
+      chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapGet,
+                               &arg, sizeof(arg), c_sublocid_any,
+                               chpl_nullTaskID);
+    }
+    break;
 
-      case am_opShutdown:
-        chpl_signal_shutdown();
-        break;
+  case am_opPut:
+    {
+      struct taskArg_RMA_t arg = { .hdr.kind = CHPL_ARG_BUNDLE_KIND_TASK,
+                                   .rma = req->rma, };
+      chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapPut,
+                               &arg, sizeof(arg), c_sublocid_any,
+                               chpl_nullTaskID);
+    }
+    break;
 
-      default:
-        INTERNAL_ERROR_V("unexpected AM op %d", (int) req->b.op);
-        break;
-      }
+  case am_opAMO:
+    amHandleAMO(&req->amo);
+    break;
+
+  case am_opFree:
+    CHPL_FREE(req->free.p);
+    break;
+
+  case am_opNop:
+    DBG_PRINTF(DBG_AM | DBG_AM_RECV, "%s", am_reqDoneStr(req));
+    if (req->b.pAmDone != NULL) {
+      amSendDone(req->b.node, req->b.pAmDone);
     }
+    break;
 
-    if ((cqes[i].flags & FI_MULTI_RECV) != 0) {
-      //
-      // Multi-receive buffer filled; post the other one.
-      //
-      ofi_msg_i = 1 - ofi_msg_i;
-      OFI_CHK(fi_recvmsg(ofi_rxEp, &ofi_msg_reqs[ofi_msg_i], FI_MULTI_RECV));
-      DBG_PRINTF(DBG_AM_BUF,
-                 "re-post fi_recvmsg(AMLZs %p, len %#zx)",
-                 ofi_msg_reqs[ofi_msg_i].msg_iov->iov_base,
-                 ofi_msg_reqs[ofi_msg_i].msg_iov->iov_len);
+  case am_opShutdown:
+    chpl_signal_shutdown();
+    break;
+
+  case am_opBatch:
+    amHandleBatch(&req->batch);
+    break;
+
+  case am_opPrivBcast:
+    {
+      struct taskArg_privBcast_t arg = { .hdr.kind = CHPL_ARG_BUNDLE_KIND_TASK,
+                                         .pb = req->privBcast, };
+      chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapPrivBcast,
+                               &arg, sizeof(arg), c_sublocid_any,
+                               chpl_nullTaskID);
     }
+    break;
 
-    CHK_TRUE((cqes[i].flags & ~(FI_MSG | FI_RECV | FI_MULTI_RECV)) == 0);
+  default:
+    INTERNAL_ERROR_V("unexpected AM op %d", (int) req->b.op);
+    break;
+  }
+}
+
+
+static
+void amHandleBatch(struct amRequest_batch_t* batch) {
+  //
+  // Handle the requests in a batch, in the order they were added.
+  //
+  char* rec = (char*) batch + AM_BATCH_HDR_SIZE;
+  for (uint32_t i = 0; i < batch->numReqs; i++) {
+    size_t reqSize = *(size_t*) rec;
+    amHandleRequest((amRequest_t*) (rec + sizeof(size_t)), reqSize);
+    rec += AM_BATCH_REC_SIZE(reqSize);
   }
 }
 
@@ -3494,38 +5121,66 @@ void amWrapExecOnBody(void* p) {
 
 static inline
 void amHandleExecOnLrg(chpl_comm_on_bundle_t* req) {
-  struct amRequest_execOnLrg_t* xol = (struct amRequest_execOnLrg_t*) req;
+  struct taskArg_execOnLrg_t arg = { .xol = *(struct amRequest_execOnLrg_t*)
+                                            req, };
+  struct amRequest_execOnLrg_t* xol = &arg.xol;
   xol->hdr.kind = am_opExecOn;  // was am_opExecOnLrg, to direct us here
+
+  //
+  // Start retrieving the payload now, so that it overlaps starting the
+  // task that will run the body.  We can do this if the GET can go
+  // directly into the space we allocate for the bundle.  Otherwise the
+  // task retrieves the payload itself.
+  //
+  chpl_comm_bundleData_t* comm = &xol->hdr.comm;
+  c_nodeid_t node = comm->node;
+  size_t payloadSize = comm->argSize
+                       - offsetof(chpl_comm_on_bundle_t, payload);
+  CHK_TRUE(mrGetKey(NULL, NULL, node, xol->pPayload, payloadSize) == 0);
+
+  CHPL_CALLOC_SZ(arg.bundle, 1, comm->argSize);
+  if (payloadSize <= ofi_info->ep_attr->max_msg_size
+      && mrGetDesc(NULL, &arg.bundle->payload, payloadSize) == 0) {
+    CHPL_CALLOC(arg.pGetDone, 1);
+    atomic_init_bool(arg.pGetDone, false);
+    ofi_get_ll(&arg.bundle->payload, node, xol->pPayload, payloadSize,
+               txnTrkEncodeDone(arg.pGetDone), amTcip);
+  } else {
+    CHPL_FREE(arg.bundle);
+    arg.bundle = NULL;
+  }
+
   chpl_task_startMovedTask(FID_NONE, (chpl_fn_p) amWrapExecOnLrgBody,
-                           xol, sizeof(*xol),
-                           xol->hdr.comm.subloc, chpl_nullTaskID);
+                           &arg, sizeof(arg),
+                           comm->subloc, chpl_nullTaskID);
 }
 
 
 static
-void amWrapExecOnLrgBody(struct amRequest_execOnLrg_t* xol) {
-  //
-  // TODO: We could stack-allocate "bundle" here, if it was small enough
-  //       (TBD) not to create the potential for stack overflow.  Some
-  //       systems have fast enough networks that saving the dynamic
-  //       alloc should be performance-visible.
-  //
-
+void amWrapExecOnLrgBody(struct taskArg_execOnLrg_t* arg) {
   //
   // The bundle header is in our argument, but we have to retrieve the
-  // payload from the initiating side.
+  // payload from the initiating side.  Usually the AM handler has
+  // already started that and we just wait for it.
   //
+  struct amRequest_execOnLrg_t* xol = &arg->xol;
   chpl_comm_bundleData_t* comm = &xol->hdr.comm;
   c_nodeid_t node = comm->node;
 
-  chpl_comm_on_bundle_t* bundle;
-  CHPL_CALLOC_SZ(bundle, 1, comm->argSize);
-  *bundle = xol->hdr;
-
-  size_t payloadSize = comm->argSize
-                       - offsetof(chpl_comm_on_bundle_t, payload);
-  CHK_TRUE(mrGetKey(NULL, NULL, node, xol->pPayload, payloadSize) == 0);
-  (void) ofi_get(&bundle->payload, node, xol->pPayload, payloadSize);
+  chpl_comm_on_bundle_t* bundle = arg->bundle;
+  if (bundle != NULL) {
+    while (!atomic_load_explicit_bool(arg->pGetDone, memory_order_acquire)) {
+      local_yield();
+    }
+    atomic_destroy_bool(arg->pGetDone);
+    CHPL_FREE(arg->pGetDone);
+  } else {
+    size_t payloadSize = comm->argSize
+                         - offsetof(chpl_comm_on_bundle_t, payload);
+    CHPL_CALLOC_SZ(bundle, 1, comm->argSize);
+    (void) ofi_get(&bundle->payload, node, xol->pPayload, payloadSize);
+  }
+  *bundle = xol->hdr;
 
   //
   // Iff this is a nonblocking executeOn, now that we have the payload
@@ -3582,6 +5237,15 @@ void amWrapPut(struct taskArg_RMA_t* tsk_rma) {
 }
 
 
+static
+void amWrapPrivBcast(struct taskArg_privBcast_t* tsk_pb) {
+  struct amRequest_privBcast_t* pb = &tsk_pb->pb;
+  privBcastSubtree(pb->id, pb->size, pb->root);
+  DBG_PRINTF(DBG_AM | DBG_AM_RECV, "%s", am_reqDoneStr((amRequest_t*) pb));
+  amSendDone(pb->b.node, pb->b.pAmDone);
+}
+
+
 static
 void amHandleAMO(struct amRequest_AMO_t* amo) {
   assert(amo->b.node != chpl_nodeID);    // should be handled on initiator
@@ -3764,8 +5428,13 @@ void chpl_comm_put(void* addr, c_nodeid_t node, void* raddr,
 
   chpl_comm_diags_verbose_rdma("put", node, size, ln, fn, commID);
   chpl_comm_diags_incr(put);
+  chpl_comm_diags_size(put, node, size);
 
-  (void) ofi_put(addr, node, raddr, size);
+  if (aggPutsEnabled) {
+    do_remote_put_agg(addr, node, raddr, size);
+  } else {
+    (void) ofi_put(addr, node, raddr, size);
+  }
 }
 
 
@@ -3802,11 +5471,173 @@ void chpl_comm_get(void* addr, int32_t node, void* raddr,
 
   chpl_comm_diags_verbose_rdma("get", node, size, ln, fn, commID);
   chpl_comm_diags_incr(get);
+  chpl_comm_diags_size(get, node, size);
 
   (void) ofi_get(addr, node, raddr, size);
 }
 
 
+//
+// Vectored strided transfers (see strdVectored).
+//
+static void ofi_put_V(int, void**, void**, c_nodeid_t*, void**, uint64_t*,
+                      size_t*, struct bitmap_t*, chpl_bool);
+static void ofi_get_V(int, void**, void**, c_nodeid_t*, void**, uint64_t*,
+                      size_t*);
+
+struct strd_V_batch_t {
+  chpl_bool isPut;
+  struct bitmap_t* b;           // PUT target nodes, for ofi_put_V()
+  int vi;
+  void* addr_v[MAX_CHAINED_STRD_LEN];
+  void* local_mr_v[MAX_CHAINED_STRD_LEN];
+  struct mrCacheEntry* mrce_v[MAX_CHAINED_STRD_LEN];
+  c_nodeid_t locale_v[MAX_CHAINED_STRD_LEN];
+  void* raddr_v[MAX_CHAINED_STRD_LEN];
+  uint64_t remote_mr_v[MAX_CHAINED_STRD_LEN];
+  size_t size_v[MAX_CHAINED_STRD_LEN];
+};
+
+
+static
+void strd_V_batch_flush(struct strd_V_batch_t* batch) {
+  if (batch->vi == 0) {
+    return;
+  }
+
+  DBG_PRINTF(DBG_RMA, "strd_V_batch_flush(): %s batch has %d entries",
+             batch->isPut ? "PUT" : "GET", batch->vi);
+
+  if (batch->isPut) {
+    ofi_put_V(batch->vi, batch->addr_v, batch->local_mr_v,
+              batch->locale_v, batch->raddr_v, batch->remote_mr_v,
+              batch->size_v, batch->b, true /*waitForCmpl*/);
+  } else {
+    ofi_get_V(batch->vi, batch->addr_v, batch->local_mr_v,
+              batch->locale_v, batch->raddr_v, batch->remote_mr_v,
+              batch->size_v);
+  }
+
+  for (int vi = 0; vi < batch->vi; vi++) {
+    mrCacheRelease(batch->mrce_v[vi]);
+  }
+  batch->vi = 0;
+}
+
+
+static
+void strd_V_chunk(void* addr, int32_t node, void* raddr, size_t size,
+                  void* ctx, int32_t commID, int ln, int32_t fn) {
+  struct strd_V_batch_t* batch = (struct strd_V_batch_t*) ctx;
+
+  if (size == 0) {
+    return;
+  }
+
+  //
+  // Do the per-chunk accounting chpl_comm_put() and chpl_comm_get()
+  // would have done, so tools see the same thing either way.
+  //
+  const chpl_comm_cb_event_kind_t cbKind =
+    batch->isPut ? chpl_comm_cb_event_kind_put : chpl_comm_cb_event_kind_get;
+  if (chpl_comm_have_callbacks(cbKind)) {
+      chpl_comm_cb_info_t cb_data =
+        {cbKind, chpl_nodeID, node,
+         .iu.comm={addr, raddr, size, commID, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+  }
+
+  if (batch->isPut) {
+    chpl_comm_diags_verbose_rdma("put", node, size, ln, fn, commID);
+    chpl_comm_diags_incr(put);
+    chpl_comm_diags_size(put, node, size);
+  } else {
+    chpl_comm_diags_verbose_rdma("get", node, size, ln, fn, commID);
+    chpl_comm_diags_incr(get);
+    chpl_comm_diags_size(get, node, size);
+  }
+
+  //
+  // If we can't do this chunk directly to or from the user's memory it
+  // goes by itself, through the ordinary path.  Flush what we have
+  // first so that the chunks are done in order.
+  //
+  uint64_t mrKey;
+  uint64_t mrRaddr;
+  void* mrDesc = NULL;
+  struct mrCacheEntry* mrce = NULL;
+  if (size > ofi_info->ep_attr->max_msg_size
+      || mrGetKey(&mrKey, &mrRaddr, node, raddr, size) != 0
+      || (mrGetDesc(&mrDesc, addr, size) != 0
+          && (mrce = mrCacheAcquire(&mrDesc, addr, size)) == NULL)) {
+    strd_V_batch_flush(batch);
+    if (batch->isPut) {
+      (void) ofi_put(addr, node, raddr, size);
+    } else {
+      (void) ofi_get(addr, node, raddr, size);
+    }
+    return;
+  }
+
+  const int vi = batch->vi;
+  batch->addr_v[vi] = addr;
+  batch->local_mr_v[vi] = mrDesc;
+  batch->mrce_v[vi] = mrce;
+  batch->locale_v[vi] = node;
+  batch->raddr_v[vi] = (void*) mrRaddr;
+  batch->remote_mr_v[vi] = mrKey;
+  batch->size_v[vi] = size;
+  if (++batch->vi == MAX_CHAINED_STRD_LEN) {
+    strd_V_batch_flush(batch);
+  }
+}
+
+
+static
+void strd_V_xfer(chpl_bool isPut, void* laddr_arg, size_t* lstrides,
+                 c_nodeid_t node, void* raddr_arg, size_t* rstrides,
+                 size_t* count, int32_t stridelevels, size_t elemSize,
+                 int32_t commID, int ln, int32_t fn) {
+  retireDelayedAmDone(false /*taskIsEnding*/);
+
+  // Communications callback support
+  if (isPut && chpl_comm_have_callbacks(chpl_comm_cb_event_kind_put_strd)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_put_strd, chpl_nodeID, node,
+         .iu.comm_strd={laddr_arg, lstrides, raddr_arg, rstrides, count,
+                        stridelevels, elemSize, commID, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+  }
+  if (!isPut && chpl_comm_have_callbacks(chpl_comm_cb_event_kind_get_strd)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_get_strd, chpl_nodeID, node,
+         .iu.comm_strd={raddr_arg, rstrides, laddr_arg, lstrides, count,
+                        stridelevels, elemSize, commID, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+  }
+
+  //
+  // Aggregated PUTs and AMOs to this node must precede the transfer.
+  //
+  agg_put_flush_node(node);
+  agg_amo_flush_node(node);
+
+  struct strd_V_batch_t batch;
+  batch.isPut = isPut;
+  batch.b = isPut ? bitmapAlloc(chpl_numNodes) : NULL;
+  batch.vi = 0;
+
+  strd_common_call(laddr_arg, lstrides, node,
+                   raddr_arg, rstrides, count, stridelevels, elemSize,
+                   &batch, &strd_V_chunk, commID, ln, fn);
+  strd_V_batch_flush(&batch);
+
+  if (batch.b != NULL) {
+    bitmapFree(batch.b);
+  }
+}
+
+
 void chpl_comm_put_strd(void* dstaddr_arg, size_t* dststrides,
                         c_nodeid_t dstnode,
                         void* srcaddr_arg, size_t* srcstrides,
@@ -3817,6 +5648,14 @@ void chpl_comm_put_strd(void* dstaddr_arg, size_t* dststrides,
              dstaddr_arg, dststrides, (int) dstnode, srcaddr_arg, srcstrides,
              count, (int) stridelevels, elemSize, (int) commID);
 
+  if (strdVectored && dstnode != chpl_nodeID) {
+    strd_V_xfer(true /*isPut*/, srcaddr_arg, srcstrides,
+                dstnode, dstaddr_arg, dststrides,
+                count, stridelevels, elemSize,
+                commID, ln, fn);
+    return;
+  }
+
   put_strd_common(dstaddr_arg, dststrides,
                   dstnode,
                   srcaddr_arg, srcstrides,
@@ -3836,6 +5675,14 @@ void chpl_comm_get_strd(void* dstaddr_arg, size_t* dststrides,
              dstaddr_arg, dststrides, (int) srcnode, srcaddr_arg, srcstrides,
              count, (int) stridelevels, elemSize, (int) commID);
 
+  if (strdVectored && srcnode != chpl_nodeID) {
+    strd_V_xfer(false /*isPut*/, dstaddr_arg, dststrides,
+                srcnode, srcaddr_arg, srcstrides,
+                count, stridelevels, elemSize,
+                commID, ln, fn);
+    return;
+  }
+
   get_strd_common(dstaddr_arg, dststrides,
                   srcnode,
                   srcaddr_arg, srcstrides,
@@ -3920,6 +5767,7 @@ void chpl_comm_get_unordered(void* addr, c_nodeid_t node, void* raddr,
 
   chpl_comm_diags_verbose_rdma("unordered get", node, size, ln, fn, commID);
   chpl_comm_diags_incr(get);
+  chpl_comm_diags_size(get, node, size);
 
   do_remote_get_buff(addr, node, raddr, size);
 }
@@ -3958,6 +5806,7 @@ void chpl_comm_put_unordered(void* addr, c_nodeid_t node, void* raddr,
 
   chpl_comm_diags_verbose_rdma("unordered put", node, size, ln, fn, commID);
   chpl_comm_diags_incr(put);
+  chpl_comm_diags_size(put, node, size);
 
   do_remote_put_buff(addr, node, raddr, size);
 }
@@ -3977,6 +5826,8 @@ void chpl_comm_getput_unordered_task_fence(void) {
 
 static inline struct perTxCtxInfo_t* tciAllocCommon(chpl_bool);
 static struct perTxCtxInfo_t* findFreeTciTabEntry(chpl_bool);
+static void tciFreeListPush(struct perTxCtxInfo_t*);
+static struct perTxCtxInfo_t* tciFreeListPop(void);
 
 static __thread struct perTxCtxInfo_t* _ttcip;
 
@@ -4020,6 +5871,9 @@ struct perTxCtxInfo_t* tciAllocCommon(chpl_bool bindToAmHandler) {
   if (bindToAmHandler
       || (tciTabFixedAssignments && chpl_task_isFixedThread())) {
     _ttcip->bound = true;
+    if (!bindToAmHandler) {
+      (void) atomic_fetch_add_int_least32_t(&tciNumBound, 1);
+    }
   }
   DBG_PRINTF(DBG_TCIPS, "alloc%s tciTab[%td]",
              _ttcip->bound ? " bound" : "", _ttcip - tciTab);
@@ -4039,47 +5893,102 @@ struct perTxCtxInfo_t* findFreeTciTabEntry(chpl_bool bindToAmHandler) {
 
   if (bindToAmHandler) {
     //
-    // AM handlers use tciTab[numWorkerTxCtxs .. tciTabLen - 1].  For
-    // now we only support a single AM handler, so this is simple.  If
-    // we ever have more, the CHK_FALSE will force us to revisit this.
+    // AM handlers use tciTab[numWorkerTxCtxs .. tciTabLen - 1], in the
+    // same order as their amhTab[] entries.
     //
-    tcip = &tciTab[numWorkerTxCtxs];
+    tcip = &tciTab[numWorkerTxCtxs + (amhip - amhTab)];
     CHK_FALSE(atomic_exchange_bool(&tcip->allocated, true));
     return tcip;
   }
 
   //
-  // Workers use tciTab[0 .. numWorkerTxCtxs - 1].  Search forever for
-  // an entry we can use.  Give up (and kill the program) only if we
-  // discover they're all bound, because if that's true we can predict
-  // we'll never find a free one.
+  // Workers use tciTab[0 .. numWorkerTxCtxs - 1], taking them from the
+  // free list.  An entry we pop may have been re-taken meanwhile by the
+  // last thread that had it (see tciAllocCommon()), in which case it's
+  // theirs and we try again.  If the list is empty we wait for someone
+  // to free an entry.  Give up (and kill the program) only if they're
+  // all bound, because if that's true we can predict we'll never find
+  // a free one.
   //
-  static __thread int last_iw = 0;
-  tcip = NULL;
+  chpl_bool contended = false;
+  while (true) {
+    if ((tcip = tciFreeListPop()) != NULL) {
+      if (!atomic_exchange_bool(&tcip->allocated, true)) {
+        break;
+      }
+    } else {
+      CHK_FALSE(atomic_load_int_least32_t(&tciNumBound) == numWorkerTxCtxs);
+      local_yield();
+    }
+    contended = true;
+  }
+
+  if (contended) {
+    chpl_comm_diags_incr(tci_alloc_contended);
+  }
 
+  return tcip;
+}
+
+
+static
+void tciFreeListPush(struct perTxCtxInfo_t* tcip) {
+  //
+  // Push a worker tx context onto the free list, unless it's already
+  // there.
+  //
+  if (atomic_exchange_bool(&tcip->onFreeList, true)) {
+    return;
+  }
+
+  const uint_least32_t idx = (uint_least32_t) (tcip - tciTab) + 1;
+  uint_least64_t head = atomic_load_uint_least64_t(&tciFreeHead);
+  uint_least64_t newHead;
   do {
-    int iw = last_iw;
-    chpl_bool allBound = true;
+    atomic_store_uint_least32_t(&tcip->nextFree,
+                                (uint_least32_t) (head & 0xffffffff));
+    newHead = (((head >> 32) + 1) << 32) | idx;
+  } while (!atomic_compare_exchange_weak_uint_least64_t(&tciFreeHead,
+                                                         &head, newHead));
+}
 
-    do {
-      if (++iw >= numWorkerTxCtxs)
-        iw = 0;
-      allBound = allBound && tciTab[iw].bound;
-      if (!atomic_exchange_bool(&tciTab[iw].allocated, true)) {
-        tcip = &tciTab[iw];
-      }
-    } while (tcip == NULL && iw != last_iw);
 
-    if (tcip == NULL) {
-      CHK_FALSE(allBound);
-      local_yield();
+static
+struct perTxCtxInfo_t* tciFreeListPop(void) {
+  //
+  // Pop a worker tx context off the free list, or return NULL if it's
+  // empty.  The tag in the head makes the CAS fail if the list changed
+  // under us, even if the same entry is on top again.
+  //
+  uint_least64_t head = atomic_load_uint_least64_t(&tciFreeHead);
+  struct perTxCtxInfo_t* tcip;
+  uint_least64_t newHead;
+  do {
+    const uint_least32_t idx = (uint_least32_t) (head & 0xffffffff);
+    if (idx == 0) {
+      return NULL;
     }
-  } while (tcip == NULL);
+    tcip = &tciTab[idx - 1];
+    newHead = (((head >> 32) + 1) << 32)
+              | atomic_load_uint_least32_t(&tcip->nextFree);
+  } while (!atomic_compare_exchange_weak_uint_least64_t(&tciFreeHead,
+                                                         &head, newHead));
 
+  atomic_store_bool(&tcip->onFreeList, false);
   return tcip;
 }
 
 
+static
+void tciFreeListInit(int numWorkerTxCtxs) {
+  atomic_init_uint_least64_t(&tciFreeHead, 0);
+  atomic_init_int_least32_t(&tciNumBound, 0);
+  for (int i = numWorkerTxCtxs - 1; i >= 0; i--) {
+    tciFreeListPush(&tciTab[i]);
+  }
+}
+
+
 static inline
 void tciFree(struct perTxCtxInfo_t* tcip) {
   //
@@ -4088,13 +5997,264 @@ void tciFree(struct perTxCtxInfo_t* tcip) {
   if (!tcip->bound) {
     DBG_PRINTF(DBG_TCIPS, "free tciTab[%td]", tcip - tciTab);
     atomic_store_bool(&tcip->allocated, false);
+    if (tcip < &tciTab[tciTabLen - numAmHandlers]) {
+      tciFreeListPush(tcip);
+    }
+  }
+}
+
+
+static
+void cmaXfer(chpl_bool isPut, void* addr, c_nodeid_t node, void* raddr,
+             size_t size) {
+#ifdef __linux__
+  //
+  // Copy directly to or from a co-located node's memory.  Any PUTs we
+  // did to it through the provider have to be visible first.  The copy
+  // itself is complete, and visible, when the call returns.
+  //
+  struct perTxCtxInfo_t* tcip;
+  CHK_TRUE((tcip = tciAlloc()) != NULL);
+  waitForPutsVisOneNode(node, tcip, NULL);
+  tciFree(tcip);
+
+  DBG_PRINTF(DBG_RMA | (isPut ? DBG_RMA_WRITE : DBG_RMA_READ),
+             "CMA %s %d:%p %s %p, size %zd",
+             isPut ? "PUT" : "GET", (int) node, raddr,
+             isPut ? "<=" : "=>", addr, size);
+
+  char* lp = (char*) addr;
+  char* rp = (char*) raddr;
+  while (size > 0) {
+    struct iovec liov = { .iov_base = lp, .iov_len = size, };
+    struct iovec riov = { .iov_base = rp, .iov_len = size, };
+    ssize_t n = isPut
+                ? process_vm_writev(cmaPids[node], &liov, 1, &riov, 1, 0)
+                : process_vm_readv(cmaPids[node], &liov, 1, &riov, 1, 0);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      INTERNAL_ERROR_V("CMA %s with node %d failed: %s",
+                       isPut ? "PUT" : "GET", (int) node, strerror(errno));
+    }
+    lp += n;
+    rp += n;
+    size -= n;
+  }
+#else
+  INTERNAL_ERROR_V("no CMA support");
+#endif
+}
+
+
+static inline
+struct railTxCtx_t* railTxCtxAlloc(struct rail_t* rail) {
+  static __thread int next;
+
+  while (true) {
+    for (int i = 0; i < rail->numTxCtxs; i++) {
+      const int ti = (next + i) % rail->numTxCtxs;
+      struct railTxCtx_t* rtcp = &rail->txCtxs[ti];
+      if (!atomic_exchange_bool(&rtcp->busy, true)) {
+        next = (ti + 1) % rail->numTxCtxs;
+        return rtcp;
+      }
+    }
+    local_yield();
+  }
+}
+
+
+static inline
+void railTxCtxFree(struct railTxCtx_t* rtcp) {
+  atomic_store_bool(&rtcp->busy, false);
+}
+
+
+static inline
+chpl_bool railGetKeyDesc(struct rail_t* rail, c_nodeid_t node,
+                         void* raddr, void* addr, size_t size,
+                         uint64_t* pKey, uint64_t* pOff, void** pDesc) {
+  if (scalableMemReg) {
+    *pKey = 0;
+    *pOff = (uint64_t) raddr;
+    *pDesc = NULL;
+    return true;
   }
+
+  struct memEntry* rmr = getMemEntry(&rail->memTabMap[node], raddr, size);
+  struct memEntry* lmr = getMemEntry(&rail->memTab, addr, size);
+  if (rmr == NULL || lmr == NULL) {
+    return false;
+  }
+  *pKey = rmr->key;
+  *pOff = (uint64_t) raddr - rmr->base;
+  *pDesc = lmr->desc;
+  return true;
+}
+
+
+//
+// Do a PUT or GET using the extra rails, if it's big enough and the
+// memory at both ends is RMA-accessible on them.  Transfers of at least
+// railStripeMinSize are split across all the rails, including the main
+// one.  Smaller ones of at least railNearMinSize go entirely through
+// the rail nearest the calling thread, if that's an extra one.  Either
+// way, when we return the data has arrived.  Returns true if we did the
+// transfer, false if the caller should.
+//
+static
+chpl_bool railRma(chpl_bool isPut, void* addr, c_nodeid_t node,
+                  void* raddr, size_t size) {
+  if (numRails == 1 || size == 0 || size < railNearMinSize || isAmHandler) {
+    return false;
+  }
+
+  //
+  // Rail 0 is the main domain and the others are railTab[r - 1].
+  //
+  int railLo;
+  int railHi;
+  if (size >= railStripeMinSize) {
+    railLo = 0;
+    railHi = numRails - 1;
+  } else {
+    const c_sublocid_t subloc = chpl_topo_getThreadLocality();
+    if (!isActualSublocID(subloc) || subloc == mainRailSubloc) {
+      return false;
+    }
+    for (railLo = 1; railLo < numRails; railLo++) {
+      if (railTab[railLo - 1].subloc == subloc) {
+        break;
+      }
+    }
+    if (railLo == numRails) {
+      return false;
+    }
+    railHi = railLo;
+  }
+
+  //
+  // Figure out the pieces, and make sure we can reach them all.
+  //
+  const int numPieces = railHi - railLo + 1;
+  const size_t pieceSize = ((size / numPieces) + 63) & ~(size_t) 63;
+  uint64_t keys[numRails];
+  uint64_t offs[numRails];
+  void* descs[numRails];
+
+  for (int r = railLo; r <= railHi; r++) {
+    const size_t off = (r - railLo) * pieceSize;
+    if (off >= size) {
+      railHi = r - 1;
+      break;
+    }
+    const size_t len = (pieceSize < size - off) ? pieceSize : size - off;
+    char* pieceAddr = (char*) addr + off;
+    char* pieceRaddr = (char*) raddr + off;
+    if (r == 0) {
+      if (mrGetKey(&keys[r], &offs[r], node, pieceRaddr, len) != 0
+          || mrGetDesc(&descs[r], pieceAddr, len) != 0) {
+        return false;
+      }
+    } else if (!railGetKeyDesc(&railTab[r - 1], node, pieceRaddr, pieceAddr,
+                               len, &keys[r], &offs[r], &descs[r])) {
+      return false;
+    }
+  }
+
+  DBG_PRINTF(DBG_RMA | (isPut ? DBG_RMA_WRITE : DBG_RMA_READ),
+             "%s %d:%p %s %p, size %zd, on rails %d-%d",
+             isPut ? "PUT" : "GET", (int) node, raddr,
+             isPut ? "<=" : "=>", addr, size, railLo, railHi);
+
+  //
+  // Earlier PUTs to this node through the main domain have to be
+  // visible before we go around them.
+  //
+  struct perTxCtxInfo_t* tcip;
+  CHK_TRUE((tcip = tciAlloc()) != NULL);
+  waitForPutsVisOneNode(node, tcip, NULL);
+
+  atomic_bool txnDone;
+  atomic_init_bool(&txnDone, false);
+  void* ctx = txnTrkEncodeDone(&txnDone);
+  struct railTxCtx_t* rtcps[numRails];
+
+  //
+  // Start the pieces.  We get the rail tx contexts in rail order, so
+  // threads waiting for them can't wait on each other in a cycle.
+  //
+  for (int r = railLo; r <= railHi; r++) {
+    const size_t off = (r - railLo) * pieceSize;
+    const size_t len = (pieceSize < size - off) ? pieceSize : size - off;
+    char* pieceAddr = (char*) addr + off;
+    char* pieceRaddr = (char*) raddr + off;
+
+    if (r == 0) {
+      if (isPut) {
+        ofi_put_ll(pieceAddr, node, pieceRaddr, len, ctx, tcip, false);
+      } else {
+        ofi_get_ll(pieceAddr, node, pieceRaddr, len, ctx, tcip);
+      }
+      continue;
+    }
+
+    struct rail_t* rail = &railTab[r - 1];
+    struct railTxCtx_t* rtcp = rtcps[r] = railTxCtxAlloc(rail);
+    ssize_t ret;
+    do {
+      if (isPut) {
+        OFI_CHK_2(fi_write(rtcp->ep, pieceAddr, len, descs[r],
+                           rail->rxAddrs[node], offs[r], keys[r], NULL),
+                  ret, -FI_EAGAIN);
+      } else {
+        OFI_CHK_2(fi_read(rtcp->ep, pieceAddr, len, descs[r],
+                          rail->rxAddrs[node], offs[r], keys[r], NULL),
+                  ret, -FI_EAGAIN);
+      }
+      if (ret == -FI_EAGAIN) {
+        sched_yield();
+      }
+    } while (ret == -FI_EAGAIN);
+  }
+
+  //
+  // Wait for them all.
+  //
+  if (railLo == 0) {
+    waitForTxnComplete(tcip, ctx);
+  }
+  atomic_destroy_bool(&txnDone);
+  tciFree(tcip);
+
+  for (int r = (railLo == 0) ? 1 : railLo; r <= railHi; r++) {
+    struct fi_cq_entry cqe;
+    while (readCQ(rtcps[r]->cq, &cqe, 1) == 0) {
+      sched_yield();
+    }
+    railTxCtxFree(rtcps[r]);
+  }
+
+  return true;
 }
 
 
 static inline
 chpl_comm_nb_handle_t ofi_put(const void* addr, c_nodeid_t node,
                               void* raddr, size_t size) {
+  //
+  // Aggregated PUTs and AMOs to this node must precede this one.
+  //
+  agg_put_flush_node(node);
+  agg_amo_flush_node(node);
+
+  if (cmaReachable(node)) {
+    cmaXfer(true, (void*) addr, node, raddr, size);
+    return NULL;
+  }
+
   //
   // Don't ask the provider to transfer more than it wants to.
   //
@@ -4115,6 +6275,10 @@ chpl_comm_nb_handle_t ofi_put(const void* addr, c_nodeid_t node,
     return NULL;
   }
 
+  if (railRma(true, (void*) addr, node, raddr, size)) {
+    return NULL;
+  }
+
   DBG_PRINTF(DBG_RMA | DBG_RMA_WRITE,
              "PUT %d:%p <= %p, size %zd",
              (int) node, raddr, addr, size);
@@ -4128,7 +6292,9 @@ chpl_comm_nb_handle_t ofi_put(const void* addr, c_nodeid_t node,
     // The remote address is RMA-accessible; PUT directly to it.
     //
     void* mrDesc = NULL;
-    if (mrGetDesc(&mrDesc, myAddr, size) != 0) {
+    struct mrCacheEntry* mrce = NULL;
+    if (mrGetDesc(&mrDesc, myAddr, size) != 0
+        && (mrce = mrCacheAcquire(&mrDesc, myAddr, size)) == NULL) {
       myAddr = allocBounceBuf(size);
       DBG_PRINTF(DBG_RMA | DBG_RMA_WRITE, "PUT src BB: %p", myAddr);
       CHK_TRUE(mrGetDesc(&mrDesc, myAddr, size) == 0);
@@ -4200,6 +6366,7 @@ chpl_comm_nb_handle_t ofi_put(const void* addr, c_nodeid_t node,
     }
 
     tciFree(tcip);
+    mrCacheRelease(mrce);
   } else {
     //
     // The remote address is not RMA-accessible.  Make sure that the
@@ -4277,7 +6444,7 @@ void ofi_put_ll(const void* addr, c_nodeid_t node,
 static
 void ofi_put_V(int v_len, void** addr_v, void** local_mr_v,
                c_nodeid_t* locale_v, void** raddr_v, uint64_t* remote_mr_v,
-               size_t* size_v, struct bitmap_t* b) {
+               size_t* size_v, struct bitmap_t* b, chpl_bool waitForCmpl) {
   DBG_PRINTF(DBG_RMA | DBG_RMA_WRITE | DBG_RMA_UNORD,
              "put_V(%d): %d:%p <= %p, size %zd, key 0x%" PRIx64,
              v_len, (int) locale_v[0], raddr_v[0], addr_v[0], size_v[0],
@@ -4338,61 +6505,173 @@ void ofi_put_V(int v_len, void** addr_v, void** local_mr_v,
     bitmapSet(b, locale_v[vi]);
   }
 
-  //
-  // Enforce Chapel MCM: force all of the above PUTs to appear in
-  // target memory.
-  //
-  mcmReleaseAllNodes(b, tcip, "unordered PUT");
+  //
+  // If the caller is going to reuse the source buffers, wait for the
+  // PUTs to be done with them.
+  //
+  if (waitForCmpl) {
+    waitForTxnComplete(tcip, txnTrkEncodeId(__LINE__));
+  }
+
+  //
+  // Enforce Chapel MCM: force all of the above PUTs to appear in
+  // target memory.
+  //
+  mcmReleaseAllNodes(b, tcip, "unordered PUT");
+
+  tciFree(tcip);
+}
+
+
+/*
+ *** START OF BUFFERED PUT OPERATIONS ***
+ *
+ * Support for buffered PUT operations. We internally buffer PUT operations and
+ * then initiate them all at once for increased transaction rate.
+ */
+
+// Flush buffered PUTs for the specified task info and reset the counter.
+static inline
+void put_buff_task_info_flush(put_buff_task_info_t* info) {
+  if (info->vi > 0) {
+    DBG_PRINTF(DBG_RMA_UNORD,
+               "put_buff_task_info_flush(): info has %d entries",
+               info->vi);
+    ofi_put_V(info->vi, info->src_addr_v, info->local_mr_v,
+              info->locale_v, info->tgt_addr_v, info->remote_mr_v,
+              info->size_v, &info->nodeBitmap, false /*waitForCmpl*/);
+    info->vi = 0;
+  }
+}
+
+
+static inline
+void do_remote_put_buff(void* addr, c_nodeid_t node, void* raddr,
+                        size_t size) {
+  uint64_t mrKey;
+  uint64_t mrRaddr;
+  put_buff_task_info_t* info;
+  size_t extra_size = bitmapSizeofMap(chpl_numNodes);
+  if (size > MAX_UNORDERED_TRANS_SZ
+      || mrGetKey(&mrKey, &mrRaddr, node, raddr, size) != 0
+      || (info = task_local_buff_acquire(put_buff, extra_size)) == NULL) {
+    (void) ofi_put(addr, node, raddr, size);
+    return;
+  }
+
+  if (info->new) {
+    info->nodeBitmap.len = chpl_numNodes;
+    info->new = false;
+  }
+
+  void* mrDesc = NULL;
+  CHK_TRUE(mrGetDesc(&mrDesc, info->src_v, size) == 0);
+
+  int vi = info->vi;
+  memcpy(&info->src_v[vi], addr, size);
+  info->src_addr_v[vi] = &info->src_v[vi];
+  info->locale_v[vi] = node;
+  info->tgt_addr_v[vi] = (void*) mrRaddr;
+  info->size_v[vi] = size;
+  info->remote_mr_v[vi] = mrKey;
+  info->local_mr_v[vi] = mrDesc;
+  info->vi++;
+
+  DBG_PRINTF(DBG_RMA_UNORD,
+             "do_remote_put_buff(): info[%d] = "
+             "{%p, %d, %p, %zd, %" PRIx64 ", %p}",
+             vi, info->src_addr_v[vi], (int) node, raddr, size, mrKey, mrDesc);
+
+  // flush if buffers are full
+  if (info->vi == MAX_CHAINED_PUT_LEN) {
+    put_buff_task_info_flush(info);
+  }
+}
+
+
+//
+// Aggregated ordinary PUTs (see aggPutsEnabled).
+//
+static inline
+put_buff_task_info_t* agg_put_info(void) {
+  chpl_comm_taskPrvData_t* prvData;
+  if (!aggPutsEnabled
+      || (prvData = get_comm_taskPrvdata()) == NULL) {
+    return NULL;
+  }
+  return (put_buff_task_info_t*) prvData->agg_put_buff;
+}
+
 
-  tciFree(tcip);
+static inline
+void agg_put_flush_node(c_nodeid_t node) {
+  put_buff_task_info_t* info = agg_put_info();
+  if (info != NULL && info->vi > 0) {
+    for (int i = 0; i < info->vi; i++) {
+      if (info->locale_v[i] == node) {
+        put_buff_task_info_flush(info);
+        return;
+      }
+    }
+  }
 }
 
 
-/*
- *** START OF BUFFERED PUT OPERATIONS ***
- *
- * Support for buffered PUT operations. We internally buffer PUT operations and
- * then initiate them all at once for increased transaction rate.
- */
-
-// Flush buffered PUTs for the specified task info and reset the counter.
 static inline
-void put_buff_task_info_flush(put_buff_task_info_t* info) {
-  if (info->vi > 0) {
-    DBG_PRINTF(DBG_RMA_UNORD,
-               "put_buff_task_info_flush(): info has %d entries",
-               info->vi);
-    ofi_put_V(info->vi, info->src_addr_v, info->local_mr_v,
-              info->locale_v, info->tgt_addr_v, info->remote_mr_v,
-              info->size_v, &info->nodeBitmap);
-    info->vi = 0;
+void agg_put_flush_all(void) {
+  put_buff_task_info_t* info = agg_put_info();
+  if (info != NULL && info->vi > 0) {
+    put_buff_task_info_flush(info);
   }
 }
 
 
 static inline
-void do_remote_put_buff(void* addr, c_nodeid_t node, void* raddr,
-                        size_t size) {
+void do_remote_put_agg(void* addr, c_nodeid_t node, void* raddr,
+                       size_t size) {
   uint64_t mrKey;
   uint64_t mrRaddr;
   put_buff_task_info_t* info;
   size_t extra_size = bitmapSizeofMap(chpl_numNodes);
   if (size > MAX_UNORDERED_TRANS_SZ
       || mrGetKey(&mrKey, &mrRaddr, node, raddr, size) != 0
-      || (info = task_local_buff_acquire(put_buff, extra_size)) == NULL) {
+      || (info = task_local_buff_acquire(agg_put_buff, extra_size)) == NULL) {
     (void) ofi_put(addr, node, raddr, size);
     return;
   }
 
   if (info->new) {
     info->nodeBitmap.len = chpl_numNodes;
+    info->bytes = 0;
     info->new = false;
   }
 
+  //
+  // Keep PUTs to overlapping addresses in order, and don't let the
+  // oldest buffered PUT wait too long.
+  //
+  if (info->vi > 0) {
+    chpl_bool mustFlush =
+      (chpl_comm_ofi_time_get() - info->firstTime > aggPutsMaxAge);
+    for (int i = 0; !mustFlush && i < info->vi; i++) {
+      mustFlush = (info->locale_v[i] == node
+                   && (char*) info->tgt_addr_v[i] < (char*) mrRaddr + size
+                   && (char*) mrRaddr
+                      < (char*) info->tgt_addr_v[i] + info->size_v[i]);
+    }
+    if (mustFlush) {
+      put_buff_task_info_flush(info);
+    }
+  }
+
   void* mrDesc = NULL;
   CHK_TRUE(mrGetDesc(&mrDesc, info->src_v, size) == 0);
 
   int vi = info->vi;
+  if (vi == 0) {
+    info->bytes = 0;
+    info->firstTime = chpl_comm_ofi_time_get();
+  }
   memcpy(&info->src_v[vi], addr, size);
   info->src_addr_v[vi] = &info->src_v[vi];
   info->locale_v[vi] = node;
@@ -4400,15 +6679,16 @@ void do_remote_put_buff(void* addr, c_nodeid_t node, void* raddr,
   info->size_v[vi] = size;
   info->remote_mr_v[vi] = mrKey;
   info->local_mr_v[vi] = mrDesc;
+  info->bytes += size;
   info->vi++;
 
-  DBG_PRINTF(DBG_RMA_UNORD,
-             "do_remote_put_buff(): info[%d] = "
+  DBG_PRINTF(DBG_RMA,
+             "do_remote_put_agg(): info[%d] = "
              "{%p, %d, %p, %zd, %" PRIx64 ", %p}",
              vi, info->src_addr_v[vi], (int) node, raddr, size, mrKey, mrDesc);
 
   // flush if buffers are full
-  if (info->vi == MAX_CHAINED_PUT_LEN) {
+  if (info->vi == MAX_CHAINED_PUT_LEN || info->bytes >= aggPutsMaxBytes) {
     put_buff_task_info_flush(info);
   }
 }
@@ -4418,6 +6698,17 @@ void do_remote_put_buff(void* addr, c_nodeid_t node, void* raddr,
 static inline
 chpl_comm_nb_handle_t ofi_get(void* addr, c_nodeid_t node,
                               void* raddr, size_t size) {
+  //
+  // This GET has to see any aggregated PUTs and AMOs to this node.
+  //
+  agg_put_flush_node(node);
+  agg_amo_flush_node(node);
+
+  if (cmaReachable(node)) {
+    cmaXfer(false, addr, node, raddr, size);
+    return NULL;
+  }
+
   //
   // Don't ask the provider to transfer more than it wants to.
   //
@@ -4438,6 +6729,10 @@ chpl_comm_nb_handle_t ofi_get(void* addr, c_nodeid_t node,
     return NULL;
   }
 
+  if (railRma(false, addr, node, raddr, size)) {
+    return NULL;
+  }
+
   DBG_PRINTF(DBG_RMA | DBG_RMA_READ,
              "GET %p <= %d:%p, size %zd",
              addr, (int) node, raddr, size);
@@ -4451,7 +6746,9 @@ chpl_comm_nb_handle_t ofi_get(void* addr, c_nodeid_t node,
     // The remote address is RMA-accessible; GET directly from it.
     //
     void* mrDesc = NULL;
-    if (mrGetDesc(&mrDesc, myAddr, size) != 0) {
+    struct mrCacheEntry* mrce = NULL;
+    if (mrGetDesc(&mrDesc, myAddr, size) != 0
+        && (mrce = mrCacheAcquire(&mrDesc, myAddr, size)) == NULL) {
       myAddr = allocBounceBuf(size);
       DBG_PRINTF(DBG_RMA | DBG_RMA_READ, "GET tgt BB: %p", myAddr);
       CHK_TRUE(mrGetDesc(&mrDesc, myAddr, size) == 0);
@@ -4492,6 +6789,7 @@ chpl_comm_nb_handle_t ofi_get(void* addr, c_nodeid_t node,
     waitForTxnComplete(tcip, ctx);
     atomic_destroy_bool(&txnDone);
     tciFree(tcip);
+    mrCacheRelease(mrce);
   } else {
     //
     // The remote address is not RMA-accessible.  Make sure that the
@@ -4802,7 +7100,7 @@ static
 void ofi_amo_nf_V(int v_len, uint64_t* opnd1_v, void* local_mr,
                   c_nodeid_t* locale_v, void** object_v, uint64_t* remote_mr_v,
                   size_t* size_v, enum fi_op* cmd_v,
-                  enum fi_datatype* type_v) {
+                  enum fi_datatype* type_v, chpl_bool waitForCmpl) {
   DBG_PRINTF(DBG_AMO | DBG_AMO_UNORD,
              "amo_nf_V(%d): obj %d:%p, opnd1 <%s>, op %s, typ %s, sz %zd, "
              "key 0x%" PRIx64,
@@ -4867,6 +7165,14 @@ void ofi_amo_nf_V(int v_len, uint64_t* opnd1_v, void* local_mr,
     tcip->numTxnsSent++;
   }
 
+  //
+  // If the caller is going to reuse the operand vector or needs the
+  // AMOs to be done, wait for them.
+  //
+  if (waitForCmpl) {
+    waitForTxnComplete(tcip, txnTrkEncodeId(__LINE__));
+  }
+
   tciFree(tcip);
 }
 
@@ -4882,10 +7188,10 @@ void amEnsureProgress(struct perTxCtxInfo_t* tcip) {
     return;
   }
 
-  if (ofi_amhPollSet != NULL) {
-    void* contexts[pollSetSize];
+  if (amhip->pollSet != NULL) {
+    void* contexts[amhip->pollSetSize];
     int ret;
-    OFI_CHK_COUNT(fi_poll(ofi_amhPollSet, contexts, pollSetSize), ret);
+    OFI_CHK_COUNT(fi_poll(amhip->pollSet, contexts, amhip->pollSetSize), ret);
 
     //
     // Process the CQs/counters that had events.  We really only have
@@ -4895,7 +7201,7 @@ void amEnsureProgress(struct perTxCtxInfo_t* tcip) {
     // progress, which the poll call itself will have done.
     //
     for (int i = 0; i < ret; i++) {
-      if (contexts[i] == &ofi_rxCQ) {
+      if (contexts[i] == &amhip->rxCQ) {
         // no action
       } else if (contexts[i] == &tcip->checkTxCmplsFn) {
         (*tcip->checkTxCmplsFn)(tcip);
@@ -4911,7 +7217,9 @@ void amEnsureProgress(struct perTxCtxInfo_t* tcip) {
     // The provider can't do poll sets.
     //
     (*tcip->checkTxCmplsFn)(tcip);
-    (*checkRxRmaCmplsFn)();
+    if (amhip == &amhTab[0]) {
+      (*checkRxRmaCmplsFn)();
+    }
   }
 }
 
@@ -4931,7 +7239,7 @@ void checkRxRmaCmplsCntr(void) {
 
 static
 void checkTxCmplsCQ(struct perTxCtxInfo_t* tcip) {
-  struct fi_cq_msg_entry cqes[txCQLen];
+  struct fi_cq_msg_entry cqes[txCQReadCount];
   const size_t cqesSize = sizeof(cqes) / sizeof(cqes[0]);
   const size_t numEvents = readCQ(tcip->txCQ, cqes, cqesSize);
 
@@ -5010,20 +7318,36 @@ void reportCQError(struct fid_cq* cq) {
 
 static inline
 void waitForTxnComplete(struct perTxCtxInfo_t* tcip, void* ctx) {
+  //
+  // Busy-poll for up to txnWaitSpins progress checks, for the sake of
+  // latency, and then start yielding the processor between checks.
+  //
+  int spins = 0;
+#define WAIT_TXN_BACKOFF()                                              \
+  do {                                                                  \
+    if (spins < txnWaitSpins) {                                         \
+      spins++;                                                          \
+    } else {                                                            \
+      sched_yield();                                                    \
+    }                                                                   \
+  } while (0)
+
   (*tcip->ensureProgressFn)(tcip);
   const txnTrkCtx_t trk = txnTrkDecode(ctx);
   if (trk.typ == txnTrkDone) {
     while (!atomic_load_explicit_bool((atomic_bool*) trk.ptr,
                                       memory_order_acquire)) {
-      sched_yield();
+      WAIT_TXN_BACKOFF();
       (*tcip->ensureProgressFn)(tcip);
     }
   } else {
     while (tcip->numTxnsOut > 0) {
-      sched_yield();
+      WAIT_TXN_BACKOFF();
       (*tcip->ensureProgressFn)(tcip);
     }
   }
+
+#undef WAIT_TXN_BACKOFF
 }
 
 
@@ -5037,6 +7361,9 @@ void waitForPutsVisOneNode(c_nodeid_t node, struct perTxCtxInfo_t* tcip,
   // ordering because the provider lacks delivery-complete and we've
   // got a bound tx context.
   //
+  agg_put_flush_node(node);
+  agg_amo_flush_node(node);
+
   if (!haveDeliveryComplete && tcip->bound) {
     chpl_comm_taskPrvData_t* myPrvData = prvData;
     if (myPrvData == NULL) {
@@ -5063,6 +7390,12 @@ void waitForPutsVisAllNodes(struct perTxCtxInfo_t* tcip,
   // ordering because the provider lacks delivery-complete and we've
   // got a bound tx context.
   //
+  // Aggregated PUTs and AMOs haven't even been initiated yet, so start
+  // them now regardless.  (Doing so also makes them visible.)
+  //
+  agg_put_flush_all();
+  agg_amo_flush_all();
+
   if (chpl_numNodes > 1 && !haveDeliveryComplete) {
     struct perTxCtxInfo_t* myTcip = tcip;
     if (myTcip == NULL) {
@@ -5091,17 +7424,77 @@ void waitForPutsVisAllNodes(struct perTxCtxInfo_t* tcip,
 }
 
 
+//
+// Bounce buffers come from per-thread pools with power-of-4 size
+// classes from 64 bytes to 64 KiB, so that the common small ones don't
+// cost a trip through the memory layer.  They are allocated from the
+// Chapel heap, so they're already registered.  A small header ahead of
+// each buffer records its class (or that it's too big for a class) and
+// links it into its pool when it's free.  Tasks can switch threads, so
+// a buffer may be freed into a different thread's pool than the one it
+// came from; each pool is capped so that can't run away with memory.
+//
+#define BB_NUM_CLASSES 6
+#define BB_MIN_SIZE_LOG2 6
+#define BB_POOL_MAX_DEPTH 16
+
+typedef union bbHdr {
+  struct {
+    int cls;
+    union bbHdr* next;
+  } h;
+  max_align_t align;
+} bbHdr_t;
+
+static __thread bbHdr_t* bbPool[BB_NUM_CLASSES];
+static __thread int bbPoolDepth[BB_NUM_CLASSES];
+
+
+static inline
+int bbSizeClass(size_t size) {
+  size_t clsSize = (size_t) 1 << BB_MIN_SIZE_LOG2;
+  for (int cls = 0; cls < BB_NUM_CLASSES; cls++, clsSize <<= 2) {
+    if (size <= clsSize) {
+      return cls;
+    }
+  }
+  return -1;
+}
+
+
 static
 void* allocBounceBuf(size_t size) {
-  void* p;
-  CHPL_CALLOC_SZ(p, 1, size);
-  return p;
+  const int cls = bbSizeClass(size);
+  bbHdr_t* hdr;
+
+  if (cls >= 0 && (hdr = bbPool[cls]) != NULL) {
+    bbPool[cls] = hdr->h.next;
+    bbPoolDepth[cls]--;
+  } else {
+    chpl_comm_diags_incr(bounce_pool_misses);
+    const size_t allocSize = (cls >= 0)
+                             ? (size_t) 1 << (BB_MIN_SIZE_LOG2 + 2 * cls)
+                             : size;
+    CHPL_CALLOC_SZ(hdr, 1, sizeof(*hdr) + allocSize);
+    hdr->h.cls = cls;
+  }
+
+  return hdr + 1;
 }
 
 
 static
 void freeBounceBuf(void* p) {
-  CHPL_FREE(p);
+  bbHdr_t* hdr = (bbHdr_t*) p - 1;
+  const int cls = hdr->h.cls;
+
+  if (cls >= 0 && bbPoolDepth[cls] < BB_POOL_MAX_DEPTH) {
+    hdr->h.next = bbPool[cls];
+    bbPool[cls] = hdr;
+    bbPoolDepth[cls]++;
+  } else {
+    CHPL_FREE(hdr);
+  }
 }
 
 
@@ -5145,6 +7538,9 @@ void local_yield(void) {
 
 static inline void doAMO(c_nodeid_t, void*, const void*, const void*, void*,
                          int, enum fi_datatype, size_t);
+static void doCasAMO(c_nodeid_t, uint64_t, uint64_t,
+                     const void*, const void*, void*,
+                     enum fi_op, enum fi_datatype, size_t);
 
 
 //
@@ -5245,6 +7641,9 @@ DEFN_CHPL_COMM_ATOMIC_CMPXCHG(uint32, FI_UINT32, uint32_t)
 DEFN_CHPL_COMM_ATOMIC_CMPXCHG(uint64, FI_UINT64, uint64_t)
 DEFN_CHPL_COMM_ATOMIC_CMPXCHG(real32, FI_FLOAT, _real32)
 DEFN_CHPL_COMM_ATOMIC_CMPXCHG(real64, FI_DOUBLE, _real64)
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+DEFN_CHPL_COMM_ATOMIC_CMPXCHG(uint128, OFI_UINT128, chpl_uint128_t)
+#endif
 
 
 #define DEFN_IFACE_AMO_SIMPLE_OP(fnOp, ofiOp, fnType, ofiType, Type)    \
@@ -5375,16 +7774,56 @@ void chpl_comm_atomic_unordered_task_fence(void) {
 // internal AMO utilities
 //
 
+static inline
+amoPath_t amoPath(enum fi_datatype ofiType, enum fi_op ofiOp,
+                  chpl_bool fetching) {
+  if (ofiType >= FI_DATATYPE_LAST) {
+    return amo_pathAm;
+  }
+  return (amoPath_t) amoPathTab[ofiType][ofiOp][fetching ? 1 : 0];
+}
+
+
 static
-int computeAtomicValid(enum fi_datatype ofiType) {
+void init_amoPaths(void) {
+  static const struct {
+    enum fi_datatype type;
+    const char* name;
+  } types[] = { { FI_INT32,  "int32" },
+                { FI_UINT32, "uint32" },
+                { FI_INT64,  "int64" },
+                { FI_UINT64, "uint64" },
+                { FI_FLOAT,  "real32" },
+                { FI_DOUBLE, "real64" },
+#ifdef OFI_HAVE_UINT128
+                { FI_UINT128, "uint128" },
+#endif
+              };
+  static const struct {
+    enum fi_op op;
+    chpl_bool fetching;
+    chpl_bool intOnly;
+    const char* name;
+  } kinds[] = { { FI_ATOMIC_WRITE, false, false, "write" },
+                { FI_ATOMIC_READ,  true,  false, "read" },
+                { FI_ATOMIC_WRITE, true,  false, "xchg" },
+                { FI_CSWAP,        true,  false, "cmpxchg" },
+                { FI_SUM,          false, false, "add" },
+                { FI_SUM,          true,  false, "fetch_add" },
+                { FI_BAND,         false, true,  "and" },
+                { FI_BAND,         true,  true,  "fetch_and" },
+                { FI_BOR,          false, true,  "or" },
+                { FI_BOR,          true,  true,  "fetch_or" },
+                { FI_BXOR,         false, true,  "xor" },
+                { FI_BXOR,         true,  true,  "fetch_xor" }, };
+  static const char* pathNames[] = { "am", "native", "cas" };
+
   //
   // At least one provider (ofi_rxm) segfaults if the endpoint given to
   // fi*atomicvalid() entirely lacks atomic caps.  The man page isn't
   // clear on whether this should work, so just avoid that situation.
   //
-  if ((ofi_info->tx_attr->caps & FI_ATOMIC) == 0) {
-    return 0;
-  }
+  const chpl_bool haveAtomics = (ofi_info->tx_attr->caps & FI_ATOMIC) != 0;
 
   struct fid_ep* ep = tciTab[0].txCtx; // assume same answer for all endpoints
   size_t count;                        // ignored
@@ -5396,57 +7835,75 @@ int computeAtomicValid(enum fi_datatype ofiType) {
 #define my_compare_valid(typ, op) \
   (fi_compare_atomicvalid(ep, typ, op, &count) == 0 && count > 0)
 
-  // For integral types, all operations matter.
-  if (ofiType == FI_INT32
-      || ofiType == FI_UINT32
-      || ofiType == FI_INT64
-      || ofiType == FI_UINT64) {
-    return (   my_valid(ofiType, FI_SUM)
-            && my_valid(ofiType, FI_BOR)
-            && my_valid(ofiType, FI_BAND)
-            && my_valid(ofiType, FI_BXOR)
-            && my_valid(ofiType, FI_ATOMIC_WRITE)
-            && my_fetch_valid(ofiType, FI_SUM)
-            && my_fetch_valid(ofiType, FI_BOR)
-            && my_fetch_valid(ofiType, FI_BAND)
-            && my_fetch_valid(ofiType, FI_BXOR)
-            && my_fetch_valid(ofiType, FI_ATOMIC_READ)
-            && my_fetch_valid(ofiType, FI_ATOMIC_WRITE)
-            && my_compare_valid(ofiType, FI_CSWAP));
-  }
-
-  //
-  // For real types, only sum, read, write, and cswap matter.
-  //
-  return (   my_valid(ofiType, FI_SUM)
-          && my_valid(ofiType, FI_ATOMIC_WRITE)
-          && my_fetch_valid(ofiType, FI_SUM)
-          && my_fetch_valid(ofiType, FI_ATOMIC_READ)
-          && my_fetch_valid(ofiType, FI_ATOMIC_WRITE)
-          && my_compare_valid(ofiType, FI_CSWAP));
+  amoAnyPathAm = false;
+  for (int ti = 0; ti < sizeof(types) / sizeof(types[0]); ti++) {
+    const enum fi_datatype ofiType = types[ti].type;
+#ifdef OFI_HAVE_UINT128
+    const chpl_bool isWide = (ofiType == FI_UINT128);
+#else
+    const chpl_bool isWide = false;
+#endif
+    const enum fi_datatype uintType = isWide
+                                      ? ofiType
+                                      : (ofiType == FI_INT32
+                                         || ofiType == FI_UINT32
+                                         || ofiType == FI_FLOAT)
+                                      ? FI_UINT32 : FI_UINT64;
+    const chpl_bool isInt = (ofiType != FI_FLOAT && ofiType != FI_DOUBLE);
+
+    amoCasType[ofiType] = FI_DATATYPE_LAST;
+    if (haveAtomics) {
+      if (my_compare_valid(ofiType, FI_CSWAP)) {
+        amoCasType[ofiType] = ofiType;
+      } else if (my_compare_valid(uintType, FI_CSWAP)) {
+        amoCasType[ofiType] = uintType;
+      }
+    }
+
+    char buf[300];
+    int len = 0;
+    for (int ki = 0; ki < sizeof(kinds) / sizeof(kinds[0]); ki++) {
+      const enum fi_op ofiOp = kinds[ki].op;
+      const chpl_bool fetching = kinds[ki].fetching;
+      if ((kinds[ki].intOnly && !isInt)
+          || (isWide && ofiOp != FI_CSWAP)) {
+        continue;
+      }
 
-#undef my_valid
-#undef my_fetch_valid
-#undef my_compare_valid
-}
+      amoPath_t path;
+      if (amoCasType[ofiType] == FI_DATATYPE_LAST) {
+        path = amo_pathAm;
+      } else if ((ofiOp == FI_CSWAP)
+                 ? my_compare_valid(ofiType, ofiOp)
+                 : fetching
+                 ? my_fetch_valid(ofiType, ofiOp)
+                 : my_valid(ofiType, ofiOp)) {
+        path = amo_pathNative;
+      } else {
+        path = amo_pathCas;
+      }
+      amoPathTab[ofiType][ofiOp][fetching ? 1 : 0] = path;
 
+      if (len < sizeof(buf)) {
+        len += snprintf(buf + len, sizeof(buf) - len, "%s%s %s",
+                        (len == 0) ? "" : ", ",
+                        kinds[ki].name, pathNames[path]);
+      }
+    }
 
-static
-int isAtomicValid(enum fi_datatype ofiType) {
-  static chpl_bool inited = false;
-  static int validByType[FI_DATATYPE_LAST];
+    if (amoCasType[ofiType] == FI_DATATYPE_LAST) {
+      amoAnyPathAm = true;
+    }
 
-  if (!inited) {
-    validByType[FI_INT32]  = computeAtomicValid(FI_INT32);
-    validByType[FI_UINT32] = computeAtomicValid(FI_UINT32);
-    validByType[FI_INT32]  = computeAtomicValid(FI_INT64);
-    validByType[FI_UINT64] = computeAtomicValid(FI_UINT64);
-    validByType[FI_FLOAT]  = computeAtomicValid(FI_FLOAT);
-    validByType[FI_DOUBLE] = computeAtomicValid(FI_DOUBLE);
-    inited = true;
+    DBG_PRINTF(DBG_CFG, "AMO paths for %s: %s", types[ti].name, buf);
+    if (verbosity >= 2 && chpl_nodeID == 0) {
+      printf("COMM=ofi: %s AMOs: %s\n", types[ti].name, buf);
+    }
   }
 
-  return validByType[ofiType];
+#undef my_valid
+#undef my_fetch_valid
+#undef my_compare_valid
 }
 
 
@@ -5460,10 +7917,20 @@ void doAMO(c_nodeid_t node, void* object,
   }
 
   retireDelayedAmDone(false /*taskIsEnding*/);
+  agg_put_flush_node(node);
+
+  if (aggAmosEnabled) {
+    if (result == NULL
+        && do_remote_amo_agg(operand1, node, object, size, ofiOp, ofiType)) {
+      return;
+    }
+    agg_amo_flush_all();
+  }
 
   uint64_t mrKey;
   uint64_t mrRaddr;
-  if (!isAtomicValid(ofiType)
+  const amoPath_t path = amoPath(ofiType, ofiOp, result != NULL);
+  if (path == amo_pathAm
       || mrGetKey(&mrKey, &mrRaddr, node, object, size) != 0) {
     //
     // We can't do the AMO on the network, so do it on the CPU.  If the
@@ -5478,6 +7945,13 @@ void doAMO(c_nodeid_t node, void* object,
       amRequestAMO(node, object, operand1, operand2, result,
                    ofiOp, ofiType, size);
     }
+  } else if (path == amo_pathCas) {
+    //
+    // The type is supported for network atomics but this op isn't.
+    // Build it out of compare-and-swaps.
+    //
+    doCasAMO(node, mrRaddr, mrKey, operand1, operand2, result,
+             ofiOp, ofiType, size);
   } else {
     //
     // The type is supported for network atomics and the object address
@@ -5489,10 +7963,71 @@ void doAMO(c_nodeid_t node, void* object,
 }
 
 
+static
+void doCasAMO(c_nodeid_t node, uint64_t object, uint64_t mrKey,
+              const void* operand1, const void* operand2, void* result,
+              enum fi_op ofiOp, enum fi_datatype ofiType, size_t size) {
+  const enum fi_datatype casType = amoCasType[ofiType];
+
+  if (ofiOp == FI_CSWAP) {
+    ofi_amo(node, object, mrKey, operand1, operand2, result,
+            FI_CSWAP, casType, size);
+    return;
+  }
+
+  //
+  // Guess the old value, compute the new one from it here, and swap it
+  // in if the guess was right.  If not, the swap told us the value, so
+  // guess that next.  The first guess is 0, which is often right for
+  // counters and flags and otherwise costs no more than a read would
+  // have.  A read is just a swap of the guess for itself.
+  //
+  chpl_amo_datum_t guess = { .u64 = 0 };
+  chpl_amo_datum_t desired;
+  chpl_amo_datum_t actual = { .u64 = 0 };
+  while (true) {
+    desired = guess;
+    if (ofiOp != FI_ATOMIC_READ) {
+      doCpuAMO(&desired, operand1, NULL, NULL, ofiOp, ofiType, size);
+    }
+    ofi_amo(node, object, mrKey, &guess, &desired, &actual,
+            FI_CSWAP, casType, size);
+    if ((size == 4) ? actual.u32 == guess.u32 : actual.u64 == guess.u64) {
+      break;
+    }
+    guess = actual;
+    chpl_comm_diags_incr(amo_cas_retries);
+  }
+
+  if (result != NULL) {
+    memcpy(result, &guess, size);
+  }
+}
+
+
 static inline
 void doCpuAMO(void* obj,
               const void* operand1, const void* operand2, void* result,
               enum fi_op ofiOp, enum fi_datatype ofiType, size_t size) {
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+  if (size == 16) {
+    CHK_TRUE(ofiOp == FI_CSWAP);
+    chpl_uint128_t myOpnd1Val;
+    chpl_uint128_t myOpnd2Val;
+    memcpy(&myOpnd1Val, operand1, sizeof(myOpnd1Val));
+    memcpy(&myOpnd2Val, operand2, sizeof(myOpnd2Val));
+    (void) atomic_compare_exchange_strong_uint128_t(obj, &myOpnd1Val,
+                                                    myOpnd2Val);
+    memcpy(result, &myOpnd1Val, sizeof(myOpnd1Val));
+    DBG_PRINTF(DBG_AMO,
+               "doCpuAMO(%p, %s, %s, %s, %s): res %p is %s",
+               obj, amo_opName(ofiOp), amo_typeName(ofiType),
+               DBG_VAL(operand1, ofiType), DBG_VAL(operand2, ofiType),
+               result, DBG_VAL(result, ofiType));
+    return;
+  }
+#endif
+
   CHK_TRUE(size == 4 || size == 8);
 
   chpl_amo_datum_t* myOpnd1 = (chpl_amo_datum_t*) operand1;
@@ -5675,7 +8210,24 @@ void amo_nf_buff_task_info_flush(amo_nf_buff_task_info_t* info) {
                info->vi);
     ofi_amo_nf_V(info->vi, info->opnd1_v, info->local_mr,
                  info->locale_v, info->object_v, info->remote_mr_v,
-                 info->size_v, info->cmd_v, info->type_v);
+                 info->size_v, info->cmd_v, info->type_v,
+                 false /*waitForCmpl*/);
+    info->vi = 0;
+  }
+}
+
+
+// Flush aggregated AMOs, waiting for them so they're visible.
+static
+void agg_amo_buff_task_info_flush(amo_nf_buff_task_info_t* info) {
+  if (info->vi > 0) {
+    DBG_PRINTF(DBG_AMO,
+               "agg_amo_buff_task_info_flush(): info has %d entries",
+               info->vi);
+    ofi_amo_nf_V(info->vi, info->opnd1_v, info->local_mr,
+                 info->locale_v, info->object_v, info->remote_mr_v,
+                 info->size_v, info->cmd_v, info->type_v,
+                 true /*waitForCmpl*/);
     info->vi = 0;
   }
 }
@@ -5697,7 +8249,8 @@ void do_remote_amo_nf_buff(void* opnd1, c_nodeid_t node,
 
   uint64_t mrKey;
   uint64_t mrRaddr;
-  if (!isAtomicValid(ofiType)
+  const amoPath_t path = amoPath(ofiType, ofiOp, false /*fetching*/);
+  if (path == amo_pathAm
       || mrGetKey(&mrKey, &mrRaddr, node, object, size) != 0) {
     if (node == chpl_nodeID) {
       doCpuAMO(object, opnd1, NULL, NULL, ofiOp, ofiType, size);
@@ -5708,6 +8261,11 @@ void do_remote_amo_nf_buff(void* opnd1, c_nodeid_t node,
     return;
   }
 
+  if (path == amo_pathCas) {
+    doCasAMO(node, mrRaddr, mrKey, opnd1, NULL, NULL, ofiOp, ofiType, size);
+    return;
+  }
+
   amo_nf_buff_task_info_t* info = task_local_buff_acquire(amo_nf_buff, 0);
   if (info == NULL) {
     ofi_amo(node, mrRaddr, mrKey, opnd1, NULL, NULL, ofiOp, ofiType, size);
@@ -5745,6 +8303,131 @@ void do_remote_amo_nf_buff(void* opnd1, c_nodeid_t node,
     amo_nf_buff_task_info_flush(info);
   }
 }
+
+
+//
+// Aggregated ordinary non-fetching AMOs (see aggAmosEnabled).
+//
+static inline
+amo_nf_buff_task_info_t* agg_amo_info(void) {
+  chpl_comm_taskPrvData_t* prvData;
+  if (!aggAmosEnabled
+      || (prvData = get_comm_taskPrvdata()) == NULL) {
+    return NULL;
+  }
+  return (amo_nf_buff_task_info_t*) prvData->agg_amo_buff;
+}
+
+
+static inline
+void agg_amo_flush_node(c_nodeid_t node) {
+  amo_nf_buff_task_info_t* info = agg_amo_info();
+  if (info != NULL && info->vi > 0) {
+    for (int i = 0; i < info->vi; i++) {
+      if (info->locale_v[i] == node) {
+        agg_amo_buff_task_info_flush(info);
+        return;
+      }
+    }
+  }
+}
+
+
+static inline
+void agg_amo_flush_all(void) {
+  amo_nf_buff_task_info_t* info = agg_amo_info();
+  if (info != NULL && info->vi > 0) {
+    agg_amo_buff_task_info_flush(info);
+  }
+}
+
+
+//
+// Buffer a non-fetching AMO, combining it with an earlier one to the
+// same object if possible.  Returns true if the AMO was buffered, or
+// false if it can't be and the caller has to do it.
+//
+static inline
+chpl_bool do_remote_amo_agg(const void* opnd1, c_nodeid_t node,
+                            void* object, size_t size,
+                            int ofiOp, enum fi_datatype ofiType) {
+  //
+  // Only combinable ops on integers (combining real adds would change
+  // the rounding) and only to remote nodes, so that CPU accesses by
+  // other tasks here don't have to wait for us.
+  //
+  if (node == chpl_nodeID
+      || (ofiOp != FI_SUM && ofiOp != FI_BAND
+          && ofiOp != FI_BOR && ofiOp != FI_BXOR)
+      || (ofiType != FI_INT32 && ofiType != FI_UINT32
+          && ofiType != FI_INT64 && ofiType != FI_UINT64)
+      || amoPath(ofiType, ofiOp, false /*fetching*/) != amo_pathNative) {
+    return false;
+  }
+
+  uint64_t mrKey;
+  uint64_t mrRaddr;
+  amo_nf_buff_task_info_t* info;
+  if (mrGetKey(&mrKey, &mrRaddr, node, object, size) != 0
+      || (info = task_local_buff_acquire(agg_amo_buff, 0)) == NULL) {
+    return false;
+  }
+
+  if (info->new) {
+    CHK_TRUE(mrGetDesc(&info->local_mr, info->opnd1_v,
+                       sizeof(info->opnd1_v)) == 0);
+    info->new = false;
+  }
+
+  const uint64_t opnd = (size == 4) ? *(uint32_t*) opnd1
+                                    : *(uint64_t*) opnd1;
+
+  for (int i = 0; i < info->vi; i++) {
+    if (info->object_v[i] == (void*) mrRaddr
+        && info->locale_v[i] == node
+        && info->cmd_v[i] == ofiOp
+        && info->type_v[i] == ofiType) {
+      //
+      // Unsigned arithmetic wraps the same way the network AMOs do,
+      // for both signed and unsigned types.  For 4-byte objects only
+      // the low half is sent, so the carry out of it doesn't matter.
+      //
+      switch (ofiOp) {
+      case FI_SUM:  info->opnd1_v[i] += opnd; break;
+      case FI_BAND: info->opnd1_v[i] &= opnd; break;
+      case FI_BOR:  info->opnd1_v[i] |= opnd; break;
+      default:      info->opnd1_v[i] ^= opnd; break;
+      }
+      chpl_comm_diags_incr(amo_agg_combined);
+      DBG_PRINTF(DBG_AMO,
+                 "do_remote_amo_agg(): combined into info[%d]", i);
+      return true;
+    }
+  }
+
+  int vi = info->vi;
+  info->opnd1_v[vi]     = opnd;
+  info->locale_v[vi]    = node;
+  info->object_v[vi]    = (void*) mrRaddr;
+  info->size_v[vi]      = size;
+  info->cmd_v[vi]       = ofiOp;
+  info->type_v[vi]      = ofiType;
+  info->remote_mr_v[vi] = mrKey;
+  info->vi++;
+
+  DBG_PRINTF(DBG_AMO,
+             "do_remote_amo_agg(): info[%d] = "
+             "{%p, %d, %p, %zd, %d, %d, %" PRIx64 ", %p}",
+             vi, &info->opnd1_v[vi], (int) node, object, size,
+             (int) ofiOp, (int) ofiType, mrKey, info->local_mr);
+
+  // flush if buffers are full
+  if (info->vi == MAX_CHAINED_AMO_NF_LEN) {
+    agg_amo_buff_task_info_flush(info);
+  }
+
+  return true;
+}
 /*** END OF NON-FETCHING BUFFERED ATOMIC OPERATIONS ***/
 
 
@@ -5797,7 +8480,9 @@ int32_t chpl_comm_getMaxThreads(void) {
 //
 // TODO: vectorize the child PUTs.
 //
-#define BAR_TREE_NUM_CHILDREN 64
+// BAR_TREE_NUM_CHILDREN is defined earlier, because the private
+// broadcast uses the same tree shape.
+//
 
 typedef struct {
   volatile int child_notify[BAR_TREE_NUM_CHILDREN];
@@ -5811,6 +8496,24 @@ static c_nodeid_t bar_parent;
 static bar_info_t bar_info;
 static bar_info_t** bar_infoMap;
 
+//
+// The dissemination barrier takes ceil(log2(numNodes)) rounds.  In
+// round r each locale adds 1 to the round-r counter on locale
+// (me + 2^r) % numNodes using a network AMO, and then waits for its
+// own round-r counter to reach the number of barriers it has entered.
+// The counters only ever go up, so nothing needs to be reset between
+// barriers, and using addition rather than writes means it doesn't
+// matter if a fast neighbor's increment for the next barrier arrives
+// before the one for this barrier.  The counters are in the heap so
+// that we can use native network atomics on them where possible.
+//
+#define BAR_DIS_MAX_ROUNDS 32
+
+static int bar_disNumRounds;
+static uint64_t bar_disEpoch;
+static atomic_uint_least64_t* bar_disCnt;
+static atomic_uint_least64_t** bar_disCntMap;
+
 
 static
 void init_bar(void) {
@@ -5827,6 +8530,43 @@ void init_bar(void) {
   CHPL_CALLOC(bar_infoMap, chpl_numNodes);
   const bar_info_t* p = &bar_info;
   chpl_comm_ofi_oob_allgather(&p, bar_infoMap, sizeof(p));
+
+  if (barAlg == bar_algDissemination) {
+    for (bar_disNumRounds = 0;
+         ((c_nodeid_t) 1 << bar_disNumRounds) < chpl_numNodes;
+         bar_disNumRounds++)
+      ;
+    CHK_TRUE(bar_disNumRounds <= BAR_DIS_MAX_ROUNDS);
+    bar_disEpoch = 0;
+
+    CHPL_CALLOC(bar_disCnt, BAR_DIS_MAX_ROUNDS);
+    for (int r = 0; r < BAR_DIS_MAX_ROUNDS; r++) {
+      atomic_init_uint_least64_t(&bar_disCnt[r], 0);
+    }
+    CHPL_CALLOC(bar_disCntMap, chpl_numNodes);
+    chpl_comm_ofi_oob_allgather(&bar_disCnt, bar_disCntMap,
+                                sizeof(bar_disCnt));
+  }
+}
+
+
+static
+void bar_dissemination(void) {
+  const uint64_t one = 1;
+  const uint64_t epoch = ++bar_disEpoch;
+
+  for (int r = 0; r < bar_disNumRounds; r++) {
+    c_nodeid_t peer = (chpl_nodeID + ((c_nodeid_t) 1 << r)) % chpl_numNodes;
+    DBG_PRINTF(DBG_BARRIER, "BAR dissemination round %d notify %d",
+               r, (int) peer);
+    doAMO(peer, &bar_disCntMap[peer][r], &one, NULL, NULL,
+          FI_SUM, FI_UINT64, sizeof(one));
+    agg_amo_flush_all();
+
+    while (atomic_load_uint_least64_t(&bar_disCnt[r]) < epoch) {
+      local_yield();
+    }
+  }
 }
 
 
@@ -5863,6 +8603,13 @@ void chpl_comm_barrier(const char *msg) {
   retireDelayedAmDone(false /*taskIsEnding*/);
   waitForPutsVisAllNodes(NULL, NULL, false /*taskIsEnding*/);
 
+  if (barAlg == bar_algDissemination) {
+    bar_dissemination();
+    DBG_PRINTF(DBG_BARRIER, "barrier '%s' done via dissemination",
+               (msg == NULL) ? "" : msg);
+    return;
+  }
+
   //
   // Wait for our child locales to notify us that they have reached the
   // barrier.
@@ -6137,7 +8884,7 @@ char* chpl_comm_ofi_dbg_prefix(void) {
 
 
 char* chpl_comm_ofi_dbg_val(const void* pV, enum fi_datatype ofiType) {
-  static __thread char buf[5][32];
+  static __thread char buf[5][40];
   static __thread int iBuf = 0;
   char* s = buf[iBuf];
 
@@ -6160,6 +8907,16 @@ char* chpl_comm_ofi_dbg_val(const void* pV, enum fi_datatype ofiType) {
     case FI_DOUBLE:
       snprintf(s, sizeof(buf[0]), "%.16g", *(const double*) pV);
       break;
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+    case OFI_UINT128:
+      {
+        chpl_uint128_t v;
+        memcpy(&v, pV, sizeof(v));
+        snprintf(s, sizeof(buf[0]), "%#" PRIx64 ":%016" PRIx64,
+                 (uint64_t) (v >> 64), (uint64_t) v);
+      }
+      break;
+#endif
     default:
       snprintf(s, sizeof(buf[0]), "%#" PRIx64, *(const uint_least64_t*) pV);
       break;
@@ -6184,6 +8941,8 @@ const char* am_opName(amOp_t op) {
   case am_opFree: return "opFree";
   case am_opNop: return "opNop";
   case am_opShutdown: return "opShutdown";
+  case am_opBatch: return "opBatch";
+  case am_opPrivBcast: return "opPrivBcast";
   default: return "op???";
   }
 }
@@ -6213,6 +8972,9 @@ const char* amo_typeName(enum fi_datatype ofiType) {
   case FI_UINT64: return "uint64";
   case FI_FLOAT: return "_real32";
   case FI_DOUBLE: return "_real64";
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+  case OFI_UINT128: return "uint128";
+#endif
   default: return "amoType???";
   }
 }
@@ -6309,6 +9071,17 @@ const char* am_reqStr(c_nodeid_t tgtNode, amRequest_t* req, size_t reqSize) {
                     req->free.p);
     break;
 
+  case am_opBatch:
+    len += snprintf(buf + len, sizeof(buf) - len, ", %" PRIu32 " reqs",
+                    req->batch.numReqs);
+    break;
+
+  case am_opPrivBcast:
+    len += snprintf(buf + len, sizeof(buf) - len, ", id %d, root %d, sz %zd",
+                    req->privBcast.id, (int) req->privBcast.root,
+                    req->privBcast.size);
+    break;
+
   default:
     break;
   }
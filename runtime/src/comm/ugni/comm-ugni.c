@@ -37,6 +37,7 @@
 #include <sys/resource.h>
 #include <sys/sysinfo.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <gni_pub.h>    // <stddef.h> and <stdint.h> must come first
@@ -67,6 +68,7 @@
 #include "chpl-mem-sys.h"
 #include "chplsys.h"
 #include "chpl-tasks.h"
+#include "chpl-topo.h"
 #include "chpltypes.h"
 #include "chpl-atomics.h"
 #include "chplcast.h"
@@ -236,6 +238,8 @@ static uint64_t debug_stats_flag = 0;
         MACRO(get_strd_cnt)                                             \
         MACRO(get_nb_cnt)                                               \
         MACRO(get_nb_b_cnt)                                             \
+        MACRO(put_nb_cnt)                                               \
+        MACRO(put_nb_b_cnt)                                             \
         MACRO(test_nb_cnt)                                              \
         MACRO(wait_nb_cnt)                                              \
         MACRO(try_nb_cnt)                                               \
@@ -249,6 +253,8 @@ static uint64_t debug_stats_flag = 0;
         MACRO(fork_get_cnt)                                             \
         MACRO(fork_free_cnt)                                            \
         MACRO(fork_amo_cnt)                                             \
+        MACRO(fork_batch_cnt)                                           \
+        MACRO(fork_batched_call_cnt)                                    \
         MACRO(regMemAlloc_cnt)                                          \
         MACRO(regMemPostAlloc_cnt)                                      \
         MACRO(regMemRealloc_cnt)                                        \
@@ -551,6 +557,17 @@ static chpl_bool yield_during_comm;
 // registrations it uses this to update its own mem_regions_all entries
 // on all the other nodes.
 //
+// If CHPL_RT_COMM_UGNI_LAZY_MEMREG_BCAST is set, new regions are not
+// broadcast.  Instead they only go into the node's own mem_regions_all
+// entry, and other nodes pick them up from there with a NIC GET when a
+// lookup of an address on that node misses (see mreg_refresh_remote()).
+// Changes that make an existing entry stale (frees and reallocations)
+// are still broadcast, because a stale entry could otherwise match an
+// address in new memory.  The gen member of a node's own entry is a
+// sequence lock: it is odd while the entry is being changed, and it
+// changes every time the entry does.  In other nodes' copies, it is
+// the gen value the copy was last refreshed from.
+//
 typedef struct {
   uint64_t         addr;
   uint64_t         len;  // includes reg. status; see mrtl_encode() etc. below
@@ -559,6 +576,7 @@ typedef struct {
 
 typedef struct {
   uint32_t     mreg_cnt;  // really hi idx + 1 (mregs[] may have holes)
+  uint32_t     gen;       // change sequence; see above
   mem_region_t mregs[];
 } mem_region_table_t;
 
@@ -574,6 +592,11 @@ static mem_region_table_t** mem_regions_all_entries;
 
 static mem_region_table_t** mem_regions_all_my_entry_map;
 
+static chpl_bool mreg_lazy_bcast = false;
+static mem_region_table_t* mreg_refresh_buf;     // staging for refreshes
+static mem_region_table_t* mreg_refresh_hdr;
+static pthread_mutex_t mreg_refresh_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static chpl_bool can_register_memory = false;
 
 //
@@ -831,6 +854,25 @@ typedef struct {
   mpool_idx_base_t next;            // free list index
 } nb_desc_t;
 
+//
+// User non-blocking GETs and PUTs (chpl_comm_{get,put}_nb()) return a
+// pointer to one of these as their handle.  When the data for a GET
+// has to land in a trampoline buffer first, we remember where it has
+// to go so we can copy it there once the transaction completes.  The
+// descriptors are kept on a per-thread free list, since the remote
+// cache in particular does a great many of these.
+//
+typedef struct nb_xfer_s {
+  nb_desc_t nb_desc;            // POST descriptor, done flag, comm domain
+  void* tramp;                  // trampoline buffer for a GET, or NULL
+  void* tgt_addr;               // where the trampolined data goes
+  size_t tramp_off;             // offset of that data in the trampoline
+  size_t size;                  // size of that data
+  struct nb_xfer_s* next_free;  // free list link
+} nb_xfer_t;
+
+static __thread nb_xfer_t* nb_xfer_free_list;
+
 
 //
 // Declarations having to do with remote fork.  None of this has to
@@ -943,10 +985,11 @@ typedef enum {
   fork_op_free,
   fork_op_amo,
   fork_op_shutdown,
+  fork_op_batch,
   fork_op_num_ops
 } fork_op_t;
 
-#define FORK_OP_BITS 3
+#define FORK_OP_BITS 4
 
 typedef struct {
   chpl_arg_bundle_kind_t op;         // operation
@@ -1005,12 +1048,16 @@ typedef enum {
   add_i64,
   add_r32,
   add_r64,
+  cswap_128,
   num_fork_amo_cmds
 } fork_amo_cmd_t;
 
 typedef union {
   int     i;    // used by amo_res_*() mgmt of temp AMO result buffers
   int64_t i64;  // unref'd; present only to 8-byte align enclosing union type
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+  chpl_uint128_t u128;  // unref'd; present only to size for 128-bit AMOs
+#endif
 } fork_amo_data_t;
 
 typedef struct {
@@ -1026,6 +1073,21 @@ typedef struct {
   fork_base_info_t b;
 } fork_shutdown_info_t;
 
+//
+// A batch of coalesced small call requests (see fork_coalesce_post()).
+// The space holds cnt on-stmt arg bundles back to back, each one
+// starting on an 8-byte boundary.
+//
+#define FORK_BATCH_SPACE MAX_SMALL_CALL_PAYLOAD
+#define FORK_BATCH_ITEM_SIZE(sz) (((sz) + 7) & ~(size_t) 7)
+
+typedef struct {
+  fork_base_info_t b;
+  uint32_t         cnt;                 // number of bundles
+  uint32_t         len;                 // bytes of space used
+  unsigned char    space[FORK_BATCH_SPACE];
+} fork_batch_info_t;
+
 typedef union fork_t {
   fork_base_info_t b;
   fork_small_call_info_t sc;  // present only to set the max req size
@@ -1034,6 +1096,7 @@ typedef union fork_t {
   fork_free_info_t f;
   fork_amo_info_t  a;
   fork_shutdown_info_t s;
+  fork_batch_info_t bt;
 } fork_t;
 
 typedef struct {
@@ -1065,6 +1128,27 @@ static int _fork_req_bufs_per_cd = 2;
 static fork_t*  fork_reqs     = NULL;
 static fork_t** fork_reqs_map = NULL;
 
+//
+// Fork request coalescing.  When CHPL_RT_COMM_UGNI_FORK_COALESCE is
+// set, a small call request to a locale that some other thread is
+// already sending a request to is added to a pending batch for that
+// locale instead of being sent by itself.  The sending thread sends
+// whatever has accumulated before it stops, so many fine-grained
+// on-stmts to the same locale cost one FMA PUT and one request buffer
+// per batch rather than one per call.  A request that finds nobody
+// sending goes right away, so this doesn't add latency.
+//
+#define FORK_COALESCE_MAX_ITEM (FORK_BATCH_SPACE / 2)
+
+typedef struct {
+  atomic_spinlock_t lock;
+  chpl_bool         posting;            // some thread is sending?
+  fork_batch_info_t pend;               // requests waiting to be sent
+} fork_coalesce_t;
+
+static chpl_bool        fork_coalesce_enabled = false;
+static fork_coalesce_t* fork_coalesce = NULL;
+
 //
 // These access the fork request buffers.
 //
@@ -1152,7 +1236,8 @@ static gni_fma_cmd_type_t nic_amos_ari_fetch[]  // Aries, fetching
                GNI_FMA_ATOMIC2_FIADD_S,  // add_i32
                GNI_FMA_ATOMIC2_FIADD,    // add_i64
                GNI_FMA_ATOMIC2_FFPADD_S, // add_r32
-               -1                        // add_r64
+               -1,                       // add_r64
+               -1                        // cswap_128
              };
 
 static gni_fma_cmd_type_t nic_amos_ari[]        // Aries, non-fetching
@@ -1173,7 +1258,8 @@ static gni_fma_cmd_type_t nic_amos_ari[]        // Aries, non-fetching
                GNI_FMA_ATOMIC2_IADD_S,   // add_i32
                GNI_FMA_ATOMIC2_IADD,     // add_i64
                GNI_FMA_ATOMIC2_FPADD_S,  // add_r32
-               -1                        // add_r64
+               -1,                       // add_r64
+               -1                        // cswap_128
              };
 
 
@@ -1345,6 +1431,29 @@ static volatile chpl_bool polling_task_done        = false;
 
 static chpl_bool polling_task_blocking_cq;
 
+//
+// Adaptive polling.  If polling_spin_nsecs is nonzero, after handling
+// a request the polling task keeps checking the request CQ without
+// giving up the processor until that long has passed with nothing
+// arriving.  Then, with a blocking CQ it waits in the kernel for the
+// next event, and with a nonblocking one it sleeps between checks,
+// doubling the sleep each time up to polling_max_sleep_nsecs.  So it
+// is responsive while requests are coming in and stays out of the way
+// of computation otherwise.  If polling_stats is set, the polling task
+// reports how long it spent handling requests and how long idle.
+//
+static uint64_t  polling_spin_nsecs      = 0;
+static uint64_t  polling_max_sleep_nsecs = 100 * 1000;
+static chpl_bool polling_stats           = false;
+
+static inline
+uint64_t polling_nsecs(void)
+{
+  struct timespec ts;
+  (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000UL + (uint64_t) ts.tv_nsec;
+}
+
 
 //
 // Specialized argument type and values for the may_remote_proxy
@@ -1384,7 +1493,9 @@ static void      install_SIGBUS_handler(void);
 static void      SIGBUS_handler(int, siginfo_t *, void *);
 static void      regMemLock(void);
 static void      regMemUnlock(void);
+static void      regMemPublish(int, int, chpl_bool);
 static void      regMemBroadcast(int, int, chpl_bool);
+static chpl_bool mreg_refresh_remote(c_nodeid_t);
 static void      exit_all(int);
 static void      exit_any(int);
 static void      rf_handler(gni_cq_entry_t*);
@@ -1446,6 +1557,9 @@ static void      fork_amo(fork_t*, c_nodeid_t);
 static void      fork_shutdown(c_nodeid_t);
 static void      do_fork_post(c_nodeid_t, chpl_bool,
                               uint64_t, fork_base_info_t*, int*, int*);
+static void      fork_coalesce_post(c_nodeid_t, chpl_comm_on_bundle_t*,
+                                    size_t, chpl_bool);
+static void      fork_coalesce_drain(c_nodeid_t);
 static void      acquire_comm_dom(void);
 static void      acquire_comm_dom_and_req_buf(c_nodeid_t, int*);
 static void      release_comm_dom(void);
@@ -1461,6 +1575,7 @@ static int       post_rdma(c_nodeid_t, gni_post_descriptor_t*);
 static void      post_rdma_and_wait(c_nodeid_t, gni_post_descriptor_t*,
                                     chpl_bool);
 static chpl_bool can_task_yield(void);
+static chpl_bool should_yield_during_comm(chpl_bool);
 static void      local_yield(void);
 
 
@@ -1534,7 +1649,9 @@ static const char* fork_op_name(fork_op_t op)
                                  "put",
                                  "get",
                                  "free",
-                                 "amo" };
+                                 "amo",
+                                 "shutdown",
+                                 "batch" };
   return ((int)op >= 0 && op < fork_op_num_ops) ? names[op] : "?op?";
 }
 
@@ -1563,7 +1680,8 @@ static const char* fork_amo_name(fork_amo_cmd_t cmd)
                                  "add_i32",
                                  "add_i64",
                                  "add_r32",
-                                 "add_r64" };
+                                 "add_r64",
+                                 "cswap_128" };
   return ((int)cmd >= 0 && cmd < num_fork_amo_cmds) ? names[cmd] : "?cmd?";
 }
 
@@ -1641,6 +1759,14 @@ static char* sprintf_rf_req(int loc, void* f_in)
     }
     break;
 
+  case fork_op_batch:
+    {
+      fork_batch_info_t* pb = (fork_batch_info_t*) f;
+      snprintf(&buf[bufcnt], sizeof(buf) - bufcnt, "%d calls, %d bytes",
+               (int) pb->cnt, (int) pb->len);
+    }
+    break;
+
   default:
     snprintf(&buf[bufcnt], sizeof(buf) - bufcnt, "(op %d)", (int) op);
     break;
@@ -1885,10 +2011,22 @@ void chpl_comm_init(int *argc_p, char ***argv_p)
   yield_during_comm = chpl_env_rt_get_bool("COMM_UGNI_YIELD_DURING_COMM",
                                            true);
 
+  fork_coalesce_enabled = chpl_env_rt_get_bool("COMM_UGNI_FORK_COALESCE",
+                                               false);
+
+  polling_spin_nsecs =
+    1000 * (uint64_t) chpl_env_rt_get_int("COMM_UGNI_POLLING_SPIN_USECS", 0);
+  polling_max_sleep_nsecs =
+    1000 * (uint64_t) chpl_env_rt_get_int("COMM_UGNI_POLLING_MAX_SLEEP_USECS",
+                                          polling_max_sleep_nsecs / 1000);
+  polling_stats = chpl_env_rt_get_bool("COMM_UGNI_POLLING_STATS", false);
+
   //
   // We can reach 16k memory regions on Aries.
   max_mem_regions = chpl_env_rt_get_int("COMM_UGNI_MAX_MEM_REGIONS", 16384);
 
+  mreg_lazy_bcast = chpl_env_rt_get_bool("COMM_UGNI_LAZY_MEMREG_BCAST", false);
+
   //
   // We have to create the local memory region table before the first
   // call to regMemAlloc() is made.  But that could come from the memory
@@ -1907,6 +2045,14 @@ void chpl_comm_init(int *argc_p, char ***argv_p)
   mr_mregs_supplement =
     (struct mregs_supp*) sys_calloc(max_mem_regions,
                                     sizeof(mr_mregs_supplement[0]));
+
+  //
+  // Make the registered heap now, if we'll have one, and start
+  // prefaulting it if asked to, so that overlaps memory and tasking
+  // init.  We wait for that in register_memory().
+  //
+  ensure_registered_heap_info_set();
+  chpl_comm_prefault_heap_start(registered_heap_start, registered_heap_size);
 }
 
 
@@ -2394,6 +2540,8 @@ void register_memory(void)
   //
   chpl_comm_mem_reg_tell(&gnr_addr, NULL);
 
+  chpl_comm_prefault_heap_wait();
+
   DBG_CATF(DBGF_MEMMAPS, debug_file, "/proc/self/maps", NULL);
   DBG_CATF(DBGF_MEMMAPS, debug_file, "/proc/self/numa_maps", NULL);
 
@@ -2600,6 +2748,7 @@ void register_memory(void)
 
       gnr_mreg_map[node] = gdp->gnr_mreg;
       mem_regions_all_entries[node]->mreg_cnt = gdp->mreg_cnt;
+      mem_regions_all_entries[node]->gen = 0;
       memcpy(&mem_regions_all_entries[node]->mregs, &gdp->mregs,
              gdata_mregs_size);
       mem_regions_all_my_entry_map[node] =
@@ -2611,6 +2760,19 @@ void register_memory(void)
     chpl_mem_free(my_gdata, 0, 0);
   }
 
+  if (mreg_lazy_bcast) {
+    // Must be directly communicable without proxy.
+    mreg_refresh_buf = (mem_region_table_t*)
+                         chpl_comm_mem_reg_allocMany(1, mem_regions_size,
+                                                     CHPL_RT_MD_COMM_PER_LOC_INFO,
+                                                     0, 0);
+    mreg_refresh_hdr = (mem_region_table_t*)
+                         chpl_comm_mem_reg_allocMany(1,
+                                                     sizeof(*mreg_refresh_hdr),
+                                                     CHPL_RT_MD_COMM_PER_LOC_INFO,
+                                                     0, 0);
+  }
+
   can_register_memory = true;
   chpl_atomic_thread_fence(memory_order_release);
 }
@@ -2781,15 +2943,102 @@ mem_region_t* mreg_for_remote_addr(void* addr, c_nodeid_t locale)
                   ((mr == NULL)
                    ? mem_regions_all_entries[locale]->mreg_cnt
                    : (mr - &mem_regions_all_entries[locale]->mregs[0] + 1)));
+    if (mr == NULL
+        && mreg_lazy_bcast
+        && locale != chpl_nodeID
+        && mreg_refresh_remote(locale)) {
+      mr = mrs[locale] = mreg_for_addr(addr, mem_regions_all_entries[locale]);
+    }
   }
   PERFSTATS_ADD(remote_mreg_nsecs, PERFSTATS_TELAPSED(pstStart));
   return mr;
 }
 
 
+static
+chpl_bool mreg_refresh_remote(c_nodeid_t locale)
+{
+  //
+  // Bring our copy of another node's region table up to date from that
+  // node's own copy, if it has changed since we last did this.  Treat
+  // the gen member there as a sequence lock, so that what we install
+  // is a consistent snapshot.  And check it again after installing,
+  // in case a broadcast update from that node came in while we were
+  // doing so and we overwrote it with older data.
+  //
+  mem_region_table_t* mine = mem_regions_all_entries[locale];
+  mem_region_table_t* theirs =
+    (mem_region_table_t*)
+    ((char*) mem_regions_all_my_entry_map[locale]
+     + ((ptrdiff_t) locale - chpl_nodeID) * (ptrdiff_t) mem_regions_size);
+  mem_region_t* remote_mr = &gnr_mreg_map[locale];
+  const size_t hdr_size = offsetof(mem_region_table_t, mregs);
+  chpl_bool changed = false;
+
+  if (pthread_mutex_lock(&mreg_refresh_mutex) != 0)
+    CHPL_INTERNAL_ERROR("cannot acquire mem region refresh lock");
+  const chpl_bool save_allow_task_yield = allow_task_yield;
+  allow_task_yield = false;
+
+  mem_region_t* local_buf_mr = mreg_for_local_addr(mreg_refresh_buf);
+  mem_region_t* local_hdr_mr = mreg_for_local_addr(mreg_refresh_hdr);
+  if (local_buf_mr == NULL || local_hdr_mr == NULL)
+    CHPL_INTERNAL_ERROR("mreg_refresh_remote(): staging isn't registered");
+
+  while (true) {
+    do_nic_get(mreg_refresh_hdr, locale, remote_mr, theirs, hdr_size,
+               local_hdr_mr);
+    const uint32_t gen = mreg_refresh_hdr->gen;
+    if (gen == mine->gen)
+      break;
+    if ((gen & 1) != 0)
+      continue;
+
+    const uint32_t cnt = mreg_refresh_hdr->mreg_cnt;
+    do_nic_get(mreg_refresh_buf, locale, remote_mr, theirs,
+               hdr_size + cnt * sizeof(mem_region_t), local_buf_mr);
+    do_nic_get(mreg_refresh_hdr, locale, remote_mr, theirs, hdr_size,
+               local_hdr_mr);
+    if (mreg_refresh_hdr->gen != gen)
+      continue;
+
+    DBG_P_LP(DBGF_MEMREG_BCAST,
+             "mreg_refresh_remote(%d): gen %u, cnt %u",
+             (int) locale, (unsigned) gen, (unsigned) cnt);
+    memcpy(mine->mregs, mreg_refresh_buf->mregs, cnt * sizeof(mem_region_t));
+    chpl_atomic_thread_fence(memory_order_release);
+    mine->mreg_cnt = cnt;
+    mine->gen = gen;
+    changed = true;
+
+    do_nic_get(mreg_refresh_hdr, locale, remote_mr, theirs, hdr_size,
+               local_hdr_mr);
+    if (mreg_refresh_hdr->gen == gen)
+      break;
+  }
+
+  allow_task_yield = save_allow_task_yield;
+  if (pthread_mutex_unlock(&mreg_refresh_mutex) != 0)
+    CHPL_INTERNAL_ERROR("cannot release mem region refresh lock");
+
+  return changed;
+}
+
+
 static
 void polling_task(void* ignore)
 {
+  const chpl_bool adaptive = (polling_spin_nsecs > 0);
+  const chpl_bool timed = adaptive || polling_stats;
+  uint64_t now = timed ? polling_nsecs() : 0;
+  uint64_t last_busy = now;
+  uint64_t sleep_nsecs = 1000;
+  uint64_t busy_nsecs = 0;
+  uint64_t idle_nsecs = 0;
+  uint64_t n_events = 0;
+
+  (void) chpl_topo_bindToReservedCPUs();
+
   set_up_for_polling();
 
   polling_task_running = true;
@@ -2797,19 +3046,33 @@ void polling_task(void* ignore)
   while (!polling_task_please_exit) {
     gni_cq_entry_t ev;
     gni_return_t   gni_rc;
+    const uint64_t then = now;
 
     //
     // Process CQ events due to PUT data arriving in the remote-fork
-    // request memory.
-    if (polling_task_blocking_cq)
+    // request memory.  When adapting, only block or sleep once we've
+    // been idle for a while.
+    //
+    const chpl_bool spinning = adaptive
+                               && now - last_busy < polling_spin_nsecs;
+    if (polling_task_blocking_cq && !spinning)
       gni_rc = GNI_CqWaitEvent(rf_cqh, 100, &ev);
     else
       gni_rc = GNI_CqGetEvent(rf_cqh, &ev);
 
     if (gni_rc == GNI_RC_SUCCESS)
       rf_handler(&ev);
-    else if (gni_rc == GNI_RC_NOT_DONE)
-      sched_yield();
+    else if (gni_rc == GNI_RC_NOT_DONE) {
+      if (!adaptive)
+        sched_yield();
+      else if (!spinning) {
+        struct timespec ts = { .tv_sec = sleep_nsecs / 1000000000UL,
+                               .tv_nsec = sleep_nsecs % 1000000000UL };
+        (void) nanosleep(&ts, NULL);
+        if ((sleep_nsecs *= 2) > polling_max_sleep_nsecs)
+          sleep_nsecs = polling_max_sleep_nsecs;
+      }
+    }
     else if (gni_rc == GNI_RC_TIMEOUT)
       ; // no-op
     else
@@ -2819,6 +3082,28 @@ void polling_task(void* ignore)
     // Process CQ events due to our request responses completing.
     //
     consume_all_outstanding_cq_events(cd_idx);
+
+    if (timed) {
+      now = polling_nsecs();
+      if (gni_rc == GNI_RC_SUCCESS) {
+        last_busy = now;
+        sleep_nsecs = 1000;
+        busy_nsecs += now - then;
+        n_events++;
+      } else {
+        idle_nsecs += now - then;
+      }
+    }
+  }
+
+  if (polling_stats) {
+    const uint64_t total_nsecs = busy_nsecs + idle_nsecs;
+    printf("%d: ugni polling task: %" PRIu64 " requests, "
+           "busy %.3f s, idle %.3f s (%.1f%% busy)\n",
+           (int) chpl_nodeID, n_events,
+           busy_nsecs / 1e9, idle_nsecs / 1e9,
+           (total_nsecs == 0) ? 0.0 : 100.0 * busy_nsecs / total_nsecs);
+    fflush(stdout);
   }
 
   polling_task_done = true;
@@ -2869,6 +3154,20 @@ void set_up_for_polling(void)
                                        CHPL_RT_MD_COMM_PER_LOC_INFO,
                                        0, 0);
 
+  if (fork_coalesce_enabled) {
+    fork_coalesce =
+      (fork_coalesce_t*) chpl_mem_allocMany(chpl_numNodes,
+                                            sizeof(fork_coalesce[0]),
+                                            CHPL_RT_MD_COMM_PER_LOC_INFO,
+                                            0, 0);
+    for (i = 0; i < chpl_numNodes; i++) {
+      atomic_init_spinlock_t(&fork_coalesce[i].lock);
+      fork_coalesce[i].posting = false;
+      fork_coalesce[i].pend.cnt = 0;
+      fork_coalesce[i].pend.len = 0;
+    }
+  }
+
   {
     typedef struct {
       c_nodeid_t   nodeID;
@@ -3520,7 +3819,23 @@ void chpl_comm_impl_regMemPostAlloc(void* p, size_t size)
   // within them yet anyway, and later when we do register them we may
   // be able to send just the entries and not the count again.
   //
-  if (mr_i < mem_regions_all_entries[chpl_nodeID]->mreg_cnt) {
+  if (mreg_lazy_bcast) {
+    //
+    // Other nodes will find out about this when they need to.
+    //
+    const uint32_t mreg_cnt_public =
+                     mem_regions_all_entries[chpl_nodeID]->mreg_cnt;
+
+    DBG_P_L(DBGF_MEMREG_BCAST,
+            "chpl_comm_impl_regMemPostAlloc(): entry %d, publish",
+            mr_i);
+    if (mr_i < mreg_cnt_public) {
+      regMemPublish(mr_i, 1, false /*send_mreg_cnt*/);
+    } else {
+      regMemPublish(mreg_cnt_public, mem_regions->mreg_cnt - mreg_cnt_public,
+                    true /*send_mreg_cnt*/);
+    }
+  } else if (mr_i < mem_regions_all_entries[chpl_nodeID]->mreg_cnt) {
     DBG_P_L(DBGF_MEMREG_BCAST,
             "chpl_comm_impl_regMemPostAlloc(): entry %d, bcast",
             mr_i);
@@ -3801,6 +4116,32 @@ void regMemUnlock(void) {
 }
 
 
+static inline
+void regMemPublish(int mr_i, int mr_cnt, chpl_bool send_mreg_cnt)
+{
+  //
+  // Update our own copy of our table, the one other nodes refresh from.
+  //
+  mem_region_table_t* pub = mem_regions_all_my_entry_map[chpl_nodeID];
+
+  pub->gen++;
+  chpl_atomic_thread_fence(memory_order_release);
+
+  if (mr_cnt > 0) {
+    memcpy((char*) &pub->mregs[mr_i],
+           (char*) &mem_regions->mregs[mr_i],
+           mr_cnt * sizeof(mem_region_t));
+  }
+
+  if (send_mreg_cnt) {
+    pub->mreg_cnt = mem_regions->mreg_cnt;
+  }
+
+  chpl_atomic_thread_fence(memory_order_release);
+  pub->gen++;
+}
+
+
 static inline
 void regMemBroadcast(int mr_i, int mr_cnt, chpl_bool send_mreg_cnt)
 {
@@ -3814,22 +4155,16 @@ void regMemBroadcast(int mr_i, int mr_cnt, chpl_bool send_mreg_cnt)
                        : MAX_CHAINED_PUT_LEN;       // using 1 V elems per node
   int vi;
 
+  //
+  // Update our own map in place.  Do this first, so that any node that
+  // sees one of the updates below and then refreshes its copy of our
+  // table from ours (see mreg_refresh_remote()) will get the same data.
+  //
+  regMemPublish(mr_i, mr_cnt, send_mreg_cnt);
+
   vi = 0;
   for (int ni = 0; ni < (int) chpl_numNodes; ni++) {
-    if (ni == chpl_nodeID) {
-      //
-      // Update our own map in place.
-      //
-      if (mr_cnt > 0) {
-        memcpy((char*) &mem_regions_all_my_entry_map[ni]->mregs[mr_i],
-               (char*) &mem_regions->mregs[mr_i],
-               mr_cnt * sizeof(mem_region_t));
-      }
-
-      if (send_mreg_cnt) {
-        mem_regions_all_my_entry_map[ni]->mreg_cnt = mem_regions->mreg_cnt;
-      }
-    } else {
+    if (ni != chpl_nodeID) {
       //
       // Update every other node's map remotely.
       //
@@ -4114,6 +4449,35 @@ void exit_any(int status)
 }
 
 
+static inline
+void rf_start_small_call(chpl_comm_on_bundle_t* f_c)
+{
+  //
+  // Run a fast on-stmt body right here, or start a task to run any
+  // other kind.  The task gets a copy of the bundle, so in either case
+  // the caller can release the request buffer when we return.
+  //
+  if (f_c->comm.fast) {
+    chpl_ftable_call(f_c->comm.fid, f_c);
+    indicate_done2(f_c->comm.caller, (rf_done_t*) f_c->comm.rf_done);
+  } else {
+    chpl_fn_p fn;
+
+    if (f_c->comm.rf_done != NULL) {
+      fn = (chpl_fn_p) fork_call_wrapper_blocking;
+    } else {
+      fn = (chpl_fn_p) chpl_ftable[f_c->comm.fid];
+    }
+    chpl_task_startMovedTask(f_c->comm.fid,
+                             fn,
+                             f_c,
+                             f_c->comm.size,
+                             f_c->comm.subloc,
+                             chpl_nullTaskID);
+  }
+}
+
+
 static
 void rf_handler(gni_cq_entry_t* ev)
 {
@@ -4140,29 +4504,34 @@ void rf_handler(gni_cq_entry_t* ev)
              (int) req_li, sprintf_rf_req(-1, f));
     {
       chpl_comm_on_bundle_t* f_c = (chpl_comm_on_bundle_t*) f;
+      chpl_bool fast = f_c->comm.fast;
 
-      if (f_c->comm.fast) {
-        chpl_ftable_call(f_c->comm.fid, f);
-        indicate_done2(f_c->comm.caller, (rf_done_t*) f_c->comm.rf_done);
-        // doesn't call release_req_buf, because that
-        // is handled on the sender side for fast forks
-      } else {
-        chpl_fn_p fn;
-
-        if (f_c->comm.rf_done != NULL) {
-          fn = (chpl_fn_p) fork_call_wrapper_blocking;
-        } else {
-          fn = (chpl_fn_p) chpl_ftable[f_c->comm.fid];
-        }
-        chpl_task_startMovedTask(f_c->comm.fid,
-                                 fn,
-                                 f_c,
-                                 f_c->comm.size,
-                                 f_c->comm.subloc,
-                                 chpl_nullTaskID);
+      rf_start_small_call(f_c);
 
+      // For fast forks the sender side releases the request buffer.
+      if (!fast)
         release_req_buf(req_li, req_cdi, req_rbi);
+    }
+    break;
+
+  case fork_op_batch:
+    DBG_P_LP(DBGF_RF, "forkFrom(%d) %s",
+             (int) req_li, sprintf_rf_req(-1, f));
+    {
+      //
+      // Coalesced small calls.  The sender doesn't know when any fast
+      // ones in here are done, so we always release the buffer here.
+      //
+      fork_batch_info_t* f_bt = &f->bt;
+      unsigned char* p = f_bt->space;
+
+      for (uint32_t i = 0; i < f_bt->cnt; i++) {
+        chpl_comm_on_bundle_t* f_c = (chpl_comm_on_bundle_t*) p;
+        p += FORK_BATCH_ITEM_SIZE(f_c->comm.size);
+        rf_start_small_call(f_c);
       }
+
+      release_req_buf(req_li, req_cdi, req_rbi);
     }
     break;
 
@@ -4485,6 +4854,23 @@ size_t do_amo_on_cpu(fork_amo_cmd_t cmd,
     }
     break;
 
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+  case cswap_128:
+    {
+      chpl_uint128_t opnd1Val;
+      chpl_uint128_t opnd2Val;
+      memcpy(&opnd1Val, opnd1, sizeof(opnd1Val));
+      memcpy(&opnd2Val, opnd2, sizeof(opnd2Val));
+      (void) atomic_compare_exchange_strong_uint128_t
+               ((atomic_uint128_t*) obj,
+                &opnd1Val,
+                opnd2Val);
+      memcpy(res, &opnd1Val, sizeof(opnd1Val));
+      res_size = sizeof(opnd1Val);
+    }
+    break;
+#endif
+
   default:
     CHPL_INTERNAL_ERROR("unsupported fork_amo command");
   }
@@ -5070,6 +5456,7 @@ void chpl_comm_put(void* addr, c_nodeid_t locale, void* raddr,
 
   chpl_comm_diags_verbose_rdma("put", locale, size, ln, fn, commID);
   chpl_comm_diags_incr(put);
+  chpl_comm_diags_size(put, locale, size);
 
   do_remote_put(addr, locale, raddr, size, NULL, may_proxy_true);
 }
@@ -5594,6 +5981,7 @@ void chpl_comm_get_unordered(void* addr, c_nodeid_t locale, void* raddr,
 
   chpl_comm_diags_verbose_rdma("unordered get", locale, size, ln, fn, commID);
   chpl_comm_diags_incr(get);
+  chpl_comm_diags_size(get, locale, size);
 
   do_remote_get_buff(addr, locale, raddr, size, may_proxy_true);
 }
@@ -5625,6 +6013,7 @@ void chpl_comm_put_unordered(void* addr, c_nodeid_t locale, void* raddr,
 
   chpl_comm_diags_verbose_rdma("unordered put", locale, size, ln, fn, commID);
   chpl_comm_diags_incr(put);
+  chpl_comm_diags_size(put, locale, size);
 
   do_remote_put_buff(addr, locale, raddr, size, may_proxy_true);
 }
@@ -5660,6 +6049,7 @@ void chpl_comm_get(void* addr, c_nodeid_t locale, void* raddr,
 
   chpl_comm_diags_verbose_rdma("get", locale, size, ln, fn, commID);
   chpl_comm_diags_incr(get);
+  chpl_comm_diags_size(get, locale, size);
 
   do_remote_get(addr, locale, raddr, size, may_proxy_true);
 }
@@ -6084,18 +6474,203 @@ void chpl_comm_get_strd(void* dstaddr_arg, size_t* dststrides,
 
 
 //
-// Non-blocking get interface
+// Non-blocking GET and PUT interface
+//
+// A transfer that can be done as a single NIC transaction is posted
+// and left in flight; the handle refers to its descriptor, and its
+// completion is seen when someone polls the completion queue of the
+// comm domain it was posted on.  This lets the remote cache and the
+// strided transfers keep a pipeline of transactions going.  Anything
+// else (unregistered remote memory, or a transfer too big for one
+// transaction) is done in blocking fashion and gets a NULL handle,
+// which is the "already complete" handle value.
+//
+
+static inline
+nb_xfer_t* nb_xfer_alloc(void)
+{
+  nb_xfer_t* x;
+
+  if ((x = nb_xfer_free_list) != NULL)
+    nb_xfer_free_list = x->next_free;
+  else
+    x = (nb_xfer_t*) chpl_mem_alloc(sizeof(*x),
+                                    CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0);
+
+  x->nb_desc.post_desc           = (gni_post_descriptor_t) { 0 };
+  x->nb_desc.post_desc.cq_mode   = GNI_CQMODE_GLOBAL_EVENT;
+  x->nb_desc.post_desc.dlvr_mode = GNI_DLVMODE_PERFORMANCE;
+  x->nb_desc.post_desc.post_id   = (uint64_t) (intptr_t) &x->nb_desc.done;
+  atomic_init_bool(&x->nb_desc.done, false);
+  x->tramp = NULL;
+  return x;
+}
+
+
+static inline
+void nb_xfer_post(c_nodeid_t locale, nb_xfer_t* x, chpl_bool do_rdma)
+{
+  x->nb_desc.cdi = do_rdma
+                   ? post_rdma(locale, &x->nb_desc.post_desc)
+                   : post_fma(locale, &x->nb_desc.post_desc);
+}
+
+
+static inline
+chpl_bool nb_xfer_done(nb_xfer_t* x)
+{
+  return atomic_load_explicit_bool(&x->nb_desc.done, memory_order_acquire);
+}
+
+
+//
+// Retire the completed transaction a handle refers to: deliver any
+// trampolined GET data, recycle the descriptor, and clear the handle.
+//
+static inline
+void nb_xfer_retire(chpl_comm_nb_handle_t* h)
+{
+  nb_xfer_t* x = (nb_xfer_t*) *h;
+
+  if (x->tramp != NULL) {
+    memcpy(x->tgt_addr, (char*) x->tramp + x->tramp_off, x->size);
+    get_buf_free(x->tramp);
+  }
+
+  x->next_free = nb_xfer_free_list;
+  nb_xfer_free_list = x;
+  *h = NULL;
+}
+
+
+//
+// Retire whichever of a batch of handles have completed.  Consecutive
+// handles were usually posted on the same comm domain, so we only poll
+// a completion queue again when that changes.  Returns the number of
+// handles retired, and sets *p_pending to the number still in flight.
 //
+static
+size_t nb_xfer_try_some(chpl_comm_nb_handle_t* h, size_t nhandles,
+                        size_t* p_pending)
+{
+  size_t retired = 0;
+  size_t pending = 0;
+  int polled_cdi = -1;
+  size_t i;
+
+  for (i = 0; i < nhandles; i++) {
+    nb_xfer_t* x = (nb_xfer_t*) h[i];
+
+    if (x == NULL)
+      continue;
+
+    if (!nb_xfer_done(x) && x->nb_desc.cdi != polled_cdi) {
+      polled_cdi = x->nb_desc.cdi;
+      consume_all_outstanding_cq_events(polled_cdi);
+    }
+
+    if (nb_xfer_done(x)) {
+      nb_xfer_retire(&h[i]);
+      retired++;
+    } else {
+      pending++;
+    }
+  }
+
+  *p_pending = pending;
+  return retired;
+}
+
+
 chpl_comm_nb_handle_t chpl_comm_get_nb(void* addr, c_nodeid_t locale,
                                        void* raddr, size_t size,
                                        int32_t commID, int ln, int32_t fn)
 {
+  mem_region_t*          local_mr;
+  mem_region_t*          remote_mr;
+  void*                  src_addr_xmit;
+  uint64_t               src_addr_xmit_off;
+  uint64_t               xmit_size;
+  chpl_bool              direct;
+  chpl_bool              do_rdma;
+  nb_xfer_t*             x;
+  gni_post_descriptor_t* post_desc;
 
   DBG_P_LP(DBGF_IFACE|DBGF_GETPUT, "IFACE chpl_comm_get_nb(%p, %d, %p, %zd)",
            addr, (int) locale, raddr, size);
 
-  chpl_comm_get(addr, locale, raddr, size, commID, ln, fn);
-  return NULL;
+  assert(addr != NULL);
+  assert(raddr != NULL);
+  if (size == 0)
+    return NULL;
+
+  if (locale == chpl_nodeID) {
+    memmove(addr, raddr, size);
+    return NULL;
+  }
+
+  //
+  // We can leave the GET in flight if the remote source is registered
+  // and it's a single transaction, either directly into the caller's
+  // target (registered, with the source and size aligned) or into a
+  // single trampoline buffer that we copy out of when it completes.
+  // See do_remote_get() for the details of these requirements.
+  //
+  src_addr_xmit     = UI64_TO_VP(ALIGN_32_DN(VP_TO_UI64(raddr)));
+  src_addr_xmit_off = VP_TO_UI64(raddr) - VP_TO_UI64(src_addr_xmit);
+  xmit_size         = ALIGN_32_UP(size + src_addr_xmit_off);
+  do_rdma           = (xmit_size >= rdma_threshold);
+
+  local_mr = mreg_for_local_addr(addr);
+  direct = (local_mr != NULL
+            && src_addr_xmit == raddr
+            && xmit_size == size);
+
+  if ((remote_mr = mreg_for_remote_addr(raddr, locale)) == NULL
+      || xmit_size > (do_rdma ? MAX_RDMA_TRANS_SZ : MAX_FMA_TRANS_SZ)
+      || (!direct && xmit_size > gbp_max_size)) {
+    PERFSTATS_INC(get_nb_b_cnt);
+    chpl_comm_get(addr, locale, raddr, size, commID, ln, fn);
+    return NULL;
+  }
+
+  // Communications callback support
+  if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_get_nb)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_get_nb, chpl_nodeID, locale,
+         .iu.comm={addr, raddr, size, commID, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+  }
+
+  chpl_comm_diags_verbose_rdma("get_nb", locale, size, ln, fn, commID);
+  chpl_comm_diags_incr(get_nb);
+  chpl_comm_diags_size(get, locale, size);
+
+  x = nb_xfer_alloc();
+  post_desc = &x->nb_desc.post_desc;
+
+  if (direct) {
+    post_desc->local_addr     = VP_TO_UI64(addr);
+    post_desc->local_mem_hndl = local_mr->mdh;
+  } else {
+    x->tramp                  = get_buf_alloc(xmit_size);
+    x->tgt_addr               = addr;
+    x->tramp_off              = src_addr_xmit_off;
+    x->size                   = size;
+    post_desc->local_addr     = VP_TO_UI64(x->tramp);
+    post_desc->local_mem_hndl = gnr_mreg->mdh;
+  }
+
+  post_desc->type            = do_rdma ? GNI_POST_RDMA_GET : GNI_POST_FMA_GET;
+  post_desc->remote_addr     = VP_TO_UI64(src_addr_xmit);
+  post_desc->remote_mem_hndl = remote_mr->mdh;
+  post_desc->length          = xmit_size;
+
+  PERFSTATS_INC(get_nb_cnt);
+  PERFSTATS_ADD(get_byte_cnt, xmit_size);
+
+  nb_xfer_post(locale, x, do_rdma);
+  return (chpl_comm_nb_handle_t) x;
 }
 
 
@@ -6103,11 +6678,68 @@ chpl_comm_nb_handle_t chpl_comm_put_nb(void* addr, c_nodeid_t locale,
                                        void* raddr, size_t size,
                                        int32_t commID, int ln, int32_t fn)
 {
+  mem_region_t*          local_mr = NULL;
+  mem_region_t*          remote_mr;
+  chpl_bool              do_rdma;
+  nb_xfer_t*             x;
+  gni_post_descriptor_t* post_desc;
+
   DBG_P_LP(DBGF_IFACE|DBGF_GETPUT, "IFACE chpl_comm_put_nb(%p, %d, %p, %zd)",
            addr, (int) locale, raddr, size);
 
-  chpl_comm_put(addr, locale, raddr, size, commID, ln, fn);
-  return NULL;
+  assert(addr != NULL);
+  assert(raddr != NULL);
+  if (size == 0)
+    return NULL;
+
+  if (locale == chpl_nodeID) {
+    memmove(raddr, addr, size);
+    return NULL;
+  }
+
+  //
+  // We can leave the PUT in flight if the remote target is registered
+  // and it's a single transaction.  As in do_remote_put(), it's an
+  // RDMA if it's big enough and the source is registered, else FMA.
+  //
+  do_rdma = (size >= rdma_threshold
+             && (local_mr = mreg_for_local_addr(addr)) != NULL);
+
+  if ((remote_mr = mreg_for_remote_addr(raddr, locale)) == NULL
+      || size > (do_rdma ? MAX_RDMA_TRANS_SZ : MAX_FMA_TRANS_SZ)) {
+    PERFSTATS_INC(put_nb_b_cnt);
+    chpl_comm_put(addr, locale, raddr, size, commID, ln, fn);
+    return NULL;
+  }
+
+  // Communications callback support
+  if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_put_nb)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_put_nb, chpl_nodeID, locale,
+         .iu.comm={addr, raddr, size, commID, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+  }
+
+  chpl_comm_diags_verbose_rdma("put_nb", locale, size, ln, fn, commID);
+  chpl_comm_diags_incr(put_nb);
+  chpl_comm_diags_size(put, locale, size);
+
+  x = nb_xfer_alloc();
+  post_desc = &x->nb_desc.post_desc;
+
+  post_desc->type            = do_rdma ? GNI_POST_RDMA_PUT : GNI_POST_FMA_PUT;
+  post_desc->local_addr      = VP_TO_UI64(addr);
+  if (do_rdma)
+    post_desc->local_mem_hndl = local_mr->mdh;
+  post_desc->remote_addr     = VP_TO_UI64(raddr);
+  post_desc->remote_mem_hndl = remote_mr->mdh;
+  post_desc->length          = size;
+
+  PERFSTATS_INC(put_nb_cnt);
+  PERFSTATS_ADD(put_byte_cnt, size);
+
+  nb_xfer_post(locale, x, do_rdma);
+  return (chpl_comm_nb_handle_t) x;
 }
 
 
@@ -6123,19 +6755,42 @@ int chpl_comm_test_nb_complete(chpl_comm_nb_handle_t h)
 
 void chpl_comm_wait_nb_some(chpl_comm_nb_handle_t* h, size_t nhandles)
 {
+  size_t pending;
+  chpl_bool do_yield;
+  uint64_t iters = 0;
+
   chpl_comm_diags_incr(wait_nb);
 
   PERFSTATS_INC(wait_nb_cnt);
+
+  //
+  // Wait until at least one completes, or none are left in flight.
+  // As in post_fma_and_wait(), yield now and then while we wait, so
+  // that other tasks (which may well be adding to this pipeline) can
+  // get something done.
+  //
+  if (nb_xfer_try_some(h, nhandles, &pending) > 0 || pending == 0)
+    return;
+
+  do_yield = should_yield_during_comm(true);
+  do {
+    if (do_yield && (iters & 0x3F) == 0) {
+      local_yield();
+    }
+    iters++;
+  } while (nb_xfer_try_some(h, nhandles, &pending) == 0 && pending > 0);
 }
 
 
 int chpl_comm_try_nb_some(chpl_comm_nb_handle_t* h, size_t nhandles)
 {
+  size_t pending;
+
   chpl_comm_diags_incr(try_nb);
 
   PERFSTATS_INC(try_nb_cnt);
 
-  return 0;
+  return nb_xfer_try_some(h, nhandles, &pending) > 0;
 }
 
 
@@ -6389,6 +7044,35 @@ DEFINE_CHPL_COMM_ATOMIC_CMPXCHG(real64, cswap_64, int_least64_t)
 
 #undef DEFINE_CHPL_COMM_ATOMIC_CMPXCHG
 
+#ifdef CHPL_HAVE_ATOMIC_UINT128
+//
+// Aries has no 128-bit AMOs, so a 128-bit compare-exchange is always
+// done by the target's processor, using a fork if it's remote.
+//
+DEFINE_DO_NON_NIC_AMO(uint128, cswap_128, chpl_uint128_t)
+
+void chpl_comm_atomic_cmpxchg_uint128(void* cmpval, void* xchgval,
+                                      int32_t loc, void* obj,
+                                      chpl_bool32* res,
+                                      memory_order succ, memory_order fail,
+                                      int ln, int32_t fn)
+{
+  DBG_P_LP(DBGF_IFACE|DBGF_AMO,
+           "IFACE chpl_comm_atomic_cmpxchg_uint128(%p, %p, %d, %p, %p)",
+           cmpval, xchgval, (int) loc, obj, res);
+
+  chpl_comm_diags_verbose_amo("amo cmpxchg", loc, ln, fn);
+  chpl_comm_diags_incr(amo);
+  chpl_uint128_t old_value;
+  chpl_uint128_t old_expected;
+  memcpy(&old_expected, cmpval, sizeof(old_expected));
+  do_non_nic_amo_cswap_128_uint128(obj, &old_value, &old_expected,
+                                   xchgval, loc);
+  *res = (chpl_bool32)(old_value == old_expected);
+  if (!*res) memcpy(cmpval, &old_value, sizeof(old_value));
+}
+#endif
+
 
 //
 // Atomic ops for ints:
@@ -6887,6 +7571,7 @@ void chpl_comm_execute_on(c_nodeid_t locale, c_sublocid_t subloc,
 
   chpl_comm_diags_verbose_executeOn("", locale, ln, fn);
   chpl_comm_diags_incr(execute_on);
+  chpl_comm_diags_size(execute_on, locale, arg_size);
 
   PERFSTATS_INC(fork_call_cnt);
   fork_call_common(locale, subloc, fid, arg, arg_size, false, true);
@@ -6914,6 +7599,7 @@ void chpl_comm_execute_on_nb(c_nodeid_t locale, c_sublocid_t subloc,
 
   chpl_comm_diags_verbose_executeOn("non-blocking", locale, ln, fn);
   chpl_comm_diags_incr(execute_on_nb);
+  chpl_comm_diags_size(execute_on, locale, arg_size);
 
   PERFSTATS_INC(fork_call_nb_cnt);
   fork_call_common(locale, subloc, fid, arg, arg_size, false, false);
@@ -6941,6 +7627,7 @@ void chpl_comm_execute_on_fast(c_nodeid_t locale, c_sublocid_t subloc,
 
   chpl_comm_diags_verbose_executeOn("fast", locale, ln, fn);
   chpl_comm_diags_incr(execute_on_fast);
+  chpl_comm_diags_size(execute_on, locale, arg_size);
 
   //
   // Note: the rf_handler() logic assumes that fast implies blocking.
@@ -6986,6 +7673,11 @@ void fork_call_common(c_nodeid_t locale, c_sublocid_t subloc,
              sprintf_rf_req(locale, arg));
     PERFSTATS_INC(fork_call_small_cnt);
 
+    if (fork_coalesce_enabled && arg_size <= FORK_COALESCE_MAX_ITEM) {
+      fork_coalesce_post(locale, arg, arg_size, blocking);
+      return;
+    }
+
     do_fork_post(locale, blocking, arg_size, (fork_base_info_t*) arg,
                  &cdi, &rbi);
 
@@ -7190,6 +7882,117 @@ void fork_shutdown(c_nodeid_t locale)
 }
 
 
+static
+void fork_coalesce_post(c_nodeid_t locale, chpl_comm_on_bundle_t* arg,
+                        size_t arg_size, chpl_bool blocking)
+{
+  fork_coalesce_t* fc = &fork_coalesce[locale];
+  rf_done_t        stack_rf_done;
+  rf_done_t*       rf_done = NULL;
+
+  //
+  // Blocking calls get their own completion flag, which the target
+  // sets when the call is done no matter how the request got there.
+  // As in do_fork_post(), it has to be in registered memory.
+  //
+  if (blocking) {
+    rf_done = (mreg_for_local_addr(&stack_rf_done) != NULL)
+              ? &stack_rf_done
+              : rf_done_alloc();
+    *rf_done = 0;
+  }
+  arg->comm.rf_done = rf_done;
+  chpl_atomic_thread_fence(memory_order_release);
+
+  //
+  // Add this request to the pending batch for the target locale.  If
+  // the batch is full, someone else must be sending it; let them.
+  //
+  size_t item_size = FORK_BATCH_ITEM_SIZE(arg_size);
+  chpl_bool must_post;
+  while (true) {
+    atomic_lock_spinlock_t(&fc->lock);
+    if (fc->pend.len + item_size <= FORK_BATCH_SPACE)
+      break;
+    atomic_unlock_spinlock_t(&fc->lock);
+    local_yield();
+  }
+  memcpy(&fc->pend.space[fc->pend.len], arg, arg_size);
+  fc->pend.len += item_size;
+  fc->pend.cnt++;
+  must_post = !fc->posting;
+  fc->posting = true;
+  atomic_unlock_spinlock_t(&fc->lock);
+
+  if (must_post)
+    fork_coalesce_drain(locale);
+
+  if (blocking) {
+    PERFSTATS_INC(wait_rfork_cnt);
+    while (! *(volatile rf_done_t*) rf_done) {
+      PERFSTATS_INC(lyield_in_wait_rfork_cnt);
+      local_yield();
+    }
+
+    if (rf_done != &stack_rf_done)
+      rf_done_free(rf_done);
+  }
+}
+
+
+static
+void fork_coalesce_drain(c_nodeid_t locale)
+{
+  fork_coalesce_t*  fc = &fork_coalesce[locale];
+  fork_batch_info_t batch;
+
+  //
+  // Send batches until no more requests have come in.  The requests
+  // already have their completion flags, so as far as do_fork_post()
+  // is concerned every one of these is nonblocking.
+  //
+  atomic_lock_spinlock_t(&fc->lock);
+  while (fc->pend.cnt > 0) {
+    batch.cnt = fc->pend.cnt;
+    batch.len = fc->pend.len;
+    memcpy(batch.space, fc->pend.space, fc->pend.len);
+    fc->pend.cnt = 0;
+    fc->pend.len = 0;
+    atomic_unlock_spinlock_t(&fc->lock);
+
+    chpl_comm_on_bundle_t* f_c = (chpl_comm_on_bundle_t*) batch.space;
+    if (batch.cnt == 1 && !f_c->comm.fast) {
+      //
+      // Just one, and the target can release the request buffer for it,
+      // so send it as it is.
+      //
+      do_fork_post(locale, false /*blocking*/, f_c->comm.size,
+                   (fork_base_info_t*) f_c, NULL, NULL);
+    } else {
+      batch.b = (fork_base_info_t) { .op = fork_op_batch,
+                                     .caller = chpl_nodeID,
+                                     .rf_done = NULL, };
+      DBG_SET_SEQ(batch.b.seq);
+      DBG_P_LP(DBGF_RF, "forkTo(%d) %s",
+               (int) locale,
+               sprintf_rf_req(locale, &batch));
+      PERFSTATS_INC(fork_batch_cnt);
+      PERFSTATS_ADD(fork_batched_call_cnt, batch.cnt);
+      chpl_comm_diags_incr(am_batches);
+      chpl_comm_diags_add(am_batched_reqs, batch.cnt);
+
+      do_fork_post(locale, false /*blocking*/,
+                   offsetof(fork_batch_info_t, space) + batch.len,
+                   &batch.b, NULL, NULL);
+    }
+
+    atomic_lock_spinlock_t(&fc->lock);
+  }
+  fc->posting = false;
+  atomic_unlock_spinlock_t(&fc->lock);
+}
+
+
 static
 void do_fork_post(c_nodeid_t locale,
                   chpl_bool blocking,
@@ -33,8 +33,6 @@
 #include <string.h>
 
 
-#define HASHSIZE 101
-
 typedef struct _configVarType { /* table entry */
   char* varName;
   const char* moduleName;
@@ -42,16 +40,33 @@ typedef struct _configVarType { /* table entry */
   char* setValue;
   int private;
 
-  struct _configVarType* nextInBucket;
   struct _configVarType* nextInstalled;
 } configVarType;
 
 
-/* hash table */
-static configVarType* configVarTable[HASHSIZE];
+//
+// Open-addressed hash table with linear probing, keyed on the variable
+// name alone so that unqualified lookups can find every module's
+// config of that name.  Each slot caches the name's full hash so most
+// mismatches cost no strcmp().  The table doubles whenever it gets half
+// full, so lookups stay O(1) however many configs a program has.
+//
+typedef struct {
+  unsigned hash;
+  configVarType* configVar;  // NULL if the slot is empty
+} configVarSlot;
+
+static configVarSlot* configVarTable = NULL;
+static unsigned configVarTableSize = 0;  // a power of 2
+static unsigned numConfigVars = 0;
+
 static configVarType* firstInTable = NULL;
 static configVarType* lastInTable = NULL;
 
+// Configs are installed module by module, so interning module names
+// only needs to remember the last one.
+static const char* lastModuleName = NULL;
+
 static configVarType _ambiguousConfigVar;
 static configVarType* ambiguousConfigVar = &_ambiguousConfigVar;
 
@@ -73,96 +88,56 @@ static void parseModVarName(char* modVarName, const char** moduleName,
 }
 
 
-/* This function parses a config var of type string, and sets its value in
-   the hash table.
-*/
-static int aParsedString(FILE* argFile, char* setConfigBuffer,
-                         int32_t lineno, int32_t filename) {
-  char* equalsSign = strchr(setConfigBuffer, '=');
-  int stringLength = strlen(setConfigBuffer);
-  char firstChar;
-  char* value;
-  char lastChar;
-  const char* moduleName;
-  char* varName;
-
-  if (!equalsSign || !(equalsSign + 1)) {
-    return 0;
+void initConfigVarTable(void) {
+  if (configVarTable != NULL) {
+    chpl_mem_free(configVarTable, 0, 0);
   }
+  configVarTable = NULL;
+  configVarTableSize = 0;
+  numConfigVars = 0;
+}
 
-  firstChar = equalsSign[1];
-  if ((firstChar != '"') && (firstChar != '\'')) {
-    return 0;
-  }
 
-  value = equalsSign + 2;
-  *equalsSign = '\0';
-  lastChar = setConfigBuffer[stringLength - 1];
-
-  parseModVarName(setConfigBuffer, &moduleName, &varName);
-
-  if ((firstChar != lastChar) || (strlen(value) == 0)) {
-    int nextChar = fgetc(argFile);
-    do {
-      switch (nextChar) {
-      case EOF:
-        {
-          char* message;
-          setConfigBuffer[stringLength] = '\0';
-          message = chpl_glom_strings(2, "Found end of file while reading string: ",
-                                      equalsSign + 1);
-          chpl_error(message, lineno, filename);
-          break;
-        }
-      case '\n':
-        {
-          char* message;
-          setConfigBuffer[stringLength] = '\0';
-          message = chpl_glom_strings(2, "Found newline while reading string: ",
-                                      equalsSign + 1);
-          chpl_error(message, lineno, filename);
-          break;
-        }
-      default:
-        {
-          if (stringLength >= _default_string_length - 1) {
-            char dsl[1024];
-            char* message;
-            sprintf(dsl, "%d", _default_string_length);
-            message = chpl_glom_strings(2, "String exceeds the maximum string length of ",
-                                        dsl);
-            chpl_error(message, lineno, filename);
-          }
-          setConfigBuffer[stringLength] = nextChar;
-          stringLength++;
-          nextChar = fgetc(argFile);
-        }
-      }
-    } while (nextChar != firstChar);
-  } else {
-    stringLength--;
+/* hashing function (FNV-1a) */
+static unsigned hash(const char* varName) {
+  unsigned hashValue = 2166136261u;
+  for (; *varName != '\0'; varName++) {
+    hashValue = (hashValue ^ (unsigned char) *varName) * 16777619u;
   }
-  setConfigBuffer[stringLength] = '\0';
-  initSetValue(varName, value, moduleName, lineno, filename);
-  return 1;
+  return hashValue;
 }
 
 
-void initConfigVarTable(void) {
-  int i;
-  for (i = 0; i < HASHSIZE; i++) {
-    configVarTable[i] = NULL;
-  }
+static void insertInTable(configVarSlot* table, unsigned size,
+                          unsigned hashValue, configVarType* configVar) {
+  unsigned i;
+  for (i = hashValue & (size - 1);
+       table[i].configVar != NULL;
+       i = (i + 1) & (size - 1))
+    ;
+  table[i].hash = hashValue;
+  table[i].configVar = configVar;
 }
 
 
-/* hashing function */
-static unsigned hash(const char* varName) {
-  unsigned hashValue;
-  for (hashValue = 0; *varName != '\0'; varName++) {
-    hashValue = *varName + 31 * hashValue;
+static void growConfigVarTable(void) {
+  unsigned newSize = (configVarTableSize == 0) ? 256 : 2 * configVarTableSize;
+  configVarSlot* newTable = (configVarSlot*)
+    chpl_mem_allocManyZero(newSize, sizeof(configVarSlot),
+                           CHPL_RT_MD_CF_TABLE_DATA, 0, 0);
+  unsigned i;
+
+  for (i = 0; i < configVarTableSize; i++) {
+    if (configVarTable[i].configVar != NULL) {
+      insertInTable(newTable, newSize, configVarTable[i].hash,
+                    configVarTable[i].configVar);
+    }
+  }
+  if (configVarTable != NULL) {
+    chpl_mem_free(configVarTable, 0, 0);
   }
-  return hashValue % HASHSIZE;
+  configVarTable = newTable;
+  configVarTableSize = newSize;
 }
 
 
@@ -236,19 +211,25 @@ void printConfigVarTable(void) {
 
 static configVarType* lookupConfigVar(const char* moduleName,
                                       const char* varName) {
-  configVarType* configVar = NULL;
   configVarType* foundConfigVar = NULL;
   unsigned hashValue;
+  unsigned i;
   int numTimesFound = 0;
+
+  if (configVarTableSize == 0) {
+    return NULL;
+  }
   hashValue = hash(varName);
 
-  /* This loops walks through the list of configuration variables
-     hashed to this location in the table. */
-  for (configVar = configVarTable[hashValue];
-       configVar != NULL;
-       configVar = configVar->nextInBucket) {
+  /* This loop walks through the run of slots starting where this
+     name hashes, which holds all the configs with this name. */
+  for (i = hashValue & (configVarTableSize - 1);
+       configVarTable[i].configVar != NULL;
+       i = (i + 1) & (configVarTableSize - 1)) {
+    configVarType* configVar = configVarTable[i].configVar;
 
-    if (strcmp(configVar->varName, varName) == 0) {
+    if (configVarTable[i].hash == hashValue &&
+        strcmp(configVar->varName, varName) == 0) {
       if (strcmp(moduleName, "") == 0) {
         // only public configs can be referred to in an unqualified manner
         if (!configVar->private) {
@@ -324,22 +305,29 @@ const char* lookupSetValue(const char* varName, const char* moduleName) {
 
 void installConfigVar(const char* varName, const char* value,
                       const char* moduleName, int private) {
-  unsigned hashValue;
   configVarType* configVar = (configVarType*)
     chpl_mem_allocMany(1, sizeof(configVarType), CHPL_RT_MD_CF_TABLE_DATA, 0, 0);
 
-  hashValue = hash(varName);
-  configVar->nextInBucket = configVarTable[hashValue];
+  if (2 * (numConfigVars + 1) > configVarTableSize) {
+    growConfigVarTable();
+  }
+  insertInTable(configVarTable, configVarTableSize, hash(varName), configVar);
+  numConfigVars++;
+
   configVar->nextInstalled = NULL;
-  configVarTable[hashValue] = configVar;
   if (firstInTable == NULL) {
     firstInTable = configVar;
   } else {
     lastInTable->nextInstalled = configVar;
   }
   lastInTable = configVar;
+
+  if (lastModuleName == NULL || strcmp(lastModuleName, moduleName) != 0) {
+    lastModuleName = chpl_glom_strings(1, moduleName);
+  }
+
   configVar->varName = chpl_glom_strings(1, varName);
-  configVar->moduleName = chpl_glom_strings(1, moduleName);
+  configVar->moduleName = lastModuleName;
   configVar->defaultValue = chpl_glom_strings(1, value);
   configVar->setValue = NULL;
   configVar->private = private;
@@ -433,64 +421,166 @@ int handlePossibleConfigVar(int* argc, char* argv[], int argnum,
   return retval;
 }
 
-// TODO: Change all the 0 linenos below into real line numbers
-void parseConfigFile(const char* configFilename,
-                     int32_t lineno, int32_t filename) {
+//
+// Reads all of a config file into memory, so parsing it doesn't have to
+// go through stdio a character or token at a time.
+//
+static char* readConfigFile(const char* configFilename,
+                            int32_t lineno, int32_t filename) {
   FILE* argFile = fopen(configFilename, "r");
+  size_t size = 0;
+  size_t cap = 0;
+  char* buf = NULL;
+
   if (!argFile) {
     char* message = chpl_glom_strings(2, "Unable to open ", configFilename);
     chpl_error(message, lineno, filename);
   }
+
+  do {
+    if (cap - size < 2) {
+      cap = (cap == 0) ? 64 * 1024 : 2 * cap;
+      buf = chpl_mem_realloc(buf, cap, CHPL_RT_MD_CFG_ARG_COPY_DATA,
+                             lineno, filename);
+    }
+    size += fread(buf + size, 1, cap - size - 1, argFile);
+  } while (!feof(argFile) && !ferror(argFile));
+
+  if (ferror(argFile)) {
+    char* message = chpl_glom_strings(2, "Unable to read ", configFilename);
+    chpl_error(message, lineno, filename);
+  }
+  fclose(argFile);
+
+  buf[size] = '\0';
+  return buf;
+}
+
+
+static int isConfigSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+         c == '\v' || c == '\f';
+}
+
+
+//
+// Skips white space, counting lines, and returns the start of the next
+// token, or NULL at the end of the buffer.
+//
+static char* nextConfigToken(char* p, int32_t* line) {
+  for (; isConfigSpace(*p); p++) {
+    if (*p == '\n') {
+      (*line)++;
+    }
+  }
+  return (*p == '\0') ? NULL : p;
+}
+
+
+//
+// Config file entries are white space separated.  An entry is
+// [module.]name=value, or [module.]name followed by its value as the
+// next entry.  A value that starts with a quote runs to the matching
+// quote, and may contain white space but not newlines.  A '#' at the
+// start of an entry comments out the rest of the line.
+//
+void parseConfigFile(const char* configFilename,
+                     int32_t lineno, int32_t filename) {
+  char* buf = readConfigFile(configFilename, lineno, filename);
+  const int32_t fileIdx = CHPL_FILE_IDX_SAVED_FILENAME;
+  int32_t line = 1;
+  char* p = buf;
+
   chpl_saveFilename(configFilename); // CHPL_FILE_IDX_SAVED_FILENAME will now
                                      // give us configFilename
-  while (!feof(argFile)) {
-    int numScans = 0;
-    char setConfigBuffer[_default_string_length];
-    numScans = fscanf(argFile, _default_format_read_string, setConfigBuffer);
-    if (numScans == 1) {
-     if (*setConfigBuffer == '#') {
-        if (!feof(argFile)) {
-          do {
-            char ch = fgetc(argFile);
-            if (ch == '\n')
-              break;
-          } while (!feof(argFile));
-        }
-      } else if (!aParsedString(argFile, setConfigBuffer, 0,
-                                CHPL_FILE_IDX_SAVED_FILENAME)) {
-        char* equalsSign;
-        const char* moduleName;
-        char* varName;
-        configVarType *configVar =
-            breakIntoPiecesAndLookup(setConfigBuffer, &equalsSign, &moduleName,
-                                     &varName, 0, CHPL_FILE_IDX_SAVED_FILENAME);
-        if (configVar == NULL) {
-          handleUnexpectedConfigVar(moduleName, varName, 0,
-                                    CHPL_FILE_IDX_SAVED_FILENAME);
-        } else {
-          char* value = equalsSign + 1;
-          if (equalsSign && *value) {
-            initSetValue(varName, value, moduleName, 0,
-                         CHPL_FILE_IDX_SAVED_FILENAME);
-          } else {
-            char configValBuffer[_default_string_length];
-            numScans =
-                fscanf(argFile, _default_format_read_string, configValBuffer);
-            if (numScans != 1) {
-              char *message =
-                  chpl_glom_strings(3, "Configuration variable '", varName,
-                                    "' is missing its initialization value");
-              chpl_error(message, 0, CHPL_FILE_IDX_SAVED_FILENAME);
-            } else {
-              initSetValue(varName, configValBuffer, moduleName, 0,
-                           CHPL_FILE_IDX_SAVED_FILENAME);
-            }
+
+  while ((p = nextConfigToken(p, &line)) != NULL) {
+    char* tok = p;
+    char* end = tok;
+    char* equalsSign;
+    const char* moduleName;
+    char* varName;
+    int32_t tokLine = line;
+
+    while (*end != '\0' && !isConfigSpace(*end)) {
+      end++;
+    }
+
+    if (*tok == '#') {
+      while (*p != '\0' && *p != '\n') {
+        p++;
+      }
+      continue;
+    }
+
+    equalsSign = memchr(tok, '=', end - tok);
+    if (equalsSign && equalsSign + 1 < end &&
+        (equalsSign[1] == '"' || equalsSign[1] == '\'')) {
+      const char quote = equalsSign[1];
+      char* value = equalsSign + 2;
+      char* valueEnd;
+
+      if (end[-1] == quote && end > value) {
+        valueEnd = end - 1;
+        p = end;
+      } else {
+        for (valueEnd = end; *valueEnd != quote; valueEnd++) {
+          if (*valueEnd == '\0' || *valueEnd == '\n') {
+            const char* what = (*valueEnd == '\0')
+                               ? "Found end of file while reading string: "
+                               : "Found newline while reading string: ";
+            *valueEnd = '\0';
+            chpl_error(chpl_glom_strings(2, what, equalsSign + 1),
+                       tokLine, fileIdx);
           }
         }
+        p = valueEnd + 1;
       }
+
+      *equalsSign = '\0';
+      *valueEnd = '\0';
+      parseModVarName(tok, &moduleName, &varName);
+      initSetValue(varName, value, moduleName, tokLine, fileIdx);
+      continue;
+    }
+
+    p = end;
+    if (*p != '\0') {
+      if (*p == '\n') {
+        line++;
+      }
+      *p++ = '\0';
+    }
+
+    configVarType* configVar =
+      breakIntoPiecesAndLookup(tok, &equalsSign, &moduleName, &varName,
+                               tokLine, fileIdx);
+    if (configVar == NULL) {
+      handleUnexpectedConfigVar(moduleName, varName, tokLine, fileIdx);
+    } else if (equalsSign && equalsSign[1] != '\0') {
+      initSetValue(varName, equalsSign + 1, moduleName, tokLine, fileIdx);
+    } else {
+      char* value = nextConfigToken(p, &line);
+      int32_t valueLine = line;
+      if (value == NULL) {
+        char *message =
+          chpl_glom_strings(3, "Configuration variable '", varName,
+                            "' is missing its initialization value");
+        chpl_error(message, tokLine, fileIdx);
+      }
+      for (p = value; *p != '\0' && !isConfigSpace(*p); p++)
+        ;
+      if (*p != '\0') {
+        if (*p == '\n') {
+          line++;
+        }
+        *p++ = '\0';
+      }
+      initSetValue(varName, value, moduleName, valueLine, fileIdx);
     }
   }
-  fclose(argFile);
+
+  chpl_mem_free(buf, lineno, filename);
 }
 
 
@@ -51,7 +51,10 @@ static char** chpl_launch_create_argv(const char *launch_cmd,
   largv[5] = (char *) "-c";
   largv[6] = (char *) "0";
   largv[7] = (char*) "-E";
-  largv[8] = chpl_get_enviro_keys(',');
+  // With an env file, the program only needs to be told where it is.
+  largv[8] = (chpl_launcher_write_env_file() != NULL)
+             ? (char*) "CHPL_RT_ENV_FILE"
+             : chpl_get_enviro_keys(',');
   largc += chpl_get_charset_env_args(&largv[largc]);
 
   return chpl_bundle_exec_args(argc, argv, largc, largv);
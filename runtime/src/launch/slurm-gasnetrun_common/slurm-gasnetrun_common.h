@@ -146,8 +146,11 @@ static int propagate_environment(char* buf)
 
   // Indiscriminately propagate all environment variables.
   // We could do this more selectively, but we would be likely
-  // to leave out something important.
-  char *enviro_keys = chpl_get_enviro_keys(',');
+  // to leave out something important.  With an env file, the
+  // program only needs to be told where it is.
+  char *enviro_keys = (chpl_launcher_write_env_file() != NULL)
+                      ? (char *) "CHPL_RT_ENV_FILE"
+                      : chpl_get_enviro_keys(',');
   if (enviro_keys)
     len += sprintf(buf, " -E '%s'", enviro_keys);
 
@@ -187,6 +187,14 @@ static char* chpl_launch_create_command(int argc, char* argv[],
   char stdoutFileNoFmt    [MAX_COM_LEN];
   char tmpStdoutFileNoFmt [MAX_COM_LEN];
 
+  // At scale, having every node load the binary from a shared file
+  // system can dominate startup.  With CHPL_LAUNCHER_SLURM_BCAST set,
+  // srun copies it to each node using Slurm's own fan-out instead.  The
+  // copy goes to <tmpDir>/ unless the env var gives a destination path.
+  // This only works if srun runs the binary directly, not a wrapper.
+  char* bcastEnv = getenv("CHPL_LAUNCHER_SLURM_BCAST");
+  char bcastOpt[MAX_COM_LEN];
+
   // command line walltime takes precedence over env var
   if (!walltime) {
     walltime = getenv("CHPL_LAUNCHER_WALLTIME");
@@ -230,6 +238,18 @@ static char* chpl_launch_create_command(int argc, char* argv[],
   
   chpl_compute_real_binary_name(argv[0]);
 
+  bcastOpt[0] = '\0';
+  if (bcastEnv != NULL) {
+    if (chpl_get_real_binary_wrapper()[0] != '\0') {
+      chpl_warning("CHPL_LAUNCHER_SLURM_BCAST is ignored when the binary "
+                   "is run through a wrapper", 0, 0);
+    } else if (strchr(bcastEnv, '/') != NULL) {
+      snprintf(bcastOpt, sizeof(bcastOpt), "--bcast=%s ", bcastEnv);
+    } else {
+      snprintf(bcastOpt, sizeof(bcastOpt), "--bcast=%s/ ", tmpDir);
+    }
+  }
+
   if (debug) {
     mypid = 0;
   } else {
@@ -328,8 +348,8 @@ static char* chpl_launch_create_command(int argc, char* argv[],
     }
 
     // add the srun command and the (possibly wrapped) binary name.
-    fprintf(slurmFile, "srun --kill-on-bad-exit %s %s ",
-        chpl_get_real_binary_wrapper(), chpl_get_real_binary_name());
+    fprintf(slurmFile, "srun --kill-on-bad-exit %s%s %s ",
+        bcastOpt, chpl_get_real_binary_wrapper(), chpl_get_real_binary_name());
 
     // add any arguments passed to the launcher to the binary 
     for (i=1; i<argc; i++) {
@@ -423,6 +443,9 @@ static char* chpl_launch_create_command(int argc, char* argv[],
       len += sprintf(iCom+len, "--account=%s ", account);
     }
     
+    // copy the binary to the nodes, if requested
+    len += sprintf(iCom+len, "%s", bcastOpt);
+
     // add the (possibly wrapped) binary name
     len += sprintf(iCom+len, "%s %s ",
         chpl_get_real_binary_wrapper(), chpl_get_real_binary_name());
@@ -25,12 +25,17 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
 
 #include "chpl-comm.h"
+#include "chpl-env.h"
 #include "chpl-linefile-support.h"
 #include "chpl-mem.h"
 #include "chpl-mem-desc.h"
 #include "chplmemtrack.h"
+#include "chpl-topo.h"
+#include "chplsys.h"
 #include "chpltypes.h"
 #include "error.h"
 
@@ -56,6 +61,34 @@ static struct shared_heap {
 } heap;
 
 
+//
+// NUMA arena groups.  On nodes with more than one NUMA domain we create
+// a group of extra arenas for each domain.  Chunks handed to them are
+// bound to their domain's memory, and each thread that is bound to a
+// single domain allocates from an arena in that domain's group.
+//
+int chpl_je_numa_arenas = 0;
+__thread int chpl_je_thread_arena_chosen = 0;
+
+static unsigned numa_arena_base;        // first NUMA arena index
+static unsigned numa_arenas_per_domain;
+static int numa_num_domains;
+static unsigned numa_next[64];          // round-robin within each group
+
+#define NUMA_MAX_DOMAINS ((int) (sizeof(numa_next) / sizeof(numa_next[0])))
+
+static inline c_sublocid_t numa_arena_domain(unsigned arena_ind) {
+  if (!chpl_je_numa_arenas
+      || arena_ind < numa_arena_base
+      || arena_ind >= numa_arena_base
+                      + numa_num_domains * numa_arenas_per_domain) {
+    return c_sublocid_any;
+  }
+  return (c_sublocid_t) ((arena_ind - numa_arena_base)
+                         / numa_arenas_per_domain);
+}
+
+
 // compute aligned index into our shared heap, alignment must be a power of 2
 static inline void* alignHelper(void* base_ptr, size_t offset, size_t alignment) {
   uintptr_t p;
@@ -129,6 +162,18 @@ static void* chunk_alloc(void *chunk, size_t size, size_t alignment, bool *zero,
       return NULL;
     }
 
+    //
+    // If this is for a NUMA arena, bind the new memory to its domain
+    // first, so the first-touch below doesn't put it wherever we happen
+    // to be running.
+    //
+    {
+      c_sublocid_t subloc = numa_arena_domain(arena_ind);
+      if (subloc != c_sublocid_any) {
+        chpl_topo_setMemLocality(cur_chunk_base, size, true, subloc);
+      }
+    }
+
     //
     // Localize the new memory via first-touch, by storing to each page.
     // This will give the memory affinity to the NUMA domain (if any)
@@ -139,6 +184,8 @@ static void* chunk_alloc(void *chunk, size_t size, size_t alignment, bool *zero,
     for (int i = 0; i < size; i += heap_page_size) {
       ((char*) cur_chunk_base)[i] = 0;
     }
+    chpl_mem_checkNumaPlacement(cur_chunk_base, size,
+                                numa_arena_domain(arena_ind));
 
     chpl_comm_regMemPostAlloc(cur_chunk_base, size);
 
@@ -185,6 +232,99 @@ static bool null_merge(void *chunk_a, size_t size_a, void *chunk_b, size_t size_
   return true;
 }
 
+// When we aren't providing the memory ourselves, NUMA arenas use the
+// default hooks but bind the chunks they get to their domain.  (With a
+// fixed heap we don't rebind anything, because that memory may already
+// be registered with the network.)
+static chunk_hooks_t default_hooks;
+
+static void* numa_chunk_alloc(void *chunk, size_t size, size_t alignment, bool *zero, bool *commit, unsigned arena_ind) {
+  void* p = default_hooks.alloc(chunk, size, alignment, zero, commit, arena_ind);
+  c_sublocid_t subloc = numa_arena_domain(arena_ind);
+
+  if (p != NULL && subloc != c_sublocid_any) {
+    chpl_topo_setMemLocality(p, size, true, subloc);
+  }
+  return p;
+}
+
+//
+// Hugepages for the large-allocation arena, when the comm layer isn't
+// providing the memory (CHPL_RT_MEM_HUGEPAGES).  With "thp" we use the
+// default hooks and advise the kernel to back the chunks with
+// transparent hugepages.  With "hugetlb" we map the chunks from the
+// hugetlb pool ourselves, falling back to ordinary pages (with the THP
+// advice) when the pool is empty.  Since hugetlb mappings can't be
+// partially unmapped or purged, in that mode we keep every chunk we map
+// and let jemalloc reuse it.
+//
+enum hugepage_mode {HP_NONE, HP_THP, HP_HUGETLB};
+static enum hugepage_mode hp_mode = HP_NONE;
+static size_t hp_size;
+
+static size_t hp_chunk_bytes;    // bytes in large-arena chunks we've made
+static size_t hp_hugetlb_bytes;  // .. of which are from the hugetlb pool
+
+static void* hp_map(size_t size, size_t alignment, int flags) {
+  // Over-map by the alignment, then trim to an aligned piece.
+  size_t map_size = size + alignment;
+  unsigned char* p;
+  unsigned char* aligned;
+
+  p = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+  if (p == MAP_FAILED) {
+    return NULL;
+  }
+  aligned = alignHelper(p, 0, alignment);
+  if (aligned > p) {
+    (void) munmap(p, aligned - p);
+  }
+  if (aligned + size < p + map_size) {
+    (void) munmap(aligned + size, (p + map_size) - (aligned + size));
+  }
+  return aligned;
+}
+
+static void* hp_chunk_alloc(void *chunk, size_t size, size_t alignment, bool *zero, bool *commit, unsigned arena_ind) {
+  void* p = NULL;
+
+  if (hp_mode == HP_HUGETLB) {
+    // we can't place a chunk at a requested address
+    if (chunk != NULL) {
+      return NULL;
+    }
+#ifdef MAP_HUGETLB
+    if (size % hp_size == 0 && alignment % hp_size == 0) {
+      if ((p = hp_map(size, alignment, MAP_HUGETLB)) != NULL) {
+        __atomic_fetch_add(&hp_hugetlb_bytes, size, __ATOMIC_RELAXED);
+      }
+    }
+#endif
+    if (p == NULL) {
+      p = hp_map(size, alignment, 0);
+    }
+    // fresh anonymous mappings are zeroed and committed
+    *zero = true;
+    *commit = true;
+  } else {
+    p = default_hooks.alloc(chunk, size, alignment, zero, commit, arena_ind);
+  }
+
+  if (p == NULL) {
+    return NULL;
+  }
+
+  (void) chpl_sys_adviseHugePages(p, size);
+  __atomic_fetch_add(&hp_chunk_bytes, size, __ATOMIC_RELAXED);
+  return p;
+}
+
+static bool hp_chunk_purge(void *chunk, size_t size, size_t offset, size_t length, unsigned arena_ind) {
+  // this fails (returns true) for hugetlb pages, which is what we want
+  return madvise((unsigned char*) chunk + offset, length, MADV_DONTNEED) != 0;
+}
+
 #endif // ifdef USE_JE_CHUNK_HOOKS
 
 // *** End chunk hook replacements *** //
@@ -276,6 +416,145 @@ static void replaceChunkHooks(void) {
 
 }
 
+#ifdef USE_JE_CHUNK_HOOKS
+static void setupHugePages(void) {
+  const char* mode = chpl_env_rt_get("MEM_HUGEPAGES", "none");
+  chunk_hooks_t hooks;
+  char path[128];
+  size_t sz;
+
+  if (heap.type != NONE) {
+    // the comm layer is already responsible for the page size
+    return;
+  }
+
+  if (strcasecmp(mode, "thp") == 0) {
+    hp_mode = HP_THP;
+  } else if (strcasecmp(mode, "hugetlb") == 0) {
+    if ((hp_size = chpl_sys_getHugePageSize()) == 0) {
+      chpl_warning("CHPL_RT_MEM_HUGEPAGES=hugetlb, but the system has no "
+                   "hugetlb page size; using transparent hugepages", 0, 0);
+      hp_mode = HP_THP;
+    } else {
+      hp_mode = HP_HUGETLB;
+    }
+  } else if (strcasecmp(mode, "none") != 0) {
+    chpl_warning("CHPL_RT_MEM_HUGEPAGES must be none, thp, or hugetlb", 0, 0);
+  }
+
+  if (hp_mode == HP_NONE) {
+    return;
+  }
+
+  // make sure the large arena has been initialized before hooking it
+  set_arena(CHPL_JE_LG_ARENA);
+  set_arena(0);
+
+  snprintf(path, sizeof(path), "arena.%u.chunk_hooks", CHPL_JE_LG_ARENA);
+  sz = sizeof(default_hooks);
+  if (CHPL_JE_MALLCTL(path, &default_hooks, &sz, NULL, 0) != 0) {
+    chpl_internal_error("could not get the default chunk hooks");
+  }
+
+  hooks = default_hooks;
+  hooks.alloc = hp_chunk_alloc;
+  if (hp_mode == HP_HUGETLB) {
+    hooks.dalloc = null_dalloc;
+    hooks.commit = null_commit;
+    hooks.decommit = null_decommit;
+    hooks.purge = hp_chunk_purge;
+    hooks.split = null_split;
+    hooks.merge = null_merge;
+  }
+
+  if (CHPL_JE_MALLCTL(path, NULL, NULL, &hooks, sizeof(hooks)) != 0) {
+    chpl_internal_error("could not update the chunk hooks");
+  }
+}
+#endif
+
+// Create the NUMA arena groups, if there's more than one NUMA domain and
+// the user hasn't turned them off.
+static void setupNumaArenas(void) {
+#ifdef USE_JE_CHUNK_HOOKS
+  int numDomains = chpl_topo_getNumNumaDomains();
+  unsigned perDomain;
+  unsigned i;
+  chunk_hooks_t hooks;
+  size_t sz;
+
+  if (numDomains <= 1 || numDomains > NUMA_MAX_DOMAINS
+      || !chpl_env_rt_get_bool("MEM_NUMA_ARENAS", true)) {
+    return;
+  }
+
+  if ((perDomain = get_num_arenas() / numDomains) == 0) {
+    perDomain = 1;
+  }
+
+  if (heap.type == NONE) {
+    sz = sizeof(default_hooks);
+    if (CHPL_JE_MALLCTL("arena.0.chunk_hooks", &default_hooks, &sz,
+                        NULL, 0) != 0) {
+      chpl_internal_error("could not get the default chunk hooks");
+    }
+    hooks = default_hooks;
+    hooks.alloc = numa_chunk_alloc;
+  } else {
+    hooks = (chunk_hooks_t) {
+              chunk_alloc,
+              null_dalloc,
+              null_commit,
+              null_decommit,
+              null_purge,
+              null_split,
+              null_merge
+            };
+  }
+
+  for (i = 0; i < numDomains * perDomain; i++) {
+    unsigned arena;
+    char path[128];
+
+    sz = sizeof(arena);
+    if (CHPL_JE_MALLCTL("arenas.extend", &arena, &sz, NULL, 0) != 0) {
+      chpl_internal_error("could not create a NUMA arena");
+    }
+    if (i == 0) {
+      numa_arena_base = arena;
+    } else if (arena != numa_arena_base + i) {
+      chpl_internal_error("NUMA arenas are not contiguous");
+    }
+
+    snprintf(path, sizeof(path), "arena.%u.chunk_hooks", arena);
+    if (CHPL_JE_MALLCTL(path, NULL, NULL, &hooks, sizeof(hooks)) != 0) {
+      chpl_internal_error("could not update the chunk hooks");
+    }
+  }
+
+  numa_arenas_per_domain = perDomain;
+  numa_num_domains = numDomains;
+  chpl_je_numa_arenas = 1;
+#endif
+}
+
+// Point the calling thread at an arena in its NUMA domain's group, if
+// it is bound to a single domain.  Otherwise leave it on the arena
+// jemalloc gave it.
+void chpl_je_choose_thread_arena(void) {
+  c_sublocid_t subloc;
+
+  // Set this first: the work below may allocate.
+  chpl_je_thread_arena_chosen = 1;
+
+  subloc = chpl_topo_getThreadBoundLocality();
+  if (subloc >= 0 && subloc < numa_num_domains) {
+    unsigned i = __atomic_fetch_add(&numa_next[subloc], 1, __ATOMIC_RELAXED);
+    set_arena(numa_arena_base + subloc * numa_arenas_per_domain
+              + i % numa_arenas_per_domain);
+  }
+}
+
 // helper routines to get the number of size classes
 static unsigned get_num_small_classes(void) {
   return get_unsigned_mallctl_value("arenas.nbins");
@@ -408,10 +687,37 @@ void chpl_mem_layerInit(void) {
     CHPL_JE_DALLOCX(p, MALLOCX_NO_FLAGS);
   }
   CHPL_JE_LG_ARENA = get_num_arenas()-1;
+
+#ifdef USE_JE_CHUNK_HOOKS
+  setupHugePages();
+#endif
+  setupNumaArenas();
+}
+
+
+// With CHPL_RT_MEM_HUGEPAGES_REPORT, say how much of our memory ended up
+// on hugepages.
+static void reportHugePages(void) {
+  if (!chpl_env_rt_get_bool("MEM_HUGEPAGES_REPORT", false)) {
+    return;
+  }
+
+  printf("%d: hugepages: %zu MiB in transparent hugepages",
+         (int) chpl_nodeID,
+         (size_t) (chpl_sys_anonHugePageBytes() >> 20));
+#ifdef USE_JE_CHUNK_HOOKS
+  if (hp_mode != HP_NONE) {
+    printf("; large arena %zu MiB, %zu MiB of it from hugetlb",
+           hp_chunk_bytes >> 20, hp_hugetlb_bytes >> 20);
+  }
+#endif
+  printf("\n");
+  fflush(stdout);
 }
 
 
 void chpl_mem_layerExit(void) {
+  reportHugePages();
   if (heap.type == FIXED) {
     // ignore errors, we're exiting anyways
     (void) pthread_mutex_destroy(&heap.alloc_lock);
@@ -22,32 +22,60 @@
 #include "chpl-comm.h"
 #include "chpl-comm-compiler-macros.h"
 #include "chpl-linefile-support.h"
+#include "chplsys.h"
 
 #include "bulkget.h"
 
+// How much of a remote qbytes_t's data to fetch along with its header,
+// on the chance that the data is stored right after the header, as it
+// is for qbytes_create_calloc().  When it is and it fits, that saves a
+// second, dependent round trip.  This never reads past the end of the
+// page the header ends on, so it touches no memory that isn't already
+// mapped and registered wherever the header is.
+#define BULK_GET_INLINE_BYTES 256
+
 // The initial ref count in the return qbytes buffer is 1.
 // The caller is responsible for calling qbytes_release on it when done.
 qbytes_t* bulk_get_bytes(int64_t src_locale, qbytes_t* src_addr)
 {
-  qbytes_t tmp;
+  struct {
+    qbytes_t hdr;
+    uint8_t data[BULK_GET_INLINE_BYTES];
+  } tmp;
   qbytes_t* ret;
   int64_t src_len;
   void* src_data;
+  uintptr_t hdr_end = (uintptr_t) (src_addr + 1);
+  size_t pg_size = chpl_getSysPageSize();
+  size_t inline_len;
   qioerr err;
 
   // Zero-initialize tmp.
-  memset(&tmp, 0, sizeof(qbytes_t));
+  memset(&tmp, 0, sizeof(tmp));
+
+  // How much data can we safely fetch along with the header?
+  inline_len = (hdr_end & (pg_size - 1)) == 0 ?
+               0 : pg_size - (hdr_end & (pg_size - 1));
+  if( inline_len > BULK_GET_INLINE_BYTES ) inline_len = BULK_GET_INLINE_BYTES;
 
-  // First, get the length and local pointer to the bytes.
-  chpl_gen_comm_get(&tmp, src_locale, src_addr, sizeof(qbytes_t),
+  // First, get the length and local pointer to the bytes, and maybe the
+  // bytes themselves.
+  chpl_gen_comm_get(&tmp, src_locale, src_addr,
+                    sizeof(qbytes_t) + inline_len,
                     CHPL_COMM_UNKNOWN_ID, -1, CHPL_FILE_IDX_INTERNAL);
-  src_len = tmp.len;
-  src_data = tmp.data;
+  src_len = tmp.hdr.len;
+  src_data = tmp.hdr.data;
 
   // The initial ref count is 1.
   err = qbytes_create_calloc(&ret, src_len);
   if( err ) return NULL;
 
+  if( src_data == (void*) hdr_end && src_len <= (int64_t) inline_len ) {
+    // We already have the data.
+    qio_memcpy(ret->data, tmp.data, src_len);
+    return ret;
+  }
+
   // TODO -- note -- technically, this should be gasnet_get_bulk,
   // since we don't want to require src/dst to have a particular alignment.
 
@@ -29,6 +29,7 @@
 #include "error.h"
 
 #include "sys.h"
+#include "chpl-thread-local-storage.h"
 
 #include <limits.h>
 #include <sys/mman.h>
@@ -41,6 +42,22 @@
 // but we can't know page size at compile time
 size_t qbytes_iobuf_size = 64*1024;
 
+// How many freed iobufs each thread keeps for reuse (at most
+// QBYTES_IOBUF_POOL_LIMIT).  0 disables the pool.
+size_t qbytes_iobuf_pool_max = 16;
+
+#define QBYTES_IOBUF_POOL_LIMIT 64
+
+#ifdef CHPL_TLS
+static CHPL_TLS qbytes_t* qbytes_iobuf_pool[QBYTES_IOBUF_POOL_LIMIT];
+static CHPL_TLS size_t qbytes_iobuf_pool_count;
+#endif
+
+static atomic_uint_least64_t qbytes_iobuf_pool_hits;
+static atomic_uint_least64_t qbytes_iobuf_pool_misses;
+static atomic_uint_least64_t qbytes_iobuf_pool_returned;
+static atomic_uint_least64_t qbytes_iobuf_pool_dropped;
+
 // prototypes.
 
 void qbytes_free_iobuf(qbytes_t* b);
@@ -87,10 +104,43 @@ void qbytes_free_qio_free(qbytes_t* b) {
   _qbytes_free_qbytes(b);
 }
 void qbytes_free_iobuf(qbytes_t* b) {
+#ifdef CHPL_TLS
+  size_t max = qbytes_iobuf_pool_max;
+  if( max > QBYTES_IOBUF_POOL_LIMIT ) max = QBYTES_IOBUF_POOL_LIMIT;
+
+  if( max > 0 ) {
+    // Keep it for the next qbytes_create_iobuf on this thread.
+    if( b->len == (int64_t) qbytes_iobuf_size &&
+        qbytes_iobuf_pool_count < max ) {
+      qbytes_iobuf_pool[qbytes_iobuf_pool_count++] = b;
+      atomic_fetch_add_uint_least64_t(&qbytes_iobuf_pool_returned, 1);
+      return;
+    }
+    atomic_fetch_add_uint_least64_t(&qbytes_iobuf_pool_dropped, 1);
+  }
+#endif
+
   // iobuf is just something to be freed with free()
   qbytes_free_qio_free(b);
 }
 
+void qbytes_iobuf_pool_drain(void)
+{
+#ifdef CHPL_TLS
+  while( qbytes_iobuf_pool_count > 0 ) {
+    qbytes_free_qio_free(qbytes_iobuf_pool[--qbytes_iobuf_pool_count]);
+  }
+#endif
+}
+
+void qbytes_iobuf_pool_stats(qbytes_iobuf_pool_stats_t* stats)
+{
+  stats->hits = atomic_load_uint_least64_t(&qbytes_iobuf_pool_hits);
+  stats->misses = atomic_load_uint_least64_t(&qbytes_iobuf_pool_misses);
+  stats->returned = atomic_load_uint_least64_t(&qbytes_iobuf_pool_returned);
+  stats->dropped = atomic_load_uint_least64_t(&qbytes_iobuf_pool_dropped);
+}
+
 void debug_print_bytes(qbytes_t* b)
 {
   fprintf(stderr, "bytes %p: data=%p len=%lli ref_cnt=%" PRIu64 " free_function=%p flags=%i\n",
@@ -172,6 +222,25 @@ qioerr qbytes_create_iobuf(qbytes_t** out)
   qbytes_t* ret = NULL;
   qioerr err;
 
+#ifdef CHPL_TLS
+  while( qbytes_iobuf_pool_count > 0 ) {
+    ret = qbytes_iobuf_pool[--qbytes_iobuf_pool_count];
+    if( ret->len != (int64_t) qbytes_iobuf_size ) {
+      // qbytes_iobuf_size changed since this one was pooled.
+      qbytes_free_qio_free(ret);
+      continue;
+    }
+    // Start out zeroed, just like a new one.
+    memset(ret->data, 0, ret->len);
+    DO_INIT_REFCNT(ret);
+    atomic_fetch_add_uint_least64_t(&qbytes_iobuf_pool_hits, 1);
+    *out = ret;
+    return 0;
+  }
+  if( qbytes_iobuf_pool_max > 0 )
+    atomic_fetch_add_uint_least64_t(&qbytes_iobuf_pool_misses, 1);
+#endif
+
   ret = (qbytes_t*) qio_calloc(1, sizeof(qbytes_t));
   if( ! ret ) {
     *out = NULL;
@@ -270,62 +339,128 @@ void qbuffer_clear_cached(qbuffer_t* buf)
 
 void debug_print_qbuffer_iter(qbuffer_iter_t* iter)
 {
-  fprintf(stderr, "offset=%lli ", (long long int) iter->offset);
-  debug_print_deque_iter(& iter->iter);
+  fprintf(stderr, "offset=%lli part=%llu\n", (long long int) iter->offset,
+          (unsigned long long int) iter->part);
 }
 
 void debug_print_qbuffer(qbuffer_t* buf)
 {
-  deque_iterator_t cur = deque_begin(& buf->deque);
-  deque_iterator_t end = deque_end(& buf->deque);
-
-  fprintf(stderr, "buf %p: offset_start=%lli offset_end=%lli deque:\n",
-          buf, (long long int) buf->offset_start, (long long int) buf->offset_end);
+  uint64_t cur;
 
-  // Print out the deque iterators
-  debug_print_deque_iter(&cur);
-  debug_print_deque_iter(&end);
+  fprintf(stderr, "buf %p: offset_start=%lli offset_end=%lli "
+          "parts %llu to %llu in %llu slots:\n",
+          buf, (long long int) buf->offset_start, (long long int) buf->offset_end,
+          (unsigned long long int) buf->parts.head,
+          (unsigned long long int) buf->parts.tail,
+          (unsigned long long int) buf->parts.mask + 1);
 
-  while( ! deque_it_equals(cur, end) ) {
-    qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr( sizeof(qbuffer_part_t), cur);
+  for( cur = buf->parts.head; cur != buf->parts.tail; cur++ ) {
+    qbuffer_part_t* qbp = qbuffer_part_at(&buf->parts, cur);
     fprintf(stderr, "part %p: bytes=%p (data %p) skip=%lli len=%lli end=%lli\n",
             qbp, qbp->bytes, qbp->bytes->data,
             (long long int) qbp->skip_bytes,
             (long long int) qbp->len_bytes,
             (long long int) qbp->end_offset);
+  }
+}
+
+// How many parts a new buffer has room for; must be a power of 2.
+#define QBUFFER_PARTS_INITIAL 8
+
+// Double the size of a full ring.  Each part keeps its number, so
+// iterators into the buffer remain valid.
+static
+qioerr qbuffer_parts_grow(qbuffer_parts_t* parts)
+{
+  uint64_t new_size = 2 * (parts->mask + 1);
+  qbuffer_part_t* new_ring;
+  uint64_t cur;
+
+  new_ring = (qbuffer_part_t*) qio_calloc(new_size, sizeof(qbuffer_part_t));
+  if( ! new_ring ) return QIO_ENOMEM;
+
+  for( cur = parts->head; cur != parts->tail; cur++ ) {
+    new_ring[cur & (new_size - 1)] = parts->ring[cur & parts->mask];
+  }
+
+  qio_free(parts->ring);
+  parts->ring = new_ring;
+  parts->mask = new_size - 1;
+
+  return 0;
+}
 
-    deque_it_forward_one( sizeof(qbuffer_part_t), &cur );
+static inline
+qioerr qbuffer_parts_push_back(qbuffer_parts_t* parts, qbuffer_part_t* part)
+{
+  if( parts->tail - parts->head > parts->mask ) {
+    qioerr err = qbuffer_parts_grow(parts);
+    if( err ) return err;
   }
+
+  *qbuffer_part_at(parts, parts->tail) = *part;
+  parts->tail++;
+
+  return 0;
+}
+
+static inline
+qioerr qbuffer_parts_push_front(qbuffer_parts_t* parts, qbuffer_part_t* part)
+{
+  if( parts->tail - parts->head > parts->mask ) {
+    qioerr err = qbuffer_parts_grow(parts);
+    if( err ) return err;
+  }
+
+  parts->head--;
+  *qbuffer_part_at(parts, parts->head) = *part;
+
+  return 0;
+}
+
+static inline
+void qbuffer_parts_pop_front(qbuffer_parts_t* parts)
+{
+  memset(qbuffer_part_at(parts, parts->head), 0, sizeof(qbuffer_part_t));
+  parts->head++;
+}
+
+static inline
+void qbuffer_parts_pop_back(qbuffer_parts_t* parts)
+{
+  parts->tail--;
+  memset(qbuffer_part_at(parts, parts->tail), 0, sizeof(qbuffer_part_t));
 }
 
 qioerr qbuffer_init(qbuffer_t* buf)
 {
   memset(buf, 0, sizeof(qbuffer_t));
   DO_INIT_REFCNT(buf);
-  return deque_init(sizeof(qbuffer_part_t), & buf->deque, 0);
-  //return 0;
+  buf->parts.ring = (qbuffer_part_t*) qio_calloc(QBUFFER_PARTS_INITIAL,
+                                                 sizeof(qbuffer_part_t));
+  if( ! buf->parts.ring ) return QIO_ENOMEM;
+  buf->parts.mask = QBUFFER_PARTS_INITIAL - 1;
+  return 0;
 }
 
 qioerr qbuffer_destroy(qbuffer_t* buf)
 {
   qioerr err = 0;
-  deque_iterator_t cur = deque_begin(& buf->deque);
-  deque_iterator_t end = deque_end(& buf->deque);
+  uint64_t cur;
 
-  while( ! deque_it_equals(cur, end) ) {
-    qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), cur);
+  for( cur = buf->parts.head; cur != buf->parts.tail; cur++ ) {
+    qbuffer_part_t* qbp = qbuffer_part_at(&buf->parts, cur);
 
     // release the qbuffer.
     qbytes_release(qbp->bytes);
-
-    deque_it_forward_one(sizeof(qbuffer_part_t), &cur);
   }
 
   // remove any cached data
   qbuffer_clear_cached(buf);
 
-  // destroy the deque
-  deque_destroy(& buf->deque);
+  // free the parts
+  qio_free(buf->parts.ring);
+  memset(&buf->parts, 0, sizeof(qbuffer_parts_t));
 
   DO_DESTROY_REFCNT(buf);
 
@@ -383,9 +518,9 @@ qioerr qbuffer_init_part(qbuffer_part_t* p, qbytes_t* bytes, int64_t skip_bytes,
 
 void qbuffer_extend_back(qbuffer_t* buf)
 {
-  if( deque_size(sizeof(qbuffer_part_t), &buf->deque) > 0 ) {
+  if( qbuffer_num_parts(buf) > 0 ) {
     // Get the last part.
-    qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr( sizeof(qbuffer_part_t), deque_last(sizeof(qbuffer_part_t), &buf->deque));
+    qbuffer_part_t* qbp = qbuffer_part_at(&buf->parts, buf->parts.tail - 1);
     if( (qbp->flags & QB_PART_FLAGS_EXTENDABLE_TO_ENTIRE_BYTES) &&
         qbp->len_bytes < qbp->bytes->len ) {
       qbp->end_offset = (qbp->end_offset - qbp->len_bytes) + qbp->bytes->len;
@@ -397,9 +532,9 @@ void qbuffer_extend_back(qbuffer_t* buf)
 
 void qbuffer_extend_front(qbuffer_t* buf)
 {
-  if( deque_size(sizeof(qbuffer_part_t), &buf->deque) > 0 ) {
+  if( qbuffer_num_parts(buf) > 0 ) {
     // Get the first part.
-    qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr( sizeof(qbuffer_part_t), deque_begin(& buf->deque));
+    qbuffer_part_t* qbp = qbuffer_part_at(&buf->parts, buf->parts.head);
     if( (qbp->flags & QB_PART_FLAGS_EXTENDABLE_TO_ENTIRE_BYTES) &&
         qbp->skip_bytes > 0 ) {
       qbp->len_bytes = qbp->bytes->len;
@@ -420,7 +555,7 @@ qioerr qbuffer_append(qbuffer_t* buf, qbytes_t* bytes, int64_t skip_bytes, int64
   err = qbuffer_init_part(&part, bytes, skip_bytes, len_bytes, new_end);
   if( err ) return err;
 
-  err = deque_push_back(sizeof(qbuffer_part_t), &buf->deque, &part);
+  err = qbuffer_parts_push_back(&buf->parts, &part);
   if( err ) {
     qbytes_release(bytes); // release the bytes.
     return err;
@@ -469,7 +604,7 @@ qioerr qbuffer_prepend(qbuffer_t* buf, qbytes_t* bytes, int64_t skip_bytes, int6
   err = qbuffer_init_part(&part, bytes, skip_bytes, len_bytes, old_start);
   if( err ) return err;
 
-  err = deque_push_front(sizeof(qbuffer_part_t), &buf->deque, &part);
+  err = qbuffer_parts_push_front(&buf->parts, &part);
   if( err ) {
     qbytes_release(bytes); // release the bytes.
     return err;
@@ -492,9 +627,9 @@ void qbuffer_trim_front(qbuffer_t* buf, int64_t remove_bytes)
   assert( remove_bytes > 0 );
   assert( new_start <= buf->offset_end );
 
-  while( deque_size(sizeof(qbuffer_part_t), &buf->deque) > 0 ) {
+  while( qbuffer_num_parts(buf) > 0 ) {
     // Get the first part.
-    qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr( sizeof(qbuffer_part_t), deque_begin(& buf->deque));
+    qbuffer_part_t* qbp = qbuffer_part_at(&buf->parts, buf->parts.head);
 
     if( qbp->end_offset - qbp->len_bytes < new_start ) {
       // we might remove it entirely, or maybe
@@ -502,8 +637,8 @@ void qbuffer_trim_front(qbuffer_t* buf, int64_t remove_bytes)
       if( qbp->end_offset <= new_start ) {
         qbytes_t* bytes = qbp->bytes;
         // ends entirely before new_start, remove the chunk.
-        // Remove it from the deque
-        deque_pop_front(sizeof(qbuffer_part_t), &buf->deque);
+        // Remove it from the buffer
+        qbuffer_parts_pop_front(&buf->parts);
         // release the bytes.
         qbytes_release(bytes);
       } else {
@@ -533,10 +668,10 @@ void qbuffer_trim_back(qbuffer_t* buf, int64_t remove_bytes)
   assert( remove_bytes > 0 );
   assert( new_end >= buf->offset_start );
 
-  // Go through the deque removing entire parts.
-  while( deque_size(sizeof(qbuffer_part_t), &buf->deque) > 0 ) {
+  // Go through the parts removing entire ones.
+  while( qbuffer_num_parts(buf) > 0 ) {
     // Get the last part.
-    qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr( sizeof(qbuffer_part_t), deque_last(sizeof(qbuffer_part_t), &buf->deque));
+    qbuffer_part_t* qbp = qbuffer_part_at(&buf->parts, buf->parts.tail - 1);
 
     if( qbp->end_offset > new_end ) {
       // we might remove it entirely, or maybe
@@ -544,8 +679,8 @@ void qbuffer_trim_back(qbuffer_t* buf, int64_t remove_bytes)
       if( qbp->end_offset - qbp->len_bytes >= new_end ) {
         qbytes_t* bytes = qbp->bytes;
         // starts entirely after new_end, remove the chunk.
-        // Remove it from the deque
-        deque_pop_front(sizeof(qbuffer_part_t), &buf->deque);
+        // Remove it from the buffer
+        qbuffer_parts_pop_back(&buf->parts);
         // release the bytes.
         qbytes_release(bytes);
       } else {
@@ -580,7 +715,7 @@ qioerr qbuffer_pop_front(qbuffer_t* buf)
 
   qbuffer_iter_get(chunk, qbuffer_end(buf), &bytes, &skip, &len);
 
-  deque_pop_front(sizeof(qbuffer_part_t), &buf->deque);
+  qbuffer_parts_pop_front(&buf->parts);
 
   buf->offset_start += len;
 
@@ -601,7 +736,7 @@ qioerr qbuffer_pop_back(qbuffer_t* buf)
 
   qbuffer_iter_get(chunk, qbuffer_end(buf), &bytes, &skip, &len);
 
-  deque_pop_back(sizeof(qbuffer_part_t), &buf->deque);
+  qbuffer_parts_pop_back(&buf->parts);
 
   buf->offset_end -= len;
 
@@ -610,21 +745,15 @@ qioerr qbuffer_pop_back(qbuffer_t* buf)
 
 void qbuffer_reposition(qbuffer_t* buf, int64_t new_offset_start)
 {
-  deque_iterator_t start = deque_begin(& buf->deque);
-  deque_iterator_t end = deque_end(& buf->deque);
-  deque_iterator_t iter;
-  qbuffer_part_t* qbp;
+  uint64_t cur;
   int64_t diff;
 
   diff = new_offset_start - buf->offset_start;
   buf->offset_start += diff;
   buf->offset_end += diff;
 
-  iter = start;
-
-  while( ! deque_it_equals(iter, end) ) {
-    qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter);
-    qbp->end_offset += diff;
+  for( cur = buf->parts.head; cur != buf->parts.tail; cur++ ) {
+    qbuffer_part_at(&buf->parts, cur)->end_offset += diff;
   }
 }
 
@@ -632,7 +761,8 @@ qbuffer_iter_t qbuffer_begin(qbuffer_t* buf)
 {
   qbuffer_iter_t ret;
   ret.offset = buf->offset_start;
-  ret.iter = deque_begin(& buf->deque);
+  ret.parts = &buf->parts;
+  ret.part = buf->parts.head;
   return ret;
 }
 
@@ -640,21 +770,20 @@ qbuffer_iter_t qbuffer_end(qbuffer_t* buf)
 {
   qbuffer_iter_t ret;
   ret.offset = buf->offset_end;
-  ret.iter = deque_end( & buf->deque );
+  ret.parts = &buf->parts;
+  ret.part = buf->parts.tail;
   return ret;
 }
 
 void qbuffer_iter_next_part(qbuffer_t* buf, qbuffer_iter_t* iter)
 {
-  deque_iterator_t d_end = deque_end( & buf->deque );
-
-  deque_it_forward_one(sizeof(qbuffer_part_t), & iter->iter);
+  iter->part++;
 
-  if( deque_it_equals(iter->iter, d_end) ) {
+  if( iter->part == buf->parts.tail ) {
     // if we're not at the end now... offset is from buf
     iter->offset = buf->offset_end;
   } else {
-    qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter->iter);
+    qbuffer_part_t* qbp = qbuffer_part_at(&buf->parts, iter->part);
     iter->offset = qbp->end_offset - qbp->len_bytes;
   }
 }
@@ -663,30 +792,27 @@ void qbuffer_iter_prev_part(qbuffer_t* buf, qbuffer_iter_t* iter)
 {
   qbuffer_part_t* qbp;
 
-  deque_it_back_one(sizeof(qbuffer_part_t), & iter->iter);
+  iter->part--;
 
-  qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter->iter);
+  qbp = qbuffer_part_at(&buf->parts, iter->part);
   iter->offset = qbp->end_offset - qbp->len_bytes;
 }
 
 void qbuffer_iter_floor_part(qbuffer_t* buf, qbuffer_iter_t* iter)
 {
-  deque_iterator_t d_start = deque_begin( & buf->deque );
-  deque_iterator_t d_end = deque_end( & buf->deque );
-
-  if( deque_it_equals(iter->iter, d_end) ) {
-    if( deque_it_equals(iter->iter, d_start) ) {
+  if( iter->part == buf->parts.tail ) {
+    if( iter->part == buf->parts.head ) {
       // We're at the beginning. Do nothing.
       return;
     }
 
     // If we're at the end, just go back one.
-    deque_it_back_one(sizeof(qbuffer_part_t), & iter->iter);
+    iter->part--;
   }
 
   {
     // Now, just set the offset appropriately.
-    qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter->iter);
+    qbuffer_part_t* qbp = qbuffer_part_at(&buf->parts, iter->part);
     iter->offset = qbp->end_offset - qbp->len_bytes;
   }
 }
@@ -694,14 +820,12 @@ void qbuffer_iter_floor_part(qbuffer_t* buf, qbuffer_iter_t* iter)
 
 void qbuffer_iter_ceil_part(qbuffer_t* buf, qbuffer_iter_t* iter)
 {
-  deque_iterator_t d_end = deque_end( & buf->deque );
-
-  if( deque_it_equals(iter->iter, d_end) ) {
+  if( iter->part == buf->parts.tail ) {
     // We're at the end. Do nothing.
   } else {
-    qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter->iter);
+    qbuffer_part_t* qbp = qbuffer_part_at(&buf->parts, iter->part);
     iter->offset = qbp->end_offset;
-    deque_it_forward_one(sizeof(qbuffer_part_t), & iter->iter);
+    iter->part++;
   }
 }
 
@@ -710,19 +834,16 @@ void qbuffer_iter_ceil_part(qbuffer_t* buf, qbuffer_iter_t* iter)
  */
 void qbuffer_iter_advance(qbuffer_t* buf, qbuffer_iter_t* iter, int64_t amt)
 {
-  deque_iterator_t d_begin = deque_begin( & buf->deque );
-  deque_iterator_t d_end = deque_end( & buf->deque );
-
   if( amt >= 0 ) {
     // forward search.
     iter->offset += amt;
-    while( ! deque_it_equals(iter->iter, d_end) ) {
-      qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter->iter);
+    while( iter->part != buf->parts.tail ) {
+      qbuffer_part_t* qbp = qbuffer_part_at(&buf->parts, iter->part);
       if( iter->offset < qbp->end_offset ) {
         // it's in this one.
         return;
       }
-      deque_it_forward_one(sizeof(qbuffer_part_t), & iter->iter);
+      iter->part++;
     }
     // If we get here, we didn't find it. Return the buffer end.
     *iter = qbuffer_end(buf);
@@ -730,27 +851,27 @@ void qbuffer_iter_advance(qbuffer_t* buf, qbuffer_iter_t* iter, int64_t amt)
     // backward search.
     iter->offset += amt; // amt is negative
 
-    if( ! deque_it_equals( iter->iter, d_end ) ) {
+    if( iter->part != buf->parts.tail ) {
       // is it within the current buffer?
-      qbuffer_part_t* qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter->iter);
+      qbuffer_part_t* qbp = qbuffer_part_at(&buf->parts, iter->part);
       if( iter->offset >= qbp->end_offset - qbp->len_bytes ) {
         // it's in this one.
         return;
       }
     }
 
-    // now we have a valid deque element.
+    // now we have a valid part.
     do {
       qbuffer_part_t* qbp;
 
-      deque_it_back_one(sizeof(qbuffer_part_t), & iter->iter);
+      iter->part--;
 
-      qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter->iter);
+      qbp = qbuffer_part_at(&buf->parts, iter->part);
       if( iter->offset >= qbp->end_offset - qbp->len_bytes ) {
         // it's in this one.
         return;
       }
-    } while( ! deque_it_equals(iter->iter, d_begin) );
+    } while( iter->part != buf->parts.head );
     // If we get here, we didn't find it. Return the buffer start.
     *iter = qbuffer_begin(buf);
   }
@@ -765,38 +886,35 @@ void qbuffer_iter_advance(qbuffer_t* buf, qbuffer_iter_t* iter, int64_t amt)
 qbuffer_iter_t qbuffer_iter_at(qbuffer_t* buf, int64_t offset)
 {
   qbuffer_iter_t ret;
-  deque_iterator_t first = deque_begin(& buf->deque);
-  deque_iterator_t last = deque_end(& buf->deque);
-  deque_iterator_t middle;
+  uint64_t first = buf->parts.head;
+  uint64_t middle;
   qbuffer_part_t* qbp;
-  ssize_t num_parts = deque_it_difference(sizeof(qbuffer_part_t), last, first);
+  ssize_t num_parts = qbuffer_num_parts(buf);
   ssize_t half;
 
   while( num_parts > 0 ) {
     half = num_parts >> 1;
-    middle = first;
-
-    deque_it_forward_n(sizeof(qbuffer_part_t), &middle, half);
+    middle = first + half;
 
-    qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), middle);
+    qbp = qbuffer_part_at(&buf->parts, middle);
     if( offset < qbp->end_offset ) {
       num_parts = half;
     } else {
-      first = middle;
-      deque_it_forward_one(sizeof(qbuffer_part_t), &first);
+      first = middle + 1;
       num_parts = num_parts - half - 1;
     }
   }
 
-  if( deque_it_equals(first, last) ) {
+  if( first == buf->parts.tail ) {
     ret = qbuffer_end(buf);
   } else {
-    qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), first);
+    qbp = qbuffer_part_at(&buf->parts, first);
     if( offset < qbp->end_offset - qbp->len_bytes ) {
       ret = qbuffer_begin(buf);
     } else {
       ret.offset = offset;
-      ret.iter = first;
+      ret.parts = &buf->parts;
+      ret.part = first;
     }
   }
   return ret;
@@ -807,12 +925,12 @@ qioerr qbuffer_to_iov(qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end,
                      qbytes_t** bytes_out /* can be NULL */,
                      size_t *iovcnt_out)
 {
-  deque_iterator_t d_end = deque_end(& buf->deque);
-  deque_iterator_t iter;
+  uint64_t d_end = buf->parts.tail;
+  uint64_t iter;
   qbuffer_part_t* qbp;
   size_t i = 0;
 
-  iter = start.iter;
+  iter = start.part;
 
   // invalid range!
   if( start.offset > end.offset ) {
@@ -820,15 +938,15 @@ qioerr qbuffer_to_iov(qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end,
     QIO_RETURN_CONSTANT_ERROR(EINVAL, "invalid range");
   }
 
-  if( deque_it_equals(iter, d_end) ) {
-    // start is actually pointing to the end of the deque. no data.
+  if( iter == d_end ) {
+    // start is actually pointing to the end of the buffer. no data.
     *iovcnt_out = 0;
     return 0;
   }
 
-  if( deque_it_equals(iter, end.iter) ) {
+  if( iter == end.part ) {
     // we're only pointing to a single block.
-    qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter);
+    qbp = qbuffer_part_at(&buf->parts, iter);
     if( i >= max_iov ) goto error_nospace;
     iov_out[i].iov_base = PTR_ADDBYTES(qbp->bytes->data, qbp->skip_bytes + (start.offset - (qbp->end_offset - qbp->len_bytes)));
     iov_out[i].iov_len = end.offset - start.offset;
@@ -836,7 +954,7 @@ qioerr qbuffer_to_iov(qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end,
     if( iov_out[i].iov_len > 0 ) i++;
   } else {
     // otherwise, there's a possibly partial block in start.
-    qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter);
+    qbp = qbuffer_part_at(&buf->parts, iter);
     if( i >= max_iov ) goto error_nospace;
     iov_out[i].iov_base = PTR_ADDBYTES(qbp->bytes->data, qbp->skip_bytes + (start.offset - (qbp->end_offset - qbp->len_bytes)));
     iov_out[i].iov_len = qbp->end_offset - start.offset;
@@ -846,17 +964,17 @@ qioerr qbuffer_to_iov(qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end,
 
 
     // Now, on to the next.
-    deque_it_forward_one(sizeof(qbuffer_part_t), &iter);
+    iter++;
 
     // until we get to the same block as end, we need to store full blocks.
-    while( ! deque_it_equals( iter, end.iter ) ) {
-      if( deque_it_equals( iter, d_end ) ) {
-        // error: end is not in deque.
+    while( iter != end.part ) {
+      if( iter == d_end ) {
+        // error: end is not in buffer.
         *iovcnt_out = 0;
-        QIO_RETURN_CONSTANT_ERROR(EINVAL, "end is not in deque");
+        QIO_RETURN_CONSTANT_ERROR(EINVAL, "end is not in buffer");
       }
 
-      qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter);
+      qbp = qbuffer_part_at(&buf->parts, iter);
       if( i >= max_iov ) goto error_nospace;
       iov_out[i].iov_base = PTR_ADDBYTES(qbp->bytes->data, qbp->skip_bytes);
       iov_out[i].iov_len = qbp->len_bytes;
@@ -865,15 +983,15 @@ qioerr qbuffer_to_iov(qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end,
       if( iov_out[i].iov_len > 0 ) i++;
 
       // Now, on to the next.
-      deque_it_forward_one(sizeof(qbuffer_part_t), &iter);
+      iter++;
     }
 
     // at the end of the loop
     // is there any data in end?
-    if( deque_it_equals(iter, d_end) ) {
+    if( iter == d_end ) {
       // we're currently pointing to the end; no need to add more.
     } else {
-      qbp = (qbuffer_part_t*) deque_it_get_cur_ptr(sizeof(qbuffer_part_t), iter);
+      qbp = qbuffer_part_at(&buf->parts, iter);
       // add a partial end block. We know it's different from
       // start since we handled that above.
       if( i >= max_iov ) goto error_nospace;
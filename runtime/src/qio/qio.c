@@ -34,6 +34,7 @@
 
 #ifndef CHPL_RT_UNIT_TEST
 #include "chplrt.h"
+#include "chpl-env.h"
 #endif
 
 #include "qio.h"
@@ -58,6 +59,21 @@
 #include <sys/stat.h>
 
 #include <assert.h>
+#include <pthread.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#ifndef CHPL_RT_UNIT_TEST
+extern void chpl_task_yield(void);
+#define qio_task_yield() chpl_task_yield()
+#else
+#include <sched.h>
+#define qio_task_yield() sched_yield()
+#endif
 
 // Default to using close-on-exec for systems that support it.
 #ifdef O_CLOEXEC
@@ -83,6 +99,7 @@
 
 static qioerr open_flags_for_string(const char* s, int *flags_out);
 static void _qio_buffered_advance_cached_leave_bits(qio_channel_t* ch);
+static qioerr _qio_pipeline_destroy(qio_channel_t* ch);
 
 // A few global variables that control which I/O strategy is used.
 // See choose_io_method.
@@ -92,14 +109,47 @@ static void _qio_buffered_advance_cached_leave_bits(qio_channel_t* ch);
 // when rounding up to 4k pages.
 ssize_t qio_too_small_for_default_mmap = 16*1024;
 ssize_t qio_mmap_chunk_iobufs = 128; // mmap 128 iobufs at a time (8M)
+// Reading channels share up to qio_mmap_windows (at most
+// QIO_MMAP_WINDOWS_MAX) mappings of this many iobufs (64M) per file.
+// 0 windows means each channel maps its own chunks.
+ssize_t qio_mmap_window_iobufs = 1024;
+int qio_mmap_windows = 4;
 
 // Future - possibly set this based on ulimit?
 ssize_t qio_initial_mmap_max = 8*1024*1024;
 
+// Use io_uring by default for seekable files, when it is available.
+// -1 means not decided yet; then CHPL_RT_QIO_URING decides.
+int qio_uring_default = -1;
+// Buffered io_uring reads fetch at least this many iobufs at a time,
+// all in flight together.
+ssize_t qio_uring_readahead_iobufs = 8;
+
+// How many iobufs a buffered channel keeps being read ahead or written
+// behind by helper threads, and how many helper threads there are.
+// -1 means not decided yet; then CHPL_RT_QIO_PIPELINE_DEPTH decides,
+// with 0 (no pipelining) as the default.
+ssize_t qio_pipeline_depth = -1;
+int qio_pipeline_threads = 4;
+
+// Alignment of offsets, lengths and memory used for O_DIRECT transfers.
+ssize_t qio_direct_align = 4096;
+
+// Smallest chunk qio_plan_parallel_read() will hand to one node.
+int64_t qio_parallel_read_min_chunk = 8*1024*1024;
+
 #ifdef _chplrt_H_
 qioerr qio_lock(qio_lock_t* x) {
+  chpl_taskID_t id;
+
+  if( x->bound ) {
+    // The owner holds the lock until it unbinds.
+    assert( chpl_task_idEquals(x->owner, chpl_task_getId()) );
+    return 0;
+  }
+
   // recursive mutex based on glibc pthreads implementation
-  chpl_taskID_t id = chpl_task_getId();
+  id = chpl_task_getId();
 
   assert( ! chpl_task_idEquals(id, NULL_OWNER) );
 
@@ -120,7 +170,14 @@ qioerr qio_lock(qio_lock_t* x) {
   return 0;
 }
 void qio_unlock(qio_lock_t* x) {
-  chpl_taskID_t id = chpl_task_getId();
+  chpl_taskID_t id;
+
+  if( x->bound ) {
+    assert( chpl_task_idEquals(x->owner, chpl_task_getId()) );
+    return;
+  }
+
+  id = chpl_task_getId();
 
   // recursive mutex based on glibc pthreads implementation
   if( ! chpl_task_idEquals(x->owner, id) ) {
@@ -135,12 +192,60 @@ void qio_unlock(qio_lock_t* x) {
   x->owner = NULL_OWNER;
   atomic_unlock_spinlock_t(&x->lock);
 }
+
+qioerr qio_lock_bind(qio_lock_t* x) {
+  qioerr err;
+
+  if( x->bound ) {
+    assert( chpl_task_idEquals(x->owner, chpl_task_getId()) );
+    return 0;
+  }
+
+  err = qio_lock(x);
+  if( err ) return err;
+
+  if( x->count != 1 ) {
+    // Already held further up the stack; those unlocks would be lost.
+    qio_unlock(x);
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "cannot bind a lock that is held");
+  }
+
+  x->bound = true;
+  return 0;
+}
+
+void qio_lock_unbind(qio_lock_t* x) {
+  if( ! x->bound ) return;
+  assert( chpl_task_idEquals(x->owner, chpl_task_getId()) );
+  x->bound = false;
+  qio_unlock(x);
+}
 #endif
 
 #ifdef CHPL_RT_UNIT_TEST
 #include "qio_plugin_api_dummy.c"
 #endif
 
+static const qio_plugin_ops_t qio_chpl_plugin_ops = {
+  chpl_qio_setup_plugin_channel,
+  chpl_qio_read_atleast,
+  chpl_qio_write,
+  chpl_qio_channel_close,
+  chpl_qio_filelength,
+  chpl_qio_getpath,
+  chpl_qio_fsync,
+  chpl_qio_get_chunk,
+  chpl_qio_get_locales_for_region,
+  chpl_qio_file_close,
+};
+
+static inline
+const qio_plugin_ops_t* _qio_plugin_ops(qio_file_t* file)
+{
+  if( file->plugin_ops ) return file->plugin_ops;
+  return &qio_chpl_plugin_ops;
+}
+
 qioerr qio_readv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, ssize_t* num_read)
 {
   ssize_t nread = 0;
@@ -402,6 +507,97 @@ error:
   return err;
 }
 
+static
+qioerr _qio_uring_prwv(qio_file_t* file, int writing, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_out)
+{
+  ssize_t total = 0;
+  int64_t num_bytes = qbuffer_iter_num_bytes(start, end);
+  ssize_t num_parts = qbuffer_iter_num_parts(start, end);
+  struct iovec* iov = NULL;
+  sys_uring_op_t* ops = NULL;
+  size_t iovcnt;
+  size_t i;
+  int64_t off;
+  err_t rc;
+  MAYBE_STACK_SPACE(struct iovec, iov_onstack);
+  MAYBE_STACK_SPACE(sys_uring_op_t, ops_onstack);
+  qioerr err;
+
+  if( num_bytes < 0 || num_parts < 0 || num_parts > INT_MAX ) {
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "range outside of buffer");
+  }
+
+  if( file->fd == -1 ) {
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "invalid file descriptor");
+  }
+
+  STARTING_SLOW_SYSCALL;
+
+  MAYBE_STACK_ALLOC(struct iovec, num_parts, iov, iov_onstack);
+  MAYBE_STACK_ALLOC(sys_uring_op_t, num_parts, ops, ops_onstack);
+  if( ! iov || ! ops ) {
+    err = QIO_ENOMEM;
+    goto error;
+  }
+
+  err = qbuffer_to_iov(buf, start, end, num_parts, iov, NULL, &iovcnt);
+  if( err ) goto error;
+
+  // One op per buffer part, each at its own offset.
+  off = seek_to_offset;
+  for( i = 0; i < iovcnt; i++ ) {
+    ops[i].iov = iov[i];
+    ops[i].offset = off;
+    off += iov[i].iov_len;
+  }
+
+  rc = sys_uring_rw(file->fd, writing, ops, iovcnt);
+  if( rc == ENOSYS ) {
+    // No io_uring here after all; do it synchronously.
+    if( writing )
+      rc = sys_pwritev(file->fd, iov, iovcnt, seek_to_offset, &total);
+    else
+      rc = sys_preadv(file->fd, iov, iovcnt, seek_to_offset, &total);
+    err = qio_int_to_err(rc);
+    goto error;
+  }
+
+  // Only the data up to the first short or failed op is contiguous.
+  // An error after some data was moved is reported by the next call.
+  for( i = 0; i < iovcnt; i++ ) {
+    if( ops[i].result < 0 ) {
+      if( total == 0 ) rc = -ops[i].result;
+      break;
+    }
+    total += ops[i].result;
+    if( (size_t) ops[i].result != ops[i].iov.iov_len ) break;
+  }
+
+  if( ! writing && rc == 0 && total == 0 && num_bytes != 0 ) rc = EEOF;
+
+  err = qio_int_to_err(rc);
+
+error:
+  MAYBE_STACK_FREE(ops, ops_onstack);
+  MAYBE_STACK_FREE(iov, iov_onstack);
+
+  *num_out = total;
+
+  DONE_SLOW_SYSCALL;
+
+  return err;
+}
+
+qioerr qio_uring_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read)
+{
+  return _qio_uring_prwv(file, 0, buf, start, end, seek_to_offset, num_read);
+}
+
+qioerr qio_uring_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written)
+{
+  return _qio_uring_prwv(file, 1, buf, start, end, seek_to_offset, num_written);
+}
+
 qioerr qio_recv(fd_t sockfd, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int flags,
               sys_sockaddr_t* src_addr_out, /* can be NULL */
               void* ancillary_out, socklen_t* ancillary_len_inout, /* can be NULL */
@@ -513,6 +709,19 @@ error:
   return err;
 }
 
+static
+int _qio_uring_by_default(void)
+{
+  if( qio_uring_default < 0 ) {
+#ifndef CHPL_RT_UNIT_TEST
+    qio_uring_default = chpl_env_rt_get_bool("QIO_URING", false);
+#else
+    qio_uring_default = 0;
+#endif
+  }
+  return qio_uring_default && sys_uring_available();
+}
+
 static
 qio_hint_t choose_io_method(qio_file_t* file, qio_hint_t hints, qio_hint_t default_hints, int64_t file_size, int reading, int writing, int isfilestar)
 {
@@ -553,6 +762,8 @@ qio_hint_t choose_io_method(qio_file_t* file, qio_hint_t hints, qio_hint_t defau
 
           if (mmap_ok)
             method = QIO_METHOD_MMAP;
+          else if (_qio_uring_by_default())
+            method = QIO_METHOD_URING;
           else
             method = QIO_METHOD_PREADPWRITE;
         } else {
@@ -562,6 +773,14 @@ qio_hint_t choose_io_method(qio_file_t* file, qio_hint_t hints, qio_hint_t defau
     } else {
       // method already chosen in hints.
     }
+
+    // io_uring needs a seekable file and kernel support.
+    if( method == QIO_METHOD_URING &&
+        ( !(fdflags & QIO_FDFLAG_SEEKABLE) || isfilestar ||
+          !sys_uring_available() ) ) {
+      method = (fdflags & QIO_FDFLAG_SEEKABLE) ? QIO_METHOD_PREADPWRITE
+                                               : QIO_METHOD_READWRITE;
+    }
   }
 
   // Always use fread/fwrite with FILE*
@@ -602,6 +821,19 @@ qioerr qio_fadvise_for_hints(qio_file_t* file)
 #endif
     err = qio_int_to_err(sys_fcntl_long(file->fd, F_SETFL, arg, &rc));
     if( err ) return err;
+
+#ifdef O_DIRECT
+    // Unbuffered channels send the unaligned ends of their transfers
+    // through a second descriptor without O_DIRECT.  If the system
+    // can't reopen the fd that way, those go to the O_DIRECT one.
+    {
+      char path[64];
+      fd_t fd2 = -1;
+      int flags = (int) (arg & ~(O_DIRECT|O_CREAT|O_EXCL|O_TRUNC));
+      snprintf(path, sizeof(path), "/proc/self/fd/%d", (int) file->fd);
+      if( sys_open(path, flags, 0, &fd2) == 0 ) file->nodirect_fd = fd2;
+    }
+#endif
   } else {
     err = 0;
 #if (_XOPEN_SOURCE >= 600 || _POSIX_C_SOURCE >= 200112L)
@@ -817,6 +1049,7 @@ qioerr qio_file_init(qio_file_t** file_out, FILE* fp, fd_t fd, qio_hint_t iohint
   DO_INIT_REFCNT(file);
   file->fp = fp;
   file->fd = fd;
+  file->nodirect_fd = -1;
   file->use_fp = usefilestar;
   file->buf = NULL;
   file->fdflags = fdflags;
@@ -862,6 +1095,12 @@ error:
 }
 
 qioerr qio_file_init_plugin(qio_file_t** file_out, void* file_info, int fdflags, const qio_style_t* style)
+{
+  return qio_file_init_plugin_ops(file_out, file_info, &qio_chpl_plugin_ops,
+                                  fdflags, style);
+}
+
+qioerr qio_file_init_plugin_ops(qio_file_t** file_out, void* file_info, const qio_plugin_ops_t* ops, int fdflags, const qio_style_t* style)
 {
   off_t initial_pos = 0;
   int64_t initial_length = 0;
@@ -876,7 +1115,7 @@ qioerr qio_file_init_plugin(qio_file_t** file_out, void* file_info, int fdflags,
   }
 
   if (seekable) {
-    err = chpl_qio_filelength(file_info, &initial_length);
+    err = ops->filelength(file_info, &initial_length);
     // Disregard errors in case it is not seekable (and if we need seek to get the
     // length). If we can't get the length, we'll set initial_pos below anyways.
     if (err) initial_length = 0;
@@ -900,6 +1139,7 @@ qioerr qio_file_init_plugin(qio_file_t** file_out, void* file_info, int fdflags,
   DO_INIT_REFCNT(file);
   file->fp = NULL;
   file->fd = -1;
+  file->nodirect_fd = -1;
   file->use_fp = 0;
   file->buf = NULL;
   file->fdflags = (qio_fdflag_t) fdflags;
@@ -907,6 +1147,7 @@ qioerr qio_file_init_plugin(qio_file_t** file_out, void* file_info, int fdflags,
   file->initial_length = initial_length;
   file->initial_pos = initial_pos;
   file->file_info  = file_info;
+  file->plugin_ops = ops;
 
   file->hints = choose_io_method(file, iohints, 0, initial_length,
                                  (fdflags & QIO_FDFLAG_READABLE) > 0,
@@ -973,10 +1214,16 @@ qioerr _qio_file_do_close(qio_file_t* f)
 
   if (f->file_info) {
     if (f->hints & QIO_HINT_OWNED)  // Should always be true
-      err = chpl_qio_file_close(f->file_info);
+      err = _qio_plugin_ops(f)->file_close(f->file_info);
     f->hints &= ~QIO_HINT_OWNED;
   }
 
+  if( f->nodirect_fd >= 0 ) {
+    // We opened this one ourselves.
+    (void) sys_close(f->nodirect_fd);
+    f->nodirect_fd = -1;
+  }
+
   if( f->fd >= 0 ) {
     if (f->hints & QIO_HINT_OWNED)
       err = qio_int_to_err(sys_close(f->fd));
@@ -1020,7 +1267,7 @@ qioerr qio_file_sync(qio_file_t* f)
   } else if( f->fd >= 0 ) {
     err = qio_int_to_err(sys_fsync(f->fd));
   } else if( f->file_info ) {
-    err = chpl_qio_fsync(f->file_info);
+    err = _qio_plugin_ops(f)->fsync(f->file_info);
   }
 
   return err;
@@ -1029,6 +1276,7 @@ qioerr qio_file_sync(qio_file_t* f)
 void _qio_file_destroy(qio_file_t* f)
 {
   qioerr err;
+  int i;
 
   if( DEBUG_QIO ) printf("Destroying file %p\n", f);
 
@@ -1043,6 +1291,10 @@ void _qio_file_destroy(qio_file_t* f)
 
   qbytes_release(f->mmap); // Does nothing if null.
 
+  for( i = 0; i < QIO_MMAP_WINDOWS_MAX; i++ ) {
+    qbytes_release(f->mmap_windows[i].bytes); // Does nothing if null.
+  }
+
   qbuffer_release(f->buf); // Does nothing if null.
 
   DO_DESTROY_REFCNT(f);
@@ -1165,6 +1417,7 @@ qioerr qio_file_open_mem_ext(qio_file_t** file_out, qbuffer_t* buf, qio_fdflag_t
   DO_INIT_REFCNT(file); // initialized to 1.
   file->fp = NULL;
   file->fd = -1;
+  file->nodirect_fd = -1;
   file->fdflags = fdflags;
   file->closed = false;
   file->hints = choose_io_method(file, iohints, 0, qbuffer_len(file->buf),
@@ -1281,7 +1534,7 @@ qioerr qio_file_path(qio_file_t* f, const char** string_out)
   if (f->fd != -1)
     return qio_file_path_for_fd(f->fd, string_out);
   else if (f->file_info != NULL)
-    return chpl_qio_getpath(f->file_info, string_out, &len);
+    return _qio_plugin_ops(f)->getpath(f->file_info, string_out, &len);
   else
     QIO_RETURN_CONSTANT_ERROR(ENOSYS, "no fd or plugin");
 }
@@ -1304,7 +1557,7 @@ qioerr qio_file_length(qio_file_t* f, int64_t *len_out)
     err = qio_int_to_err(sys_fstat(f->fd, &stats));
     *len_out = stats.st_size;
   } else if (f->file_info) {
-    err = chpl_qio_filelength(f->file_info, len_out);
+    err = _qio_plugin_ops(f)->filelength(f->file_info, len_out);
   } else {
     QIO_RETURN_CONSTANT_ERROR(ENOSYS, "no fd or plugin");
   }
@@ -1377,7 +1630,7 @@ qioerr _qio_channel_init_file_internal(qio_channel_t* ch, qio_file_t* file, qio_
   // Setup any plugin channel, if necessary
   if (file->file_info != NULL) {
     void* chan_info = NULL;
-    err = chpl_qio_setup_plugin_channel(file->file_info, &chan_info, start, end, ch);
+    err = _qio_plugin_ops(file)->setup_plugin_channel(file->file_info, &chan_info, start, end, ch);
     if (err) return err;
     ch->chan_info = chan_info;
   }
@@ -1790,12 +2043,17 @@ qioerr _qio_channel_final_flush_unlocked(qio_channel_t* ch)
   // Make a note of any error from flush/truncate so we don't forget it
   flush_or_truncate_error = err;
 
+  if( ch->pipeline ) {
+    err = _qio_pipeline_destroy(ch);
+    if( ! flush_or_truncate_error ) flush_or_truncate_error = err;
+  }
+
   // set end_pos to the current position.
   ch->end_pos = qio_channel_offset_unlocked(ch);
 
   // Close plugin structure if any
   if (ch->chan_info != NULL)
-    chpl_qio_channel_close(ch->chan_info);
+    _qio_plugin_ops(ch->file)->channel_close(ch->chan_info);
 
   if( !destroyed_buffer && qbuffer_is_initialized(&ch->buf) ) {
     // Destroy the buffer.
@@ -2074,6 +2332,131 @@ qioerr _buffered_get_memory(qio_channel_t* ch, int64_t amt, int writing)
   return err;
 }
 
+// Finds (or maps) a shared window containing [offset, offset+amt)
+// of the file. Call this with the file lock held. On success, returns
+// 0 and sets *window_out, or sets it to NULL if the range can't come
+// from a window (e.g. because it crosses a window boundary).
+static
+qioerr _qio_file_get_mmap_window_lock_held(qio_file_t* file, int64_t offset,
+                                           int64_t amt, qio_hint_t hints,
+                                           qio_mmap_window_t** window_out)
+{
+  int64_t window_size = qio_mmap_window_iobufs * qbytes_iobuf_size;
+  int nwindows = qio_mmap_windows;
+  qio_mmap_window_t* w = NULL;
+  struct stat stats;
+  int64_t map_start;
+  int64_t len;
+  void* data;
+  qbytes_t* bytes;
+  qioerr err;
+  int i;
+
+  *window_out = NULL;
+
+  if( nwindows > QIO_MMAP_WINDOWS_MAX ) nwindows = QIO_MMAP_WINDOWS_MAX;
+  if( nwindows <= 0 || window_size <= 0 ) return 0;
+
+  // Keep windows page aligned.
+  window_size -= window_size % sys_page_size();
+  if( window_size <= 0 ) return 0;
+
+  map_start = offset - offset % window_size;
+  if( offset + amt > map_start + window_size ) return 0;
+
+  file->mmap_window_clock++;
+
+  for( i = 0; i < nwindows; i++ ) {
+    qio_mmap_window_t* cur = &file->mmap_windows[i];
+    if( cur->bytes && cur->start == map_start &&
+        offset + amt <= cur->start + cur->bytes->len ) {
+      cur->last_use = file->mmap_window_clock;
+      *window_out = cur;
+      return 0;
+    }
+  }
+
+  err = qio_int_to_err(sys_fstat(file->fd, &stats));
+  if( err ) return err;
+
+  len = window_size;
+  if( map_start + len > stats.st_size ) len = stats.st_size - map_start;
+  // Not enough data in the file; let the caller handle EOF.
+  if( len < offset + amt - map_start || len <= 0 ) return 0;
+
+  // This check is (only) important for 32-bit systems.
+  if( len > SSIZE_MAX ) return 0;
+
+  err = qio_int_to_err(sys_mmap(NULL, len, PROT_READ, MAP_SHARED, file->fd, map_start, &data));
+  if( err ) return err;
+
+  // Not worth failing the read over.
+  qio_madvise_for_hints(data, len, hints);
+
+  err = qbytes_create_generic(&bytes, data, len, qbytes_free_munmap);
+  if( err ) {
+    sys_munmap(data, len);
+    return err;
+  }
+
+  // Replace a shorter mapping of the same window (the file grew), or
+  // use an empty slot, or evict the least recently used window.
+  // Channels still using the old mapping hold their own references.
+  for( i = 0; i < nwindows; i++ ) {
+    qio_mmap_window_t* cur = &file->mmap_windows[i];
+    if( cur->bytes == NULL || cur->start == map_start ) {
+      w = cur;
+      break;
+    }
+    if( w == NULL || cur->last_use < w->last_use ) w = cur;
+  }
+
+  qbytes_release(w->bytes); // Does nothing if null.
+  w->bytes = bytes;
+  w->start = map_start;
+  w->last_use = file->mmap_window_clock;
+
+  *window_out = w;
+  return 0;
+}
+
+// Appends the rest of a shared window, starting at the end of ch->buf,
+// to ch->buf. Sets *used to false if no window could be used.
+static
+qioerr _buffered_get_mmap_window(qio_channel_t* ch, int64_t amt, int* used)
+{
+  qio_mmap_window_t* w = NULL;
+  int64_t start = qbuffer_end_offset(&ch->buf);
+  int64_t skip;
+  int64_t len;
+  qioerr err;
+
+  *used = 0;
+
+  err = qio_lock(&ch->file->lock);
+  if( err ) return err;
+
+  err = _qio_file_get_mmap_window_lock_held(ch->file, start, amt,
+                                            ch->hints, &w);
+  if( ! err && w ) {
+    skip = start - w->start;
+    len = w->bytes->len - skip;
+    // do not exceed end_pos.
+    if( ch->end_pos < INT64_MAX && start + len > ch->end_pos ) {
+      len = ch->end_pos - start;
+    }
+    if( len >= amt ) {
+      // qbuffer_append retains the window's bytes.
+      err = qbuffer_append(&ch->buf, w->bytes, skip, len);
+      ch->av_end = qbuffer_end_offset(&ch->buf);
+      if( ! err ) *used = 1;
+    }
+  }
+
+  qio_unlock(&ch->file->lock);
+  return err;
+}
+
 static
 qioerr _buffered_get_mmap(qio_channel_t* ch, int64_t amt_in, int writing)
 {
@@ -2099,6 +2482,15 @@ qioerr _buffered_get_mmap(qio_channel_t* ch, int64_t amt_in, int writing)
     QIO_RETURN_CONSTANT_ERROR(EINVAL, "internal error");
   }
 
+  // Readers share windows of the file, so that random access
+  // doesn't remap on every request.
+  if( ! writing && ! (ch->flags & QIO_FDFLAG_WRITEABLE) ) {
+    int used = 0;
+    err = _buffered_get_mmap_window(ch, amt_in, &used);
+    if( err ) return err;
+    if( used ) return 0;
+  }
+
   // round start down to page size.
   pagesize = sys_page_size();
 
@@ -2198,80 +2590,459 @@ qioerr _buffered_get_mmap(qio_channel_t* ch, int64_t amt_in, int writing)
   else return 0;
 }
 
-// Runs read or pread, whichever is appropriate,
-// to read into the buffer.
+// Background read-ahead and write-behind for buffered channels.
+//
+// When qio_pipeline_depth > 0, buffered channels that use a positional
+// I/O method hand their file I/O to a small pool of helper pthreads.
+// A reading channel keeps up to depth iobufs being read ahead of av_end;
+// a writing channel queues each finished buffer part for writing instead
+// of writing it in _qio_buffered_behind.  The pipeline's op queue is only
+// touched while holding the channel lock; helpers only touch the op they
+// are working on.  Channel tasks wait for ops by yielding, so the task's
+// thread can run other tasks meanwhile.
+//
+// Write-behind errors are reported by a later _qio_buffered_behind call
+// (at the latest, the flush when the channel is closed).
+
+typedef struct qio_pipe_op_s {
+  struct qio_pipe_op_s* next; // in the helper queue
+  fd_t fd;
+  int writing;
+  qbytes_t* bytes;
+  int64_t skip;
+  int64_t len;
+  int64_t offset;
+  int64_t result; // bytes moved
+  err_t err;
+  int done;       // set by the helper once result and err are valid
+} qio_pipe_op_t;
+
+typedef struct qio_pipeline_s {
+  int64_t depth;
+  qio_pipe_op_t** ops; // outstanding ops, oldest at head
+  int64_t head;
+  int64_t count;
+  int64_t next_read;   // offset of the next read-ahead to issue
+  qioerr write_err;    // write-behind error not reported yet
+} qio_pipeline_t;
+
+static pthread_mutex_t qio_pipe_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t qio_pipe_cond = PTHREAD_COND_INITIALIZER;
+static qio_pipe_op_t* qio_pipe_queue_head;
+static qio_pipe_op_t* qio_pipe_queue_tail;
+static int qio_pipe_nhelpers;
+
 static
-qioerr _buffered_read_atleast(qio_channel_t* ch, int64_t amt)
+void _qio_pipe_do(qio_pipe_op_t* op)
 {
-  qbuffer_iter_t read_start;
-  qbuffer_iter_t read_end;
-  ssize_t num_read;
-  int64_t left = amt;
-  int64_t max_amt;
-  int return_eof = 0;
-  qioerr err;
-  qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+  char* ptr = (char*) qio_ptr_add(op->bytes->data, op->skip);
+  int64_t left = op->len;
+  ssize_t got;
+  err_t err = 0;
 
-  err = _qio_channel_needbuffer_unlocked(ch);
-  if( err ) return err;
+  while( left > 0 ) {
+    got = 0;
+    if( op->writing )
+      err = sys_pwrite(op->fd, ptr, left, op->offset + op->result, &got);
+    else
+      err = sys_pread(op->fd, ptr, left, op->offset + op->result, &got);
+    if( err == EINTR ) continue;
+    if( err == EEOF ) err = 0;
+    if( err || got == 0 ) break;
+    ptr += got;
+    left -= got;
+    op->result += got;
+  }
+  op->err = err;
+}
 
-  // do not exceed end_pos.
-  max_amt = INT64_MAX;
-  if( ch->end_pos < INT64_MAX ) {
-    max_amt = ch->end_pos - ch->av_end;
-    if( max_amt < 0 ) max_amt = 0; // handle channel position beyond end
-  }
+static
+void* _qio_pipe_helper(void* arg)
+{
+  qio_pipe_op_t* op;
 
-  if( amt > max_amt ) {
-    amt = max_amt;
-    return_eof = 1;
-  }
+  pthread_mutex_lock(&qio_pipe_lock);
+  while( 1 ) {
+    while( qio_pipe_queue_head == NULL )
+      pthread_cond_wait(&qio_pipe_cond, &qio_pipe_lock);
+    op = qio_pipe_queue_head;
+    qio_pipe_queue_head = op->next;
+    if( qio_pipe_queue_head == NULL ) qio_pipe_queue_tail = NULL;
+    pthread_mutex_unlock(&qio_pipe_lock);
 
-  if (ch->chan_info) {
-    return chpl_qio_read_atleast(ch->chan_info, amt);
+    _qio_pipe_do(op);
+    __atomic_store_n(&op->done, 1, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&qio_pipe_lock);
   }
+  return NULL;
+}
 
-  //printf("Allocating bufferspace %lli\n", (long long int) amt);
-  err = _buffered_allocate_bufferspace(ch, amt, max_amt);
-  if( err ) return err;
+static
+qioerr _qio_pipe_submit(qio_pipeline_t* p, qio_pipe_op_t* op)
+{
+  int ok = 1;
+
+  op->next = NULL;
+  op->result = 0;
+  op->err = 0;
+  op->done = 0;
+
+  pthread_mutex_lock(&qio_pipe_lock);
+  while( qio_pipe_nhelpers < qio_pipeline_threads ) {
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if( pthread_create(&thread, &attr, _qio_pipe_helper, NULL) != 0 ) {
+      pthread_attr_destroy(&attr);
+      // Carry on with what we have, if anything.
+      if( qio_pipe_nhelpers == 0 ) ok = 0;
+      break;
+    }
+    pthread_attr_destroy(&attr);
+    qio_pipe_nhelpers++;
+  }
+  if( ok ) {
+    if( qio_pipe_queue_tail ) qio_pipe_queue_tail->next = op;
+    else qio_pipe_queue_head = op;
+    qio_pipe_queue_tail = op;
+    pthread_cond_signal(&qio_pipe_cond);
+  }
+  pthread_mutex_unlock(&qio_pipe_lock);
 
-  read_start = _av_end_iter(ch);
+  if( ! ok ) QIO_RETURN_CONSTANT_ERROR(EAGAIN, "could not start qio helper thread");
 
-  left = amt;
-  while(left > 0) {
-    read_end = read_start;
-    qbuffer_iter_advance(&ch->buf, &read_end, left);
+  p->ops[(p->head + p->count) % p->depth] = op;
+  p->count++;
+  return 0;
+}
 
-    // Round up to whole chunk.
-    qbuffer_iter_ceil_part(&ch->buf, &read_end);
+// Waits for the oldest op and removes it from the queue.
+// The caller owns the op afterwards.
+static
+qio_pipe_op_t* _qio_pipe_pop(qio_pipeline_t* p)
+{
+  qio_pipe_op_t* op = p->ops[p->head];
 
-    QIO_GET_CONSTANT_ERROR(err, EINVAL, "read method not implemented");
-    num_read = 0;
-    switch (method) {
-      case QIO_METHOD_READWRITE:
-        err = qio_readv(ch->file, &ch->buf, read_start, read_end, &num_read);
-        break;
-      case QIO_METHOD_PREADPWRITE:
-        err = qio_preadv(ch->file, &ch->buf, read_start, read_end, read_start.offset, &num_read);
-        break;
-      case QIO_METHOD_FREADFWRITE:
-        err = qio_freadv(ch->file->fp, &ch->buf, read_start, read_end, &num_read);
-        break;
-      case QIO_METHOD_MMAP:
-      case QIO_METHOD_MEMORY:
-        // should've been handled outside this method!
-        QIO_GET_CONSTANT_ERROR(err, EINVAL, "internal error");
-        break;
-      // no default to get warnings when new methods are added
-    }
+  while( ! __atomic_load_n(&op->done, __ATOMIC_ACQUIRE) )
+    qio_task_yield();
 
-    left -= num_read;
-    qbuffer_iter_advance(&ch->buf, &read_start, num_read);
+  p->head = (p->head + 1) % p->depth;
+  p->count--;
+  return op;
+}
 
-    // Ignore interrupted system call, just keep reading.
-    if( err && qio_err_to_int(err) == EINTR ) err = 0;
+static
+void _qio_pipe_free(qio_pipeline_t* p, qio_pipe_op_t* op)
+{
+  if( op->writing && op->err && ! p->write_err )
+    p->write_err = qio_int_to_err(op->err);
+  qbytes_release(op->bytes);
+  qio_free(op);
+}
 
-    if( err ) break;
+static
+void _qio_pipe_drop_all(qio_pipeline_t* p)
+{
+  while( p->count > 0 )
+    _qio_pipe_free(p, _qio_pipe_pop(p));
+}
+
+// Returns the channel's pipeline, creating it if the channel should
+// have one, or NULL.
+static
+qio_pipeline_t* _qio_channel_pipeline(qio_channel_t* ch)
+{
+  qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+  int reading = (ch->flags & QIO_FDFLAG_READABLE) != 0;
+  int writing = (ch->flags & QIO_FDFLAG_WRITEABLE) != 0;
+  qio_pipeline_t* p;
+
+  if( ch->pipeline ) return ch->pipeline;
+
+  if( qio_pipeline_depth < 0 ) {
+#ifndef CHPL_RT_UNIT_TEST
+    qio_pipeline_depth = chpl_env_rt_get_int("QIO_PIPELINE_DEPTH", 0);
+#else
+    qio_pipeline_depth = 0;
+#endif
+  }
+
+  if( qio_pipeline_depth <= 0 ||
+      qio_pipeline_threads <= 0 ||
+      (method != QIO_METHOD_PREADPWRITE && method != QIO_METHOD_URING) ||
+      reading == writing ||
+      ch->chan_info ||
+      (ch->hints & QIO_HINT_DIRECT) ||
+      ch->file->fd == -1 )
+    return NULL;
+
+  p = (qio_pipeline_t*) qio_calloc(1, sizeof(qio_pipeline_t));
+  if( ! p ) return NULL;
+  p->ops = (qio_pipe_op_t**) qio_calloc(qio_pipeline_depth,
+                                        sizeof(qio_pipe_op_t*));
+  if( ! p->ops ) {
+    qio_free(p);
+    return NULL;
+  }
+  p->depth = qio_pipeline_depth;
+  p->next_read = -1;
+
+  ch->pipeline = p;
+  return p;
+}
+
+// Waits for everything outstanding, reporting any write error.
+static
+qioerr _qio_pipeline_drain(qio_channel_t* ch)
+{
+  qio_pipeline_t* p = ch->pipeline;
+  qioerr err;
+
+  if( ! p ) return 0;
+
+  _qio_pipe_drop_all(p);
+  err = p->write_err;
+  p->write_err = 0;
+  return err;
+}
+
+static
+qioerr _qio_pipeline_destroy(qio_channel_t* ch)
+{
+  qioerr err = _qio_pipeline_drain(ch);
+
+  if( ch->pipeline ) {
+    qio_free(ch->pipeline->ops);
+    qio_free(ch->pipeline);
+    ch->pipeline = NULL;
+  }
+  return err;
+}
+
+// Appends read-ahead data to the channel buffer until at least amt
+// bytes past av_end were added, keeping the pipeline full.  Same return
+// convention as _buffered_read_atleast.
+static
+qioerr _qio_pipeline_read(qio_channel_t* ch, qio_pipeline_t* p, int64_t amt)
+{
+  int64_t got = 0;
+  qio_pipe_op_t* op;
+  qbytes_t* bytes;
+  int64_t len;
+  qioerr err = 0;
+
+  // Read-ahead is only useful if it starts where we are now.
+  if( p->next_read < 0 ||
+      (p->count > 0 ? p->ops[p->head]->offset : p->next_read) != ch->av_end ) {
+    _qio_pipe_drop_all(p);
+    p->next_read = ch->av_end;
+  }
+
+  while( got < amt ) {
+    while( p->count < p->depth && p->next_read < ch->end_pos ) {
+      err = qbytes_create_iobuf(&bytes);
+      if( err ) break;
+      op = (qio_pipe_op_t*) qio_calloc(1, sizeof(qio_pipe_op_t));
+      if( ! op ) {
+        qbytes_release(bytes);
+        err = QIO_ENOMEM;
+        break;
+      }
+      len = bytes->len;
+      if( len > ch->end_pos - p->next_read ) len = ch->end_pos - p->next_read;
+      op->fd = ch->file->fd;
+      op->writing = 0;
+      op->bytes = bytes;
+      op->skip = 0;
+      op->len = len;
+      op->offset = p->next_read;
+      err = _qio_pipe_submit(p, op);
+      if( err ) {
+        _qio_pipe_free(p, op);
+        break;
+      }
+      p->next_read += len;
+    }
+    if( err && p->count == 0 ) return err;
+    err = 0;
+
+    if( p->count == 0 ) break; // at end_pos
+
+    op = _qio_pipe_pop(p);
+    if( op->result > 0 ) {
+      err = qbuffer_append(&ch->buf, op->bytes, 0, op->result);
+      if( ! err ) {
+        ch->av_end += op->result;
+        got += op->result;
+      }
+    }
+    if( ! err && op->err ) err = qio_int_to_err(op->err);
+    if( err || op->result < op->len ) {
+      // Error or end of file. Anything after this is no good.
+      _qio_pipe_free(p, op);
+      _qio_pipe_drop_all(p);
+      p->next_read = -1;
+      break;
+    }
+    _qio_pipe_free(p, op);
+  }
+
+  if( got >= amt ) return 0;
+  if( err ) return err;
+  return QIO_EEOF;
+}
+
+// Queues the data in [*write_start, write_end) for writing, advancing
+// *write_start past what was queued.  With flushall, waits for all of
+// it to be written.
+static
+qioerr _qio_pipeline_write(qio_channel_t* ch, qio_pipeline_t* p, qbuffer_iter_t* write_start, qbuffer_iter_t write_end, int flushall)
+{
+  qio_pipe_op_t* op;
+  qbytes_t* bytes;
+  int64_t skip;
+  int64_t len;
+  qioerr err = 0;
+
+  while( qbuffer_iter_num_bytes(*write_start, write_end) > 0 ) {
+    qbuffer_iter_get(*write_start, write_end, &bytes, &skip, &len);
+
+    if( p->count == p->depth )
+      _qio_pipe_free(p, _qio_pipe_pop(p));
+
+    op = (qio_pipe_op_t*) qio_calloc(1, sizeof(qio_pipe_op_t));
+    if( ! op ) {
+      err = QIO_ENOMEM;
+      break;
+    }
+    qbytes_retain(bytes);
+    op->fd = ch->file->fd;
+    op->writing = 1;
+    op->bytes = bytes;
+    op->skip = skip;
+    op->len = len;
+    op->offset = write_start->offset;
+    err = _qio_pipe_submit(p, op);
+    if( err ) {
+      qbytes_release(bytes);
+      qio_free(op);
+      break;
+    }
+    qbuffer_iter_advance(&ch->buf, write_start, len);
+  }
+
+  if( flushall ) _qio_pipe_drop_all(p);
+
+  if( ! err ) {
+    err = p->write_err;
+    p->write_err = 0;
+  }
+  return err;
+}
+
+// Runs read or pread, whichever is appropriate,
+// to read into the buffer.
+static
+qioerr _buffered_read_atleast(qio_channel_t* ch, int64_t amt)
+{
+  qbuffer_iter_t read_start;
+  qbuffer_iter_t read_end;
+  ssize_t num_read;
+  int64_t left = amt;
+  int64_t want;
+  int64_t max_amt;
+  int return_eof = 0;
+  qioerr err;
+  qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+
+  err = _qio_channel_needbuffer_unlocked(ch);
+  if( err ) return err;
+
+  // do not exceed end_pos.
+  max_amt = INT64_MAX;
+  if( ch->end_pos < INT64_MAX ) {
+    max_amt = ch->end_pos - ch->av_end;
+    if( max_amt < 0 ) max_amt = 0; // handle channel position beyond end
+  }
+
+  if( amt > max_amt ) {
+    amt = max_amt;
+    return_eof = 1;
+  }
+
+  if (ch->chan_info) {
+    return _qio_plugin_ops(ch->file)->read_atleast(ch->chan_info, amt);
+  }
+
+  if( qbuffer_end_offset(&ch->buf) == ch->av_end ) {
+    qio_pipeline_t* p = _qio_channel_pipeline(ch);
+    if( p ) {
+      err = _qio_pipeline_read(ch, p, amt);
+      if( err ) return err;
+      if( return_eof ) return QIO_EEOF;
+      else return 0;
+    }
+  }
+
+  // With io_uring, read ahead by several iobufs so that they are all in
+  // flight at once.  Running out of file during the read-ahead part is
+  // not an error.
+  want = amt;
+  if( method == QIO_METHOD_URING ) {
+    int64_t ra = qio_uring_readahead_iobufs * qbytes_iobuf_size;
+    if( want < ra ) want = ra;
+    if( want > max_amt ) want = max_amt;
+  }
+
+  //printf("Allocating bufferspace %lli\n", (long long int) amt);
+  err = _buffered_allocate_bufferspace(ch, want, max_amt);
+  if( err ) return err;
+
+  read_start = _av_end_iter(ch);
+
+  left = want;
+  while(left > 0) {
+    read_end = read_start;
+    qbuffer_iter_advance(&ch->buf, &read_end, left);
+
+    // Round up to whole chunk.
+    qbuffer_iter_ceil_part(&ch->buf, &read_end);
+
+    QIO_GET_CONSTANT_ERROR(err, EINVAL, "read method not implemented");
+    num_read = 0;
+    switch (method) {
+      case QIO_METHOD_READWRITE:
+        err = qio_readv(ch->file, &ch->buf, read_start, read_end, &num_read);
+        break;
+      case QIO_METHOD_PREADPWRITE:
+        err = qio_preadv(ch->file, &ch->buf, read_start, read_end, read_start.offset, &num_read);
+        break;
+      case QIO_METHOD_URING:
+        err = qio_uring_preadv(ch->file, &ch->buf, read_start, read_end, read_start.offset, &num_read);
+        break;
+      case QIO_METHOD_FREADFWRITE:
+        err = qio_freadv(ch->file->fp, &ch->buf, read_start, read_end, &num_read);
+        break;
+      case QIO_METHOD_MMAP:
+      case QIO_METHOD_MEMORY:
+        // should've been handled outside this method!
+        QIO_GET_CONSTANT_ERROR(err, EINVAL, "internal error");
+        break;
+      // no default to get warnings when new methods are added
+    }
+
+    left -= num_read;
+    qbuffer_iter_advance(&ch->buf, &read_start, num_read);
+
+    // Ignore interrupted system call, just keep reading.
+    if( err && qio_err_to_int(err) == EINTR ) err = 0;
+
+    if( err ) {
+      if( qio_err_to_int(err) == EEOF && want - left >= amt ) err = 0;
+      break;
+    }
   }
 
   ch->av_end = read_start.offset;
@@ -2648,6 +3419,8 @@ qioerr _qio_buffered_behind(qio_channel_t* ch, int flushall)
 
   if (nbytes == 0) {
     err = 0;
+    // Anything written behind has to be out before a full flush is done.
+    if( flushall ) err = _qio_pipeline_drain(ch);
     goto done;
   }
 
@@ -2655,7 +3428,7 @@ qioerr _qio_buffered_behind(qio_channel_t* ch, int flushall)
   //debug_print_qbuffer(&ch->buf);
 
   if (ch->chan_info && (ch->flags & QIO_FDFLAG_WRITEABLE)) {
-    return chpl_qio_write(ch->chan_info, nbytes);
+    return _qio_plugin_ops(ch->file)->write(ch->chan_info, nbytes);
   }
 
   if(ch->hints & QIO_HINT_DIRECT) {
@@ -2664,6 +3437,11 @@ qioerr _qio_buffered_behind(qio_channel_t* ch, int flushall)
   }
 
   if(ch->flags & QIO_FDFLAG_WRITEABLE) {
+    qio_pipeline_t* p = _qio_channel_pipeline(ch);
+    if( p ) {
+      err = _qio_pipeline_write(ch, p, &write_start, write_end, flushall);
+      goto error;
+    }
     while( qbuffer_iter_num_bytes(write_start, write_end) > 0 ) {
       QIO_GET_CONSTANT_ERROR(err, EINVAL, "write method not implemented");
       num_written = 0;
@@ -2674,6 +3452,9 @@ qioerr _qio_buffered_behind(qio_channel_t* ch, int flushall)
         case QIO_METHOD_PREADPWRITE:
           err = qio_pwritev(ch->file, &ch->buf, write_start, write_end, write_start.offset, &num_written);
           break;
+        case QIO_METHOD_URING:
+          err = qio_uring_pwritev(ch->file, &ch->buf, write_start, write_end, write_start.offset, &num_written);
+          break;
         case QIO_METHOD_FREADFWRITE:
           err = qio_fwritev(ch->file->fp, &ch->buf, write_start, write_end, &num_written);
           break;
@@ -2869,6 +3650,69 @@ error:
   return err;
 }
 
+// Positional read/write for unbuffered channels.  For QIO_HINT_DIRECT
+// files, the aligned middle of a transfer uses the O_DIRECT descriptor
+// (through an aligned iobuf if ptr itself isn't aligned) and an
+// unaligned head or tail uses file->nodirect_fd.  Like sys_pread and
+// sys_pwrite, this may move fewer than len bytes.
+static
+err_t _qio_unbuffered_pio(qio_file_t* file, int writing, void* ptr, size_t len, off_t offset, ssize_t* num_out)
+{
+  size_t align = qio_direct_align;
+  fd_t fd = file->fd;
+
+  if( (file->hints & QIO_HINT_DIRECT) && align > 0 ) {
+    size_t head = (align - (size_t) offset % align) % align;
+
+    if( head > 0 || len < align ) {
+      if( file->nodirect_fd != -1 ) fd = file->nodirect_fd;
+      if( head > 0 && head < len ) len = head;
+    } else {
+      len -= len % align;
+
+      if( ((uintptr_t) ptr) % align != 0 ) {
+        qbytes_t* bounce;
+
+        if( qbytes_iobuf_size >= align && qbytes_create_iobuf(&bounce) == 0 ) {
+          size_t chunk = bounce->len - bounce->len % align;
+          ssize_t total = 0;
+          ssize_t got;
+          err_t err = 0;
+
+          while( (size_t) total < len ) {
+            size_t n = len - total;
+            if( n > chunk ) n = chunk;
+            got = 0;
+            if( writing ) {
+              qio_memcpy(bounce->data, qio_ptr_add(ptr, total), n);
+              err = sys_pwrite(fd, bounce->data, n, offset + total, &got);
+            } else {
+              err = sys_pread(fd, bounce->data, n, offset + total, &got);
+              if( ! err ) qio_memcpy(qio_ptr_add(ptr, total), bounce->data, got);
+            }
+            if( err ) break;
+            total += got;
+            if( (size_t) got != n ) break;
+          }
+          qbytes_release(bounce);
+
+          // Like a short read or write, report what was done first.
+          if( total > 0 ) err = 0;
+          *num_out = total;
+          return err;
+        }
+
+        if( file->nodirect_fd != -1 ) fd = file->nodirect_fd;
+      }
+    }
+  }
+
+  if( writing )
+    return sys_pwrite(fd, ptr, len, offset, num_out);
+  else
+    return sys_pread(fd, ptr, len, offset, num_out);
+}
+
 static
 qioerr _qio_unbuffered_write(qio_channel_t* ch, const void* ptr, ssize_t len_in, ssize_t *amt_written)
 {
@@ -2911,7 +3755,8 @@ qioerr _qio_unbuffered_write(qio_channel_t* ch, const void* ptr, ssize_t len_in,
         case QIO_METHOD_MMAP: // mmap uses pread/pwrite when we're
                               // outside the mmap'd region.
         case QIO_METHOD_PREADPWRITE:
-          err = qio_int_to_err(sys_pwrite(ch->file->fd, ptr, len, _right_mark_start(ch), &num_written));
+        case QIO_METHOD_URING: // a single write gains nothing from a ring
+          err = qio_int_to_err(_qio_unbuffered_pio(ch->file, 1, (void*) ptr, len, _right_mark_start(ch), &num_written));
           break;
         case QIO_METHOD_FREADFWRITE:
           if( ch->file->fp ) {
@@ -2989,7 +3834,8 @@ qioerr _qio_unbuffered_read(qio_channel_t* ch, void* ptr, ssize_t len_in, ssize_
   len = len_in;
 
   if( ch->file->mmap &&
-      (method == QIO_METHOD_PREADPWRITE || method == QIO_METHOD_MMAP) &&
+      (method == QIO_METHOD_PREADPWRITE || method == QIO_METHOD_MMAP ||
+       method == QIO_METHOD_URING) &&
       _right_mark_start(ch) + len <= ch->file->mmap->len) {
     // As long as we're using an I/O method that seeks on every read,
     // copy the data out of the mmap.
@@ -3005,7 +3851,8 @@ qioerr _qio_unbuffered_read(qio_channel_t* ch, void* ptr, ssize_t len_in, ssize_
           break;
         case QIO_METHOD_MMAP:
         case QIO_METHOD_PREADPWRITE:
-          err = qio_int_to_err(sys_pread(ch->file->fd, ptr, len, _right_mark_start(ch), &num_read));
+        case QIO_METHOD_URING:
+          err = qio_int_to_err(_qio_unbuffered_pio(ch->file, 0, ptr, len, _right_mark_start(ch), &num_read));
           break;
         case QIO_METHOD_FREADFWRITE:
           if( ch->file->fp ) {
@@ -3502,68 +4349,590 @@ qioerr qio_channel_put_buffer(const int threadsafe, qio_channel_t* ch, qbuffer_t
   return err;
 }
 
-// you don't have to call end_peek_buffer if this returns an error
-qioerr qio_channel_begin_peek_buffer(const int threadsafe, qio_channel_t* ch, int64_t require, int writing, qbuffer_t** buf_out, qbuffer_iter_t* start_out, qbuffer_iter_t* end_out)
+// Can ch's data be moved straight to or from its fd?  That needs a
+// buffered fd channel whose fd position (or offset, for positional
+// methods) is all that matters once its buffer has been moved/flushed.
+static
+int _qio_channel_can_copy_fd(qio_channel_t* ch)
 {
-  qioerr err;
+  qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
 
-  *buf_out = NULL;
+  if( ch->chan_info || ch->file->fd == -1 ) return 0;
+  if( ch->mark_cur != 0 ) return 0;
+  if( ch->bit_buffer_bits != 0 || ch->bits_read_bytes != 0 ) return 0;
 
-  if( threadsafe ) {
-    err = qio_lock(&ch->lock);
-    if( err ) {
-      return err;
-    }
-  }
+  return method == QIO_METHOD_READWRITE ||
+         method == QIO_METHOD_PREADPWRITE ||
+         method == QIO_METHOD_URING;
+}
 
-  // require calls needbuffer_unlocked and advance_cached.
-  err = _qio_channel_require_unlocked(ch, require, writing);
-  if( err ) {
-    _qio_channel_set_error_unlocked(ch, err);
-    qio_unlock(&ch->lock);
-    return err;
-  }
+// Empties ch's buffer and puts its position at pos.  Anything in the
+// buffer has to have been written or consumed already.
+static
+void _qio_channel_reset_buffer_at(qio_channel_t* ch, int64_t pos)
+{
+  qbuffer_trim_back(&ch->buf, qbuffer_end_offset(&ch->buf) -
+                              qbuffer_start_offset(&ch->buf));
+  qbuffer_reposition(&ch->buf, pos);
+  _set_right_mark_start(ch, pos);
+  ch->av_end = pos;
+  _qio_buffered_setup_cached(ch);
+}
 
-  *buf_out = &ch->buf;
-  *start_out = _right_mark_start_iter(ch);
-  *end_out = _av_end_iter(ch);
+// Moves up to max bytes that src has read but not returned into dst.
+// The qbytes are shared, not copied.
+static
+qioerr _qio_transfer_available(qio_channel_t* dst, qio_channel_t* src, int64_t max, int64_t* moved_out)
+{
+  qbuffer_iter_t start;
+  qbuffer_iter_t end;
+  int64_t n;
+  qioerr err;
 
-  err = 0;
+  *moved_out = 0;
 
-  return err;
-}
+  _qio_buffered_advance_cached(src);
 
+  n = src->av_end - _right_mark_start(src);
+  if( n > max ) n = max;
+  if( n > dst->end_pos - qio_channel_offset_unlocked(dst) )
+    n = dst->end_pos - qio_channel_offset_unlocked(dst);
+  if( n <= 0 ) return 0;
 
-qioerr _qio_buffered_behind(qio_channel_t* ch, int flushall);
+  start = _right_mark_start_iter(src);
+  end = start;
+  qbuffer_iter_advance(&src->buf, &end, n);
 
-qioerr qio_channel_end_peek_buffer(const int threadsafe, qio_channel_t* ch, int64_t advance)
+  err = _qio_channel_put_buffer_unlocked(dst, &src->buf, start, end);
+  if( err ) return err;
+
+  _add_right_mark_start(src, n);
+  *moved_out = n;
+
+  // Let go of the parts src no longer needs.
+  return _qio_buffered_behind(src, false);
+}
+
+static
+qioerr _qio_channel_transfer_unlocked(qio_channel_t* dst, qio_channel_t* src, int64_t len, int64_t* num_out)
 {
+  qio_method_t src_method = (qio_method_t) (src->hints & QIO_METHODMASK);
+  qio_method_t dst_method = (qio_method_t) (dst->hints & QIO_METHODMASK);
+  int until_eof = len < 0;
+  int64_t done = 0;
+  int64_t moved;
+  int eof = 0;
   qioerr err;
 
-  if( ! qbuffer_is_initialized(&ch->buf) ) {
-    QIO_GET_CONSTANT_ERROR(err, EINVAL, "internal error");
-    goto error;
+  *num_out = 0;
+
+  if( ! (src->flags & QIO_FDFLAG_READABLE) )
+    QIO_RETURN_CONSTANT_ERROR(EBADF, "not readable");
+  if( ! (dst->flags & QIO_FDFLAG_WRITEABLE) )
+    QIO_RETURN_CONSTANT_ERROR(EBADF, "not writeable");
+
+  if( until_eof ) len = INT64_MAX;
+
+  err = _qio_channel_needbuffer_unlocked(src);
+  if( err ) return err;
+  err = _qio_channel_needbuffer_unlocked(dst);
+  if( err ) return err;
+
+  // First, whatever src has already read.
+  err = _qio_transfer_available(dst, src, len, &moved);
+  if( err ) return err;
+  done += moved;
+
+  // Then let the kernel move the data between the fds, if it can.
+  if( done < len &&
+      _qio_channel_can_copy_fd(src) && _qio_channel_can_copy_fd(dst) &&
+      src->av_end == _right_mark_start(src) ) {
+    int src_positional = src_method != QIO_METHOD_READWRITE;
+    int dst_positional = dst_method != QIO_METHOD_READWRITE;
+    off_t spos;
+    off_t dpos;
+    int64_t n;
+    ssize_t got;
+    err_t rc;
+
+    err = _qio_channel_flush_qio_unlocked(dst);
+    if( err ) goto done;
+    err = _qio_pipeline_drain(src); // drops any read-ahead
+    if( err ) goto done;
+
+    spos = _right_mark_start(src);
+    dpos = _right_mark_start(dst);
+    _qio_channel_reset_buffer_at(src, spos);
+    _qio_channel_reset_buffer_at(dst, dpos);
+
+    while( done < len ) {
+      n = len - done;
+      if( n > src->end_pos - (int64_t) spos ) n = src->end_pos - spos;
+      if( n > dst->end_pos - (int64_t) dpos ) n = dst->end_pos - dpos;
+      if( n > 1024*1024*1024 ) n = 1024*1024*1024;
+      if( n <= 0 ) break;
+
+      got = 0;
+      rc = sys_copy_fd(src->file->fd, src_positional ? &spos : NULL,
+                       dst->file->fd, dst_positional ? &dpos : NULL,
+                       n, &got);
+      if( rc == EINTR ) continue;
+      if( rc == ENOSYS ) break; // carry on below
+      if( rc ) {
+        err = qio_int_to_err(rc);
+        break;
+      }
+      if( got == 0 ) {
+        eof = 1;
+        break;
+      }
+      if( ! src_positional ) spos += got;
+      if( ! dst_positional ) dpos += got;
+      done += got;
+    }
+
+    _qio_channel_reset_buffer_at(src, spos);
+    _qio_channel_reset_buffer_at(dst, dpos);
+    if( err ) goto done;
   }
 
-  _add_right_mark_start(ch, advance);
+  // Otherwise read into src's buffer and hand its qbytes to dst.
+  while( ! eof && done < len ) {
+    if( qio_channel_offset_unlocked(dst) >= dst->end_pos ) break;
 
-  err = _qio_buffered_behind(ch, false);
+    err = _qio_channel_require_unlocked(src, 1, 0);
+    if( qio_err_to_int(err) == EEOF ) {
+      err = 0;
+      eof = 1;
+      break;
+    }
+    if( err ) break;
 
-error:
-  _qio_channel_set_error_unlocked(ch, err);
-  if( threadsafe ) {
-    qio_unlock(&ch->lock);
+    err = _qio_transfer_available(dst, src, len - done, &moved);
+    if( err ) break;
+    if( moved == 0 ) break;
+    done += moved;
   }
 
-  return err;
+done:
+  *num_out = done;
+  if( err ) return err;
+  if( ! until_eof && done < len ) return QIO_EEOF;
+  return 0;
 }
 
-qioerr qio_channel_advance_past_byte(const int threadsafe, qio_channel_t* ch, int byte)
+qioerr qio_channel_transfer(const int threadsafe, qio_channel_t* dst, qio_channel_t* src, int64_t len, int64_t* num_out)
 {
-  qioerr err=0;
+  qio_channel_t* first = dst < src ? dst : src;
+  qio_channel_t* second = dst < src ? src : dst;
+  qioerr err;
+
+  if( dst == src ) QIO_RETURN_CONSTANT_ERROR(EINVAL, "same channel");
 
+  // Always lock in the same order so two transfers can't deadlock.
   if( threadsafe ) {
-    err = qio_lock(&ch->lock);
+    err = qio_lock(&first->lock);
+    if( err ) return err;
+    err = qio_lock(&second->lock);
+    if( err ) {
+      qio_unlock(&first->lock);
+      return err;
+    }
+  }
+
+  err = _qio_channel_transfer_unlocked(dst, src, len, num_out);
+
+  if( threadsafe ) {
+    qio_unlock(&second->lock);
+    qio_unlock(&first->lock);
+  }
+
+  return err;
+}
+
+static inline
+uint16_t _qio_bswap16(uint16_t x)
+{
+  return (uint16_t) ((x >> 8) | (x << 8));
+}
+
+static inline
+uint32_t _qio_bswap32(uint32_t x)
+{
+  return ((x & 0xff000000u) >> 24) | ((x & 0x00ff0000u) >>  8) |
+         ((x & 0x0000ff00u) <<  8) | ((x & 0x000000ffu) << 24);
+}
+
+static inline
+uint64_t _qio_bswap64(uint64_t x)
+{
+  return ((uint64_t) _qio_bswap32((uint32_t) x) << 32) |
+         _qio_bswap32((uint32_t) (x >> 32));
+}
+
+// Reverses the bytes of each of the count elt_size-byte elements at ptr.
+static
+void _qio_bswap_array(void* ptr, size_t elt_size, size_t count)
+{
+  size_t i = 0;
+
+  if( elt_size < 2 ) return;
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+  {
+    unsigned char* p = (unsigned char*) ptr;
+    size_t nbytes = elt_size * count;
+    size_t b = 0;
+    // byte shuffles for one 16-byte lane
+    static const unsigned char rev[3][16] = {
+      { 1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14 },
+      { 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12 },
+      { 7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8 },
+    };
+    const unsigned char* r = rev[elt_size == 2 ? 0 : elt_size == 4 ? 1 : 2];
+    __m128i mask = _mm_loadu_si128((const __m128i*) r);
+#if defined(__AVX2__)
+    __m256i mask2 = _mm256_broadcastsi128_si256(mask);
+    for( ; b + 32 <= nbytes; b += 32 ) {
+      __m256i v = _mm256_loadu_si256((const __m256i*) (p + b));
+      _mm256_storeu_si256((__m256i*) (p + b), _mm256_shuffle_epi8(v, mask2));
+    }
+#endif
+    for( ; b + 16 <= nbytes; b += 16 ) {
+      __m128i v = _mm_loadu_si128((const __m128i*) (p + b));
+      _mm_storeu_si128((__m128i*) (p + b), _mm_shuffle_epi8(v, mask));
+    }
+    i = b / elt_size;
+  }
+#endif
+
+  switch( elt_size ) {
+    case 2:
+    {
+      uint16_t* p = (uint16_t*) ptr;
+      for( ; i < count; i++ ) p[i] = _qio_bswap16(p[i]);
+      break;
+    }
+    case 4:
+    {
+      uint32_t* p = (uint32_t*) ptr;
+      for( ; i < count; i++ ) p[i] = _qio_bswap32(p[i]);
+      break;
+    }
+    case 8:
+    {
+      uint64_t* p = (uint64_t*) ptr;
+      for( ; i < count; i++ ) p[i] = _qio_bswap64(p[i]);
+      break;
+    }
+  }
+}
+
+// Does an array in byteorder need swapping to or from this machine's?
+static inline
+int _qio_array_needs_swap(int byteorder)
+{
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+  return byteorder == QIO_BIG;
+#else
+  return byteorder == QIO_LITTLE;
+#endif
+}
+
+// Can a len-byte read or write skip ch's buffer?  Only worth it for at
+// least an iobuf, and only for channels qio_channel_transfer could
+// hand to the kernel.
+static
+int _qio_channel_can_bypass_buffer(qio_channel_t* ch, ssize_t len, int writing)
+{
+  int reading = (ch->flags & QIO_FDFLAG_READABLE) != 0;
+
+  if( len < (ssize_t) qbytes_iobuf_size ) return 0;
+  if( writing == reading ) return 0;
+  if( writing && ! (ch->flags & QIO_FDFLAG_WRITEABLE) ) return 0;
+  if( ! _use_buffered(ch, len) ) return 0;
+
+  return _qio_channel_can_copy_fd(ch);
+}
+
+// Reads len bytes into ptr, reading large requests straight from the
+// file into ptr after copying out what the channel has buffered.
+static
+qioerr _qio_channel_read_bypass_unlocked(qio_channel_t* ch, void* ptr, ssize_t len, ssize_t* num_out)
+{
+  qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+  ssize_t done = 0;
+  ssize_t got;
+  int64_t pos;
+  qioerr err;
+
+  *num_out = 0;
+
+  if( ! _qio_channel_can_bypass_buffer(ch, len, 0) )
+    return qio_channel_read(false, ch, ptr, len, num_out);
+
+  err = _qio_channel_needbuffer_unlocked(ch);
+  if( err ) return err;
+
+  // First, whatever the channel has already read.
+  _qio_buffered_advance_cached(ch);
+  got = ch->av_end - _right_mark_start(ch);
+  if( got > len ) got = len;
+  if( got > 0 ) {
+    err = qio_channel_read(false, ch, ptr, got, &got);
+    done = got;
+    if( err || done == len ) goto done;
+  }
+
+  err = _qio_pipeline_drain(ch); // drops any read-ahead
+  if( err ) goto done;
+
+  pos = _right_mark_start(ch);
+  _qio_channel_reset_buffer_at(ch, pos);
+
+  while( done < len ) {
+    ssize_t n = len - done;
+    err_t rc;
+
+    if( n > ch->end_pos - pos ) n = ch->end_pos - pos;
+    if( n <= 0 ) {
+      err = QIO_EEOF;
+      break;
+    }
+
+    got = 0;
+    if( method == QIO_METHOD_READWRITE )
+      rc = sys_read(ch->file->fd, qio_ptr_add(ptr, done), n, &got);
+    else
+      rc = _qio_unbuffered_pio(ch->file, 0, qio_ptr_add(ptr, done), n, pos, &got);
+    if( rc == EINTR ) continue;
+    if( rc ) {
+      err = qio_int_to_err(rc);
+      break;
+    }
+    if( got == 0 ) {
+      err = QIO_EEOF;
+      break;
+    }
+    pos += got;
+    done += got;
+  }
+
+  _qio_channel_reset_buffer_at(ch, pos);
+  _qio_channel_set_error_unlocked(ch, err);
+
+done:
+  *num_out = done;
+  return err;
+}
+
+// Writes len bytes from ptr, writing large requests straight to the
+// file after flushing what the channel has buffered.
+static
+qioerr _qio_channel_write_bypass_unlocked(qio_channel_t* ch, const void* ptr, ssize_t len)
+{
+  qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+  ssize_t done = 0;
+  ssize_t got;
+  int64_t pos;
+  qioerr err;
+
+  if( ! _qio_channel_can_bypass_buffer(ch, len, 1) )
+    return qio_channel_write_amt(false, ch, ptr, len);
+
+  err = _qio_channel_needbuffer_unlocked(ch);
+  if( err ) return err;
+
+  err = _qio_channel_flush_qio_unlocked(ch);
+  if( err ) return err;
+
+  pos = _right_mark_start(ch);
+  _qio_channel_reset_buffer_at(ch, pos);
+
+  while( done < len ) {
+    ssize_t n = len - done;
+    err_t rc;
+
+    if( n > ch->end_pos - pos ) n = ch->end_pos - pos;
+    if( n <= 0 ) {
+      err = QIO_EEOF;
+      break;
+    }
+
+    got = 0;
+    if( method == QIO_METHOD_READWRITE )
+      rc = sys_write(ch->file->fd, qio_ptr_add((void*) ptr, done), n, &got);
+    else
+      rc = _qio_unbuffered_pio(ch->file, 1, qio_ptr_add((void*) ptr, done), n, pos, &got);
+    if( rc == EINTR ) continue;
+    if( rc == 0 && got == 0 ) rc = EIO;
+    if( rc ) {
+      err = qio_int_to_err(rc);
+      break;
+    }
+    pos += got;
+    done += got;
+  }
+
+  _qio_channel_reset_buffer_at(ch, pos);
+  _qio_channel_set_error_unlocked(ch, err);
+  return err;
+}
+
+static
+qioerr _qio_check_array_args(size_t elt_size, ssize_t count)
+{
+  if( elt_size != 1 && elt_size != 2 && elt_size != 4 && elt_size != 8 )
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "bad element size");
+  if( count < 0 )
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "negative count");
+  if( (size_t) count > SSIZE_MAX / elt_size )
+    QIO_RETURN_CONSTANT_ERROR(EOVERFLOW, "array too large");
+  return 0;
+}
+
+qioerr qio_channel_read_array(const int threadsafe, const int byteorder, qio_channel_t* restrict ch, void* restrict ptr, size_t elt_size, ssize_t count, ssize_t* restrict num_read_out)
+{
+  ssize_t got = 0;
+  ssize_t n;
+  qioerr err;
+
+  *num_read_out = 0;
+
+  err = _qio_check_array_args(elt_size, count);
+  if( err ) return err;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) return err;
+  }
+
+  err = _qio_channel_read_bypass_unlocked(ch, ptr, count * elt_size, &got);
+
+  // Only whole elements were read.
+  n = got / elt_size;
+  if( _qio_array_needs_swap(byteorder) ) _qio_bswap_array(ptr, elt_size, n);
+  *num_read_out = n;
+
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
+qioerr qio_channel_write_array(const int threadsafe, const int byteorder, qio_channel_t* restrict ch, const void* restrict ptr, size_t elt_size, ssize_t count)
+{
+  ssize_t len;
+  qioerr err;
+
+  err = _qio_check_array_args(elt_size, count);
+  if( err ) return err;
+
+  len = count * elt_size;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) return err;
+  }
+
+  if( ! _qio_array_needs_swap(byteorder) || elt_size == 1 ) {
+    err = _qio_channel_write_bypass_unlocked(ch, ptr, len);
+  } else {
+    // Swap a chunk at a time in a scratch buffer.
+    char small[1024];
+    ssize_t chunk = 16 * qbytes_iobuf_size;
+    ssize_t done;
+    char* tmp = small;
+
+    chunk -= chunk % elt_size;
+    if( len <= (ssize_t) sizeof(small) ) chunk = sizeof(small);
+    else tmp = (char*) qio_malloc(chunk);
+
+    if( ! tmp ) err = QIO_ENOMEM;
+
+    for( done = 0; ! err && done < len; done += chunk ) {
+      ssize_t n = len - done;
+      if( n > chunk ) n = chunk;
+      qio_memcpy(tmp, qio_ptr_add((void*) ptr, done), n);
+      _qio_bswap_array(tmp, elt_size, n / elt_size);
+      err = _qio_channel_write_bypass_unlocked(ch, tmp, n);
+    }
+
+    if( tmp != small ) qio_free(tmp);
+  }
+
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
+// you don't have to call end_peek_buffer if this returns an error
+qioerr qio_channel_begin_peek_buffer(const int threadsafe, qio_channel_t* ch, int64_t require, int writing, qbuffer_t** buf_out, qbuffer_iter_t* start_out, qbuffer_iter_t* end_out)
+{
+  qioerr err;
+
+  *buf_out = NULL;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) {
+      return err;
+    }
+  }
+
+  // require calls needbuffer_unlocked and advance_cached.
+  err = _qio_channel_require_unlocked(ch, require, writing);
+  if( err ) {
+    _qio_channel_set_error_unlocked(ch, err);
+    if( threadsafe ) {
+      qio_unlock(&ch->lock);
+    }
+    return err;
+  }
+
+  *buf_out = &ch->buf;
+  *start_out = _right_mark_start_iter(ch);
+  *end_out = _av_end_iter(ch);
+
+  err = 0;
+
+  return err;
+}
+
+
+qioerr _qio_buffered_behind(qio_channel_t* ch, int flushall);
+
+qioerr qio_channel_end_peek_buffer(const int threadsafe, qio_channel_t* ch, int64_t advance)
+{
+  qioerr err;
+
+  if( ! qbuffer_is_initialized(&ch->buf) ) {
+    QIO_GET_CONSTANT_ERROR(err, EINVAL, "internal error");
+    goto error;
+  }
+
+  _add_right_mark_start(ch, advance);
+
+  err = _qio_buffered_behind(ch, false);
+
+error:
+  _qio_channel_set_error_unlocked(ch, err);
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
+qioerr qio_channel_advance_past_byte(const int threadsafe, qio_channel_t* ch, int byte)
+{
+  qioerr err=0;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
     if( err ) {
       return err;
     }
@@ -3603,6 +4972,128 @@ qioerr qio_channel_advance_past_byte(const int threadsafe, qio_channel_t* ch, in
 }
 
 
+// Records the offsets (relative to ptr) of up to max_offsets occurrences
+// of byte in ptr[0..len), returning how many were recorded.  Compares a
+// vector's worth of bytes at a time where the platform has that.
+size_t qio_find_byte_offsets(const void* ptr, size_t len, int byte, int64_t* offsets, size_t max_offsets)
+{
+  const unsigned char* p = (const unsigned char*) ptr;
+  size_t i = 0;
+  size_t n = 0;
+
+  if( max_offsets == 0 ) return 0;
+
+#if defined(__AVX2__)
+  {
+    __m256i want = _mm256_set1_epi8((char) byte);
+    for( ; i + 32 <= len; i += 32 ) {
+      __m256i v = _mm256_loadu_si256((const __m256i*) (p + i));
+      uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, want));
+      while( mask ) {
+        offsets[n++] = i + __builtin_ctz(mask);
+        if( n == max_offsets ) return n;
+        mask &= mask - 1;
+      }
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  {
+    __m128i want = _mm_set1_epi8((char) byte);
+    for( ; i + 16 <= len; i += 16 ) {
+      __m128i v = _mm_loadu_si128((const __m128i*) (p + i));
+      uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, want));
+      while( mask ) {
+        offsets[n++] = i + __builtin_ctz(mask);
+        if( n == max_offsets ) return n;
+        mask &= mask - 1;
+      }
+    }
+  }
+#elif defined(__ARM_NEON)
+  {
+    uint8x16_t want = vdupq_n_u8((uint8_t) byte);
+    for( ; i + 16 <= len; i += 16 ) {
+      uint8x16_t eq = vceqq_u8(vld1q_u8(p + i), want);
+      // Narrow to 4 bits per byte so the result fits in 64 bits.
+      uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+                        vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+      while( mask ) {
+        offsets[n++] = i + (__builtin_ctzll(mask) >> 2);
+        if( n == max_offsets ) return n;
+        mask &= ~((uint64_t) 0xf << (__builtin_ctzll(mask) & ~3));
+      }
+    }
+  }
+#endif
+
+  // Whatever is left (or everything, without vectors).
+  while( i < len ) {
+    const unsigned char* found = memchr(p + i, byte, len - i);
+    if( ! found ) break;
+    i = found - p;
+    offsets[n++] = i;
+    if( n == max_offsets ) return n;
+    i++;
+  }
+
+  return n;
+}
+
+qioerr qio_channel_find_byte_offsets(const int threadsafe, qio_channel_t* ch, int byte, int64_t* offsets, size_t max_offsets, size_t* num_out)
+{
+  qbuffer_iter_t start;
+  qbuffer_iter_t end;
+  qbytes_t* bytes;
+  int64_t skip;
+  int64_t len;
+  int64_t pos;
+  size_t n = 0;
+  size_t got;
+  size_t i;
+  qioerr err;
+
+  *num_out = 0;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) return err;
+  }
+
+  // Make sure something is buffered; require calls advance_cached.
+  err = _qio_channel_require_unlocked(ch, 1, 0);
+  if( err ) goto unlock;
+
+  pos = _right_mark_start(ch);
+  start = _right_mark_start_iter(ch);
+  end = _av_end_iter(ch);
+  if( ch->av_end > ch->end_pos ) {
+    end = start;
+    qbuffer_iter_advance(&ch->buf, &end, ch->end_pos - pos);
+  }
+
+  while( n < max_offsets && qbuffer_iter_num_bytes(start, end) > 0 ) {
+    qbuffer_iter_get(start, end, &bytes, &skip, &len);
+    got = qio_find_byte_offsets(qio_ptr_add(bytes->data, skip), len, byte,
+                                offsets + n, max_offsets - n);
+    for( i = n; i < n + got; i++ ) offsets[i] += pos;
+    n += got;
+    pos += len;
+    qbuffer_iter_next_part(&ch->buf, &start);
+  }
+
+  *num_out = n;
+
+unlock:
+  _qio_channel_set_error_unlocked(ch, err);
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
+
 qioerr qio_channel_mark_maybe_flush_bits(const int threadsafe, qio_channel_t* ch, int flushbits)
 {
   qioerr err;
@@ -4398,7 +5889,7 @@ qioerr qio_get_chunk(qio_file_t* fl, int64_t* len_out)
   sys_statfs_t s;
 
   if (fl->file_info) {
-    err = chpl_qio_get_chunk(fl->file_info, len_out);
+    err = _qio_plugin_ops(fl)->get_chunk(fl->file_info, len_out);
   } else {
     fd = fl->fd;
     if (fl->fp) fd = fileno(fl->fp);
@@ -4431,7 +5922,7 @@ qioerr qio_locales_for_region(qio_file_t* fl, off_t start, off_t end, const char
   qioerr err = 0;
   if (fl->file_info) {
     void* tmp = NULL;
-    err = chpl_qio_get_locales_for_region(fl->file_info, start, end, &tmp, num_locs_out);
+    err = _qio_plugin_ops(fl)->get_locales_for_region(fl->file_info, start, end, &tmp, num_locs_out);
     *loc_names_out = (const char**) tmp;
     return err;
   } else {
@@ -4440,3 +5931,185 @@ qioerr qio_locales_for_region(qio_file_t* fl, off_t start, off_t end, const char
   }
 }
 
+// Does node name 'a' name the same host as 'b'?  A name without a domain
+// matches the same name with one.
+static
+int _qio_same_host(const char* a, const char* b)
+{
+  size_t la = strcspn(a, ".");
+  size_t lb = strcspn(b, ".");
+
+  if( 0 == strcmp(a, b) ) return 1;
+  if( (a[la] != '\0') == (b[lb] != '\0') ) return 0; // both or neither short
+  return la == lb && 0 == strncmp(a, b, la);
+}
+
+qioerr qio_plan_parallel_read(qio_file_t* fl, int64_t start, int64_t end, int64_t num_nodes, const char** node_names, int64_t min_chunk, qio_read_plan_t** plan_out)
+{
+  qio_read_plan_t* plan = NULL;
+  int64_t* load = NULL;
+  int64_t fs_chunk = 0;
+  int64_t chunk;
+  int64_t len = end - start;
+  int64_t fair;
+  int64_t n, i, j, k;
+  int64_t pos;
+  int64_t cur;
+  qioerr err;
+
+  *plan_out = NULL;
+
+  if( len < 0 || num_nodes <= 0 ) {
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "invalid region or node count");
+  }
+
+  // Chunks are a multiple of the file system's chunk (e.g. the Lustre
+  // stripe size), a few per node, and at least min_chunk bytes.
+  err = qio_get_chunk(fl, &fs_chunk);
+  if( err || fs_chunk <= 0 ) fs_chunk = 1;
+  if( min_chunk <= 0 ) min_chunk = qio_parallel_read_min_chunk;
+  chunk = len / (4 * num_nodes);
+  if( chunk < min_chunk ) chunk = min_chunk;
+  if( chunk < fs_chunk ) chunk = fs_chunk;
+  chunk = ((chunk + fs_chunk - 1) / fs_chunk) * fs_chunk;
+
+  // Boundaries are at file offsets that are multiples of chunk.
+  n = 0;
+  if( len > 0 ) n = (end - 1) / chunk - start / chunk + 1;
+
+  plan = (qio_read_plan_t*) qio_calloc(1, sizeof(qio_read_plan_t));
+  load = (int64_t*) qio_calloc(num_nodes, sizeof(int64_t));
+  if( plan ) {
+    plan->chunk_start = (int64_t*) qio_calloc(n + 1, sizeof(int64_t));
+    plan->chunk_node = (int64_t*) qio_calloc(n + 1, sizeof(int64_t));
+  }
+  if( ! plan || ! load || ! plan->chunk_start || ! plan->chunk_node ) {
+    qio_read_plan_free(plan);
+    qio_free(load);
+    return QIO_ENOMEM;
+  }
+
+  plan->num_chunks = n;
+  plan->num_nodes = num_nodes;
+  pos = start;
+  for( i = 0; i < n; i++ ) {
+    plan->chunk_start[i] = pos;
+    plan->chunk_node[i] = -1;
+    pos = (pos / chunk + 1) * chunk;
+    if( pos > end ) pos = end;
+  }
+  plan->chunk_start[n] = end;
+
+  fair = (len + num_nodes - 1) / num_nodes;
+
+  // First give chunks to a node that holds them, if the file system can
+  // say, without loading any node much more than its fair share.
+  if( fl->file_info && node_names ) {
+    for( i = 0; i < n; i++ ) {
+      const char** names = NULL;
+      int64_t num_names = 0;
+      int64_t clen = plan->chunk_start[i+1] - plan->chunk_start[i];
+      int64_t best = -1;
+
+      err = qio_locales_for_region(fl, plan->chunk_start[i],
+                                   plan->chunk_start[i+1],
+                                   &names, &num_names);
+      if( err ) break; // no locality information
+      for( j = 0; j < num_names; j++ ) {
+        for( k = 0; k < num_nodes; k++ ) {
+          if( node_names[k] && names[j] &&
+              _qio_same_host(node_names[k], names[j]) &&
+              load[k] + clen <= fair + chunk &&
+              (best == -1 || load[k] < load[best]) )
+            best = k;
+        }
+      }
+      if( best != -1 ) {
+        plan->chunk_node[i] = best;
+        load[best] += clen;
+      }
+    }
+  }
+
+  // Then hand out the rest in contiguous runs, filling each node up to
+  // its fair share in turn, so each node reads sequentially.
+  cur = 0;
+  for( i = 0; i < n; i++ ) {
+    if( plan->chunk_node[i] != -1 ) continue;
+    while( cur < num_nodes - 1 && load[cur] >= fair ) cur++;
+    plan->chunk_node[i] = cur;
+    load[cur] += plan->chunk_start[i+1] - plan->chunk_start[i];
+  }
+
+  qio_free(load);
+  *plan_out = plan;
+  return 0;
+}
+
+void qio_read_plan_free(qio_read_plan_t* plan)
+{
+  if( ! plan ) return;
+  qio_free(plan->chunk_start);
+  qio_free(plan->chunk_node);
+  qio_free(plan);
+}
+
+int64_t qio_read_plan_next(const qio_read_plan_t* plan, int64_t node, int64_t chunk)
+{
+  int64_t i;
+
+  for( i = chunk < 0 ? 0 : chunk; i < plan->num_chunks; i++ ) {
+    if( plan->chunk_node[i] == node ) return i;
+  }
+  return -1;
+}
+
+// Returns the offset just past the first 'sep' at or after pos, or
+// region_end if there is none.
+static
+qioerr _qio_after_next_sep(qio_file_t* fl, int64_t pos, int64_t region_end, int32_t sep, int64_t* out)
+{
+  qio_channel_t* ch = NULL;
+  int32_t c;
+  qioerr err;
+
+  err = qio_channel_create(&ch, fl, 0, 1, 0, pos, region_end, NULL);
+  if( err ) return err;
+
+  while( 1 ) {
+    c = qio_channel_read_byte(false, ch);
+    if( c < 0 ) {
+      if( -c != EEOF ) err = qio_int_to_err(-c);
+      pos = region_end;
+      break;
+    }
+    pos++;
+    if( c == sep ) break;
+  }
+
+  qio_channel_release(ch);
+  *out = pos;
+  return err;
+}
+
+qioerr qio_align_chunk_to_records(qio_file_t* fl, int64_t region_start, int64_t region_end, int64_t start, int64_t end, int32_t sep, int64_t* start_out, int64_t* end_out)
+{
+  qioerr err;
+
+  *start_out = start;
+  *end_out = end;
+
+  // A record starts just after a separator.  Look from the byte before
+  // each boundary so that a separator right before it counts.
+  if( start > region_start ) {
+    err = _qio_after_next_sep(fl, start - 1, region_end, sep, start_out);
+    if( err ) return err;
+  }
+  if( end < region_end ) {
+    err = _qio_after_next_sep(fl, end - 1, region_end, sep, end_out);
+    if( err ) return err;
+  }
+  if( *end_out < *start_out ) *end_out = *start_out;
+  return 0;
+}
+
@@ -0,0 +1,522 @@
+/*
+ * Copyright 2020-2021 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sys_basic.h"
+
+#ifndef CHPL_RT_UNIT_TEST
+#include "chplrt.h"
+#include "chpl-env.h"
+#endif
+
+#include "qio.h"
+#include "qio_plugin_api.h"
+#include "qio_compress.h"
+
+#ifdef SYS_HAS_ZSTD
+#include <zstd.h>
+#endif
+#ifdef SYS_HAS_LZ4
+#include <lz4frame.h>
+#endif
+
+int qio_compress_level = 0;
+int qio_compress_threads = -1;
+
+// LZ4 compresses at most this much at a time.
+#define QIO_COMPRESS_CHUNK (64*1024)
+
+#if defined(SYS_HAS_ZSTD) || defined(SYS_HAS_LZ4)
+
+// The file_info of a compressed file.
+typedef struct qio_compress_file_s {
+  qio_file_t* backing;
+  qio_compress_codec_t codec;
+} qio_compress_file_t;
+
+// The chan_info of a channel on a compressed file.
+typedef struct qio_compress_channel_s {
+  qio_compress_file_t* file;
+  qio_channel_t* ch; // the channel this one (de)compresses for
+  qio_channel_t* backing_ch; // reads or writes the compressed data
+  int writing;
+
+  // Readers: compressed data from backing_ch not yet decompressed.
+  // Writers: compressed data not yet written to backing_ch.
+  char* cbuf;
+  size_t cbuf_cap;
+  size_t cbuf_pos;
+  size_t cbuf_len;
+
+  int backing_eof; // readers: read all of backing_ch
+  int in_frame; // readers: stopped in the middle of a frame
+  int pending; // readers: the codec may have more output buffered
+
+#ifdef SYS_HAS_ZSTD
+  ZSTD_CCtx* zc;
+  ZSTD_DCtx* zd;
+#endif
+#ifdef SYS_HAS_LZ4
+  LZ4F_cctx* lc;
+  LZ4F_dctx* ld;
+#endif
+} qio_compress_channel_t;
+
+static
+int _qio_compress_nthreads(void)
+{
+  if( qio_compress_threads < 0 ) {
+#ifndef CHPL_RT_UNIT_TEST
+    qio_compress_threads = chpl_env_rt_get_int("QIO_COMPRESS_THREADS", 4);
+#else
+    qio_compress_threads = 0;
+#endif
+  }
+  return qio_compress_threads;
+}
+
+static
+void _qio_compress_channel_free(qio_compress_channel_t* c)
+{
+#ifdef SYS_HAS_ZSTD
+  if( c->zc ) ZSTD_freeCCtx(c->zc);
+  if( c->zd ) ZSTD_freeDCtx(c->zd);
+#endif
+#ifdef SYS_HAS_LZ4
+  if( c->lc ) LZ4F_freeCompressionContext(c->lc);
+  if( c->ld ) LZ4F_freeDecompressionContext(c->ld);
+#endif
+  if( c->backing_ch ) qio_channel_release(c->backing_ch);
+  qio_free(c->cbuf);
+  qio_free(c);
+}
+
+static
+qioerr _qio_compress_codec_init(qio_compress_channel_t* c)
+{
+  switch( c->file->codec ) {
+#ifdef SYS_HAS_ZSTD
+    case QIO_COMPRESS_ZSTD:
+      if( c->writing ) {
+        int nthreads = _qio_compress_nthreads();
+        c->zc = ZSTD_createCCtx();
+        if( ! c->zc ) return QIO_ENOMEM;
+        ZSTD_CCtx_setParameter(c->zc, ZSTD_c_compressionLevel,
+                               qio_compress_level);
+        // This fails if libzstd was built without threads;
+        // then we just compress in the writing task.
+        if( nthreads > 0 )
+          ZSTD_CCtx_setParameter(c->zc, ZSTD_c_nbWorkers, nthreads);
+        c->cbuf_cap = ZSTD_CStreamOutSize();
+      } else {
+        c->zd = ZSTD_createDCtx();
+        if( ! c->zd ) return QIO_ENOMEM;
+        c->cbuf_cap = ZSTD_DStreamInSize();
+      }
+      break;
+#endif
+#ifdef SYS_HAS_LZ4
+    case QIO_COMPRESS_LZ4:
+      if( c->writing ) {
+        LZ4F_preferences_t prefs;
+        memset(&prefs, 0, sizeof(prefs));
+        prefs.compressionLevel = qio_compress_level;
+        prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+        if( LZ4F_isError(LZ4F_createCompressionContext(&c->lc, LZ4F_VERSION)) )
+          return QIO_ENOMEM;
+        c->cbuf_cap = LZ4F_compressBound(QIO_COMPRESS_CHUNK, &prefs);
+        if( c->cbuf_cap < LZ4F_HEADER_SIZE_MAX )
+          c->cbuf_cap = LZ4F_HEADER_SIZE_MAX;
+        c->cbuf = (char*) qio_malloc(c->cbuf_cap);
+        if( ! c->cbuf ) return QIO_ENOMEM;
+        // The frame header goes out with the first write.
+        c->cbuf_len = LZ4F_compressBegin(c->lc, c->cbuf, c->cbuf_cap, &prefs);
+        if( LZ4F_isError(c->cbuf_len) ) {
+          c->cbuf_len = 0;
+          QIO_RETURN_CONSTANT_ERROR(EINVAL, "lz4 compression setup failed");
+        }
+      } else {
+        if( LZ4F_isError(LZ4F_createDecompressionContext(&c->ld, LZ4F_VERSION)) )
+          return QIO_ENOMEM;
+        c->cbuf_cap = QIO_COMPRESS_CHUNK;
+      }
+      break;
+#endif
+    default:
+      QIO_RETURN_CONSTANT_ERROR(ENOSYS, "compression codec not supported");
+  }
+
+  if( ! c->cbuf ) {
+    c->cbuf = (char*) qio_malloc(c->cbuf_cap);
+    if( ! c->cbuf ) return QIO_ENOMEM;
+  }
+
+  return 0;
+}
+
+static
+syserr qio_compress_setup_channel(void* file, void** plugin_ch, int64_t start, int64_t end, qio_channel_t* qio_ch)
+{
+  qio_compress_file_t* f = (qio_compress_file_t*) file;
+  qio_compress_channel_t* c;
+  int writing = (qio_ch->flags & QIO_FDFLAG_WRITEABLE) != 0;
+  qioerr err;
+
+  if( start != 0 )
+    QIO_RETURN_CONSTANT_ERROR(ESPIPE, "compressed channels must start at 0");
+
+  c = (qio_compress_channel_t*) qio_calloc(1, sizeof(qio_compress_channel_t));
+  if( ! c ) return QIO_ENOMEM;
+
+  c->file = f;
+  c->ch = qio_ch;
+  c->writing = writing;
+
+  err = qio_channel_create(&c->backing_ch, f->backing, 0,
+                           ! writing, writing, 0, INT64_MAX, NULL);
+  if( err ) goto error;
+
+  err = _qio_compress_codec_init(c);
+  if( err ) goto error;
+
+  *plugin_ch = c;
+  return 0;
+
+error:
+  _qio_compress_channel_free(c);
+  return err;
+}
+
+static
+qioerr _qio_compress_flush_cbuf(qio_compress_channel_t* c)
+{
+  qioerr err;
+
+  if( c->cbuf_len == 0 ) return 0;
+
+  err = qio_channel_write_amt(false, c->backing_ch, c->cbuf, c->cbuf_len);
+  c->cbuf_len = 0;
+  return err;
+}
+
+// Compresses len bytes at ptr; with end, also finishes the frame.
+static
+qioerr _qio_compress_some(qio_compress_channel_t* c, const void* ptr, size_t len, int end)
+{
+  qioerr err;
+
+  switch( c->file->codec ) {
+#ifdef SYS_HAS_ZSTD
+    case QIO_COMPRESS_ZSTD:
+    {
+      ZSTD_inBuffer in = { ptr, len, 0 };
+      size_t left;
+      do {
+        ZSTD_outBuffer out = { c->cbuf, c->cbuf_cap, 0 };
+        left = ZSTD_compressStream2(c->zc, &out, &in,
+                                    end ? ZSTD_e_end : ZSTD_e_continue);
+        if( ZSTD_isError(left) )
+          QIO_RETURN_CONSTANT_ERROR(EIO, "zstd compression failed");
+        c->cbuf_len = out.pos;
+        err = _qio_compress_flush_cbuf(c);
+        if( err ) return err;
+      } while( end ? left != 0 : in.pos < in.size );
+      return 0;
+    }
+#endif
+#ifdef SYS_HAS_LZ4
+    case QIO_COMPRESS_LZ4:
+    {
+      const char* cur = (const char*) ptr;
+      size_t got;
+
+      while( len > 0 ) {
+        size_t n = len < QIO_COMPRESS_CHUNK ? len : QIO_COMPRESS_CHUNK;
+        // Send the frame header or earlier output first.
+        err = _qio_compress_flush_cbuf(c);
+        if( err ) return err;
+        got = LZ4F_compressUpdate(c->lc, c->cbuf, c->cbuf_cap, cur, n, NULL);
+        if( LZ4F_isError(got) )
+          QIO_RETURN_CONSTANT_ERROR(EIO, "lz4 compression failed");
+        c->cbuf_len = got;
+        cur += n;
+        len -= n;
+      }
+      err = _qio_compress_flush_cbuf(c);
+      if( err ) return err;
+      if( end ) {
+        got = LZ4F_compressEnd(c->lc, c->cbuf, c->cbuf_cap, NULL);
+        if( LZ4F_isError(got) )
+          QIO_RETURN_CONSTANT_ERROR(EIO, "lz4 compression failed");
+        c->cbuf_len = got;
+        err = _qio_compress_flush_cbuf(c);
+      }
+      return err;
+    }
+#endif
+    default:
+      QIO_RETURN_CONSTANT_ERROR(ENOSYS, "compression codec not supported");
+  }
+}
+
+// Decompresses some of cbuf into len bytes at ptr.
+static
+qioerr _qio_decompress_some(qio_compress_channel_t* c, void* ptr, size_t len, size_t* produced)
+{
+  switch( c->file->codec ) {
+#ifdef SYS_HAS_ZSTD
+    case QIO_COMPRESS_ZSTD:
+    {
+      ZSTD_inBuffer in = { c->cbuf + c->cbuf_pos, c->cbuf_len - c->cbuf_pos, 0 };
+      ZSTD_outBuffer out = { ptr, len, 0 };
+      size_t hint = ZSTD_decompressStream(c->zd, &out, &in);
+      if( ZSTD_isError(hint) )
+        QIO_RETURN_CONSTANT_ERROR(EIO, "corrupt zstd data");
+      c->cbuf_pos += in.pos;
+      // hint is 0 at the end of each frame
+      c->in_frame = hint != 0;
+      c->pending = out.pos == out.size;
+      *produced = out.pos;
+      return 0;
+    }
+#endif
+#ifdef SYS_HAS_LZ4
+    case QIO_COMPRESS_LZ4:
+    {
+      size_t src_len = c->cbuf_len - c->cbuf_pos;
+      size_t dst_len = len;
+      size_t hint = LZ4F_decompress(c->ld, ptr, &dst_len,
+                                    c->cbuf + c->cbuf_pos, &src_len, NULL);
+      if( LZ4F_isError(hint) )
+        QIO_RETURN_CONSTANT_ERROR(EIO, "corrupt lz4 data");
+      c->cbuf_pos += src_len;
+      c->in_frame = hint != 0;
+      c->pending = dst_len == len;
+      *produced = dst_len;
+      return 0;
+    }
+#endif
+    default:
+      QIO_RETURN_CONSTANT_ERROR(ENOSYS, "compression codec not supported");
+  }
+}
+
+static
+syserr qio_compress_read_atleast(void* plugin_ch, int64_t amt)
+{
+  qio_compress_channel_t* c = (qio_compress_channel_t*) plugin_ch;
+  int64_t got = 0;
+  qioerr err;
+
+  while( got < amt ) {
+    void* ptr = NULL;
+    ssize_t len = 0;
+    int64_t offset = 0;
+    size_t produced = 0;
+
+    if( c->cbuf_pos == c->cbuf_len && ! c->pending ) {
+      ssize_t num_read = 0;
+
+      if( c->backing_eof ) {
+        if( c->in_frame )
+          QIO_RETURN_CONSTANT_ERROR(EIO, "truncated compressed data");
+        return QIO_EEOF;
+      }
+
+      err = qio_channel_read(false, c->backing_ch,
+                             c->cbuf, c->cbuf_cap, &num_read);
+      if( err && qio_err_to_int(err) == EEOF ) {
+        c->backing_eof = 1;
+        err = 0;
+      }
+      if( err ) return err;
+      c->cbuf_pos = 0;
+      c->cbuf_len = num_read;
+      continue;
+    }
+
+    err = qio_channel_get_allocated_ptr_unlocked(c->ch, amt - got,
+                                                 &ptr, &len, &offset);
+    if( err ) return err;
+
+    err = _qio_decompress_some(c, ptr, len, &produced);
+    if( err ) return err;
+
+    qio_channel_advance_available_end_unlocked(c->ch, produced);
+    got += produced;
+  }
+
+  return 0;
+}
+
+static
+syserr qio_compress_write(void* plugin_ch, int64_t amt)
+{
+  qio_compress_channel_t* c = (qio_compress_channel_t*) plugin_ch;
+  qioerr err;
+
+  while( amt > 0 ) {
+    void* ptr = NULL;
+    ssize_t len = 0;
+    int64_t offset = 0;
+
+    err = qio_channel_get_write_behind_ptr_unlocked(c->ch, &ptr, &len, &offset);
+    if( err ) return err;
+    if( len > amt ) len = amt;
+    if( len <= 0 ) break;
+
+    err = _qio_compress_some(c, ptr, len, 0);
+    if( err ) return err;
+
+    qio_channel_advance_write_behind_unlocked(c->ch, len);
+    amt -= len;
+  }
+
+  return 0;
+}
+
+static
+syserr qio_compress_channel_close(void* plugin_ch)
+{
+  qio_compress_channel_t* c = (qio_compress_channel_t*) plugin_ch;
+  qioerr err = 0;
+  qioerr newerr;
+
+  if( c->writing ) {
+    err = _qio_compress_some(c, NULL, 0, 1);
+    newerr = qio_channel_close(false, c->backing_ch);
+    if( ! err ) err = newerr;
+  }
+
+  _qio_compress_channel_free(c);
+  return err;
+}
+
+static
+syserr qio_compress_filelength(void* file, int64_t* length)
+{
+  QIO_RETURN_CONSTANT_ERROR(ESPIPE, "length of compressed data is unknown");
+}
+
+static
+syserr qio_compress_getpath(void* file, const char** str, int64_t* len)
+{
+  qio_compress_file_t* f = (qio_compress_file_t*) file;
+  qioerr err;
+
+  err = qio_file_path(f->backing, str);
+  if( ! err ) *len = strlen(*str);
+  return err;
+}
+
+static
+syserr qio_compress_fsync(void* file)
+{
+  qio_compress_file_t* f = (qio_compress_file_t*) file;
+  return qio_file_sync(f->backing);
+}
+
+static
+syserr qio_compress_get_chunk(void* file, int64_t* length)
+{
+  qio_compress_file_t* f = (qio_compress_file_t*) file;
+  return qio_get_chunk(f->backing, length);
+}
+
+static
+syserr qio_compress_get_locales_for_region(void* file, int64_t start, int64_t end, void **localeNamesPtr, int64_t* nLocales)
+{
+  *nLocales = 0;
+  QIO_RETURN_CONSTANT_ERROR(ENOSYS, "no locales for compressed data");
+}
+
+static
+syserr qio_compress_file_close(void* file)
+{
+  qio_compress_file_t* f = (qio_compress_file_t*) file;
+
+  qio_file_release(f->backing);
+  qio_free(f);
+  return 0;
+}
+
+static const qio_plugin_ops_t qio_compress_plugin_ops = {
+  qio_compress_setup_channel,
+  qio_compress_read_atleast,
+  qio_compress_write,
+  qio_compress_channel_close,
+  qio_compress_filelength,
+  qio_compress_getpath,
+  qio_compress_fsync,
+  qio_compress_get_chunk,
+  qio_compress_get_locales_for_region,
+  qio_compress_file_close,
+};
+
+#endif
+
+int qio_compress_supported(qio_compress_codec_t codec)
+{
+  switch( codec ) {
+#ifdef SYS_HAS_ZSTD
+    case QIO_COMPRESS_ZSTD:
+      return 1;
+#endif
+#ifdef SYS_HAS_LZ4
+    case QIO_COMPRESS_LZ4:
+      return 1;
+#endif
+    default:
+      return 0;
+  }
+}
+
+qioerr qio_file_open_compressed(qio_file_t** file_out, qio_file_t* backing,
+                                qio_compress_codec_t codec,
+                                const qio_style_t* style)
+{
+#if defined(SYS_HAS_ZSTD) || defined(SYS_HAS_LZ4)
+  qio_compress_file_t* f;
+  qioerr err;
+
+  *file_out = NULL;
+
+  if( ! qio_compress_supported(codec) )
+    QIO_RETURN_CONSTANT_ERROR(ENOSYS, "compression codec not supported");
+
+  f = (qio_compress_file_t*) qio_calloc(1, sizeof(qio_compress_file_t));
+  if( ! f ) return QIO_ENOMEM;
+
+  qio_file_retain(backing);
+  f->backing = backing;
+  f->codec = codec;
+
+  err = qio_file_init_plugin_ops(file_out, f, &qio_compress_plugin_ops,
+                                 backing->fdflags & ~QIO_FDFLAG_SEEKABLE,
+                                 style);
+  if( err ) {
+    qio_file_release(backing);
+    qio_free(f);
+  }
+  return err;
+#else
+  *file_out = NULL;
+  QIO_RETURN_CONSTANT_ERROR(ENOSYS, "no compression support in this runtime");
+#endif
+}
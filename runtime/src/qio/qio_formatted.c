@@ -28,6 +28,12 @@
 #include <limits.h>
 #include <ctype.h>
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #ifdef HAS_WCTYPE_H
 #include <wctype.h>
 #include <langinfo.h>
@@ -154,6 +160,317 @@ qioerr qio_channel_write_svarint(const int threadsafe, qio_channel_t* restrict c
   return qio_channel_write_uvarint(threadsafe, ch, u_num);
 }
 
+// Decodes one varint from p, which must have at least 10 readable
+// bytes.  Returns its length, or -1 if it is longer than 10 bytes.
+static inline
+int _qio_decode_uvarint_unchecked(const unsigned char* restrict p, uint64_t* restrict out)
+{
+  uint64_t num = 0;
+  int i;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  {
+    // Find the last byte of varints up to 8 bytes with one load.
+    uint64_t v;
+    uint64_t stops;
+    int len;
+
+    memcpy(&v, p, 8);
+    stops = ~v & 0x8080808080808080ULL;
+    if( stops ) {
+      len = (__builtin_ctzll(stops) >> 3) + 1;
+      if( len < 8 ) v &= (1ULL << (8*len)) - 1;
+#if defined(__BMI2__)
+      num = _pext_u64(v, 0x7f7f7f7f7f7f7f7fULL);
+#else
+      for( i = 0; i < len; i++ ) {
+        num |= ((v >> (8*i)) & 0x7f) << (7*i);
+      }
+#endif
+      *out = num;
+      return len;
+    }
+  }
+#endif
+
+  for( i = 0; i < 10; i++ ) {
+    num |= (uint64_t) (p[i] & 0x7f) << (7*i);
+    if( ! (p[i] & 0x80) ) {
+      *out = num;
+      return i + 1;
+    }
+  }
+  *out = num;
+  return -1;
+}
+
+static inline
+int _qio_encode_uvarint_unchecked(unsigned char* restrict p, uint64_t num)
+{
+  int i = 0;
+  while( num >= 0x80 ) {
+    p[i++] = (num & 0x7f) | 0x80;
+    num >>= 7;
+  }
+  p[i++] = num;
+  return i;
+}
+
+static
+qioerr _qio_channel_read_varints(qio_channel_t* restrict ch, uint64_t* restrict ptr, ssize_t count, int zigzag, ssize_t* restrict num_read_out)
+{
+  qioerr err = 0;
+  ssize_t i = 0;
+  uint64_t u;
+  int len;
+
+  while( i < count ) {
+    // Decode straight from the fast path buffer while a whole
+    // varint is sure to fit.
+    while( i < count &&
+           qio_space_in_ptr_diff(10, ch->cached_end, ch->cached_cur) ) {
+      len = _qio_decode_uvarint_unchecked((const unsigned char*) ch->cached_cur, &u);
+      if( len < 0 ) {
+        ch->cached_cur = qio_ptr_add(ch->cached_cur, 10);
+        QIO_GET_CONSTANT_ERROR(err, EFORMAT, "overflow in varint");
+        goto done;
+      }
+      ch->cached_cur = qio_ptr_add(ch->cached_cur, len);
+      ptr[i++] = zigzag ? (u >> 1) ^ -(u & 1) : u;
+    }
+    if( i == count ) break;
+
+    // Near the end of the buffer: one at a time.
+    err = qio_channel_read_uvarint(false, ch, &u);
+    if( err ) goto done;
+    ptr[i++] = zigzag ? (u >> 1) ^ -(u & 1) : u;
+  }
+
+done:
+  *num_read_out = i;
+  return err;
+}
+
+static
+qioerr _qio_channel_write_varints(qio_channel_t* restrict ch, const uint64_t* restrict ptr, ssize_t count, int zigzag)
+{
+  qioerr err = 0;
+  ssize_t i = 0;
+  uint64_t u;
+  int len;
+
+  while( i < count ) {
+    while( i < count &&
+           qio_space_in_ptr_diff(10, ch->cached_end, ch->cached_cur) ) {
+      u = ptr[i++];
+      if( zigzag ) u = (u << 1) ^ (uint64_t) ((int64_t) u >> 63);
+      len = _qio_encode_uvarint_unchecked((unsigned char*) ch->cached_cur, u);
+      ch->cached_cur = qio_ptr_add(ch->cached_cur, len);
+    }
+    err = _qio_channel_post_cached_write(ch);
+    if( err ) break;
+    if( i == count ) break;
+
+    u = ptr[i++];
+    if( zigzag ) u = (u << 1) ^ (uint64_t) ((int64_t) u >> 63);
+    err = qio_channel_write_uvarint(false, ch, u);
+    if( err ) break;
+  }
+
+  return err;
+}
+
+qioerr qio_channel_read_uvarints(const int threadsafe, qio_channel_t* restrict ch, uint64_t* restrict ptr, ssize_t count, ssize_t* restrict num_read_out) {
+  qioerr err;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) {
+      *num_read_out = 0;
+      return err;
+    }
+  }
+
+  err = _qio_channel_read_varints(ch, ptr, count, 0, num_read_out);
+  _qio_channel_set_error_unlocked(ch, err);
+
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
+qioerr qio_channel_read_svarints(const int threadsafe, qio_channel_t* restrict ch, int64_t* restrict ptr, ssize_t count, ssize_t* restrict num_read_out) {
+  qioerr err;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) {
+      *num_read_out = 0;
+      return err;
+    }
+  }
+
+  err = _qio_channel_read_varints(ch, (uint64_t*) ptr, count, 1, num_read_out);
+  _qio_channel_set_error_unlocked(ch, err);
+
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
+// Decodes varints from a region of memory, stopping at the end of
+// the region or after count values.
+static
+qioerr _qio_decode_varints(const unsigned char* restrict p, size_t len, uint64_t* restrict ptr, ssize_t count, int zigzag, ssize_t* restrict num_read_out, size_t* restrict used_out)
+{
+  qioerr err = 0;
+  const unsigned char* start = p;
+  const unsigned char* end = p + len;
+  ssize_t i = 0;
+  uint64_t u;
+  int n;
+
+  // Decode without bounds checks while a whole varint is sure to fit.
+  // A 10th byte can only hold bit 63; anything more is an overflow.
+  while( i < count && end - p >= 10 ) {
+    n = _qio_decode_uvarint_unchecked(p, &u);
+    if( n < 0 || (n == 10 && p[9] > 1) ) {
+      QIO_GET_CONSTANT_ERROR(err, EFORMAT, "overflow in varint");
+      goto done;
+    }
+    p += n;
+    ptr[i++] = zigzag ? (u >> 1) ^ -(u & 1) : u;
+  }
+
+  // The last few bytes: a byte at a time.
+  while( i < count && p < end ) {
+    u = 0;
+    for( n = 0; ; n++ ) {
+      if( p + n == end ) {
+        QIO_GET_CONSTANT_ERROR(err, EEOF, "varint cut off at end of region");
+        goto done;
+      }
+      if( n == 9 && p[n] > 1 ) {
+        QIO_GET_CONSTANT_ERROR(err, EFORMAT, "overflow in varint");
+        goto done;
+      }
+      u |= (uint64_t) (p[n] & 0x7f) << (7*n);
+      if( ! (p[n] & 0x80) ) break;
+    }
+    p += n + 1;
+    ptr[i++] = zigzag ? (u >> 1) ^ -(u & 1) : u;
+  }
+
+done:
+  *num_read_out = i;
+  *used_out = p - start;
+  return err;
+}
+
+qioerr qio_decode_uvarints(const void* restrict buf, size_t len, uint64_t* restrict ptr, ssize_t count, ssize_t* restrict num_read_out, size_t* restrict used_out) {
+  return _qio_decode_varints((const unsigned char*) buf, len, ptr, count, 0,
+                             num_read_out, used_out);
+}
+
+qioerr qio_decode_svarints(const void* restrict buf, size_t len, int64_t* restrict ptr, ssize_t count, ssize_t* restrict num_read_out, size_t* restrict used_out) {
+  return _qio_decode_varints((const unsigned char*) buf, len,
+                             (uint64_t*) ptr, count, 1,
+                             num_read_out, used_out);
+}
+
+qioerr qio_channel_read_bytes_ref(const int threadsafe, qio_channel_t* restrict ch, int64_t len, qbytes_t** restrict bytes_out, int64_t* restrict skip_out) {
+  qioerr err;
+  qioerr end_err;
+  qbuffer_t* buf;
+  qbuffer_iter_t start;
+  qbuffer_iter_t end;
+  qbytes_t* bytes = NULL;
+  int64_t skip = 0;
+  int64_t part_len = 0;
+
+  *bytes_out = NULL;
+  *skip_out = 0;
+
+  if( len < 0 ) QIO_RETURN_CONSTANT_ERROR(EINVAL, "negative length");
+
+  err = qio_channel_begin_peek_buffer(threadsafe, ch, len, 0,
+                                      &buf, &start, &end);
+  if( err ) return err;
+
+  if( len > 0 ) qbuffer_iter_get(start, end, &bytes, &skip, &part_len);
+
+  if( len > 0 && bytes != NULL && part_len >= len ) {
+    // The data is all in one bytes object; share it.
+    qbytes_retain(bytes);
+  } else {
+    end = start;
+    qbuffer_iter_advance(buf, &end, len);
+    skip = 0;
+    err = qbytes_create_calloc(&bytes, len);
+    if( err ) {
+      bytes = NULL;
+    } else {
+      err = qbuffer_copyout(buf, start, end, bytes->data, len);
+    }
+  }
+
+  end_err = qio_channel_end_peek_buffer(threadsafe, ch, err ? 0 : len);
+  if( ! err ) err = end_err;
+
+  if( err ) {
+    if( bytes ) qbytes_release(bytes);
+    return err;
+  }
+
+  *bytes_out = bytes;
+  *skip_out = skip;
+  return 0;
+}
+
+qioerr qio_channel_write_uvarints(const int threadsafe, qio_channel_t* restrict ch, const uint64_t* restrict ptr, ssize_t count) {
+  qioerr err;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) {
+      return err;
+    }
+  }
+
+  err = _qio_channel_write_varints(ch, ptr, count, 0);
+  _qio_channel_set_error_unlocked(ch, err);
+
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
+qioerr qio_channel_write_svarints(const int threadsafe, qio_channel_t* restrict ch, const int64_t* restrict ptr, ssize_t count) {
+  qioerr err;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) {
+      return err;
+    }
+  }
+
+  err = _qio_channel_write_varints(ch, (const uint64_t*) ptr, count, 1);
+  _qio_channel_set_error_unlocked(ch, err);
+
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
+
 
 
 static
@@ -171,15 +488,28 @@ qioerr _peek_until_byte(qio_channel_t* restrict ch, uint8_t term_byte, int64_t*
   err = qio_channel_mark(false, ch);
   if( err ) return err;
 
+  found_term = 0;
   while( 1 ) {
+    // Search whatever is in the fast path buffer all at once.
+    if( qio_space_in_ptr_diff(1, ch->cached_end, ch->cached_cur) ) {
+      size_t len = qio_ptr_diff(ch->cached_end, ch->cached_cur);
+      void* found = memchr(ch->cached_cur, term_byte, len);
+      if( found ) {
+        ch->cached_cur = qio_ptr_add(found, 1);
+        found_term = 1;
+        break;
+      }
+      ch->cached_cur = ch->cached_end;
+      continue;
+    }
     err = qio_channel_read_uint8(false, ch, &byte);
     if( err ) break;
-    if( byte == term_byte ) break;
+    if( byte == term_byte ) {
+      found_term = 1;
+      break;
+    }
   }
 
-  if( byte == term_byte ) found_term = 1;
-  else found_term = 0;
-
   end_offset = qio_channel_offset_unlocked(ch);
 
   qio_channel_revert_unlocked(ch);
@@ -2088,6 +2418,36 @@ static inline bool is_json_whitespace(int32_t c)
            c == '\f' || c == '\n' || c == '\r' || c == '\t' );
 }
 
+// Returns the first '"' or '\\' in [p, end), or end.
+static inline
+const unsigned char* _qio_json_string_stop(const unsigned char* p, const unsigned char* end)
+{
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  while( end - p >= 16 ) {
+    __m128i v = _mm_loadu_si128((const __m128i*) p);
+    int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                              _mm_cmpeq_epi8(v, backslash)));
+    if( mask ) return p + __builtin_ctz(mask);
+    p += 16;
+  }
+#elif defined(__ARM_NEON)
+  const uint8x16_t quote = vdupq_n_u8('"');
+  const uint8x16_t backslash = vdupq_n_u8('\\');
+  while( end - p >= 16 ) {
+    uint8x16_t v = vld1q_u8(p);
+    uint8x16_t eq = vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash));
+    if( vmaxvq_u8(eq) ) break; // find it below
+    p += 16;
+  }
+#endif
+  while( p < end && *p != '"' && *p != '\\' ) p++;
+  return p;
+}
+
+static int32_t _qio_skip_json_value_from(qio_channel_t* restrict ch, int32_t c);
+
 // Read and skip an arbitrary JSON object, assuming the leading '{'
 // has already been read. Returns 0 on success or a negative error code.
 int32_t qio_skip_json_object_unlocked(qio_channel_t* restrict ch)
@@ -2177,6 +2537,14 @@ int32_t qio_skip_json_value_unlocked(qio_channel_t* restrict ch)
     }
   }
 
+  return _qio_skip_json_value_from(ch, c);
+}
+
+// Like qio_skip_json_value_unlocked, but c is the first character of
+// the value, already read.
+static
+int32_t _qio_skip_json_value_from(qio_channel_t* restrict ch, int32_t c)
+{
   if( c == '"' ) {
     // read string until matching '"'
     return qio_skip_json_string_unlocked(ch);
@@ -2290,6 +2658,28 @@ int32_t qio_skip_json_string_unlocked(qio_channel_t* restrict ch)
   int32_t c;
 
   while( true ) {
+    // Search the fast path buffer for the end quote or a backslash.
+    if( qio_space_in_ptr_diff(1, ch->cached_end, ch->cached_cur) ) {
+      const unsigned char* end = (const unsigned char*) ch->cached_end;
+      const unsigned char* p;
+      p = _qio_json_string_stop((const unsigned char*) ch->cached_cur, end);
+      if( p == end ) {
+        ch->cached_cur = ch->cached_end;
+        continue;
+      }
+      if( *p == '"' ) {
+        ch->cached_cur = (void*) (p + 1);
+        return 0;
+      }
+      if( p + 1 < end ) {
+        // skip the backslash and the character it quotes
+        ch->cached_cur = (void*) (p + 2);
+        continue;
+      }
+      // the quoted character isn't buffered yet
+      ch->cached_cur = (void*) p;
+    }
+
     c = qio_channel_read_byte(false, ch);
     if( c < 0 ) return c;
 
@@ -2406,6 +2796,102 @@ unlock:
 
 }
 
+// Reads whitespace and returns the next character, or a negative error.
+static
+int32_t _qio_json_read_nonspace(qio_channel_t* restrict ch)
+{
+  int32_t c;
+
+  while( true ) {
+    // Skip runs of spaces straight out of the fast path buffer.
+    while( qio_space_in_ptr_diff(1, ch->cached_end, ch->cached_cur) &&
+           is_json_whitespace(*(unsigned char*) ch->cached_cur) ) {
+      ch->cached_cur = qio_ptr_add(ch->cached_cur, 1);
+    }
+    c = qio_channel_read_byte(false, ch);
+    if( c < 0 || ! is_json_whitespace(c) ) return c;
+  }
+}
+
+static
+int32_t _qio_json_next_field_unlocked(qio_channel_t* restrict ch, qio_json_field_t* restrict field)
+{
+  int32_t c;
+
+  field->name_start = -1;
+  field->name_end = -1;
+  field->value_start = -1;
+  field->value_end = -1;
+  field->value_kind = 0;
+  field->last = 0;
+
+  c = _qio_json_read_nonspace(ch);
+  if( c < 0 ) return c;
+  if( c == '}' ) {
+    field->last = 1;
+    return 0;
+  }
+  if( c != '"' ) return -EFORMAT;
+
+  // The name
+  field->name_start = qio_channel_offset_unlocked(ch);
+  c = qio_skip_json_string_unlocked(ch);
+  if( c < 0 ) return c;
+  field->name_end = qio_channel_offset_unlocked(ch) - 1;
+
+  c = _qio_json_read_nonspace(ch);
+  if( c < 0 ) return c;
+  if( c != ':' ) return -EFORMAT;
+
+  // The value
+  c = _qio_json_read_nonspace(ch);
+  if( c < 0 ) return c;
+  field->value_start = qio_channel_offset_unlocked(ch) - 1;
+  field->value_kind = (c == '-' || ('0' <= c && c <= '9')) ? '0' : c;
+  if( c == 0 || ! strchr("0\"{[tfn", field->value_kind) ) return -EFORMAT;
+
+  c = _qio_skip_json_value_from(ch, c);
+  if( c < 0 ) return c;
+  if( c == 0 ) {
+    field->value_end = qio_channel_offset_unlocked(ch);
+    c = _qio_json_read_nonspace(ch);
+    if( c < 0 ) return c;
+  } else {
+    // a number, ended by the character we're given back
+    field->value_end = qio_channel_offset_unlocked(ch) - 1;
+    if( is_json_whitespace(c) ) {
+      c = _qio_json_read_nonspace(ch);
+      if( c < 0 ) return c;
+    }
+  }
+
+  // Then , or }
+  if( c == '}' ) field->last = 1;
+  else if( c != ',' ) return -EFORMAT;
+
+  return 0;
+}
+
+qioerr qio_channel_json_next_field(const int threadsafe, qio_channel_t* ch, qio_json_field_t* field)
+{
+  qioerr err = 0;
+  int32_t got;
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) return err;
+  }
+
+  got = _qio_json_next_field_unlocked(ch, field);
+  if( got < 0 ) err = qio_int_to_err(-got);
+
+  _qio_channel_set_error_unlocked(ch, err);
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+  return err;
+}
+
 // only support floating point numbers in
 // base 10, or base 16 (with decimal exponent).
 //
@@ -2659,6 +3145,245 @@ error:
 }
 
 
+// Fast paths for scanning numbers in the common style (base 10, the
+// usual sign characters), working directly on the cached buffer.  They
+// only succeed when the whole number, and the character after it, are
+// already buffered; anything unusual (prefixes, inf/nan, non-ASCII
+// whitespace, too many digits) is left for _peek_number_unlocked and
+// the strtoull/strtod conversions, which handle every style.
+
+static inline
+int _qio_is_ascii_space(unsigned char c)
+{
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline
+int _qio_is_digit(unsigned char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+// If the 8 bytes at p are all digits, stores their value and returns 1.
+static inline
+int _qio_parse_8_digits(const unsigned char* p, uint64_t* val)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint64_t v;
+  memcpy(&v, p, 8);
+  // each byte must be 0x30..0x39
+  if( ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+       (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) !=
+      0x3333333333333333ULL )
+    return 0;
+  v -= 0x3030303030303030ULL;
+  // combine pairs, then pairs of pairs, then the two halves
+  v = (v * 10) + (v >> 8);
+  v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+       (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+  *val = v;
+  return 1;
+#else
+  uint64_t v = 0;
+  int i;
+  for( i = 0; i < 8; i++ ) {
+    if( ! _qio_is_digit(p[i]) ) return 0;
+    v = 10*v + (p[i] - '0');
+  }
+  *val = v;
+  return 1;
+#endif
+}
+
+// Reads digits starting at *pp, adding them to *num.  Returns the number
+// of digits read, stopping early (after at most max_digits + 1) so that
+// the caller can tell the value would no longer fit.
+static inline
+int _qio_parse_digits(const unsigned char** pp, const unsigned char* end, uint64_t* num, int max_digits)
+{
+  const unsigned char* p = *pp;
+  uint64_t n = *num;
+  uint64_t eight;
+  int count = 0;
+
+  while( count + 8 <= max_digits && end - p >= 8 &&
+         _qio_parse_8_digits(p, &eight) ) {
+    n = n * 100000000ULL + eight;
+    p += 8;
+    count += 8;
+  }
+  while( p < end && _qio_is_digit(*p) && count <= max_digits ) {
+    n = 10*n + (*p - '0');
+    p++;
+    count++;
+  }
+
+  *pp = p;
+  *num = n;
+  return count;
+}
+
+static
+int _qio_fast_number_style(qio_style_t* style)
+{
+  return (style->base == 0 || style->base == 10) &&
+         style->positive_char == '+' && style->negative_char == '-';
+}
+
+// Skips whitespace and a sign.  Returns NULL if the fast path can't be
+// used, e.g. because the number might start with a base prefix.
+static
+const unsigned char* _qio_fast_number_start(qio_channel_t* ch, int allow_neg, int* negative)
+{
+  const unsigned char* p = (const unsigned char*) ch->cached_cur;
+  const unsigned char* end = (const unsigned char*) ch->cached_end;
+
+  if( p == NULL ) return NULL;
+
+  while( p < end && _qio_is_ascii_space(*p) ) p++;
+  if( p == end ) return NULL;
+
+  *negative = 0;
+  if( *p == '+' ) {
+    p++;
+  } else if( *p == '-' && allow_neg ) {
+    *negative = 1;
+    p++;
+  }
+  if( p == end || ! _qio_is_digit(*p) ) return NULL;
+
+  // 0x 0b 0o
+  if( *p == '0' && p + 1 < end &&
+      (p[1] == 'x' || p[1] == 'X' || p[1] == 'b' || p[1] == 'B' ||
+       p[1] == 'o' || p[1] == 'O') )
+    return NULL;
+
+  return p;
+}
+
+static
+int _qio_scan_int_fast(qio_channel_t* restrict ch, int issigned, unsigned long long* num_out, int* sign_out)
+{
+  const unsigned char* end = (const unsigned char*) ch->cached_end;
+  const unsigned char* p;
+  uint64_t num = 0;
+  int negative = 0;
+  int ndigits;
+
+  p = _qio_fast_number_start(ch, issigned, &negative);
+  if( ! p ) return 0;
+
+  while( p < end && *p == '0' ) p++;
+  // 19 digits always fit in 64 bits.
+  ndigits = _qio_parse_digits(&p, end, &num, 19);
+  if( ndigits > 19 ) return 0;
+  // Need to see what follows to know the number is over.
+  if( p == end ) return 0;
+
+  ch->cached_cur = (void*) p;
+  *num_out = num;
+  *sign_out = negative ? -1 : 1;
+  return 1;
+}
+
+// Exact powers of ten representable as doubles.
+static const double _qio_exact_pow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static
+int _qio_scan_double_fast(qio_channel_t* restrict ch, qio_style_t* style, double* num_out)
+{
+#if FLT_EVAL_METHOD == 0
+  const unsigned char* end = (const unsigned char*) ch->cached_end;
+  const unsigned char* p;
+  const unsigned char* frac;
+  uint64_t mantissa = 0;
+  int64_t exp10 = 0;
+  int64_t e = 0;
+  int negative = 0;
+  int exp_negative = 0;
+  int ndigits;
+  int nfrac;
+  int nexp;
+  double d;
+
+  if( style->point_char != '.' ||
+      (style->exponent_char != 'e' && style->exponent_char != 'E') )
+    return 0;
+
+  p = _qio_fast_number_start(ch, 1, &negative);
+  if( ! p ) return 0;
+
+  while( p < end && *p == '0' ) p++;
+  ndigits = _qio_parse_digits(&p, end, &mantissa, 19);
+  if( ndigits > 19 ) return 0;
+
+  if( p < end && *p == '.' ) {
+    p++;
+    frac = p;
+    if( ndigits == 0 ) {
+      // leading zeros after the point only move the exponent
+      while( p < end && *p == '0' ) p++;
+      exp10 -= p - frac;
+    }
+    nfrac = _qio_parse_digits(&p, end, &mantissa, 19 - ndigits);
+    if( ndigits + nfrac > 19 ) return 0;
+    exp10 -= nfrac;
+  }
+
+  if( p < end && (*p == 'e' || *p == 'E') ) {
+    p++;
+    if( p < end && (*p == '+' || *p == '-') ) {
+      exp_negative = *p == '-';
+      p++;
+    }
+    nexp = 0;
+    while( p < end && _qio_is_digit(*p) && nexp < 5 ) {
+      e = 10*e + (*p - '0');
+      p++;
+      nexp++;
+    }
+    if( nexp == 0 || nexp == 5 ) return 0;
+    exp10 += exp_negative ? -e : e;
+  }
+
+  // Anything that _peek_number_unlocked would keep reading, or might
+  // be followed by more of the number, goes the slow way.
+  if( p == end ) return 0;
+  if( _qio_is_digit(*p) || *p == '.' || *p == 'e' || *p == 'E' ) return 0;
+
+  // Clinger's fast path: with an exact mantissa and an exact power of
+  // ten, a single multiply or divide rounds correctly.
+  if( mantissa > (1ULL << 53) ) return 0;
+  if( mantissa == 0 ) {
+    d = 0.0;
+  } else if( exp10 < 0 ) {
+    if( exp10 < -22 ) return 0;
+    d = (double) mantissa / _qio_exact_pow10[-exp10];
+  } else if( exp10 <= 22 ) {
+    d = (double) mantissa * _qio_exact_pow10[exp10];
+  } else if( exp10 <= 22 + 15 ) {
+    // Move some of the exponent into the mantissa if it stays exact.
+    uint64_t scale = (uint64_t) _qio_exact_pow10[exp10 - 22];
+    if( mantissa > (1ULL << 53) / scale ) return 0;
+    mantissa *= scale;
+    d = (double) mantissa * _qio_exact_pow10[22];
+  } else {
+    return 0;
+  }
+
+  ch->cached_cur = (void*) p;
+  *num_out = negative ? -d : d;
+  return 1;
+#else
+  // Without strict double evaluation the fast path could double-round.
+  return 0;
+#endif
+}
+
+
 qioerr qio_channel_scan_int(const int threadsafe, qio_channel_t* restrict ch, void* restrict out, size_t len, int issigned)
 {
   unsigned long long int num = 0;
@@ -2684,6 +3409,13 @@ qioerr qio_channel_scan_int(const int threadsafe, qio_channel_t* restrict ch, vo
 
   style = &ch->style;
 
+  if( _qio_fast_number_style(style) &&
+      ! (style->showpoint || style->precision > 0) &&
+      _qio_scan_int_fast(ch, issigned, &num, &sign) ) {
+    err = 0;
+    goto have_num;
+  }
+
   memset(&st, 0, sizeof(number_reading_state_t));
 
   st.base = style->base;
@@ -2749,6 +3481,7 @@ qioerr qio_channel_scan_int(const int threadsafe, qio_channel_t* restrict ch, vo
   // success!
   err = 0;
 
+have_num:
 error:
   if( err != 0 ) num = 0;
 
@@ -2844,6 +3577,12 @@ qioerr qio_channel_scan_float_or_imag(const int threadsafe, qio_channel_t* restr
 
   needs_i = imag && style->complex_style == QIO_COMPLEX_FORMAT_ABI;
 
+  if( ! needs_i && _qio_fast_number_style(style) &&
+      _qio_scan_double_fast(ch, style, &num) ) {
+    err = 0;
+    goto have_num;
+  }
+
   memset(&st, 0, sizeof(number_reading_state_t));
 
   st.base = style->base;
@@ -2966,6 +3705,7 @@ qioerr qio_channel_scan_float_or_imag(const int threadsafe, qio_channel_t* restr
 
   err = 0;
 
+have_num:
 error:
   if( err ) num = 0;
 
@@ -3165,6 +3905,273 @@ static int _find_prec(char *buf, int len){
   return last_dig;
 }
 
+// Shortest representation that reads back as the same double, using
+// Loitsch's Grisu2 ("Printing Floating-Point Numbers Quickly and
+// Accurately with Integers", PLDI 2010).  The output is always
+// correct and almost always the shortest possible.
+
+typedef struct qio_diy_fp_s {
+  uint64_t f;
+  int e;
+} qio_diy_fp_t;
+
+#define QIO_DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define QIO_DP_HIDDEN_BIT 0x0010000000000000ULL
+#define QIO_DP_EXPONENT_BIAS (0x3FF + 52)
+
+static inline
+qio_diy_fp_t _qio_diy_fp_mul(qio_diy_fp_t x, qio_diy_fp_t y)
+{
+  const uint64_t m32 = 0xFFFFFFFFULL;
+  uint64_t a = x.f >> 32, b = x.f & m32;
+  uint64_t c = y.f >> 32, d = y.f & m32;
+  uint64_t ac = a*c, bc = b*c, ad = a*d, bd = b*d;
+  uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+  qio_diy_fp_t r;
+
+  tmp += 1ULL << 31; // round
+  r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+  r.e = x.e + y.e + 64;
+  return r;
+}
+
+static inline
+qio_diy_fp_t _qio_diy_fp_normalize(qio_diy_fp_t x)
+{
+  int s = __builtin_clzll(x.f);
+  x.f <<= s;
+  x.e -= s;
+  return x;
+}
+
+// 10^k for k = -348, -340, ..., 340 as normalized 64-bit values.
+static const uint64_t _qio_cached_powers_f[] = {
+  0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+  0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+  0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+  0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+  0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+  0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+  0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+  0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+  0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+  0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+  0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+  0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+  0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+  0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+  0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+  0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+  0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+  0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+  0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+  0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+  0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+  0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+  0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+  0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+  0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+  0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+  0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+  0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+  0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+static const int16_t _qio_cached_powers_e[] = {
+  -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+  -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+  -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+  -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+  -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+  109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+  375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+  641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+  907, 933, 960, 986, 1013, 1039, 1066
+};
+
+static const uint64_t _qio_pow10_u64[] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+  10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+  100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+  100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+  100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static inline
+void _qio_grisu_round(char* buf, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+{
+  while( rest < wp_w && delta - rest >= ten_kappa &&
+         (rest + ten_kappa < wp_w ||
+          wp_w - rest > rest + ten_kappa - wp_w) ) {
+    buf[len - 1]--;
+    rest += ten_kappa;
+  }
+}
+
+static
+int _qio_count_digits32(uint32_t n)
+{
+  int k = 1;
+  while( k < 10 && n >= _qio_pow10_u64[k] ) k++;
+  return k;
+}
+
+// Generates the digits of a positive finite double into buf (at least
+// 18 bytes) and returns how many there are; the value is
+// digits * 10^(*k_out).
+static
+int _qio_grisu2(double value, char* buf, int* k_out)
+{
+  uint64_t bits;
+  qio_diy_fp_t v, w_plus, w_minus, c_mk, w, wp, wm, one, wp_w;
+  uint64_t delta, p2, tmp;
+  uint32_t p1;
+  uint32_t d;
+  double dk;
+  int biased_e;
+  int kappa;
+  int index;
+  int len = 0;
+  int k;
+
+  memcpy(&bits, &value, sizeof(bits));
+  biased_e = (int) ((bits >> 52) & 0x7FF);
+  v.f = bits & QIO_DP_SIGNIFICAND_MASK;
+  if( biased_e != 0 ) {
+    v.f += QIO_DP_HIDDEN_BIT;
+    v.e = biased_e - QIO_DP_EXPONENT_BIAS;
+  } else {
+    v.e = 1 - QIO_DP_EXPONENT_BIAS;
+  }
+
+  // The boundaries halfway to the neighboring doubles.
+  w_plus.f = (v.f << 1) + 1;
+  w_plus.e = v.e - 1;
+  w_plus = _qio_diy_fp_normalize(w_plus);
+  if( v.f == QIO_DP_HIDDEN_BIT ) {
+    w_minus.f = (v.f << 2) - 1;
+    w_minus.e = v.e - 2;
+  } else {
+    w_minus.f = (v.f << 1) - 1;
+    w_minus.e = v.e - 1;
+  }
+  w_minus.f <<= w_minus.e - w_plus.e;
+  w_minus.e = w_plus.e;
+
+  // Pick a cached power of ten that brings the exponent into range.
+  dk = (-61 - w_plus.e) * 0.30102999566398114 + 347;
+  k = (int) dk;
+  if( dk - k > 0.0 ) k++;
+  index = (k >> 3) + 1;
+  k = -(-348 + index * 8);
+  c_mk.f = _qio_cached_powers_f[index];
+  c_mk.e = _qio_cached_powers_e[index];
+
+  w = _qio_diy_fp_mul(_qio_diy_fp_normalize(v), c_mk);
+  wp = _qio_diy_fp_mul(w_plus, c_mk);
+  wm = _qio_diy_fp_mul(w_minus, c_mk);
+  wm.f++;
+  wp.f--;
+
+  // Generate digits until they identify a value within (wm, wp).
+  delta = wp.f - wm.f;
+  one.f = 1ULL << -wp.e;
+  one.e = wp.e;
+  wp_w.f = wp.f - w.f;
+  wp_w.e = wp.e;
+  p1 = (uint32_t) (wp.f >> -one.e);
+  p2 = wp.f & (one.f - 1);
+  kappa = _qio_count_digits32(p1);
+
+  while( kappa > 0 ) {
+    uint32_t div = (uint32_t) _qio_pow10_u64[kappa - 1];
+    d = p1 / div;
+    p1 %= div;
+    if( d || len ) buf[len++] = '0' + d;
+    kappa--;
+    tmp = ((uint64_t) p1 << -one.e) + p2;
+    if( tmp <= delta ) {
+      _qio_grisu_round(buf, len, delta, tmp,
+                       _qio_pow10_u64[kappa] << -one.e, wp_w.f);
+      *k_out = k + kappa;
+      return len;
+    }
+  }
+
+  while( 1 ) {
+    p2 *= 10;
+    delta *= 10;
+    d = (uint32_t) (p2 >> -one.e);
+    if( d || len ) buf[len++] = '0' + d;
+    p2 &= one.f - 1;
+    kappa--;
+    if( p2 < delta ) {
+      index = -kappa;
+      _qio_grisu_round(buf, len, delta, p2, one.f,
+                       wp_w.f * (index < 20 ? _qio_pow10_u64[index] : 0));
+      *k_out = k + kappa;
+      return len;
+    }
+  }
+}
+
+// Writes the shortest round-trip form of num into buf like %g would
+// lay it out: positional notation for exponents from -4 up to 15,
+// otherwise d.ddde+XX.  Behaves like snprintf with respect to buf_sz.
+static
+int _qio_shortest_dtoa(char* buf, size_t buf_sz, double num, int uppercase)
+{
+  char digits[24];
+  char out[40];
+  int ndigits;
+  int k;
+  int x; // decimal exponent of the first digit
+  int got = 0;
+  int i;
+
+  if( num == 0.0 ) {
+    out[got++] = '0';
+  } else {
+    ndigits = _qio_grisu2(num, digits, &k);
+    x = ndigits + k - 1;
+
+    if( x >= -4 && x < 16 ) {
+      if( x < 0 ) {
+        // 0.000ddd
+        out[got++] = '0';
+        out[got++] = '.';
+        for( i = 0; i < -x - 1; i++ ) out[got++] = '0';
+        for( i = 0; i < ndigits; i++ ) out[got++] = digits[i];
+      } else {
+        // ddd.ddd or ddd000
+        for( i = 0; i < ndigits || i <= x; i++ ) {
+          if( i == x + 1 ) out[got++] = '.';
+          out[got++] = (i < ndigits) ? digits[i] : '0';
+        }
+      }
+    } else {
+      out[got++] = digits[0];
+      if( ndigits > 1 ) {
+        out[got++] = '.';
+        for( i = 1; i < ndigits; i++ ) out[got++] = digits[i];
+      }
+      out[got++] = uppercase ? 'E' : 'e';
+      out[got++] = (x < 0) ? '-' : '+';
+      if( x < 0 ) x = -x;
+      if( x >= 100 ) out[got++] = '0' + x / 100;
+      out[got++] = '0' + (x / 10) % 10;
+      out[got++] = '0' + x % 10;
+    }
+  }
+
+  if( buf_sz > 0 ) {
+    size_t n = ((size_t) got < buf_sz) ? (size_t) got : buf_sz - 1;
+    memcpy(buf, out, n);
+    buf[n] = '\0';
+  }
+
+  return got;
+}
+
 // Converts num to a string in buf, returns the number
 // of bytes that would be used if space permits (not including null)
 // or -1 on error
@@ -3179,7 +4186,7 @@ static int _find_prec(char *buf, int len){
 // num is the number to be converted
 // buf and buf_sz are the output buffer
 // base is the numeric base (10 or 16 only)
-// realfmt is style->realfmt; 0->%g, 1->%f, 2->%e
+// realfmt is style->realfmt; 0->%g, 1->%f, 2->%e, 3->shortest
 // precision is the number of digits after . for %f or %e or
 //   the number of significant digits
 // uppercase indicates hex digits or exponent character should be uppercase
@@ -3245,7 +4252,7 @@ int _ftoa_core(char* buf, size_t buf_sz, double num,
           //It can also be done starting from the number itself
           //but this way avoids to deal with the loss of precision
           //caused by floating point representation
-          if(buf_sz > 0)
+          if(got < buf_sz)
             got = snprintf(buf, buf_sz, "%.*E",_find_prec(buf, got), num);
         }
         else
@@ -3253,7 +4260,7 @@ int _ftoa_core(char* buf, size_t buf_sz, double num,
       } else {
         if(num >= 100000.0 && num < 1000000.0){
           got = snprintf(buf, buf_sz, "%.5e", num);
-          if(buf_sz > 0)
+          if(got < buf_sz)
             got = snprintf(buf, buf_sz, "%.*e",_find_prec(buf, got), num);
         }
         else
@@ -3280,6 +4287,18 @@ int _ftoa_core(char* buf, size_t buf_sz, double num,
         got = snprintf(buf, buf_sz, "%.*f", precision, num);
       }
     }
+  } else if( realfmt == 3 ) {
+    if( precision < 0 && isfinite(num) ) {
+      got = _qio_shortest_dtoa(buf, buf_sz, num, uppercase);
+    } else if( precision < 0 ) {
+      got = snprintf(buf, buf_sz, uppercase ? "%G" : "%g", num);
+    } else {
+      if( uppercase ) {
+        got = snprintf(buf, buf_sz, "%.*G", precision, num);
+      } else {
+        got = snprintf(buf, buf_sz, "%.*g", precision, num);
+      }
+    }
   } else if( realfmt == 2 ) {
     if( precision < 0 ) {
       if( uppercase ) {
@@ -3938,6 +4957,16 @@ qioerr qio_channel_skip_past_newline(const int threadsafe, qio_channel_t* restri
     if( err ) return err;
   }
 
+  if( ! skipOnlyWs &&
+      (qio_glocale_utf8 == QIO_GLOCALE_UTF8 ||
+       qio_glocale_utf8 == QIO_GLOCALE_ASCII) ) {
+    // A newline byte can't be part of a multibyte UTF-8 sequence,
+    // so just search for the byte.
+    err = qio_channel_advance_past_byte(false, ch, '\n');
+    _qio_channel_set_error_unlocked(ch, err);
+    goto unlock;
+  }
+
   if( skipOnlyWs ) {
     err = qio_channel_mark(false, ch);
     if( err ) goto unlock;
@@ -4372,7 +5401,7 @@ qioerr _qio_channel_read_char_slow_unlocked(qio_channel_t* restrict ch, int32_t*
         // We always read 1 character at least.
         gotch = qio_channel_read_byte(false, ch);
         if( gotch < 0 ) {
-          err = qio_int_to_err(-got);
+          err = qio_int_to_err(-gotch);
           *chr = -1;
           break;
         }
@@ -30,7 +30,6 @@
 
 #include "qio_popen.h"
 
-#include <sys/select.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -451,8 +450,10 @@ qioerr qio_proc_communicate(
   bool input_ready;
   bool output_ready;
   bool error_ready;
-  fd_set rfds, wfds, efds;
-  int nfds = 1;
+  sys_poller_t* poller = NULL;
+  sys_poll_event_t events[3];
+  int nevents = 0;
+  int i;
 
   int input_fd = -1;
   int output_fd = -1;
@@ -495,18 +496,9 @@ qioerr qio_proc_communicate(
     }
   }
 
-  if( input ) {
-    input_fd = input->file->fd;
-    if( nfds <= input_fd ) nfds = input_fd + 1;
-  }
-  if( output ) {
-    output_fd = output->file->fd;
-    if( nfds <= output_fd ) nfds = output_fd + 1;
-  }
-  if( error ) {
-    error_fd = error->file->fd;
-    if( nfds <= error_fd ) nfds = error_fd + 1;
-  }
+  if( input ) input_fd = input->file->fd;
+  if( output ) output_fd = output->file->fd;
+  if( error ) error_fd = error->file->fd;
 
   // Adjust all three pipes to be non-blocking.
   if( input_fd != -1 ) {
@@ -546,58 +538,41 @@ qioerr qio_proc_communicate(
   do_output = (output != NULL);
   do_error = (error != NULL);
 
-  while( do_input || do_output || do_error ) {
-
-    // Now call select to wait for one of the descriptors to
-    // become ready.
+  // Wait for the pipes with a poller rather than polling them, so that
+  // the task waiting here lets others run on its thread.
+  if( !err ) err = qio_int_to_err(sys_poller_create(&poller));
+  if( !err && input_fd != -1 )
+    err = qio_int_to_err(sys_poller_add(poller, input_fd, SYS_POLL_WRITE, NULL));
+  if( !err && output_fd != -1 )
+    err = qio_int_to_err(sys_poller_add(poller, output_fd, SYS_POLL_READ, NULL));
+  if( !err && error_fd != -1 )
+    err = qio_int_to_err(sys_poller_add(poller, error_fd, SYS_POLL_READ, NULL));
+  if( err ) do_input = do_output = do_error = false;
 
-    FD_ZERO(&rfds);
-    FD_ZERO(&wfds);
-    FD_ZERO(&efds);
+  while( do_input || do_output || do_error ) {
 
-    if( do_input && input_fd != -1 ) {
-      FD_SET(input_fd, &wfds);
-      FD_SET(input_fd, &efds);
-    }
-    if( do_output && output_fd != -1 ) {
-      FD_SET(output_fd, &rfds);
-      FD_SET(output_fd, &efds);
-    }
-    if( do_error && error_fd != -1 ) {
-      FD_SET(error_fd, &rfds);
-      FD_SET(error_fd, &efds);
+    err = qio_int_to_err(sys_poller_wait(poller, events, 3, -1, &nevents));
+    if( qio_err_to_int(err) == EINTR ) {
+      err = 0;
+      continue;
     }
+    if( err ) break;
 
     input_ready = false;
     output_ready = false;
     error_ready = false;
 
-    // Run select to wait for something
-    if( do_input || do_output || do_error ) {
-      // TODO -- use sys_select so threading can interact
-      struct timeval t;
-      t.tv_sec = 0;
-      t.tv_usec = 10;
-      rc = select(nfds, &rfds, &wfds, &efds, &t);
-      if (rc > 0) {
-        // read ready file descriptors
-        input_ready = input_fd != -1 && FD_ISSET(input_fd, &wfds);
-        output_ready = output_fd != -1 && FD_ISSET(output_fd, &rfds);
-        error_ready = error_fd != -1 && FD_ISSET(error_fd, &rfds);
-      }
-      // Ignore EAGAIN and EINTR
-      if (rc == EAGAIN || rc == EINTR) rc = 0;
-    }
-
-    if( rc == -1 ) {
-      err = qio_int_to_err(errno);
-      break;
+    for( i = 0; i < nevents; i++ ) {
+      if( events[i].fd == input_fd ) input_ready = true;
+      if( events[i].fd == output_fd ) output_ready = true;
+      if( events[i].fd == error_fd ) error_ready = true;
     }
 
     if( do_input && input_ready ) {
       err = _qio_channel_flush_qio_unlocked(input);
       if( !err ) {
         do_input = false;
+        sys_poller_remove(poller, input_fd);
         // Close input channel.
         err = qio_channel_close(false, input);
       }
@@ -612,6 +587,7 @@ qioerr qio_proc_communicate(
         qio_file_t* output_file = qio_channel_get_file(output);
 
         do_output = false;
+        sys_poller_remove(poller, output_fd);
         // close the output file (not channel), in case closing output
         // causes the program to output on stderr, e.g.
         if( output_file )
@@ -632,6 +608,7 @@ qioerr qio_proc_communicate(
         qio_file_t* error_file = qio_channel_get_file(error);
 
         do_error = false;
+        sys_poller_remove(poller, error_fd);
         // close the error file (not channel)
         if( error_file )
           err = qio_file_close(error_file);
@@ -641,10 +618,10 @@ qioerr qio_proc_communicate(
       if( qio_err_to_int(err) == EAGAIN ) err = 0;
       if( err ) break;
     }
-
-    chpl_task_yield();
   }
 
+  if( poller ) sys_poller_destroy(poller);
+
   // we could close the file descriptors at this point,
   // but we don't because we don't want to modify
   // the file descriptor of the file since it's
@@ -674,6 +651,150 @@ qioerr qio_proc_communicate(
   return err;
 }
 
+// One direction of qio_proc_pump: moves src to dst, where pipe (one of
+// the two) is the child's pipe end that the pump waits on.
+typedef struct {
+  fd_t src;
+  fd_t dst;
+  fd_t pipe;
+  int events;
+  int old_flags;
+  bool use_copy;
+  bool done;
+  char* buf;
+  ssize_t buf_start;
+  ssize_t buf_end;
+  int64_t moved;
+} qio_pump_dir_t;
+
+// Moves whatever can be moved now without blocking on the pipe.
+// Returns EAGAIN when the pipe isn't ready and EEOF when src is done.
+static
+err_t qio_pump_step(qio_pump_dir_t* d, bool* progress)
+{
+  ssize_t n = 0;
+  err_t err;
+
+  if( d->use_copy && d->buf_start == d->buf_end ) {
+    err = sys_copy_fd(d->src, NULL, d->dst, NULL, qbytes_iobuf_size, &n);
+    if( err != ENOSYS ) {
+      if( !err && n == 0 ) err = EEOF;
+      if( n > 0 ) {
+        d->moved += n;
+        *progress = true;
+      }
+      return err;
+    }
+    // The kernel can't copy between these; use a bounce buffer.
+    d->use_copy = false;
+  }
+
+  if( ! d->buf ) {
+    d->buf = (char*) qio_malloc(qbytes_iobuf_size);
+    if( ! d->buf ) return ENOMEM;
+  }
+
+  if( d->buf_start == d->buf_end ) {
+    d->buf_start = d->buf_end = 0;
+    err = sys_read(d->src, d->buf, qbytes_iobuf_size, &n);
+    if( err ) return err;
+    d->buf_end = n;
+    *progress = true;
+  }
+
+  err = sys_write(d->dst, d->buf + d->buf_start,
+                  d->buf_end - d->buf_start, &n);
+  if( err ) return err;
+  d->buf_start += n;
+  d->moved += n;
+  *progress = true;
+
+  return 0;
+}
+
+qioerr qio_proc_pump(fd_t in_src, fd_t stdin_fd,
+                     fd_t stdout_fd, fd_t out_dst,
+                     int64_t* in_bytes_out, int64_t* out_bytes_out)
+{
+  qio_pump_dir_t dirs[2];
+  sys_poller_t* poller = NULL;
+  sys_poll_event_t events[2];
+  int nevents = 0;
+  bool progress;
+  err_t err = 0;
+  int i;
+
+  memset(dirs, 0, sizeof(dirs));
+  dirs[0].src = in_src;
+  dirs[0].dst = stdin_fd;
+  dirs[0].pipe = stdin_fd;
+  dirs[0].events = SYS_POLL_WRITE;
+  dirs[0].done = (in_src == -1 || stdin_fd == -1);
+  dirs[1].src = stdout_fd;
+  dirs[1].dst = out_dst;
+  dirs[1].pipe = stdout_fd;
+  dirs[1].events = SYS_POLL_READ;
+  dirs[1].done = (stdout_fd == -1 || out_dst == -1);
+
+  err = sys_poller_create(&poller);
+
+  // Make the child's pipe ends non-blocking so that neither direction
+  // can stall the other.
+  for( i = 0; i < 2 && !err; i++ ) {
+    qio_pump_dir_t* d = &dirs[i];
+    d->use_copy = true;
+    d->old_flags = -1;
+    if( d->done ) continue;
+    d->old_flags = fcntl(d->pipe, F_GETFL);
+    if( d->old_flags == -1 ||
+        fcntl(d->pipe, F_SETFL, d->old_flags | O_NONBLOCK) == -1 ) {
+      err = errno;
+      break;
+    }
+    err = sys_poller_add(poller, d->pipe, d->events, NULL);
+  }
+
+  while( !err && (!dirs[0].done || !dirs[1].done) ) {
+    progress = false;
+
+    for( i = 0; i < 2 && !err; i++ ) {
+      qio_pump_dir_t* d = &dirs[i];
+      if( d->done ) continue;
+
+      err = qio_pump_step(d, &progress);
+      if( err == EAGAIN || err == EWOULDBLOCK ) {
+        err = 0;
+      } else if( err == EEOF || (i == 0 && err == EPIPE) ) {
+        // src is exhausted, or the child stopped reading its input.
+        err = 0;
+        d->done = true;
+        sys_poller_remove(poller, d->pipe);
+        fcntl(d->pipe, F_SETFL, d->old_flags);
+        d->old_flags = -1;
+        // Closing the child's stdin lets it see the end of its input.
+        if( i == 0 ) err = sys_close(stdin_fd);
+      }
+    }
+
+    // Only wait when neither direction could move anything.
+    if( !err && !progress && (!dirs[0].done || !dirs[1].done) ) {
+      err = sys_poller_wait(poller, events, 2, -1, &nevents);
+      if( err == EINTR ) err = 0;
+    }
+  }
+
+  for( i = 0; i < 2; i++ ) {
+    if( dirs[i].old_flags != -1 ) fcntl(dirs[i].pipe, F_SETFL, dirs[i].old_flags);
+    if( dirs[i].buf ) qio_free(dirs[i].buf);
+  }
+  if( poller ) sys_poller_destroy(poller);
+
+  if( in_bytes_out ) *in_bytes_out = dirs[0].moved;
+  if( out_bytes_out ) *out_bytes_out = dirs[1].moved;
+
+  return qio_int_to_err(err);
+}
+
 // Send a signal to the specified pid
 qioerr qio_send_signal(int64_t pid, int sig)
 {
@@ -23,6 +23,8 @@
 #define CHPL_RE2
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
 #include <pthread.h>
 #include <stdlib.h>
@@ -43,6 +45,7 @@
 #undef printf
 
 #include "re2/re2.h"
+#include "re2/set.h"
 
 using namespace re2;
 
@@ -153,6 +156,89 @@ void re_free(re_t* re)
 }
 
 
+static
+bool re_matches(re_t* re, const char* str, int64_t str_len, const qio_regexp_options_t* options)
+{
+  const string& pat = re->re.pattern();
+  const RE2::Options& opt = re->re.options();
+  return (uint64_t) pat.length() == (uint64_t) str_len &&
+         0 == memcmp(pat.data(), str, str_len ) &&
+         equal_options(&opt, options);
+}
+
+// A process-wide cache behind the per-thread ones, so that tasks running
+// on different threads share one compiled RE2 (which is safe to match
+// with from several threads at once). Lookups only take the read lock.
+#define REGEXP_GLOBAL_CACHE_SIZE 64
+struct global_cache_elem {
+  std::atomic<int64_t> date;
+  re_t* re;
+};
+
+static pthread_rwlock_t global_cache_lock = PTHREAD_RWLOCK_INITIALIZER;
+static std::atomic<int64_t> global_cache_date;
+static global_cache_elem global_cache[REGEXP_GLOBAL_CACHE_SIZE];
+
+// Returns a retained re_t for the pattern, compiling it if no thread
+// has yet.
+static
+re_t* global_cache_get(const char* str, int64_t str_len, const qio_regexp_options_t* options) {
+  re_t* re = NULL;
+  re_t* evicted = NULL;
+  int64_t date = ++global_cache_date;
+  int oldest;
+  int64_t oldest_date;
+
+  pthread_rwlock_rdlock(&global_cache_lock);
+  for( int i = 0; i < REGEXP_GLOBAL_CACHE_SIZE; i++ ) {
+    if( global_cache[i].re &&
+        re_matches(global_cache[i].re, str, str_len, options) ) {
+      global_cache[i].date.store(date, std::memory_order_relaxed);
+      re = global_cache[i].re;
+      DO_RETAIN(re);
+      break;
+    }
+  }
+  pthread_rwlock_unlock(&global_cache_lock);
+  if( re ) return re;
+
+  // Compile without holding the lock.
+  RE2::Options opts;
+  qio_re_options_to_re2_options(options, &opts);
+  StringPiece strp(str, str_len);
+  re = new re_t(strp, opts, NULL);
+
+  pthread_rwlock_wrlock(&global_cache_lock);
+  oldest = 0;
+  oldest_date = global_cache[0].date.load(std::memory_order_relaxed);
+  for( int i = 0; i < REGEXP_GLOBAL_CACHE_SIZE; i++ ) {
+    int64_t d = global_cache[i].date.load(std::memory_order_relaxed);
+    if( d < oldest_date ) {
+      oldest = i;
+      oldest_date = d;
+    }
+    if( global_cache[i].re &&
+        re_matches(global_cache[i].re, str, str_len, options) ) {
+      // Another thread compiled it first; use theirs.
+      evicted = re;
+      re = global_cache[i].re;
+      oldest = -1;
+      break;
+    }
+  }
+  if( oldest >= 0 ) {
+    // The cache keeps the reference re_t was created with.
+    evicted = global_cache[oldest].re;
+    global_cache[oldest].re = re;
+    global_cache[oldest].date.store(date, std::memory_order_relaxed);
+  }
+  DO_RETAIN(re);
+  pthread_rwlock_unlock(&global_cache_lock);
+
+  if( evicted ) DO_RELEASE(evicted, re_free);
+  return re;
+}
+
 static
 re_t* local_cache_get(const char* str, int64_t str_len, const qio_regexp_options_t* options) {
   re_cache* c = local_cache();
@@ -169,11 +255,7 @@ re_t* local_cache_get(const char* str, int64_t str_len, const qio_regexp_options
       oldest_date = c->elems[i].date;
     }
     if( ! c->elems[i].re ) continue;
-    const string& pat = c->elems[i].re->re.pattern();
-    const RE2::Options& opt = c->elems[i].re->re.options();
-    if( (uint64_t) pat.length() == (uint64_t) str_len &&
-        0 == memcmp(pat.data(), str, str_len ) &&
-        equal_options(&opt, options) ) {
+    if( re_matches(c->elems[i].re, str, str_len, options) ) {
       // Make the date current.
       c->elems[i].date = c->date;
       // Return this element.
@@ -188,11 +270,9 @@ re_t* local_cache_get(const char* str, int64_t str_len, const qio_regexp_options
   // If we found no match, replace oldest.
   if( c->elems[oldest].re) DO_RELEASE(c->elems[oldest].re, re_free);
 
-  // Put a new RE in that slot.
-  RE2::Options opts;
-  qio_re_options_to_re2_options(options, &opts);
-  StringPiece strp(str, str_len);
-  re_t* re = new re_t(strp, opts, c);
+  // Put the RE from the global cache in that slot; the local cache
+  // keeps the reference global_cache_get returned.
+  re_t* re = global_cache_get(str, str_len, options);
   c->elems[oldest].date = c->date;
   c->elems[oldest].re = re;
   // We increment the reference count before returning a copy to the
@@ -410,6 +490,228 @@ void qio_regexp_channel_discard(qio_channel_s* ch, int64_t cur, int64_t min)
 }
 
 
+// How many bytes the block-oriented matcher below searches at a time.
+static const int64_t qio_regexp_chunk_bytes = 64*1024;
+
+enum {
+  QIO_REGEXP_CHUNKED_NOMATCH = 0,
+  QIO_REGEXP_CHUNKED_MATCH = 1,
+  QIO_REGEXP_CHUNKED_FALLBACK = 2,
+};
+
+// Gets a contiguous window of up to want bytes starting at the channel's
+// current offset, without moving it. The window is the channel's cached
+// region if that holds everything available or at least min_len bytes;
+// otherwise the bytes are copied into *scratch (allocated here and freed
+// by the caller). at_eof_out is set if the window ends at EOF.
+static
+qioerr qio_regexp_channel_window(qio_channel_s* ch, int64_t want,
+                                 int64_t min_len, bool read_ahead,
+                                 char** scratch, const char** data_out,
+                                 int64_t* len_out, bool* at_eof_out)
+{
+  void* bufstart = NULL;
+  void* bufend = NULL;
+  int64_t total, avail, cached;
+  ssize_t amt = 0;
+  bool eof = false;
+  qioerr err = 0;
+
+  *at_eof_out = false;
+
+  _qio_buffered_advance_cached(ch);
+  total = qio_channel_nbytes_available_unlocked(ch);
+  if( qio_err_to_int(qio_channel_error(ch)) == EEOF ) {
+    // An earlier read already hit EOF, so the buffer has all there is.
+    eof = true;
+  } else if( read_ahead && total < want &&
+             (total < min_len || total < want / 2) ) {
+    // Read more when the buffer is getting short, rather than topping
+    // it up by a few bytes on every search.
+    err = qio_channel_require_read(false, ch, want);
+    if( qio_err_to_int(err) == EEOF ) {
+      eof = true;
+      err = 0;
+    }
+    if( err ) return err;
+    total = qio_channel_nbytes_available_unlocked(ch);
+  }
+
+  avail = total;
+  if( avail > want ) avail = want;
+  if( min_len > avail ) min_len = avail;
+
+  err = qio_channel_begin_peek_cached(false, ch, &bufstart, &bufend);
+  if( qio_err_to_int(err) == EEOF ) err = 0; // ignore EOF
+  if( err ) return err;
+
+  cached = bufstart ? qio_ptr_diff(bufend, bufstart) : 0;
+  if( cached > avail ) cached = avail;
+
+  if( cached >= min_len ) {
+    *data_out = (const char*) bufstart;
+    *len_out = cached;
+    *at_eof_out = eof && cached == total;
+    return 0;
+  }
+
+  // The bytes span more than one part of the buffer, so copy them.
+  if( ! *scratch ) {
+    *scratch = (char*) qio_malloc(std::max(want, qio_regexp_chunk_bytes + 1));
+    if( ! *scratch ) QIO_RETURN_CONSTANT_ERROR(ENOMEM, "out of memory");
+  }
+  // Copy only as much as the caller needs.
+  if( avail > 2 * min_len ) avail = 2 * min_len;
+  err = qio_channel_mark(false, ch);
+  if( err ) return err;
+  err = qio_channel_read(false, ch, *scratch, avail, &amt);
+  qio_channel_revert_unlocked(ch);
+  if( qio_err_to_int(err) == EEOF ) err = 0; // ignore EOF
+  if( err ) return err;
+
+  *data_out = *scratch;
+  *len_out = amt;
+  *at_eof_out = eof && amt == total;
+  return 0;
+}
+
+// Searches [start_offset, end) by running the in-memory matcher over
+// contiguous windows of the channel, instead of reading a byte at a time
+// through MatchFile. A window answers the search when it reaches end (or
+// EOF) or, for patterns with a bounded match length, when every match that
+// could start at or before the one found fits inside it. Unanchored
+// searches with a bounded match length skip ahead a window at a time,
+// discarding what they skipped if discard is set.
+//
+// Returns QIO_REGEXP_CHUNKED_FALLBACK, with the channel still at
+// start_offset, when MatchFile needs to do the search. Otherwise a match
+// is stored in captures and match_start_out/match_len_out, and after no
+// match the channel is left at the end of the searched region.
+static
+int qio_regexp_channel_match_chunked(RE2* re, qio_channel_s* ch,
+                                     int64_t start_offset, int64_t end,
+                                     RE2::Anchor ranchor, bool discard,
+                                     qio_regexp_string_piece_t* captures,
+                                     int64_t ncaptures,
+                                     int64_t* match_start_out,
+                                     int64_t* match_len_out,
+                                     qioerr* err_out)
+{
+  int64_t maxmatch = re->max_match_length_bytes();
+  int64_t pos = start_offset; // offset of the window's first byte
+  int64_t ctx = 0; // leading window bytes that are only context
+  int64_t want, min_len, len, wend, next;
+  int64_t mstart = -1;
+  int64_t mlen = 0;
+  int nvec = (ncaptures > 0) ? (int) ncaptures : 1;
+  int i;
+  const char* data = NULL;
+  char* scratch = NULL;
+  bool read_ahead;
+  bool at_eof = false;
+  bool at_end, found, conclusive;
+  int ret = QIO_REGEXP_CHUNKED_FALLBACK;
+  qioerr err = 0;
+  StringPiece* vec = NULL;
+  MAYBE_STACK_SPACE(StringPiece, vec_onstack);
+
+  // Only read ahead on files where that can't block for more input
+  // than the search ends up needing.
+  read_ahead = ch->file && (ch->file->fdflags & QIO_FDFLAG_SEEKABLE);
+
+  // Windows have to be able to hold a match plus some progress, so treat
+  // very long bounded matches as unbounded.
+  if( maxmatch >= qio_regexp_chunk_bytes / 8 ) maxmatch = -1;
+
+  // Without a bound on the match length, only a window holding all of
+  // [start_offset, end) answers the search; don't bother reading one
+  // for a search that could go much further.
+  if( maxmatch < 0 && end - start_offset > qio_regexp_chunk_bytes )
+    return QIO_REGEXP_CHUNKED_FALLBACK;
+
+  // A pattern starting with ^ is an anchored search.
+  if( ranchor == RE2::UNANCHORED && re->anchored_at_start() )
+    ranchor = RE2::ANCHOR_START;
+
+  MAYBE_STACK_ALLOC(StringPiece, nvec, vec, vec_onstack);
+
+  while( true ) {
+    want = qio_regexp_chunk_bytes + ctx;
+    if( end - pos < want ) want = end - pos;
+    min_len = (maxmatch < 0) ? want : 2 * (maxmatch + 1) + ctx;
+
+    err = qio_regexp_channel_window(ch, want, min_len, read_ahead, &scratch,
+                                    &data, &len, &at_eof);
+    if( err ) break;
+
+    wend = pos + len;
+    at_end = at_eof || wend >= end;
+
+    // A match anchored at both ends has to end at end.
+    if( ranchor == RE2::ANCHOR_BOTH && ! at_end ) break;
+
+    found = re->Match(StringPiece(data, len), ctx, len, ranchor, vec, nvec);
+    if( found ) {
+      mstart = pos + (vec[0].data() - data);
+      mlen = vec[0].size();
+    }
+
+    if( at_end ) conclusive = true;
+    else if( maxmatch < 0 ) conclusive = false;
+    else if( found ) conclusive = mstart + maxmatch < wend;
+    else conclusive = ranchor != RE2::UNANCHORED &&
+                      pos + ctx + maxmatch < wend;
+
+    if( conclusive ) {
+      if( found ) {
+        for( i = 0; i < ncaptures; i++ ) {
+          if( vec[i].data() == NULL ) {
+            captures[i].offset = -1;
+            captures[i].len = 0;
+          } else {
+            captures[i].offset = pos + (vec[i].data() - data);
+            captures[i].len = vec[i].size();
+          }
+        }
+        *match_start_out = mstart;
+        *match_len_out = mlen;
+        ret = QIO_REGEXP_CHUNKED_MATCH;
+      } else {
+        // Leave the channel after everything we searched.
+        qio_channel_advance_unlocked(ch, len);
+        ret = QIO_REGEXP_CHUNKED_NOMATCH;
+      }
+      break;
+    }
+
+    // Anchored and unbounded searches only get the first window, as do
+    // channels we can't read ahead on.
+    if( ranchor != RE2::UNANCHORED || maxmatch < 0 || ! read_ahead ) break;
+
+    // No match can start before next, so continue from there, keeping
+    // the byte before it as context for ^ and \b.
+    next = wend - maxmatch;
+    if( next - 1 <= pos ) {
+      // Windows are at least min_len long unless at_end, so this
+      // should not happen; but we can't fall back after skipping.
+      if( pos == start_offset ) break;
+      QIO_GET_CONSTANT_ERROR(err, EINVAL, "regexp window too small");
+      break;
+    }
+    qio_channel_advance_unlocked(ch, next - 1 - pos);
+    pos = next - 1;
+    ctx = 1;
+    if( discard ) qio_regexp_channel_discard(ch, pos, pos);
+  }
+
+  MAYBE_STACK_FREE(vec, vec_onstack);
+  if( scratch ) qio_free(scratch);
+
+  *err_out = err;
+  if( err ) return QIO_REGEXP_CHUNKED_NOMATCH;
+  return ret;
+}
+
 qioerr qio_regexp_channel_match(const qio_regexp_t* regexp, const int threadsafe, struct qio_channel_s* ch, int64_t maxlen, int anchor, qio_bool can_discard, qio_bool keep_unmatched, qio_bool keep_whole_pattern, qio_regexp_string_piece_t* captures, int64_t ncaptures)
 {
   RE2* re = (RE2*) regexp->regexp;
@@ -429,6 +731,7 @@ qioerr qio_regexp_channel_match(const qio_regexp_t* regexp, const int threadsafe
   bool found = false;
   int i;
   int use_captures = ncaptures;
+  int chunked;
   bool atEOF = false;
   MAYBE_STACK_SPACE(FilePiece, caps_onstack);
 
@@ -484,6 +787,20 @@ qioerr qio_regexp_channel_match(const qio_regexp_t* regexp, const int threadsafe
     err = 0;
   }
 
+  // Try searching contiguous windows of the buffer first.
+  if( ! atEOF && FilePiece::allow_buffer_search() ) {
+    chunked = qio_regexp_channel_match_chunked(re, ch, start_offset, end,
+                                               ranchor,
+                                               can_discard && ! keep_unmatched,
+                                               captures, ncaptures,
+                                               &match_start, &match_len,
+                                               &err);
+    if( chunked != QIO_REGEXP_CHUNKED_FALLBACK ) {
+      found = (chunked == QIO_REGEXP_CHUNKED_MATCH);
+      goto error;
+    }
+  }
+
   // Require at least 1 byte and at most 1024 bytes.
   need = re->min_match_length_bytes();
   if( need <= 0 ) need = 1;
@@ -582,3 +899,185 @@ markerror:
 }
 
 
+
+struct re_set_t {
+  RE2::Set set;
+  qbytes_refcnt_t ref_cnt;
+  int64_t size;
+  bool compiled;
+  re_set_t(const RE2::Options& options, RE2::Anchor anchor)
+    : set(options, anchor), size(0), compiled(false)
+  {
+    DO_INIT_REFCNT(this);
+  }
+};
+
+static
+void re_set_free(re_set_t* s)
+{
+  delete s;
+}
+
+void qio_regexp_set_create(const qio_regexp_options_t* options, int anchor, qio_regexp_set_t* set_out)
+{
+  RE2::Options opts;
+  RE2::Anchor ranchor = RE2::UNANCHORED;
+
+  qio_re_options_to_re2_options(options, &opts);
+  // Errors are reported through qio_regexp_set_add.
+  opts.set_log_errors(false);
+
+  if( anchor == QIO_REGEXP_ANCHOR_START ) ranchor = RE2::ANCHOR_START;
+  else if( anchor == QIO_REGEXP_ANCHOR_BOTH ) ranchor = RE2::ANCHOR_BOTH;
+
+  set_out->set = (void*) new re_set_t(opts, ranchor);
+}
+
+void qio_regexp_set_retain(const qio_regexp_set_t* set)
+{
+  re_set_t* s = (re_set_t*) set->set;
+  DO_RETAIN(s);
+}
+
+void qio_regexp_set_release(qio_regexp_set_t* set)
+{
+  re_set_t* s = (re_set_t*) set->set;
+  DO_RELEASE(s, re_set_free);
+  set->set = NULL;
+}
+
+int64_t qio_regexp_set_add(qio_regexp_set_t* set, const char* str, int64_t str_len, const char** error_out)
+{
+  re_set_t* s = (re_set_t*) set->set;
+  std::string error;
+  int idx;
+
+  if( error_out ) *error_out = NULL;
+
+  if( s->compiled ) {
+    if( error_out ) *error_out = qio_strdup("regexp set is already compiled");
+    return -1;
+  }
+
+  idx = s->set.Add(StringPiece(str, str_len), &error);
+  if( idx < 0 ) {
+    if( error_out ) *error_out = qio_strdup(error.c_str());
+    return -1;
+  }
+
+  s->size++;
+  return idx;
+}
+
+qio_bool qio_regexp_set_compile(qio_regexp_set_t* set)
+{
+  re_set_t* s = (re_set_t*) set->set;
+
+  if( ! s->compiled ) s->compiled = s->set.Compile();
+  return s->compiled;
+}
+
+int64_t qio_regexp_set_size(const qio_regexp_set_t* set)
+{
+  re_set_t* s = (re_set_t*) set->set;
+  return s->size;
+}
+
+static
+int64_t re_set_match(re_set_t* s, const char* str, int64_t str_len, int64_t* matches, int64_t nmatches)
+{
+  std::vector<int> v;
+  RE2::Set::ErrorInfo info;
+  int64_t i;
+
+  if( ! s->compiled ) return -1;
+
+  if( ! s->set.Match(StringPiece(str, str_len), &v, &info) ) {
+    if( info.kind != RE2::Set::kNoError ) return -1;
+    return 0;
+  }
+
+  std::sort(v.begin(), v.end());
+  for( i = 0; i < nmatches && i < (int64_t) v.size(); i++ ) {
+    matches[i] = v[i];
+  }
+  return v.size();
+}
+
+int64_t qio_regexp_set_match(const qio_regexp_set_t* set, const char* str, int64_t str_len, int64_t* matches, int64_t nmatches)
+{
+  return re_set_match((re_set_t*) set->set, str, str_len, matches, nmatches);
+}
+
+qioerr qio_regexp_set_channel_match(const qio_regexp_set_t* set, const int threadsafe, struct qio_channel_s* ch, int64_t maxlen, int delim, int64_t* matches, int64_t nmatches, int64_t* nmatched_out)
+{
+  re_set_t* s = (re_set_t*) set->set;
+  qioerr err;
+  int64_t start, len, consume;
+  int64_t wlen = 0;
+  int64_t nmatched = 0;
+  const char* data = NULL;
+  char* scratch = NULL;
+  bool at_eof = false;
+
+  *nmatched_out = 0;
+
+  if( delim < 0 && maxlen == std::numeric_limits<int64_t>::max() )
+    QIO_RETURN_CONSTANT_ERROR(EINVAL, "regexp set match needs a delimiter or a maximum length");
+
+  if( threadsafe ) {
+    err = qio_lock(&ch->lock);
+    if( err ) {
+      return err;
+    }
+  }
+
+  err = qio_channel_mark(false, ch);
+  if( err ) goto unlock;
+
+  // Find the end of the record, leaving it in the buffer.
+  start = qio_channel_offset_unlocked(ch);
+  if( delim >= 0 ) {
+    err = qio_channel_advance_past_byte(false, ch, delim);
+    consume = qio_channel_offset_unlocked(ch) - start;
+    len = consume;
+    if( err == 0 ) len--; // don't match against the delimiter
+  } else {
+    err = qio_channel_require_read(false, ch, maxlen);
+    len = consume = qio_channel_nbytes_available_unlocked(ch);
+    if( consume > maxlen ) len = consume = maxlen;
+  }
+  qio_channel_revert_unlocked(ch);
+
+  if( qio_err_to_int(err) == EEOF ) {
+    err = (consume == 0) ? QIO_EEOF : 0;
+  }
+  if( err ) goto unlock;
+
+  if( len > maxlen ) len = maxlen;
+
+  // Match against the record where it sits in the buffer.
+  err = qio_regexp_channel_window(ch, len, len, true, &scratch,
+                                  &data, &wlen, &at_eof);
+  if( err ) goto unlock;
+
+  nmatched = re_set_match(s, data, wlen, matches, nmatches);
+  if( nmatched < 0 ) {
+    QIO_GET_CONSTANT_ERROR(err, ENOMEM, "regexp set match failed");
+    goto unlock;
+  }
+
+  err = qio_channel_advance_unlocked(ch, consume);
+  if( err ) goto unlock;
+
+  *nmatched_out = nmatched;
+
+unlock:
+  if( scratch ) qio_free(scratch);
+
+  if( threadsafe ) {
+    qio_unlock(&ch->lock);
+  }
+
+  return err;
+}
@@ -24,6 +24,11 @@
 #endif
 #define _POSIX_C_SOURCE 20112L
 
+#ifndef _GNU_SOURCE
+// get splice, SPLICE_F_MOVE, loff_t
+#define _GNU_SOURCE
+#endif
+
 #ifndef CHPL_RT_UNIT_TEST
 #include "chplrt.h"
 #endif
@@ -1233,6 +1238,90 @@ err_t sys_pwritev(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_of
 }
 
 
+#endif
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+
+err_t sys_copy_fd(fd_t in_fd, off_t* in_off, fd_t out_fd, off_t* out_off, size_t len, ssize_t* num_copied_out)
+{
+  struct stat in_st;
+  struct stat out_st;
+  loff_t in_pos = in_off ? *in_off : 0;
+  loff_t out_pos = out_off ? *out_off : 0;
+  ssize_t got = -1;
+  err_t err_out = 0;
+
+  *num_copied_out = 0;
+
+  if( fstat(in_fd, &in_st) != 0 ) return errno;
+  if( fstat(out_fd, &out_st) != 0 ) return errno;
+
+  STARTING_SLOW_SYSCALL;
+
+#ifdef SYS_copy_file_range
+  // file to file; can share extents on some file systems
+  if( S_ISREG(in_st.st_mode) && S_ISREG(out_st.st_mode) ) {
+    got = syscall(SYS_copy_file_range, in_fd, in_off ? &in_pos : NULL,
+                  out_fd, out_off ? &out_pos : NULL, len, 0);
+    if( got == -1 &&
+        errno != EXDEV && errno != ENOSYS && errno != EINVAL &&
+        errno != EOPNOTSUPP ) {
+      err_out = errno;
+      goto done;
+    }
+  }
+#endif
+
+  // file to anything, written at the output's file position
+  if( got == -1 && S_ISREG(in_st.st_mode) && out_off == NULL ) {
+    off_t pos = in_pos;
+    got = sendfile(out_fd, in_fd, in_off ? &pos : NULL, len);
+    if( got != -1 ) {
+      in_pos = pos;
+    } else if( errno != EINVAL && errno != ENOSYS ) {
+      err_out = errno;
+      goto done;
+    }
+  }
+
+  // to or from a pipe
+  if( got == -1 &&
+      ((S_ISFIFO(in_st.st_mode) && in_off == NULL) ||
+       (S_ISFIFO(out_st.st_mode) && out_off == NULL)) ) {
+    got = splice(in_fd, in_off ? &in_pos : NULL,
+                 out_fd, out_off ? &out_pos : NULL, len, SPLICE_F_MOVE);
+    if( got == -1 && errno != EINVAL && errno != ENOSYS ) {
+      err_out = errno;
+      goto done;
+    }
+  }
+
+  if( got == -1 ) {
+    err_out = ENOSYS;
+    goto done;
+  }
+
+  *num_copied_out = got;
+  // Each call above advances the offsets it was given.
+  if( in_off ) *in_off = in_pos;
+  if( out_off ) *out_off = out_pos;
+
+done:
+  DONE_SLOW_SYSCALL;
+
+  return err_out;
+}
+
+#else
+
+err_t sys_copy_fd(fd_t in_fd, off_t* in_off, fd_t out_fd, off_t* out_off, size_t len, ssize_t* num_copied_out)
+{
+  *num_copied_out = 0;
+  return ENOSYS;
+}
+
 #endif
 
 err_t sys_fsync(fd_t fd)
@@ -1364,6 +1453,312 @@ poll
 epoll
 */
 
+//
+// Socket calls on blocking fds would tie up a whole worker thread while
+// they wait.  Instead we make the call non-blocking and, if it would
+// have blocked, have the tasking layer park this task until the fd is
+// ready and then try again.  Other tasks can run on the thread in the
+// meantime.  Calls the user asked to be non-blocking, and calls on
+// non-blocking fds, behave as they always did.
+//
+#if defined(MSG_DONTWAIT) && !defined(CHPL_RT_UNIT_TEST)
+#define SYS_MSG_DONTWAIT MSG_DONTWAIT
+
+// see chpl-tasks.h
+#define CHPL_TASK_FD_READ  0x1
+#define CHPL_TASK_FD_WRITE 0x2
+extern int chpl_task_waitForFd(int fd, int events, int64_t timeout_usec);
+#define SYS_HAS_TASK_WAIT_FD
+
+static
+int sys_fd_is_blocking(fd_t fd)
+{
+  int fl = fcntl(fd, F_GETFL);
+  return fl != -1 && (fl & O_NONBLOCK) == 0;
+}
+
+// Returns true if the caller should retry the call that got 'err'.
+static
+int sys_wait_and_retry(fd_t fd, int flags, int err, int events)
+{
+  if ((err != EAGAIN && err != EWOULDBLOCK) ||
+      (flags & MSG_DONTWAIT) != 0 ||
+      !sys_fd_is_blocking(fd)) {
+    errno = err;
+    return 0;
+  }
+
+  if (chpl_task_waitForFd(fd, events, -1) != 0) {
+    errno = err;
+    return 0;
+  }
+
+  return 1;
+}
+
+static
+void sys_wait_if_blocking(fd_t fd, int events)
+{
+  if (sys_fd_is_blocking(fd))
+    (void) chpl_task_waitForFd(fd, events, -1);
+}
+#else
+#define SYS_MSG_DONTWAIT 0
+#define CHPL_TASK_FD_READ  0x1
+#define CHPL_TASK_FD_WRITE 0x2
+#define sys_wait_and_retry(fd, flags, err, events) 0
+#define sys_wait_if_blocking(fd, events) do { } while (0)
+#endif
+
+//
+// io_uring support for sys_uring_rw().  There is one ring per process,
+// shared by all threads and protected by a mutex; submitting and reaping
+// are both short, non-blocking operations done under the lock.  Whoever
+// holds the lock reaps every completion in the ring and hands each one to
+// the op it belongs to, so a waiter may find its batch finished by some
+// other thread.  Waiting is done on the ring fd (which polls readable when
+// completions are present) so the tasking layer can run other tasks.
+//
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAS_IO_URING
+#endif
+#endif
+
+#ifdef HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <poll.h>
+
+#define SYS_URING_ENTRIES 256
+
+static struct {
+  int fd;
+  unsigned* sq_tail;
+  unsigned* sq_head;
+  unsigned* sq_mask;
+  unsigned* sq_array;
+  unsigned sq_entries;
+  struct io_uring_sqe* sqes;
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned* cq_mask;
+  struct io_uring_cqe* cqes;
+  unsigned cq_entries;
+  unsigned inflight;     // submitted or queued, not yet reaped
+  unsigned unsubmitted;  // queued in the SQ, not yet taken by the kernel
+  pthread_mutex_t lock;
+} sys_uring = { -1 };
+
+static pthread_once_t sys_uring_once = PTHREAD_ONCE_INIT;
+
+static
+void sys_uring_setup(void)
+{
+  struct io_uring_params p;
+  size_t sq_sz, cq_sz;
+  char* sq_ptr;
+  char* cq_ptr;
+  void* sqes;
+  int fd;
+
+  memset(&p, 0, sizeof(p));
+  fd = (int) syscall(__NR_io_uring_setup, SYS_URING_ENTRIES, &p);
+  if (fd < 0) return;
+
+  sq_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if ((p.features & IORING_FEAT_SINGLE_MMAP) && cq_sz > sq_sz)
+    sq_sz = cq_sz;
+
+  sq_ptr = mmap(NULL, sq_sz, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ptr == MAP_FAILED) goto error;
+
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ptr = sq_ptr;
+  } else {
+    cq_ptr = mmap(NULL, cq_sz, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ptr == MAP_FAILED) goto error;
+  }
+
+  sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+              PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+              fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) goto error;
+
+  sys_uring.sq_tail = (unsigned*) (sq_ptr + p.sq_off.tail);
+  sys_uring.sq_head = (unsigned*) (sq_ptr + p.sq_off.head);
+  sys_uring.sq_mask = (unsigned*) (sq_ptr + p.sq_off.ring_mask);
+  sys_uring.sq_array = (unsigned*) (sq_ptr + p.sq_off.array);
+  sys_uring.sq_entries = p.sq_entries;
+  sys_uring.sqes = (struct io_uring_sqe*) sqes;
+  sys_uring.cq_head = (unsigned*) (cq_ptr + p.cq_off.head);
+  sys_uring.cq_tail = (unsigned*) (cq_ptr + p.cq_off.tail);
+  sys_uring.cq_mask = (unsigned*) (cq_ptr + p.cq_off.ring_mask);
+  sys_uring.cqes = (struct io_uring_cqe*) (cq_ptr + p.cq_off.cqes);
+  sys_uring.cq_entries = p.cq_entries;
+  pthread_mutex_init(&sys_uring.lock, NULL);
+  sys_uring.fd = fd;
+  return;
+
+error:
+  // The mappings go away with the fd.
+  close(fd);
+}
+
+int sys_uring_available(void)
+{
+  pthread_once(&sys_uring_once, sys_uring_setup);
+  return sys_uring.fd >= 0;
+}
+
+// Hand every completion in the ring to its op.  Called with the lock held.
+static
+void sys_uring_reap(void)
+{
+  unsigned head = *sys_uring.cq_head;
+  unsigned tail = __atomic_load_n(sys_uring.cq_tail, __ATOMIC_ACQUIRE);
+
+  while (head != tail) {
+    struct io_uring_cqe* cqe = &sys_uring.cqes[head & *sys_uring.cq_mask];
+    sys_uring_op_t* op = (sys_uring_op_t*) (uintptr_t) cqe->user_data;
+    op->result = cqe->res;
+    (*op->pending)--;
+    sys_uring.inflight--;
+    head++;
+  }
+
+  __atomic_store_n(sys_uring.cq_head, head, __ATOMIC_RELEASE);
+}
+
+// Pass queued SQEs to the kernel.  If it refuses them outright, take them
+// back out of the SQ and fail their ops.  Called with the lock held.
+static
+void sys_uring_submit(void)
+{
+  int got;
+
+  while (sys_uring.unsubmitted > 0) {
+    got = (int) syscall(__NR_io_uring_enter, sys_uring.fd,
+                        sys_uring.unsubmitted, 0, 0, NULL, 0);
+    if (got > 0) {
+      sys_uring.unsubmitted -= got;
+    } else if (got == 0 || errno == EAGAIN || errno == EBUSY) {
+      // Out of kernel resources for now; try again once something
+      // completes.
+      return;
+    } else if (errno != EINTR) {
+      int err = errno;
+      unsigned tail = *sys_uring.sq_tail;
+      while (sys_uring.unsubmitted > 0) {
+        struct io_uring_sqe* sqe;
+        sys_uring_op_t* op;
+        tail--;
+        sqe = &sys_uring.sqes[sys_uring.sq_array[tail & *sys_uring.sq_mask]];
+        op = (sys_uring_op_t*) (uintptr_t) sqe->user_data;
+        op->result = -err;
+        (*op->pending)--;
+        sys_uring.inflight--;
+        sys_uring.unsubmitted--;
+      }
+      __atomic_store_n(sys_uring.sq_tail, tail, __ATOMIC_RELEASE);
+      return;
+    }
+  }
+}
+
+static
+void sys_uring_wait(void)
+{
+  struct pollfd pfd;
+
+  // Use a timeout: another thread may reap our completions and not
+  // leave anything in the ring to wake us up.
+#ifdef SYS_HAS_TASK_WAIT_FD
+  int rc = chpl_task_waitForFd(sys_uring.fd, CHPL_TASK_FD_READ, 1000);
+  if (rc == 0 || rc == ETIMEDOUT)
+    return;
+#endif
+  pfd.fd = sys_uring.fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  (void) poll(&pfd, 1, 1);
+}
+
+err_t sys_uring_rw(fd_t fd, int writing, sys_uring_op_t* ops, int nops)
+{
+  int pending = 0;
+  int next = 0;
+
+  if (!sys_uring_available()) return ENOSYS;
+
+  STARTING_SLOW_SYSCALL;
+
+  pthread_mutex_lock(&sys_uring.lock);
+  while (next < nops || pending > 0) {
+    // Queue as many of our ops as the rings have room for.  Keeping
+    // inflight within the CQ size means completions can't overflow.
+    unsigned tail = *sys_uring.sq_tail;
+    unsigned head = __atomic_load_n(sys_uring.sq_head, __ATOMIC_ACQUIRE);
+    while (next < nops &&
+           tail - head < sys_uring.sq_entries &&
+           sys_uring.inflight < sys_uring.cq_entries) {
+      unsigned idx = tail & *sys_uring.sq_mask;
+      struct io_uring_sqe* sqe = &sys_uring.sqes[idx];
+      sys_uring_op_t* op = &ops[next];
+
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = writing ? IORING_OP_WRITEV : IORING_OP_READV;
+      sqe->fd = fd;
+      sqe->off = op->offset;
+      sqe->addr = (uintptr_t) &op->iov;
+      sqe->len = 1;
+      sqe->user_data = (uintptr_t) op;
+      sys_uring.sq_array[idx] = idx;
+      op->result = 0;
+      op->pending = &pending;
+
+      tail++;
+      next++;
+      pending++;
+      sys_uring.inflight++;
+      sys_uring.unsubmitted++;
+    }
+    __atomic_store_n(sys_uring.sq_tail, tail, __ATOMIC_RELEASE);
+
+    sys_uring_submit();
+    sys_uring_reap();
+
+    if (next == nops && pending == 0) break;
+
+    pthread_mutex_unlock(&sys_uring.lock);
+    sys_uring_wait();
+    pthread_mutex_lock(&sys_uring.lock);
+  }
+  pthread_mutex_unlock(&sys_uring.lock);
+
+  DONE_SLOW_SYSCALL;
+
+  return 0;
+}
+
+#else
+
+int sys_uring_available(void)
+{
+  return 0;
+}
+
+err_t sys_uring_rw(fd_t fd, int writing, sys_uring_op_t* ops, int nops)
+{
+  return ENOSYS;
+}
+
+#endif
+
 err_t sys_accept(fd_t sockfd, sys_sockaddr_t* addr_out, fd_t* fd_out)
 {
   int got;
@@ -1372,6 +1767,7 @@ err_t sys_accept(fd_t sockfd, sys_sockaddr_t* addr_out, fd_t* fd_out)
 
   STARTING_SLOW_SYSCALL;
 
+  sys_wait_if_blocking(sockfd, CHPL_TASK_FD_READ);
   got = accept(sockfd, (struct sockaddr*) & addr_out->addr, &addr_len);
   if( got != -1 ) {
     if( addr_len > (socklen_t) sizeof(sys_sockaddr_storage_t) ) {
@@ -1634,7 +2030,10 @@ err_t sys_recv(fd_t sockfd, void* buf, size_t len, int flags, ssize_t* num_recvd
   err_t err_out;
 
   STARTING_SLOW_SYSCALL;
-  got = recv(sockfd, buf, len, flags);
+  do {
+    got = recv(sockfd, buf, len, flags | SYS_MSG_DONTWAIT);
+  } while( got == -1 &&
+           sys_wait_and_retry(sockfd, flags, errno, CHPL_TASK_FD_READ) );
   if( got != -1 ) {
     *num_recvd_out = got;
     err_out = 0;
@@ -1653,7 +2052,10 @@ err_t sys_recvfrom(fd_t sockfd, void* buf, size_t len, int flags, sys_sockaddr_t
   err_t err_out;
 
   STARTING_SLOW_SYSCALL;
-  got = recvfrom(sockfd, buf, len, flags, (struct sockaddr*) &src_addr_out->addr, & src_addr_out->len);
+  do {
+    got = recvfrom(sockfd, buf, len, flags | SYS_MSG_DONTWAIT, (struct sockaddr*) &src_addr_out->addr, & src_addr_out->len);
+  } while( got == -1 &&
+           sys_wait_and_retry(sockfd, flags, errno, CHPL_TASK_FD_READ) );
   if( got != -1 ) {
     *num_recvd_out = got;
     err_out = 0;
@@ -1673,7 +2075,10 @@ err_t sys_recvmsg(fd_t sockfd, struct msghdr *msg, int flags, ssize_t* num_recvd
   err_t err_out;
 
   STARTING_SLOW_SYSCALL;
-  got = recvmsg(sockfd, msg, flags);
+  do {
+    got = recvmsg(sockfd, msg, flags | SYS_MSG_DONTWAIT);
+  } while( got == -1 &&
+           sys_wait_and_retry(sockfd, flags, errno, CHPL_TASK_FD_READ) );
 
   if( got != -1 ) {
     *num_recvd_out = got;
@@ -1694,7 +2099,10 @@ err_t sys_send(fd_t sockfd, const void* buf, int64_t len, int flags, ssize_t* nu
   err_t err_out;
 
   STARTING_SLOW_SYSCALL;
-  sent = send(sockfd, buf, len, flags);
+  do {
+    sent = send(sockfd, buf, len, flags | SYS_MSG_DONTWAIT);
+  } while( sent == -1 &&
+           sys_wait_and_retry(sockfd, flags, errno, CHPL_TASK_FD_WRITE) );
   if( sent != -1 ) {
     *num_sent_out = sent;
     err_out = 0;
@@ -1713,7 +2121,10 @@ err_t sys_sendto(fd_t sockfd, const void* buf, int64_t len, int flags, const sys
   err_t err_out;
 
   STARTING_SLOW_SYSCALL;
-  sent = sendto(sockfd, buf, len, flags, (const struct sockaddr*) &dest_addr->addr, dest_addr->len);
+  do {
+    sent = sendto(sockfd, buf, len, flags | SYS_MSG_DONTWAIT, (const struct sockaddr*) &dest_addr->addr, dest_addr->len);
+  } while( sent == -1 &&
+           sys_wait_and_retry(sockfd, flags, errno, CHPL_TASK_FD_WRITE) );
   if( sent != -1 ) {
     *num_sent_out = sent;
     err_out = 0;
@@ -1732,7 +2143,10 @@ err_t sys_sendmsg(fd_t sockfd, const struct msghdr *msg, int flags, ssize_t* num
   err_t err_out;
 
   STARTING_SLOW_SYSCALL;
-  sent = sendmsg(sockfd, msg, flags);
+  do {
+    sent = sendmsg(sockfd, msg, flags | SYS_MSG_DONTWAIT);
+  } while( sent == -1 &&
+           sys_wait_and_retry(sockfd, flags, errno, CHPL_TASK_FD_WRITE) );
   if( sent != -1 ) {
     *num_sent_out = sent;
     err_out = 0;
@@ -1850,6 +2264,376 @@ err_t sys_select(int nfds, fd_set* readfds, fd_set* writefds, fd_set* exceptfds,
   return err_out;
 }
 
+//
+// Readiness multiplexing for many fds at once: epoll on Linux, kqueue
+// on BSD and macOS, and poll() elsewhere.  The poller keeps a table,
+// indexed by fd, of what each fd was registered with, so that every
+// backend can hand back the same sys_poll_event_t.  sys_poller_wait()
+// waits on the epoll/kqueue fd through the tasking layer, so one task
+// can service many sockets without holding on to a worker thread.
+//
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define SYS_POLLER_EPOLL
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+      defined(__OpenBSD__) || defined(__DragonFly__)
+#include <sys/event.h>
+#define SYS_POLLER_KQUEUE
+#endif
+
+#include <poll.h>
+#include <pthread.h>
+
+typedef struct sys_poller_entry_s {
+  int events; // 0 if the fd is not registered
+  void* data;
+} sys_poller_entry_t;
+
+struct sys_poller_s {
+  fd_t fd; // epoll or kqueue fd, or -1 for poll()
+  pthread_mutex_t lock; // protects entries
+  sys_poller_entry_t* entries;
+  int nentries;
+};
+
+#define SYS_POLLER_MAX_EVENTS 256
+
+// An entry for a one-shot fd that has fired and not been re-armed.
+#define SYS_POLL_DISARMED 0x100
+
+err_t sys_poller_create(sys_poller_t** poller_out)
+{
+  sys_poller_t* p;
+
+  *poller_out = NULL;
+
+  p = (sys_poller_t*) qio_calloc(1, sizeof(sys_poller_t));
+  if (p == NULL) return ENOMEM;
+
+  p->fd = -1;
+#if defined(SYS_POLLER_EPOLL)
+  p->fd = epoll_create1(EPOLL_CLOEXEC);
+  if (p->fd == -1) {
+    err_t err = errno;
+    qio_free(p);
+    return err;
+  }
+#elif defined(SYS_POLLER_KQUEUE)
+  p->fd = kqueue();
+  if (p->fd == -1) {
+    err_t err = errno;
+    qio_free(p);
+    return err;
+  }
+  (void) fcntl(p->fd, F_SETFD, FD_CLOEXEC);
+#endif
+
+  pthread_mutex_init(&p->lock, NULL);
+  *poller_out = p;
+  return 0;
+}
+
+err_t sys_poller_destroy(sys_poller_t* p)
+{
+  err_t err = 0;
+
+  if (p == NULL) return 0;
+
+  if (p->fd != -1 && close(p->fd) != 0) err = errno;
+  pthread_mutex_destroy(&p->lock);
+  qio_free(p->entries);
+  qio_free(p);
+  return err;
+}
+
+// Call with p->lock held.
+static
+err_t sys_poller_entry(sys_poller_t* p, fd_t fd, sys_poller_entry_t** entry_out)
+{
+  if (fd < 0) return EBADF;
+
+  if (fd >= p->nentries) {
+    int n = p->nentries ? p->nentries : 64;
+    sys_poller_entry_t* grown;
+
+    while (n <= fd) n *= 2;
+    grown = (sys_poller_entry_t*) qio_realloc(p->entries,
+                                              n * sizeof(sys_poller_entry_t));
+    if (grown == NULL) return ENOMEM;
+    memset(grown + p->nentries, 0,
+           (n - p->nentries) * sizeof(sys_poller_entry_t));
+    p->entries = grown;
+    p->nentries = n;
+  }
+
+  *entry_out = &p->entries[fd];
+  return 0;
+}
+
+// Tells the kernel about fd's new events (0 for none).
+// Call with p->lock held.
+static
+err_t sys_poller_update_kernel(sys_poller_t* p, fd_t fd, int old_events, int events)
+{
+#if defined(SYS_POLLER_EPOLL)
+  struct epoll_event ev;
+  int op;
+
+  memset(&ev, 0, sizeof(ev));
+  ev.data.fd = fd;
+  if (events & SYS_POLL_READ) ev.events |= EPOLLIN;
+  if (events & SYS_POLL_WRITE) ev.events |= EPOLLOUT;
+  if (events & SYS_POLL_ONESHOT) ev.events |= EPOLLONESHOT;
+
+  if (old_events == 0) op = EPOLL_CTL_ADD;
+  else if (events == 0) op = EPOLL_CTL_DEL;
+  else op = EPOLL_CTL_MOD;
+
+  if (epoll_ctl(p->fd, op, fd, &ev) != 0) return errno;
+  return 0;
+#elif defined(SYS_POLLER_KQUEUE)
+  struct kevent kev[2];
+  int n = 0;
+  u_short flags = EV_ADD | EV_ENABLE;
+
+  if (events & SYS_POLL_ONESHOT) flags |= EV_ONESHOT;
+
+  // Add the filters we want; delete the ones we had but no longer do.
+  if (events & SYS_POLL_READ)
+    EV_SET(&kev[n++], fd, EVFILT_READ, flags, 0, 0, NULL);
+  else if (old_events & SYS_POLL_READ)
+    EV_SET(&kev[n++], fd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+  if (events & SYS_POLL_WRITE)
+    EV_SET(&kev[n++], fd, EVFILT_WRITE, flags, 0, 0, NULL);
+  else if (old_events & SYS_POLL_WRITE)
+    EV_SET(&kev[n++], fd, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+
+  // A one-shot filter that already fired is gone, so ignore ENOENT.
+  if (n > 0 && kevent(p->fd, kev, n, NULL, 0, NULL) != 0 && errno != ENOENT)
+    return errno;
+  return 0;
+#else
+  return 0;
+#endif
+}
+
+static
+err_t sys_poller_set(sys_poller_t* p, fd_t fd, int events, void* data, int adding)
+{
+  sys_poller_entry_t* e = NULL;
+  err_t err;
+
+  events &= SYS_POLL_READ | SYS_POLL_WRITE | SYS_POLL_ONESHOT;
+
+  pthread_mutex_lock(&p->lock);
+  err = sys_poller_entry(p, fd, &e);
+  if (err == 0) {
+    if (adding && e->events != 0) err = EEXIST;
+    else if (! adding && e->events == 0) err = ENOENT;
+  }
+  if (err == 0) err = sys_poller_update_kernel(p, fd, e->events, events);
+  if (err == 0) {
+    e->events = events;
+    e->data = (events != 0) ? data : NULL;
+  }
+  pthread_mutex_unlock(&p->lock);
+
+  return err;
+}
+
+err_t sys_poller_add(sys_poller_t* p, fd_t fd, int events, void* data)
+{
+  if ((events & (SYS_POLL_READ | SYS_POLL_WRITE)) == 0) return EINVAL;
+  return sys_poller_set(p, fd, events, data, 1);
+}
+
+err_t sys_poller_modify(sys_poller_t* p, fd_t fd, int events, void* data)
+{
+  if ((events & (SYS_POLL_READ | SYS_POLL_WRITE)) == 0) return EINVAL;
+  return sys_poller_set(p, fd, events, data, 0);
+}
+
+err_t sys_poller_remove(sys_poller_t* p, fd_t fd)
+{
+  return sys_poller_set(p, fd, 0, NULL, 0);
+}
+
+// Fills in events[i] for fd and what happened, and forgets a one-shot
+// registration.  Call with p->lock held.
+static
+void sys_poller_report(sys_poller_t* p, fd_t fd, int happened, sys_poll_event_t* ev)
+{
+  sys_poller_entry_t* e = &p->entries[fd];
+
+  ev->fd = fd;
+  ev->events = happened;
+  ev->data = e->data;
+
+  // The kernel has disabled a fired one-shot fd; keep it registered so
+  // sys_poller_modify can re-arm it.
+  if (e->events & SYS_POLL_ONESHOT)
+    e->events = (e->events & SYS_POLL_ONESHOT) | SYS_POLL_DISARMED;
+}
+
+// Collects ready events, waiting at most timeout_ms (-1: forever).
+static
+err_t sys_poller_collect(sys_poller_t* p, sys_poll_event_t* events, int max, int timeout_ms, int* num_out)
+{
+  int got = 0;
+  int i;
+
+  *num_out = 0;
+  if (max > SYS_POLLER_MAX_EVENTS) max = SYS_POLLER_MAX_EVENTS;
+
+#if defined(SYS_POLLER_EPOLL)
+  {
+    struct epoll_event evs[SYS_POLLER_MAX_EVENTS];
+
+    got = epoll_wait(p->fd, evs, max, timeout_ms);
+    if (got < 0) return errno;
+
+    pthread_mutex_lock(&p->lock);
+    for (i = 0; i < got; i++) {
+      int happened = 0;
+      if (evs[i].events & EPOLLIN) happened |= SYS_POLL_READ;
+      if (evs[i].events & EPOLLOUT) happened |= SYS_POLL_WRITE;
+      if (evs[i].events & (EPOLLERR | EPOLLHUP)) happened |= SYS_POLL_ERROR;
+      sys_poller_report(p, evs[i].data.fd, happened, &events[i]);
+    }
+    pthread_mutex_unlock(&p->lock);
+  }
+#elif defined(SYS_POLLER_KQUEUE)
+  {
+    struct kevent evs[SYS_POLLER_MAX_EVENTS];
+    struct timespec ts;
+
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    got = kevent(p->fd, NULL, 0, evs, max, timeout_ms < 0 ? NULL : &ts);
+    if (got < 0) return errno;
+
+    pthread_mutex_lock(&p->lock);
+    for (i = 0; i < got; i++) {
+      int happened = 0;
+      if (evs[i].filter == EVFILT_READ) happened |= SYS_POLL_READ;
+      if (evs[i].filter == EVFILT_WRITE) happened |= SYS_POLL_WRITE;
+      if (evs[i].flags & (EV_EOF | EV_ERROR)) happened |= SYS_POLL_ERROR;
+      sys_poller_report(p, (fd_t) evs[i].ident, happened, &events[i]);
+    }
+    pthread_mutex_unlock(&p->lock);
+  }
+#else
+  {
+    struct pollfd* pfds;
+    int npfds = 0;
+
+    pthread_mutex_lock(&p->lock);
+    pfds = (struct pollfd*) qio_malloc((p->nentries + 1) * sizeof(struct pollfd));
+    if (pfds == NULL) {
+      pthread_mutex_unlock(&p->lock);
+      return ENOMEM;
+    }
+    for (i = 0; i < p->nentries; i++) {
+      int ev = p->entries[i].events;
+      if ((ev & (SYS_POLL_READ | SYS_POLL_WRITE)) == 0) continue;
+      pfds[npfds].fd = i;
+      pfds[npfds].events = ((ev & SYS_POLL_READ) ? POLLIN : 0) |
+                           ((ev & SYS_POLL_WRITE) ? POLLOUT : 0);
+      pfds[npfds].revents = 0;
+      npfds++;
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    got = poll(pfds, npfds, timeout_ms);
+    if (got < 0) {
+      err_t err = errno;
+      qio_free(pfds);
+      return err;
+    }
+
+    got = 0;
+    pthread_mutex_lock(&p->lock);
+    for (i = 0; i < npfds && got < max; i++) {
+      int happened = 0;
+      short re = pfds[i].revents;
+      if (re == 0) continue;
+      // Skip fds removed or disarmed while we were waiting.
+      if ((p->entries[pfds[i].fd].events &
+           (SYS_POLL_READ | SYS_POLL_WRITE)) == 0) continue;
+      if (re & POLLIN) happened |= SYS_POLL_READ;
+      if (re & POLLOUT) happened |= SYS_POLL_WRITE;
+      if (re & (POLLERR | POLLHUP | POLLNVAL)) happened |= SYS_POLL_ERROR;
+      sys_poller_report(p, pfds[i].fd, happened, &events[got]);
+      got++;
+    }
+    pthread_mutex_unlock(&p->lock);
+    qio_free(pfds);
+  }
+#endif
+
+  *num_out = got;
+  return 0;
+}
+
+err_t sys_poller_wait(sys_poller_t* p, sys_poll_event_t* events, int max, int64_t timeout_usec, int* num_out)
+{
+  struct timeval deadline;
+  struct timeval now;
+  int64_t left = timeout_usec;
+  err_t err;
+
+  *num_out = 0;
+  if (max <= 0) return EINVAL;
+
+  if (timeout_usec > 0) {
+    gettimeofday(&deadline, NULL);
+    deadline.tv_sec += timeout_usec / 1000000;
+    deadline.tv_usec += timeout_usec % 1000000;
+    if (deadline.tv_usec >= 1000000) {
+      deadline.tv_sec++;
+      deadline.tv_usec -= 1000000;
+    }
+  }
+
+  while (1) {
+    // Take whatever is ready already.
+    err = sys_poller_collect(p, events, max, 0, num_out);
+    if (err == EINTR) continue;
+    if (err || *num_out > 0 || timeout_usec == 0) return err;
+
+    if (timeout_usec > 0) {
+      gettimeofday(&now, NULL);
+      left = (int64_t) (deadline.tv_sec - now.tv_sec) * 1000000 +
+             (deadline.tv_usec - now.tv_usec);
+      if (left <= 0) return 0;
+    }
+
+#ifdef SYS_HAS_TASK_WAIT_FD
+    if (p->fd != -1) {
+      // The epoll/kqueue fd polls readable when it has events, so the
+      // tasking layer can run other tasks until then.
+      int rc = chpl_task_waitForFd(p->fd, CHPL_TASK_FD_READ, left);
+      if (rc == ETIMEDOUT) return 0;
+      if (rc != 0) return rc;
+    } else {
+      chpl_task_yield();
+    }
+#else
+    {
+      int timeout_ms = -1;
+      if (left >= 0) timeout_ms = (int) ((left + 999) / 1000);
+      if (left > (int64_t) INT_MAX * 1000) timeout_ms = INT_MAX;
+
+      STARTING_SLOW_SYSCALL;
+      err = sys_poller_collect(p, events, max, timeout_ms, num_out);
+      DONE_SLOW_SYSCALL;
+      if (err == EINTR) continue;
+      return err;
+    }
+#endif
+  }
+}
+
 err_t sys_unlink(const char* path)
 {
   int got;
@@ -27,6 +27,7 @@
 #include "chplcgfns.h"
 #include "chpl-arg-bundle.h"
 #include "chpl-comm.h"
+#include "chpl-env.h"
 #include "chplexit.h"
 #include "chpl-locale-model.h"
 #include "chpl-mem.h"
@@ -47,6 +48,13 @@
 #include <unistd.h>
 #include <math.h>
 
+#ifdef CHPL_TASKS_FIFO_FUTEX_SYNC
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
 
 //
 // task pool: linked list of tasks
@@ -63,9 +71,12 @@ typedef struct task_pool_struct {
   task_pool_p      list_prev;
   task_pool_p      next;         // double-link pointers for pool
   task_pool_p      prev;
+  task_pool_p*     ws_list_head; // task list we belong to, if on a deque
 
   chpl_task_prvDataImpl_t chpl_data;
 
+  chpl_bool        small;        // bundle has PTASK_SMALL_BUNDLE_SIZE bytes
+
   chpl_task_bundle_t* taskBundle; // addr of task bundle in bundle below
   chpl_any_arg_bundle_t bundle[0];
 } task_pool_t;
@@ -80,10 +91,51 @@ typedef struct lockReport {
 } lockReport_t;
 
 
+//
+// Optional work stealing (CHPL_RT_TASKS_FIFO_WORK_STEALING).  Each
+// worker thread gets a fixed-size Chase-Lev deque.  Tasks a worker
+// creates go on the bottom of its own deque, and it takes work from
+// there first.  Idle threads steal from the tops of randomly chosen
+// deques.  Tasks created by threads without a deque (the main thread,
+// the comm thread, AM handlers) and any that don't fit still go
+// through the global pool.  Tasks on a deque aren't linked onto their
+// coforall/cobegin task list.  Instead the parent runs its own
+// children from the bottom of its deque in executeTasksInList.
+//
+#define WS_DEQUE_SIZE 4096              // must be a power of 2
+#define WS_MAX_DEQUES 1024
+
+typedef struct {
+  int64_t     top;                      // stealers take from here
+  int64_t     bottom;                   // owner pushes and pops here
+  task_pool_p buf[WS_DEQUE_SIZE];
+} ws_deque_t;
+
+static chpl_bool   ws_enabled = false;
+static ws_deque_t* ws_deques[WS_MAX_DEQUES];
+static int         ws_num_deques = 0;
+
+
+//
+// Task descriptors with room for arg bundles of up to
+// PTASK_SMALL_BUNDLE_SIZE bytes, which covers the usual begin, cobegin
+// and coforall bundle, are all allocated at that size.  When a thread
+// finishes running one it keeps it, up to PTASK_CACHE_MAX of them, for
+// the next task it creates.  Coforall and cobegin tasks are mostly
+// created and run by the same few threads, so this saves a malloc and
+// free per task.
+//
+#define PTASK_SMALL_BUNDLE_SIZE 256
+#define PTASK_CACHE_MAX 64
+
 // This is the data that is private to each thread.
 typedef struct {
   task_pool_p   ptask;
   lockReport_t* lockRprt;
+  ws_deque_t*   deque;                  // our deque, if work stealing
+  uint32_t      ws_seed;                // for picking steal victims
+  task_pool_p   ptask_cache;            // small descriptors, for reuse
+  int           ptask_cache_cnt;
 } thread_private_data_t;
 
 
@@ -98,7 +150,7 @@ static volatile task_pool_p
 static volatile task_pool_p
                            task_pool_tail;     // tail of task pool
 
-static int                 queued_task_cnt;    // number of tasks in task pool
+static int                 queued_task_cnt;    // number of tasks in pool and deques
 static int64_t             extra_task_cnt;     // number of tasks being run by
                                                //   threads occupied already
 static int                 blocked_thread_cnt; // number of threads that
@@ -145,6 +197,182 @@ static task_pool_p             add_to_task_pool(chpl_fn_int_t, chpl_fn_p,
                                                 void*, size_t,
                                                 chpl_bool, task_pool_p*,
                                                 chpl_bool, int, int32_t);
+static void                    free_ptask(thread_private_data_t*,
+                                          task_pool_p);
+static task_pool_p             new_ptask(chpl_fn_int_t, chpl_fn_p,
+                                         void*, size_t, chpl_bool,
+                                         int, int32_t);
+static chpl_bool               ws_add_task(chpl_fn_int_t, chpl_fn_p,
+                                           void*, size_t, chpl_bool,
+                                           task_pool_p*, int, int32_t);
+static void                    run_child_task(task_pool_p, task_pool_p);
+static void                    run_pool_task(thread_private_data_t*,
+                                             task_pool_p);
+
+#ifdef CHPL_TASKS_FIFO_FUTEX_SYNC
+
+// Sync variables
+
+//
+// How many times to poll before parking, when we aren't oversubscribed.
+//
+#define SYNC_SPIN_ITERS 1000
+
+static inline int futex_wait(uint32_t* addr, uint32_t val,
+                             const struct timespec* timeout) {
+  return syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, timeout, NULL, 0);
+}
+
+static inline void futex_wake(uint32_t* addr, int n) {
+  (void) syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+static inline chpl_bool sync_oversubscribed(void) {
+  return (chpl_thread_getNumThreads() >= chpl_topo_getNumCPUsLogical(true));
+}
+
+//
+// This is the three-state futex mutex from Drepper's "Futexes Are
+// Tricky", with a short spin up front.
+//
+static inline void sync_futex_lock(uint32_t* l) {
+  uint32_t c;
+  int i;
+
+  for (i = 0; i < SYNC_SPIN_ITERS; i++) {
+    c = __atomic_load_n(l, __ATOMIC_RELAXED);
+    if (c == 2)
+      break;
+    if (c == 0
+        && __atomic_compare_exchange_n(l, &c, 1, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return;
+  }
+
+  while ((c = __atomic_exchange_n(l, 2, __ATOMIC_ACQUIRE)) != 0)
+    (void) futex_wait(l, 2, NULL);
+}
+
+static inline void sync_futex_unlock(uint32_t* l) {
+  if (__atomic_exchange_n(l, 0, __ATOMIC_RELEASE) == 2)
+    futex_wake(l, 1);
+}
+
+static void sync_wait_and_lock(chpl_sync_aux_t *s,
+                               chpl_bool want_full,
+                               int32_t lineno, int32_t filename) {
+  uint32_t* seq = want_full ? &s->full_seq : &s->empty_seq;
+  uint32_t* waiters = want_full ? &s->full_waiters : &s->empty_waiters;
+  int spins;
+
+  sync_futex_lock(&s->lock);
+
+  if (s->is_full == want_full) {
+    if (blockreport)
+      progress_cnt++;
+    return;
+  }
+
+  // If we're oversubscribing the hardware, park right away; spinning
+  // would only keep the thread we're waiting for off the processor.
+  spins = sync_oversubscribed() ? 0 : SYNC_SPIN_ITERS;
+
+  while (s->is_full != want_full) {
+    // Read this under the lock, so any change after we release it
+    // will show up as a different sequence number.
+    uint32_t seq0 = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+    int i;
+
+    sync_futex_unlock(&s->lock);
+
+    for (i = 0;
+         i < spins && __atomic_load_n(seq, __ATOMIC_ACQUIRE) == seq0;
+         i++)
+      ;
+
+    if (__atomic_load_n(seq, __ATOMIC_ACQUIRE) == seq0) {
+      __atomic_add_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+      if (set_block_loc(lineno, filename)) {
+        // all other tasks appear to be blocked
+        struct timespec timeout = { 1, 0 };
+        if (futex_wait(seq, seq0, &timeout) != 0
+            && errno == ETIMEDOUT
+            && __atomic_load_n(seq, __ATOMIC_ACQUIRE) == seq0)
+          check_for_deadlock();
+      } else {
+        (void) futex_wait(seq, seq0, NULL);
+      }
+      unset_block_loc();
+      __atomic_sub_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+    }
+
+    sync_futex_lock(&s->lock);
+  }
+
+  if (blockreport)
+    progress_cnt++;
+}
+
+//
+// Called with the lock held; the waiter count check pairs with the
+// waiters' increment-then-recheck in sync_wait_and_lock(), so either
+// we see them or they see the new sequence number.
+//
+static inline void sync_mark_and_signal(chpl_sync_aux_t *s, chpl_bool full) {
+  uint32_t* seq = full ? &s->full_seq : &s->empty_seq;
+  uint32_t* waiters = full ? &s->full_waiters : &s->empty_waiters;
+
+  s->is_full = full;
+  __atomic_add_fetch(seq, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(waiters, __ATOMIC_SEQ_CST) > 0)
+    futex_wake(seq, INT_MAX);
+  sync_futex_unlock(&s->lock);
+}
+
+void chpl_sync_lock(chpl_sync_aux_t *s) {
+  sync_futex_lock(&s->lock);
+}
+
+void chpl_sync_unlock(chpl_sync_aux_t *s) {
+  sync_futex_unlock(&s->lock);
+}
+
+void chpl_sync_waitFullAndLock(chpl_sync_aux_t *s,
+                                  int32_t lineno, int32_t filename) {
+  sync_wait_and_lock(s, true, lineno, filename);
+}
+
+void chpl_sync_waitEmptyAndLock(chpl_sync_aux_t *s,
+                                   int32_t lineno, int32_t filename) {
+  sync_wait_and_lock(s, false, lineno, filename);
+}
+
+void chpl_sync_markAndSignalFull(chpl_sync_aux_t *s) {
+  sync_mark_and_signal(s, true);
+}
+
+void chpl_sync_markAndSignalEmpty(chpl_sync_aux_t *s) {
+  sync_mark_and_signal(s, false);
+}
+
+chpl_bool chpl_sync_isFull(void *val_ptr,
+                            chpl_sync_aux_t *s) {
+  return s->is_full;
+}
+
+void chpl_sync_initAux(chpl_sync_aux_t *s) {
+  s->is_full = false;
+  s->lock = 0;
+  s->full_seq = 0;
+  s->empty_seq = 0;
+  s->full_waiters = 0;
+  s->empty_waiters = 0;
+}
+
+void chpl_sync_destroyAux(chpl_sync_aux_t *s) {
+}
+
+#else // CHPL_TASKS_FIFO_FUTEX_SYNC
 
 //
 // Condition variable methods
@@ -306,6 +534,8 @@ void chpl_sync_destroyAux(chpl_sync_aux_t *s) {
   chpl_thread_mutexDestroy(&s->lock);
 }
 
+#endif // CHPL_TASKS_FIFO_FUTEX_SYNC
+
 static void setup_main_thread_private_data(void)
 {
   thread_private_data_t* tp;
@@ -339,6 +569,7 @@ static void setup_main_thread_private_data(void)
 // Tasks
 
 void chpl_task_init(void) {
+  chpl_task_localsInit();
   chpl_thread_mutexInit(&threading_lock);
   chpl_thread_mutexInit(&extra_task_lock);
   chpl_thread_mutexInit(&task_id_lock);
@@ -349,6 +580,8 @@ void chpl_task_init(void) {
   extra_task_cnt = 0;
   task_pool_head = task_pool_tail = NULL;
 
+  ws_enabled = chpl_env_rt_get_bool("TASKS_FIFO_WORK_STEALING", false);
+
   chpl_thread_init(thread_begin, thread_end);
 
   //
@@ -538,7 +771,9 @@ static void comm_task_wrapper(void* arg) {
 //
 static inline
 void enqueue_task(task_pool_p ptask, task_pool_p* p_task_list_head) {
-  queued_task_cnt++;
+  // This is atomic because with work stealing, tasks on deques are
+  // counted without holding threading_lock.
+  (void) __atomic_add_fetch(&queued_task_cnt, 1, __ATOMIC_SEQ_CST);
 
   //
   // Add to pool.
@@ -570,7 +805,7 @@ void enqueue_task(task_pool_p ptask, task_pool_p* p_task_list_head) {
 static inline
 void dequeue_task(task_pool_p ptask) {
   assert(queued_task_cnt > 0);
-  queued_task_cnt--;
+  (void) __atomic_sub_fetch(&queued_task_cnt, 1, __ATOMIC_SEQ_CST);
 
   //
   // Remove from pool.
@@ -602,6 +837,172 @@ void dequeue_task(task_pool_p ptask) {
 }
 
 
+//
+// Chase-Lev deque operations, following Le et al., "Correct and
+// Efficient Work-Stealing for Weak Memory Models" (PPoPP '13), but
+// with a fixed-size buffer.  Only the owner pushes and pops.
+//
+static inline
+chpl_bool ws_push(ws_deque_t* q, task_pool_p ptask) {
+  int64_t b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED);
+  int64_t t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+
+  if (b - t >= WS_DEQUE_SIZE)
+    return false;
+  __atomic_store_n(&q->buf[b & (WS_DEQUE_SIZE - 1)], ptask, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+  return true;
+}
+
+
+static inline
+task_pool_p ws_pop(ws_deque_t* q) {
+  int64_t b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED) - 1;
+  int64_t t;
+  task_pool_p ptask = NULL;
+
+  __atomic_store_n(&q->bottom, b, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  t = __atomic_load_n(&q->top, __ATOMIC_RELAXED);
+  if (t <= b) {
+    ptask = __atomic_load_n(&q->buf[b & (WS_DEQUE_SIZE - 1)],
+                            __ATOMIC_RELAXED);
+    if (t == b) {
+      // last one; race the stealers for it
+      if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        ptask = NULL;
+      __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+  } else {
+    __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+  }
+  return ptask;
+}
+
+
+static inline
+task_pool_p ws_steal(ws_deque_t* q) {
+  int64_t t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+  int64_t b;
+  task_pool_p ptask;
+
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  b = __atomic_load_n(&q->bottom, __ATOMIC_ACQUIRE);
+  if (t >= b)
+    return NULL;
+  ptask = __atomic_load_n(&q->buf[t & (WS_DEQUE_SIZE - 1)], __ATOMIC_RELAXED);
+  if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, false,
+                                   __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+    return NULL;
+  return ptask;
+}
+
+
+static void ws_register_thread(thread_private_data_t* tp) {
+  int i;
+
+  tp->deque = NULL;
+  tp->ws_seed = (uint32_t) (intptr_t) tp;
+
+  if (!ws_enabled)
+    return;
+
+  if ((i = __atomic_fetch_add(&ws_num_deques, 1, __ATOMIC_SEQ_CST))
+      >= WS_MAX_DEQUES)
+    return;   // too many threads; this one just uses the global pool
+
+  tp->deque = (ws_deque_t*) chpl_mem_calloc(1, sizeof(ws_deque_t),
+                                            CHPL_RT_MD_THREAD_PRV_DATA,
+                                            0, 0);
+  __atomic_store_n(&ws_deques[i], tp->deque, __ATOMIC_RELEASE);
+}
+
+
+//
+// Find a task for an idle worker: our own deque first, then the
+// global pool, then a few randomly chosen victims.
+//
+static task_pool_p ws_find_task(thread_private_data_t* tp) {
+  task_pool_p ptask = NULL;
+  int n, i;
+
+  if (tp->deque != NULL && (ptask = ws_pop(tp->deque)) != NULL) {
+    (void) __atomic_sub_fetch(&queued_task_cnt, 1, __ATOMIC_SEQ_CST);
+    return ptask;
+  }
+
+  if (task_pool_head) {
+    chpl_thread_mutexLock(&threading_lock);
+    if ((ptask = task_pool_head) != NULL)
+      dequeue_task(ptask);
+    chpl_thread_mutexUnlock(&threading_lock);
+    if (ptask != NULL)
+      return ptask;
+  }
+
+  n = __atomic_load_n(&ws_num_deques, __ATOMIC_ACQUIRE);
+  if (n > WS_MAX_DEQUES)
+    n = WS_MAX_DEQUES;
+  for (i = 0; i < n; i++) {
+    ws_deque_t* victim;
+
+    tp->ws_seed = tp->ws_seed * 1103515245 + 12345;
+    victim = __atomic_load_n(&ws_deques[(tp->ws_seed >> 8) % n],
+                             __ATOMIC_ACQUIRE);
+    if (victim != NULL && victim != tp->deque
+        && (ptask = ws_steal(victim)) != NULL) {
+      (void) __atomic_sub_fetch(&queued_task_cnt, 1, __ATOMIC_SEQ_CST);
+      return ptask;
+    }
+  }
+
+  return NULL;
+}
+
+
+//
+// If work stealing is on and we're a worker with a deque, create the
+// task and push it on our deque.  Returns false if the caller should
+// use the global pool instead.
+//
+static chpl_bool ws_add_task(chpl_fn_int_t fid, chpl_fn_p fp,
+                             void* a, size_t a_size,
+                             chpl_bool is_executeOn,
+                             task_pool_p* p_task_list_head,
+                             int lineno, int32_t filename) {
+  thread_private_data_t* tp;
+  task_pool_p ptask;
+
+  if (!ws_enabled
+      || (tp = chpl_thread_getPrivateData()) == NULL
+      || tp->deque == NULL)
+    return false;
+
+  ptask = new_ptask(fid, fp, a, a_size, is_executeOn, lineno, filename);
+  ptask->ws_list_head = p_task_list_head;
+
+  (void) __atomic_add_fetch(&queued_task_cnt, 1, __ATOMIC_SEQ_CST);
+  if (!ws_push(tp->deque, ptask)) {
+    (void) __atomic_sub_fetch(&queued_task_cnt, 1, __ATOMIC_SEQ_CST);
+    ptask->ws_list_head = NULL;
+    chpl_thread_mutexLock(&threading_lock);
+    enqueue_task(ptask, p_task_list_head);
+    chpl_thread_mutexUnlock(&threading_lock);
+  }
+
+  if (__atomic_load_n(&queued_task_cnt, __ATOMIC_RELAXED)
+      > __atomic_load_n(&idle_thread_cnt, __ATOMIC_RELAXED)) {
+    chpl_thread_mutexLock(&threading_lock);
+    maybe_add_thread();
+    chpl_thread_mutexUnlock(&threading_lock);
+  }
+
+  return true;
+}
+
+
 void chpl_task_addToTaskList(chpl_fn_int_t fid,
                              chpl_task_bundle_t* arg, size_t arg_size,
                              c_sublocid_t subloc,
@@ -614,6 +1015,13 @@ void chpl_task_addToTaskList(chpl_fn_int_t fid,
 
   arg->kind = CHPL_ARG_BUNDLE_KIND_TASK;
 
+  if (ws_add_task(fid, chpl_ftable[fid], arg, arg_size, false,
+                  (task_list_locale == chpl_nodeID)
+                  ? (task_pool_p*) p_task_list_void
+                  : NULL,
+                  lineno, filename))
+    return;
+
   // begin critical section
   chpl_thread_mutexLock(&threading_lock);
 
@@ -643,12 +1051,30 @@ void chpl_task_executeTasksInList(void** p_task_list_void) {
   task_pool_p* p_task_list_head = (task_pool_p*) p_task_list_void;
   task_pool_p curr_ptask;
   task_pool_p child_ptask;
+  thread_private_data_t* tp;
 
   // Note: this function needs to tolerate an empty task
   // list. That will happen for coforalls inside a serial block, say.
 
   curr_ptask = get_current_ptask(true /*must_be_task*/);
 
+  //
+  // With work stealing our own children that nobody has stolen yet are
+  // at the bottom of our deque.  Run them until we come to something
+  // that isn't one of them, and put that back.
+  //
+  tp = get_thread_private_data();
+  if (tp->deque != NULL) {
+    while ((child_ptask = ws_pop(tp->deque)) != NULL) {
+      if (child_ptask->ws_list_head != p_task_list_head) {
+        (void) ws_push(tp->deque, child_ptask);
+        break;
+      }
+      (void) __atomic_sub_fetch(&queued_task_cnt, 1, __ATOMIC_SEQ_CST);
+      run_child_task(curr_ptask, child_ptask);
+    }
+  }
+
   while (*p_task_list_head != NULL) {
     chpl_fn_p task_to_run_fun = NULL;
 
@@ -666,61 +1092,69 @@ void chpl_task_executeTasksInList(void** p_task_list_void) {
     if (task_to_run_fun == NULL)
       continue;
 
-    set_current_ptask(child_ptask);
+    run_child_task(curr_ptask, child_ptask);
+  }
+}
+
 
-    // begin critical section
-    chpl_thread_mutexLock(&extra_task_lock);
+//
+// Run a child task on the current thread, on behalf of its parent.
+//
+static void run_child_task(task_pool_p curr_ptask, task_pool_p child_ptask) {
+  set_current_ptask(child_ptask);
 
-    extra_task_cnt++;
+  // begin critical section
+  chpl_thread_mutexLock(&extra_task_lock);
 
-    // end critical section
-    chpl_thread_mutexUnlock(&extra_task_lock);
+  extra_task_cnt++;
 
-    if (do_taskReport) {
-      chpl_thread_mutexLock(&taskTable_lock);
-      chpldev_taskTable_set_suspended(curr_ptask->taskBundle->id);
-      chpldev_taskTable_set_active(child_ptask->taskBundle->id);
-      chpl_thread_mutexUnlock(&taskTable_lock);
-    }
+  // end critical section
+  chpl_thread_mutexUnlock(&extra_task_lock);
 
-    if (blockreport)
-      initializeLockReportForThread();
-
-    chpl_task_do_callbacks(chpl_task_cb_event_kind_begin,
-                           child_ptask->taskBundle->requested_fid,
-                           child_ptask->taskBundle->filename,
-                           child_ptask->taskBundle->lineno,
-                           child_ptask->taskBundle->id,
-                           child_ptask->taskBundle->is_executeOn);
-
-    (*task_to_run_fun)(&child_ptask->bundle);
-
-    chpl_task_do_callbacks(chpl_task_cb_event_kind_end,
-                           child_ptask->taskBundle->requested_fid,
-                           child_ptask->taskBundle->filename,
-                           child_ptask->taskBundle->lineno,
-                           child_ptask->taskBundle->id,
-                           child_ptask->taskBundle->is_executeOn);
-
-    if (do_taskReport) {
-      chpl_thread_mutexLock(&taskTable_lock);
-      chpldev_taskTable_set_active(curr_ptask->taskBundle->id);
-      chpldev_taskTable_remove(child_ptask->taskBundle->id);
-      chpl_thread_mutexUnlock(&taskTable_lock);
-    }
+  if (do_taskReport) {
+    chpl_thread_mutexLock(&taskTable_lock);
+    chpldev_taskTable_set_suspended(curr_ptask->taskBundle->id);
+    chpldev_taskTable_set_active(child_ptask->taskBundle->id);
+    chpl_thread_mutexUnlock(&taskTable_lock);
+  }
 
-    // begin critical section
-    chpl_thread_mutexLock(&extra_task_lock);
+  if (blockreport)
+    initializeLockReportForThread();
 
-    extra_task_cnt--;
+  chpl_task_do_callbacks(chpl_task_cb_event_kind_begin,
+                         child_ptask->taskBundle->requested_fid,
+                         child_ptask->taskBundle->filename,
+                         child_ptask->taskBundle->lineno,
+                         child_ptask->taskBundle->id,
+                         child_ptask->taskBundle->is_executeOn);
 
-    // end critical section
-    chpl_thread_mutexUnlock(&extra_task_lock);
+  (child_ptask->taskBundle->requested_fn)(&child_ptask->bundle);
 
-    set_current_ptask(curr_ptask);
-    chpl_mem_free(child_ptask, 0, 0);
+  chpl_task_do_callbacks(chpl_task_cb_event_kind_end,
+                         child_ptask->taskBundle->requested_fid,
+                         child_ptask->taskBundle->filename,
+                         child_ptask->taskBundle->lineno,
+                         child_ptask->taskBundle->id,
+                         child_ptask->taskBundle->is_executeOn);
 
+  if (do_taskReport) {
+    chpl_thread_mutexLock(&taskTable_lock);
+    chpldev_taskTable_set_active(curr_ptask->taskBundle->id);
+    chpldev_taskTable_remove(child_ptask->taskBundle->id);
+    chpl_thread_mutexUnlock(&taskTable_lock);
   }
+
+  // begin critical section
+  chpl_thread_mutexLock(&extra_task_lock);
+
+  extra_task_cnt--;
+
+  // end critical section
+  chpl_thread_mutexUnlock(&extra_task_lock);
+
+  chpl_task_arenaRelease(&child_ptask->chpl_data.infoRuntime);
+  set_current_ptask(curr_ptask);
+  chpl_mem_free(child_ptask, 0, 0);
 }
 
 
@@ -737,6 +1171,9 @@ void taskCallBody(chpl_fn_int_t fid, chpl_fn_p fp,
                   void* arg, size_t arg_size,
                   c_sublocid_t subloc,
                   int lineno, int32_t filename) {
+  if (ws_add_task(fid, fp, arg, arg_size, true, NULL, lineno, filename))
+    return;
+
   // begin critical section
   chpl_thread_mutexLock(&threading_lock);
 
@@ -827,6 +1264,10 @@ void chpl_task_sleep(double secs) {
                && now.tv_usec < deadline.tv_usec));
 }
 
+int chpl_task_waitForFd(int fd, int events, int64_t timeout_usec) {
+  return chpl_task_waitForFdYielding(fd, events, timeout_usec);
+}
+
 uint32_t chpl_task_getMaxPar(void) {
   uint32_t max;
   uint32_t maxThreads;
@@ -1151,10 +1592,52 @@ thread_begin(void* ptask_void) {
 
   tp->ptask = NULL;
   tp->lockRprt = NULL;
+  tp->ptask_cache = NULL;
+  tp->ptask_cache_cnt = 0;
+  ws_register_thread(tp);
   if (blockreport)
     initializeLockReportForThread();
 
   while (true) {
+    if (ws_enabled) {
+      //
+      // With work stealing, queued_task_cnt covers both the global pool
+      // and the deques, so that's what we wait on.
+      //
+      while ((ptask = ws_find_task(tp)) == NULL) {
+        if (set_block_loc(0, CHPL_FILE_IDX_IDLE_TASK)) {
+          struct timeval deadline, now;
+          gettimeofday(&deadline, NULL);
+          deadline.tv_sec += 1;
+          do {
+            chpl_thread_yield();
+            gettimeofday(&now, NULL);
+          } while (__atomic_load_n(&queued_task_cnt, __ATOMIC_ACQUIRE) == 0
+                   && (now.tv_sec < deadline.tv_sec
+                       || (now.tv_sec == deadline.tv_sec
+                           && now.tv_usec < deadline.tv_usec)));
+          if (__atomic_load_n(&queued_task_cnt, __ATOMIC_ACQUIRE) == 0) {
+            check_for_deadlock();
+          }
+        }
+        else {
+          do {
+            chpl_thread_yield();
+          } while (__atomic_load_n(&queued_task_cnt, __ATOMIC_ACQUIRE) == 0);
+        }
+
+        unset_block_loc();
+      }
+
+      if (blockreport)
+        progress_cnt++;
+
+      (void) __atomic_sub_fetch(&idle_thread_cnt, 1, __ATOMIC_SEQ_CST);
+      run_pool_task(tp, ptask);
+      (void) __atomic_add_fetch(&idle_thread_cnt, 1, __ATOMIC_SEQ_CST);
+      continue;
+    }
+
     //
     // wait for a task to be present in the task pool
     //
@@ -1219,45 +1702,14 @@ thread_begin(void* ptask_void) {
     // for task-reports on deadlock or Ctrl+C).
     //
     ptask = task_pool_head;
-    idle_thread_cnt--;
+    (void) __atomic_sub_fetch(&idle_thread_cnt, 1, __ATOMIC_SEQ_CST);
 
     dequeue_task(ptask);
 
     // end critical section
     chpl_thread_mutexUnlock(&threading_lock);
 
-    tp->ptask = ptask;
-
-    if (do_taskReport) {
-      chpl_thread_mutexLock(&taskTable_lock);
-      chpldev_taskTable_set_active(ptask->taskBundle->id);
-      chpl_thread_mutexUnlock(&taskTable_lock);
-    }
-
-    chpl_task_do_callbacks(chpl_task_cb_event_kind_begin,
-                           ptask->taskBundle->requested_fid,
-                           ptask->taskBundle->filename,
-                           ptask->taskBundle->lineno,
-                           ptask->taskBundle->id,
-                           ptask->taskBundle->is_executeOn);
-
-    (ptask->taskBundle->requested_fn)(&ptask->bundle);
-
-    chpl_task_do_callbacks(chpl_task_cb_event_kind_end,
-                           ptask->taskBundle->requested_fid,
-                           ptask->taskBundle->filename,
-                           ptask->taskBundle->lineno,
-                           ptask->taskBundle->id,
-                           ptask->taskBundle->is_executeOn);
-
-    if (do_taskReport) {
-      chpl_thread_mutexLock(&taskTable_lock);
-      chpldev_taskTable_remove(ptask->taskBundle->id);
-      chpl_thread_mutexUnlock(&taskTable_lock);
-    }
-
-    tp->ptask = NULL;
-    chpl_mem_free(ptask, 0, 0);
+    run_pool_task(tp, ptask);
 
     // begin critical section
     chpl_thread_mutexLock(&threading_lock);
@@ -1265,7 +1717,7 @@ thread_begin(void* ptask_void) {
     //
     // finished task; increment idle count
     //
-    idle_thread_cnt++;
+    (void) __atomic_add_fetch(&idle_thread_cnt, 1, __ATOMIC_SEQ_CST);
 
     // end critical section
     chpl_thread_mutexUnlock(&threading_lock);
@@ -1273,6 +1725,46 @@ thread_begin(void* ptask_void) {
 }
 
 
+//
+// Run a task taken from the pool (or a deque) on a worker thread.
+//
+static void run_pool_task(thread_private_data_t* tp, task_pool_p ptask) {
+  tp->ptask = ptask;
+
+  if (do_taskReport) {
+    chpl_thread_mutexLock(&taskTable_lock);
+    chpldev_taskTable_set_active(ptask->taskBundle->id);
+    chpl_thread_mutexUnlock(&taskTable_lock);
+  }
+
+  chpl_task_do_callbacks(chpl_task_cb_event_kind_begin,
+                         ptask->taskBundle->requested_fid,
+                         ptask->taskBundle->filename,
+                         ptask->taskBundle->lineno,
+                         ptask->taskBundle->id,
+                         ptask->taskBundle->is_executeOn);
+
+  (ptask->taskBundle->requested_fn)(&ptask->bundle);
+
+  chpl_task_do_callbacks(chpl_task_cb_event_kind_end,
+                         ptask->taskBundle->requested_fid,
+                         ptask->taskBundle->filename,
+                         ptask->taskBundle->lineno,
+                         ptask->taskBundle->id,
+                         ptask->taskBundle->is_executeOn);
+
+  if (do_taskReport) {
+    chpl_thread_mutexLock(&taskTable_lock);
+    chpldev_taskTable_remove(ptask->taskBundle->id);
+    chpl_thread_mutexUnlock(&taskTable_lock);
+  }
+
+  chpl_task_arenaRelease(&ptask->chpl_data.infoRuntime);
+  tp->ptask = NULL;
+  free_ptask(tp, ptask);
+}
+
+
 //
 // When a thread is destroyed it calls this ending function.
 //
@@ -1286,6 +1778,11 @@ static void thread_end(void)
       chpl_mem_free(tp->lockRprt, 0, 0);
       tp->lockRprt = NULL;
     }
+    while (tp->ptask_cache != NULL) {
+      task_pool_p ptask = tp->ptask_cache;
+      tp->ptask_cache = ptask->next;
+      chpl_mem_free(ptask, 0, 0);
+    }
     chpl_mem_free(tp, 0, 0);
     chpl_thread_setPrivateData(NULL);
   }
@@ -1300,7 +1797,7 @@ static void maybe_add_thread(void) {
 
   if (!warning_issued && chpl_thread_canCreate()) {
     if (chpl_thread_create(NULL) == 0) {
-      idle_thread_cnt++;
+      (void) __atomic_add_fetch(&idle_thread_cnt, 1, __ATOMIC_SEQ_CST);
     }
     else {
       int32_t max_threads = chpl_thread_getMaxThreads();
@@ -1333,8 +1830,29 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
                              task_pool_p* p_task_list_head,
                              chpl_bool is_begin_stmt,
                              int lineno, int32_t filename) {
+  task_pool_p ptask;
+
+  ptask = new_ptask(fid, fp, a, a_size, is_executeOn, lineno, filename);
 
+  enqueue_task(ptask, p_task_list_head);
 
+  // If we now have more tasks than threads to run them on, try to start
+  // another thread
+  if (queued_task_cnt > idle_thread_cnt) {
+    maybe_add_thread();
+  }
+
+  return ptask;
+}
+
+
+// create a task from the given function pointer and arguments,
+// announce it to the callbacks and the task table, but don't queue it
+static
+task_pool_p new_ptask(chpl_fn_int_t fid, chpl_fn_p fp,
+                      void* a, size_t a_size,
+                      chpl_bool is_executeOn,
+                      int lineno, int32_t filename) {
   task_pool_p ptask;
   chpl_task_prvDataImpl_t pv;
 
@@ -1345,9 +1863,26 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
   // could be either a comm or a task one.
   //
   assert(a_size >= chpl_argBundleSizeofHdr(a));
-  ptask = (task_pool_p) chpl_mem_alloc(offsetof(task_pool_t, bundle) + a_size,
-                                       CHPL_RT_MD_TASK_ARG_AND_POOL_DESC,
-                                       lineno, filename);
+  if (a_size <= PTASK_SMALL_BUNDLE_SIZE) {
+    thread_private_data_t* tp = chpl_thread_getPrivateData();
+    if (tp != NULL && tp->ptask_cache != NULL) {
+      ptask = tp->ptask_cache;
+      tp->ptask_cache = ptask->next;
+      tp->ptask_cache_cnt--;
+    } else {
+      ptask = (task_pool_p) chpl_mem_alloc(offsetof(task_pool_t, bundle)
+                                           + PTASK_SMALL_BUNDLE_SIZE,
+                                           CHPL_RT_MD_TASK_ARG_AND_POOL_DESC,
+                                           lineno, filename);
+    }
+    ptask->small = true;
+  } else {
+    ptask = (task_pool_p) chpl_mem_alloc(offsetof(task_pool_t, bundle)
+                                         + a_size,
+                                         CHPL_RT_MD_TASK_ARG_AND_POOL_DESC,
+                                         lineno, filename);
+    ptask->small = false;
+  }
 
   memcpy(&ptask->bundle, a, a_size);
   ptask->taskBundle = chpl_argBundleTaskArgBundle(&ptask->bundle);
@@ -1357,6 +1892,7 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
   ptask->list_prev              = NULL;
   ptask->next                   = NULL;
   ptask->prev                   = NULL;
+  ptask->ws_list_head           = NULL;
   ptask->chpl_data              = pv;
 
   *ptask->taskBundle =
@@ -1371,8 +1907,6 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
       .infoChapel      = ptask->taskBundle->infoChapel,// retain; set by caller
     };
 
-  enqueue_task(ptask, p_task_list_head);
-
   chpl_task_do_callbacks(chpl_task_cb_event_kind_create,
                          ptask->taskBundle->requested_fid,
                          ptask->taskBundle->filename,
@@ -1389,16 +1923,24 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
     chpl_thread_mutexUnlock(&taskTable_lock);
   }
 
-  // If we now have more tasks than threads to run them on, try to start
-  // another thread
-  if (queued_task_cnt > idle_thread_cnt) {
-    maybe_add_thread();
-  }
-
   return ptask;
 }
 
 
+// Done with a task descriptor: keep it for reuse if it is a small one
+// and there is room in this thread's cache, otherwise free it.
+static
+void free_ptask(thread_private_data_t* tp, task_pool_p ptask) {
+  if (ptask->small && tp != NULL && tp->ptask_cache_cnt < PTASK_CACHE_MAX) {
+    ptask->next = tp->ptask_cache;
+    tp->ptask_cache = ptask;
+    tp->ptask_cache_cnt++;
+  } else {
+    chpl_mem_free(ptask, 0, 0);
+  }
+}
+
+
 // Threads
 
 uint32_t chpl_task_getNumThreads(void) {
@@ -1408,3 +1950,8 @@ uint32_t chpl_task_getNumThreads(void) {
 uint32_t chpl_task_getNumIdleThreads(void) {
   return idle_thread_cnt;
 }
+
+void chpl_task_getIdleTimes(double* spinSecs, double* parkSecs) {
+  *spinSecs = 0.0;
+  *parkSecs = 0.0;
+}
@@ -48,6 +48,7 @@
 #include "chpl-tasks-callbacks-internal.h"
 #include "chpl-tasks-impl.h"
 #include "chpl-topo.h"
+#include "chpltimers.h"
 #include "chpltypes.h"
 
 #include "qthread.h"
@@ -63,8 +64,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #include <math.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 
 #define ALIGN_DN(i, size)  ((i) & ~((size) - 1))
 #define ALIGN_UP(i, size)  ALIGN_DN((i) + (size) - 1, size)
@@ -149,6 +155,8 @@ static pthread_t initer;
 pthread_t chpl_qthread_process_pthread;
 pthread_t chpl_qthread_comm_pthread;
 
+int chpl_qthread_sheps_per_subloc = 1;
+
 chpl_task_bundle_t chpl_qthread_process_bundle = {
                                    .kind = CHPL_ARG_BUNDLE_KIND_TASK,
                                    .is_executeOn = false,
@@ -181,6 +189,107 @@ chpl_qthread_tls_t chpl_qthread_comm_task_tls = {
 
 static aligned_t exit_ret = 0;
 
+//
+// Optional per-task-function profiling, enabled by setting
+// CHPL_RT_QTHREADS_TASK_PROFILE.  Each worker accumulates into its own
+// row of the table, so no atomics are needed; the rows are summed and
+// reported at exit.  A task counts as stolen if it started on some
+// shepherd other than the one it was placed on.
+//
+typedef struct {
+    uint64_t count;
+    uint64_t run_ns;            // start to finish, including blocked time
+    uint64_t sync_ns;           // blocked on sync vars
+    uint64_t wait_ns;           // spawned to started
+    uint64_t steals;
+} task_prof_t;
+
+// Prepended to the task arg when profiling.
+typedef struct {
+    uint64_t              create_ns;
+    qthread_shepherd_id_t shep;
+} task_prof_hdr_t;
+
+static chpl_bool    taskProf = false;
+static int          taskProfNumFids;
+static int          taskProfNumRows;
+static task_prof_t* taskProfTab;
+
+static inline uint64_t task_prof_nsecs(void)
+{
+    return chpl_now_monotonic_ns();
+}
+
+static void task_prof_init(void)
+{
+    if (!(taskProf = chpl_env_rt_get_bool("QTHREADS_TASK_PROFILE", false)))
+        return;
+
+    for (taskProfNumFids = 0;
+         chpl_finfo[taskProfNumFids].name != NULL;
+         taskProfNumFids++)
+        ;
+
+    // Worker unique IDs start at 1; row 0 catches anything unexpected.
+    taskProfNumRows = qthread_num_workers() + 1;
+    taskProfTab = chpl_mem_allocManyZero(taskProfNumRows * taskProfNumFids,
+                                         sizeof(taskProfTab[0]),
+                                         CHPL_RT_MD_TASK_LAYER_UNSPEC, 0, 0);
+}
+
+static int task_prof_cmp(const void* a, const void* b)
+{
+    const task_prof_t* pa = &taskProfTab[*(const int*) a];
+    const task_prof_t* pb = &taskProfTab[*(const int*) b];
+    return (pa->run_ns < pb->run_ns) ? 1 : (pa->run_ns > pb->run_ns) ? -1 : 0;
+}
+
+static void task_prof_print(void)
+{
+    int* order;
+    int numUsed;
+    int fid, row;
+
+    if (!taskProf)
+        return;
+
+    // Sum all the rows into row 0.
+    for (row = 1; row < taskProfNumRows; row++) {
+        for (fid = 0; fid < taskProfNumFids; fid++) {
+            task_prof_t* dst = &taskProfTab[fid];
+            task_prof_t* src = &taskProfTab[row * taskProfNumFids + fid];
+            dst->count   += src->count;
+            dst->run_ns  += src->run_ns;
+            dst->sync_ns += src->sync_ns;
+            dst->wait_ns += src->wait_ns;
+            dst->steals  += src->steals;
+        }
+    }
+
+    order = chpl_mem_allocMany(taskProfNumFids, sizeof(order[0]),
+                               CHPL_RT_MD_TASK_LAYER_UNSPEC, 0, 0);
+    for (numUsed = fid = 0; fid < taskProfNumFids; fid++) {
+        if (taskProfTab[fid].count > 0)
+            order[numUsed++] = fid;
+    }
+    qsort(order, numUsed, sizeof(order[0]), task_prof_cmp);
+
+    for (row = 0; row < numUsed; row++) {
+        const task_prof_t* p = &taskProfTab[order[row]];
+        const chpl_fn_info* fi = &chpl_finfo[order[row]];
+        fprintf(stderr,
+                "%d: task profile: %s (%s:%d): count %" PRIu64
+                ", run %.6f s, sync blocked %.6f s, queue wait %.6f s"
+                ", steals %" PRIu64 "\n",
+                (int) chpl_nodeID, fi->name,
+                chpl_lookupFilename(fi->fileno), fi->lineno,
+                p->count, p->run_ns / 1e9, p->sync_ns / 1e9,
+                p->wait_ns / 1e9, p->steals);
+    }
+
+    chpl_mem_free(order, 0, 0);
+}
+
 static chpl_bool guardPagesInUse = true;
 
 void chpl_task_yield(void)
@@ -217,7 +326,15 @@ void chpl_sync_waitFullAndLock(chpl_sync_aux_t *s,
     chpl_sync_lock(s);
     while (s->is_full == 0) {
         chpl_sync_unlock(s);
-        qthread_readFE(NULL, &(s->signal_full));
+        if (taskProf) {
+            chpl_qthread_tls_t* tls = chpl_qthread_get_tasklocal();
+            uint64_t t0 = task_prof_nsecs();
+            qthread_readFE(NULL, &(s->signal_full));
+            if (tls != NULL)
+                tls->prof_sync_ns += task_prof_nsecs() - t0;
+        } else {
+            qthread_readFE(NULL, &(s->signal_full));
+        }
         chpl_sync_lock(s);
     }
 }
@@ -231,7 +348,15 @@ void chpl_sync_waitEmptyAndLock(chpl_sync_aux_t *s,
     chpl_sync_lock(s);
     while (s->is_full != 0) {
         chpl_sync_unlock(s);
-        qthread_readFE(NULL, &(s->signal_empty));
+        if (taskProf) {
+            chpl_qthread_tls_t* tls = chpl_qthread_get_tasklocal();
+            uint64_t t0 = task_prof_nsecs();
+            qthread_readFE(NULL, &(s->signal_empty));
+            if (tls != NULL)
+                tls->prof_sync_ns += task_prof_nsecs() - t0;
+        } else {
+            qthread_readFE(NULL, &(s->signal_empty));
+        }
         chpl_sync_lock(s);
     }
 }
@@ -491,6 +616,9 @@ static void setupAvailableParallelism(int32_t maxThreads) {
         hwpar = qtEnvThreads;
     }
     // User did not set chapel or qthreads vars -- our default
+    // (Neither this nor the limit above counts CPUs reserved for the
+    // comm layer with CHPL_RT_RESERVE_COMM_CORES, so workers never
+    // land on those.)
     else {
         hwpar = chpl_topo_getNumCPUsPhysical(true);
     }
@@ -522,6 +650,53 @@ static void setupAvailableParallelism(int32_t maxThreads) {
             }
         }
 
+        //
+        // In NUMA shepherd mode, give each NUMA domain (sublocale) its
+        // own shepherd or, with a one-worker-per-shepherd scheduler, its
+        // own range of shepherds, so tasks fired on a sublocale run on
+        // that domain's cores.  Since cross-shepherd work stealing is
+        // off by default (see setupWorkStealing()), the workers serving
+        // a domain only ever pick up that domain's tasks.  This is the
+        // default with the numa locale model, where on-stmts targeting
+        // a sublocale are expected to run on its cores.
+        //
+        if (chpl_env_rt_get_bool("QTHREADS_NUMA_SHEPHERDS",
+                                 strcmp(CHPL_LOCALE_MODEL, "numa") == 0)
+            && strcmp(CHPL_LOCALE_MODEL, "flat") != 0) {
+            int numNumaDomains = chpl_topo_getNumNumaDomains();
+            if (numNumaDomains > 1 && hwpar >= numNumaDomains) {
+                int workersPerDomain = hwpar / numNumaDomains;
+                char newenv_sheps[QT_ENV_S] = { 0 };
+
+                if (verbosity > 0 && hwpar % numNumaDomains != 0) {
+                    printf("QTHREADS: Reduced numThreadsPerLocale=%d to %d "
+                           "to use the same number in each NUMA domain.\n",
+                           hwpar, workersPerDomain * numNumaDomains);
+                }
+                hwpar = workersPerDomain * numNumaDomains;
+
+                chpl_qt_unsetenv("HWPAR");
+                if (CHPL_QTHREAD_SCHEDULER_ONE_WORKER_PER_SHEPHERD) {
+                    chpl_qthread_sheps_per_subloc = workersPerDomain;
+                    snprintf(newenv_sheps, sizeof(newenv_sheps), "%i",
+                             (int) hwpar);
+                    snprintf(newenv_workers, sizeof(newenv_workers), "%i", 1);
+                } else {
+                    snprintf(newenv_sheps, sizeof(newenv_sheps), "%i",
+                             numNumaDomains);
+                    snprintf(newenv_workers, sizeof(newenv_workers), "%i",
+                             workersPerDomain);
+                    chpl_qt_setenv("SHEPHERD_BOUNDARY", "node", 1);
+                }
+                chpl_qt_setenv("WORKER_UNIT",
+                               (hwpar > chpl_topo_getNumCPUsPhysical(true))
+                               ? "pu" : "core", 0);
+                chpl_qt_setenv("NUM_SHEPHERDS", newenv_sheps, 1);
+                chpl_qt_setenv("NUM_WORKERS_PER_SHEPHERD", newenv_workers, 1);
+                return;
+            }
+        }
+
         // If there is more parallelism requested than the number of cores, set the
         // worker unit to pu, otherwise core.
         if (hwpar > chpl_topo_getNumCPUsPhysical(true)) {
@@ -646,6 +821,22 @@ static void setupCallStacks(void) {
     }
     snprintf(newenv_alloc, sizeof(newenv_alloc), "%zu", maxPoolAllocSize);
     chpl_qt_setenv("MAX_POOL_ALLOC_SIZE", newenv_alloc, 0);
+
+    // With guard pages, each worker caches some freed stacks with their
+    // guard pages still set up, so task churn doesn't turn into mprotect()
+    // calls.  Optionally the memory of cached stacks can be given back to
+    // the OS and lazily recommitted, which keeps the footprint down when
+    // there are lots of workers and big stacks.
+    if (guardPagesEnabled) {
+        char newenv_cache[QT_ENV_S];
+        size_t cacheSize = chpl_env_rt_get_size("QTHREADS_STACK_CACHE_SIZE",
+                                                16);
+        snprintf(newenv_cache, sizeof(newenv_cache), "%zu", cacheSize);
+        chpl_qt_setenv("STACK_CACHE_SIZE", newenv_cache, 0);
+        if (chpl_env_rt_get_bool("QTHREADS_LAZY_STACKS", false)) {
+            chpl_qt_setenv("LAZY_STACKS", "true", 0);
+        }
+    }
 }
 
 static void setupTasklocalStorage(void) {
@@ -662,12 +853,21 @@ static void setupTasklocalStorage(void) {
 }
 
 static void setupWorkStealing(void) {
-    // In our experience the current work stealing implementation hurts
-    // performance, so disable it. Note that we don't override, so a user could
-    // try working stealing out by setting {QT,QTHREAD}_STEAL_RATIO. Also note
-    // that not all schedulers support work stealing, but it doesn't hurt to
-    // set this env var for those configs anyways.
-    chpl_qt_setenv("STEAL_RATIO", "0", 0);
+    // The distrib scheduler steals half of a queue at a time, from the
+    // nearest shepherds first, and only once a worker has been idle for
+    // QT_STEAL_IDLE tries, so it evens out irregular work without
+    // getting in the way of regular loops.  We leave that on, except
+    // with the numa locale model, where tasks run on a sublocale are
+    // expected to stay on its cores.  Other schedulers' stealing has
+    // hurt performance in our experience, so we turn it off for them.
+    // Note that we don't override, so a user can always set
+    // {QT,QTHREAD}_STEAL_RATIO.  Also note that not all schedulers
+    // support work stealing, but it doesn't hurt to set this env var
+    // for those configs anyways.
+    if (!CHPL_QTHREAD_SCHEDULER_STEAL_BY_DEFAULT
+        || strcmp(CHPL_LOCALE_MODEL, "numa") == 0) {
+        chpl_qt_setenv("STEAL_RATIO", "0", 0);
+    }
 }
 
 static void setupSpinWaiting(void) {
@@ -677,6 +877,12 @@ static void setupSpinWaiting(void) {
   } else if (strncmp(crayPlatform, CHPL_TARGET_PLATFORM, strlen(crayPlatform)) == 0) {
     chpl_qt_setenv("SPINCOUNT", "3000000", 0);
   }
+
+  // Let each idle worker tune how long it spins before parking from
+  // how soon work has been showing up for it.  The spin counts above
+  // (and the schedulers' own defaults) become upper bounds.  A fixed
+  // count can still be had by setting {QT,QTHREAD}_SPIN_ADAPTIVE=no.
+  chpl_qt_setenv("SPIN_ADAPTIVE", "yes", 0);
 }
 
 static void setupAffinity(void) {
@@ -689,6 +895,8 @@ void chpl_task_init(void)
 {
     int32_t   commMaxThreads;
 
+    chpl_task_localsInit();
+
     chpl_qthread_process_pthread = pthread_self();
     chpl_qthread_process_bundle.id = qthread_incr(&next_task_id, 1);
 
@@ -717,6 +925,8 @@ void chpl_task_init(void)
     // the number of threads qthreads creates beforehand
     assert(0 == commMaxThreads || qthread_num_workers() < commMaxThreads);
 
+    task_prof_init();
+
     if (blockreport || taskreport) {
         if (signal(SIGINT, SIGINT_handler) == SIG_ERR) {
             perror("Could not register SIGINT handler");
@@ -730,6 +940,8 @@ void chpl_task_exit(void)
     profile_print();
 #endif /* CHAPEL_PROFILE */
 
+    task_prof_print();
+
     if (qthread_shep() == NO_SHEPHERD) {
         /* sometimes, tasking is told to shutdown even though it hasn't been
          * told to start yet */
@@ -771,9 +983,78 @@ static aligned_t chapel_wrapper(void *arg)
 
     wrap_callbacks(chpl_task_cb_event_kind_end, bundle);
 
+    chpl_task_arenaRelease(&tls->infoRuntime);
+
+    return 0;
+}
+
+static aligned_t chapel_wrapper_prof(void *arg)
+{
+    task_prof_hdr_t       *hdr = arg;
+    chpl_task_bundle_t *bundle = chpl_argBundleTaskArgBundle(hdr + 1);
+    chpl_fn_int_t          fid = bundle->requested_fid;
+    chpl_qthread_tls_t    *tls = chpl_qthread_get_tasklocal();
+    qthread_shepherd_id_t start_shep = qthread_shep();
+    uint64_t             start = task_prof_nsecs();
+    qthread_worker_id_t worker;
+    task_prof_t*             p;
+
+    chapel_wrapper(hdr + 1);
+
+    if (fid < 0 || fid >= taskProfNumFids)
+        return 0;
+
+    worker = qthread_worker_unique(NULL);
+    if (worker == NO_WORKER || worker >= taskProfNumRows)
+        worker = 0;
+    p = &taskProfTab[worker * taskProfNumFids + fid];
+    p->count++;
+    p->run_ns += task_prof_nsecs() - start;
+    p->sync_ns += tls->prof_sync_ns;
+    p->wait_ns += start - hdr->create_ns;
+    if (hdr->shep != NO_SHEPHERD && hdr->shep != start_shep)
+        p->steals++;
+
     return 0;
 }
 
+//
+// Start a task on the given shepherd, or anywhere if NO_SHEPHERD.
+//
+static void fork_task(void *arg, size_t arg_size, qthread_shepherd_id_t shep)
+{
+    uint64_t buf[64];
+    task_prof_hdr_t* hdr;
+    size_t size;
+
+    if (!taskProf) {
+        if (shep == NO_SHEPHERD) {
+            qthread_fork_copyargs(chapel_wrapper, arg, arg_size, NULL);
+        } else {
+            qthread_fork_copyargs_to(chapel_wrapper, arg, arg_size, NULL,
+                                     shep);
+        }
+        return;
+    }
+
+    size = sizeof(*hdr) + arg_size;
+    hdr = (size <= sizeof(buf))
+          ? (task_prof_hdr_t*) buf
+          : chpl_mem_alloc(size, CHPL_RT_MD_TASK_ARG, 0, 0);
+    hdr->create_ns = task_prof_nsecs();
+    hdr->shep = (shep == NO_SHEPHERD) ? qthread_shep() : shep;
+    memcpy(hdr + 1, arg, arg_size);
+
+    if (shep == NO_SHEPHERD) {
+        qthread_fork_copyargs(chapel_wrapper_prof, hdr, size, NULL);
+    } else {
+        qthread_fork_copyargs_to(chapel_wrapper_prof, hdr, size, NULL, shep);
+    }
+
+    if ((void*) hdr != (void*) buf)
+        chpl_mem_free(hdr, 0, 0);
+}
+
 typedef struct {
     chpl_fn_p fn;
     void *arg;
@@ -863,12 +1144,10 @@ void chpl_task_addToTaskList(chpl_fn_int_t       fid,
 
     wrap_callbacks(chpl_task_cb_event_kind_create, arg);
 
-    if (execution_subloc == c_sublocid_any) {
-        qthread_fork_copyargs(chapel_wrapper, arg, arg_size, NULL);
-    } else {
-        qthread_fork_copyargs_to(chapel_wrapper, arg, arg_size, NULL,
-                                 (qthread_shepherd_id_t) execution_subloc);
-    }
+    fork_task(arg, arg_size,
+              (execution_subloc == c_sublocid_any)
+              ? NO_SHEPHERD
+              : chpl_qthread_sublocToShep(execution_subloc));
 }
 
 void chpl_task_executeTasksInList(void **task_list)
@@ -899,12 +1178,10 @@ static inline void taskCallBody(chpl_fn_int_t fid, chpl_fn_p fp,
 
     wrap_callbacks(chpl_task_cb_event_kind_create, bundle);
 
-    if (execution_subloc < 0) {
-        qthread_fork_copyargs(chapel_wrapper, arg, arg_size, NULL);
-    } else {
-        qthread_fork_copyargs_to(chapel_wrapper, arg, arg_size, NULL,
-                                 (qthread_shepherd_id_t) execution_subloc);
-    }
+    fork_task(arg, arg_size,
+              (execution_subloc < 0)
+              ? NO_SHEPHERD
+              : chpl_qthread_sublocToShep(execution_subloc));
 }
 
 void chpl_task_taskCallFTable(chpl_fn_int_t fid,
@@ -1016,6 +1293,106 @@ void chpl_task_sleep(double secs)
     }
 }
 
+//
+// Waiting for fd readiness.  On Linux a single poller pthread owns an
+// epoll set.  A task that needs to wait registers its fd there (one-
+// shot), then blocks on an FEB word, which lets its worker go run other
+// tasks.  When the fd becomes ready the poller fills the word and the
+// task is rescheduled.  Timed waits, waits from outside qthreads, and
+// fds that are already being waited on by some other task fall back to
+// polling and yielding.
+//
+#ifdef __linux__
+typedef struct {
+    aligned_t feb;
+    int       fd;
+} fd_waiter_t;
+
+static int            fdPollEpfd = -1;
+static pthread_once_t fdPollOnce = PTHREAD_ONCE_INIT;
+
+static void *fd_poller(void *arg)
+{
+    struct epoll_event evs[64];
+
+    while (1) {
+        int n = epoll_wait(fdPollEpfd, evs, sizeof(evs) / sizeof(evs[0]), -1);
+        int i;
+
+        for (i = 0; i < n; i++) {
+            fd_waiter_t *w = (fd_waiter_t *)evs[i].data.ptr;
+
+            // One-shot has disarmed it; take it out so the fd can be
+            // waited on again, then wake the waiter.
+            (void) epoll_ctl(fdPollEpfd, EPOLL_CTL_DEL, w->fd, NULL);
+            qthread_fill(&w->feb);
+        }
+    }
+
+    return NULL;
+}
+
+static void fd_poller_start(void)
+{
+    pthread_t poller;
+
+    if ((fdPollEpfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        return;
+    }
+    if (pthread_create(&poller, NULL, fd_poller, NULL) != 0) {
+        close(fdPollEpfd);
+        fdPollEpfd = -1;
+        return;
+    }
+    (void) pthread_detach(poller);
+}
+#endif
+
+int chpl_task_waitForFd(int fd, int events, int64_t timeout_usec)
+{
+#ifdef __linux__
+    struct epoll_event ev;
+    struct pollfd      pfd;
+    fd_waiter_t        w;
+
+    if (timeout_usec >= 0 || qthread_shep() == NO_SHEPHERD) {
+        return chpl_task_waitForFdYielding(fd, events, timeout_usec);
+    }
+
+    // Most of the time the fd is ready already.
+    pfd.fd = fd;
+    pfd.events = (((events & CHPL_TASK_FD_READ) != 0) ? POLLIN : 0)
+                 | (((events & CHPL_TASK_FD_WRITE) != 0) ? POLLOUT : 0);
+    if (poll(&pfd, 1, 0) != 0) {
+        return 0;
+    }
+
+    (void) pthread_once(&fdPollOnce, fd_poller_start);
+    if (fdPollEpfd < 0) {
+        return chpl_task_waitForFdYielding(fd, events, timeout_usec);
+    }
+
+    qthread_empty(&w.feb);
+    w.fd = fd;
+    ev.events = EPOLLONESHOT
+                | (((events & CHPL_TASK_FD_READ) != 0) ? EPOLLIN : 0)
+                | (((events & CHPL_TASK_FD_WRITE) != 0) ? EPOLLOUT : 0);
+    ev.data.ptr = &w;
+    if (epoll_ctl(fdPollEpfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        // EEXIST: someone else is waiting on this fd already.
+        if (errno == EEXIST) {
+            return chpl_task_waitForFdYielding(fd, events, timeout_usec);
+        }
+        return errno;
+    }
+
+    qthread_readFF(NULL, &w.feb);
+    return 0;
+#else
+    return chpl_task_waitForFdYielding(fd, events, timeout_usec);
+#endif
+}
+
 uint32_t chpl_task_getMaxPar(void) {
     //
     // We assume here that the caller (in the LocaleModel module code)
@@ -1069,4 +1446,9 @@ uint32_t chpl_task_getNumIdleThreads(void)
     return 0;
 }
 
+void chpl_task_getIdleTimes(double* spinSecs, double* parkSecs)
+{
+    qthread_idle_stats(spinSecs, parkSecs, NULL);
+}
+
 /* vim:set expandtab: */
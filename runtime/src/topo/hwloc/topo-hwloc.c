@@ -64,12 +64,20 @@ static int topoDepth;
 static int numaLevel;
 static int numNumaDomains;
 
+//
+// CPUs reserved for comm layer progress threads, and the unrestricted
+// topology we need to bind those threads to them.  NULL if none.
+//
+static hwloc_cpuset_t reservedCPUs;
+static hwloc_topology_t fullTopology;
+
 
 static hwloc_obj_t getNumaObj(c_sublocid_t);
 static void alignAddrSize(void*, size_t, chpl_bool,
                           size_t*, unsigned char**, size_t*);
 static void chpl_topo_setMemLocalityByPages(unsigned char*, size_t,
                                             hwloc_obj_t);
+static void reserveCPUs(void);
 
 
 //
@@ -127,6 +135,13 @@ void chpl_topo_init(void) {
   //
   CHK_ERR_ERRNO(hwloc_topology_load(topology) == 0);
 
+  //
+  // Set aside CPUs for the comm layer, if requested.  This has to be
+  // done before anyone else (in particular the tasking layer) sees the
+  // topology.
+  //
+  reserveCPUs();
+
   //
   // What is supported?
   //
@@ -198,10 +213,128 @@ void chpl_topo_exit(void) {
     return;
   }
 
+  if (reservedCPUs != NULL) {
+    hwloc_topology_destroy(fullTopology);
+    hwloc_bitmap_free(reservedCPUs);
+  }
+
   hwloc_topology_destroy(topology);
 }
 
 
+//
+// With CHPL_RT_RESERVE_COMM_CORES set, take a CPU on each socket away
+// from the tasking layer and keep it for the comm layer's AM handler
+// or polling thread, so that thread never competes with the workers:
+//
+//   none  reserve nothing (the default)
+//   core  reserve the last core of each socket that has more than one
+//   smt   reserve the last PU of the last core of each socket, if that
+//         core has more than one PU, leaving the core's other PUs for
+//         tasks
+//
+// The reserved PUs are removed from the topology everyone else, Qthreads
+// included, uses.  We keep a copy of the original so that comm threads
+// can still be bound to them.
+//
+static
+void reserveCPUs(void) {
+  const char* ev = chpl_env_rt_get("RESERVE_COMM_CORES", "none");
+  chpl_bool wholeCore;
+
+  if (strcmp(ev, "none") == 0) {
+    return;
+  } else if (strcmp(ev, "core") == 0) {
+    wholeCore = true;
+  } else if (strcmp(ev, "smt") == 0) {
+    wholeCore = false;
+  } else {
+    chpl_warning("CHPL_RT_RESERVE_COMM_CORES must be \"none\", \"core\", "
+                 "or \"smt\"; not reserving any", 0, 0);
+    return;
+  }
+
+  const hwloc_const_cpuset_t allowed =
+    hwloc_topology_get_allowed_cpuset(topology);
+  hwloc_cpuset_t reserve;
+  CHK_ERR_ERRNO((reserve = hwloc_bitmap_alloc()) != NULL);
+
+  const int numPkgs = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_PACKAGE);
+  for (int i = 0; i < numPkgs; i++) {
+    hwloc_obj_t pkg;
+    CHK_ERR((pkg = hwloc_get_obj_by_type(topology, HWLOC_OBJ_PACKAGE, i))
+            != NULL);
+    const int numCores =
+      hwloc_get_nbobjs_inside_cpuset_by_type(topology, pkg->cpuset,
+                                             HWLOC_OBJ_CORE);
+    if (numCores < 2) {
+      continue;
+    }
+
+    hwloc_obj_t core;
+    CHK_ERR((core = hwloc_get_obj_inside_cpuset_by_type(topology,
+                                                        pkg->cpuset,
+                                                        HWLOC_OBJ_CORE,
+                                                        numCores - 1))
+            != NULL);
+    if (wholeCore) {
+      if (hwloc_bitmap_isincluded(core->cpuset, allowed)) {
+        hwloc_bitmap_or(reserve, reserve, core->cpuset);
+      }
+    } else {
+      const int numPUs =
+        hwloc_get_nbobjs_inside_cpuset_by_type(topology, core->cpuset,
+                                               HWLOC_OBJ_PU);
+      if (numPUs < 2) {
+        continue;
+      }
+
+      hwloc_obj_t pu;
+      CHK_ERR((pu = hwloc_get_obj_inside_cpuset_by_type(topology,
+                                                        core->cpuset,
+                                                        HWLOC_OBJ_PU,
+                                                        numPUs - 1))
+              != NULL);
+      if (hwloc_bitmap_isincluded(pu->cpuset, allowed)) {
+        hwloc_bitmap_or(reserve, reserve, pu->cpuset);
+      }
+    }
+  }
+
+  if (hwloc_bitmap_iszero(reserve)) {
+    hwloc_bitmap_free(reserve);
+    chpl_warning("CHPL_RT_RESERVE_COMM_CORES: no CPUs could be reserved",
+                 0, 0);
+    return;
+  }
+
+  hwloc_cpuset_t keep;
+  CHK_ERR_ERRNO((keep = hwloc_bitmap_alloc()) != NULL);
+  hwloc_bitmap_andnot(keep, hwloc_topology_get_topology_cpuset(topology),
+                      reserve);
+
+  CHK_ERR_ERRNO(hwloc_topology_dup(&fullTopology, topology) == 0);
+  CHK_ERR_ERRNO(hwloc_topology_restrict(topology, keep, 0) == 0);
+  hwloc_bitmap_free(keep);
+
+  reservedCPUs = reserve;
+}
+
+
+chpl_bool chpl_topo_bindToReservedCPUs(void) {
+  if (!haveTopology
+      || reservedCPUs == NULL
+      || !topoSupport->cpubind->set_thread_cpubind) {
+    return false;
+  }
+
+  CHK_ERR_ERRNO(hwloc_set_cpubind(fullTopology, reservedCPUs,
+                                  HWLOC_CPUBIND_THREAD)
+                == 0);
+  return true;
+}
+
+
 void* chpl_topo_getHwlocTopology(void) {
   return (haveTopology) ? topology : NULL;
 }
@@ -262,6 +395,9 @@ void getNumCPUs(void) {
   }
   hwloc_bitmap_and(logAccSet, logAccSet,
                    hwloc_topology_get_online_cpuset(topology));
+  if (reservedCPUs != NULL) {
+    hwloc_bitmap_andnot(logAccSet, logAccSet, reservedCPUs);
+  }
 
   hwloc_cpuset_t physAccSet;
   CHK_ERR_ERRNO((physAccSet = hwloc_bitmap_alloc()) != NULL);
@@ -313,6 +449,67 @@ int chpl_topo_getNumNumaDomains(void) {
 }
 
 
+static inline
+chpl_bool isDataCache(hwloc_obj_t obj) {
+#if HWLOC_API_VERSION >= 0x00020000
+  return hwloc_obj_type_is_dcache(obj->type);
+#else
+  return (obj->type == HWLOC_OBJ_CACHE
+          && obj->attr->cache.type != HWLOC_OBJ_CACHE_INSTRUCTION);
+#endif
+}
+
+
+//
+// Find the data cache at the given level above the first accessible PU.
+//
+static
+hwloc_obj_t getCacheObj(int level) {
+  hwloc_obj_t obj;
+
+  if (!haveTopology) {
+    return NULL;
+  }
+
+  obj = hwloc_get_next_obj_inside_cpuset_by_type(
+          topology, hwloc_topology_get_allowed_cpuset(topology),
+          HWLOC_OBJ_PU, NULL);
+  for ( ; obj != NULL; obj = obj->parent) {
+    if (isDataCache(obj) && (int) obj->attr->cache.depth == level) {
+      return obj;
+    }
+  }
+  return NULL;
+}
+
+
+int chpl_topo_getNumCacheLevels(void) {
+  int level = 0;
+  while (getCacheObj(level + 1) != NULL) {
+    level++;
+  }
+  return level;
+}
+
+
+uint64_t chpl_topo_getCacheSize(int level) {
+  hwloc_obj_t obj = getCacheObj(level);
+  return (obj == NULL) ? 0 : (uint64_t) obj->attr->cache.size;
+}
+
+
+int chpl_topo_getCacheLineSize(int level) {
+  hwloc_obj_t obj = getCacheObj(level);
+  return (obj == NULL) ? 0 : (int) obj->attr->cache.linesize;
+}
+
+
+int chpl_topo_getCacheNumSharingCPUs(int level) {
+  hwloc_obj_t obj = getCacheObj(level);
+  return (obj == NULL) ? 0 : hwloc_bitmap_weight(obj->cpuset);
+}
+
+
 void chpl_topo_setThreadLocality(c_sublocid_t subloc) {
   hwloc_cpuset_t cpuset;
   int flags;
@@ -369,6 +566,39 @@ c_sublocid_t chpl_topo_getThreadLocality(void) {
 }
 
 
+c_sublocid_t chpl_topo_getThreadBoundLocality(void) {
+  hwloc_cpuset_t cpuset;
+  hwloc_nodeset_t nodeset;
+  int flags;
+  c_sublocid_t subloc;
+
+  if (!haveTopology) {
+    return c_sublocid_any;
+  }
+
+  if (!topoSupport->cpubind->get_thread_cpubind) {
+    return c_sublocid_any;
+  }
+
+  CHK_ERR_ERRNO((cpuset = hwloc_bitmap_alloc()) != NULL);
+  CHK_ERR_ERRNO((nodeset = hwloc_bitmap_alloc()) != NULL);
+
+  flags = HWLOC_CPUBIND_THREAD;
+  CHK_ERR_ERRNO(hwloc_get_cpubind(topology, cpuset, flags) == 0);
+
+  hwloc_cpuset_to_nodeset(topology, cpuset, nodeset);
+
+  subloc = (hwloc_bitmap_weight(nodeset) == 1)
+           ? hwloc_bitmap_first(nodeset)
+           : c_sublocid_any;
+
+  hwloc_bitmap_free(nodeset);
+  hwloc_bitmap_free(cpuset);
+
+  return subloc;
+}
+
+
 void chpl_topo_setMemLocality(void* p, size_t size, chpl_bool onlyInside,
                               c_sublocid_t subloc) {
   size_t pgSize;
@@ -433,6 +663,22 @@ void chpl_topo_setMemSubchunkLocality(void* p, size_t size,
 }
 
 
+//
+// Write-fault each page without changing its contents, so that this is
+// safe on memory that is already in use.
+//
+static inline
+void touchPages(unsigned char* pPgLo, size_t pgSize, size_t nPages) {
+  size_t pg;
+  for (pg = 0; pg < nPages; pg++) {
+    unsigned char* pb = &pPgLo[pg * pgSize];
+    unsigned char b = __atomic_load_n(pb, __ATOMIC_RELAXED);
+    (void) __atomic_compare_exchange_n(pb, &b, b, false,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  }
+}
+
+
 void chpl_topo_touchMemFromSubloc(void* p, size_t size, chpl_bool onlyInside,
                                   c_sublocid_t subloc) {
   size_t pgSize;
@@ -444,12 +690,6 @@ void chpl_topo_touchMemFromSubloc(void* p, size_t size, chpl_bool onlyInside,
   _DBG_P("chpl_topo_touchMemFromSubloc(%p, %#zx, onlyIn=%s, %d)\n",
          p, size, (onlyInside ? "T" : "F"), (int) subloc);
 
-  if (!haveTopology
-      || !topoSupport->cpubind->get_thread_cpubind
-      || !topoSupport->cpubind->set_thread_cpubind) {
-    return;
-  }
-
   alignAddrSize(p, size, onlyInside, &pgSize, &pPgLo, &nPages);
 
   _DBG_P("    localize %p, %#zx bytes (%#zx pages)\n",
@@ -458,19 +698,21 @@ void chpl_topo_touchMemFromSubloc(void* p, size_t size, chpl_bool onlyInside,
   if (nPages == 0)
     return;
 
+  if (!haveTopology
+      || !topoSupport->cpubind->get_thread_cpubind
+      || !topoSupport->cpubind->set_thread_cpubind) {
+    touchPages(pPgLo, pgSize, nPages);
+    return;
+  }
+
   CHK_ERR_ERRNO((cpuset = hwloc_bitmap_alloc()) != NULL);
 
   flags = HWLOC_CPUBIND_THREAD;
-  CHK_ERR_ERRNO(hwloc_set_cpubind(topology, cpuset, flags) == 0);
+  CHK_ERR_ERRNO(hwloc_get_cpubind(topology, cpuset, flags) == 0);
 
   chpl_topo_setThreadLocality(subloc);
 
-  {
-    size_t pg;
-    for (pg = 0; pg < nPages; pg++) {
-      pPgLo[pg * pgSize] = 0;
-    }
-  }
+  touchPages(pPgLo, pgSize, nPages);
 
   flags = HWLOC_CPUBIND_THREAD | HWLOC_CPUBIND_STRICT;
   CHK_ERR_ERRNO(hwloc_set_cpubind(topology, cpuset, flags) == 0);
@@ -578,6 +820,54 @@ c_sublocid_t chpl_topo_getMemLocality(void* p) {
 }
 
 
+void chpl_topo_checkMemLocality(void* p, size_t size, c_sublocid_t subloc,
+                                size_t* p_nChecked, size_t* p_nRemote) {
+  const size_t maxSamples = 256;
+  size_t pgSize;
+  unsigned char* pPgLo;
+  size_t nPages;
+  size_t nSamples;
+  size_t i;
+  hwloc_nodeset_t nodeset;
+  hwloc_obj_t numaObj;
+
+  *p_nChecked = 0;
+  *p_nRemote = 0;
+
+  if (!haveTopology
+      || !topoSupport->membind->get_area_memlocation
+      || !isActualSublocID(subloc)) {
+    return;
+  }
+
+  alignAddrSize(p, size, true, &pgSize, &pPgLo, &nPages);
+  if (nPages == 0)
+    return;
+
+  nSamples = (nPages < maxSamples) ? nPages : maxSamples;
+  numaObj = getNumaObj(subloc);
+
+  CHK_ERR_ERRNO((nodeset = hwloc_bitmap_alloc()) != NULL);
+
+  for (i = 0; i < nSamples; i++) {
+    unsigned char* pg = pPgLo + (i * nPages / nSamples) * pgSize;
+    if (hwloc_get_area_memlocation(topology, pg, 1, nodeset,
+                                   HWLOC_MEMBIND_BYNODESET) != 0
+        || hwloc_bitmap_iszero(nodeset)) {
+      continue;
+    }
+    (*p_nChecked)++;
+    if (!hwloc_bitmap_intersects(nodeset, numaObj->nodeset))
+      (*p_nRemote)++;
+  }
+
+  hwloc_bitmap_free(nodeset);
+
+  _DBG_P("chpl_topo_checkMemLocality(%p, %#zx, %d): %zd of %zd remote\n",
+         p, size, (int) subloc, *p_nRemote, *p_nChecked);
+}
+
+
 static
 void chk_err_fn(const char* file, int lineno, const char* what) {
   chpl_internal_error_v("%s: %d: !(%s)", file, lineno, what);
@@ -29,6 +29,7 @@
 #include "error.h"
 
 #include <stdint.h>
+#include <unistd.h>
 
 
 void chpl_topo_init(void) { }
@@ -42,6 +43,11 @@ void* chpl_topo_getHwlocTopology(void) {
 }
 
 
+chpl_bool chpl_topo_bindToReservedCPUs(void) {
+  return false;
+}
+
+
 int chpl_topo_getNumCPUsPhysical(chpl_bool accessible_only) {
   return chpl_sys_getNumCPUsPhysical(accessible_only);
 }
@@ -57,6 +63,63 @@ int chpl_topo_getNumNumaDomains(void) {
 }
 
 
+//
+// Without hwloc, we can still get the cache geometry from sysconf() on
+// some systems (glibc, notably), for L1 through L3.  We can't tell how
+// the caches are shared.
+//
+static long getCacheSysconf(int level, chpl_bool lineSize) {
+  long val = -1;
+  switch (level) {
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL1_DCACHE_LINESIZE)
+  case 1:
+    val = sysconf(lineSize ? _SC_LEVEL1_DCACHE_LINESIZE
+                           : _SC_LEVEL1_DCACHE_SIZE);
+    break;
+#endif
+#if defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL2_CACHE_LINESIZE)
+  case 2:
+    val = sysconf(lineSize ? _SC_LEVEL2_CACHE_LINESIZE
+                           : _SC_LEVEL2_CACHE_SIZE);
+    break;
+#endif
+#if defined(_SC_LEVEL3_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_LINESIZE)
+  case 3:
+    val = sysconf(lineSize ? _SC_LEVEL3_CACHE_LINESIZE
+                           : _SC_LEVEL3_CACHE_SIZE);
+    break;
+#endif
+  default:
+    break;
+  }
+  return (val > 0) ? val : 0;
+}
+
+
+int chpl_topo_getNumCacheLevels(void) {
+  int level = 0;
+  while (level < 3 && getCacheSysconf(level + 1, false) > 0) {
+    level++;
+  }
+  return level;
+}
+
+
+uint64_t chpl_topo_getCacheSize(int level) {
+  return (uint64_t) getCacheSysconf(level, false);
+}
+
+
+int chpl_topo_getCacheLineSize(int level) {
+  return (int) getCacheSysconf(level, true);
+}
+
+
+int chpl_topo_getCacheNumSharingCPUs(int level) {
+  return 0;
+}
+
+
 void chpl_topo_setThreadLocality(c_sublocid_t subloc) { }
 
 
@@ -65,6 +128,11 @@ c_sublocid_t chpl_topo_getThreadLocality(void) {
 }
 
 
+c_sublocid_t chpl_topo_getThreadBoundLocality(void) {
+  return c_sublocid_any;
+}
+
+
 void chpl_topo_setMemLocality(void* p, size_t size, chpl_bool onlyInside,
                               c_sublocid_t subloc) { }
 
@@ -75,9 +143,39 @@ void chpl_topo_setMemSubchunkLocality(void* p, size_t size,
 
 
 void chpl_topo_touchMemFromSubloc(void* p, size_t size, chpl_bool onlyInside,
-                                  c_sublocid_t subloc) { }
+                                  c_sublocid_t subloc) {
+  //
+  // With no topology there's nowhere to run but here.  Write-fault the
+  // pages without changing their contents.
+  //
+  const size_t pgSize = chpl_getHeapPageSize();
+  const uintptr_t pgMask = pgSize - 1;
+  uintptr_t lo = (uintptr_t) p;
+  uintptr_t hi = lo + size;
+
+  if (onlyInside) {
+    lo = (lo + pgMask) & ~pgMask;
+    hi &= ~pgMask;
+  } else {
+    lo &= ~pgMask;
+  }
+
+  for (uintptr_t a = lo; a < hi; a += pgSize) {
+    unsigned char* pb = (unsigned char*) a;
+    unsigned char b = __atomic_load_n(pb, __ATOMIC_RELAXED);
+    (void) __atomic_compare_exchange_n(pb, &b, b, false,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  }
+}
 
 
 c_sublocid_t chpl_topo_getMemLocality(void* p) {
   return c_sublocid_any;
 }
+
+
+void chpl_topo_checkMemLocality(void* p, size_t size, c_sublocid_t subloc,
+                                size_t* p_nChecked, size_t* p_nRemote) {
+  *p_nChecked = 0;
+  *p_nRemote = 0;
+}
@@ -0,0 +1,4 @@
+pragma "soa layout" class C { var x: int; }
+
+var c = new C(1);
+writeln(c.x);
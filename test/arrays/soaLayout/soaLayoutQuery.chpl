@@ -0,0 +1,34 @@
+pragma "soa layout"
+record Particle {
+  var x, y, z: real;
+  var id: int;
+}
+
+pragma "soa layout"
+record Pair {
+  type t;
+  var a, b: t;
+}
+
+// Not marked
+record Plain {
+  var x, y: real;
+}
+
+// Marked, but strings aren't POD
+pragma "soa layout"
+record Named {
+  var name: string;
+  var weight: real;
+}
+
+proc isSoa(type t) param return __primitive("is soa layout type", t);
+
+writeln(isSoa(Particle));
+writeln(isSoa(Pair(int)));
+writeln(isSoa(Plain));
+writeln(isSoa(Named));
+writeln(isSoa(int));
+
+var p: Particle;
+writeln(p);
@@ -0,0 +1,29 @@
+config const n = 5;
+const alpha = 2.0;
+
+var A, B, C: [1..n] real;
+for i in 1..n {
+  B[i] = i;
+  C[i] = 10 * i;
+}
+
+proc total(X: [] real) {
+  return + reduce X;
+}
+
+proc scaled(in X: [] real) {
+  for x in X do x *= 2;
+  return X;
+}
+
+// The promoted multiply is fused into the promoted add
+A = B + alpha * C;
+writeln(A);
+
+// The operands are arrays, so there is nothing to fuse
+A = B + C;
+writeln(A);
+
+// These are stored into an array for the callee
+writeln(total(B + C));
+writeln(scaled(B * alpha));
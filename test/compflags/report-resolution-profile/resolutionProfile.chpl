@@ -0,0 +1,19 @@
+// --report-resolution-profile counts, for each source function, how often
+// it and its instantiations were resolved, how many instantiations and
+// wrappers it had, and how long resolving them took.
+
+proc square(x: int) {
+  return x * x;
+}
+
+proc twice(x) {
+  return x + x;
+}
+
+proc withDefault(x: int, y: int = 2) {
+  return x + y;
+}
+
+writeln(square(3), " ", square(4));
+writeln(twice(1), " ", twice(1.5), " ", twice(2));
+writeln(withDefault(1), " ", withDefault(1, 5), " ", withDefault(2));
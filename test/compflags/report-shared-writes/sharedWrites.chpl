@@ -0,0 +1,38 @@
+config const n = 1000;
+
+proc bump(ref x: int) { x += 1; }
+
+// Every task writes the same outer scalar
+proc lastIndex() {
+  var last = 0;
+  forall i in 1..n with (ref last) do if i == n then last = i;
+  return last;
+}
+
+proc bumpOnce() {
+  var hits = 0;
+  forall i in 1..n with (ref hits) do if i == 1 then bump(hits);
+  return hits;
+}
+
+// These are left alone: a reduce intent, a scalar that is only read, and
+// an array
+proc sum() {
+  var s = 0;
+  forall i in 1..n with (+ reduce s) do s += i;
+  return s;
+}
+
+proc readOnly() {
+  var limit = n / 2, A: [1..n] int;
+  forall i in 1..n with (ref limit) do A[i] = if i <= limit then 1 else 0;
+  return + reduce A;
+}
+
+proc array() {
+  var B: [1..n] int;
+  forall i in 1..n with (ref B) do B[i] = i;
+  return B[n];
+}
+
+writeln(lastIndex(), " ", bumpOnce(), " ", sum(), " ", readOnly(), " ", array());
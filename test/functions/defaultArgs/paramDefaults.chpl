@@ -0,0 +1,42 @@
+// Defaults that fold to a param are only resolved once per formal, so
+// check that each call still gets the right value, and that defaults
+// that are not params are still evaluated at every call.
+
+proc scale(x: int, param factor = 2) {
+  return x * factor;
+}
+
+enum color { red, green, blue }
+
+proc paint(c = color.green) {
+  return c;
+}
+
+// Each instantiation has its own 'bits' formal
+proc width(x, param bits = numBits(x.type)) {
+  return bits;
+}
+
+// The default depends on another param formal
+proc tens(param a: int, param b = a * 10) param {
+  return b;
+}
+
+var counter = 0;
+
+proc next() {
+  counter += 1;
+  return counter;
+}
+
+// Not a param, so each call has to call next()
+proc ticket(n = next()) {
+  return n;
+}
+
+writeln(scale(1), " ", scale(2), " ", scale(3, 5), " ", scale(4));
+writeln(paint(), " ", paint(color.blue), " ", paint());
+writeln(width(1:int(8)), " ", width(1:int(32)), " ", width(1), " ",
+        width(1:int(8), 3));
+writeln(tens(1), " ", tens(2), " ", tens(3, 7), " ", tens(1));
+writeln(ticket(), " ", ticket(), " ", ticket(10), " ", ticket());
@@ -0,0 +1,26 @@
+// Instantiations are cached by their substitutions.  Calls with the same
+// substitutions share one, and ones that only differ in which formal
+// gets which substitution must each get their own.
+
+proc pair(x, y) {
+  return x.type:string + "," + y.type:string;
+}
+
+proc digits(param a: int, param b: int) param {
+  return a * 10 + b;
+}
+
+writeln(pair(1, 2.0));
+writeln(pair(2.0, 1));
+writeln(pair(3, 4.0));
+writeln(pair(true, 1));
+writeln(pair(1, true));
+
+writeln(digits(1, 2), " ", digits(2, 1), " ", digits(1, 2));
+
+var sum = 0;
+for param i in 1..20 {
+  sum += digits(i, 20 - i);
+  sum += digits(20 - i, i);
+}
+writeln(sum);
@@ -0,0 +1,78 @@
+class Node {
+  var val: int;
+  var left, right: unmanaged Node?;
+}
+
+proc build(lo: int, hi: int): unmanaged Node? {
+  if lo > hi then return nil;
+  const mid = (lo + hi) / 2;
+  return new unmanaged Node(mid, build(lo, mid-1), build(mid+1, hi));
+}
+
+proc free(n: unmanaged Node?) {
+  if n != nil {
+    free(n!.left);
+    free(n!.right);
+    delete n;
+  }
+}
+
+// The recursive loops in these only forward what they yield
+iter inorder(n: unmanaged Node?): int {
+  if n != nil {
+    for x in inorder(n!.left) do yield x;
+    yield n!.val;
+    for x in inorder(n!.right) do yield x;
+  }
+}
+
+iter postorder(n: unmanaged Node?): int {
+  if n != nil {
+    for x in postorder(n!.left) do yield x;
+    for x in postorder(n!.right) do yield x;
+    yield n!.val;
+  }
+}
+
+iter depths(n: unmanaged Node?, d: int = 0): int {
+  if n != nil {
+    for x in depths(n!.left, d+1) do yield x;
+    yield d;
+    for x in depths(n!.right, d+1) do yield x;
+  }
+}
+
+// The recursive loops in this filter what they yield, so they keep their
+// own loop bodies
+iter evens(n: unmanaged Node?): int {
+  if n != nil {
+    for x in evens(n!.left) do if x % 2 == 0 then yield x;
+    if n!.val % 2 == 0 then yield n!.val;
+    for x in evens(n!.right) do if x % 2 == 0 then yield x;
+  }
+}
+
+const root = build(1, 15);
+
+// inorder is run with two different loop bodies, the others with one
+for x in inorder(root) do write(x, " ");
+writeln();
+
+var sum = 0;
+for x in inorder(root) do sum += x;
+writeln(sum);
+
+for x in postorder(root) do write(x, " ");
+writeln();
+
+var depthSum = 0;
+for d in depths(root) {
+  write(d, " ");
+  depthSum += d;
+}
+writeln(depthSum);
+
+for x in evens(root) do write(x, " ");
+writeln();
+
+free(root);
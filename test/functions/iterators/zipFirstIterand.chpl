@@ -0,0 +1,34 @@
+// This has two loops, so it needs an advance function in a zippered loop
+iter twoRuns(n: int) {
+  for i in 1..n do yield i;
+  for i in 1..n do yield -i;
+}
+
+iter squares(n: int) {
+  for i in 1..n do yield i*i;
+}
+
+const n = 4;
+var A: [1..2*n] int = 1..2*n;
+
+// The first iterand is inlined and the others are advanced in its body
+for (x, i, a) in zip(twoRuns(n), 1.., A) do write(x*i + a, " ");
+writeln();
+
+var sum = 0;
+for (x, y) in zip(twoRuns(n), twoRuns(n)) do sum += x*y;
+writeln(sum);
+
+for (x, a) in zip(twoRuns(n), A) do a = x;
+writeln(A);
+
+// These are left alone: the body jumps out of the loop, and the first
+// iterand is already a single loop
+for (x, s) in zip(twoRuns(n), squares(2*n)) {
+  if x < 0 then break;
+  write(x + s, " ");
+}
+writeln();
+
+for (s, x) in zip(squares(2*n), twoRuns(n)) do write(s - x, " ");
+writeln();
@@ -0,0 +1,24 @@
+class C { var x: int; }
+
+proc checked() {
+  var b: borrowed C?;
+  {
+    var own = new owned C(1);
+    b = own.borrow();
+  }
+  writeln(b);
+}
+
+// Not checked, so the same code here isn't reported
+pragma "unsafe"
+proc unchecked() {
+  var b: borrowed C?;
+  {
+    var own = new owned C(2);
+    b = own.borrow();
+  }
+  writeln(b);
+}
+
+checked();
+unchecked();
@@ -0,0 +1,33 @@
+class C { var x: int; }
+
+// Lifetimes are still inferred for the foralls in these, for the forall
+// unordered ops optimization
+pragma "unsafe"
+proc fill(A: [] int) {
+  forall i in A.domain do A[i] = i * 2;
+}
+
+pragma "unsafe"
+proc countMod(A: [] int, B: [] atomic int) {
+  forall a in A do B[a % B.size].add(1);
+}
+
+// Task functions aren't checked on their own, only with the function
+// that starts them
+proc tasks() {
+  var a = new owned C(1), b = new owned C(2);
+  var sum = 0;
+  cobegin with (ref sum) {
+    sum += a.borrow().x;
+    { const c = b.borrow(); writeln(c.x); }
+  }
+  writeln(sum);
+}
+
+var A: [0..#10] int;
+var B: [0..#5] atomic int;
+fill(A);
+writeln(A);
+countMod(A, B);
+writeln([b in B] b.read());
+tasks();
@@ -0,0 +1,60 @@
+// Visible function lookups are cached per name and scope.  Look up the
+// same names from different scopes, more than once each, including
+// through private functions, renaming uses and the point of
+// instantiation, and check that each call sees its own candidates.
+
+module Lib {
+  proc which() { return "Lib.which"; }
+
+  private proc hidden() { return "Lib.hidden"; }
+
+  proc callHidden() { return hidden(); }
+
+  proc generic(x) { return helper(x); }
+}
+
+module Other {
+  proc which() { return "Other.which"; }
+}
+
+proc first() {
+  use Lib;
+  return which();
+}
+
+proc second() {
+  use Other;
+  return which();
+}
+
+proc nested() {
+  proc which() { return "nested.which"; }
+  return which();
+}
+
+proc renamed() {
+  use Other only which as otherWhich;
+  return otherWhich();
+}
+
+proc hiddenHere() {
+  proc hidden() { return "hiddenHere.hidden"; }
+  use Lib;
+  return hidden();
+}
+
+proc poi() {
+  proc helper(x: int) { return "poi.helper"; }
+  use Lib;
+  return generic(1);
+}
+
+for i in 1..2 {
+  writeln(first());
+  writeln(second());
+  writeln(nested());
+  writeln(renamed());
+  writeln(hiddenHere());
+  writeln(Lib.callHidden());
+  writeln(poi());
+}
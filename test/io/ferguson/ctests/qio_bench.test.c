@@ -0,0 +1,307 @@
+#include "qio.h"
+#include "qio_formatted.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Throughput benchmarks for qio: sequential reads and writes with each
+// I/O method, integer and float scanning, float printing and JSON
+// skipping.  Everything is reported in MB/s of text or data handled.
+//
+// Usage: qio_bench [--printTimings] [--mb=N]
+//   --printTimings  print the rates (otherwise only check results)
+//   --mb=N          size of the data for each benchmark (default 16)
+
+int printTimings = 0;
+int64_t mb = 16;
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void report(const char* what, int64_t bytes, double secs)
+{
+  if( printTimings ) {
+    printf("%s (MB/s): %.2f\n", what, bytes / secs / 1.0e6);
+  }
+}
+
+static const char* method_name(qio_hint_t method)
+{
+  switch( method ) {
+    case QIO_METHOD_READWRITE: return "readwrite";
+    case QIO_METHOD_PREADPWRITE: return "preadpwrite";
+    case QIO_METHOD_FREADFWRITE: return "freadfwrite";
+    case QIO_METHOD_MMAP: return "mmap";
+    case QIO_METHOD_URING: return "uring";
+    default: return "default";
+  }
+}
+
+static void open_tmp(qio_file_t** f, qio_hint_t method, char* filename,
+                     const char* access)
+{
+  qioerr err;
+
+  if( method == QIO_METHOD_FREADFWRITE ) {
+    FILE* fp = fopen(filename, access);
+    assert(fp);
+    err = qio_file_init(f, fp, -1, method, NULL, 1);
+  } else {
+    err = qio_file_open_access(f, filename, access, method, NULL);
+  }
+  assert(!err);
+}
+
+// Write and then read back 'mb' MB with the given method, in 64 KiB
+// pieces, and check what comes back.
+static void bench_method(qio_hint_t method)
+{
+  char filename[128];
+  char what[128];
+  int64_t total = mb * 1024 * 1024;
+  ssize_t chunksz = 64 * 1024;
+  unsigned char* chunk = qio_malloc(chunksz);
+  unsigned char* got = qio_malloc(chunksz);
+  qio_file_t* f;
+  qio_channel_t* ch;
+  int64_t off;
+  uint64_t sum = 0, gotsum = 0;
+  ssize_t k;
+  double t;
+  qioerr err;
+  int fd;
+
+  assert(chunk && got);
+  for( k = 0; k < chunksz; k++ ) chunk[k] = k * 7 + (k >> 8);
+
+  strcpy(filename, "/tmp/qio_benchXXXXXX");
+  fd = mkstemp(filename);
+  assert(fd >= 0);
+  close(fd);
+
+  open_tmp(&f, method, filename, "w");
+  t = now();
+  err = qio_channel_create(&ch, f, 0, 0, 1, 0, INT64_MAX, NULL);
+  assert(!err);
+  for( off = 0; off < total; off += chunksz ) {
+    chunk[0] = off / chunksz;
+    sum += chunk[0];
+    err = qio_channel_write_amt(false, ch, chunk, chunksz);
+    assert(!err);
+  }
+  qio_channel_release(ch);
+  err = qio_file_sync(f);
+  assert(!err);
+  qio_file_release(f);
+  sprintf(what, "sequential write, %s", method_name(method));
+  report(what, total, now() - t);
+
+  open_tmp(&f, method, filename, "r");
+  t = now();
+  err = qio_channel_create(&ch, f, 0, 1, 0, 0, INT64_MAX, NULL);
+  assert(!err);
+  for( off = 0; off < total; off += chunksz ) {
+    err = qio_channel_read_amt(false, ch, got, chunksz);
+    assert(!err);
+    gotsum += got[0];
+  }
+  qio_channel_release(ch);
+  qio_file_release(f);
+  sprintf(what, "sequential read, %s", method_name(method));
+  report(what, total, now() - t);
+
+  assert(sum == gotsum);
+  assert(0 == memcmp(chunk + 1, got + 1, chunksz - 1));
+
+  unlink(filename);
+  qio_free(chunk);
+  qio_free(got);
+}
+
+// A memory file holding 'mb' MB of text made by calling 'fill' until
+// it has written that much.
+static qio_file_t* make_text(void (*fill)(qio_channel_t*, int64_t),
+                             int64_t* len_out)
+{
+  qio_file_t* f;
+  qio_channel_t* ch;
+  qioerr err;
+  int64_t i;
+
+  err = qio_file_open_mem_ext(&f, NULL,
+                              QIO_FDFLAG_READABLE|QIO_FDFLAG_WRITEABLE|
+                              QIO_FDFLAG_SEEKABLE, 0, NULL);
+  assert(!err);
+  err = qio_channel_create(&ch, f, 0, 0, 1, 0, INT64_MAX, NULL);
+  assert(!err);
+  for( i = 0; qio_channel_offset_unlocked(ch) < mb * 1024 * 1024; i++ ) {
+    fill(ch, i);
+  }
+  *len_out = qio_channel_offset_unlocked(ch);
+  qio_channel_release(ch);
+  return f;
+}
+
+static void fill_int(qio_channel_t* ch, int64_t i)
+{
+  int64_t num = (i * 2654435761LL) % 1000000007 - 500000000;
+  qioerr err = qio_channel_print_int(false, ch, &num, 8, 1);
+  assert(!err);
+  err = qio_channel_write_amt(false, ch, " ", 1);
+  assert(!err);
+}
+
+static void fill_float(qio_channel_t* ch, int64_t i)
+{
+  double num = ((i * 2654435761LL) % 1000000007 - 500000000) / 1024.0;
+  qioerr err = qio_channel_print_float(false, ch, &num, 8);
+  assert(!err);
+  err = qio_channel_write_amt(false, ch, " ", 1);
+  assert(!err);
+}
+
+static void fill_json(qio_channel_t* ch, int64_t i)
+{
+  char buf[256];
+  int len = snprintf(buf, sizeof(buf),
+                     "%s{\"id\": %lld, \"name\": \"item \\\"%lld\\\"\", "
+                     "\"tags\": [\"a\", \"b\", {\"x\": %lld.5}], "
+                     "\"ok\": true}",
+                     i == 0 ? "[" : ", ", (long long) i, (long long) i,
+                     (long long) i);
+  qioerr err = qio_channel_write_amt(false, ch, buf, len);
+  assert(!err);
+}
+
+static void bench_scan_int(void)
+{
+  int64_t len, count = 0, num;
+  qio_file_t* f = make_text(fill_int, &len);
+  qio_channel_t* ch;
+  qioerr err;
+  double t;
+
+  err = qio_channel_create(&ch, f, 0, 1, 0, 0, len, NULL);
+  assert(!err);
+  t = now();
+  while( 1 ) {
+    err = qio_channel_scan_int(false, ch, &num, 8, 1);
+    if( err ) break;
+    assert(num == (count * 2654435761LL) % 1000000007 - 500000000);
+    count++;
+    err = qio_channel_scan_literal(false, ch, " ", 1, 0);
+    assert(!err);
+  }
+  report("scan int", len, now() - t);
+  assert(qio_err_to_int(err) == EEOF);
+  assert(count > 0);
+  qio_channel_release(ch);
+  qio_file_release(f);
+}
+
+static void bench_scan_float(void)
+{
+  int64_t len, count = 0;
+  double num;
+  qio_file_t* f = make_text(fill_float, &len);
+  qio_channel_t* ch;
+  qioerr err;
+  double t;
+
+  err = qio_channel_create(&ch, f, 0, 1, 0, 0, len, NULL);
+  assert(!err);
+  t = now();
+  while( 1 ) {
+    err = qio_channel_scan_float(false, ch, &num, 8);
+    if( err ) break;
+    assert(num >= -500000000 && num <= 500000000);
+    count++;
+    err = qio_channel_scan_literal(false, ch, " ", 1, 0);
+    assert(!err);
+  }
+  report("scan float", len, now() - t);
+  assert(qio_err_to_int(err) == EEOF);
+  assert(count > 0);
+  qio_channel_release(ch);
+  qio_file_release(f);
+}
+
+// Printing ints and floats into memory (the latter is _ftoa writing
+// straight into the channel buffer).
+static void bench_print(void)
+{
+  int64_t len;
+  qio_file_t* f;
+  double t;
+
+  t = now();
+  f = make_text(fill_int, &len);
+  report("print int", len, now() - t);
+  qio_file_release(f);
+
+  t = now();
+  f = make_text(fill_float, &len);
+  report("print float", len, now() - t);
+  qio_file_release(f);
+}
+
+static void bench_skip_json(void)
+{
+  int64_t len;
+  qio_file_t* f;
+  qio_channel_t* ch;
+  qioerr err;
+  int32_t got;
+  double t;
+
+  // make_text() leaves the array open, so close it after.
+  f = make_text(fill_json, &len);
+  err = qio_channel_create(&ch, f, 0, 0, 1, len, INT64_MAX, NULL);
+  assert(!err);
+  err = qio_channel_write_amt(false, ch, "]", 1);
+  assert(!err);
+  qio_channel_release(ch);
+  len++;
+
+  err = qio_channel_create(&ch, f, 0, 1, 0, 0, len, NULL);
+  assert(!err);
+  t = now();
+  got = qio_skip_json_value_unlocked(ch);
+  report("skip json", len, now() - t);
+  assert(got == 0);
+  assert(qio_channel_offset_unlocked(ch) == len);
+  qio_channel_release(ch);
+  qio_file_release(f);
+}
+
+int main(int argc, char** argv)
+{
+  int i;
+
+  for( i = 1; i < argc; i++ ) {
+    if( 0 == strcmp(argv[i], "--printTimings") ) printTimings = 1;
+    else if( 0 == strncmp(argv[i], "--mb=", 5) ) mb = atoll(argv[i] + 5);
+  }
+
+  qbytes_iobuf_size = 64*1024;
+
+  bench_method(QIO_METHOD_READWRITE);
+  bench_method(QIO_METHOD_PREADPWRITE);
+  bench_method(QIO_METHOD_FREADFWRITE);
+  bench_method(QIO_METHOD_MMAP);
+  bench_method(QIO_METHOD_URING);
+
+  bench_scan_int();
+  bench_scan_float();
+  bench_print();
+  bench_skip_json();
+
+  printf("qio_bench PASS\n");
+
+  return 0;
+}
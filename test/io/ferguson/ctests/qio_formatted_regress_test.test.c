@@ -0,0 +1,129 @@
+#include "qio_formatted.h"
+#include <assert.h>
+#include <locale.h>
+
+// Regression tests for scanning a number that ends the channel and for
+// printing reals into a nearly full channel buffer.
+
+static void write_file(qio_file_t* f, const char* pad, int padlen,
+                       double* num)
+{
+  qioerr err;
+  qio_channel_t* writing;
+
+  err = qio_channel_create(&writing, f, QIO_CH_BUFFERED, 0, 1, 0, INT64_MAX, NULL);
+  assert(!err);
+
+  if( padlen > 0 ) {
+    err = qio_channel_write_amt(true, writing, pad, padlen);
+    assert(!err);
+  }
+
+  if( num ) {
+    err = qio_channel_print_float(true, writing, num, 8);
+    assert(!err);
+  }
+
+  qio_channel_release(writing);
+}
+
+static void read_file(qio_file_t* f, char* got, size_t got_sz)
+{
+  qioerr err;
+  qio_channel_t* reading;
+  ssize_t amt_read;
+
+  memset(got, 0, got_sz);
+
+  err = qio_channel_create(&reading, f, QIO_CH_BUFFERED, 1, 0, 0, INT64_MAX, NULL);
+  assert(!err);
+
+  err = qio_channel_read(true, reading, got, got_sz - 1, &amt_read);
+  assert(qio_err_to_int(err) == EEOF);
+
+  qio_channel_release(reading);
+}
+
+// "14" with nothing after it used to scan as 1 when characters were
+// read a byte at a time, because EOF on the last read was not reported.
+static void test_scan_int_at_eof(void)
+{
+  int locales[] = {QIO_GLOCALE_UTF8, QIO_GLOCALE_ASCII, QIO_GLOCALE_OTHER};
+  qioerr err;
+  qio_file_t* f;
+  qio_channel_t* reading;
+  int64_t num;
+  int i;
+
+  for( i = 0; i < 3; i++ ) {
+    qio_glocale_utf8 = locales[i];
+
+    err = qio_file_open_tmp(&f, 0, NULL);
+    assert(!err);
+
+    write_file(f, "14", 2, NULL);
+
+    err = qio_channel_create(&reading, f, QIO_CH_BUFFERED, 1, 0, 0, INT64_MAX, NULL);
+    assert(!err);
+
+    num = 0;
+    err = qio_channel_scan_int(true, reading, &num, 8, 1);
+    assert(!err);
+    assert(num == 14);
+
+    err = qio_channel_scan_int(true, reading, &num, 8, 1);
+    assert(qio_err_to_int(err) == EEOF);
+
+    qio_channel_release(reading);
+    qio_file_release(f);
+  }
+}
+
+// Reals in [1e5, 1e6) are printed with %e and then again with the
+// precision found in the first result.  When the first result was cut
+// short, the precision came from a partial string.
+static void test_print_float_short_buffer(void)
+{
+  double nums[] = {123456.0, 654321.5, 100000.0, 999999.875};
+  char pad[128];
+  char expect[128];
+  char got[256];
+  qioerr err;
+  qio_file_t* f;
+  int i, padlen;
+
+  memset(pad, 'x', sizeof(pad));
+
+  for( i = 0; i < 4; i++ ) {
+    err = qio_file_open_tmp(&f, 0, NULL);
+    assert(!err);
+    write_file(f, pad, 0, &nums[i]);
+    read_file(f, expect, sizeof(expect));
+    qio_file_release(f);
+
+    for( padlen = 1; padlen <= 2 * (int) qbytes_iobuf_size; padlen++ ) {
+      err = qio_file_open_tmp(&f, 0, NULL);
+      assert(!err);
+      write_file(f, pad, padlen, &nums[i]);
+      read_file(f, got, sizeof(got));
+      assert(0 == memcmp(got, pad, padlen));
+      assert(0 == strcmp(got + padlen, expect));
+      qio_file_release(f);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  setlocale(LC_CTYPE, "");
+
+  test_scan_int_at_eof();
+
+  // Small buffers, so that prints land near their ends
+  qbytes_iobuf_size = 64;
+  test_print_float_short_buffer();
+
+  printf("qio_formatted_regress_test PASS\n");
+
+  return 0;
+}
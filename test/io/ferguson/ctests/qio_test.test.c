@@ -435,6 +435,11 @@ int main(int argc, char** argv)
 
   check_channels();
 
+  // again, with read-ahead/write-behind by helper threads.
+  qio_pipeline_depth = 3;
+  check_channels();
+  qio_pipeline_depth = 0;
+
 
   printf("qio_test PASS\n");
 
@@ -0,0 +1,204 @@
+#include "qio_formatted.h"
+#include <assert.h>
+
+// Tests for decoding varints from memory and for reading bytes out of a
+// channel without copying them.
+
+static size_t encode(unsigned char* p, uint64_t num)
+{
+  size_t i = 0;
+  while( num >= 0x80 ) {
+    p[i++] = (num & 0x7f) | 0x80;
+    num >>= 7;
+  }
+  p[i++] = num;
+  return i;
+}
+
+static void test_decode_varints(void)
+{
+  unsigned char buf[4096];
+  uint64_t nums[300];
+  uint64_t got[300];
+  int64_t snums[4] = {0, -1, INT64_MIN, INT64_MAX};
+  int64_t sgot[4];
+  size_t len = 0;
+  size_t cut;
+  size_t used;
+  ssize_t n;
+  qioerr err;
+  int i;
+
+  for( i = 0; i < 300; i++ ) {
+    nums[i] = (i % 65 == 64) ? UINT64_MAX
+                             : (((uint64_t) 1) << (i % 64)) + i;
+    len += encode(buf + len, nums[i]);
+  }
+
+  // All of them, and a count that stops early
+  err = qio_decode_uvarints(buf, len, got, 300, &n, &used);
+  assert(!err && n == 300 && used == len);
+  for( i = 0; i < 300; i++ ) assert(got[i] == nums[i]);
+
+  err = qio_decode_uvarints(buf, len, got, 7, &n, &used);
+  assert(!err && n == 7);
+
+  // Every prefix decodes the values before the cut; a varint cut in
+  // half is EEOF
+  for( cut = 0; cut < len; cut++ ) {
+    err = qio_decode_uvarints(buf, cut, got, 300, &n, &used);
+    assert(!err || qio_err_to_int(err) == EEOF);
+    assert(used <= cut);
+    for( i = 0; i < n; i++ ) assert(got[i] == nums[i]);
+    if( !err ) assert(used == cut);
+  }
+
+  // Signed values are zigzag encoded
+  len = 0;
+  for( i = 0; i < 4; i++ ) {
+    uint64_t u = ((uint64_t) snums[i] << 1) ^ (uint64_t) (snums[i] >> 63);
+    len += encode(buf + len, u);
+  }
+  err = qio_decode_svarints(buf, len, sgot, 4, &n, &used);
+  assert(!err && n == 4 && used == len);
+  for( i = 0; i < 4; i++ ) assert(sgot[i] == snums[i]);
+}
+
+static void check_overflow(const unsigned char* bad, size_t badlen)
+{
+  unsigned char buf[64];
+  uint64_t got[4];
+  size_t used;
+  ssize_t n;
+  qioerr err;
+  int pad;
+
+  // with enough bytes after it for the fast path, and at the very end
+  for( pad = 0; pad <= 16; pad += 16 ) {
+    memset(buf, 0, sizeof(buf));
+    buf[0] = 5;
+    memcpy(buf + 1, bad, badlen);
+    err = qio_decode_uvarints(buf, 1 + badlen + pad, got, 4, &n, &used);
+    assert(qio_err_to_int(err) == EFORMAT);
+    assert(n == 1 && got[0] == 5 && used == 1);
+  }
+}
+
+static void test_malformed_varints(void)
+{
+  // 11 bytes that all continue
+  const unsigned char too_long[11] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                      0x80, 0x80, 0x80, 0x81, 0x00};
+  // 10 bytes with bits above bit 63 in the last one
+  const unsigned char too_big[10] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                                     0xff, 0xff, 0xff, 0x02};
+  // the largest value still fits
+  const unsigned char max[10] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                                 0xff, 0xff, 0xff, 0x01};
+  uint64_t got[1];
+  size_t used;
+  ssize_t n;
+  qioerr err;
+
+  check_overflow(too_long, sizeof(too_long));
+  check_overflow(too_big, sizeof(too_big));
+
+  err = qio_decode_uvarints(max, sizeof(max), got, 1, &n, &used);
+  assert(!err && n == 1 && used == 10 && got[0] == UINT64_MAX);
+}
+
+static void make_file(qio_file_t** f, const char* a, const char* b)
+{
+  qbuffer_t* buf;
+  qbytes_t* bytes;
+  qioerr err;
+
+  err = qbuffer_create(&buf);
+  assert(!err);
+
+  err = qbytes_create_calloc(&bytes, strlen(a));
+  assert(!err);
+  memcpy(bytes->data, a, strlen(a));
+  err = qbuffer_append(buf, bytes, 0, strlen(a));
+  assert(!err);
+  qbytes_release(bytes);
+
+  if( b ) {
+    err = qbytes_create_calloc(&bytes, strlen(b));
+    assert(!err);
+    memcpy(bytes->data, b, strlen(b));
+    err = qbuffer_append(buf, bytes, 0, strlen(b));
+    assert(!err);
+    qbytes_release(bytes);
+  }
+
+  err = qio_file_open_mem(f, buf, NULL);
+  assert(!err);
+  qbuffer_release(buf);
+}
+
+static void test_read_bytes_ref(void)
+{
+  qio_file_t* f;
+  qio_channel_t* ch;
+  qbytes_t* first;
+  qbytes_t* bytes;
+  int64_t skip;
+  qioerr err;
+
+  // Within one bytes object: the same object is returned
+  make_file(&f, "hello, world", NULL);
+  err = qio_channel_create(&ch, f, 0, 1, 0, 0, INT64_MAX, NULL);
+  assert(!err);
+
+  err = qio_channel_read_bytes_ref(true, ch, 5, &first, &skip);
+  assert(!err && skip == 0);
+  assert(0 == memcmp((char*) first->data + skip, "hello", 5));
+
+  err = qio_channel_read_bytes_ref(true, ch, 7, &bytes, &skip);
+  assert(!err && bytes == first && skip == 5);
+  assert(0 == memcmp((char*) bytes->data + skip, ", world", 7));
+  qbytes_release(bytes);
+  qbytes_release(first);
+
+  // Nothing left
+  err = qio_channel_read_bytes_ref(true, ch, 1, &bytes, &skip);
+  assert(qio_err_to_int(err) == EEOF && bytes == NULL);
+
+  qio_channel_release(ch);
+  qio_file_release(f);
+
+  // Across two bytes objects: the data is copied into a new one
+  make_file(&f, "abc", "defg");
+  err = qio_channel_create(&ch, f, 0, 1, 0, 0, INT64_MAX, NULL);
+  assert(!err);
+
+  err = qio_channel_read_bytes_ref(true, ch, 1, &first, &skip);
+  assert(!err);
+  err = qio_channel_read_bytes_ref(true, ch, 4, &bytes, &skip);
+  assert(!err && bytes != first && skip == 0);
+  assert(0 == memcmp(bytes->data, "bcde", 4));
+  qbytes_release(bytes);
+  qbytes_release(first);
+
+  // Fewer bytes left than asked for; they are still there afterwards
+  err = qio_channel_read_bytes_ref(true, ch, 3, &bytes, &skip);
+  assert(qio_err_to_int(err) == EEOF && bytes == NULL);
+  err = qio_channel_read_bytes_ref(true, ch, 2, &bytes, &skip);
+  assert(!err && 0 == memcmp((char*) bytes->data + skip, "fg", 2));
+  qbytes_release(bytes);
+
+  qio_channel_release(ch);
+  qio_file_release(f);
+}
+
+int main(int argc, char** argv)
+{
+  test_decode_varints();
+  test_malformed_varints();
+  test_read_bytes_ref();
+
+  printf("qio_varint_mem_test PASS\n");
+
+  return 0;
+}
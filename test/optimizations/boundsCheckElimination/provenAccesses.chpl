@@ -0,0 +1,43 @@
+// With --bounds-check-elimination, accesses that are proven to be in
+// bounds lose their checks and all others keep them.
+
+config const n = 10;
+
+var GD = {1..n};
+var GA: [GD] int;
+
+// Proven: D is const and A is declared over it
+proc overConstDomain() {
+  const D = {1..n};
+  var A: [D] int;
+  for i in D do A[i] = i;
+  forall i in A.domain do A[i] += 1;
+  writeln(+ reduce A);
+}
+
+// Not proven: the index is not the loop index
+proc shifted() {
+  const D = {1..n};
+  var A: [D] int;
+  for i in D do if i < n then A[i+1] = i;
+  writeln(+ reduce A);
+}
+
+// Not proven: the domain is a global that other code can change
+proc overGlobalDomain() {
+  for i in GD do GA[i] = i;
+  writeln(+ reduce GA);
+}
+
+// Not proven: the domain of a '[]' formal isn't known here
+proc overFormal(ref A: [] int) {
+  for i in A.domain do A[i] = 2 * i;
+}
+
+overConstDomain();
+shifted();
+overGlobalDomain();
+
+var B: [1..n] int;
+overFormal(B);
+writeln(+ reduce B);
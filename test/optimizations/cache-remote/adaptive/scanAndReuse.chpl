@@ -0,0 +1,28 @@
+// Mix repeated reads of a small hot region with large scans over a cold
+// one, so that the adaptive 2Q policy moves pages between its queues,
+// and check that the values read are still right.
+
+config const hotN = 2000;
+config const coldN = 200000;
+config const rounds = 4;
+
+var Hot: [0..#hotN] int = 0..#hotN;
+var Cold: [0..#coldN] int = 0..#coldN;
+
+const hotExpect = + reduce Hot;
+const coldExpect = + reduce Cold;
+
+on Locales[numLocales-1] {
+  var ok = true;
+  for r in 0..#rounds {
+    for 1..3 {
+      var hot = 0;
+      for i in 0..#hotN do hot += Hot[i];
+      if hot != hotExpect then ok = false;
+    }
+    var cold = 0;
+    for i in 0..#coldN do cold += Cold[i];
+    if cold != coldExpect then ok = false;
+  }
+  writeln(ok);
+}
@@ -0,0 +1,137 @@
+// Remote cache effectiveness on some standard access patterns: the last
+// locale reads and writes an array on locale 0 sequentially, with a
+// stride, at random, as a write-heavy scatter, and as writes followed
+// by reads across a memory fence.  With --printTimings each pattern
+// reports its time and the cache's get/put hit rates; compile with
+// --no-cache-remote for the uncached times (the cacheBench entry in
+// util/test/BENCHMARKS runs both and reports the speedup).
+
+use Time;
+
+require "cacheStats.h";
+
+extern proc cs_start();
+extern proc cs_stop(stats: c_ptr(uint(64)));
+extern proc cs_enabled(): c_int;
+extern const CS_GET_HITS, CS_GET_MISSES, CS_PUT_HITS, CS_PUT_MISSES,
+             CS_PREFETCH_HITS, CS_GETS, CS_PUTS, CS_NUM_STATS: c_int;
+
+config const printTimings = false;
+config const n = 1 << 20;
+config const accesses = 1 << 20;     // per pattern
+config const stride = 17;
+config const seed = 314159;
+
+var A: [0..#n] int = 0..#n;
+
+proc report(pattern: string, t: real, const ref stats) {
+  if !printTimings then return;
+  writef("%s time (ms): %.3dr\n", pattern, 1.0e3 * t);
+  if cs_enabled() != 0 {
+    proc rate(hits, misses) {
+      return if hits + misses == 0 then 0.0
+             else 100.0 * hits / (hits + misses);
+    }
+    writef("%s get hit rate (%%): %.2dr\n", pattern,
+           rate(stats[CS_GET_HITS], stats[CS_GET_MISSES]));
+    writef("%s put hit rate (%%): %.2dr\n", pattern,
+           rate(stats[CS_PUT_HITS], stats[CS_PUT_MISSES]));
+    writeln(pattern, " cache get hits/misses: ",
+            stats[CS_GET_HITS], " ", stats[CS_GET_MISSES]);
+    writeln(pattern, " cache put hits/misses: ",
+            stats[CS_PUT_HITS], " ", stats[CS_PUT_MISSES]);
+    writeln(pattern, " stride prefetch hits: ", stats[CS_PREFETCH_HITS]);
+  }
+  writeln(pattern, " network gets/puts: ", stats[CS_GETS], " ",
+          stats[CS_PUTS]);
+}
+
+// Run 'body' on the last locale, timing it and collecting the cache
+// counters there.
+proc measure(pattern: string, body) {
+  on Locales[numLocales-1] {
+    var stats: [0..#CS_NUM_STATS] uint(64);
+    var t: Timer;
+    cs_start();
+    t.start();
+    const ok = body();
+    t.stop();
+    cs_stop(c_ptrTo(stats[0]));
+    writeln(pattern, ": ", ok);
+    report(pattern, t.elapsed(), stats);
+  }
+}
+
+inline proc nextRand(ref x: uint) {
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return (x % n: uint): int;
+}
+
+record SeqRead {
+  proc this() {
+    var sum = 0;
+    for i in 0..#min(n, accesses) do sum += A[i];
+    return sum == + reduce [i in 0..#min(n, accesses)] i;
+  }
+}
+
+record StridedRead {
+  proc this() {
+    var sum = 0, expect = 0, i = 0;
+    for 1..accesses {
+      sum += A[i];
+      expect += i;
+      i = (i + stride) % n;
+    }
+    return sum == expect;
+  }
+}
+
+record RandomRead {
+  proc this() {
+    var x = seed: uint, sum = 0, expect = 0;
+    for 1..accesses {
+      const i = nextRand(x);
+      sum += A[i];
+      expect += i;
+    }
+    return sum == expect;
+  }
+}
+
+record Scatter {
+  proc this() {
+    var x = seed: uint;
+    for k in 1..accesses do A[nextRand(x)] = -k;
+    // Check the last write to one of the locations.
+    x = seed: uint;
+    var last = 0;
+    for 1..accesses-1 do nextRand(x);
+    last = nextRand(x);
+    return A[last] == -accesses;
+  }
+}
+
+record ReadAfterFence {
+  proc this() {
+    var flag: atomic int;
+    var ok = true;
+    var i = 0;
+    for 1..accesses / 4 {
+      A[i] = i;
+      flag.add(1);             // fence: the write goes out, cache drops reads
+      ok &&= A[(i + 1) % n] == (i + 1) % n;
+      i = (i + stride) % n;
+    }
+    return ok;
+  }
+}
+
+measure("sequential read", new SeqRead());
+measure("strided read", new StridedRead());
+measure("random read", new RandomRead());
+measure("scatter write", new Scatter());
+A = 0..#n;
+measure("read after fence", new ReadAfterFence());
@@ -0,0 +1,42 @@
+//
+// Remote cache counters for this locale, from the comm diagnostics.
+//
+
+#include <stdint.h>
+
+#include "chpl-cache.h"
+#include "chpl-comm-diags.h"
+
+enum {
+  CS_GET_HITS,
+  CS_GET_MISSES,
+  CS_PUT_HITS,
+  CS_PUT_MISSES,
+  CS_PREFETCH_HITS,
+  CS_GETS,
+  CS_PUTS,
+  CS_NUM_STATS
+};
+
+static inline void cs_start(void) {
+  chpl_comm_resetDiagnosticsHere();
+  chpl_comm_startDiagnosticsHere(false);
+}
+
+static inline void cs_stop(uint64_t* stats) {
+  chpl_commDiagnostics d;
+
+  chpl_comm_stopDiagnosticsHere();
+  chpl_comm_getDiagnosticsHere(&d);
+  stats[CS_GET_HITS] = d.cache_get_hits;
+  stats[CS_GET_MISSES] = d.cache_get_misses;
+  stats[CS_PUT_HITS] = d.cache_put_hits;
+  stats[CS_PUT_MISSES] = d.cache_put_misses;
+  stats[CS_PREFETCH_HITS] = d.cache_stride_prefetch_hits;
+  stats[CS_GETS] = d.get + d.get_nb;
+  stats[CS_PUTS] = d.put + d.put_nb;
+}
+
+static inline int cs_enabled(void) {
+  return chpl_cache_enabled();
+}
@@ -0,0 +1,37 @@
+// Iterations of a forall that read two or more pieces of remote data
+// prefetch them together.  Serial loops are left alone, and either way
+// the values read have to be right.
+
+config const n = 1000;
+
+var A, B: [0..#n] int;
+
+for i in 0..#n {
+  A[i] = i;
+  B[i] = 2 * i;
+}
+
+proc forallReads() {
+  var sum = 0;
+  on Locales[numLocales-1] {
+    var C: [0..#n] int;
+    forall i in 0..#n do
+      C[i] = A[i] + B[n-1-i];
+    sum = + reduce C;
+  }
+  return sum;
+}
+
+proc serialReads() {
+  var sum = 0;
+  on Locales[numLocales-1] {
+    var partial = 0;
+    for i in 0..#n do
+      partial += A[i] + B[n-1-i];
+    sum = partial;
+  }
+  return sum;
+}
+
+writeln(forallReads());
+writeln(serialReads());
@@ -0,0 +1,12 @@
+// Check that the remote cache works with a non-default geometry
+// chosen through the CHPL_RT_CACHE_* environment variables.
+
+config const n = 10000;
+
+var A: [1..n] int = 1..n;
+
+on Locales[numLocales-1] {
+  var sum = 0;
+  for a in A do sum += a;
+  writeln(sum == n*(n+1)/2);
+}
@@ -0,0 +1,23 @@
+// Read remote data with a fixed non-unit stride, forwards and backwards,
+// so that the remote cache's stride prefetcher kicks in, and check that
+// we still see the right values (including after remote updates).
+
+config const n = 100000;
+config const stride = 17;
+
+var A: [0..#n] int = 0..#n;
+
+proc check() {
+  const expect = + reduce [i in 0..#n by stride] A[i];
+  on Locales[numLocales-1] {
+    var fwd, bwd = 0;
+    for i in 0..#n by stride do fwd += A[i];
+    for i in 0..#n by -stride do bwd += A[i];
+    writeln(fwd == expect);
+    writeln(bwd == expect);
+  }
+}
+
+check();
+A += 1;
+check();
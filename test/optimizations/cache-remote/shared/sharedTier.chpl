@@ -0,0 +1,23 @@
+// Have every task on a locale read the same remote table through the
+// shared remote cache tier, and check that updates made between phases
+// (both remotely and from the reading locale itself) are seen.
+
+config const n = 10000;
+config const phases = 3;
+
+var Table: [0..#n] int = 0..#n;
+
+for phase in 0..#phases {
+  on Locales[numLocales-1] {
+    var ok: atomic bool = true;
+    coforall tid in 0..#here.maxTaskPar {
+      var sum = 0;
+      for i in 0..#n do sum += Table[i];
+      if sum != (+ reduce (0..#n)) + phase*n then ok.write(false);
+    }
+    writeln(ok.read());
+
+    // update the table from here; the next phase reads it from here too
+    for i in 0..#n do Table[i] += 1;
+  }
+}
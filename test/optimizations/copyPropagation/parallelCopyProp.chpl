@@ -0,0 +1,42 @@
+// Copy propagation runs over functions on several threads with
+// --optimization-threads.  Give it many functions full of copies and
+// check that the results don't depend on the thread count.
+
+record R {
+  var x, y: int;
+}
+
+proc copies(param p: int, a: int) {
+  var b = a;
+  var c = b;
+  var r = new R(c, p);
+  var s = r;
+  if c > p {
+    c = s.x - p;
+  } else {
+    var d = c;
+    c = d + s.y;
+  }
+  var e = c;
+  return e + s.x;
+}
+
+var total = 0;
+for param p in 1..64 {
+  total += copies(p, 40);
+}
+writeln(total);
+
+proc chain(n: int) {
+  var a = n;
+  var b = a;
+  var i = 0;
+  while i < b {
+    var c = a;
+    a = c + 1;
+    i += 1;
+  }
+  return a;
+}
+
+writeln(chain(10), " ", chain(0));
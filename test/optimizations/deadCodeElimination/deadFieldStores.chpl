@@ -0,0 +1,88 @@
+// Stores to a field that are overwritten before they can be read are
+// removed.  Check that the ones that can still be seen are kept.
+
+class C {
+  var f: int;
+  var g: int;
+}
+
+record R {
+  var f: int;
+  var g: int;
+}
+
+var calls = 0;
+
+proc next(): int {
+  calls += 1;
+  return calls * 10;
+}
+
+// The first store is dead
+proc overwritten() {
+  var a = new unmanaged C();
+  a.f = 1;
+  a.g = 5;
+  a.f = 2;
+  writeln("overwritten: ", a.f, " ", a.g);
+  delete a;
+}
+
+// The first store is read before the second one
+proc readBetween() {
+  var a = new unmanaged C();
+  a.f = 1;
+  const x = a.f;
+  a.f = 2;
+  writeln("readBetween: ", x, " ", a.f);
+  delete a;
+}
+
+// 'a' names a different object by the time of the second store
+proc rebound() {
+  var a = new unmanaged C();
+  var b = new unmanaged C();
+  const first = a;
+  a.f = 1;
+  a = b;
+  a.f = 2;
+  writeln("rebound: ", first.f, " ", b.f);
+  delete first, b;
+}
+
+// 'c' is the same object as 'a'
+proc aliased() {
+  var a = new unmanaged C();
+  var c = a;
+  a.f = 1;
+  c.f = 3;
+  const x = a.f;
+  a.f = 2;
+  writeln("aliased: ", x, " ", a.f);
+  delete a;
+}
+
+// The record is copied, field and all, between the stores
+proc copied() {
+  var r: R;
+  r.f = 1;
+  var s = r;
+  r.f = 2;
+  writeln("copied: ", s.f, " ", r.f);
+}
+
+// The stored value has a side effect that must still happen
+proc sideEffect() {
+  var a = new unmanaged C();
+  a.f = next();
+  a.f = 2;
+  writeln("sideEffect: ", calls, " ", a.f);
+  delete a;
+}
+
+overwritten();
+readBetween();
+rebound();
+aliased();
+copied();
+sideEffect();
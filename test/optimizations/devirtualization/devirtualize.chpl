@@ -0,0 +1,43 @@
+// Method calls that can only reach one method are made directly.  When
+// only one class at or below the receiver's type is ever allocated, the
+// call to its method is guarded by a class id test instead.
+
+class Animal {
+  proc sound(): int { return 0; }
+}
+
+class Dog : Animal {
+  override proc sound(): int { return 1; }
+}
+
+class Cat : Animal {
+  override proc sound(): int { return 2; }
+}
+
+class Kitten : Cat {
+  override proc sound(): int { return 3; }
+}
+
+class Bird : Animal { }
+
+// None of the overrides are at or below Bird
+proc birdSound(b: borrowed Bird) {
+  return b.sound();
+}
+
+// Kitten is the only class allocated at or below Cat
+proc catSound(c: borrowed Cat) {
+  return c.sound();
+}
+
+// Dog, Kitten and Bird are all allocated below Animal
+proc animalSound(a: borrowed Animal) {
+  return a.sound();
+}
+
+var dog = new Dog();
+var kitten = new Kitten();
+var bird = new Bird();
+
+writeln(birdSound(bird), " ", catSound(kitten));
+writeln(animalSound(dog), " ", animalSound(kitten), " ", animalSound(bird));
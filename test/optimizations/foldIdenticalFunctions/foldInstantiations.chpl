@@ -0,0 +1,25 @@
+// Instantiations whose generated code would be the same are folded into
+// one.  Ones that differ are kept, even when they only differ in a param
+// value or in which of two records with the same fields they use.
+
+// The body doesn't use 'p', so all three instantiations are the same
+proc ignoresParam(param p, x) {
+  return x * 2;
+}
+
+// The body does use 'p'
+proc usesParam(param p, x) {
+  return x * p;
+}
+
+record A { var x: int; }
+record B { var x: int; }
+
+proc getX(r) {
+  return r.x;
+}
+
+writeln(ignoresParam(1, 10), " ", ignoresParam(2, 20), " ",
+        ignoresParam(3, 30));
+writeln(usesParam(1, 10), " ", usesParam(2, 20), " ", usesParam(3, 30));
+writeln(getX(new A(4)), " ", getX(new B(5)));
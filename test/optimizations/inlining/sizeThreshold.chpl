@@ -0,0 +1,26 @@
+// --inline-size-threshold inlines small functions once everything they
+// call is inlined too.  Recursive functions and functions that call ones
+// that won't be inlined are left alone.
+
+proc square(x: int) {
+  return x * x;
+}
+
+// Inlined once square is
+proc fourth(x: int) {
+  return square(square(x));
+}
+
+proc fact(n: int): int {
+  if n <= 1 then return 1;
+  return n * fact(n - 1);
+}
+
+// Calls fact, which isn't inlined
+proc factPlusOne(n: int) {
+  return fact(n) + 1;
+}
+
+writeln(square(3), " ", square(4));
+writeln(fourth(2));
+writeln(fact(5), " ", factPlusOne(3));
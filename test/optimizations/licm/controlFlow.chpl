@@ -0,0 +1,77 @@
+config const n = 10;
+config const k = 3;
+
+// The def dominates the rest of the loop body, so it is hoisted
+proc straightLine() {
+  var sum = 0;
+  for i in 1..n {
+    const t = k * 7;
+    sum += t + i;
+  }
+  return sum;
+}
+
+// These defs don't dominate all of the loop's uses or exits
+proc conditionalDef() {
+  var sum = 0;
+  for i in 1..n {
+    var t = 0;
+    if i % 2 == 0 then t = k * k;
+    sum += t;
+  }
+  return sum;
+}
+
+proc earlyExit() {
+  var i = 0, last = 0;
+  while true {
+    i += 1;
+    if i > n then break;
+    last = k + 1;
+    last += i;
+  }
+  return (i, last);
+}
+
+proc withContinue() {
+  var sum = 0;
+  for i in 1..n {
+    if i % 3 == 0 then continue;
+    const t = k * 2;
+    sum += t;
+  }
+  return sum;
+}
+
+// The code after the loop can't be reached
+proc unreachable() {
+  var x = 0;
+  while true {
+    x += 1;
+    if x >= k then return x;
+  }
+  x = 5;
+  return -1;
+}
+
+// 'b' is invariant in both loops and 'a' only in the inner one
+proc nested() {
+  var total = 0;
+  var i = 0;
+  do {
+    for j in 1..n {
+      const a = i * k;
+      const b = k + 2;
+      total += a + b + j;
+    }
+    i += 1;
+  } while i < 3;
+  return total;
+}
+
+writeln(straightLine());
+writeln(conditionalDef());
+writeln(earlyExit());
+writeln(withContinue());
+writeln(unreachable());
+writeln(nested());
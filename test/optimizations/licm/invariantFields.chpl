@@ -0,0 +1,56 @@
+// Array metadata reads are hoisted out of loops that pass the array to
+// calls that can't reallocate it.  Loops that resize the array's domain
+// must still see the new metadata.
+
+config const n = 10;
+
+var D = {0..#n};
+var A: [D] int = [i in D] i;
+
+proc first(const ref X: [] int) {
+  return X[X.domain.low];
+}
+
+// Only reads A, including through a call
+proc readsOnly() {
+  var sum = 0;
+  for i in 0..#n do
+    sum += A[i] + first(A);
+  return sum;
+}
+
+proc grow(size: int) {
+  D = {0..#size};
+}
+
+// Reallocates A on every iteration, directly and through a call
+proc resizes() {
+  var sum = 0;
+  for i in 1..4 {
+    D = {0..#(n * i)};
+    A[n * i - 1] = i;
+    sum += A[n * i - 1];
+    grow(n * i + 1);
+    A[n * i] = 10 * i;
+    sum += A[n * i];
+  }
+  return sum;
+}
+
+var M: [1..3, 1..4] int;
+
+// Two-dimensional indexing in a nested loop
+proc nested() {
+  for i in 1..3 do
+    for j in 1..4 do
+      M[i, j] = i * 10 + j;
+  var sum = 0;
+  for i in 1..3 do
+    for j in 1..4 do
+      sum += M[i, j] * first(M[i, ..]);
+  return sum;
+}
+
+writeln(readsOnly());
+writeln(resizes(), " ", A.size);
+writeln(nested());
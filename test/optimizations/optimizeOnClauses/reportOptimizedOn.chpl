@@ -0,0 +1,20 @@
+var x = 0;
+
+proc fast() {
+  on Locales[1] { var y = 3; }
+}
+
+proc writesRemote() {
+  on Locales[1] { x = 5; }
+}
+
+proc loops() {
+  var total = 0;
+  on Locales[1] { var s = 0; for i in 1..10 do s += i; total = s; }
+  writeln(total);
+}
+
+fast();
+writesRemote();
+writeln(x);
+loops();
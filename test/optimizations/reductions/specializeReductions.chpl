@@ -0,0 +1,60 @@
+config const n = 100;
+
+// These accumulate with the operation itself
+proc ints() {
+  var s = 0, p = 1, lo = max(int), hi = min(int), a = -1, o = 0, x = 0;
+  forall i in 1..n with (+ reduce s, min reduce lo, max reduce hi,
+                         | reduce o, ^ reduce x) {
+    const v = (i * 37) % 101;
+    s reduce= i;
+    lo reduce= v;
+    hi reduce= v;
+    o reduce= 1 << (i % 8);
+    x reduce= i;
+  }
+  forall i in 1..10 with (* reduce p, & reduce a) {
+    p reduce= i;
+    a reduce= ~(1 << i);
+  }
+  writeln(s, " ", p, " ", lo, " ", hi, " ", a, " ", o, " ", x);
+}
+
+proc uints() {
+  var s: uint = 0, o: uint = 0;
+  forall i in 1..n with (+ reduce s, | reduce o) {
+    s reduce= i:uint;
+    o reduce= i:uint << 56;
+  }
+  writeln(s, " ", o);
+}
+
+proc reals() {
+  var s = 0.0, p = 1.0, lo = max(real), hi = min(real), im = 0.0i;
+  forall i in 1..n with (+ reduce s, min reduce lo, max reduce hi,
+                         + reduce im) {
+    s reduce= i / 2.0;
+    lo reduce= i - 50.5;
+    hi reduce= i * 0.25;
+    im reduce= i * 1.0i;
+  }
+  forall i in 1..10 with (* reduce p) do p reduce= 2.0;
+  writeln(s, " ", p, " ", lo, " ", hi, " ", im);
+}
+
+// These are left alone: complex sums and logical reductions
+proc leftAlone() {
+  var c = 0.0 + 0.0i, allPos = true;
+  forall i in 1..n with (+ reduce c, && reduce allPos) {
+    c reduce= i + (i * 2.0) * 1.0i;
+    allPos reduce= i > 0;
+  }
+  writeln(c, " ", allPos);
+}
+
+ints();
+uints();
+reals();
+leftAlone();
+
+var A: [1..n] int = 1..n;
+writeln(+ reduce A, " ", max reduce A, " ", min reduce (A * 3), " ", ^ reduce A);
@@ -0,0 +1,70 @@
+record Point {
+  var x, y: int;
+}
+
+record Nested {
+  var p: Point;
+  var t: (real, real);
+  var flag: bool;
+}
+
+// 9 * 8 = 72 bytes, over the default limit
+record Big {
+  var a, b, c, d, e, f, g, h, i: int;
+}
+
+// Small records read in a blocking on statement are forwarded by value
+proc readPoint(const ref p: Point) {
+  var sum = 0;
+  on Locales[numLocales-1] { sum = p.x + p.y; }
+  return sum;
+}
+
+proc readNested(const ref n: Nested) {
+  var sum = 0.0;
+  on Locales[numLocales-1] {
+    if n.flag then sum = n.p.x + n.p.y + n.t(1) + n.t(2);
+  }
+  return sum;
+}
+
+// These are left alone: a record over the limit, an on body that uses an
+// atomic, and an on statement that doesn't block
+proc readBig(const ref b: Big) {
+  var sum = 0;
+  on Locales[numLocales-1] { sum = b.a + b.e + b.i; }
+  return sum;
+}
+
+proc readWithAtomic(const ref p: Point, ref done: atomic bool) {
+  var sum = 0;
+  on Locales[numLocales-1] { done.waitFor(true); sum = p.x * p.y; }
+  return sum;
+}
+
+proc readBegin(const ref p: Point) {
+  var sum: sync int;
+  begin on Locales[numLocales-1] { sum.writeEF(p.x - p.y); }
+  return sum.readFE();
+}
+
+var p = new Point(3, 4);
+var n = new Nested(new Point(1, 2), (0.5, 0.25), true);
+var b = new Big(1, 2, 3, 4, 5, 6, 7, 8, 9);
+
+writeln(readPoint(p));
+writeln(readNested(n));
+writeln(readBig(b));
+
+// Another task changes the record before setting the flag, so the on
+// body has to read it after the atomic read
+var done: atomic bool;
+var q = new Point(1, 1);
+var prod = 0;
+cobegin with (ref prod) {
+  prod = readWithAtomic(q, done);
+  { q = new Point(5, 6); done.write(true); }
+}
+writeln(prod);
+
+writeln(readBegin(p));
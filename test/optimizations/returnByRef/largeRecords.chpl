@@ -0,0 +1,78 @@
+// Large plain records are returned through a reference argument, and the
+// caller's destination is passed directly when nothing else can see it
+// during the call.  The results have to be the same as returning by value.
+
+record R {
+  var a, b, c, d: int;
+}
+
+record Small {
+  var a, b: int;
+}
+
+proc make(x: int) {
+  var ret: R;
+  ret.a = x;
+  ret.b = x + 1;
+  ret.c = x + 2;
+  ret.d = x + 3;
+  return ret;
+}
+
+// Reads its argument while building the result
+proc swapped(r: R) {
+  var ret: R;
+  ret.a = r.d;
+  ret.b = r.c;
+  ret.c = r.b;
+  ret.d = r.a;
+  return ret;
+}
+
+proc pick(flag: bool) {
+  if flag then
+    return make(10);
+  else
+    return new R(-1, -2, -3, -4);
+}
+
+proc sumTo(n: int): R {
+  if n == 0 then
+    return new R(0, 0, 0, 0);
+
+  var r = sumTo(n - 1);
+  r.a += n;
+  r.d += 1;
+  return r;
+}
+
+proc makeSmall(x: int) {
+  return new Small(x, -x);
+}
+
+var g = make(1);
+
+// Reads the global it is assigned to
+proc swappedGlobal() {
+  var ret: R;
+  ret.a = g.d;
+  ret.b = g.c;
+  ret.c = g.b;
+  ret.d = g.a;
+  return ret;
+}
+
+proc test() {
+  var x = make(5);                 // x is new, so it can be passed
+  x = swapped(x);                  // x is passed in, so it can't be
+  var y = swapped(x);
+  writeln(x);
+  writeln(y);
+  writeln(pick(true), " ", pick(false));
+  writeln(sumTo(4));
+  writeln(makeSmall(3));
+}
+
+test();
+g = swappedGlobal();
+writeln(g);
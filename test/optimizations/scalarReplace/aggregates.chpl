@@ -0,0 +1,73 @@
+// Records and classes used only through their fields are scalar
+// replaced; ones that escape, or that inherit fields, are left alone.
+// Either way the results have to match.
+
+record Point {
+  var x, y: int;
+}
+
+class Counter {
+  var n: int;
+}
+
+class Base {
+  var a: int;
+}
+
+class Derived : Base {
+  var b: int;
+}
+
+// Only field accesses
+proc fieldsOnly(): int {
+  var p = new Point(3, 4);
+  p.x += 1;
+  return p.x * p.x + p.y * p.y;
+}
+
+proc scale(ref p: Point) {
+  p.x *= 10;
+}
+
+// Passed by reference
+proc passedByRef(): int {
+  var p = new Point(1, 2);
+  scale(p);
+  return p.x + p.y;
+}
+
+// Allocated and freed locally
+proc localClass(): int {
+  var c = new unmanaged Counter(5);
+  c.n += 2;
+  const result = c.n;
+  delete c;
+  return result;
+}
+
+var kept: unmanaged Counter?;
+
+// Stored in a global
+proc storedClass(): int {
+  var c = new unmanaged Counter(1);
+  kept = c;
+  c.n += 1;
+  return kept!.n;
+}
+
+// Has an inherited field
+proc subclass(): int {
+  var d = new unmanaged Derived(1, 2);
+  d.a += d.b;
+  const result = d.a;
+  delete d;
+  return result;
+}
+
+writeln(fieldsOnly());
+writeln(passedByRef());
+writeln(localClass());
+writeln(storedClass(), " ", kept!.n);
+writeln(subclass());
+
+delete kept;
@@ -0,0 +1,27 @@
+// Index arithmetic that changes by a fixed amount per iteration is
+// replaced by running sums, but not when a factor changes in the loop.
+
+config const n = 4, m = 5;
+
+proc flattened(n: int, m: int) {
+  var sum = 0;
+  for i in 0..n-1 {
+    for j in 0..m-1 {
+      sum += i*m + j;
+    }
+  }
+  return sum;
+}
+
+proc varyingFactor(n: int) {
+  var sum = 0;
+  var k = 1;
+  for i in 0..n-1 {
+    sum += i*k;
+    k += 1;
+  }
+  return sum;
+}
+
+writeln(flattened(n, m));
+writeln(varyingFactor(n));
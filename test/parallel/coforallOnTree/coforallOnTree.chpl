@@ -0,0 +1,53 @@
+var visits: [LocaleSpace] atomic int;
+var mismatches: atomic int;
+
+// These fan out through a spanning tree
+proc fanOut() {
+  coforall loc in Locales do on loc { visits[here.id].add(1); check(loc); }
+}
+
+proc fanOutBlock() {
+  coforall loc in Locales do on loc { const id = loc.id; visits[id].add(1); check(loc); }
+}
+
+// These are left alone: a task intent, a different target, a different
+// iterator, and a body that does more than the on statement
+proc withIntent() {
+  var total: atomic int;
+  coforall loc in Locales with (ref total) do on loc { total.add(1); visits[here.id].add(1); }
+  writeln(total.read());
+}
+
+proc otherTarget() {
+  coforall loc in Locales do on Locales[(loc.id + 1) % numLocales] { visits[here.id].add(1); }
+}
+
+proc overRange() {
+  coforall i in 0..#numLocales do on Locales[i] { visits[here.id].add(1); }
+}
+
+proc moreThanOn() {
+  coforall loc in Locales { const id = loc.id; on loc { visits[id].add(1); check(loc); } }
+}
+
+proc check(loc: locale) {
+  if loc.id != here.id then mismatches.add(1);
+}
+
+proc show() {
+  writeln(+ reduce [v in visits] v.read(), " ", mismatches.read());
+  for v in visits do v.write(0);
+}
+
+fanOut();
+show();
+fanOutBlock();
+show();
+withIntent();
+show();
+otherTarget();
+show();
+overRange();
+show();
+moreThanOn();
+show();
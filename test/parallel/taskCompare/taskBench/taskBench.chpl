@@ -0,0 +1,200 @@
+// Tasking layer microbenchmarks: begin spawn and join rate, coforall
+// fan-out at several widths, sync variable ping-pong, yield cost,
+// task-local data access, how fast unevenly spawned work gets spread
+// over the workers (which is what work stealing buys), and foralls with
+// regular and irregular work (to check that stealing doesn't cost the
+// regular ones anything).  These are meant to be compared across
+// CHPL_TASKS settings and thread counts; see the taskBench entry in
+// util/test/BENCHMARKS.
+
+use DynamicIters, Time;
+
+extern proc chpl_task_yield();
+extern proc chpl_task_getInfoChapel(): c_void_ptr;
+extern proc chpl_task_getNumThreads(): uint(32);
+
+config const printTimings = false;
+config const numTrials = 10000,      // spawn trials
+             pingPongIters = 100000,
+             yieldIters = 1000000,
+             tlsIters = 10000000,
+             stealTasks = 100000,
+             stealWork = 1000,       // loop trips per stolen task
+             loopIters = 100000,
+             loopWork = 1000;        // average loop trips per iteration
+
+// Fan-out widths, as multiples of maxTaskPar.
+config const widths = "1 2 4 16";
+
+proc report(what: string, units: string, value: real) {
+  if printTimings then
+    writef("%s (%s): %.4dr\n", what, units, value);
+}
+
+const nTasks = here.maxTaskPar;
+
+if printTimings then
+  writeln("maxTaskPar: ", nTasks, ", threads: ", chpl_task_getNumThreads());
+
+//
+// begin spawn and join: maxTaskPar begins, then wait for them.
+//
+{
+  var t: Timer;
+  t.start();
+  for 1..numTrials do
+    sync { for 1..nTasks do begin { } }
+  t.stop();
+  report("begin spawn+join rate", "Mtasks/s",
+         numTrials * nTasks / t.elapsed() / 1.0e6);
+}
+
+//
+// coforall fan-out at several widths.
+//
+for w in widths.split() {
+  const width = w: int * nTasks;
+  const trials = max(10, numTrials * nTasks / width);
+  var t: Timer;
+  t.start();
+  for 1..trials do
+    coforall 1..width { }
+  t.stop();
+  report("coforall fan-out, " + w + "x maxTaskPar", "usec",
+         1.0e6 * t.elapsed() / trials);
+}
+
+//
+// sync variable ping-pong between two tasks.
+//
+{
+  var ping, pong: sync bool;
+  var t: Timer;
+  t.start();
+  cobegin {
+    for 1..pingPongIters {
+      ping.writeEF(true);
+      pong.readFE();
+    }
+    for 1..pingPongIters {
+      ping.readFE();
+      pong.writeEF(true);
+    }
+  }
+  t.stop();
+  report("sync ping-pong round trip", "usec",
+         1.0e6 * t.elapsed() / pingPongIters);
+}
+
+//
+// chpl_task_yield(), alone and with every worker yielding at once.
+//
+{
+  var t: Timer;
+  t.start();
+  for 1..yieldIters do chpl_task_yield();
+  t.stop();
+  report("yield cost, 1 task", "nsec", 1.0e9 * t.elapsed() / yieldIters);
+
+  t.clear();
+  t.start();
+  coforall 1..nTasks do
+    for 1..yieldIters / nTasks do chpl_task_yield();
+  t.stop();
+  report("yield cost, " + nTasks:string + " tasks", "nsec",
+         1.0e9 * t.elapsed() / (yieldIters / nTasks));
+}
+
+//
+// Task-local data: the runtime's per-task Chapel info, which is where
+// serial state and the like live, alone and from every worker at once.
+//
+{
+  var p: c_void_ptr;
+  var t: Timer;
+  t.start();
+  for 1..tlsIters do p = chpl_task_getInfoChapel();
+  t.stop();
+  report("task-local data access, 1 task", "nsec",
+         1.0e9 * t.elapsed() / tlsIters);
+
+  t.clear();
+  t.start();
+  coforall 1..nTasks {
+    var q: c_void_ptr;
+    for 1..tlsIters / nTasks do q = chpl_task_getInfoChapel();
+  }
+  t.stop();
+  report("task-local data access, " + nTasks:string + " tasks", "nsec",
+         1.0e9 * t.elapsed() / (tlsIters / nTasks));
+}
+
+//
+// Unbalanced spawning: one task creates all the work, so how fast it
+// finishes depends on how quickly idle workers pick it up.
+//
+var stealSum: atomic int;
+{
+  var t: Timer;
+  t.start();
+  sync {
+    for i in 1..stealTasks do begin {
+      var x = i;
+      for 1..stealWork do x = (x * 1103515245 + 12345) % 2147483648;
+      stealSum.add(x & 1);
+    }
+  }
+  t.stop();
+  report("single-spawner task throughput", "Mtasks/s",
+         stealTasks / t.elapsed() / 1.0e6);
+}
+
+//
+// Foralls doing the same total work, either evenly over the iterations
+// or all in the first 1/16 of them.  The irregular work is run with a
+// dynamic iterator, and as a forall whose first iterations each run a
+// nested forall; in the latter, the inner loops' tasks all start out
+// on the few workers that got those outer iterations.
+//
+proc spin(i: int, trips: int) {
+  var x = i;
+  for 1..trips do x = (x * 1103515245 + 12345) % 2147483648;
+  return x & 1;
+}
+
+const heavyIters = max(1, loopIters / 16);
+var loopOk = true;
+{
+  var t: Timer;
+  var s = 0;
+  t.start();
+  forall i in 1..loopIters with (+ reduce s) do
+    s += spin(i, loopWork);
+  t.stop();
+  report("regular forall", "Miters/s", loopIters / t.elapsed() / 1.0e6);
+  loopOk &&= s <= loopIters;
+
+  t.clear();
+  s = 0;
+  t.start();
+  forall i in dynamic(1..loopIters, chunkSize=16) with (+ reduce s) do
+    if i <= heavyIters then s += spin(i, loopWork * 16);
+  t.stop();
+  report("irregular dynamic forall", "Miters/s",
+         loopIters / t.elapsed() / 1.0e6);
+  loopOk &&= s <= heavyIters;
+
+  t.clear();
+  s = 0;
+  t.start();
+  forall i in 1..loopIters with (+ reduce s) do
+    if i <= min(nTasks, heavyIters) then
+      forall j in 1..heavyIters * 16 / min(nTasks, heavyIters)
+          with (+ reduce s) do
+        s += spin(j, loopWork);
+  t.stop();
+  report("irregular nested forall", "Miters/s",
+         loopIters / t.elapsed() / 1.0e6);
+}
+
+writeln("done: ", stealSum.read() <= stealTasks && loopOk);
@@ -0,0 +1,130 @@
+#include "qio.h"
+#include "qio_regexp.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <limits>
+
+// How fast qio_regexp_channel_match scans a channel, in MB/s of text,
+// for a pattern that rarely matches and one that matches often.
+//
+// Usage: regexp_bench [--printTimings] [--mb=N]
+
+int printTimings = 0;
+int64_t mb = 16;
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+// A memory file of lines like "alpha beta=123 gamma delta=45 ..."
+// with "needle<n>" on every 1000th line.
+static qio_file_t* make_text(int64_t* len_out, int64_t* needles_out,
+                             int64_t* pairs_out)
+{
+  qio_file_t* f;
+  qio_channel_t* ch;
+  qioerr err;
+  char line[128];
+  int64_t i;
+
+  err = qio_file_open_mem_ext(&f, NULL,
+                              (qio_fdflag_t)(QIO_FDFLAG_READABLE|
+                                             QIO_FDFLAG_WRITEABLE|
+                                             QIO_FDFLAG_SEEKABLE), 0, NULL);
+  assert(!err);
+  err = qio_channel_create(&ch, f, 0, 0, 1, 0,
+                           std::numeric_limits<int64_t>::max(), NULL);
+  assert(!err);
+
+  *needles_out = 0;
+  *pairs_out = 0;
+  for( i = 0; qio_channel_offset_unlocked(ch) < mb * 1024 * 1024; i++ ) {
+    int len;
+    if( i % 1000 == 999 ) {
+      len = snprintf(line, sizeof(line), "the needle%lld is here\n",
+                     (long long) i);
+      (*needles_out)++;
+    } else {
+      len = snprintf(line, sizeof(line),
+                     "alpha beta=%lld gamma delta=%lld epsilon zeta\n",
+                     (long long) i, (long long) (i % 97));
+      *pairs_out += 2;
+    }
+    err = qio_channel_write_amt(false, ch, line, len);
+    assert(!err);
+  }
+  *len_out = qio_channel_offset_unlocked(ch);
+  qio_channel_release(ch);
+  return f;
+}
+
+// Count the matches of 'pattern' in the file, one channel match at a time.
+static int64_t scan(qio_file_t* f, int64_t len, const char* pattern,
+                    const char* what)
+{
+  qio_regexp_t compiled;
+  qio_regexp_string_piece_t submatch[1];
+  qio_channel_t* ch;
+  int64_t count = 0;
+  qioerr err;
+  double t;
+
+  qio_regexp_create_compile_flags(pattern, strlen(pattern), "", 0, false,
+                                  &compiled);
+  assert(compiled.regexp);
+
+  err = qio_channel_create(&ch, f, 0, 1, 0, 0, len, NULL);
+  assert(!err);
+
+  t = now();
+  while( 1 ) {
+    err = qio_channel_mark(false, ch);
+    assert(!err);
+    err = qio_regexp_channel_match(&compiled, false, ch,
+                                   std::numeric_limits<int64_t>::max(),
+                                   QIO_REGEXP_ANCHOR_UNANCHORED,
+                                   true, false, false, submatch, 1);
+    qio_channel_commit_unlocked(ch);
+    if( err ) break;
+    count++;
+  }
+  t = now() - t;
+  assert(qio_err_to_int(err) == EFORMAT);
+
+  if( printTimings ) {
+    printf("regexp scan, %s (MB/s): %.2f\n", what, len / t / 1.0e6);
+  }
+
+  qio_channel_release(ch);
+  qio_regexp_release(&compiled);
+  return count;
+}
+
+int main(int argc, char** argv)
+{
+  int64_t len, needles, pairs;
+  qio_file_t* f;
+  int i;
+
+  for( i = 1; i < argc; i++ ) {
+    if( 0 == strcmp(argv[i], "--printTimings") ) printTimings = 1;
+    else if( 0 == strncmp(argv[i], "--mb=", 5) ) mb = atoll(argv[i] + 5);
+  }
+
+  f = make_text(&len, &needles, &pairs);
+
+  assert(scan(f, len, "needle[0-9]+", "sparse") == needles);
+  assert(scan(f, len, "[a-z]+=[0-9]+", "dense") == pairs);
+
+  qio_file_release(f);
+
+  printf("regexp_bench PASS\n");
+
+  return 0;
+}
@@ -0,0 +1,41 @@
+// Call the runtime all-gather and all-reduce collectives directly from
+// one task on each locale and check the results.
+
+extern type chpl_comm_coll_type_t = c_int;
+extern type chpl_comm_coll_op_t = c_int;
+extern const CHPL_COMM_COLL_INT64: chpl_comm_coll_type_t;
+extern const CHPL_COMM_COLL_REAL64: chpl_comm_coll_type_t;
+extern const CHPL_COMM_COLL_SUM: chpl_comm_coll_op_t;
+extern const CHPL_COMM_COLL_MAX: chpl_comm_coll_op_t;
+
+extern proc chpl_comm_allgather(dst: c_void_ptr, src: c_void_ptr,
+                                size: size_t);
+extern proc chpl_comm_allreduce(dst: c_void_ptr, src: c_void_ptr,
+                                count: size_t,
+                                ty: chpl_comm_coll_type_t,
+                                op: chpl_comm_coll_op_t);
+
+var ok: [LocaleSpace] bool;
+
+coforall loc in Locales do on loc {
+  var mine = here.id: int;
+  var all: [0..numLocales-1] int;
+  chpl_comm_allgather(c_ptrTo(all), c_ptrTo(mine), numBytes(int): size_t);
+  var good = && reduce [i in 0..numLocales-1] all[i] == i;
+
+  var vals = [here.id: int, 1];
+  var sums: [0..1] int;
+  chpl_comm_allreduce(c_ptrTo(sums), c_ptrTo(vals), 2: size_t,
+                      CHPL_COMM_COLL_INT64, CHPL_COMM_COLL_SUM);
+  good = good && sums[0] == numLocales * (numLocales - 1) / 2
+           && sums[1] == numLocales;
+
+  var r = here.id: real, rmax: real;
+  chpl_comm_allreduce(c_ptrTo(rmax), c_ptrTo(r), 1: size_t,
+                      CHPL_COMM_COLL_REAL64, CHPL_COMM_COLL_MAX);
+  good = good && rmax == (numLocales - 1): real;
+
+  ok[here.id] = good;
+}
+
+writeln(&& reduce ok);
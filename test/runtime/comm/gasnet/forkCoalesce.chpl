@@ -0,0 +1,20 @@
+// With fork request coalescing on, have many tasks do small blocking
+// and non-blocking on-stmts to the same locale at once, and check that
+// every one of them runs exactly once.
+
+config const tasksPerLocale = 64;
+config const iters = 1000;
+
+var cnt: atomic int;
+
+coforall 0..#tasksPerLocale {
+  for 0..#iters do
+    on Locales[numLocales-1] do cnt.add(1);
+}
+
+coforall 0..#tasksPerLocale {
+  coforall 0..#4 do
+    on Locales[numLocales-1] do cnt.add(1);
+}
+
+writeln(cnt.read() == tasksPerLocale * (iters + 4));
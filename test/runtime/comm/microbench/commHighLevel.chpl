@@ -0,0 +1,154 @@
+// Chapel-level counterparts of the measurements in commLowLevel.chpl,
+// between locale 0 and the last locale: remote element read and write
+// latency, bulk slice transfer bandwidth, on-stmt round trips, remote
+// atomic rates, unordered remote writes from a forall, and barriers.
+// Comparing the two shows what the compiler and modules add on top of
+// the comm layer.
+
+use Time, BlockDist;
+
+extern proc chpl_comm_barrier(msg: c_string);
+
+config const printTimings = false;
+config const minSize = 8,
+             maxSize = 4 * 1024 * 1024;
+config const latencyIters = 10000,
+             rateIters = 100000,
+             barrierIters = 1000;
+
+const target = numLocales - 1;
+
+var local: [0..#maxSize] uint(8);
+var remoteDom = {0..#maxSize} dmapped Block({0..#maxSize},
+                                            targetLocales=[Locales[target]]);
+var remote: [remoteDom] uint(8);
+var counter: [{0..0} dmapped Block({0..0},
+                                   targetLocales=[Locales[target]])] atomic int;
+
+proc report(what: string, units: string, value: real) {
+  if printTimings then
+    writef("%s (%s): %.4dr\n", what, units, value);
+}
+
+proc itersFor(size: int, iters: int) {
+  return max(10, iters / max(1, size / 65536));
+}
+
+//
+// Single remote element reads and writes.
+//
+{
+  var t: Timer;
+  var x: uint(8);
+  t.start();
+  for i in 0..#latencyIters do remote[i % 8] = i: uint(8);
+  t.stop();
+  report("remote write latency", "usec", 1.0e6 * t.elapsed() / latencyIters);
+
+  t.clear();
+  t.start();
+  for i in 0..#latencyIters do x ^= remote[i % 8];
+  t.stop();
+  report("remote read latency", "usec", 1.0e6 * t.elapsed() / latencyIters);
+}
+
+//
+// Bulk slice assignment, by size.
+//
+var size = minSize;
+while size <= maxSize {
+  const n = itersFor(size, latencyIters);
+  var t: Timer;
+  t.start();
+  for 1..n do remote[0..#size] = local[0..#size];
+  t.stop();
+  report("slice put bandwidth, " + size:string + " bytes", "MB/s",
+         n * size / t.elapsed() / 1.0e6);
+
+  t.clear();
+  t.start();
+  for 1..n do local[0..#size] = remote[0..#size];
+  t.stop();
+  report("slice get bandwidth, " + size:string + " bytes", "MB/s",
+         n * size / t.elapsed() / 1.0e6);
+  size *= 4;
+}
+
+//
+// Empty on-stmts, blocking and from many tasks at once.
+//
+{
+  var t: Timer;
+  t.start();
+  for 1..latencyIters do on Locales[target] do ;
+  t.stop();
+  report("on-stmt round trip", "usec", 1.0e6 * t.elapsed() / latencyIters);
+
+  const nTasks = here.maxTaskPar;
+  t.clear();
+  t.start();
+  coforall 1..nTasks do
+    for 1..latencyIters / 10 do on Locales[target] do ;
+  t.stop();
+  report("on-stmt rate", "Kons/s",
+         nTasks * (latencyIters / 10) / t.elapsed() / 1.0e3);
+}
+
+//
+// Remote atomic adds, from one task and from many.
+//
+{
+  var t: Timer;
+  t.start();
+  for 1..rateIters do counter[0].add(1);
+  t.stop();
+  report("remote atomic add rate, 1 task", "Mops/s",
+         rateIters / t.elapsed() / 1.0e6);
+
+  const nTasks = here.maxTaskPar;
+  t.clear();
+  t.start();
+  coforall 1..nTasks do
+    for 1..rateIters do counter[0].add(1);
+  t.stop();
+  report("remote atomic add rate, " + nTasks:string + " tasks", "Mops/s",
+         nTasks * rateIters / t.elapsed() / 1.0e6);
+
+  t.clear();
+  t.start();
+  for 1..latencyIters do counter[0].fetchAdd(1);
+  t.stop();
+  report("remote atomic fetch-add latency", "usec",
+         1.0e6 * t.elapsed() / latencyIters);
+}
+
+//
+// Remote writes from a forall, which the compiler can make unordered.
+//
+{
+  const n = min(rateIters, maxSize);
+  var t: Timer;
+  t.start();
+  forall i in 0..#n do remote[i] = i: uint(8);
+  t.stop();
+  report("forall remote write rate", "Mops/s", n / t.elapsed() / 1.0e6);
+}
+
+//
+// Barriers, which every locale has to take part in.
+//
+var barrierTime: real;
+coforall loc in Locales with (ref barrierTime) do on loc {
+  var t: Timer;
+  t.start();
+  for 1..barrierIters do chpl_comm_barrier(c"commHighLevel");
+  t.stop();
+  if here.id == 0 then barrierTime = t.elapsed() / barrierIters;
+}
+report("barrier time", "usec", 1.0e6 * barrierTime);
+
+local[0] = 42;
+remote[0..0] = local[0..0];
+writeln("done: ", remote[0] == 42 &&
+                  counter[0].read() == (1 + here.maxTaskPar) * rateIters
+                                       + latencyIters);
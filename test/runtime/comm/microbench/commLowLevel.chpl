@@ -0,0 +1,145 @@
+// Comm layer microbenchmarks, between locale 0 and the last locale,
+// using the C kernels in commLowLevel.h: PUT/GET latency and bandwidth
+// over a range of sizes, small-message rate from many tasks, unordered
+// op throughput, network AMO rates where the comm layer has them, and
+// barrier time.  See commHighLevel.chpl for the same things done in
+// Chapel.
+
+use Time, CPtr;
+
+require "commLowLevel.h";
+
+extern proc cb_put_latency(laddr: c_void_ptr, node: int(32),
+                           raddr: c_void_ptr, size: int, iters: int): real;
+extern proc cb_get_latency(laddr: c_void_ptr, node: int(32),
+                           raddr: c_void_ptr, size: int, iters: int): real;
+extern proc cb_nb_time(isPut: c_int, laddr: c_void_ptr, node: int(32),
+                       raddr: c_void_ptr, size: int, iters: int,
+                       window: c_int): real;
+extern proc cb_unordered_time(isPut: c_int, laddr: c_void_ptr, node: int(32),
+                              raddr: c_void_ptr, size: int,
+                              iters: int): real;
+extern proc cb_barrier_time(iters: int): real;
+extern proc cb_have_native_amos(): c_int;
+extern proc cb_amo_add_time(unordered: c_int, node: int(32),
+                            raddr: c_void_ptr, iters: int): real;
+extern proc cb_amo_fetch_add_time(node: int(32), raddr: c_void_ptr,
+                                  iters: int): real;
+
+config const printTimings = false;
+config const minSize = 8,
+             maxSize = 4 * 1024 * 1024;
+config const latencyIters = 10000,   // per size, scaled down for big ones
+             rateIters = 100000,     // per task, for small-message rates
+             barrierIters = 1000;
+config const window = 64;            // non-blocking ops in flight
+
+const target = numLocales - 1;
+const targetNode = target: int(32);
+
+class Buf {
+  var bytes: [0..#maxSize] uint(8);
+  var word: [0..#1] int;
+}
+
+// Remote and local buffers, and their raw addresses.
+var remote: unmanaged Buf?;
+var raddr, rword: c_void_ptr;
+on Locales[target] {
+  remote = new unmanaged Buf();
+  raddr = c_ptrTo(remote!.bytes[0]): c_void_ptr;
+  rword = c_ptrTo(remote!.word[0]): c_void_ptr;
+}
+
+var local = new unmanaged Buf();
+const laddr = c_ptrTo(local.bytes[0]): c_void_ptr;
+
+proc report(what: string, units: string, value: real) {
+  if printTimings then
+    writef("%s (%s): %.4dr\n", what, units, value);
+}
+
+proc itersFor(size: int, iters: int) {
+  // Keep the bytes moved at each size roughly the same past 64 KiB.
+  return max(10, iters / max(1, size / 65536));
+}
+
+//
+// Latency and bandwidth, by size.
+//
+var size = minSize;
+while size <= maxSize {
+  const n = itersFor(size, latencyIters);
+  report("put latency, " + size:string + " bytes", "usec",
+         1.0e6 * cb_put_latency(laddr, targetNode, raddr, size, n));
+  report("get latency, " + size:string + " bytes", "usec",
+         1.0e6 * cb_get_latency(laddr, targetNode, raddr, size, n));
+  report("put bandwidth, " + size:string + " bytes", "MB/s",
+         size / cb_nb_time(1, laddr, targetNode, raddr, size, n,
+                           window: c_int) / 1.0e6);
+  report("get bandwidth, " + size:string + " bytes", "MB/s",
+         size / cb_nb_time(0, laddr, targetNode, raddr, size, n,
+                           window: c_int) / 1.0e6);
+  size *= 4;
+}
+
+//
+// Small-message rate: 8-byte non-blocking PUTs and GETs from every
+// task at once, each with its own 8 bytes at both ends.
+//
+proc msgRate(isPut: c_int) {
+  const nTasks = min(here.maxTaskPar, maxSize / 8);
+  var t: Timer;
+  t.start();
+  coforall tid in 0..#nTasks {
+    const off = tid * 8;
+    cb_nb_time(isPut, (laddr: c_ptr(uint(8)) + off): c_void_ptr, targetNode,
+               (raddr: c_ptr(uint(8)) + off): c_void_ptr, 8, rateIters,
+               window: c_int);
+  }
+  t.stop();
+  return nTasks * rateIters / t.elapsed() / 1.0e6;
+}
+
+report("put message rate, 8 bytes", "Mmsgs/s", msgRate(1));
+report("get message rate, 8 bytes", "Mmsgs/s", msgRate(0));
+
+//
+// Unordered ops.
+//
+report("unordered put rate, 8 bytes", "Mops/s",
+       1.0e-6 / cb_unordered_time(1, laddr, targetNode, raddr, 8, rateIters));
+report("unordered get rate, 8 bytes", "Mops/s",
+       1.0e-6 / cb_unordered_time(0, laddr, targetNode, raddr, 8, rateIters));
+
+//
+// Network atomics.
+//
+if cb_have_native_amos() != 0 {
+  report("AMO add rate", "Mops/s",
+         1.0e-6 / cb_amo_add_time(0, targetNode, rword, rateIters));
+  report("unordered AMO add rate", "Mops/s",
+         1.0e-6 / cb_amo_add_time(1, targetNode, rword, rateIters));
+  report("AMO fetch-add latency", "usec",
+         1.0e6 * cb_amo_fetch_add_time(targetNode, rword, latencyIters));
+} else if printTimings {
+  writeln("(no network AMOs in this comm layer)");
+}
+
+//
+// Barrier, which every locale has to take part in.
+//
+var barrierTime: real;
+coforall loc in Locales with (ref barrierTime) do on loc {
+  const t = cb_barrier_time(barrierIters);
+  if here.id == 0 then barrierTime = t;
+}
+report("barrier time", "usec", 1.0e6 * barrierTime);
+
+// The transfers went to and from the same bytes, so check one made it.
+local.bytes[0] = 42;
+cb_put_latency(laddr, targetNode, raddr, 1, 1);
+writeln("done: ", remote!.bytes[0] == 42);
+
+delete local;
+on Locales[target] do delete remote;
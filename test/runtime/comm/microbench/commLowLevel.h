@@ -0,0 +1,161 @@
+//
+// Comm layer microbenchmark kernels, called from commLowLevel.chpl.
+// These go straight to the runtime's comm interface, so they measure
+// the comm layer itself rather than whatever the compiler and modules
+// turn a Chapel statement into.  The blocking and unordered transfers
+// use the same chpl_gen_comm_*() entry points as generated code, so run
+// without the remote cache.  Times are in seconds.
+//
+
+#include <stdint.h>
+#include <time.h>
+
+#include "chpl-comm.h"
+#include "chpl-comm-compiler-macros.h"
+
+#define CB_MAX_WINDOW 64
+
+static inline double cb_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static inline void cb_wait_all(chpl_comm_nb_handle_t* h, int n) {
+  int i;
+  for (i = 0; i < n; i++) {
+    while (!chpl_comm_test_nb_complete(h[i]))
+      chpl_comm_wait_nb_some(&h[i], n - i);
+  }
+}
+
+// Time per blocking PUT or GET of 'size' bytes.
+static inline double cb_put_latency(void* laddr, int32_t node, void* raddr,
+                                    int64_t size, int64_t iters) {
+  double t = cb_now();
+  int64_t i;
+  for (i = 0; i < iters; i++)
+    chpl_gen_comm_put(laddr, node, raddr, size, -1, 0, 0);
+  return (cb_now() - t) / iters;
+}
+
+static inline double cb_get_latency(void* laddr, int32_t node, void* raddr,
+                                    int64_t size, int64_t iters) {
+  double t = cb_now();
+  int64_t i;
+  for (i = 0; i < iters; i++)
+    chpl_gen_comm_get(laddr, node, raddr, size, -1, 0, 0);
+  return (cb_now() - t) / iters;
+}
+
+//
+// Time per non-blocking PUT or GET of 'size' bytes, with up to 'window'
+// of them in flight.  The bandwidth is size / this, and with small
+// sizes and many calling tasks, 1 / this is the message rate.
+//
+static inline double cb_nb_time(int isPut, void* laddr, int32_t node,
+                                void* raddr, int64_t size, int64_t iters,
+                                int window) {
+  chpl_comm_nb_handle_t h[CB_MAX_WINDOW];
+  double t;
+  int64_t i;
+  int n = 0;
+
+  if (window < 1)
+    window = 1;
+  if (window > CB_MAX_WINDOW)
+    window = CB_MAX_WINDOW;
+
+  t = cb_now();
+  for (i = 0; i < iters; i++) {
+    h[n++] = isPut
+             ? chpl_comm_put_nb(laddr, node, raddr, size, -1, 0, 0)
+             : chpl_comm_get_nb(laddr, node, raddr, size, -1, 0, 0);
+    if (n == window) {
+      cb_wait_all(h, n);
+      n = 0;
+    }
+  }
+  cb_wait_all(h, n);
+  return (cb_now() - t) / iters;
+}
+
+//
+// Time per unordered PUT or GET of 'size' bytes, including the fence
+// that makes them all visible at the end.
+//
+static inline double cb_unordered_time(int isPut, void* laddr, int32_t node,
+                                       void* raddr, int64_t size,
+                                       int64_t iters) {
+  double t = cb_now();
+  int64_t i;
+  for (i = 0; i < iters; i++) {
+    if (isPut)
+      chpl_gen_comm_put_unordered(laddr, node, raddr, size, -1, 0, 0);
+    else
+      chpl_gen_comm_get_unordered(laddr, node, raddr, size, -1, 0, 0);
+  }
+  chpl_gen_comm_getput_unordered_task_fence();
+  return (cb_now() - t) / iters;
+}
+
+// Time per barrier.  Every locale has to call this, with the same iters.
+static inline double cb_barrier_time(int64_t iters) {
+  double t = cb_now();
+  int64_t i;
+  for (i = 0; i < iters; i++)
+    chpl_comm_barrier("commLowLevel");
+  return (cb_now() - t) / iters;
+}
+
+//
+// Network atomics, for the comm layers that have them (these declare
+// them in chpl-comm-native-atomics.h, which chpl-comm.h pulls in).
+// Without them these return 0 and the program says so.
+//
+static inline int cb_have_native_amos(void) {
+#ifdef _chpl_comm_native_atomics_h_
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+// Time per non-fetching atomic add: blocking, or unordered plus a fence.
+static inline double cb_amo_add_time(int unordered, int32_t node,
+                                     void* raddr, int64_t iters) {
+#ifdef _chpl_comm_native_atomics_h_
+  int64_t one = 1;
+  double t = cb_now();
+  int64_t i;
+  for (i = 0; i < iters; i++) {
+    if (unordered)
+      chpl_comm_atomic_add_unordered_int64(&one, node, raddr, 0, 0);
+    else
+      chpl_comm_atomic_add_int64(&one, node, raddr, memory_order_seq_cst,
+                                 0, 0);
+  }
+  if (unordered)
+    chpl_comm_atomic_unordered_task_fence();
+  return (cb_now() - t) / iters;
+#else
+  return 0.0;
+#endif
+}
+
+// Time per fetching atomic add, which is a full round trip.
+static inline double cb_amo_fetch_add_time(int32_t node, void* raddr,
+                                           int64_t iters) {
+#ifdef _chpl_comm_native_atomics_h_
+  int64_t one = 1;
+  int64_t old;
+  double t = cb_now();
+  int64_t i;
+  for (i = 0; i < iters; i++)
+    chpl_comm_atomic_fetch_add_int64(&one, node, raddr, &old,
+                                     memory_order_seq_cst, 0, 0);
+  return (cb_now() - t) / iters;
+#else
+  return 0.0;
+#endif
+}
@@ -0,0 +1,21 @@
+// With non-fetching AMO aggregation, do lots of remote adds, subs, and
+// bitwise ops on a few hot counters and check that none are lost and
+// that they're visible after each task ends.
+
+config const n = 10000;
+
+var counts: [0..3] atomic int;
+var bits: atomic uint;
+
+on Locales[numLocales - 1] {
+  coforall t in 0..3 {
+    for i in 1..n {
+      counts[i % 4].add(2);
+      counts[(i + 1) % 4].sub(1);
+    }
+    bits.or(1:uint << t);
+  }
+}
+
+writeln((+ reduce [c in counts] c.read()) == 4 * n);
+writeln(bits.read() == 0xf);
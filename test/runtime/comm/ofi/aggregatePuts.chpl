@@ -0,0 +1,20 @@
+// With PUT aggregation on, do many small remote writes (including
+// repeated writes to the same element, and reads and atomics mixed in)
+// and check that every one of them is seen, in program order.
+
+config const n = 10000;
+
+var A: [0..#n] int;
+var flag: atomic int;
+
+on Locales[numLocales-1] {
+  for i in 0..#n {
+    A[i] = -1;
+    A[i] = i;            // must land after the write above
+    if i % 1000 == 999 then
+      if A[i] != i then writeln("read-after-write mismatch at ", i);
+  }
+  flag.write(1);         // A must be fully written before the flag
+}
+
+writeln(flag.read() == 1 && (&& reduce (A == 0..#n)));
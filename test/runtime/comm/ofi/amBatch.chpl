@@ -0,0 +1,22 @@
+// With AM batching on, start a lot of nonblocking on-stmts and do a lot
+// of remote non-fetching atomics, and check that all of them happen.
+
+config const n = 1000;
+
+var count: atomic int;
+var total: atomic int;
+
+sync {
+  for i in 1..n do
+    begin on Locales[i % numLocales] {
+      count.add(1);
+      total.add(i);
+    }
+}
+
+on Locales[numLocales-1] {
+  for i in 1..n do
+    count.add(1);
+}
+
+writeln(count.read() == 2 * n && total.read() == n * (n + 1) / 2);
@@ -0,0 +1,22 @@
+// Run a lot of comm-layer barriers using the dissemination algorithm
+// and check that no locale gets past a barrier before all of them
+// have reached it.
+
+extern proc chpl_comm_barrier(msg: c_string);
+
+config const n = 1000;
+
+var arrived: [LocaleSpace] atomic int;
+var ok: [LocaleSpace] bool = true;
+
+coforall loc in Locales do on loc {
+  for i in 1..n {
+    arrived[here.id].write(i);
+    chpl_comm_barrier(c"test");
+    for a in arrived do
+      if a.read() < i then ok[here.id] = false;
+    chpl_comm_barrier(c"test");
+  }
+}
+
+writeln(&& reduce ok);
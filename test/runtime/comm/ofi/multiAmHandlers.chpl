@@ -0,0 +1,16 @@
+// With more than one AM handler per node, do on-stmts and remote
+// atomics in both directions and check that all of them happen.
+
+config const n = 1000;
+
+var counts: [LocaleSpace] atomic int;
+
+coforall loc in Locales do on loc {
+  const other = Locales[(here.id + 1) % numLocales];
+  for i in 1..n do
+    on other do counts[here.id].add(1);
+  for i in 1..n do
+    counts[other.id].add(1);
+}
+
+writeln(&& reduce [c in counts] c.read() == 2 * n);
@@ -0,0 +1,29 @@
+// With vectored strided transfers on, do strided GETs and PUTs big
+// enough to need several batches and check that every element arrives.
+
+config const n = 300;
+
+var A: [1..n, 1..n] int;
+forall (i,j) in A.domain do A[i,j] = i * n + j;
+
+on Locales[numLocales-1] {
+  var B: [1..n, 1..n] int;
+
+  // strided GET: every other row, every third column
+  B[1..n by 2, 1..n by 3] = A[1..n by 2, 1..n by 3];
+  var ok = true;
+  for (i,j) in {1..n by 2, 1..n by 3} do
+    if B[i,j] != i * n + j then ok = false;
+  writeln(ok);
+
+  // strided PUT: negate the same elements back on locale 0
+  B[1..n by 2, 1..n by 3] = -B[1..n by 2, 1..n by 3];
+  A[1..n by 2, 1..n by 3] = B[1..n by 2, 1..n by 3];
+}
+
+var ok = true;
+for (i,j) in A.domain {
+  const expect = if i % 2 == 1 && j % 3 == 1 then -(i * n + j) else i * n + j;
+  if A[i,j] != expect then ok = false;
+}
+writeln(ok);
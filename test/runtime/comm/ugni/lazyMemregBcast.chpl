@@ -0,0 +1,28 @@
+// With lazy memory registration broadcasts on, repeatedly allocate
+// arrays big enough to get their own registered regions on every
+// locale, and have each locale access another locale's part, which is
+// in a region it hasn't heard about yet.
+
+use BlockDist;
+
+config const n = 4 * 1024 * 1024;
+config const rounds = 4;
+
+var ok: atomic bool;
+ok.write(true);
+
+for 1..rounds {
+  const D = {0..#n} dmapped Block({0..#n});
+  var A: [D] int;
+  forall i in D do A[i] = i;
+  coforall loc in Locales do on loc {
+    const other = Locales[(here.id + 1) % numLocales];
+    const i = A.localSubdomain(other).low;
+    if A[i] != i then ok.write(false);
+    A[i] = -i;
+  }
+  forall i in D do
+    if A[i] != i && A[i] != -i then ok.write(false);
+}
+
+writeln(ok.read());
@@ -0,0 +1,53 @@
+// A compile-time stress test for resolution: numTypes instantiations of
+// a generic record, each used with generic procs, methods, iterators
+// and a generic class hierarchy, so the work the compiler does grows
+// with numTypes.  Compile with -snumTypes=N to scale it.
+
+config param numTypes = 100;
+
+record R {
+  param k: int;
+  type eltType;
+  var data: numTypes*eltType;
+
+  proc sum() {
+    var s: eltType;
+    for param i in 0..numTypes-1 do s += data(i);
+    return s;
+  }
+
+  iter these() {
+    for x in data do yield x;
+  }
+}
+
+class Base {
+  proc value(): int { return 0; }
+}
+
+class Derived: Base {
+  param k: int;
+  override proc value(): int { return k; }
+}
+
+proc combine(a: R(?k, ?t), b: R(k, t)) {
+  var c: R(k, t);
+  for param i in 0..numTypes-1 do c.data(i) = a.data(i) + b.data(i);
+  return c;
+}
+
+proc check(param k: int) {
+  var a: R(k, if k % 2 == 0 then int else real);
+  for param i in 0..numTypes-1 do a.data(i) = i: a.eltType;
+  const b = combine(a, a);
+  var total = 0.0;
+  for x in b do total += x;
+  const d: owned Base = new owned Derived(k);
+  return total == 2 * a.sum() && d.value() == k;
+}
+
+var ok = true;
+for param k in 1..numTypes do
+  ok &&= check(k);
+
+writeln(ok);
@@ -0,0 +1,118 @@
+#ifndef QT_IDLE_H
+#define QT_IDLE_H
+
+#include "qthread/qtimer.h"
+
+#include "qt_visibility.h"
+#include "qt_envariables.h"
+#include "qt_shepherd_innards.h"
+
+/* Spin-then-park bookkeeping for idle workers.
+ *
+ * A worker that finds its queue empty spins for up to a spin limit and
+ * then parks on a condition variable until work is enqueued.  A long
+ * fixed limit burns cycles that other threads (e.g. a communication
+ * layer's progress thread) could use; a short one pays for a wakeup
+ * whenever work turns up just after the worker parked.
+ *
+ * With QT_SPIN_ADAPTIVE set, each worker tunes its own limit from how
+ * its idle periods end:
+ *  - work turned up while spinning, after more than half the limit:
+ *    the next wait may well be longer, so double the limit;
+ *  - the worker parked, but work came within the time it had already
+ *    spent spinning: spinning twice as long would have caught it, so
+ *    double the limit;
+ *  - the worker parked for longer than that: the spinning was wasted,
+ *    so halve the limit.
+ * The limit stays between QT_SPINCOUNT_MIN and the scheduler's fixed
+ * limit, and since it moves by factors of two a worker follows a job
+ * from a latency-bound phase to a throughput-bound one (or back) within
+ * a few idle periods.
+ *
+ * Either way, each worker adds up the time it spends spinning and
+ * parked; see qthread_idle_stats(). */
+
+typedef struct {
+    unsigned long min;      /* smallest adaptive limit */
+    unsigned long max;      /* largest adaptive limit, or the fixed one */
+    int           adaptive;
+} qt_idle_policy_t;
+
+typedef struct {
+    qthread_worker_t *worker;
+    double            start;      /* when the worker went idle */
+    double            park_start; /* when it last parked */
+    double            parked;     /* total time parked so far */
+    unsigned long     limit;      /* spins allowed before parking */
+} qt_idle_t;
+
+static QINLINE void qt_idle_policy_init(qt_idle_policy_t *p,
+                                        unsigned long     max,
+                                        unsigned long     dflt_min)
+{   /*{{{*/
+    p->max      = max;
+    p->min      = qt_internal_get_env_num("SPINCOUNT_MIN", dflt_min, 0);
+    p->adaptive = qt_internal_get_env_bool("SPIN_ADAPTIVE", 0);
+    if (p->min > p->max) { p->min = p->max; }
+} /*}}}*/
+
+/* Start an idle period; returns the number of spins before parking. */
+static QINLINE unsigned long qt_idle_begin(qt_idle_t              *idle,
+                                           const qt_idle_policy_t *p)
+{   /*{{{*/
+    qthread_worker_t *w = qthread_internal_getworker();
+
+    idle->worker = w;
+    idle->start  = qtimer_wtime();
+    idle->parked = 0.0;
+    idle->limit  = p->max;
+    if (p->adaptive && (w != NULL)) {
+        if (w->spin_limit == 0) { w->spin_limit = p->max; }
+        idle->limit = w->spin_limit;
+    }
+    return idle->limit;
+} /*}}}*/
+
+static QINLINE void qt_idle_park(qt_idle_t *idle)
+{   /*{{{*/
+    idle->park_start = qtimer_wtime();
+} /*}}}*/
+
+static QINLINE void qt_idle_unpark(qt_idle_t *idle)
+{   /*{{{*/
+    idle->parked += qtimer_wtime() - idle->park_start;
+    if (idle->worker != NULL) { idle->worker->parks++; }
+} /*}}}*/
+
+/* End an idle period in which the worker last spun 'spins' times. */
+static QINLINE void qt_idle_end(qt_idle_t              *idle,
+                                const qt_idle_policy_t *p,
+                                unsigned long           spins)
+{   /*{{{*/
+    qthread_worker_t *w     = idle->worker;
+    double            spun  = qtimer_wtime() - idle->start - idle->parked;
+    unsigned long     limit = idle->limit;
+
+    if (w == NULL) { return; }
+
+    w->spin_time += spun;
+    w->park_time += idle->parked;
+
+    if (!p->adaptive) { return; }
+    if (idle->parked == 0.0) {
+        if (2 * spins > limit) { limit *= 2; }
+    } else if (idle->parked <= spun) {
+        limit *= 2;
+    } else {
+        limit /= 2;
+    }
+    if (limit < p->min) {
+        limit = p->min;
+    } else if (limit > p->max) {
+        limit = p->max;
+    }
+    w->spin_limit = limit;
+} /*}}}*/
+
+#endif // ifndef QT_IDLE_H
+/* vim:set expandtab: */
@@ -36,6 +36,10 @@ typedef struct qthread_shepherd_s qthread_shepherd_t;
 
 # define STEAL_BUFFER_LENGTH 128
 
+#ifdef QTHREAD_GUARD_PAGES
+# define QTHREAD_STACK_CACHE_MAX 64
+#endif
+
 struct qthread_worker_s {
     uintptr_t                 hazard_ptrs[HAZARD_PTRS_PER_SHEP]; /* hazard pointers (see http://portal.acm.org/citation.cfm?id=987524.987595) */
     hazard_freelist_t         hazard_free_list;
@@ -47,8 +51,17 @@ struct qthread_worker_s {
     qthread_worker_id_t       unique_id;
     qthread_worker_id_t       worker_id;
     qthread_worker_id_t       packed_worker_id;
+    /* idle spinning and parking (see qt_idle.h) */
+    unsigned long             spin_limit;
+    double                    spin_time;
+    double                    park_time;
+    size_t                    parks;
 #ifdef QTHREAD_PERFORMANCE
     struct qtperfdata_s*             performance_data;
+#endif
+#ifdef QTHREAD_GUARD_PAGES
+    void                     *stack_cache[QTHREAD_STACK_CACHE_MAX]; /* freed stacks, guard pages intact */
+    unsigned int              stack_cache_cnt;
 #endif
     Q_ALIGNED(8) uint_fast8_t QTHREAD_CASLOCK(active);
 };
@@ -346,6 +346,9 @@ const qthread_shepherd_id_t *qthread_sorted_sheps_remote(const
 qthread_shepherd_id_t qthread_num_shepherds(void);
 qthread_worker_id_t   qthread_num_workers(void); /* how many kernel-level threads are running */
 qthread_worker_id_t   qthread_num_workers_local(qthread_shepherd_id_t shepherd_id);
+/* how long the workers have spent spinning and parked waiting for work,
+ * and how many times they parked */
+void qthread_idle_stats(double *spin_secs, double *park_secs, size_t *parks);
 /* queries the current state */
 enum introspective_state {
     STACK_SIZE,
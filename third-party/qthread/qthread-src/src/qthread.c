@@ -222,10 +222,26 @@ static QINLINE void FREE_STACK(void *t)
 #else /* if defined(UNPOOLED_STACKS) || defined(UNPOOLED) */
 static qt_mpool generic_stack_pool = NULL;
 # ifdef QTHREAD_GUARD_PAGES
+/* Each worker keeps up to STACK_CACHE_SIZE freed stacks with their guard
+ * pages still in place, so that reusing a stack doesn't take four mprotect()
+ * calls.  With LAZY_STACKS, the pages of a cached stack are handed back to
+ * the OS with madvise() and get recommitted on demand when it is reused. */
+static unsigned int stack_cache_size = 0;
+static int          stack_lazy       = 0;
+
+static QINLINE void FREE_STACK_UNCACHED(void *t);
+
 static QINLINE void *ALLOC_STACK(void)
 {                      /*{{{ */
     if (GUARD_PAGES) {
-        uint8_t *tmp = qt_mpool_alloc(generic_stack_pool);
+        qthread_worker_t *w = qthread_internal_getworker();
+        uint8_t          *tmp;
+
+        if ((w != NULL) && (w->stack_cache_cnt > 0)) {
+            return w->stack_cache[--w->stack_cache_cnt];
+        }
+
+        tmp = qt_mpool_alloc(generic_stack_pool);
 
         assert(tmp);
         if (tmp == NULL) {
@@ -246,6 +262,32 @@ static QINLINE void *ALLOC_STACK(void)
 }                      /*}}} */
 
 static QINLINE void FREE_STACK(void *t)
+{                      /*{{{ */
+    if (GUARD_PAGES) {
+        qthread_worker_t *w = qthread_internal_getworker();
+
+        assert(t);
+        if ((w != NULL) && (w->stack_cache_cnt < stack_cache_size)) {
+            if (stack_lazy) {
+                /* keep the top page, where the next task will start */
+                size_t len = qlib->qthread_stack_size - getpagesize();
+                int    r   = -1;
+
+#  ifdef MADV_FREE
+                r = madvise(t, len, MADV_FREE);
+#  endif
+                if (r != 0) {
+                    (void)madvise(t, len, MADV_DONTNEED);
+                }
+            }
+            w->stack_cache[w->stack_cache_cnt++] = t;
+            return;
+        }
+    }
+    FREE_STACK_UNCACHED(t);
+}                      /*}}} */
+
+static QINLINE void FREE_STACK_UNCACHED(void *t)
 {                      /*{{{ */
     if (GUARD_PAGES) {
         assert(t);
@@ -262,6 +304,13 @@ static QINLINE void FREE_STACK(void *t)
     qt_mpool_free(generic_stack_pool, t);
 }                      /*}}} */
 
+static void stack_cache_drain(qthread_worker_t *w)
+{                      /*{{{ */
+    while (w->stack_cache_cnt > 0) {
+        FREE_STACK_UNCACHED(w->stack_cache[--w->stack_cache_cnt]);
+    }
+}                      /*}}} */
+
 # else /* ifdef QTHREAD_GUARD_PAGES */
 #  define ALLOC_STACK() qt_mpool_alloc(generic_stack_pool)
 #  define FREE_STACK(t) qt_mpool_free(generic_stack_pool, t)
@@ -884,6 +933,13 @@ int API_FUNC qthread_initialize(void)
     qthread_debug(CORE_DETAILS, "qthread stack size: %u\n", qlib->qthread_stack_size);
 #ifdef QTHREAD_GUARD_PAGES
     GUARD_PAGES = qt_internal_get_env_bool("GUARD_PAGES", 1);
+# if !defined(UNPOOLED_STACKS) && !defined(UNPOOLED)
+    stack_cache_size = qt_internal_get_env_num("STACK_CACHE_SIZE", 16, 0);
+    if (stack_cache_size > QTHREAD_STACK_CACHE_MAX) {
+        stack_cache_size = QTHREAD_STACK_CACHE_MAX;
+    }
+    stack_lazy = qt_internal_get_env_bool("LAZY_STACKS", 0);
+# endif
 #endif
     if (GUARD_PAGES) {
         if (print_info) {
@@ -1480,6 +1536,11 @@ void API_FUNC qthread_finalize(void)
         qthread_worker_id_t j;
         qthread_shepherd_t *shep = &(qlib->shepherds[i]);
         qthread_debug(SHEPHERD_DETAILS, "destroying shepherd %i's worker memory \n", (int)i);
+#if defined(QTHREAD_GUARD_PAGES) && !defined(UNPOOLED_STACKS) && !defined(UNPOOLED)
+        for (j = 0; j < qlib->nworkerspershep; j++) {
+            stack_cache_drain(&shep->workers[j]);
+        }
+#endif
         for (j = 0; j < qlib->nworkerspershep; j++) {
             if ((i == 0) && (j == 0)) {
                 continue;  /* This leaves out shepherd 0's worker 0 */
@@ -21,6 +21,7 @@
 #include "qt_prefetch.h"
 #include "qt_threadqueues.h"
 #include "qt_envariables.h"
+#include "qt_idle.h"
 #include "qt_debug.h"
 #ifdef QTHREAD_USE_EUREKAS
 #include "qt_eurekas.h" /* for qt_eureka_check() */
@@ -36,6 +37,9 @@ int max_backoff;
 int spinloop_backoff;
 int condwait_backoff;
 int steal_ratio;
+int steal_idle;
+
+static qt_idle_policy_t idle_policy;
 
 /* Data Structures */
 struct _qt_threadqueue_node {
@@ -165,7 +169,11 @@ static void qt_threadqueue_subsystem_shutdown(){
 
 void INTERNAL qt_threadqueue_subsystem_init(){   
   steal_ratio = qt_internal_get_env_num("STEAL_RATIO", 8, 0);
+  steal_idle = qt_internal_get_env_num("STEAL_IDLE", 64, 0);
   condwait_backoff = qt_internal_get_env_num("CONDWAIT_BACKOFF", 2048, 0);
+  // An adaptive backoff shouldn't drop below the point where we steal
+  qt_idle_policy_init(&idle_policy, condwait_backoff,
+                      steal_ratio > 0 ? steal_idle + steal_ratio : 64);
   finalizing = 0;
   generic_threadqueue_pools.queues = qt_mpool_create_aligned(sizeof(qt_threadqueue_t),
                                                              qthread_cacheline());
@@ -343,6 +351,60 @@ int INTERNAL qt_threadqueue_private_enqueue_yielded(qt_threadqueue_private_t *re
                                                     qthread_t *restrict                t)
 { return 0; } 
 
+// Steal about half of the tasks in one of the victim's queues.  We take
+// the oldest ones, from the head, since owners work from the tail.  One
+// is returned and the rest go on the end of one of the thief's queues,
+// so the thief doesn't have to come back for each of them.
+static qt_threadqueue_node_t *qt_threadqueue_steal_half(qt_threadqueue_t *victim,
+                                                         qt_threadqueue_t *thief){
+  for(size_t i = 0; i < victim->num_queues; i++){
+    qt_threadqueue_internal* q = victim->t + i;
+    qt_threadqueue_node_t *first, *last;
+    long n;
+
+    if (q->qlength == 0) continue;
+    if (!QTHREAD_TRYLOCK_TRY(&q->qlock)) continue;
+    n = (q->qlength + 1) / 2;
+    if (n == 0){
+      QTHREAD_TRYLOCK_UNLOCK(&q->qlock);
+      continue;
+    }
+    first = last = q->head;
+    for(long j = 1; j < n; j++) last = last->next;
+    q->head = last->next;
+    if(q->head) q->head->prev = NULL;
+    else q->tail = NULL;
+    q->qlength -= n;
+    QTHREAD_TRYLOCK_UNLOCK(&q->qlock);
+    last->next = NULL;
+
+    if (n > 1){
+      qt_threadqueue_internal* mq = myqueue(thief);
+      qt_threadqueue_node_t *rest = first->next;
+
+      QTHREAD_TRYLOCK_LOCK(&mq->qlock);
+      rest->prev = mq->tail;
+      if (mq->tail == NULL) {
+        mq->head = rest;
+      } else {
+        mq->tail->next = rest;
+      }
+      mq->tail = last;
+      mq->qlength += n - 1;
+      QTHREAD_TRYLOCK_UNLOCK(&mq->qlock);
+
+      if(thief->numwaiters){
+        QTHREAD_COND_LOCK(thief->cond);
+        if(thief->numwaiters) QTHREAD_COND_SIGNAL(thief->cond);
+        QTHREAD_COND_UNLOCK(thief->cond);
+      }
+    }
+    first->next = NULL;
+    return first;
+  }
+  return NULL;
+}
+
 // We try and dequeue locally, if that fails we should do some stealing
 qthread_t INTERNAL *qt_scheduler_get_thread(qt_threadqueue_t         *qe,
                                             qt_threadqueue_private_t *qc,
@@ -351,16 +413,28 @@ qthread_t INTERNAL *qt_scheduler_get_thread(qt_threadqueue_t         *qe,
   qt_threadqueue_node_t *node = NULL;
   qthread_t* t;
   qthread_shepherd_t *my_shepherd = qthread_internal_getshep();
+  qt_idle_t idle;
+  unsigned long backoff = 0;
+  int idling = 0;
+  int numwaits;
 
-  for(int numwaits = 0; !node; numwaits ++){
+  for(numwaits = 0; !node; numwaits ++){
     node = qt_threadqueue_dequeue_tail(qe);
 
-    // If we've done QT_STEAL_RATIO waits on local queue, try to steal 
-    if(!node && steal_ratio > 0 && numwaits % steal_ratio == 0) {
-      for(int i=0; i < qlib->nshepherds; i++){
-        qt_threadqueue_t *victim_queue = qlib->shepherds[i].ready;
-        node = qt_threadqueue_dequeue_head(victim_queue);
+    // Once we've been idle for QT_STEAL_IDLE tries, try to steal every
+    // QT_STEAL_RATIO tries.  Our own shepherd's queues are already
+    // covered by the local dequeue, so look at the others, nearest
+    // (sorted_sheplist is by distance) first.
+    if(!node && steal_ratio > 0 && qlib->nshepherds > 1 &&
+       numwaits >= steal_idle && (numwaits - steal_idle) % steal_ratio == 0) {
+      for(int i=0; i < qlib->nshepherds - 1; i++){
+        qthread_shepherd_id_t v =
+          my_shepherd->sorted_sheplist ?
+          my_shepherd->sorted_sheplist[i] :
+          (my_shepherd->shepherd_id + 1 + i) % qlib->nshepherds;
+        node = qt_threadqueue_steal_half(qlib->shepherds[v].ready, qe);
         if (node){
+          if (idling) qt_idle_end(&idle, &idle_policy, numwaits);
           t = node->value;
           free_tqnode(node);
           return t;
@@ -371,13 +445,20 @@ qthread_t INTERNAL *qt_scheduler_get_thread(qt_threadqueue_t         *qe,
     if(!node && qthread_worker(NULL) == 0 && mccoy){
       qthread_t *t = mccoy;
       mccoy = NULL;
+      if (idling) qt_idle_end(&idle, &idle_policy, numwaits);
       return t; 
     } else if(!node){
-      if(numwaits > condwait_backoff && !finalizing){
+      if(!idling){
+        backoff = qt_idle_begin(&idle, &idle_policy);
+        idling = 1;
+      }
+      if(numwaits > (int)backoff && !finalizing){
         QTHREAD_COND_LOCK(qe->cond);
         qe->numwaiters++;
         MACHINE_FENCE;
+        qt_idle_park(&idle);
         if(!finalizing) QTHREAD_COND_WAIT(qe->cond);
+        qt_idle_unpark(&idle);
         qe->numwaiters--;
         QTHREAD_COND_UNLOCK(qe->cond);
         numwaits = 0;
@@ -386,6 +467,7 @@ qthread_t INTERNAL *qt_scheduler_get_thread(qt_threadqueue_t         *qe,
       }
     }
   }
+  if (idling) qt_idle_end(&idle, &idle_policy, numwaits);
   t = node->value;
   free_tqnode(node);
   return t;
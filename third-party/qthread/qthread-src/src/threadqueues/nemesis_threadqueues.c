@@ -19,6 +19,7 @@
 #include "qt_prefetch.h"
 #include "qt_threadqueues.h"
 #include "qt_envariables.h"
+#include "qt_idle.h"
 #include "qt_qthread_struct.h"
 #include "qt_debug.h"
 #ifdef QTHREAD_USE_EUREKAS
@@ -38,6 +39,9 @@ int num_spins_before_condwait;
 #else
 #define DEFAULT_SPINCOUNT 300000
 #endif
+#define DEFAULT_SPINCOUNT_MIN 64
+
+static qt_idle_policy_t idle_policy;
 
 /* Data Structures */
 struct _qt_threadqueue_node {
@@ -94,6 +98,8 @@ void INTERNAL qt_threadqueue_subsystem_init(void)
 {   /*{{{*/
 
     num_spins_before_condwait = qt_internal_get_env_num("SPINCOUNT", DEFAULT_SPINCOUNT, 0);
+    qt_idle_policy_init(&idle_policy, num_spins_before_condwait,
+                        DEFAULT_SPINCOUNT_MIN);
 
     generic_threadqueue_pools.queues = qt_mpool_create(sizeof(qt_threadqueue_t));
     generic_threadqueue_pools.nodes  = qt_mpool_create_aligned(sizeof(qt_threadqueue_node_t), 8);
@@ -363,7 +369,7 @@ qthread_t INTERNAL *qt_scheduler_get_thread(qt_threadqueue_t         *q,
                                             qt_threadqueue_private_t *QUNUSED(qc),
                                             uint_fast8_t              QUNUSED(active))
 {                                      /*{{{ */
-    int i;
+    unsigned long i;
 #ifdef QTHREAD_USE_EUREKAS
     qt_eureka_disable();
 #endif /* QTHREAD_USE_EUREKAS */
@@ -375,15 +381,17 @@ qthread_t INTERNAL *qt_scheduler_get_thread(qt_threadqueue_t         *q,
     qthread_debug(THREADQUEUE_DETAILS, "q(%p)->q {head:%p tail:%p sh:%p} q->advisory_queuelen:%u\n", q, q->q.head, q->q.tail, q->q.shadow_head, q->advisory_queuelen);
     PARANOIA(sanity_check_tq(&q->q));
     if (node == NULL) {
+        qt_idle_t     idle;
+        unsigned long limit = qt_idle_begin(&idle, &idle_policy);
 #ifdef QTHREAD_USE_EUREKAS
         qt_eureka_check(0);
 #endif /* QTHREAD_USE_EUREKAS */
 
+        i = 0;
 #ifdef QTHREAD_CONDWAIT_BLOCKING_QUEUE
-        i = num_spins_before_condwait;
-        while (q->q.shadow_head == NULL && q->q.head == NULL && i > 0) {
+        while (q->q.shadow_head == NULL && q->q.head == NULL && i < limit) {
           SPINLOCK_BODY();
-          i--;
+          i++;
         }
 #endif      /* QTHREAD_CONDWAIT_BLOCKING_QUEUE */
 
@@ -394,12 +402,15 @@ qthread_t INTERNAL *qt_scheduler_get_thread(qt_threadqueue_t         *q,
             if (qthread_incr(&q->frustration, 1) > 1000) {
                 QTHREAD_COND_LOCK(q->trigger);
                 if (q->frustration > 1000) {
+                    qt_idle_park(&idle);
                     QTHREAD_COND_WAIT(q->trigger);
+                    qt_idle_unpark(&idle);
                 }
                 QTHREAD_COND_UNLOCK(q->trigger);
             }
 #endif      /* ifdef USE_HARD_POLLING */
         }
+        qt_idle_end(&idle, &idle_policy, i);
 #ifdef QTHREAD_USE_EUREKAS
         qt_eureka_disable();
 #endif /* QTHREAD_USE_EUREKAS */
@@ -116,4 +116,30 @@ qthread_worker_id_t API_FUNC qthread_num_workers_local(qthread_shepherd_id_t she
     return qlib->nworkerspershep;
 }
 
+/* Add up the time the workers have spent spinning and parked waiting
+ * for work, and how many times they parked.  These are advisory: the
+ * workers update them without synchronization. */
+void API_FUNC qthread_idle_stats(double *spin_secs,
+                                 double *park_secs,
+                                 size_t *parks)
+{                      /*{{{ */
+    double spin = 0.0, park = 0.0;
+    size_t n    = 0;
+
+    assert(qthread_library_initialized);
+
+    for (qthread_shepherd_id_t s = 0; s < qlib->nshepherds; s++) {
+        for (qthread_worker_id_t w = 0; w < qlib->nworkerspershep; w++) {
+            qthread_worker_t *worker = &qlib->shepherds[s].workers[w];
+
+            spin += worker->spin_time;
+            park += worker->park_time;
+            n    += worker->parks;
+        }
+    }
+    if (spin_secs) { *spin_secs = spin; }
+    if (park_secs) { *park_secs = park; }
+    if (parks) { *parks = n; }
+}                      /*}}} */
+
 /* vim:set expandtab: */
@@ -777,6 +777,12 @@ bool RE2::Match(const StringPiece& text,
   return true;
 }
 
+bool RE2::anchored_at_start() const {
+  if (!ok() || prog_ == NULL)
+    return false;
+  return !prefix_.empty() || prog_->anchor_start();
+}
+
 bool RE2::MatchFile(FilePiece& text,
                     const StringPiece& buffer,
                     Anchor re_anchor,
@@ -48,6 +48,12 @@ void taskCallback (Fl_Widget *w, void *p) {
   //printf ("v is 0x%lx\n", (long)view); 
 }
 
+void overviewCallback (Fl_Widget *w, void *p) {
+  ConcurrencyData *data = (ConcurrencyData *)w->parent();
+  data->showRows(0, -1);
+  data->buildData();
+}
+
 ConcurrencyView::ConcurrencyView (int x, int y, int W, int H, const char *l)
   :  Fl_Group (x, y, W, H, l)
 {
@@ -64,6 +70,7 @@ void ConcurrencyView::updateData (long loc, long tag)
            loc, curTag->name, curTag->locales[loc].maxConc,
            curTag->locales[loc].maxTaskClock);
   title->copy_label(tmp);
+  dataBox->showRows(0, -1);
   dataBox->buildData();
 }
 
@@ -123,6 +130,11 @@ void ConcurrencyData::draw (void) {
   Fl_Group::draw();
   std::list<drawData>::iterator dbItr;
 
+  if (!buckets.empty()) {
+    drawBuckets();
+    return;
+  }
+
   // Get the scroll window information for "clipping" and drawing
   s_x = parent->scroll->x();
   s_y = parent->scroll->y();
@@ -165,10 +177,88 @@ void ConcurrencyData::draw (void) {
   fl_line_style(FL_SOLID, 1, NULL);
 }
 
+// Draw only the buckets in the scroll area, one per line, as a bar as
+// wide as the most tasks running at once in the bucket.
+
+void ConcurrencyData::drawBuckets (void) {
+  char tmp[2048];
+  int s_y = parent->scroll->y();
+  int s_h = parent->scroll->h();
+  long first = (s_y - (y() + 40)) / 25 - 1;
+  long last = (s_y + s_h - (y() + 40)) / 25 + 1;
+
+  if (first < 0)
+    first = 0;
+  if (last >= (long)buckets.size())
+    last = buckets.size() - 1;
+
+  fl_font(FL_HELVETICA, 12);
+  for (long ix = first; ix <= last; ix++) {
+    bucketData &b = buckets[ix];
+    int b_y = y() + 40 + 25 * ix;
+    int b_w = 60 * (b.maxConc > 0 ? b.maxConc : 1);
+
+    fl_color(heatColor(b.numBegun, maxBucketBegun));
+    fl_rectf(x() + 10, b_y, b_w, 20);
+    fl_color(FL_BLACK);
+    fl_rect(x() + 10, b_y, b_w, 20);
+
+    if (b.tagNo != DataModel::TagALL)
+      snprintf (tmp, sizeof(tmp), "%ld begun, %ld ended  TAG: %s",
+                b.numBegun, b.numEnded, VisData.getTagData(b.tagNo)->name);
+    else
+      snprintf (tmp, sizeof(tmp), "%ld begun, %ld ended",
+                b.numBegun, b.numEnded);
+    fl_draw(tmp, x() + 15, b_y + 15);
+  }
+}
+
 int ConcurrencyData::handle(int event) {
+  if (event == FL_PUSH && !buckets.empty() && Fl::event_y() >= y() + 40) {
+    long ix = (Fl::event_y() - (y() + 40)) / 25;
+    if (ix < (long)buckets.size()) {
+      showRows(ix * rowsPerBucket, ix * rowsPerBucket + maxDetailRows);
+      buildData();
+      return 1;
+    }
+  }
   return Fl_Group::handle(event);
 }
 
+// Add the button for a task that was running before the first row shown
+
+void ConcurrencyData::addContinuation (int col, int line, long taskId) {
+  Fl_Button *btn;
+  taskData *theTask;
+  char tmp[2048];
+
+  btn = new Fl_Button(x()+15+60*col, y()+40+25*line, 60, 20, NULL);
+  btn->box(FL_BORDER_BOX);
+  btn->down_box(FL_BORDER_BOX);
+  if (parent->localeNum == 0 && taskId == 1)
+    snprintf (tmp, sizeof(tmp), "Main");
+  else
+    snprintf (tmp, sizeof(tmp), "C %ld", taskId);
+  btn->copy_label(tmp);
+  add(btn);
+  theTask = VisData.getTaskData(parent->localeNum, taskId);
+  if (theTask) {
+    if (theTask->taskRec && theTask->taskRec->isLocal()) {
+      const char *fname = VisData.fileName(theTask->taskRec->srcFile());
+      snprintf (tmp, sizeof(tmp), "%f C %ld G %ld P %ld OC\n%s:%ld",
+                theTask->taskClock, theTask->commSum.numGets,
+                theTask->commSum.numPuts, theTask->commSum.numForks,
+                (fname[0] == '$' ? &fname[11] : fname),
+                theTask->taskRec->srcLine());
+    } else {
+      snprintf (tmp, sizeof(tmp), "%f C %ld G %ld P %ld OC",
+                theTask->taskClock, theTask->commSum.numGets,
+                theTask->commSum.numPuts, theTask->commSum.numForks);
+    }
+    btn->copy_tooltip(tmp);
+    btn->callback(taskCallback, (void *)theTask);
+  }
+}
 
 void ConcurrencyData::buildData(void) {
   Fl_Box *b;
@@ -182,6 +272,10 @@ void ConcurrencyData::buildData(void) {
   int numLines = 0;
   int curLine;
   int curCol;
+  int lineBase;   // Row shown on the first line
+  int running;    // Number of tasks running
+  bool overview;
+  bool window;
 
   DataModel::tagData *tmpTag;
   long tmpTagNo;
@@ -274,7 +368,22 @@ void ConcurrencyData::buildData(void) {
   // Get correct number of lines and height of data area
   if (greedy[0]) numLines++;
   height = 40 + 25 * numLines;
-                                   
+
+  // Too many rows for a button per task, show buckets of rows instead
+  buckets.clear();
+  maxBucketBegun = 0;
+  overview = numLines > maxDetailRows && lastRow < 0;
+  window = !overview && (firstRow > 0 || lastRow >= 0);
+  if (overview) {
+    rowsPerBucket = (numLines + maxDetailRows - 1) / maxDetailRows;
+    buckets.resize((numLines + rowsPerBucket - 1) / rowsPerBucket);
+    height = 40 + 25 * buckets.size();
+  } else if (window) {
+    if (lastRow < 0 || lastRow >= numLines)
+      lastRow = numLines - 1;
+    height = 40 + 25 * (lastRow - firstRow + 2);
+  }
+
   // Reset scroll
   parent->scroll->scroll_to(0,0);
 
@@ -289,8 +398,16 @@ void ConcurrencyData::buildData(void) {
   // Start the rebuild by resizing
   resize (x(), y(), width, height);
 
+  if (window) {
+    btn = new Fl_Button(x()+10, y()+10, 80, 20, "Overview");
+    btn->callback(overviewCallback);
+    add(btn);
+  }
+
   // Build the data
   curLine = 0;
+  lineBase = 0;
+  running = 0;
   tl_itr = tagStart;
   tmpTagNo = parent->tagNum;
   if (tmpTagNo == DataModel::TagALL)
@@ -304,43 +421,83 @@ void ConcurrencyData::buildData(void) {
       // printf ("Building continuation for col %d\n", col);
       greedy[curCol] = greedy[col];
       greedyStart[curCol] = 0;
-      btn = new Fl_Button(x()+15+60*curCol, y()+40, 60, 20, NULL);
-      btn->box(FL_BORDER_BOX);
-      btn->down_box(FL_BORDER_BOX);
-      if (parent->localeNum == 0 && greedy[col] == 1)
-        snprintf (tmp, sizeof(tmp), "Main");
-      else
-        snprintf (tmp, sizeof(tmp), "C %d", greedy[curCol]);
-      btn->copy_label(tmp);
-      add(btn);
-      theTask = VisData.getTaskData(parent->localeNum, greedy[curCol]);
-      if (theTask) {
-        if (theTask->taskRec && theTask->taskRec->isLocal()) {
-          const char *fname = VisData.fileName(theTask->taskRec->srcFile());
-          snprintf (tmp, sizeof(tmp), "%f C %ld G %ld P %ld OC\n%s:%ld",
-                    theTask->taskClock, theTask->commSum.numGets,
-                    theTask->commSum.numPuts, theTask->commSum.numForks,
-                    (fname[0] == '$' ? &fname[11] : fname),
-                    theTask->taskRec->srcLine());
-        } else {
-          snprintf (tmp, sizeof(tmp), "%f C %ld G %ld P %ld OC",
-                    theTask->taskClock, theTask->commSum.numGets,
-                    theTask->commSum.numPuts, theTask->commSum.numForks);
-        }
-        btn->copy_tooltip(tmp);
-        btn->callback(taskCallback, (void *)theTask);
-      }
+      if (!overview && firstRow == 0)
+        addContinuation(curCol, 0, greedy[curCol]);
       if (curCol != col)
         greedy[col] = 0;
       curCol++;
     }
   if (curCol)
     curLine++;
+  running = curCol;
 
   done = false; 
 
   while (!done && tl_itr !=  VisData.taskTimeline[parent->localeNum].end()) {
 
+    if (window && curLine > lastRow)
+      break;
+
+    // Entering the window, show the tasks that are already running
+    if (window && curLine == firstRow && firstRow > 0) {
+      lineBase = firstRow - 1;
+      curCol = 0;
+      for (int col = 0; col < progMaxConc; col++)
+        if (greedy[col] != 0) {
+          greedy[curCol] = greedy[col];
+          greedyStart[curCol] = 0;
+          addContinuation(curCol, 0, greedy[curCol]);
+          if (curCol != col)
+            greedy[col] = 0;
+          curCol++;
+        }
+    }
+
+    // Rows outside the shown ones only keep track of the running tasks
+    if (overview || curLine < firstRow) {
+      bucketData *bucket = overview ? &buckets[curLine / rowsPerBucket] : NULL;
+
+      switch (tl_itr->first) {
+
+        case DataModel::Tl_Tag:
+          if (parent->tagNum != DataModel::TagALL) {
+            done = true;
+            break;
+          }
+          tmpTagNo = tl_itr->second;
+          if (bucket && bucket->tagNo == DataModel::TagALL)
+            bucket->tagNo = tmpTagNo;
+          break;
+
+        case DataModel::Tl_Begin:
+          curCol = 0;
+          while (greedy[curCol] != 0) curCol++;
+          greedy[curCol] = tl_itr->second;
+          running++;
+          if (bucket) {
+            bucket->numBegun++;
+            if (bucket->numBegun > maxBucketBegun)
+              maxBucketBegun = bucket->numBegun;
+          }
+          break;
+
+        case DataModel::Tl_End:
+          curCol = 0;
+          while (greedy[curCol] != tl_itr->second) curCol++;
+          greedy[curCol] = 0;
+          running--;
+          if (bucket)
+            bucket->numEnded++;
+          break;
+      }
+      if (bucket && running > bucket->maxConc)
+        bucket->maxConc = running;
+      if (!done)
+        curLine++;
+      tl_itr++;
+      continue;
+    }
+
     switch (tl_itr->first) {
       
       case DataModel::Tl_Tag:
@@ -353,8 +510,9 @@ void ConcurrencyData::buildData(void) {
         while (greedy[curCol] != 0) curCol++;
         snprintf (tmp, sizeof(tmp), "TAG: %s", 
                   VisData.getTagData(tmpTagNo)->name);
-        b = new Fl_Box(FL_BORDER_BOX, x()+10+60*curCol, y()+40+25*curLine,
-                               8+7*strlen(tmp), 20, NULL);
+        b = new Fl_Box(FL_BORDER_BOX, x()+10+60*curCol,
+                       y()+40+25*(curLine-lineBase),
+                       8+7*strlen(tmp), 20, NULL);
         b->copy_label(tmp);
         add(b);
         curLine++;
@@ -364,9 +522,10 @@ void ConcurrencyData::buildData(void) {
         curCol = 0;
         while (greedy[curCol] != 0) curCol++;
         greedy[curCol] = tl_itr->second; // store the task id
-        greedyStart[curCol] = curLine;
+        greedyStart[curCol] = curLine - lineBase;
         theTask = VisData.getTaskData(parent->localeNum,tl_itr->second, tmpTagNo);
-        btn = new Fl_Button(x()+10+60*curCol, y()+40+25*curLine, 70, 20, NULL);
+        btn = new Fl_Button(x()+10+60*curCol, y()+40+25*(curLine-lineBase),
+                            70, 20, NULL);
         btn->box(FL_ROUNDED_BOX);
         btn->down_box(FL_ROUNDED_BOX);
         snprintf (tmp, sizeof(tmp), "%c%s %ld",
@@ -401,7 +560,7 @@ void ConcurrencyData::buildData(void) {
         // Update drawing information
         lineDrawData.startLine = greedyStart[curCol];
         lineDrawData.column = curCol;
-        lineDrawData.endLine = curLine;
+        lineDrawData.endLine = curLine - lineBase;
         lineDrawData.isEndTask = true;
         drawDB.push_back(lineDrawData);
         greedy[curCol] = 0;
@@ -412,9 +571,9 @@ void ConcurrencyData::buildData(void) {
   } 
 
   // Update drawing information for any element still in greedy
-  lineDrawData.endLine = curLine;
+  lineDrawData.endLine = curLine - lineBase;
   lineDrawData.isEndTask = false;
-  for (int col = 0; col < progMaxConc; col++)
+  for (int col = 0; col < progMaxConc && !overview; col++)
     if (greedy[col] != 0) {
       lineDrawData.column = col;
       lineDrawData.startLine = greedyStart[col];
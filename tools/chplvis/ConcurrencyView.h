@@ -29,6 +29,8 @@
 
 #include "DataModel.h"
 
+#include <vector>
+
 class ConcurrencyView;
 
 // Data (Box) class for the concurrency view
@@ -40,20 +42,50 @@ struct drawData {
   bool isEndTask;
 };
 
+// Summary of a run of timeline rows, for timelines too long to show
+// a button for every task
+
+struct bucketData {
+  long numBegun;
+  long numEnded;
+  int  maxConc;
+  long tagNo;     // First tag in the bucket, or TagALL if none
+
+  bucketData()
+    : numBegun(0), numEnded(0), maxConc(0), tagNo(DataModel::TagALL) {};
+};
+
 class ConcurrencyData : public Fl_Group {
 
   private:
     ConcurrencyView *parent;
     std::list<drawData> drawDB;
 
+    // Timelines with more than maxDetailRows rows are shown as buckets
+    // of rows first.  Clicking on a bucket shows the rows from there on,
+    // firstRow up to lastRow.  lastRow < 0 means all rows.
+    static const long maxDetailRows = 2000;
+    std::vector<bucketData> buckets;
+    long rowsPerBucket;
+    long maxBucketBegun;
+    long firstRow;
+    long lastRow;
+
+    void addContinuation (int col, int line, long taskId);
+    void drawBuckets (void);
+
   public:
     void draw (void);
     int handle (int event);
 
-    ConcurrencyData (int x, int y, int W, int H, const char *l=0) : Fl_Group(x,y,W,H,l){};
+    ConcurrencyData (int x, int y, int W, int H, const char *l=0)
+      : Fl_Group(x,y,W,H,l), rowsPerBucket(1), maxBucketBegun(0),
+        firstRow(0), lastRow(-1) {};
 
     void setParent(ConcurrencyView *p) { parent = p; }
 
+    void showRows (long first, long last) { firstRow = first; lastRow = last; }
+
     void buildData (void);
   
 };
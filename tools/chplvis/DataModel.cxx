@@ -37,6 +37,14 @@
 
 // C++ Libraries
 #include <set>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// Binary data records, shared with the runtime
+#include "chpl-visual-debug-format.h"
 
 #ifndef MAXPATHLEN
 #define MAXPATHLEN 2048
@@ -168,16 +176,49 @@ int DataModel::LoadData(const char * filename, bool fromArgv)
   // Debug
   std::list<Event *>::iterator itr;
 
+  // File 0 has the name tables the other files use, so it is read first.
+  // The rest are parsed in parallel, then all are merged in locale order.
+  std::vector<std::string> fnames(nlocales);
+  std::vector<std::list<Event *> > fileEvents(nlocales);
+  std::vector<int> fileOk(nlocales, 0);
+
   for (int i = 0; i < nlocales; i++) {
     snprintf (fname, namesize+15, "%.*s%d", namesize, fullfilename, i);
-    if (!LoadFile(fname, i, seq)) {
+    fnames[i] = fname;
+  }
+
+  numTags = 0;
+  fileOk[0] = ParseFile(fnames[0].c_str(), 0, seq, fileEvents[0]);
+  if (fileOk[0] && nlocales > 1) {
+    std::atomic<int> nextFile(1);
+    unsigned nThreads = std::thread::hardware_concurrency();
+    if (nThreads == 0)
+      nThreads = 1;
+    if (nThreads > (unsigned)nlocales - 1)
+      nThreads = nlocales - 1;
+
+    std::vector<std::thread> parsers;
+    for (unsigned t = 0; t < nThreads; t++) {
+      parsers.push_back(std::thread([&]() {
+        int i;
+        while ((i = nextFile++) < nlocales)
+          fileOk[i] = ParseFile(fnames[i].c_str(), i, seq, fileEvents[i]);
+      }));
+    }
+    for (unsigned t = 0; t < nThreads; t++)
+      parsers[t].join();
+  }
+
+  for (int i = 0; i < nlocales; i++) {
+    if (!fileOk[i]) {
       if (!fromArgv)
-        fl_message ("Error processing data from %s", fname);
+        fl_message ("Error processing data from %s", fnames[i].c_str());
       else
-        fl_message ("Error processing data from %s\n", fname);
+        fl_message ("Error processing data from %s\n", fnames[i].c_str());
       numLocales = -1;
       return 0;
     }
+    MergeEvents(fnames[i].c_str(), fileEvents[i]);
     // Debug
     /*
 
@@ -794,9 +835,32 @@ int DataModel::LoadData(const char * filename, bool fromArgv)
 }
 
 
-// Load the data in the current file
+// Read the binary records following a "Binary:" line as the text lines
+// they stand for, in the order they were logged.
+
+static bool readBinaryRecords (FILE *data,
+                               std::vector<std::pair<uint64_t, std::string> > &lines)
+{
+  chpl_vdebug_rec_t rec;
+  char str[MAX_LINE_LEN];
+  char line[MAX_LINE_LEN];
+  int rv;
+
+  while ((rv = chpl_vdebug_rec_read(data, &rec, str, sizeof(str))) == 1) {
+    if (chpl_vdebug_rec_format(&rec, str, line, sizeof(line)) > 0)
+      lines.push_back(std::make_pair(rec.seq, std::string(line)));
+  }
+  std::sort(lines.begin(), lines.end());
+  return rv == 0;
+}
+
+// Read the events in one locale's file into fileEvents, in file order.
+// This only changes the DataModel when reading file 0, which has the
+// file, function and tag name tables; the other files only read those,
+// so they can be parsed at the same time once file 0 is done.
 
-int DataModel::LoadFile (const char *fileToOpen, int index, double seq)
+int DataModel::ParseFile (const char *fileToOpen, int index, double seq,
+                          std::list<Event *> &fileEvents)
 {
   FILE *data = fopen(fileToOpen, "r");
   char line[MAX_LINE_LEN];
@@ -811,9 +875,10 @@ int DataModel::LoadFile (const char *fileToOpen, int index, double seq)
 
   if (!data) return 0;
 
-  //printf ("LoadFile %s\n", fileToOpen);
+  //printf ("ParseFile %s\n", fileToOpen);
   if (fgets(line,MAX_LINE_LEN,data) != line) {
     fprintf (stderr, "Error reading file %s.\n", fileToOpen);
+    fclose(data);
     return 0;
   }
 
@@ -837,6 +902,7 @@ int DataModel::LoadFile (const char *fileToOpen, int index, double seq)
 
   if (floc != numLocales || findex != index || fabs(seq-fseq) > .01 || VerMinor != EXPECTED_VMINOR) {
     fprintf (stderr, "Data file %s does not match other data.\n", fileToOpen);
+    fclose(data);
     return 0;
   }
 
@@ -847,22 +913,30 @@ int DataModel::LoadFile (const char *fileToOpen, int index, double seq)
     (void)vdbTids.insert(vdbTid);
 
   // Create a start event with starting user/sys times.
-  std::list<Event *>::iterator itr = theEvents.begin();
-
-  // Other initializations
-  numTags = 0;
+  Event *newEvent = new E_start(e_sec, e_usec, findex, u_sec, u_usec, s_sec, s_usec);
+  fileEvents.push_back(newEvent);
 
   // Now read the rest of the file
-  Event *newEvent = new E_start(e_sec, e_usec, findex, u_sec, u_usec, s_sec, s_usec);
-  if (itr == theEvents.end()) {
-    theEvents.push_front(newEvent);
-  } else {
-    // Move past existing start events
-    while ((*itr)->Ekind() == Ev_start) { itr++; }
-    theEvents.insert(itr,newEvent);
-  }
 
-  while ( fgets(line, MAX_LINE_LEN, data) == line ) {
+  // Lines converted from binary records, if the file has them
+  std::vector<std::pair<uint64_t, std::string> > binLines;
+  size_t binNext = 0;
+  bool binary = false;
+
+  while ( binary ? binNext < binLines.size()
+                 : fgets(line, MAX_LINE_LEN, data) == line ) {
+    if (binary) {
+      strncpy(line, binLines[binNext++].second.c_str(), MAX_LINE_LEN-1);
+      line[MAX_LINE_LEN-1] = 0;
+    } else if (strstr(line, "Binary:") == line) {
+      if (!readBinaryRecords(data, binLines)) {
+        fprintf (stderr, "Bad binary data in %s\n", fileToOpen);
+        nErrs++;
+      }
+      binary = true;
+      continue;
+    }
+
     // Common Data
     char *linedata;
     long linelen;
@@ -1128,8 +1202,6 @@ int DataModel::LoadFile (const char *fileToOpen, int index, double seq)
         } else {
           newEvent = new E_tag(sec, usec, nid, u_sec, u_usec, s_sec, s_usec, tagId,
                                tagNames[tagId], vdbTid);
-          if (tagId >= numTags)
-            numTags = tagId+1;
           if (nid == 0) {
             nid0vdbtask = 0;
           }
@@ -1179,7 +1251,79 @@ int DataModel::LoadFile (const char *fileToOpen, int index, double seq)
         /* Do nothing */ ;
     }
 
-    //  Add the newEvent to the list, group Starts, Tags, Resumes and Ends together.
+    if (newEvent)
+      fileEvents.push_back(newEvent);
+  }
+
+  // Remove any task or Btask records that are in the vdbTids db.
+  std::list<Event *>::iterator itr = fileEvents.begin();
+  while (itr != fileEvents.end()) {
+    bool doErase = false;
+    Event *ev = *itr;
+    // ev->print();
+    if (ev->nodeId() == findex) {
+      switch (ev->Ekind()) {
+        case Ev_task:
+          if (vdbTids.find(((E_task *)ev)->taskId()) != vdbTids.end()) {
+            doErase = true;
+          }
+          break;
+        case Ev_begin_task:
+          if (vdbTids.find(((E_begin_task *)ev)->taskId()) != vdbTids.end()) {
+            doErase = true;
+          }
+          break;
+        default:
+          break;
+      }
+      if (doErase)
+        itr = fileEvents.erase(itr);
+      else
+        itr++;
+    } else {
+      itr++;
+    }
+  }
+
+  if (nErrs) fprintf(stderr, "%d errors in data file '%s'.\n", nErrs, fileToOpen);
+
+  //  if (ignoreFork > 0 || ignoreTask > 0) {
+  //    fprintf (stderr, "%s: Error in data filters: ignoreFork = %d, ignoreTask = %d\n",
+  //         fileToOpen, ignoreFork, ignoreTask);
+  //  }
+
+  int atEnd = feof(data);
+  fclose(data);
+
+  return atEnd ? 1 : 0;
+}
+
+// Merge one file's events into theEvents, grouping Starts, Tags, Resumes
+// and Ends together and putting the rest in time order.
+
+void DataModel::MergeEvents (const char *fileToOpen, std::list<Event *> &fileEvents)
+{
+  std::list<Event *>::iterator itr = theEvents.begin();
+  std::list<Event *>::iterator evItr = fileEvents.begin();
+
+  if (evItr == fileEvents.end())
+    return;
+
+  // The start event
+  Event *newEvent = *evItr++;
+  if (itr == theEvents.end()) {
+    theEvents.push_front(newEvent);
+  } else {
+    // Move past existing start events
+    while ((*itr)->Ekind() == Ev_start) { itr++; }
+    theEvents.insert(itr,newEvent);
+  }
+
+  for ( ; evItr != fileEvents.end(); evItr++) {
+    newEvent = *evItr;
+    if (newEvent->Ekind() == Ev_tag && ((E_tag *)newEvent)->tagNo() >= numTags)
+      numTags = ((E_tag *)newEvent)->tagNo() + 1;
+
     if (newEvent) {
       if (theEvents.empty()) {
         theEvents.push_front (newEvent);
@@ -1240,47 +1384,7 @@ int DataModel::LoadFile (const char *fileToOpen, int index, double seq)
       }
     }
   }
-
-  // Remove any task or Btask records that are in the vdbTids db.
-  itr = theEvents.begin();
-  while (itr != theEvents.end()) {
-    bool doErase = false;
-    Event *ev = *itr;
-    // ev->print();
-    if (ev->nodeId() == findex) {
-      switch (ev->Ekind()) {
-        case Ev_task:
-          if (vdbTids.find(((E_task *)ev)->taskId()) != vdbTids.end()) {
-            doErase = true;
-          }
-          break;
-        case Ev_begin_task:
-          if (vdbTids.find(((E_begin_task *)ev)->taskId()) != vdbTids.end()) {
-            doErase = true;
-          }
-          break;
-        default:
-          break;
-      }
-      if (doErase)
-        itr = theEvents.erase(itr);
-      else
-        itr++;
-    } else {
-      itr++;
-    }
-  }
-
-  if (nErrs) fprintf(stderr, "%d errors in data file '%s'.\n", nErrs, fileToOpen);
-
-  //  if (ignoreFork > 0 || ignoreTask > 0) {
-  //    fprintf (stderr, "%s: Error in data filters: ignoreFork = %d, ignoreTask = %d\n",
-  //         fileToOpen, ignoreFork, ignoreTask);
-  //  }
-
-  if ( !feof(data) ) return 0;
-
-  return 1;
+  fileEvents.clear();
 }
 
 // Get the task data by task Id and locale.
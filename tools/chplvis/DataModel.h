@@ -35,9 +35,9 @@
 // This is the class that reads the files as generated by runtime/src/chpl-visual-debug.c
 // in the Chapel runtime.
 //
-// Initially the data files are in ascii.  To turn these into binary data files,
-// both this class and runtime/src/chpl-visual-debug.c need to be modified to
-// write (chpl-visual-debug.c) and read (this class) in binary.
+// The files are in ascii, except that with CHPL_RT_VDEBUG_BINARY the events
+// are binary records (see runtime/include/chpl-visual-debug-format.h),
+// which are read back as the equivalent ascii lines.
 
 // Support Structs used by DataModel
 
@@ -164,7 +164,9 @@ class DataModel {
   
   // Utility routines
   
-  int LoadFile (const char *filename, int index, double seq);
+  int ParseFile (const char *filename, int index, double seq,
+                 std::list<Event *> &fileEvents);
+  void MergeEvents (const char *filename, std::list<Event *> &fileEvents);
   
   void newList ();
   